@@ -178,6 +178,7 @@ subroutine abscalc(nproc,iproc,atoms,rxyz,&
    use yaml_strings, only: yaml_toa
    use psp_projectors_base, only: free_DFT_PSP_projectors
    use public_enums, only: LINEAR_PARTITION_NONE
+   use vdwcorrection, only: vdwcorrection_finalize
    use module_input_keys, only: print_dft_parameters
    use IObox
    use orbitalbasis
@@ -551,6 +552,7 @@ subroutine abscalc(nproc,iproc,atoms,rxyz,&
    call IonicEnergyandForces(iproc,nproc,dpcom,atoms,in%elecfield,rxyz,&
         energs%eion,fion,in%dispersion,energs%edisp,fdisp,ewaldstr,&
         pot_ion,pkernel,psoffset)
+   call vdwcorrection_finalize()
 
    call createIonicPotential(iproc, (iproc == 0), atoms,rxyz, &
         in%elecfield,dpcom,pkernel,pot_ion,rho_ion,psoffset)
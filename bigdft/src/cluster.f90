@@ -1584,6 +1584,7 @@ subroutine kswfn_optimization_loop(iproc, nproc, opt, &
   use io, only: write_energies
   use module_xc, only: XC_NO_HARTREE
   use yaml_output
+  use Poisson_Solver, only: PS_set_options
   use public_enums
   implicit none
   real(dp), dimension(6), intent(out) :: xcstr
@@ -1712,6 +1713,9 @@ subroutine kswfn_optimization_loop(iproc, nproc, opt, &
 
            !if (opt%iter == 1) minres_gpe=denspot%pkernel%minres
            !denspot%pkernel%minres=max(min(1.e-6_gp,opt%gnrm**2) ,minres_gpe)!!opt%gnrm_cv**2)
+           !the mixed precision Poisson solver goes back to double precision transpositions
+           !when the root mean square residual of the wavefunctions gets below its threshold
+           call PS_set_options(denspot%pkernel,scf_residual=opt%gnrm)
 
            nlpsp%apply_gamma_target=((opt%scf .hasattr. 'MIXING') .and. opt%itrp <= in%occupancy_control_itermax &
                 .and. opt%itrep <= in%occupancy_control_nrepmax) .or. &
@@ -29,7 +29,7 @@ void nanosec_(long long unsigned int * t){
   *t += time.tv_nsec;
 }
 
-const double filt[] = { 8.4334247333529341094733325815816e-7,
+static const double filt[] = { 8.4334247333529341094733325815816e-7,
                        -0.1290557201342060969516786758559028e-4,
                         0.8762984476210559564689161894116397e-4,
                        -0.30158038132690463167163703826169879e-3,
@@ -53,10 +53,10 @@ void magicfilter_partial(unsigned int n1, unsigned int start, unsigned int ndat,
   double result0;
   double result1;
   const double *x_t0, *x_t1;
-  for(j=start; j<start+ndat; j+=2 ) {
+  for(j=start; j+1<start+ndat; j+=2 ) {
     x_t0 = x+j*n1;
     x_t1 = x+(j+1)*n1;
-    for(i=0; i<n1; i+=4) {
+    for(i=0; i+3<n1; i+=4) {
       result00 = 0;
       result10 = 0;
       result20 = 0;
@@ -264,6 +264,8 @@ void magicfilter_partial(unsigned int n1, unsigned int start, unsigned int ndat,
       result0 += x_t0[(i   +3)%n1]*filt[11];
       result1 += x_t1[(i   +3)%n1]*filt[11];
       result0 += x_t0[(i   +4)%n1]*filt[12];
+      result1 += x_t1[(i   +4)%n1]*filt[12];
+      result0 += x_t0[(i   +5)%n1]*filt[13];
       result1 += x_t1[(i   +5)%n1]*filt[13];
       result0 += x_t0[(i   +6)%n1]*filt[14];
       result1 += x_t1[(i   +6)%n1]*filt[14];
@@ -273,9 +275,9 @@ void magicfilter_partial(unsigned int n1, unsigned int start, unsigned int ndat,
       y[i*ld + j+1] = result1;
     }
   }
-  for(j=start + (ndat/2)*4; j<start+ndat; j++) {
+  for(j=start + (ndat/2)*2; j<start+ndat; j++) {
     x_t0 = x+j*n1;
-    for(i=0; i<n1; i+=4) {
+    for(i=0; i+3<n1; i+=4) {
       result00 = 0;
       result10 = 0;
       result20 = 0;
@@ -381,6 +383,7 @@ void magicfilter_partial(unsigned int n1, unsigned int start, unsigned int ndat,
       result0 += x_t0[(i   +2)%n1]*filt[10];
       result0 += x_t0[(i   +3)%n1]*filt[11];
       result0 += x_t0[(i   +4)%n1]*filt[12];
+      result0 += x_t0[(i   +5)%n1]*filt[13];
       result0 += x_t0[(i   +6)%n1]*filt[14];
       result0 += x_t0[(i   +7)%n1]*filt[15];
       y[i*ld + j] = result0;
@@ -396,10 +399,11 @@ void magicfilter_partial2(unsigned int n1, unsigned int start, unsigned int ndat
 //  double result01,result11,result21,result31;//,result4,result5,result6,result7,result8,result9,result10,result11,result12,result13,result14,result15;
   const double *x_t0, *x_t1, *x_t2, *x_t3,*x_t4, *x_t5, *x_t6, *x_t7;//,*x_t8;//, *x_t9, *x_t10, *x_t11;
   double *y_t;
-  x_t7 = x-n1;
   const double *fil_t = filt+8;
-  for(j=start; j+7<start+ndat; j+=8 ) {
-    x_t0=x_t7+n1;
+  /* blocks of 8 lines, the boundary loops below need n1 >= 16 */
+  const unsigned int nblock = n1 >= 16 ? (ndat/8)*8 : 0;
+  for(j=start; j<start+nblock; j+=8 ) {
+    x_t0=x+(size_t)j*n1;
     x_t1=x_t0+n1;
     x_t2=x_t1+n1;
     x_t3=x_t2+n1;
@@ -504,12 +508,12 @@ void magicfilter_partial2(unsigned int n1, unsigned int start, unsigned int ndat
       *y_t++ = result7;
     }
   }
-  for(j=start + (ndat/8)*8; j<start+ndat; j++) {
-//    printf("plop\n");
-    x_t0 = x+j*n1;
+  for(j=start + nblock; j<start+ndat; j++) {
+    x_t0 = x+(size_t)j*n1;
     for(i=0; i<n1; i++) {
       result0 = 0;
-      unsigned int i_t = i+n1;
+      /* shifted by a multiple of n1 so that i_t-8 stays positive */
+      unsigned int i_t = i+8*n1;
 
       for(k=-8; k<8; k++) {
         result0 += x_t0[(i_t+k)%n1]*fil_t[k];
@@ -532,11 +536,11 @@ struct magicfilter_params {
 };
 
 
-struct magicfilter_params ** params;
+static struct magicfilter_params ** params;
 
 void init_thread_engine_(){
-  char *argv[]={"conv_check", "-t", "topology_muscade.cfg", "-p", "placement_muscade.cfg", "-v", "1"};
-  int argc = 7;
+  char *argv[]={"conv_check", "-v", "1"};
+  int argc = 3;
   int i;
 
   get_engine_opt( argc, argv);
@@ -603,6 +607,25 @@ void magicfilter1d_d_par_(unsigned int *n1, unsigned int *ndat, double *x, doubl
 //    printf("  start : %llu, stop %llu\n", params[j]->start_date-start, params[j]->stop_date-start);
 }
 
+static void magicfilter_pool_body(int lo, int hi, void *arg) {
+  struct magicfilter_params * p = (struct magicfilter_params *) arg;
+  magicfilter_partial2(p->n1, lo, hi-lo, p->ld, p->x, p->y);
+}
+
+/* Same on the thread pool, by chunks of lines fitting in the share of the
+   cache of a worker; the chunks are multiples of the 8 lines of
+   magicfilter_partial2, the last one takes the remainder. */
+void magicfilter1d_d_pool_(unsigned int *n1, unsigned int *ndat, double *x, double *y) {
+  struct magicfilter_params p;
+  int grain = CACHE_SIZE/(*n1 * sizeof(double) * NB_SYB * thread_pool_size());
+  grain = grain < 8 ? 8 : (grain/8)*8;
+  p.n1 = *n1;
+  p.ld = *ndat;
+  p.x = x;
+  p.y = y;
+  thread_pool_parallel_for(0, *ndat, grain, magicfilter_pool_body, &p);
+}
+
 void magicfilter1d_d_seq_(unsigned int *n1, unsigned int *ndat, double *x, double *y) {
    int i,j;
    size_t slice;
@@ -0,0 +1,228 @@
+//! @file
+//!  C ABI of the templated convolutions of conv1d.hpp.
+//!
+//!  The routines have the arguments of their Fortran counterparts in
+//!  orbitals/*.f90 (prefixed by conv1d_) and can be called directly from
+//!  Fortran in their place. The periodic kernels of
+//!  orbitals/convolut_optim_per.f90 reach them through the dispatcher of
+//!  conv1d_profile.cpp.
+//!
+//! @author
+//!    Copyright (C) 2017 BigDFT group
+//!    This file is distributed under the terms of the
+//!    GNU General Public License, see ~/COPYING file
+//!    or http://www.gnu.org/copyleft/gpl.txt .
+//!    For the list of contributors, see ~/AUTHORS
+#include "conv1d.hpp"
+
+namespace conv1d {
+
+const double magic_filter[16] = {
+   8.4334247333529341094733325815816e-7,
+  -0.1290557201342060969516786758559028e-4,
+   0.8762984476210559564689161894116397e-4,
+  -0.30158038132690463167163703826169879e-3,
+   0.174723713672993903449447812749852942e-2,
+  -0.942047030201080385922711540948195075e-2,
+   0.2373821463724942397566389712597274535e-1,
+   0.612625895831207982195380597e-1,
+   0.9940415697834003993178616713,
+  -0.604895289196983516002834636e-1,
+  -0.2103025160930381434955489412839065067e-1,
+   0.1337263414854794752733423467013220997e-1,
+  -0.344128144493493857280881509686821861e-2,
+   0.49443227688689919192282259476750972e-3,
+  -0.5185986881173432922848639136911487e-4,
+   2.72734492911979659657715313017228e-6};
+
+const double magic_filter_t[16] = {
+   2.72734492911979659657715313017228e-6,
+  -0.5185986881173432922848639136911487e-4,
+   0.49443227688689919192282259476750972e-3,
+  -0.344128144493493857280881509686821861e-2,
+   0.1337263414854794752733423467013220997e-1,
+  -0.2103025160930381434955489412839065067e-1,
+  -0.604895289196983516002834636e-1,
+   0.9940415697834003993178616713,
+   0.612625895831207982195380597e-1,
+   0.2373821463724942397566389712597274535e-1,
+  -0.942047030201080385922711540948195075e-2,
+   0.174723713672993903449447812749852942e-2,
+  -0.30158038132690463167163703826169879e-3,
+   0.8762984476210559564689161894116397e-4,
+  -0.1290557201342060969516786758559028e-4,
+   8.4334247333529341094733325815816e-7};
+
+const double kinetic_filter[15] = {
+  -3.5536922899131901941296809374e0,
+   2.2191465938911163898794546405e0,
+  -0.6156141465570069496314853949e0,
+   0.2371780582153805636239247476e0,
+  -0.0822663999742123340987663521e0,
+   0.02207029188482255523789911295638968409e0,
+  -0.409765689342633823899327051188315485e-2,
+   0.45167920287502235349480037639758496e-3,
+  -0.2398228524507599670405555359023135e-4,
+   2.0904234952920365957922889447361e-6,
+  -3.7230763047369275848791496973044e-7,
+  -1.05857055496741470373494132287e-8,
+  -5.813879830282540547959250667e-11,
+   2.70800493626319438269856689037647576e-13,
+  -6.924474940639200152025730585882e-18};
+
+const double kinetic_filter_k[15] = {
+   0.0,
+   0.8834460460908270942785856e0,
+  -0.3032593514765938346887962e0,
+   0.1063640682894442760934532e0,
+  -0.03129014783948023634381564e0,
+   0.006958379116450707495020408e0,
+  -0.001031530213375445369097965e0,
+   0.00007667706908380351933901775e0,
+   2.451992111053665419191564e-7,
+   3.993810456408053712133667e-8,
+  -7.207948238588481597101904e-8,
+  -9.697184925637300947553069e-10,
+  -7.252206916665149851135592e-13,
+   1.240078536096648534547439e-14,
+  -1.585464751677102510097179e-19};
+
+const double scaling_filter[16] = {
+  -0.0033824159510050025955, -0.00054213233180001068935,
+   0.031695087811525991431,   0.0076074873249766081919,
+  -0.14329423835127266284,   -0.061273359067811077843,
+   0.48135965125905339159,    0.77718575169962802862,
+   0.36444189483617893676,   -0.051945838107881800736,
+  -0.027219029917103486322,   0.049137179673730286787,
+   0.0038087520138944894631, -0.014952258337062199118,
+  -0.00030292051472413308126, 0.0018899503327676891843};
+
+const double wavelet_filter[16] = {
+  -0.0018899503327676891843, -0.00030292051472413308126,
+   0.014952258337062199118,   0.0038087520138944894631,
+  -0.049137179673730286787,  -0.027219029917103486322,
+   0.051945838107881800736,   0.36444189483617893676,
+  -0.77718575169962802862,    0.48135965125905339159,
+   0.061273359067811077843,  -0.14329423835127266284,
+  -0.0076074873249766081919,  0.031695087811525991431,
+   0.00054213233180001068935,-0.0033824159510050025955};
+
+static filter magic(bool transposed)
+{
+  filter f;
+  f.lowfil = transposed ? -7 : -8;
+  f.lupfil = transposed ? 8 : 7;
+  f.fre = transposed ? magic_filter_t : magic_filter;
+  f.fim = 0;
+  f.c = 0.0;
+  return f;
+}
+
+} // namespace conv1d
+
+using namespace conv1d;
+
+extern "C" {
+
+/* Magic filter, x(0:n1,ndat) -> y(ndat,0:n1). */
+void conv1d_convrot_n_per_(int *n1, int *ndat, const double *x, double *y)
+{
+  convolution<periodic,real_t>::transposed(*n1+1,*ndat,magic(false),x,y);
+}
+
+void conv1d_convrot_t_per_(int *n1, int *ndat, const double *x, double *y)
+{
+  convolution<periodic,real_t>::transposed(*n1+1,*ndat,magic(true),x,y);
+}
+
+/* Complex (k-point) data, x(2,0:n1,ndat) -> y(2,ndat,0:n1). */
+void conv1d_convrot_n_per_k_(int *n1, int *ndat, const double *x, double *y)
+{
+  convolution<periodic,complex_t>::transposed(*n1+1,*ndat,magic(false),x,y);
+}
+
+void conv1d_convrot_t_per_k_(int *n1, int *ndat, const double *x, double *y)
+{
+  convolution<periodic,complex_t>::transposed(*n1+1,*ndat,magic(true),x,y);
+}
+
+/* Free BC, x(0:n1,ndat) -> y(ndat,-7:n1+8). */
+void conv1d_convrot_grow_(int *n1, int *ndat, const double *x, double *y)
+{
+  convolution<grow,real_t>::transposed(*n1+1,*ndat,magic(false),x,y);
+}
+
+/* Free BC, x(-7:n1+8,ndat) -> y(ndat,0:n1). */
+void conv1d_convrot_shrink_(int *n1, int *ndat, const double *x, double *y)
+{
+  convolution<shrink,real_t>::transposed(*n1+1,*ndat,magic(true),x,y);
+}
+
+/* Wavelet analysis and synthesis, x(0:2n+1,ndat) -> y(ndat,0:2n+1). */
+void conv1d_ana_rot_per_(int *n, int *ndat, const double *x, double *y)
+{
+  analysis<periodic,real_t>::transposed(*n+1,*ndat,x,y);
+}
+
+void conv1d_syn_rot_per_(int *n, int *ndat, const double *x, double *y)
+{
+  synthesis<periodic,real_t>::transposed(*n+1,*ndat,x,y);
+}
+
+/* x(-7:2n+8,ndat) -> y(ndat,0:2n+1). */
+void conv1d_ana_rot_shrink_(int *n, int *ndat, const double *x, double *y)
+{
+  analysis<shrink,real_t>::transposed(*n+1,*ndat,x,y);
+}
+
+/* x(0:2n+1,ndat) -> y(ndat,-7:2n+8). */
+void conv1d_syn_rot_grow_(int *n, int *ndat, const double *x, double *y)
+{
+  synthesis<grow,real_t>::transposed(*n+1,*ndat,x,y);
+}
+
+/* Kinetic operator y = c x - 1/2 Laplacian x on x(0:n1,0:n2,0:n3). */
+void conv1d_kinetic_per_c_(int *n1, int *n2, int *n3, const double *hgrid,
+                           const double *x, double *y, const double *c)
+{
+  kinetic3d<periodic,periodic,periodic,real_t>::apply(*n1,*n2,*n3,hgrid,x,y,*c);
+}
+
+void conv1d_kinetic_slab_c_(int *n1, int *n2, int *n3, const double *hgrid,
+                            const double *x, double *y, const double *c)
+{
+  kinetic3d<periodic,free_bc,periodic,real_t>::apply(*n1,*n2,*n3,hgrid,x,y,*c);
+}
+
+void conv1d_kinetic_wire_c_(int *n1, int *n2, int *n3, const double *hgrid,
+                            const double *x, double *y, const double *c)
+{
+  kinetic3d<free_bc,free_bc,periodic,real_t>::apply(*n1,*n2,*n3,hgrid,x,y,*c);
+}
+
+/* Same with a k-point on x(2,0:n1,0:n2,0:n3). */
+void conv1d_kinetic_per_c_k_(int *n1, int *n2, int *n3, const double *hgrid,
+                             const double *x, double *y, const double *c_in,
+                             const double *k1, const double *k2, const double *k3)
+{
+  const double kpt[3] = {*k1,*k2,*k3};
+  kinetic3d<periodic,periodic,periodic,complex_t>::apply(*n1,*n2,*n3,hgrid,x,y,*c_in,kpt);
+}
+
+void conv1d_kinetic_slab_c_k_(int *n1, int *n2, int *n3, const double *hgrid,
+                              const double *x, double *y, const double *c_in,
+                              const double *k1, const double *k2, const double *k3)
+{
+  const double kpt[3] = {*k1,*k2,*k3};
+  kinetic3d<periodic,free_bc,periodic,complex_t>::apply(*n1,*n2,*n3,hgrid,x,y,*c_in,kpt);
+}
+
+void conv1d_kinetic_wire_c_k_(int *n1, int *n2, int *n3, const double *hgrid,
+                              const double *x, double *y, const double *c_in,
+                              const double *k1, const double *k2, const double *k3)
+{
+  const double kpt[3] = {*k1,*k2,*k3};
+  kinetic3d<free_bc,free_bc,periodic,complex_t>::apply(*n1,*n2,*n3,hgrid,x,y,*c_in,kpt);
+}
+
+}
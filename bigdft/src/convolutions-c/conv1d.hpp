@@ -0,0 +1,405 @@
+//! @file
+//!  Compile-time generated one-dimensional Daubechies convolutions.
+//!
+//!  A single line filter is specialised at compile time on
+//!   - the boundary condition of the direction (periodic, free, grow, shrink),
+//!   - the data type (real, or complex interleaved as in the _k routines),
+//!   - the decimation step (1 for filters, 2 for the analysis),
+//!   - the number NB of lines treated together (register blocking on ndat),
+//!  which reproduces the convrot_*, ana_rot_*, syn_rot_* and
+//!  convolut_kinetic_*_c(_k) families of orbitals/*.f90. The slab and wire
+//!  3D operators are instantiations with one boundary condition per
+//!  direction. Strides are explicit, so the same kernel serves the
+//!  transposed (ndat,n) layout of the 1D Fortran kernels and the
+//!  non-transposed 3D layout. conv1d.cpp exports the C ABI.
+//!
+//! @author
+//!    Copyright (C) 2017 BigDFT group
+//!    This file is distributed under the terms of the
+//!    GNU General Public License, see ~/COPYING file
+//!    or http://www.gnu.org/copyleft/gpl.txt .
+//!    For the list of contributors, see ~/AUTHORS
+#ifndef CONV1D_HPP
+#define CONV1D_HPP
+
+#include <cstddef>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace conv1d {
+
+typedef std::ptrdiff_t index_t;
+
+/* Share [first,first+count) of n items of the calling OpenMP thread (all of
+   them outside of a parallel region). */
+inline void thread_share(index_t n, index_t & first, index_t & count)
+{
+#ifdef _OPENMP
+  const index_t nt = omp_get_num_threads(), it = omp_get_thread_num();
+  first = (n*it)/nt;
+  count = (n*(it+1))/nt-first;
+#else
+  first = 0;
+  count = n;
+#endif
+}
+
+/* Boundary conditions. For an interior of n output points, a filter
+   lowfil..lupfil and a decimation step, the input covers
+   [first_in, first_in+nin) and the output [first_out, first_out+n+extra_out);
+   points outside the input are wrapped (periodic) or zero. */
+struct periodic {
+  static const bool wrap = true;
+  static int first_in(int, int) { return 0; }
+  static int nin(int n, int step, int, int) { return step*n; }
+  static int first_out(int, int) { return 0; }
+  static int extra_out(int, int) { return 0; }
+};
+
+struct free_bc {
+  static const bool wrap = false;
+  static int first_in(int, int) { return 0; }
+  static int nin(int n, int step, int, int) { return step*n; }
+  static int first_out(int, int) { return 0; }
+  static int extra_out(int, int) { return 0; }
+};
+
+/* Output grown by the filter length (convrot_grow). */
+struct grow {
+  static const bool wrap = false;
+  static int first_in(int, int) { return 0; }
+  static int nin(int n, int step, int, int) { return step*n; }
+  static int first_out(int, int lupfil) { return -lupfil; }
+  static int extra_out(int lowfil, int lupfil) { return lupfil-lowfil; }
+};
+
+/* Input larger than the output by the filter length (convrot_shrink). */
+struct shrink {
+  static const bool wrap = false;
+  static int first_in(int lowfil, int) { return lowfil; }
+  static int nin(int n, int step, int lowfil, int lupfil) { return step*(n-1)+lupfil-lowfil+1; }
+  static int first_out(int, int) { return 0; }
+  static int extra_out(int, int) { return 0; }
+};
+
+/* Data types: number of interleaved components per point. */
+struct real_t { static const int ncomp = 1; };
+struct complex_t { static const int ncomp = 2; };
+
+/* Filter coefficients fre(lowfil:lupfil) and, for complex filters acting on
+   complex data, an imaginary part fim (may be null). */
+struct filter {
+  int lowfil, lupfil;
+  const double * fre;
+  const double * fim;
+  double c; //< diagonal term c*x(i), added first as in the kinetic kernels
+};
+
+/* Strided view of ndat lines: element k of line b, component m is at
+   x[b*sb + k*sk + m]. */
+struct lines {
+  index_t sk, sb;
+};
+
+inline int modulo(int a, int n) { int r = a % n; return r < 0 ? r+n : r; }
+
+/* NB lines of y = F x for a filter of step STEP:
+     y(i) = c*x(STEP*i) + sum_l f(l) x(STEP*i+l),  i in the output range.
+   The taps are accumulated in increasing l, like the Fortran references. */
+template <class BC, class T, int STEP, int NB>
+struct line_block {
+  static void apply(int nin, int first_in, int nout, int first_out, const filter & f,
+                    const double * x, const lines & lx, double * y, const lines & ly, bool accumulate)
+  {
+    const int nc = T::ncomp;
+    for (int io = 0; io < nout; ++io) {
+      const int base = STEP*(first_out+io);
+      double a[NB][T::ncomp], b[NB][T::ncomp];
+      for (int j = 0; j < NB; ++j)
+        for (int m = 0; m < nc; ++m) { a[j][m] = 0.0; b[j][m] = 0.0; }
+      if (f.c != 0.0) {
+        const index_t k = BC::wrap ? modulo(base-first_in,nin) : base-first_in;
+        if (k >= 0 && k < nin)
+          for (int j = 0; j < NB; ++j)
+            for (int m = 0; m < nc; ++m) a[j][m] = f.c*x[j*lx.sb+k*lx.sk+m];
+      }
+      int lmin = f.lowfil, lmax = f.lupfil;
+      bool inside = true;
+      if (BC::wrap) {
+        inside = (base+f.lowfil-first_in >= 0 && base+f.lupfil-first_in < nin);
+      } else {
+        if (first_in-base > lmin) lmin = first_in-base;
+        if (first_in+nin-1-base < lmax) lmax = first_in+nin-1-base;
+      }
+      for (int l = lmin; l <= lmax; ++l) {
+        const index_t k = inside ? base+l-first_in : modulo(base+l-first_in,nin);
+        const double fr = f.fre[l-f.lowfil];
+        const double * xk = x+k*lx.sk;
+        for (int j = 0; j < NB; ++j)
+          for (int m = 0; m < nc; ++m) a[j][m] += fr*xk[j*lx.sb+m];
+        if (nc == 2 && f.fim != 0) {
+          const double fi = f.fim[l-f.lowfil];
+          for (int j = 0; j < NB; ++j) {
+            b[j][0] += fi*xk[j*lx.sb+nc-1];
+            b[j][nc-1] += fi*xk[j*lx.sb];
+          }
+        }
+      }
+      double * yi = y+io*ly.sk;
+      for (int j = 0; j < NB; ++j) {
+        if (nc == 2) {
+          a[j][0] -= b[j][0];
+          a[j][nc-1] += b[j][nc-1];
+        }
+        for (int m = 0; m < nc; ++m) {
+          if (accumulate)
+            yi[j*ly.sb+m] += a[j][m];
+          else
+            yi[j*ly.sb+m] = a[j][m];
+        }
+      }
+    }
+  }
+};
+
+/* Same result with the loop over the taps outside the loop over the
+   outputs: y(i) += f(l) x(STEP*i+l) is streamed for each l. This trades
+   register accumulation for unit-stride sweeps and wins on large n. The
+   taps still enter each y(i) in increasing l. */
+template <class BC, class T, int STEP, int NB>
+struct line_block_tap {
+  static void apply(int nin, int first_in, int nout, int first_out, const filter & f,
+                    const double * x, const lines & lx, double * y, const lines & ly, bool accumulate)
+  {
+    const int nc = T::ncomp;
+    for (int io = 0; io < nout; ++io) {
+      double * yi = y+io*ly.sk;
+      const int base = STEP*(first_out+io);
+      const index_t k = BC::wrap ? modulo(base-first_in,nin) : base-first_in;
+      const bool diag = (f.c != 0.0 && k >= 0 && k < nin);
+      for (int j = 0; j < NB; ++j)
+        for (int m = 0; m < nc; ++m) {
+          const double d = diag ? f.c*x[j*lx.sb+k*lx.sk+m] : 0.0;
+          yi[j*ly.sb+m] = accumulate ? yi[j*ly.sb+m]+d : d;
+        }
+    }
+    for (int l = f.lowfil; l <= f.lupfil; ++l) {
+      const double fr = f.fre[l-f.lowfil];
+      const double fi = (nc == 2 && f.fim != 0) ? f.fim[l-f.lowfil] : 0.0;
+      for (int io = 0; io < nout; ++io) {
+        index_t k = STEP*(first_out+io)+l-first_in;
+        if (k < 0 || k >= nin) {
+          if (!BC::wrap) continue;
+          k = modulo((int)k,nin);
+        }
+        const double * xk = x+k*lx.sk;
+        double * yi = y+io*ly.sk;
+        for (int j = 0; j < NB; ++j) {
+          for (int m = 0; m < nc; ++m) yi[j*ly.sb+m] += fr*xk[j*lx.sb+m];
+          if (fi != 0.0) {
+            yi[j*ly.sb] -= fi*xk[j*lx.sb+nc-1];
+            yi[j*ly.sb+nc-1] += fi*xk[j*lx.sb];
+          }
+        }
+      }
+    }
+  }
+};
+
+/* Loop orders of the line filter. */
+enum loop_order { output_major = 0, tap_major = 1 };
+
+template <class BC, class T, int STEP, int NB, int ORDER>
+struct line_kernel : line_block<BC,T,STEP,NB> {};
+template <class BC, class T, int STEP, int NB>
+struct line_kernel<BC,T,STEP,NB,tap_major> : line_block_tap<BC,T,STEP,NB> {};
+
+/* Filter ndat lines of interior size n, NB lines at a time. */
+template <class BC, class T, int STEP = 1, int NB = 4, int ORDER = output_major>
+struct convolution {
+  static int nin(int n, const filter & f) { return BC::nin(n,STEP,f.lowfil,f.lupfil); }
+  static int nout(int n, const filter & f) { return n+BC::extra_out(f.lowfil,f.lupfil); }
+
+  static void apply(int n, int ndat, const filter & f, const double * x, const lines & lx,
+                    double * y, const lines & ly, bool accumulate = false)
+  {
+    const int ni = nin(n,f), no = nout(n,f);
+    const int fi = BC::first_in(f.lowfil,f.lupfil), fo = BC::first_out(f.lowfil,f.lupfil);
+    int j = 0;
+    for (; j+NB <= ndat; j += NB)
+      line_kernel<BC,T,STEP,NB,ORDER>::apply(ni,fi,no,fo,f,x+j*lx.sb,lx,y+j*ly.sb,ly,accumulate);
+    for (; j < ndat; ++j)
+      line_kernel<BC,T,STEP,1,ORDER>::apply(ni,fi,no,fo,f,x+j*lx.sb,lx,y+j*ly.sb,ly,accumulate);
+  }
+
+  /* Layout of the 1D Fortran kernels: x(ncomp,nin,ndat) -> y(ncomp,ld,nout),
+     ld=ndat by default. */
+  static void transposed(int n, int ndat, const filter & f, const double * x, double * y,
+                         index_t ld = 0)
+  {
+    const index_t nc = T::ncomp;
+    lines lx, ly;
+    lx.sk = nc; lx.sb = nc*nin(n,f);
+    ly.sk = nc*(ld > 0 ? ld : ndat); ly.sb = nc;
+    apply(n,ndat,f,x,lx,y,ly);
+  }
+};
+
+/* Daubechies-16 filters, defined in conv1d.cpp. */
+extern const double magic_filter[16];    //< lowfil=-8
+extern const double magic_filter_t[16];  //< lowfil=-7
+extern const double kinetic_filter[15];  //< taps 0..14, symmetric
+extern const double kinetic_filter_k[15];//< first derivative, taps 0..14, antisymmetric
+extern const double scaling_filter[16];  //< ch(-7:8)
+extern const double wavelet_filter[16];  //< cg(-7:8)
+
+/* Analysis, x(ncomp,2m(+14),ndat) -> y(ncomp,ndat,0:2m-1): scaling then
+   wavelet coefficients (ana_rot_per, ana_rot_shrink). */
+template <class BC, class T, int NB = 4, int ORDER = output_major>
+struct analysis {
+  static void transposed(int m, int ndat, const double * x, double * y, index_t ld = 0)
+  {
+    const index_t nc = T::ncomp;
+    filter f;
+    f.lowfil = -7; f.lupfil = 8; f.fim = 0; f.c = 0.0;
+    lines lx, ly;
+    lx.sk = nc; lx.sb = nc*convolution<BC,T,2,NB,ORDER>::nin(m,f);
+    ly.sk = nc*(ld > 0 ? ld : ndat); ly.sb = nc;
+    f.fre = scaling_filter;
+    convolution<BC,T,2,NB,ORDER>::apply(m,ndat,f,x,lx,y,ly);
+    f.fre = wavelet_filter;
+    convolution<BC,T,2,NB,ORDER>::apply(m,ndat,f,x,lx,y+m*ly.sk,ly);
+  }
+};
+
+/* Synthesis, x(ncomp,0:2m-1,ndat) -> y(ncomp,ndat,2m(+14)) (syn_rot_per,
+   syn_rot_grow):
+     y(2i)   = sum_l ch(2l)   xc(i-l) + cg(2l)   xw(i-l)
+     y(2i+1) = sum_l ch(2l+1) xc(i-l) + cg(2l+1) xw(i-l),  l=-4..4 */
+template <class BC>
+struct synthesis_range;
+template <>
+struct synthesis_range<periodic> {
+  static int first(int) { return 0; }
+  static int last(int m) { return m-1; }
+  static int first_out() { return 0; }
+  static int nout(int m) { return 2*m; }
+};
+template <>
+struct synthesis_range<grow> {
+  static int first(int) { return -4; }
+  static int last(int m) { return m+3; }
+  static int first_out() { return -7; }
+  static int nout(int m) { return 2*m+14; }
+};
+
+template <class BC, class T, int NB = 4>
+struct synthesis {
+  static double ch(int l) { return (l >= -7 && l <= 8) ? scaling_filter[l+7] : 0.0; }
+  static double cg(int l) { return (l >= -7 && l <= 8) ? wavelet_filter[l+7] : 0.0; }
+
+  template <int NBB>
+  static void block(int m, index_t ld, const double * x, double * y)
+  {
+    const int nc = T::ncomp;
+    const index_t lsx = nc*2*m, lsy = nc, ldy = nc*ld;
+    const int ifo = synthesis_range<BC>::first_out(), nout = synthesis_range<BC>::nout(m);
+    for (int i = synthesis_range<BC>::first(m); i <= synthesis_range<BC>::last(m); ++i) {
+      double se[NBB][T::ncomp], so[NBB][T::ncomp];
+      for (int j = 0; j < NBB; ++j)
+        for (int c = 0; c < nc; ++c) { se[j][c] = 0.0; so[j][c] = 0.0; }
+      int lmin = -4, lmax = 4;
+      if (!BC::wrap) {
+        if (i-(m-1) > lmin) lmin = i-(m-1);
+        if (i < lmax) lmax = i;
+      }
+      for (int l = lmin; l <= lmax; ++l) {
+        const index_t k = BC::wrap ? modulo(i-l,m) : i-l;
+        const double che = ch(2*l), cge = cg(2*l), cho = ch(2*l+1), cgo = cg(2*l+1);
+        const double * xc = x+nc*k;
+        const double * xw = x+nc*(k+m);
+        for (int j = 0; j < NBB; ++j)
+          for (int c = 0; c < nc; ++c) {
+            se[j][c] = se[j][c]+che*xc[j*lsx+c]+cge*xw[j*lsx+c];
+            so[j][c] = so[j][c]+cho*xc[j*lsx+c]+cgo*xw[j*lsx+c];
+          }
+      }
+      const int ie = 2*i-ifo, iodd = 2*i+1-ifo;
+      for (int j = 0; j < NBB; ++j)
+        for (int c = 0; c < nc; ++c) {
+          if (ie >= 0 && ie < nout) y[ie*ldy+j*lsy+c] = se[j][c];
+          if (iodd >= 0 && iodd < nout) y[iodd*ldy+j*lsy+c] = so[j][c];
+        }
+    }
+  }
+
+  static void transposed(int m, int ndat, const double * x, double * y, index_t ld = 0)
+  {
+    const int nc = T::ncomp;
+    if (ld <= 0) ld = ndat;
+    int j = 0;
+    for (; j+NB <= ndat; j += NB) block<NB>(m,ld,x+j*nc*2*m,y+j*nc);
+    for (; j < ndat; ++j) block<1>(m,ld,x+j*nc*2*m,y+j*nc);
+  }
+};
+
+/* Three-dimensional kinetic operator y = c x - 1/2 Laplacian x on
+   x(ncomp,0:n1,0:n2,0:n3), one boundary condition per direction. For
+   complex data with a k-point, the first derivative enters as the
+   imaginary part of the filter (convolut_kinetic_*_c_k). */
+template <class BC1, class BC2, class BC3, class T, int NB = 4, int ORDER = output_major>
+struct kinetic3d {
+  static void filters(double h, double k, double * fre, double * fim)
+  {
+    const double scale = -0.5/(h*h), scale1 = k/h;
+    for (int l = 0; l <= 14; ++l) {
+      fre[14+l] = kinetic_filter[l]*scale;
+      fre[14-l] = fre[14+l];
+      fim[14+l] = kinetic_filter_k[l]*scale1;
+      fim[14-l] = -fim[14+l];
+    }
+  }
+
+  static void apply(int n1, int n2, int n3, const double * hgrid, const double * x, double * y,
+                    double c, const double * kpt = 0)
+  {
+    const index_t nc = T::ncomp;
+    const index_t m1 = n1+1, m2 = n2+1, m3 = n3+1;
+    double fre[3][29], fim[3][29];
+    filter f[3];
+    for (int d = 0; d < 3; ++d) {
+      filters(hgrid[d],kpt ? kpt[d] : 0.0,fre[d],fim[d]);
+      f[d].lowfil = -14; f[d].lupfil = 14;
+      f[d].fre = fre[d];
+      f[d].fim = kpt ? fim[d] : 0;
+      f[d].c = 0.0;
+    }
+    if (kpt) c += 0.5*(kpt[0]*kpt[0]+kpt[1]*kpt[1]+kpt[2]*kpt[2]);
+    f[0].c = c;
+    lines l1, l2, l3;
+    l1.sk = nc; l1.sb = nc*m1;
+    l2.sk = nc*m1; l2.sb = nc;
+    l3.sk = nc*m1*m2; l3.sb = nc;
+    //the three passes write y, they are separated by barriers
+#pragma omp parallel
+    {
+      index_t j0, nj;
+      //x direction: contiguous lines, one per (i2,i3)
+      thread_share(m2*m3,j0,nj);
+      convolution<BC1,T,1,NB,ORDER>::apply(m1,nj,f[0],x+j0*l1.sb,l1,y+j0*l1.sb,l1);
+#pragma omp barrier
+      //y direction: lines along i1, one plane at a time
+#pragma omp for
+      for (index_t i3 = 0; i3 < m3; ++i3)
+        convolution<BC2,T,1,NB,ORDER>::apply(m2,m1,f[1],x+i3*nc*m1*m2,l2,y+i3*nc*m1*m2,l2,true);
+      //z direction: lines along i1+i2
+      thread_share(m1*m2,j0,nj);
+      convolution<BC3,T,1,NB,ORDER>::apply(m3,nj,f[2],x+j0*l3.sb,l3,y+j0*l3.sb,l3,true);
+    }
+  }
+};
+
+} // namespace conv1d
+
+#endif
@@ -0,0 +1,54 @@
+//! @file
+//!  Dispatch entry points of the periodic convolutions when the C/C++
+//!  kernels are not built (configure without --enable-convolutions-c):
+//!  the Fortran kernels of orbitals/convolut_optim_per.f90 run their own
+//!  loops.
+//!
+//! @author
+//!    Copyright (C) 2017 BigDFT group
+//!    This file is distributed under the terms of the
+//!    GNU General Public License, see ~/COPYING file
+//!    or http://www.gnu.org/copyleft/gpl.txt .
+//!    For the list of contributors, see ~/AUTHORS
+
+void conv1d_convrot_n_per_dispatch_(int *n1, int *ndat, const double *x, double *y, int *done)
+{
+  *done = 0;
+}
+
+void conv1d_convrot_t_per_dispatch_(int *n1, int *ndat, const double *x, double *y, int *done)
+{
+  *done = 0;
+}
+
+void conv1d_ana_rot_per_dispatch_(int *n, int *ndat, const double *x, double *y, int *done)
+{
+  *done = 0;
+}
+
+void conv1d_syn_rot_per_dispatch_(int *n, int *ndat, const double *x, double *y, int *done)
+{
+  *done = 0;
+}
+
+void conv1d_kinetic_per_c_dispatch_(int *n1, int *n2, int *n3, const double *hgrid,
+                                    const double *x, double *y, const double *c, int *done)
+{
+  *done = 0;
+}
+
+void conv1d_dispatch_set_(int *on)
+{
+}
+
+void conv1d_dispatch_get_(int *on)
+{
+  *on = 0;
+}
+
+void conv1d_profile_get_(char *path, int *ln, int *status, int path_ln)
+{
+  int i;
+  for (i = 0; i < *ln; i++) path[i] = ' ';
+  *status = 0;
+}
@@ -0,0 +1,486 @@
+//! @file
+//!  Variant registry, machine profile and dispatcher of the periodic
+//!  convolutions.
+//!
+//! @author
+//!    Copyright (C) 2017 BigDFT group
+//!    This file is distributed under the terms of the
+//!    GNU General Public License, see ~/COPYING file
+//!    or http://www.gnu.org/copyleft/gpl.txt .
+//!    For the list of contributors, see ~/AUTHORS
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include "conv1d.hpp"
+#include "conv1d_profile.hpp"
+#include "convolution_avx.h"
+
+/* Fortran loops of orbitals/convolut_optim_per.f90. */
+extern "C" {
+void convrot_n_per_(int *n1, int *ndat, const double *x, double *y);
+void convrot_t_per_(int *n1, int *ndat, const double *x, double *y);
+void ana_rot_per_(int *n, int *ndat, const double *x, double *y);
+void syn_rot_per_(int *n, int *ndat, const double *x, double *y);
+void convolut_kinetic_per_c_(int *n1, int *n2, int *n3, const double *hgrid,
+                             const double *x, double *y, const double *c);
+/* Thread pool version of MagicFilter_C.c, n1 is the number of points. */
+void magicfilter1d_d_pool_(unsigned int *n1, unsigned int *ndat, double *x, double *y);
+}
+
+namespace conv1d {
+
+/* Set while a Fortran variant runs, so that the kernel called from it does
+   not come back to the dispatcher. */
+static __thread int bypass = 0;
+
+/* Adapters giving all variants of a kernel the same signature. */
+template <int NB, int ORDER>
+static void v_magic_n(int n, int ndat, int ld, const double * x, double * y)
+{
+  filter f;
+  f.lowfil = -8; f.lupfil = 7; f.fre = magic_filter; f.fim = 0; f.c = 0.0;
+  convolution<periodic,real_t,1,NB,ORDER>::transposed(n,ndat,f,x,y,ld);
+}
+
+template <int NB, int ORDER>
+static void v_magic_t(int n, int ndat, int ld, const double * x, double * y)
+{
+  filter f;
+  f.lowfil = -7; f.lupfil = 8; f.fre = magic_filter_t; f.fim = 0; f.c = 0.0;
+  convolution<periodic,real_t,1,NB,ORDER>::transposed(n,ndat,f,x,y,ld);
+}
+
+/* n is the number of fine points (2m) for the wavelet transforms. */
+template <int NB, int ORDER>
+static void v_ana(int n, int ndat, int ld, const double * x, double * y)
+{
+  analysis<periodic,real_t,NB,ORDER>::transposed(n/2,ndat,x,y,ld);
+}
+
+template <int NB, int ORDER>
+static void v_syn(int n, int ndat, int ld, const double * x, double * y)
+{
+  synthesis<periodic,real_t,NB>::transposed(n/2,ndat,x,y,ld);
+}
+
+template <int NB, int ORDER>
+static void v_kinetic(int n1, int n2, int n3, const double * hgrid,
+                      const double * x, double * y, double c)
+{
+  kinetic3d<periodic,periodic,periodic,real_t,NB,ORDER>::apply(n1,n2,n3,hgrid,x,y,c);
+}
+
+/* AVX kernels of convolution_avx.c, threaded over ndat. */
+static void avx_magic_n(int n, int ndat, int, const double * x, double * y)
+{
+  unsigned int un = n, und = ndat;
+  magicfilter1d_avx_(&un,&und,x,y);
+}
+
+static void avx_magic_t(int n, int ndat, int, const double * x, double * y)
+{
+  unsigned int un = n, und = ndat;
+  magicfilter1d_t_avx_(&un,&und,x,y);
+}
+
+static void avx_ana(int n, int ndat, int, const double * x, double * y)
+{
+  int m = n/2-1;
+  ana_rot_per_avx_(&m,&ndat,x,y);
+}
+
+static void avx_syn(int n, int ndat, int, const double * x, double * y)
+{
+  int m = n/2-1;
+  syn_rot_per_avx_(&m,&ndat,x,y);
+}
+
+static void pool_magic_n(int n, int ndat, int, const double * x, double * y)
+{
+  unsigned int un = n, und = ndat;
+  magicfilter1d_d_pool_(&un,&und,const_cast<double *>(x),y);
+}
+
+/* Fortran loops, threaded with OpenMP. */
+static void fortran_magic_n(int n, int ndat, int, const double * x, double * y)
+{
+  int n1 = n-1;
+  bypass = 1;
+  convrot_n_per_(&n1,&ndat,x,y);
+  bypass = 0;
+}
+
+static void fortran_magic_t(int n, int ndat, int, const double * x, double * y)
+{
+  int n1 = n-1;
+  bypass = 1;
+  convrot_t_per_(&n1,&ndat,x,y);
+  bypass = 0;
+}
+
+static void fortran_ana(int n, int ndat, int, const double * x, double * y)
+{
+  int m = n/2-1;
+  bypass = 1;
+  ana_rot_per_(&m,&ndat,x,y);
+  bypass = 0;
+}
+
+static void fortran_syn(int n, int ndat, int, const double * x, double * y)
+{
+  int m = n/2-1;
+  bypass = 1;
+  syn_rot_per_(&m,&ndat,x,y);
+  bypass = 0;
+}
+
+static void fortran_kinetic(int n1, int n2, int n3, const double * hgrid,
+                            const double * x, double * y, double c)
+{
+  bypass = 1;
+  convolut_kinetic_per_c_(&n1,&n2,&n3,hgrid,x,y,&c);
+  bypass = 0;
+}
+
+static std::string conv1d_name(int nb, int order)
+{
+  char name[32];
+  std::snprintf(name,sizeof(name),"nb%d_%s",nb,order == tap_major ? "tap" : "output");
+  return name;
+}
+
+template <int NB, int ORDER>
+static variant make_line(line_fn fn)
+{
+  variant v;
+  v.name = conv1d_name(NB,ORDER);
+  v.nb = NB; v.order = ORDER; v.threaded = false; v.line = fn; v.kinetic = 0;
+  return v;
+}
+
+static variant make_threaded(const char * name, line_fn line, kinetic_fn kinetic)
+{
+  variant v;
+  v.name = name;
+  v.nb = 0; v.order = -1; v.threaded = true; v.line = line; v.kinetic = kinetic;
+  return v;
+}
+
+#define CONV1D_LINE_VARIANTS(tab,fn) \
+  tab.push_back(make_line<1,output_major>(fn<1,output_major>)); \
+  tab.push_back(make_line<2,output_major>(fn<2,output_major>)); \
+  tab.push_back(make_line<4,output_major>(fn<4,output_major>)); \
+  tab.push_back(make_line<8,output_major>(fn<8,output_major>)); \
+  tab.push_back(make_line<1,tap_major>(fn<1,tap_major>)); \
+  tab.push_back(make_line<2,tap_major>(fn<2,tap_major>)); \
+  tab.push_back(make_line<4,tap_major>(fn<4,tap_major>)); \
+  tab.push_back(make_line<8,tap_major>(fn<8,tap_major>));
+
+#define CONV1D_KINETIC_VARIANT(tab,NB,ORDER) \
+  { variant v; v.name = conv1d_name(NB,ORDER); v.nb = NB; v.order = ORDER; \
+    v.threaded = true; v.line = 0; v.kinetic = v_kinetic<NB,ORDER>; \
+    tab.push_back(v); }
+
+static std::vector< std::vector<variant> > build_registry()
+{
+  std::vector< std::vector<variant> > reg(nkernels);
+  CONV1D_LINE_VARIANTS(reg[magic_n_per],v_magic_n)
+  reg[magic_n_per].push_back(make_threaded("avx",avx_magic_n,0));
+  reg[magic_n_per].push_back(make_threaded("pool",pool_magic_n,0));
+  reg[magic_n_per].push_back(make_threaded("fortran",fortran_magic_n,0));
+  CONV1D_LINE_VARIANTS(reg[magic_t_per],v_magic_t)
+  reg[magic_t_per].push_back(make_threaded("avx",avx_magic_t,0));
+  reg[magic_t_per].push_back(make_threaded("fortran",fortran_magic_t,0));
+  CONV1D_LINE_VARIANTS(reg[ana_per],v_ana)
+  reg[ana_per].push_back(make_threaded("avx",avx_ana,0));
+  reg[ana_per].push_back(make_threaded("fortran",fortran_ana,0));
+  //the synthesis has a single loop order
+  reg[syn_per].push_back(make_line<1,output_major>(v_syn<1,output_major>));
+  reg[syn_per].push_back(make_line<2,output_major>(v_syn<2,output_major>));
+  reg[syn_per].push_back(make_line<4,output_major>(v_syn<4,output_major>));
+  reg[syn_per].push_back(make_line<8,output_major>(v_syn<8,output_major>));
+  reg[syn_per].push_back(make_threaded("avx",avx_syn,0));
+  reg[syn_per].push_back(make_threaded("fortran",fortran_syn,0));
+  CONV1D_KINETIC_VARIANT(reg[kinetic_per],1,output_major)
+  CONV1D_KINETIC_VARIANT(reg[kinetic_per],2,output_major)
+  CONV1D_KINETIC_VARIANT(reg[kinetic_per],4,output_major)
+  CONV1D_KINETIC_VARIANT(reg[kinetic_per],8,output_major)
+  CONV1D_KINETIC_VARIANT(reg[kinetic_per],1,tap_major)
+  CONV1D_KINETIC_VARIANT(reg[kinetic_per],2,tap_major)
+  CONV1D_KINETIC_VARIANT(reg[kinetic_per],4,tap_major)
+  CONV1D_KINETIC_VARIANT(reg[kinetic_per],8,tap_major)
+  reg[kinetic_per].push_back(make_threaded("fortran",0,fortran_kinetic));
+  return reg;
+}
+
+static const char * const kernel_names[nkernels] = {
+  "convrot_n_per", "convrot_t_per", "ana_rot_per", "syn_rot_per", "kinetic_per_c"};
+
+const char * kernel_name(int kernel)
+{
+  return kernel_names[kernel];
+}
+
+int kernel_from_name(const std::string & name)
+{
+  for (int k = 0; k < nkernels; ++k)
+    if (name == kernel_names[k]) return k;
+  return -1;
+}
+
+const std::vector<variant> & variants(int kernel)
+{
+  static const std::vector< std::vector<variant> > registry = build_registry();
+  return registry[kernel];
+}
+
+int variant_from_name(int kernel, const std::string & name)
+{
+  const std::vector<variant> & vs = variants(kernel);
+  for (size_t iv = 0; iv < vs.size(); ++iv)
+    if (vs[iv].name == name) return (int)iv;
+  return -1;
+}
+
+int fortran_variant(int kernel)
+{
+  return variant_from_name(kernel,"fortran");
+}
+
+/* The AVX kernels when the CPU has them, the Fortran loops otherwise. The
+   kinetic operator keeps its Fortran loops, the conv1d ones are only run
+   when a tuned profile selects them. */
+int default_variant(int kernel)
+{
+  if (kernel == kinetic_per) return fortran_variant(kernel);
+  int isa;
+  conv_avx_isa_(&isa);
+  return variant_from_name(kernel,isa > CONV_ISA_GENERIC ? "avx" : "fortran");
+}
+
+int kernel_flops(int kernel)
+{
+  switch (kernel) {
+  case magic_n_per:
+  case magic_t_per:
+  case ana_per:
+    return 32;
+  case syn_per:
+    return 36;
+  default:
+    return 3*29*2;
+  }
+}
+
+profile::profile() : entries_(nkernels) {}
+
+bool profile::empty() const
+{
+  for (int k = 0; k < nkernels; ++k)
+    if (!entries_[k].empty()) return false;
+  return true;
+}
+
+bool profile::has(int kernel) const
+{
+  return !entries_[kernel].empty();
+}
+
+void profile::set(int kernel, int n, int variant, double seconds)
+{
+  profile_entry e;
+  e.n = n; e.variant = variant; e.seconds = seconds;
+  entries_[kernel][n] = e;
+}
+
+int profile::select(int kernel, int n) const
+{
+  const std::map<int,profile_entry> & tab = entries_[kernel];
+  if (tab.empty()) return default_variant(kernel);
+  std::map<int,profile_entry>::const_iterator up = tab.lower_bound(n);
+  if (up == tab.end()) return (--up)->second.variant;
+  if (up->first == n || up == tab.begin()) return up->second.variant;
+  std::map<int,profile_entry>::const_iterator lo = up;
+  --lo;
+  //closest size in ratio, the blocking effects scale with n
+  return (std::log((double)n/lo->first) <= std::log((double)up->first/n)) ?
+    lo->second.variant : up->second.variant;
+}
+
+/* The profile is a small YAML document:
+     host: <name>
+     kernels:
+       convrot_n_per:
+       - {n: 64, variant: nb4_output, seconds: 1.2e-05}
+   only the lines written by save() are understood. */
+bool profile::save(const std::string & path) const
+{
+  FILE * f = std::fopen(path.c_str(),"w");
+  if (!f) return false;
+  std::fprintf(f,"# convolution autotuning profile, written by conv1d_tune\n");
+  std::fprintf(f,"host: %s\n",host.c_str());
+  std::fprintf(f,"kernels:\n");
+  for (int k = 0; k < nkernels; ++k) {
+    if (entries_[k].empty()) continue;
+    std::fprintf(f,"  %s:\n",kernel_name(k));
+    for (std::map<int,profile_entry>::const_iterator it = entries_[k].begin(); it != entries_[k].end(); ++it)
+      std::fprintf(f,"  - {n: %d, variant: %s, seconds: %.6e}\n",
+                   it->second.n,variants(k)[it->second.variant].name.c_str(),it->second.seconds);
+  }
+  return std::fclose(f) == 0;
+}
+
+bool profile::load(const std::string & path)
+{
+  FILE * f = std::fopen(path.c_str(),"r");
+  if (!f) return false;
+  char line[256], name[128];
+  int kernel = -1;
+  while (std::fgets(line,sizeof(line),f)) {
+    int n;
+    double seconds;
+    if (std::sscanf(line,"host: %127s",name) == 1) {
+      host = name;
+    } else if (std::sscanf(line,"  - {n: %d, variant: %127[a-z0-9_], seconds: %lf}",
+                           &n,name,&seconds) == 3) {
+      //variants not compiled in this library are ignored
+      const int iv = kernel < 0 ? -1 : variant_from_name(kernel,name);
+      if (iv >= 0) set(kernel,n,iv,seconds);
+    } else if (std::sscanf(line,"  %127[a-z_]:",name) == 1) {
+      kernel = kernel_from_name(name);
+    }
+  }
+  std::fclose(f);
+  return !empty();
+}
+
+/* 1 when the profile has been read, -1 when BIGDFT_CONV_PROFILE names a
+   file without entries, 0 when it is not set. */
+static int profile_status = 0;
+
+const std::string & machine_profile_path()
+{
+  static const std::string path = std::getenv("BIGDFT_CONV_PROFILE") ?
+    std::getenv("BIGDFT_CONV_PROFILE") : "";
+  return path;
+}
+
+static profile load_machine_profile()
+{
+  profile prof;
+  const std::string & path = machine_profile_path();
+  if (!path.empty()) profile_status = prof.load(path) ? 1 : -1;
+  return prof;
+}
+
+profile & machine_profile()
+{
+  static profile prof = load_machine_profile();
+  return prof;
+}
+
+/* The profile is read when the library is loaded, not at the first
+   convolution, which may be inside a parallel region. */
+static const profile & initial_profile = machine_profile();
+
+/* BIGDFT_CONV_DISPATCH=no keeps the Fortran loops everywhere. */
+static int dispatch_from_env()
+{
+  const char * s = std::getenv("BIGDFT_CONV_DISPATCH");
+  return (s && (std::strcmp(s,"no") == 0 || std::strcmp(s,"0") == 0)) ? 0 : 1;
+}
+
+static int dispatch_on = dispatch_from_env();
+
+int dispatch_variant(int kernel, int n)
+{
+  return machine_profile().select(kernel,n);
+}
+
+void run_line(const variant & v, int n, int ndat, const double * x, double * y)
+{
+  if (v.threaded) {
+    v.line(n,ndat,ndat,x,y);
+    return;
+  }
+#pragma omp parallel if(ndat >= 64)
+  {
+    index_t j0, nj;
+    thread_share(ndat,j0,nj);
+    if (nj > 0) v.line(n,(int)nj,ndat,x+j0*n,y+j0);
+  }
+}
+
+/* 1 when the lines have been filtered here, 0 when the Fortran caller has
+   to run its own loops. */
+static int dispatch_line(int kernel, int n, int ndat, const double * x, double * y)
+{
+  if (!dispatch_on || bypass) return 0;
+  const int iv = dispatch_variant(kernel,n);
+  if (iv == fortran_variant(kernel)) return 0;
+  run_line(variants(kernel)[iv],n,ndat,x,y);
+  return 1;
+}
+
+} // namespace conv1d
+
+using namespace conv1d;
+
+extern "C" {
+
+/* Called on entry of the Fortran kernels, with their arguments. */
+void conv1d_convrot_n_per_dispatch_(int *n1, int *ndat, const double *x, double *y, int *done)
+{
+  *done = dispatch_line(magic_n_per,*n1+1,*ndat,x,y);
+}
+
+void conv1d_convrot_t_per_dispatch_(int *n1, int *ndat, const double *x, double *y, int *done)
+{
+  *done = dispatch_line(magic_t_per,*n1+1,*ndat,x,y);
+}
+
+void conv1d_ana_rot_per_dispatch_(int *n, int *ndat, const double *x, double *y, int *done)
+{
+  *done = dispatch_line(ana_per,2*(*n+1),*ndat,x,y);
+}
+
+void conv1d_syn_rot_per_dispatch_(int *n, int *ndat, const double *x, double *y, int *done)
+{
+  *done = dispatch_line(syn_per,2*(*n+1),*ndat,x,y);
+}
+
+void conv1d_kinetic_per_c_dispatch_(int *n1, int *n2, int *n3, const double *hgrid,
+                                    const double *x, double *y, const double *c, int *done)
+{
+  *done = 0;
+  if (!dispatch_on || bypass) return;
+  const int iv = dispatch_variant(kinetic_per,*n1+1);
+  if (iv == fortran_variant(kinetic_per)) return;
+  variants(kinetic_per)[iv].kinetic(*n1,*n2,*n3,hgrid,x,y,*c);
+  *done = 1;
+}
+
+/* Switch the dispatch off (0) or on, e.g. to time the Fortran loops. */
+void conv1d_dispatch_set_(int *on)
+{
+  dispatch_on = (*on != 0);
+}
+
+void conv1d_dispatch_get_(int *on)
+{
+  *on = dispatch_on;
+}
+
+/* Profile file of the run (blank padded) and profile_status. */
+void conv1d_profile_get_(char *path, int *ln, int *status, int path_ln)
+{
+  const std::string & p = machine_profile_path();
+  machine_profile();
+  std::memset(path,' ',*ln);
+  std::memcpy(path,p.c_str(),std::min((size_t)*ln,p.size()));
+  *status = profile_status;
+}
+
+}
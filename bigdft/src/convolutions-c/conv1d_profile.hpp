@@ -0,0 +1,105 @@
+//! @file
+//!  Autotuning of the periodic convolutions: registry of the compiled
+//!  variants of each kernel (conv1d ndat blocking and loop order, the AVX
+//!  kernels of convolution_avx.c, the thread pool magic filter of
+//!  MagicFilter_C.c and the Fortran loops of orbitals/convolut_optim_per.f90)
+//!  and per-machine profile of the fastest one for each grid size.
+//!
+//!  The profile is written by the conv1d_tune program and read when the
+//!  library is loaded, from the file named by BIGDFT_CONV_PROFILE only
+//!  (no profile when it is not set); print_logo reports it. The Fortran kernels
+//!  convrot_n_per, convrot_t_per, ana_rot_per, syn_rot_per and
+//!  convolut_kinetic_per_c ask the dispatcher for the variant to run. For a
+//!  kernel without profile entries the AVX kernels are used when the CPU has
+//!  them (the Fortran loops otherwise); the kinetic operator keeps its
+//!  Fortran loops.
+//!
+//! @author
+//!    Copyright (C) 2017 BigDFT group
+//!    This file is distributed under the terms of the
+//!    GNU General Public License, see ~/COPYING file
+//!    or http://www.gnu.org/copyleft/gpl.txt .
+//!    For the list of contributors, see ~/AUTHORS
+#ifndef CONV1D_PROFILE_HPP
+#define CONV1D_PROFILE_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace conv1d {
+
+/* Tuned kernels. The 1D ones use the transposed layout
+   x(0:n-1,ndat) -> y(ndat,0:n-1); kinetic_per is the 3D operator. */
+enum kernel_id {
+  magic_n_per = 0,
+  magic_t_per,
+  ana_per,
+  syn_per,
+  kinetic_per,
+  nkernels
+};
+
+/* Lines x(0:n-1,ndat) -> y(ld,0:n-1). */
+typedef void (*line_fn)(int n, int ndat, int ld, const double * x, double * y);
+typedef void (*kinetic_fn)(int n1, int n2, int n3, const double * hgrid,
+                           const double * x, double * y, double c);
+
+struct variant {
+  std::string name;
+  int nb;        //< lines treated together (conv1d), 0 for the others
+  int order;     //< loop_order of conv1d.hpp, -1 for the others
+  bool threaded; //< shares the lines over the threads itself
+  line_fn line;
+  kinetic_fn kinetic;
+};
+
+const char * kernel_name(int kernel);
+int kernel_from_name(const std::string & name);
+const std::vector<variant> & variants(int kernel);
+int variant_from_name(int kernel, const std::string & name);
+/* Variant used for a kernel without profile entries. */
+int default_variant(int kernel);
+/* The Fortran loops, reference of the tuner. */
+int fortran_variant(int kernel);
+
+/* Floating point operations per grid point, for the reports. */
+int kernel_flops(int kernel);
+
+struct profile_entry {
+  int n;
+  int variant;
+  double seconds;
+};
+
+class profile {
+ public:
+  profile();
+  bool load(const std::string & path);
+  bool save(const std::string & path) const;
+  void set(int kernel, int n, int variant, double seconds);
+  bool has(int kernel) const;
+  /* Variant measured for the closest grid size (default if none). */
+  int select(int kernel, int n) const;
+  bool empty() const;
+  std::string host;
+ private:
+  std::vector< std::map<int,profile_entry> > entries_;
+};
+
+/* Profile of the run, loaded with the library. */
+profile & machine_profile();
+/* File it was read from, empty without BIGDFT_CONV_PROFILE. */
+const std::string & machine_profile_path();
+
+/* Variant run by the dispatcher for a grid of n points (fine points for
+   the wavelet transforms, n1+1 for the kinetic operator). */
+int dispatch_variant(int kernel, int n);
+
+/* Apply a variant as the dispatcher does: the lines of the variants that
+   are not threaded are shared over the OpenMP threads. */
+void run_line(const variant & v, int n, int ndat, const double * x, double * y);
+
+} // namespace conv1d
+
+#endif
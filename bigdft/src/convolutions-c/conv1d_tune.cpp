@@ -0,0 +1,143 @@
+//! @file
+//!  Autotuner of the periodic convolutions: times every variant of the
+//!  registry (Fortran loops, AVX kernels, conv1d blockings) on a set of grid
+//!  sizes, writes the machine profile and checks that the profile read back
+//!  makes the dispatcher select the measured variants.
+//!
+//!  Usage: conv1d_tune [profile file] [maximal grid size]
+//!
+//! @author
+//!    Copyright (C) 2017 BigDFT group
+//!    This file is distributed under the terms of the
+//!    GNU General Public License, see ~/COPYING file
+//!    or http://www.gnu.org/copyleft/gpl.txt .
+//!    For the list of contributors, see ~/AUTHORS
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include <time.h>
+#include <unistd.h>
+#include "conv1d_profile.hpp"
+
+using namespace conv1d;
+
+static const int sizes[] = {16, 24, 32, 48, 64, 96, 128, 160, 200, 256, 300, 400};
+static const int nsizes = sizeof(sizes)/sizeof(sizes[0]);
+static const int nrep = 5;
+
+static double wtime()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec + 1e-9*ts.tv_nsec;
+}
+
+static void fill(std::vector<double> & v)
+{
+  for (size_t i = 0; i < v.size(); ++i) v[i] = std::sin(0.37*i) + 0.01*(i%17);
+}
+
+static double maxdiff(const std::vector<double> & a, const std::vector<double> & b)
+{
+  double d = 0.0;
+  for (size_t i = 0; i < a.size(); ++i) d = std::max(d,std::fabs(a[i]-b[i]));
+  return d;
+}
+
+/* Best of nrep runs of one variant, the output is left in y. */
+static double time_variant(int kernel, const variant & v, int n, int ndat,
+                           const std::vector<double> & x, std::vector<double> & y)
+{
+  const double hgrid[3] = {0.45, 0.45, 0.45};
+  double best = 1e30;
+  for (int r = 0; r < nrep; ++r) {
+    double t0 = wtime();
+    if (kernel == kinetic_per)
+      v.kinetic(n-1,n-1,n-1,hgrid,&x[0],&y[0],0.5);
+    else
+      run_line(v,n,ndat,&x[0],&y[0]);
+    best = std::min(best,wtime()-t0);
+  }
+  return best;
+}
+
+int main(int argc, char ** argv)
+{
+  const char * path = argc > 1 ? argv[1] : "conv1d_profile.yaml";
+  const int nmax = argc > 2 ? std::atoi(argv[2]) : 400;
+  int ierr = 0;
+  profile prof;
+  char host[128] = "unknown";
+  gethostname(host,sizeof(host)-1);
+  prof.host = host;
+
+  for (int k = 0; k < nkernels; ++k) {
+    const std::vector<variant> & vs = variants(k);
+    std::printf("%s:\n",kernel_name(k));
+    for (int is = 0; is < nsizes && sizes[is] <= nmax; ++is) {
+      const int n = sizes[is];
+      //the 3D kernel is kept to a few seconds on the largest grids
+      if (k == kinetic_per && n > 160) break;
+      //a full n^3 grid for the 3D kernel, at most 4M points for the lines
+      const int ndat = (k == kinetic_per) ? n*n : std::min(n*n,(1<<22)/n);
+      const size_t npts = (size_t)n*ndat;
+      std::vector<double> x(npts), ref(npts), y(npts);
+      fill(x);
+      //the Fortran loops are the reference, the default variant the baseline
+      const int iref = fortran_variant(k);
+      const int idef = default_variant(k);
+      std::vector<double> times(vs.size());
+      times[iref] = time_variant(k,vs[iref],n,ndat,x,ref);
+      double tol = 0.0;
+      for (size_t i = 0; i < ref.size(); ++i) tol = std::max(tol,std::fabs(ref[i]));
+      tol = 1e-12*std::max(1.0,tol);
+      int best = iref;
+      for (int iv = 0; iv < (int)vs.size(); ++iv) {
+        if (iv == iref) continue;
+        times[iv] = time_variant(k,vs[iv],n,ndat,x,y);
+        double d = maxdiff(ref,y);
+        if (d > tol) {
+          std::printf("  ERROR: variant %s differs by %g at n=%d\n",vs[iv].name.c_str(),d,n);
+          ierr = 1;
+          continue;
+        }
+        if (times[iv] < times[best]) best = iv;
+      }
+      prof.set(k,n,best,times[best]);
+      std::printf("  n=%4d  %-10s %8.3f GFlops  (default %s %8.3f, fortran %8.3f)\n",
+                  n,vs[best].name.c_str(),1e-9*kernel_flops(k)*npts/times[best],
+                  vs[idef].name.c_str(),1e-9*kernel_flops(k)*npts/times[idef],
+                  1e-9*kernel_flops(k)*npts/times[iref]);
+    }
+  }
+
+  if (!prof.save(path)) {
+    std::fprintf(stderr,"conv1d_tune: cannot write %s\n",path);
+    return 1;
+  }
+  std::printf("profile written to %s\n",path);
+
+  //read the file back as the library does and check the dispatcher
+  profile back;
+  int nbad = 0;
+  if (!back.load(path)) {
+    std::fprintf(stderr,"conv1d_tune: cannot read back %s\n",path);
+    return 1;
+  }
+  machine_profile() = back;
+  for (int k = 0; k < nkernels; ++k)
+    for (int is = 0; is < nsizes && sizes[is] <= nmax; ++is) {
+      const int n = sizes[is];
+      if (k == kinetic_per && n > 160) break;
+      const int best = prof.select(k,n);
+      if (back.select(k,n) != best || dispatch_variant(k,n) != best) {
+        std::printf("  ERROR: %s n=%d dispatches %s instead of %s\n",kernel_name(k),n,
+                    variants(k)[dispatch_variant(k,n)].name.c_str(),variants(k)[best].name.c_str());
+        ++nbad;
+      }
+    }
+  std::printf("profile read back: %s\n",nbad == 0 ? "tuned variants selected" : "MISMATCH");
+  return (ierr || nbad) ? 1 : 0;
+}
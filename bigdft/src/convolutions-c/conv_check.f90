@@ -24,10 +24,10 @@ program conv_check
   character(len=*), parameter :: subname='conv_check'
   character(len=50) :: chain
   integer :: i,i_stat,i_all,j,i1,i2,i3,ntimes,ndat,i1_max,i_max,it0,it1,ndim,itimes
-  integer :: count_rate,count_max,l,ierror,i1s,i1e
+  integer :: count_rate,count_max,l,ierror,i1s,i1e,isa,avx_strict,navx_fail
   integer :: n1s,n1e,ndats,ndate,nvctr_cf,nseg,iseg
   real(wp) :: tt,scale
-  real(gp) :: v,p,CPUtime,GPUtime,comp,ekin
+  real(gp) :: v,p,CPUtime,GPUtime,comp,ekin,avx_tol
   real(gp), dimension(3) :: hgridh
   real(gp), dimension(8) :: scal
   integer, dimension(:), allocatable :: keyv,modarr
@@ -251,6 +251,20 @@ program conv_check
   call MPI_COMM_SIZE(MPI_COMM_WORLD,nproc,ierr)
 
   ekin=0.0_wp
+
+  !convrot_n_per, convrot_t_per, ana_rot_per and syn_rot_per hand their
+  !lines to the variant of the machine profile (AVX, conv1d): the dispatch is
+  !switched off so that they are kept as Fortran references here
+  call conv_avx_isa(isa)
+  call conv1d_dispatch_set(0)
+  !without FMA the AVX kernels must give the Fortran results bit by bit
+  call conv_avx_strict(avx_strict)
+  if (avx_strict /= 0) then
+     avx_tol=0.0_gp
+  else
+     avx_tol=3.d-7
+  end if
+  navx_fail=0
   
   !call set_gpu_double() !after this call, all memory operations are in double precision, call set_gpu_simple() in order to have simple memory operations
 !  call init_thread_engine();
@@ -543,6 +557,278 @@ program conv_check
 
            call compare_time(CPUtime,GPUtime,n1*ndat,32,ntimes,maxdiff,3.d-7)
 
+           !runtime-dispatched AVX2/AVX-512 kernels, compared with the
+           !reference convrot_n_per/convrot_t_per outputs above
+           call convrot_n_per(n1-1,ndat,psi_in,psi_out)
+
+           if (iproc == 0) then
+             write(*,'(a,i7,i7,a,i2)')'CPU avx Convolutions, dimensions:',n1,ndat,', isa:',isa
+           end if
+
+           call nanosec(tsc0);
+           do i=1,ntimes
+              call magicfilter1d_avx(n1,ndat,psi_in,psi_cuda)
+           end do
+           call nanosec(tsc1);
+
+           GPUtime=real(tsc1-tsc0,kind=8)*1d-9
+
+           call print_time(GPUtime,n1*ndat,32,ntimes)
+
+           call compare_2D_results(ndat, n1, psi_out, psi_cuda, maxdiff, avx_tol)
+           call check_avx_result(maxdiff)
+
+           call compare_time(CPUtime,GPUtime,n1*ndat,32,ntimes,maxdiff,avx_tol)
+
+           call convrot_t_per(n1-1,ndat,psi_in,psi_out)
+
+           if (iproc == 0) then
+             write(*,'(a,i7,i7,a,i2)')'CPU avx Convolutions T, dimensions:',n1,ndat,', isa:',isa
+           end if
+
+           call nanosec(tsc0);
+           do i=1,ntimes
+              call magicfilter1d_t_avx(n1,ndat,psi_in,psi_cuda)
+           end do
+           call nanosec(tsc1);
+
+           GPUtime=real(tsc1-tsc0,kind=8)*1d-9
+
+           call print_time(GPUtime,n1*ndat,32,ntimes)
+
+           call compare_2D_results(ndat, n1, psi_out, psi_cuda, maxdiff, avx_tol)
+           call check_avx_result(maxdiff)
+
+           call compare_time(CPUtime,GPUtime,n1*ndat,32,ntimes,maxdiff,avx_tol)
+
+           !one direction of the kinetic operator, y=c*x-1/2 d2x/dx2
+           call kinetic1d_per_simple(n1,ndat,fil,0.5_wp,psi_in,psi_out)
+
+           if (iproc == 0) then
+             write(*,'(a,i7,i7,a,i2)')'CPU avx Kinetic 1D, dimensions:',n1,ndat,', isa:',isa
+           end if
+
+           call nanosec(tsc0);
+           do i=1,ntimes
+              call kinetic1d_avx(n1,ndat,hx,0.5_wp,psi_in,psi_cuda)
+           end do
+           call nanosec(tsc1);
+
+           GPUtime=real(tsc1-tsc0,kind=8)*1d-9
+
+           call print_time(GPUtime,n1*ndat,29*2,ntimes)
+
+           call compare_2D_results(ndat, n1, psi_out, psi_cuda, maxdiff, avx_tol)
+           call check_avx_result(maxdiff)
+
+           !three-dimensional magic filter, against convolut_magic_n_per
+           !and convolut_magic_t_per (the psi_3d_tmp work array is spared)
+           if (iproc == 0) then
+             write(*,'(a,i7,i7,i7)')'CPU 3D magic filter, dimensions:',n1,n2,n3
+           end if
+
+           call nanosec(tsc0);
+           do itimes=1,ntimes
+              call convolut_magic_n_per(n1-1,n2-1,n3-1,psi_3d_in(1,1,1,itimes),&
+                   psi_3d_out(1,1,1,itimes),psi_3d_tmp(1,1,1,itimes))
+           end do
+           call nanosec(tsc1);
+
+           CPUtime=real(tsc1-tsc0,kind=8)*1d-9
+
+           call print_time(CPUtime,n1*n2*n3,32*3,ntimes)
+
+           if (iproc == 0) then
+             write(*,'(a,i7,i7,i7,a,i2)')'CPU avx 3D magic filter, dimensions:',n1,n2,n3,', isa:',isa
+           end if
+
+           call nanosec(tsc0);
+           do itimes=1,ntimes
+              call magicfilter3d_avx(n1-1,n2-1,n3-1,psi_3d_in(1,1,1,itimes),&
+                   psi_3d_cuda(1,1,1,itimes),psi_3d_tmp(1,1,1,itimes))
+           end do
+           call nanosec(tsc1);
+
+           GPUtime=real(tsc1-tsc0,kind=8)*1d-9
+
+           call print_time(GPUtime,n1*n2*n3,32*3,ntimes)
+
+           call compare_3D_results(n1,n2,n3,psi_3d_out, psi_3d_cuda, maxdiff, avx_tol)
+           call check_avx_result(maxdiff)
+
+           call compare_time(CPUtime,GPUtime,n1*n2*n3,32*3,ntimes,maxdiff,avx_tol)
+
+           do itimes=1,ntimes
+              call convolut_magic_t_per(n1-1,n2-1,n3-1,psi_3d_in(1,1,1,itimes),&
+                   psi_3d_out(1,1,1,itimes))
+           end do
+
+           if (iproc == 0) then
+             write(*,'(a,i7,i7,i7,a,i2)')'CPU avx 3D magic filter T, dimensions:',n1,n2,n3,', isa:',isa
+           end if
+
+           call nanosec(tsc0);
+           do itimes=1,ntimes
+              call magicfilter3d_t_avx(n1-1,n2-1,n3-1,psi_3d_in(1,1,1,itimes),&
+                   psi_3d_cuda(1,1,1,itimes),psi_3d_tmp(1,1,1,itimes))
+           end do
+           call nanosec(tsc1);
+
+           GPUtime=real(tsc1-tsc0,kind=8)*1d-9
+
+           call print_time(GPUtime,n1*n2*n3,32*3,ntimes)
+
+           call compare_3D_results(n1,n2,n3,psi_3d_out, psi_3d_cuda, maxdiff, avx_tol)
+           call check_avx_result(maxdiff)
+
+           !analysis and synthesis need an even number of points
+           if (modulo(n1,2) == 0) then
+              call ana_rot_per(n1/2-1,ndat,psi_in,psi_out)
+
+              if (iproc == 0) then
+                write(*,'(a,i7,i7,a,i2)')'CPU avx Analysis, dimensions:',n1,ndat,', isa:',isa
+              end if
+
+              call nanosec(tsc0);
+              do i=1,ntimes
+                 call ana_rot_per_avx(n1/2-1,ndat,psi_in,psi_cuda)
+              end do
+              call nanosec(tsc1);
+
+              GPUtime=real(tsc1-tsc0,kind=8)*1d-9
+
+              call print_time(GPUtime,n1*ndat,32,ntimes)
+
+              call compare_2D_results(ndat, n1, psi_out, psi_cuda, maxdiff, avx_tol)
+              call check_avx_result(maxdiff)
+
+              call compare_time(CPUtime,GPUtime,n1*ndat,32,ntimes,maxdiff,avx_tol)
+
+              !the unrolled syn_rot_per skips the zero taps, the AVX kernel
+              !follows the order of syn_rot_per_simple
+              call syn_rot_per_simple(n1/2-1,ndat,psi_in,psi_out)
+
+              if (iproc == 0) then
+                write(*,'(a,i7,i7,a,i2)')'CPU avx Synthesis, dimensions:',n1,ndat,', isa:',isa
+              end if
+
+              call nanosec(tsc0);
+              do i=1,ntimes
+                 call syn_rot_per_avx(n1/2-1,ndat,psi_in,psi_cuda)
+              end do
+              call nanosec(tsc1);
+
+              GPUtime=real(tsc1-tsc0,kind=8)*1d-9
+
+              call print_time(GPUtime,n1*ndat,32,ntimes)
+
+              call compare_2D_results(ndat, n1, psi_out, psi_cuda, maxdiff, avx_tol)
+              call check_avx_result(maxdiff)
+
+              call compare_time(CPUtime,GPUtime,n1*ndat,32,ntimes,maxdiff,avx_tol)
+
+              !templated C++ analysis and synthesis against the Fortran ones
+              if (iproc == 0) then
+                write(*,'(a,i7,i7)')'CPU Analysis, dimensions:',n1,ndat
+              end if
+
+              call nanosec(tsc0);
+              do i=1,ntimes
+                 call ana_rot_per(n1/2-1,ndat,psi_in,psi_out)
+              end do
+              call nanosec(tsc1);
+
+              CPUtime=real(tsc1-tsc0,kind=8)*1d-9
+
+              call print_time(CPUtime,n1*ndat,32,ntimes)
+
+              if (iproc == 0) then
+                write(*,'(a,i7,i7)')'CPU conv1d Analysis, dimensions:',n1,ndat
+              end if
+
+              call nanosec(tsc0);
+              do i=1,ntimes
+                 call conv1d_ana_rot_per(n1/2-1,ndat,psi_in,psi_cuda)
+              end do
+              call nanosec(tsc1);
+
+              GPUtime=real(tsc1-tsc0,kind=8)*1d-9
+
+              call print_time(GPUtime,n1*ndat,32,ntimes)
+
+              call compare_2D_results(ndat, n1, psi_out, psi_cuda, maxdiff, 3.d-7)
+
+              call compare_time(CPUtime,GPUtime,n1*ndat,32,ntimes,maxdiff,3.d-7)
+
+              if (iproc == 0) then
+                write(*,'(a,i7,i7)')'CPU Synthesis, dimensions:',n1,ndat
+              end if
+
+              call nanosec(tsc0);
+              do i=1,ntimes
+                 call syn_rot_per(n1/2-1,ndat,psi_in,psi_out)
+              end do
+              call nanosec(tsc1);
+
+              CPUtime=real(tsc1-tsc0,kind=8)*1d-9
+
+              call print_time(CPUtime,n1*ndat,32,ntimes)
+
+              if (iproc == 0) then
+                write(*,'(a,i7,i7)')'CPU conv1d Synthesis, dimensions:',n1,ndat
+              end if
+
+              call nanosec(tsc0);
+              do i=1,ntimes
+                 call conv1d_syn_rot_per(n1/2-1,ndat,psi_in,psi_cuda)
+              end do
+              call nanosec(tsc1);
+
+              GPUtime=real(tsc1-tsc0,kind=8)*1d-9
+
+              call print_time(GPUtime,n1*ndat,32,ntimes)
+
+              call compare_2D_results(ndat, n1, psi_out, psi_cuda, maxdiff, 3.d-7)
+
+              call compare_time(CPUtime,GPUtime,n1*ndat,32,ntimes,maxdiff,3.d-7)
+           end if
+
+           !three-dimensional kinetic operator, periodic BC
+           hgridh(:)=hx
+           if (iproc == 0) then
+             write(*,'(a,i7,i7,i7)')'CPU Kinetic, dimensions:',n1,n2,n3
+           end if
+
+           call nanosec(tsc0);
+           do itimes=1,ntimes
+              call convolut_kinetic_per_c(n1-1,n2-1,n3-1,hgridh,psi_3d_in(1,1,1,itimes),&
+                   psi_3d_out(1,1,1,itimes),0.5_gp)
+           end do
+           call nanosec(tsc1);
+
+           CPUtime=real(tsc1-tsc0,kind=8)*1d-9
+
+           call print_time(CPUtime,n1*n2*n3,29*3,ntimes)
+
+           if (iproc == 0) then
+             write(*,'(a,i7,i7,i7)')'CPU conv1d Kinetic, dimensions:',n1,n2,n3
+           end if
+
+           call nanosec(tsc0);
+           do itimes=1,ntimes
+              call conv1d_kinetic_per_c(n1-1,n2-1,n3-1,hgridh,psi_3d_in(1,1,1,itimes),&
+                   psi_3d_cuda(1,1,1,itimes),0.5_gp)
+           end do
+           call nanosec(tsc1);
+
+           GPUtime=real(tsc1-tsc0,kind=8)*1d-9
+
+           call print_time(GPUtime,n1*n2*n3,29*3,ntimes)
+
+           call compare_3D_results(n1,n2,n3,psi_3d_out, psi_3d_cuda, maxdiff, 3.d-7)
+
+           call compare_time(CPUtime,GPUtime,n1*n2*n3,29*3,ntimes,maxdiff,3.d-7)
+
  
         end do
      end do
@@ -555,8 +841,24 @@ program conv_check
 
   call MPI_FINALIZE(ierr)
 
+  if (navx_fail > 0) then
+     write(*,'(a,i6,a)')'ERROR: ',navx_fail,' strict AVX results differ from the Fortran ones'
+     stop 1
+  end if
+
 contains
 
+  !> Strict AVX kernels (no FMA) are checked for bitwise equality
+  subroutine check_avx_result(maxdiff)
+    implicit none
+    real(gp), intent(in) :: maxdiff
+
+    if (iproc == 0 .and. avx_strict /= 0 .and. maxdiff /= 0.0_gp) then
+      write(*,'(a,1pe12.5)')'<<<< ERROR: strict AVX kernel not bitwise equal, maxdiff=',maxdiff
+      navx_fail=navx_fail+1
+    end if
+  END SUBROUTINE check_avx_result
+
   subroutine start_counters(events,event_number,ierror)
     implicit none
     integer, intent(in) :: event_number
@@ -764,6 +1066,32 @@ subroutine convrot_n_per_simple(n1,ndat,x,y)
 
 END SUBROUTINE convrot_n_per_simple
 
+!> One periodic direction of the kinetic operator, y(ndat,0:n1-1)=c*x+sum_l fil(l)*x(i+l),
+!! taps in increasing l (reference of kinetic1d_avx)
+subroutine kinetic1d_per_simple(n1,ndat,fil,c,x,y)
+  use module_base
+  implicit none
+  integer, intent(in) :: n1,ndat
+  real(wp), intent(in) :: c
+  real(wp), dimension(-14:14), intent(in) :: fil
+  real(wp), dimension(0:(n1-1),ndat), intent(in) :: x
+  real(wp), dimension(ndat,0:(n1-1)), intent(out) :: y
+  !local variables
+  integer :: i,j,l
+  real(wp) :: tt
+
+  do j=1,ndat
+     do i=0,n1-1
+        tt=c*x(i,j)
+        do l=-14,14
+           tt=tt+x(modulo(i+l,n1),j)*fil(l)
+        enddo
+        y(j,i)=tt
+     enddo
+  enddo
+
+END SUBROUTINE kinetic1d_per_simple
+
 subroutine convrot_n_per_3d_simple_transpose(n1,n2,n3,x,y,tmp)
   use module_base
   implicit none
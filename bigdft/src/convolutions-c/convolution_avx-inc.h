@@ -0,0 +1,160 @@
+//! @file
+//!  Body of the periodic convolution kernels, instantiated once per vector
+//!  width by convolution_avx.c.
+//!
+//!  The including file defines:
+//!    CONV_SUFFIX  name suffix of the instance (generic, avx2, avx512)
+//!    CONV_TARGET  function attribute enabling the instruction set
+//!    CONV_W       number of doubles in a vector
+//!    conv_vec     the vector type
+//!    CONV_LOAD, CONV_STORE, CONV_SET1, CONV_MUL, CONV_FMA(a,b,c)=a*b+c
+//!
+//!  CONV_W independent lines (the ndat direction) are packed in one vector,
+//!  so that every tap of the filter is a broadcast multiply-add and the
+//!  transposed output of the Fortran kernels is a contiguous store.
+//!
+//! @author
+//!    Copyright (C) 2017 BigDFT group
+//!    This file is distributed under the terms of the
+//!    GNU General Public License, see ~/COPYING file
+//!    or http://www.gnu.org/copyleft/gpl.txt .
+//!    For the list of contributors, see ~/AUTHORS
+
+#define CONV_CAT_(a,b) a##_##b
+#define CONV_CAT(a,b) CONV_CAT_(a,b)
+#define CONV_FN(name) CONV_CAT(name,CONV_SUFFIX)
+
+/* Gather CONV_W lines of stride ld into buf, interleaved, with periodic
+   wrapping: buf[p*CONV_W+w] = source[w*ld + modulo(p+shift,nper)]. */
+static CONV_TARGET void CONV_FN(conv_fill)(size_t nper, long shift, size_t nbuf, size_t ld,
+                               double const * source, double * buf){
+  size_t p,w,idx;
+  long s = shift % (long)nper;
+  idx = (size_t)(s < 0 ? s + (long)nper : s);
+  for(p=0;p<nbuf;p++){
+    for(w=0;w<CONV_W;w++) buf[p*CONV_W+w] = source[w*ld+idx];
+    if(++idx == nper) idx=0;
+  }
+}
+
+/* dest[j*ldd] = c*buf[step*j+center] + sum_k fil[k]*buf[step*j+k], j<nout.
+   The sum is done in the order of the Fortran reference kernels. Four
+   outputs are computed together to hide the latency of the FMA chain. */
+static CONV_TARGET void CONV_FN(conv_apply)(size_t nout, size_t step, size_t nfil, double const * fil,
+                                            double c, size_t center, double const * buf,
+                                            double * dest, size_t ldd){
+  size_t j,k,k0;
+  conv_vec F,A0,A1,A2,A3;
+  k0 = (c == 0.0) ? 1 : 0;
+  for(j=0;j+4<=nout;j+=4){
+    double const * b = buf+step*j*CONV_W;
+    if(k0==0){
+      F = CONV_SET1(c);
+      A0 = CONV_MUL(F,CONV_LOAD(b+center*CONV_W));
+      A1 = CONV_MUL(F,CONV_LOAD(b+(step+center)*CONV_W));
+      A2 = CONV_MUL(F,CONV_LOAD(b+(2*step+center)*CONV_W));
+      A3 = CONV_MUL(F,CONV_LOAD(b+(3*step+center)*CONV_W));
+    } else {
+      F = CONV_SET1(fil[0]);
+      A0 = CONV_MUL(F,CONV_LOAD(b));
+      A1 = CONV_MUL(F,CONV_LOAD(b+step*CONV_W));
+      A2 = CONV_MUL(F,CONV_LOAD(b+2*step*CONV_W));
+      A3 = CONV_MUL(F,CONV_LOAD(b+3*step*CONV_W));
+    }
+    for(k=k0;k<nfil;k++){
+      F = CONV_SET1(fil[k]);
+      A0 = CONV_FMA(F,CONV_LOAD(b+k*CONV_W),A0);
+      A1 = CONV_FMA(F,CONV_LOAD(b+(step+k)*CONV_W),A1);
+      A2 = CONV_FMA(F,CONV_LOAD(b+(2*step+k)*CONV_W),A2);
+      A3 = CONV_FMA(F,CONV_LOAD(b+(3*step+k)*CONV_W),A3);
+    }
+    CONV_STORE(dest+j*ldd,A0);
+    CONV_STORE(dest+(j+1)*ldd,A1);
+    CONV_STORE(dest+(j+2)*ldd,A2);
+    CONV_STORE(dest+(j+3)*ldd,A3);
+  }
+  for(;j<nout;j++){
+    double const * b = buf+step*j*CONV_W;
+    if(k0==0){
+      A0 = CONV_MUL(CONV_SET1(c),CONV_LOAD(b+center*CONV_W));
+    } else {
+      A0 = CONV_MUL(CONV_SET1(fil[0]),CONV_LOAD(b));
+    }
+    for(k=k0;k<nfil;k++) A0 = CONV_FMA(CONV_SET1(fil[k]),CONV_LOAD(b+k*CONV_W),A0);
+    CONV_STORE(dest+j*ldd,A0);
+  }
+}
+
+/* Synthesis step: even and odd outputs from the scaling (bc) and wavelet
+   (bw) halves. The taps enter in increasing l=-4..4 (decreasing buffer
+   position), the order of syn_rot_per in convolut_simple_per.f90. The
+   unrolled syn_rot_per of convolut_optim_per.f90 skips the zero taps and
+   starts the even outputs from l=4, so it differs in the last bits. */
+static CONV_TARGET void CONV_FN(conv_syn)(size_t nout, double const * che, double const * cge,
+                                          double const * cho, double const * cgo,
+                                          double const * bc, double const * bw,
+                                          double * dest, size_t ldd){
+  size_t j,k;
+  conv_vec SE,SO,XC,XW;
+  for(j=0;j<nout;j++){
+    XC = CONV_LOAD(bc+(j+8)*CONV_W);
+    XW = CONV_LOAD(bw+(j+8)*CONV_W);
+    SE = CONV_FMA(CONV_SET1(cge[0]),XW,CONV_MUL(CONV_SET1(che[0]),XC));
+    SO = CONV_FMA(CONV_SET1(cgo[0]),XW,CONV_MUL(CONV_SET1(cho[0]),XC));
+    for(k=1;k<9;k++){
+      XC = CONV_LOAD(bc+(j+8-k)*CONV_W);
+      XW = CONV_LOAD(bw+(j+8-k)*CONV_W);
+      SE = CONV_FMA(CONV_SET1(cge[k]),XW,CONV_FMA(CONV_SET1(che[k]),XC,SE));
+      SO = CONV_FMA(CONV_SET1(cgo[k]),XW,CONV_FMA(CONV_SET1(cho[k]),XC,SO));
+    }
+    CONV_STORE(dest+2*j*ldd,SE);
+    CONV_STORE(dest+(2*j+1)*ldd,SO);
+  }
+}
+
+/* Periodic filter along n for ndat lines, transposed output of leading
+   dimension ldd. Lines left over by the vector width go to the generic
+   instance. */
+static CONV_TARGET void CONV_FN(conv_periodic)(size_t n, size_t ndat, size_t ldd, long lowfil, size_t nfil,
+                                               double const * fil, double c,
+                                               double const * source, double * dest){
+  size_t i, nbuf = n+nfil+3;
+  double * buf = conv_buffer(nbuf*CONV_W);
+  for(i=0;i+CONV_W<=ndat;i+=CONV_W){
+    CONV_FN(conv_fill)(n,lowfil,nbuf,n,source+i*n,buf);
+    CONV_FN(conv_apply)(n,1,nfil,fil,c,(size_t)(-lowfil),buf,dest+i,ldd);
+  }
+  free(buf);
+  if(i<ndat) conv_periodic_generic(n,ndat-i,ldd,lowfil,nfil,fil,c,source+i*n,dest+i);
+}
+
+/* Analysis: x(0:2n+1,ndat) -> y(ldd,0:2n+1), scaling part then wavelets. */
+static CONV_TARGET void CONV_FN(conv_ana)(size_t n, size_t ndat, size_t ldd, double const * x, double * y){
+  size_t i, m = 2*n+2, nbuf = m+18;
+  double * buf = conv_buffer(nbuf*CONV_W);
+  for(i=0;i+CONV_W<=ndat;i+=CONV_W){
+    CONV_FN(conv_fill)(m,-7,nbuf,m,x+i*m,buf);
+    CONV_FN(conv_apply)(n+1,2,16,conv_ch,0.0,0,buf,y+i,ldd);
+    CONV_FN(conv_apply)(n+1,2,16,conv_cg,0.0,0,buf,y+(n+1)*ldd+i,ldd);
+  }
+  free(buf);
+  if(i<ndat) conv_ana_generic(n,ndat-i,ldd,x+i*m,y+i);
+}
+
+/* Synthesis: x(0:2n+1,ndat) -> y(ldd,0:2n+1). */
+static CONV_TARGET void CONV_FN(conv_synthesis)(size_t n, size_t ndat, size_t ldd, double const * x, double * y){
+  size_t i, m = 2*n+2, nbuf = n+10;
+  double * bc = conv_buffer(2*nbuf*CONV_W);
+  double * bw = bc+nbuf*CONV_W;
+  for(i=0;i+CONV_W<=ndat;i+=CONV_W){
+    CONV_FN(conv_fill)(n+1,-4,nbuf,m,x+i*m,bc);
+    CONV_FN(conv_fill)(n+1,-4,nbuf,m,x+i*m+n+1,bw);
+    CONV_FN(conv_syn)(n+1,conv_syn_che,conv_syn_cge,conv_syn_cho,conv_syn_cgo,bc,bw,y+i,ldd);
+  }
+  free(bc);
+  if(i<ndat) conv_synthesis_generic(n,ndat-i,ldd,x+i*m,y+i);
+}
+
+#undef CONV_FN
+#undef CONV_CAT
+#undef CONV_CAT_
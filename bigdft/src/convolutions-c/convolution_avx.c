@@ -0,0 +1,390 @@
+//! @file
+//!  Periodic convolutions for AVX2 (4-wide FMA) and AVX-512 (8-wide FMA),
+//!  selected at startup from CPUID.
+//!
+//!  The vector kernels are instantiated from convolution_avx-inc.h for each
+//!  width. The instruction set is fixed at load time by conv_avx_init(), can
+//!  be restricted with the BIGDFT_CONV_ISA environment variable
+//!  (generic, avx2, avx512) and queried from Fortran with conv_avx_isa.
+//!  When it is above generic, convrot_n_per, convrot_t_per, ana_rot_per
+//!  and syn_rot_per of orbitals/convolut_optim_per.f90 hand their lines
+//!  to these kernels, which share them over the OpenMP threads.
+//!  By default the taps are accumulated with separate multiply and add,
+//!  which reproduces bit by bit the Fortran reference kernels (same
+//!  summation order). Configure with --enable-convolutions-fma (which
+//!  defines CONV_AVX_FMA) to fuse them, the results then differ in the
+//!  last bits. conv_avx_strict tells which one was compiled.
+//!
+//! @author
+//!    Copyright (C) 2017 BigDFT group
+//!    This file is distributed under the terms of the
+//!    GNU General Public License, see ~/COPYING file
+//!    or http://www.gnu.org/copyleft/gpl.txt .
+//!    For the list of contributors, see ~/AUTHORS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "convolution_avx.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define CONV_HAVE_X86 1
+#include <immintrin.h>
+#endif
+
+/* Magic filter for Daubechies-16, lowfil=-8 (convrot_n_per). */
+static const double conv_mf[16] = {
+   8.4334247333529341094733325815816e-7,
+  -0.1290557201342060969516786758559028e-4,
+   0.8762984476210559564689161894116397e-4,
+  -0.30158038132690463167163703826169879e-3,
+   0.174723713672993903449447812749852942e-2,
+  -0.942047030201080385922711540948195075e-2,
+   0.2373821463724942397566389712597274535e-1,
+   0.612625895831207982195380597e-1,
+   0.9940415697834003993178616713,
+  -0.604895289196983516002834636e-1,
+  -0.2103025160930381434955489412839065067e-1,
+   0.1337263414854794752733423467013220997e-1,
+  -0.344128144493493857280881509686821861e-2,
+   0.49443227688689919192282259476750972e-3,
+  -0.5185986881173432922848639136911487e-4,
+   2.72734492911979659657715313017228e-6};
+
+/* Transposed magic filter, lowfil=-7 (convrot_t_per). */
+static const double conv_mf_t[16] = {
+   2.72734492911979659657715313017228e-6,
+  -0.5185986881173432922848639136911487e-4,
+   0.49443227688689919192282259476750972e-3,
+  -0.344128144493493857280881509686821861e-2,
+   0.1337263414854794752733423467013220997e-1,
+  -0.2103025160930381434955489412839065067e-1,
+  -0.604895289196983516002834636e-1,
+   0.9940415697834003993178616713,
+   0.612625895831207982195380597e-1,
+   0.2373821463724942397566389712597274535e-1,
+  -0.942047030201080385922711540948195075e-2,
+   0.174723713672993903449447812749852942e-2,
+  -0.30158038132690463167163703826169879e-3,
+   0.8762984476210559564689161894116397e-4,
+  -0.1290557201342060969516786758559028e-4,
+   8.4334247333529341094733325815816e-7};
+
+/* Second derivative filter for Daubechies-16, taps 0..14 (symmetric). */
+static const double conv_kin[15] = {
+  -3.5536922899131901941296809374e0,
+   2.2191465938911163898794546405e0,
+  -0.6156141465570069496314853949e0,
+   0.2371780582153805636239247476e0,
+  -0.0822663999742123340987663521e0,
+   0.02207029188482255523789911295638968409e0,
+  -0.409765689342633823899327051188315485e-2,
+   0.45167920287502235349480037639758496e-3,
+  -0.2398228524507599670405555359023135e-4,
+   2.0904234952920365957922889447361e-6,
+  -3.7230763047369275848791496973044e-7,
+  -1.05857055496741470373494132287e-8,
+  -5.813879830282540547959250667e-11,
+   2.70800493626319438269856689037647576e-13,
+  -6.924474940639200152025730585882e-18};
+
+/* Daubechies-16 scaling and wavelet filters, indices -7..8 (ana_rot_per). */
+static const double conv_ch[16] = {
+  -0.0033824159510050025955, -0.00054213233180001068935,
+   0.031695087811525991431,   0.0076074873249766081919,
+  -0.14329423835127266284,   -0.061273359067811077843,
+   0.48135965125905339159,    0.77718575169962802862,
+   0.36444189483617893676,   -0.051945838107881800736,
+  -0.027219029917103486322,   0.049137179673730286787,
+   0.0038087520138944894631, -0.014952258337062199118,
+  -0.00030292051472413308126, 0.0018899503327676891843};
+static const double conv_cg[16] = {
+  -0.0018899503327676891843, -0.00030292051472413308126,
+   0.014952258337062199118,   0.0038087520138944894631,
+  -0.049137179673730286787,  -0.027219029917103486322,
+   0.051945838107881800736,   0.36444189483617893676,
+  -0.77718575169962802862,    0.48135965125905339159,
+   0.061273359067811077843,  -0.14329423835127266284,
+  -0.0076074873249766081919,  0.031695087811525991431,
+   0.00054213233180001068935,-0.0033824159510050025955};
+
+/* Synthesis taps ch(2l),cg(2l),ch(2l+1),cg(2l+1) for l=-4..4, filled by
+   conv_avx_init() from conv_ch/conv_cg (zero outside -7..8). */
+static double conv_syn_che[9], conv_syn_cge[9], conv_syn_cho[9], conv_syn_cgo[9];
+
+static int conv_isa = -1;
+
+/* Below this number of lines the kernels run on the calling thread. */
+#define CONV_OMP_MIN 64
+
+/* Keep the compiler from contracting or reassociating the strict kernels. */
+#ifndef CONV_AVX_FMA
+#define CONV_STRICT_ATTR __attribute__((optimize("no-fast-math","fp-contract=off")))
+#else
+#define CONV_STRICT_ATTR
+#endif
+
+static double * conv_buffer(size_t size){
+  void * buf = NULL;
+  if(posix_memalign(&buf,64,size*sizeof(double)) != 0){
+    fprintf(stderr,"convolution_avx: cannot allocate %lu doubles\n",(unsigned long)size);
+    abort();
+  }
+  return (double *)buf;
+}
+
+/* Lines [*i0,*i0+*nd) of the calling thread, in blocks of the widest
+   vector so that only the last thread has a remainder. */
+static void conv_thread_lines(size_t ndat, size_t * i0, size_t * nd){
+#ifdef _OPENMP
+  size_t nt = (size_t)omp_get_num_threads(), it = (size_t)omp_get_thread_num();
+  size_t nblk = (ndat+7)/8, i1;
+  *i0 = 8*((nblk*it)/nt);
+  i1 = 8*((nblk*(it+1))/nt);
+  if(i1 > ndat) i1 = ndat;
+  *nd = i1 > *i0 ? i1-*i0 : 0;
+#else
+  *i0 = 0;
+  *nd = ndat;
+#endif
+}
+
+/* Generic instance, also used for the ndat remainder of the vector ones. */
+#define CONV_SUFFIX generic
+#define CONV_TARGET CONV_STRICT_ATTR
+#define CONV_W 1
+typedef double conv_vec_generic;
+#define conv_vec conv_vec_generic
+#define CONV_LOAD(p) (*(p))
+#define CONV_STORE(p,a) (*(p)=(a))
+#define CONV_SET1(a) (a)
+#define CONV_MUL(a,b) ((a)*(b))
+#define CONV_FMA(a,b,c) ((c)+(a)*(b))
+#include "convolution_avx-inc.h"
+#undef CONV_SUFFIX
+#undef CONV_TARGET
+#undef CONV_W
+#undef conv_vec
+#undef CONV_LOAD
+#undef CONV_STORE
+#undef CONV_SET1
+#undef CONV_MUL
+#undef CONV_FMA
+
+#ifdef CONV_HAVE_X86
+#define CONV_SUFFIX avx2
+#define CONV_TARGET __attribute__((target("avx2,fma"))) CONV_STRICT_ATTR
+#define CONV_W 4
+#define conv_vec __m256d
+#define CONV_LOAD(p) _mm256_loadu_pd(p)
+#define CONV_STORE(p,a) _mm256_storeu_pd(p,a)
+#define CONV_SET1(a) _mm256_set1_pd(a)
+#define CONV_MUL(a,b) _mm256_mul_pd(a,b)
+#ifndef CONV_AVX_FMA
+#define CONV_FMA(a,b,c) _mm256_add_pd(c,_mm256_mul_pd(a,b))
+#else
+#define CONV_FMA(a,b,c) _mm256_fmadd_pd(a,b,c)
+#endif
+#include "convolution_avx-inc.h"
+#undef CONV_SUFFIX
+#undef CONV_TARGET
+#undef CONV_W
+#undef conv_vec
+#undef CONV_LOAD
+#undef CONV_STORE
+#undef CONV_SET1
+#undef CONV_MUL
+#undef CONV_FMA
+
+#define CONV_SUFFIX avx512
+#define CONV_TARGET __attribute__((target("avx512f"))) CONV_STRICT_ATTR
+#define CONV_W 8
+#define conv_vec __m512d
+#define CONV_LOAD(p) _mm512_loadu_pd(p)
+#define CONV_STORE(p,a) _mm512_storeu_pd(p,a)
+#define CONV_SET1(a) _mm512_set1_pd(a)
+#define CONV_MUL(a,b) _mm512_mul_pd(a,b)
+#ifndef CONV_AVX_FMA
+#define CONV_FMA(a,b,c) _mm512_add_pd(c,_mm512_mul_pd(a,b))
+#else
+#define CONV_FMA(a,b,c) _mm512_fmadd_pd(a,b,c)
+#endif
+#include "convolution_avx-inc.h"
+#undef CONV_SUFFIX
+#undef CONV_TARGET
+#undef CONV_W
+#undef conv_vec
+#undef CONV_LOAD
+#undef CONV_STORE
+#undef CONV_SET1
+#undef CONV_MUL
+#undef CONV_FMA
+#endif
+
+static int conv_isa_detect(void){
+  int isa = CONV_ISA_GENERIC;
+#ifdef CONV_HAVE_X86
+  __builtin_cpu_init();
+  if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) isa = CONV_ISA_AVX2;
+  if(__builtin_cpu_supports("avx512f")) isa = CONV_ISA_AVX512;
+#endif
+  return isa;
+}
+
+static void __attribute__((constructor)) conv_avx_init(void){
+  const char * env;
+  int l, isa = conv_isa_detect();
+  for(l=-4;l<=4;l++){
+    int ie = 2*l, io = 2*l+1;
+    conv_syn_che[l+4] = (ie >= -7 && ie <= 8) ? conv_ch[ie+7] : 0.0;
+    conv_syn_cge[l+4] = (ie >= -7 && ie <= 8) ? conv_cg[ie+7] : 0.0;
+    conv_syn_cho[l+4] = (io >= -7 && io <= 8) ? conv_ch[io+7] : 0.0;
+    conv_syn_cgo[l+4] = (io >= -7 && io <= 8) ? conv_cg[io+7] : 0.0;
+  }
+  env = getenv("BIGDFT_CONV_ISA");
+  if(env != NULL){
+    int req = isa;
+    if(strcmp(env,"generic") == 0) req = CONV_ISA_GENERIC;
+    else if(strcmp(env,"avx2") == 0) req = CONV_ISA_AVX2;
+    else if(strcmp(env,"avx512") == 0) req = CONV_ISA_AVX512;
+    if(req < isa) isa = req;
+  }
+  conv_isa = isa;
+}
+
+static void conv_dispatch_periodic(size_t n, size_t ndat, long lowfil, size_t nfil,
+                                   double const * fil, double c, double const * x, double * y){
+  if(conv_isa < 0) conv_avx_init();
+#pragma omp parallel if(ndat >= CONV_OMP_MIN)
+  {
+    size_t i0, nd;
+    conv_thread_lines(ndat,&i0,&nd);
+    if(nd > 0){
+      switch(conv_isa){
+#ifdef CONV_HAVE_X86
+      case CONV_ISA_AVX512:
+        conv_periodic_avx512(n,nd,ndat,lowfil,nfil,fil,c,x+i0*n,y+i0);
+        break;
+      case CONV_ISA_AVX2:
+        conv_periodic_avx2(n,nd,ndat,lowfil,nfil,fil,c,x+i0*n,y+i0);
+        break;
+#endif
+      default:
+        conv_periodic_generic(n,nd,ndat,lowfil,nfil,fil,c,x+i0*n,y+i0);
+      }
+    }
+  }
+}
+
+void conv_avx_isa_(int *isa){
+  if(conv_isa < 0) conv_avx_init();
+  *isa = conv_isa;
+}
+
+/* 1 when the kernels are bitwise equal to the Fortran ones (no FMA). */
+void conv_avx_strict_(int *strict){
+#ifdef CONV_AVX_FMA
+  *strict = 0;
+#else
+  *strict = 1;
+#endif
+}
+
+/* Restrict the instruction set, never above what the CPU supports. */
+void conv_avx_set_isa_(int *isa){
+  int best = conv_isa_detect();
+  if(conv_isa < 0) conv_avx_init();
+  conv_isa = (*isa < best) ? *isa : best;
+  if(conv_isa < CONV_ISA_GENERIC) conv_isa = CONV_ISA_GENERIC;
+}
+
+void magicfilter1d_avx_(unsigned int *n, unsigned int *ndat, double const *source, double *dest){
+  conv_dispatch_periodic(*n,*ndat,-8,16,conv_mf,0.0,source,dest);
+}
+
+void magicfilter1d_t_avx_(unsigned int *n, unsigned int *ndat, double const *source, double *dest){
+  conv_dispatch_periodic(*n,*ndat,-7,16,conv_mf_t,0.0,source,dest);
+}
+
+/* Same interface as convolut_magic_n_per: three transposing passes. */
+void magicfilter3d_avx_(int *n1, int *n2, int *n3, double const *x, double *y, double *ww){
+  size_t m1 = *n1+1, m2 = *n2+1, m3 = *n3+1;
+  conv_dispatch_periodic(m1,m2*m3,-8,16,conv_mf,0.0,x,y);
+  conv_dispatch_periodic(m2,m3*m1,-8,16,conv_mf,0.0,y,ww);
+  conv_dispatch_periodic(m3,m1*m2,-8,16,conv_mf,0.0,ww,y);
+}
+
+/* Same interface as convolut_magic_t_per. */
+void magicfilter3d_t_avx_(int *n1, int *n2, int *n3, double const *x, double *y, double *ww){
+  size_t m1 = *n1+1, m2 = *n2+1, m3 = *n3+1;
+  conv_dispatch_periodic(m1,m2*m3,-7,16,conv_mf_t,0.0,x,y);
+  conv_dispatch_periodic(m2,m3*m1,-7,16,conv_mf_t,0.0,y,ww);
+  conv_dispatch_periodic(m3,m1*m2,-7,16,conv_mf_t,0.0,ww,y);
+}
+
+/* One direction of convolut_kinetic_per_c: y = c*x - 1/(2h^2) d^2x/dx^2,
+   with the transposed output of the other 1D kernels. */
+void kinetic1d_avx_(unsigned int *n, unsigned int *ndat, double const *hgrid, double const *c,
+                    double const *source, double *dest){
+  double fil[29];
+  double scale = -0.5/((*hgrid)*(*hgrid));
+  int l;
+  for(l=0;l<=14;l++){
+    fil[14+l] = conv_kin[l]*scale;
+    fil[14-l] = fil[14+l];
+  }
+  conv_dispatch_periodic(*n,*ndat,-14,29,fil,*c,source,dest);
+}
+
+/* Same interface as ana_rot_per: x(0:2n+1,ndat) -> y(ndat,0:2n+1). */
+void ana_rot_per_avx_(int *n, int *ndat, double const *x, double *y){
+  size_t m = 2*(size_t)*n+2;
+  if(conv_isa < 0) conv_avx_init();
+#pragma omp parallel if(*ndat >= CONV_OMP_MIN)
+  {
+    size_t i0, nd;
+    conv_thread_lines(*ndat,&i0,&nd);
+    if(nd > 0){
+      switch(conv_isa){
+#ifdef CONV_HAVE_X86
+      case CONV_ISA_AVX512:
+        conv_ana_avx512(*n,nd,*ndat,x+i0*m,y+i0);
+        break;
+      case CONV_ISA_AVX2:
+        conv_ana_avx2(*n,nd,*ndat,x+i0*m,y+i0);
+        break;
+#endif
+      default:
+        conv_ana_generic(*n,nd,*ndat,x+i0*m,y+i0);
+      }
+    }
+  }
+}
+
+/* Same interface as syn_rot_per. */
+void syn_rot_per_avx_(int *n, int *ndat, double const *x, double *y){
+  size_t m = 2*(size_t)*n+2;
+  if(conv_isa < 0) conv_avx_init();
+#pragma omp parallel if(*ndat >= CONV_OMP_MIN)
+  {
+    size_t i0, nd;
+    conv_thread_lines(*ndat,&i0,&nd);
+    if(nd > 0){
+      switch(conv_isa){
+#ifdef CONV_HAVE_X86
+      case CONV_ISA_AVX512:
+        conv_synthesis_avx512(*n,nd,*ndat,x+i0*m,y+i0);
+        break;
+      case CONV_ISA_AVX2:
+        conv_synthesis_avx2(*n,nd,*ndat,x+i0*m,y+i0);
+        break;
+#endif
+      default:
+        conv_synthesis_generic(*n,nd,*ndat,x+i0*m,y+i0);
+      }
+    }
+  }
+}
@@ -0,0 +1,41 @@
+//! @file
+//!  Runtime-dispatched AVX2/AVX-512 periodic convolutions (magic filter,
+//!  kinetic, analysis/synthesis)
+//!
+//! @author
+//!    Copyright (C) 2017 BigDFT group
+//!    This file is distributed under the terms of the
+//!    GNU General Public License, see ~/COPYING file
+//!    or http://www.gnu.org/copyleft/gpl.txt .
+//!    For the list of contributors, see ~/AUTHORS
+#ifndef CONVOLUTION_AVX_H
+#define CONVOLUTION_AVX_H
+
+/* Instruction sets known by the dispatcher, ordered by vector width. */
+#define CONV_ISA_GENERIC 0
+#define CONV_ISA_AVX2    1
+#define CONV_ISA_AVX512  2
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* All routines follow the conventions of the Fortran periodic kernels:
+   the input is (n,ndat), the output is transposed to (ndat,n). */
+void conv_avx_isa_(int *isa);
+void conv_avx_set_isa_(int *isa);
+void conv_avx_strict_(int *strict);
+
+void magicfilter1d_avx_(unsigned int *n, unsigned int *ndat, double const *source, double *dest);
+void magicfilter1d_t_avx_(unsigned int *n, unsigned int *ndat, double const *source, double *dest);
+void magicfilter3d_avx_(int *n1, int *n2, int *n3, double const *x, double *y, double *ww);
+void magicfilter3d_t_avx_(int *n1, int *n2, int *n3, double const *x, double *y, double *ww);
+void kinetic1d_avx_(unsigned int *n, unsigned int *ndat, double const *hgrid, double const *c,
+                    double const *source, double *dest);
+void ana_rot_per_avx_(int *n, int *ndat, double const *x, double *y);
+void syn_rot_per_avx_(int *n, int *ndat, double const *x, double *y);
+
+#ifdef __cplusplus
+ }
+#endif
+#endif
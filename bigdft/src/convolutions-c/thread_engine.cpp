@@ -16,282 +16,507 @@
 */
 #include <pthread.h>
 #include <iostream>
-#ifndef u32
-typedef unsigned int u32;
-#endif
-//#include <asm/msr.h>
+#include <algorithm>
+#include <new>
+#include <vector>
+#include <string>
 #include <sched.h>
 #include <sys/types.h>
+#include <dirent.h>
 #include <unistd.h>
-#include <semaphore.h>
+#include <stdio.h>
 #include <stdlib.h>
-//#include <errno.h>
-#include <libconfig.h++>
+#include <string.h>
+#include <stdint.h>
 #include "thread_engine.h"
 
 #define ASMPAUSE asm("" : : : "memory")
+#define CACHE_LINE 64
+/* Polls of the job counter before a worker goes to sleep. */
+#define SPIN_COUNT 20000
 
+struct thread_engine_param *engine_params = NULL;
 
-struct thread_data {
-  void * ( * volatile thread_code)(void * param);
-  void * volatile param;
+/* Range of iterations [lo,hi) packed in one word so that it can be
+   updated by a single compare and swap. */
+static inline uint64_t pack_range(int lo, int hi) {
+  return ((uint64_t)(uint32_t)lo << 32) | (uint32_t)hi;
+}
+static inline int range_lo(uint64_t r) { return (int)(uint32_t)(r >> 32); }
+static inline int range_hi(uint64_t r) { return (int)(uint32_t)r; }
+
+struct worker {
+  uint64_t range;            /* work-stealing deque of the worker */
+  int node;
+  int cpu;
+  pthread_t thread;
+  std::vector<int> victims;  /* same domain first */
+  char pad[CACHE_LINE];
+};
+
+struct numa_node {
+  std::vector<int> cpus;
+};
+
+enum job_kind { JOB_FOR, JOB_RUN };
+
+struct thread_pool {
+  int size;
+  int bind;
+  std::vector<numa_node> nodes;
+  std::vector<worker *> workers;
+  cpu_set_t initial_mask;
+  /* current job */
+  job_kind kind;
+  thread_pool_body body;
+  void (*fn)(int rank, void * arg);
+  void * arg;
+  int grain;
+  volatile unsigned long generation;
+  volatile int checkout;
+  volatile int sleepers;
+  volatile int quit;
   pthread_mutex_t mutex;
   pthread_cond_t cond;
-  pthread_spinlock_t spin;
+  pthread_mutex_t submit;
 };
 
-struct thread_param {
-  int thread_number;
+static thread_pool * pool = NULL;
+static __thread int pool_rank = -1;
+
+/* ------------------------------------------------------------------ */
+/* Topology                                                            */
+
+static void parse_cpulist(const char * s, std::vector<int> & cpus) {
+  while (*s && *s != '\n') {
+    char * end;
+    long a = strtol(s, &end, 10);
+    long b = a;
+    if (end == s) break;
+    s = end;
+    if (*s == '-') {
+      b = strtol(s+1, &end, 10);
+      s = end;
+    }
+    for (long c = a; c <= b; c++) cpus.push_back((int)c);
+    if (*s == ',') s++;
+  }
+}
+
+/* NUMA domains restricted to the CPUs the process may run on. */
+static void get_topology(cpu_set_t * mask, std::vector<numa_node> & nodes) {
+  DIR * dir = opendir("/sys/devices/system/node");
+  if (dir) {
+    std::vector<int> ids;
+    struct dirent * e;
+    while ((e = readdir(dir)) != NULL) {
+      int id;
+      if (sscanf(e->d_name, "node%d", &id) == 1) ids.push_back(id);
+    }
+    closedir(dir);
+    std::sort(ids.begin(), ids.end());
+    for (size_t i = 0; i < ids.size(); i++) {
+      char path[128], line[4096];
+      snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", ids[i]);
+      FILE * f = fopen(path, "r");
+      if (!f) continue;
+      std::vector<int> cpus;
+      if (fgets(line, sizeof(line), f)) parse_cpulist(line, cpus);
+      fclose(f);
+      numa_node n;
+      for (size_t j = 0; j < cpus.size(); j++)
+        if (cpus[j] < CPU_SETSIZE && CPU_ISSET(cpus[j], mask)) n.cpus.push_back(cpus[j]);
+      if (!n.cpus.empty()) nodes.push_back(n);
+    }
+  }
+  if (nodes.empty()) {
+    numa_node n;
+    for (int c = 0; c < CPU_SETSIZE; c++)
+      if (CPU_ISSET(c, mask)) n.cpus.push_back(c);
+    if (n.cpus.empty()) n.cpus.push_back(0);
+    nodes.push_back(n);
+  }
+}
+
+static void bind_worker(const worker * w) {
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  if (pool->bind == 2) {
+    CPU_SET(w->cpu, &cpuset);
+  } else if (pool->bind == 1) {
+    const std::vector<int> & cpus = pool->nodes[w->node].cpus;
+    for (size_t j = 0; j < cpus.size(); j++) CPU_SET(cpus[j], &cpuset);
+  } else {
+    return;
+  }
+  if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset) != 0)
+    perror("pthread_setaffinity_np");
+}
+
+/* ------------------------------------------------------------------ */
+/* Work stealing                                                       */
+
+/* Chunk of at most grain iterations from the front of the own range. */
+static bool pop_front(worker * w, int grain, int * lo, int * hi) {
+  uint64_t r = __atomic_load_n(&w->range, __ATOMIC_ACQUIRE);
+  for (;;) {
+    int l = range_lo(r), h = range_hi(r);
+    if (l >= h) return false;
+    int n = h - l < grain ? h - l : grain;
+    if (__atomic_compare_exchange_n(&w->range, &r, pack_range(l+n, h), false,
+                                    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+      *lo = l;
+      *hi = l+n;
+      return true;
+    }
+  }
+}
+
+/* Back half of the range of the victim: a chunk is returned, the rest goes
+   to the (empty) range of the thief. */
+static bool steal_back(worker * thief, worker * victim, int grain, int * lo, int * hi) {
+  uint64_t r = __atomic_load_n(&victim->range, __ATOMIC_ACQUIRE);
+  for (;;) {
+    int l = range_lo(r), h = range_hi(r);
+    if (l >= h) return false;
+    int mid = (h - l <= grain) ? l : h - (h - l)/2;
+    if (__atomic_compare_exchange_n(&victim->range, &r, pack_range(l, mid), false,
+                                    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+      int n = h - mid < grain ? h - mid : grain;
+      *lo = mid;
+      *hi = mid + n;
+      if (mid + n < h)
+        __atomic_store_n(&thief->range, pack_range(mid+n, h), __ATOMIC_RELEASE);
+      return true;
+    }
+  }
+}
+
+static void execute_job(int rank) {
+  worker * self = pool->workers[rank];
+  pool_rank = rank;
+  if (pool->kind == JOB_RUN) {
+    pool->fn(rank, pool->arg);
+  } else {
+    const int grain = pool->grain;
+    int lo, hi;
+    for (;;) {
+      if (pop_front(self, grain, &lo, &hi)) {
+        pool->body(lo, hi, pool->arg);
+        continue;
+      }
+      bool found = false;
+      for (size_t v = 0; v < self->victims.size() && !found; v++)
+        found = steal_back(self, pool->workers[self->victims[v]], grain, &lo, &hi);
+      if (!found) break;
+      pool->body(lo, hi, pool->arg);
+    }
+  }
+  pool_rank = -1;
+}
+
+static void * worker_main(void * arg) {
+  int rank = (int)(intptr_t)arg;
+  unsigned long seen = 0;
+  bind_worker(pool->workers[rank]);
+  while (1) {
+    int spin = 0;
+    while (__atomic_load_n(&pool->generation, __ATOMIC_ACQUIRE) == seen && spin < SPIN_COUNT) {
+      ASMPAUSE;
+      spin++;
+    }
+    if (__atomic_load_n(&pool->generation, __ATOMIC_ACQUIRE) == seen) {
+      pthread_mutex_lock(&pool->mutex);
+      __atomic_add_fetch(&pool->sleepers, 1, __ATOMIC_SEQ_CST);
+      while (__atomic_load_n(&pool->generation, __ATOMIC_SEQ_CST) == seen)
+        pthread_cond_wait(&pool->cond, &pool->mutex);
+      __atomic_sub_fetch(&pool->sleepers, 1, __ATOMIC_SEQ_CST);
+      pthread_mutex_unlock(&pool->mutex);
+    }
+    seen = __atomic_load_n(&pool->generation, __ATOMIC_ACQUIRE);
+    if (pool->quit) break;
+    execute_job(rank);
+    __atomic_add_fetch(&pool->checkout, 1, __ATOMIC_ACQ_REL);
+  }
+  return NULL;
+}
+
+/* Publish the job set up in pool, run the share of the caller and wait for
+   every worker to be done with it. */
+static void dispatch() {
+  pool->checkout = 0;
+  __atomic_add_fetch(&pool->generation, 1, __ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&pool->sleepers, __ATOMIC_SEQ_CST) > 0) {
+    pthread_mutex_lock(&pool->mutex);
+    pthread_cond_broadcast(&pool->cond);
+    pthread_mutex_unlock(&pool->mutex);
+  }
+  if (pool->quit) return;
+  execute_job(0);
+  int spin = 0;
+  while (__atomic_load_n(&pool->checkout, __ATOMIC_ACQUIRE) != pool->size - 1) {
+    if (++spin < SPIN_COUNT) ASMPAUSE; else sched_yield();
+  }
+}
+
+/* ------------------------------------------------------------------ */
+/* Pool                                                                */
+
+static int env_int(const char * name, int def) {
+  const char * s = getenv(name);
+  return (s && atoi(s) > 0) ? atoi(s) : def;
+}
+
+static int env_bind(int def) {
+  const char * s = getenv("BIGDFT_THREAD_BIND");
+  if (!s) return def;
+  if (strcmp(s, "none") == 0) return 0;
+  if (strcmp(s, "core") == 0) return 2;
+  return 1;
+}
+
+static const char * bind_name(int bind) {
+  return bind == 0 ? "none" : (bind == 2 ? "core" : "node");
+}
+
+void thread_pool_init(int nthreads) {
+  int verbose = engine_params ? engine_params->verbose : 0;
+  int bind = engine_params ? engine_params->bind : env_bind(1);
+  if (pool) {
+    if (nthreads <= 0 || nthreads == pool->size) return;
+    thread_pool_finalize();
+  }
+  pool = new thread_pool;
+  sched_getaffinity(0, sizeof(cpu_set_t), &pool->initial_mask);
+  get_topology(&pool->initial_mask, pool->nodes);
+  std::vector<int> cpus, cpu_node;
+  for (size_t k = 0; k < pool->nodes.size(); k++)
+    for (size_t j = 0; j < pool->nodes[k].cpus.size(); j++) {
+      cpus.push_back(pool->nodes[k].cpus[j]);
+      cpu_node.push_back((int)k);
+    }
+  if (nthreads <= 0) nthreads = env_int("BIGDFT_THREADS", env_int("OMP_NUM_THREADS", 1));
+  pool->size = nthreads;
+  pool->bind = bind;
+  pool->generation = 0;
+  pool->checkout = 0;
+  pool->sleepers = 0;
+  pool->quit = 0;
+  pthread_mutex_init(&pool->mutex, NULL);
+  pthread_cond_init(&pool->cond, NULL);
+  pthread_mutex_init(&pool->submit, NULL);
+
+  /* workers spread evenly over the CPUs, by blocks of domains */
+  for (int w = 0; w < nthreads; w++) {
+    void * mem;
+    if (posix_memalign(&mem, CACHE_LINE, sizeof(worker)) != 0) {
+      std::cerr << "thread_pool_init: out of memory" << std::endl;
+      exit(1);
+    }
+    worker * wk = new (mem) worker;
+    size_t c = ((size_t)w * cpus.size()) / nthreads;
+    wk->cpu = cpus[c];
+    wk->node = cpu_node[c];
+    wk->range = pack_range(0, 0);
+    pool->workers.push_back(wk);
+  }
+  for (int w = 0; w < nthreads; w++) {
+    worker * wk = pool->workers[w];
+    for (int pass = 0; pass < 2; pass++)
+      for (int v = 1; v < nthreads; v++) {
+        int o = (w + v) % nthreads;
+        if ((pool->workers[o]->node == wk->node) == (pass == 0)) wk->victims.push_back(o);
+      }
+  }
+  if (verbose)
+    std::cout << "thread pool: " << nthreads << " workers on " << cpus.size() << " cpus, "
+              << pool->nodes.size() << " numa nodes, binding " << bind_name(bind) << std::endl;
+
+  /* worker 0 is the caller: its affinity is left to MPI and OpenMP */
+  pool_rank = -1;
+  for (int w = 1; w < nthreads; w++) {
+    if (verbose > 1)
+      std::cout << "worker " << w << ": node " << pool->workers[w]->node
+                << " cpu " << pool->workers[w]->cpu << std::endl;
+    pthread_create(&pool->workers[w]->thread, NULL, worker_main, (void *)(intptr_t)w);
+  }
+
+  if (!engine_params) {
+    engine_params = new struct thread_engine_param;
+    engine_params->real_time = 0;
+    engine_params->verbose = 0;
+  }
+  engine_params->cpu_number = (int)cpus.size();
+  engine_params->node_number = (int)pool->nodes.size();
+  engine_params->thread_number = nthreads - 1;
+  engine_params->bind = bind;
+}
+
+void thread_pool_finalize(void) {
+  if (!pool) return;
+  pool->quit = 1;
+  dispatch();
+  for (int w = 1; w < pool->size; w++) pthread_join(pool->workers[w]->thread, NULL);
+  for (int w = 0; w < pool->size; w++) {
+    pool->workers[w]->~worker();
+    free(pool->workers[w]);
+  }
+  pthread_mutex_destroy(&pool->mutex);
+  pthread_cond_destroy(&pool->cond);
+  pthread_mutex_destroy(&pool->submit);
+  delete pool;
+  pool = NULL;
+}
+
+int thread_pool_size(void) {
+  if (!pool) thread_pool_init(0);
+  return pool->size;
+}
+
+int thread_pool_rank(void) {
+  return pool_rank;
+}
+
+void thread_pool_parallel_for(int begin, int end, int grain, thread_pool_body body, void * arg) {
+  if (end <= begin) return;
+  if (grain < 1) grain = 1;
+  if (!pool) thread_pool_init(0);
+  /* nested calls and single worker run in place */
+  if (pool_rank >= 0 || pool->size == 1 || end - begin <= grain) {
+    body(begin, end, arg);
+    return;
+  }
+  pthread_mutex_lock(&pool->submit);
+  pool->kind = JOB_FOR;
+  pool->body = body;
+  pool->arg = arg;
+  pool->grain = grain;
+  /* contiguous blocks, in the order of the workers and thus of the domains */
+  long n = end - begin;
+  for (int w = 0; w < pool->size; w++) {
+    int lo = begin + (int)((n * w) / pool->size);
+    int hi = begin + (int)((n * (w+1)) / pool->size);
+    __atomic_store_n(&pool->workers[w]->range, pack_range(lo, hi), __ATOMIC_RELAXED);
+  }
+  dispatch();
+  pthread_mutex_unlock(&pool->submit);
+}
+
+void thread_pool_run(void (*fn)(int rank, void * arg), void * arg) {
+  if (!pool) thread_pool_init(0);
+  if (pool_rank >= 0) {
+    fn(pool_rank, arg);
+    return;
+  }
+  pthread_mutex_lock(&pool->submit);
+  pool->kind = JOB_RUN;
+  pool->fn = fn;
+  pool->arg = arg;
+  dispatch();
+  pthread_mutex_unlock(&pool->submit);
+}
+
+/* ------------------------------------------------------------------ */
+/* Fortran interface                                                   */
+
+struct fortran_body {
+  void (*body)(int *lo, int *hi, void *arg);
+  void * arg;
 };
 
-struct thread_engine_param *engine_params;
-struct thread_param * thread_params;
-struct thread_data * volatile * thread_datas;
-pthread_t * threads;
-sem_t semaphore;
-pthread_spinlock_t global_spin;
-volatile unsigned int thread_counter;
+static void call_fortran_body(int lo, int hi, void * arg) {
+  struct fortran_body * f = (struct fortran_body *)arg;
+  f->body(&lo, &hi, f->arg);
+}
 
+void thread_pool_init_(int *nthreads) {
+  thread_pool_init(*nthreads);
+}
 
-void get_topology( ) {
-	if( engine_params->verbose ) std::cout << "reading topology" << std::endl;
-        libconfig::Config topology;
-        topology.readFile(engine_params->topology_file);
-        engine_params->cpu_number = topology.lookup("topology.cpu_number");
+void thread_pool_finalize_(void) {
+  thread_pool_finalize();
 }
 
-void get_placement( ) {
-	try {
-	        libconfig::Config thread_placement;
-		if( engine_params->verbose ) std::cout << "reading placement" << std::endl;
-	        thread_placement.readFile(engine_params->placement_file);
-        	libconfig::Setting& thread_cpus = thread_placement.lookup("placement.thread_cpus");
-	        libconfig::Setting& main_cpus = thread_placement.lookup("placement.main_cpus");
-	        engine_params->thread_number = thread_cpus.getLength();
-	        engine_params->main_cpus = new int[main_cpus.getLength()];
-	        engine_params->main_cpus_number = main_cpus.getLength();
-	        for( int i=0; i<main_cpus.getLength(); i++ ) {
-	                engine_params->main_cpus[i] = main_cpus[i];
-	        }
-	        engine_params->thread_cpus = new int*[thread_cpus.getLength()];
-	        engine_params->thread_cpus_number = new int[thread_cpus.getLength()];
-	        for( int i=0; i<thread_cpus.getLength(); i++ ) {
-	                engine_params->thread_cpus[i] = new int[thread_cpus[i].getLength()];
-	                engine_params->thread_cpus_number[i] = thread_cpus[i].getLength();
-	                for( int j=0; j<thread_cpus[i].getLength(); j++) {
-	                        engine_params->thread_cpus[i][j] = thread_cpus[i][j];
-	                }
-	        }
-        	engine_params->memory_allocation = thread_placement.lookup("placement.memory_allocation");
-                engine_params->use_spin = (bool)thread_placement.lookup("use_spin");
-	} catch (libconfig::ParseException e) {
-		std::cerr << "libconfig::ParseException" << std::endl;
-		std::cerr <<e.getLine () <<" : "<<e.getError() << std::endl;
-		exit(-1);
-	}
+void thread_pool_size_(int *size) {
+  *size = thread_pool_size();
+}
+
+void thread_pool_parallel_for_(int *begin, int *end, int *grain,
+                               void (*body)(int *lo, int *hi, void *arg), void *arg) {
+  struct fortran_body f;
+  f.body = body;
+  f.arg = arg;
+  thread_pool_parallel_for(*begin, *end, *grain, call_fortran_body, &f);
 }
 
+/* ------------------------------------------------------------------ */
+/* Benchmark harness                                                   */
+
 void get_engine_opt(int argc, char *argv[]) {
 	int ch;
-	char *endptr;
         engine_params = new struct thread_engine_param;
-        //errno = 0;
 
-        engine_params->thread_number = 0;
+        engine_params->thread_number = -1;
 	engine_params->cpu_number = 1;
+	engine_params->node_number = 1;
+	engine_params->bind = env_bind(1);
 	engine_params->real_time = false;
-	engine_params->topology_file = NULL;
-	engine_params->placement_file = NULL;
 	engine_params->verbose = 0;
 
-	while ((ch = getopt(argc, argv, "t:p:rsv:")) != -1) {
+	optind = 1;
+	while ((ch = getopt(argc, argv, "n:b:rv:")) != -1) {
 		switch (ch) {
-                        case 't':
-                                engine_params->topology_file = optarg;
-                                break;
-                        case 'p':
-                                engine_params->placement_file = optarg;
-                                break;
+			case 'n':
+				engine_params->thread_number = strtol(optarg, NULL, 10) - 1;
+				break;
+			case 'b':
+				engine_params->bind = strcmp(optarg,"none") == 0 ? 0 : (strcmp(optarg,"core") == 0 ? 2 : 1);
+				break;
 			case 'r':
 				//real_time
 				engine_params->real_time = true;
 				break;
 			case 'v':
-				engine_params->verbose = strtol(optarg, &endptr, 10);
-//				if( errno != 0)  {
-//					perror("Invalid verbose level");
-//				};
+				engine_params->verbose = strtol(optarg, NULL, 10);
 				break;
 			default:
 				printf ("Unknown parameter : %c\n",ch);
 				break;
 		}
 	}
-	if( engine_params->topology_file )
-		get_topology();
-	else {
-		std::cerr << "no topology file given" << std::endl;
-		exit(-1);
-	}
-	if( engine_params->placement_file )
-		get_placement();
-	else {
-		std::cerr << "no placement file given" << std::endl;
-		exit(-1);
-	}
-	argc -= optind;
-	argv += optind;	
-}
-
-void * thread_master_function_spin( void *arg ) {
-  struct thread_param *param;
-  param = (struct thread_param *)arg;
-  struct thread_data data;
-  data.thread_code = NULL;
-  data.param = NULL;
-  pthread_spin_init(&(data.spin),PTHREAD_PROCESS_PRIVATE);
-  thread_datas[param->thread_number] = &data;
-  sem_post(&semaphore);
-  while(1) {
-    while (1) {
-      while (data.thread_code == NULL){ASMPAUSE;}
-      pthread_spin_lock(&(data.spin));//
-      if (data.thread_code != NULL) break;
-      pthread_spin_unlock(&(data.spin));
-    }
-    pthread_spin_unlock(&(data.spin));
-    data.thread_code(data.param);
-    data.param = NULL;
-    data.thread_code = NULL;
-    pthread_spin_lock(&global_spin);
-    thread_counter--;
-    pthread_spin_unlock(&global_spin);
-  }
-  return NULL;
-}
-
-void * thread_master_function( void *arg ) {
-  struct thread_param *param;
-  param = (struct thread_param *)arg;
-  struct thread_data data;
-  data.thread_code = NULL;
-  data.param = NULL;
-  pthread_mutex_init(&(data.mutex),NULL);
-  pthread_cond_init(&(data.cond),NULL);
-  thread_datas[param->thread_number] = &data;
-  while ( 1 ) {
-    sem_post(&semaphore);
-    pthread_mutex_lock(&(data.mutex));
-    while(data.thread_code == NULL)
-      pthread_cond_wait(&(data.cond),&(data.mutex));
-    pthread_mutex_unlock(&(data.mutex));
-
-    data.thread_code(data.param);
-    data.thread_code = NULL;
-    data.param = NULL;
-
-  }
-  return NULL;
-}
-
-void set_cpu_sets(int *cpus, int cpus_number ) {
-  cpu_set_t cpuset;
-  cpu_set_t fullcpuset;
-  CPU_ZERO(&fullcpuset);
-  int cpu_number = engine_params->cpu_number;
-  for( int i=0; i<cpu_number; i++) {
-    CPU_SET(i,&fullcpuset);
-  }
-  if(cpu_number > 0) {
-    if(engine_params->verbose) std::cout << "cpus :";
-    CPU_ZERO(&cpuset);
-    for( int j=0; j<cpus_number; j++ ){
-      if(engine_params->verbose) std::cout << " "<< cpus[j];
-      if(cpus[j]>=cpu_number || cpus[j]<0) { std::cerr << "Invalid CPU number : " << cpus[j] << std::endl; exit(1);}
-      CPU_SET(cpus[j], &cpuset);
-    }
-    if(engine_params->verbose) std::cout << std::endl;
-    if(pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset)<0)
-      perror("pthread_setaffinity_np");
-    sched_yield();
-  } else {
-    if(engine_params->verbose) std::cout << "all cpus" << std::endl;
-    if(pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &fullcpuset)<0)
-      perror("pthread_setaffinity_np");
-    sched_yield();
-  }
 }
 
 void init_thread_engine ( ) {
-  if(engine_params->real_time) {       
+  if (!engine_params) get_engine_opt(0, NULL);
+  if(engine_params->real_time) {
     struct sched_param sched_p;
     sched_p.__sched_priority = sched_get_priority_max (SCHED_RR);
     if (sched_setscheduler (0, SCHED_RR, &sched_p) != 0)
       perror("sched_setscheduler");
   }
-  thread_datas = new thread_data*[engine_params->thread_number];
-  thread_params = new thread_param[engine_params->thread_number];
-  threads = new pthread_t[engine_params->thread_number];
-  if(engine_params->use_spin) {
-    thread_counter=0;
-    pthread_spin_init(&(global_spin),PTHREAD_PROCESS_PRIVATE);
-  }
-  sem_init(&semaphore,0,0);
-  for( int i=0; i<engine_params->thread_number; i++ ) {
-    if( engine_params->verbose ) std::cout << "binding thread : " << i+1 << std::endl; 
-    set_cpu_sets(engine_params->thread_cpus[i], engine_params->thread_cpus_number[i]);
-    thread_params[i].thread_number = i;
-    if(engine_params->use_spin) {
-      pthread_create( &(threads[i]), NULL, thread_master_function_spin, (void *) &(thread_params[i]) );
-    } else {
-      pthread_create( &(threads[i]), NULL, thread_master_function, (void *) &(thread_params[i]) );
-    }
-    sem_wait(&semaphore);
-  }
-  if( engine_params->verbose ) std::cout << "binding  main thread (0)" << std::endl; 
-  set_cpu_sets(engine_params->main_cpus, engine_params->main_cpus_number);
+  thread_pool_init(engine_params->thread_number + 1);
 }
 
-void _run_bench_spin( void * (*main_program)(void * param), void * (*thread_program)(void * param), void ** params ) {
-  for( int i=0; i<engine_params->thread_number; i++ ) {
-    struct thread_data *d = thread_datas[i];
-    pthread_spin_lock(&global_spin);
-    thread_counter++;
-    pthread_spin_unlock(&global_spin);
-    pthread_spin_lock(&(d->spin));
-    d->param = params[i+1];
-    d->thread_code = thread_program;
-    pthread_spin_unlock(&(d->spin));
-  }
-  main_program(params[0]);
-  while (1) {
-    while (thread_counter != 0){ASMPAUSE;}
-    pthread_spin_lock(&global_spin);
-    if (thread_counter == 0) break;
-    pthread_spin_unlock(&global_spin);
-  }
-  pthread_spin_unlock(&global_spin);
-}
+struct bench_job {
+  void * (*main_program)(void * param);
+  void * (*thread_program)(void * param);
+  void ** params;
+};
 
-void _run_bench( void * (*main_program)(void * param), void * (*thread_program)(void * param), void ** params ) {
-  for( int i=0; i<engine_params->thread_number; i++ ) {
-    struct thread_data *d = thread_datas[i];
-    pthread_mutex_lock(&(d->mutex));
-    d->param = params[i+1];
-    d->thread_code = thread_program;
-    pthread_cond_signal(&(d->cond));
-    pthread_mutex_unlock(&(d->mutex));
-  }
-  main_program(params[0]);
-  for( int i=0; i<engine_params->thread_number; i++ ) {
-    sem_wait(&semaphore);
-  }
+static void run_bench_worker(int rank, void * arg) {
+  struct bench_job * job = (struct bench_job *)arg;
+  if (rank == 0)
+    job->main_program(job->params[0]);
+  else
+    job->thread_program(job->params[rank]);
 }
 
+/* main_program(params[0]) on the calling thread and
+   thread_program(params[i]) on the helper thread i. */
 void run_bench( void * (*main_program)(void * param), void * (*thread_program)(void * param), void ** params ) {
-  if(engine_params->use_spin) {
-    _run_bench_spin(main_program, thread_program, params);
-  } else {
-    _run_bench(main_program, thread_program, params);
-  }
+  struct bench_job job;
+  job.main_program = main_program;
+  job.thread_program = thread_program;
+  job.params = params;
+  thread_pool_run(run_bench_worker, &job);
 }
@@ -16,33 +16,60 @@
 */
 #ifndef THREAD_ENGINE_H
 #define THREAD_ENGINE_H 1
-//#include "tool.h"
 
+/* Persistent thread pool.
+
+   The NUMA topology is read from /sys/devices/system/node (one domain with
+   the CPUs of the process affinity mask when it is not available). Worker w
+   is bound to the CPUs of the domain it belongs to, the workers being
+   distributed by contiguous blocks over the domains; worker 0 is the calling
+   thread, which is not bound and keeps its affinity. Work is handed out as
+   ranges of iterations, each worker owning a lock-free deque: it takes
+   chunks from the front of its own range and idle workers steal half of the
+   back of another one, trying the workers of their own domain first.
+
+   Environment:
+     BIGDFT_THREADS      number of workers (default: OMP_NUM_THREADS, else 1)
+     BIGDFT_THREAD_BIND  none, node (default) or core
+*/
 struct thread_engine_param {
-  char * topology_file;
-  char * placement_file;
-  int cpu_number;
-  int thread_number;
-  int **thread_cpus;
-  int *thread_cpus_number;
-  int *main_cpus;
-  int main_cpus_number;
-  int memory_allocation;
+  int cpu_number;     /* CPUs available to the process */
+  int node_number;    /* NUMA domains */
+  int thread_number;  /* helper threads, the main thread is not counted */
+  int bind;           /* 0: none, 1: NUMA domain, 2: core */
   int real_time;
-  int stack;
   int verbose;
-  int use_spin;
 };
 extern struct thread_engine_param *engine_params;
+
 #ifdef __cplusplus
  extern "C" {
 #endif
 
+typedef void (*thread_pool_body)(int lo, int hi, void * arg);
+
+/* Start the pool with nthreads workers (<= 0: from the environment). */
+void thread_pool_init(int nthreads);
+void thread_pool_finalize(void);
+int thread_pool_size(void);
+/* Rank of the calling worker, -1 outside of the pool. */
+int thread_pool_rank(void);
+/* body(lo,hi,arg) on chunks of at most grain iterations of [begin,end). */
+void thread_pool_parallel_for(int begin, int end, int grain, thread_pool_body body, void * arg);
+/* fn(rank,arg) once on every worker. */
+void thread_pool_run(void (*fn)(int rank, void * arg), void * arg);
+
+/* Fortran interface, the body receives its arguments by reference. */
+void thread_pool_init_(int *nthreads);
+void thread_pool_finalize_(void);
+void thread_pool_size_(int *size);
+void thread_pool_parallel_for_(int *begin, int *end, int *grain,
+                               void (*body)(int *lo, int *hi, void *arg), void *arg);
+
+/* Benchmark harness: options -n <threads> -b <none|node|core> -r -v <level>. */
 void get_engine_opt(int argc, char *argv[]);
 void init_thread_engine ( );
-//void init_thread_engine_spin ( struct thread_engine_param * param );
 void run_bench( void * (*main_program)(void * param), void * (*thread_program)(void * param), void ** params ) ;
-//void run_bench_spin( void * (*main_program)(void * param), void * (*thread_program)(void * param), void ** params ) ;
 
 #ifdef __cplusplus
  }
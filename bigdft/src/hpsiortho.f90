@@ -478,7 +478,8 @@ subroutine psitohpsi(iproc,nproc,atoms,scf,denspot,itrp,itwfn,scf_mode,alphamix,
   !choose to just add the potential if needed
   call LocalHamiltonianApplication(iproc,nproc,atoms,wfn%orbs%npsidim_orbs,wfn%orbs,&
        wfn%Lzd,wfn%confdatarr,denspot%dpbox%ngatherarr,denspot%pot_work,wfn%psi,wfn%hpsi,&
-       energs,wfn%SIC,GPU,correcth,denspot%xc,pkernel=denspot%pkernelseq)
+       energs,wfn%SIC,GPU,correcth,denspot%xc,pkernel=denspot%pkernelseq,&
+       exctx_screening=wfn%exctx_screening,exctx_persistent=wfn%exctx_persistent)
 
   !in the case of OCL GPU the nonlocal hamiltonian can run after the local hamiltonian to overlap GPU-CPU computation
   if (GPU%OCLconv) then
@@ -619,7 +620,8 @@ END SUBROUTINE FullHamiltonianApplication
 !> Application of the Local Hamiltonian
 subroutine LocalHamiltonianApplication(iproc,nproc,at,npsidim_orbs,orbs,&
      Lzd,confdatarr,ngatherarr,pot,psi,hpsi,&
-     energs,SIC,GPU,PotOrKin,xc,pkernel,orbsocc,psirocc,dpbox,potential,comgp,hpsi_noconf,econf)
+     energs,SIC,GPU,PotOrKin,xc,pkernel,orbsocc,psirocc,dpbox,potential,comgp,hpsi_noconf,econf,&
+     exctx_screening,exctx_persistent)
   use module_base
   use module_dpbox, only: denspot_distribution
   use module_types
@@ -630,6 +632,7 @@ subroutine LocalHamiltonianApplication(iproc,nproc,at,npsidim_orbs,orbs,&
   use communications_base, only: p2pComms
   use locreg_operations
   use overlap_point_to_point
+  use Poisson_Solver, only: reduced_kernels,reduced_kernels_null,reduced_kernels_new,reduced_kernels_free
   implicit none
   !logical, intent(in) :: onlypot !< if true, only the potential operator is applied
   integer, intent(in) :: PotOrKin
@@ -656,9 +659,11 @@ subroutine LocalHamiltonianApplication(iproc,nproc,at,npsidim_orbs,orbs,&
   type(p2pComms),intent(inout), optional:: comgp
   real(wp), target, dimension(max(1,npsidim_orbs)), intent(inout),optional :: hpsi_noconf
   real(gp),intent(out),optional :: econf
+  real(gp), intent(in), optional :: exctx_screening !< norm fraction neglected to skip the exact exchange couples
+  logical, intent(in), optional :: exctx_persistent !< persistent requests for the OP2P ring of the orbitals
   !local variables
   character(len=*), parameter :: subname='LocalHamiltonianApplication'
-  logical :: exctX,op2p_flag, symmetric
+  logical :: exctX,op2p_flag, symmetric, screening
   integer :: n3p,ispot,ipotmethod,ngroup,prc,isorb,jproc,ndim,norbp
   integer :: igpu,gpudirect,i_stat,nsize,nspinor
   real(gp) :: evsic_tmp, ekin, epot,sfac
@@ -670,7 +675,10 @@ subroutine LocalHamiltonianApplication(iproc,nproc,at,npsidim_orbs,orbs,&
   type(workarr_sumrho) :: w
   type(OP2P_data) :: OP2P
   type(OP2P_iterator) :: iter
+  type(reduced_kernels) :: rk
+  integer, dimension(2) :: npairs
   integer, dimension(:,:), allocatable :: nobj_par
+  integer, dimension(:,:,:), allocatable :: supports
   real(wp), dimension(:,:), allocatable :: vsicpsir
   real(wp), dimension(:,:), allocatable :: psir
   !real(wp), dimension(:,:), allocatable :: vpsi_tmp
@@ -799,7 +807,8 @@ subroutine LocalHamiltonianApplication(iproc,nproc,at,npsidim_orbs,orbs,&
            !check that we did not deactivate gpudirect manually
            if(igpu==1 .and. pkernel%use_gpu_direct) gpudirect=1
 
-           call initialize_OP2P_data(OP2P,bigdft_mpi%mpi_comm,iproc,nproc,ngroup,ndim,nobj_par,gpudirect,symmetric)
+           call initialize_OP2P_data(OP2P,bigdft_mpi%mpi_comm,iproc,nproc,ngroup,ndim,nobj_par,gpudirect,symmetric,&
+                persistent=exctx_persistent)
 
            !initialization deactivates gpudirect if not enough memory (these parts should go via accessors in the PS_set_options somehow)
            if(gpudirect==1 .and. OP2P%gpudirect==1) pkernel%stay_on_gpu=1
@@ -807,6 +816,20 @@ subroutine LocalHamiltonianApplication(iproc,nproc,at,npsidim_orbs,orbs,&
            !allocate work array for the internal exctx calculation
            rp_ij = f_malloc(ndim,id='rp_ij')
            energs%eexctX=0.0_gp
+           !supports of the orbitals, to skip the couples which do not overlap
+           screening=.false.
+           if (present(exctx_screening)) screening=exctx_screening > 0.0_gp
+           npairs=0
+           rk=reduced_kernels_null()
+           if (screening) then
+              supports = f_malloc0([2,3,orbs%norb],id='supports')
+              call exctx_supports(pkernel%mesh,exctx_screening,orbs%norbp,orbs%isorb,psir,supports)
+              if (nproc>1) call fmpi_allreduce(supports,FMPI_SUM,comm=bigdft_mpi%mpi_comm)
+              !the couples are solved in the reduced boxes of their supports
+              rk=reduced_kernels_new(pkernel)
+           else
+              supports = f_malloc0([2,3,1],id='supports')
+           end if
            !initialize the OP2P descriptor for the communication
            call set_OP2P_iterator(iproc,OP2P,iter,orbs%norbp,psir,pot(ispot:ispot+OP2P%ndim*orbs%norbp-1))!vpsi_tmp)
            !main loop
@@ -815,9 +838,9 @@ subroutine LocalHamiltonianApplication(iproc,nproc,at,npsidim_orbs,orbs,&
               call OP2P_communication_step(iproc,OP2P,iter)
               if(igpu==1) call synchronize()
               if (iter%event == OP2P_EXIT) exit OP2P_exctx_loop
-              call internal_calculation_exctx(iter%istep,sfac,pkernel,orbs%norb,orbs%occup,orbs%spinsgn,&
+              call screened_calculation_exctx(iter%istep,sfac,pkernel,orbs%norb,orbs%occup,orbs%spinsgn,&
                    iter%remote_result,iter%nloc_i,iter%nloc_j,iter%isloc_i,iter%isloc_j,&
-                   iter%phi_i,iter%phi_j,energs%eexctX,rp_ij)
+                   iter%phi_i,iter%phi_j,energs%eexctX,rp_ij,screening,supports,npairs,rk,OP2P)
               if (iproc == 0) then
                  call OP2P_info(iter,OP2P,prc,tel,trm)
                  call yaml_comment('Exact exchange calculation: '+prc**'(i3)'+&
@@ -839,6 +862,17 @@ subroutine LocalHamiltonianApplication(iproc,nproc,at,npsidim_orbs,orbs,&
            !the exact exchange energy is half the Hartree energy (which already has another half)
            energs%eexctX=-xc_exctXfac(xc)*energs%eexctX
            if (iproc == 0) call yaml_map('Exact Exchange Energy',energs%eexctX,fmt='(1pe18.11)')
+           if (screening) then
+              if (nproc>1) call fmpi_allreduce(npairs,FMPI_SUM,comm=bigdft_mpi%mpi_comm)
+              if (iproc == 0) then
+                 call yaml_mapping_open('Exact Exchange pairs',flow=.true.)
+                 call yaml_map('Calculated',npairs(1))
+                 call yaml_map('Skipped',npairs(2))
+                 call yaml_mapping_close()
+              end if
+           end if
+           call reduced_kernels_free(rk)
+           call f_free(supports)
            !call f_memcpy(n=ndim*orbs%norbp,src=vpsi_tmp(1,1),dest=pot(ispot))
            call f_free(nobj_par)
            call f_free(rp_ij)
@@ -680,7 +680,9 @@ use wfn_extrap
   character(len=*), parameter :: subname='input_wf_memory_history'
   logical, parameter :: debug_flag=.false.
   integer :: istep,jstep,nvctr
+  integer(f_long) :: nbytes,nbytes_full
   real(wp), dimension(:,:), allocatable :: psi_istep, psi_nstep
+  real(wp), dimension(:), pointer :: psi_old
 !  integer, save :: icall=0
 
   real(wp), dimension(0:5) :: cc
@@ -739,17 +741,39 @@ use wfn_extrap
   end if
   !  end if
 
+  !memory used by the history, compared to full copies
+  nbytes=0
+  nbytes_full=0
+  do istep=0,wfn_history
+     nbytes=nbytes+old_wavefunction_memory(oldpsis(istep))
+     nbytes_full=nbytes_full+8_f_long*(oldpsis(istep)%Lzd%Glr%wfd%nvctr_c+7*oldpsis(istep)%Lzd%Glr%wfd%nvctr_f)*&
+          oldpsis(istep)%norbp
+  end do
+  if (nproc > 1) then
+     call fmpi_allreduce(nbytes,1,FMPI_SUM,comm=bigdft_mpi%mpi_comm)
+     call fmpi_allreduce(nbytes_full,1,FMPI_SUM,comm=bigdft_mpi%mpi_comm)
+  end if
+  if (iproc==0) then
+     call yaml_mapping_open('Wavefunction history',flow=.true.)
+     call yaml_map('Depth',wfn_history)
+     call yaml_map('Memory (MB)',real(nbytes,gp)/1048576.0_gp,fmt='(f12.2)')
+     call yaml_map('Saved (MB)',real(nbytes_full-nbytes,gp)/1048576.0_gp,fmt='(f12.2)')
+     call yaml_mapping_close()
+  end if
+
   psi_nstep = f_malloc((/ Lzd%Glr%wfd%nvctr_c+7*Lzd%Glr%wfd%nvctr_f, orbs%nspinor*orbs%norbp /),id='psi_nstep')
 
   !first reformat the previous SCF step
   istep=wfn_history+1
   if(iproc.eq.0 .and. debug_flag)print *, "NNdbg, Reformatting the prev. SCF wfn(wfn_history+1)"
+  call old_wavefunction_get_psi(oldpsis(istep),psi_old)
   call reformatmywaves(iproc,orbs,atoms,&
        oldpsis(istep)%Lzd%hgrids(1),oldpsis(istep)%Lzd%hgrids(2),oldpsis(istep)%Lzd%hgrids(3),&
        oldpsis(istep)%Lzd%Glr%d%n1,oldpsis(istep)%Lzd%Glr%d%n2,oldpsis(istep)%Lzd%Glr%d%n3,&
        oldpsis(istep)%rxyz,oldpsis(istep)%Lzd%Glr%wfd,&
-       oldpsis(istep)%psi,Lzd%hgrids(1),Lzd%hgrids(2),Lzd%hgrids(3),&
+       psi_old,Lzd%hgrids(1),Lzd%hgrids(2),Lzd%hgrids(3),&
        Lzd%Glr%d%n1,Lzd%Glr%d%n2,Lzd%Glr%d%n3,rxyz,Lzd%Glr%wfd,psi_nstep(1,1))
+  call old_wavefunction_release_psi(oldpsis(istep),psi_old)
 
   !       if(iproc==0)print *, "NNdbg: ....checking"," reformatted prev. SCF wfn"
   !       call myoverlap(iproc,nproc,oldpsis(istep)%Lzd,orbs,comms,psi_nstep(1,1), &
@@ -805,12 +829,14 @@ use wfn_extrap
   !  call myoverlap(iproc,nproc,lzd,orbs,comms,psi_tmp,psi_tmp)
   !
   do jstep=0,wfn_history
+     call old_wavefunction_get_psi(oldpsis(jstep),psi_old)
      call reformatmywaves(iproc,orbs,atoms,&
           oldpsis(jstep)%Lzd%hgrids(1),oldpsis(jstep)%Lzd%hgrids(2),oldpsis(jstep)%Lzd%hgrids(3),&
           oldpsis(jstep)%Lzd%Glr%d%n1,oldpsis(jstep)%Lzd%Glr%d%n2,oldpsis(jstep)%Lzd%Glr%d%n3,&
           oldpsis(jstep)%rxyz,oldpsis(jstep)%Lzd%Glr%wfd,&
-          oldpsis(jstep)%psi,Lzd%hgrids(1),Lzd%hgrids(2),Lzd%hgrids(3),&
+          psi_old,Lzd%hgrids(1),Lzd%hgrids(2),Lzd%hgrids(3),&
           Lzd%Glr%d%n1,Lzd%Glr%d%n2,Lzd%Glr%d%n3,rxyz,Lzd%Glr%wfd,psi_istep(1,1))
+     call old_wavefunction_release_psi(oldpsis(jstep),psi_old)
      if(iproc.eq.0 .and. debug_flag)print *, "NNdbg reformat is done for oldpsis(",jstep,")"
      !dbg
      !     if(iproc.eq.0)print *, "NNdbg checking the reformatted oldpsis(",jstep,")"
@@ -877,6 +903,7 @@ subroutine input_wf_memory_history(iproc,orbs,atoms,wfn_history,istep_history,ol
   character(len=*), parameter :: subname='input_wf_memory_history'
   integer :: istep,jstep,nvctr
   real(wp), dimension(:,:), allocatable :: psi_tmp
+  real(wp), dimension(:), pointer :: psi_old
   real(gp), dimension(3:9) :: kappa,alpha
   real(gp), dimension(0:9,3:9) :: c
 
@@ -940,23 +967,27 @@ if (iproc==0)call yaml_map('Previous SCF wfn copied',.true.)
 
   !first reformat the previous SCF step
   istep=wfn_history+1
+  call old_wavefunction_get_psi(oldpsis(istep),psi_old)
   call reformatmywaves(iproc,orbs,atoms,&
        oldpsis(istep)%Lzd%hgrids(1),oldpsis(istep)%Lzd%hgrids(2),oldpsis(istep)%Lzd%hgrids(3),&
        oldpsis(istep)%Lzd%Glr%d%n1,oldpsis(istep)%Lzd%Glr%d%n2,oldpsis(istep)%Lzd%Glr%d%n3,&
        oldpsis(istep)%rxyz,oldpsis(istep)%Lzd%Glr%wfd,&
-       oldpsis(istep)%psi,Lzd%hgrids(1),Lzd%hgrids(2),Lzd%hgrids(3),&
+       psi_old,Lzd%hgrids(1),Lzd%hgrids(2),Lzd%hgrids(3),&
        Lzd%Glr%d%n1,Lzd%Glr%d%n2,Lzd%Glr%d%n3,rxyz,Lzd%Glr%wfd,psi_tmp)
+  call old_wavefunction_release_psi(oldpsis(istep),psi_old)
   if (nvctr>0) call axpy(nvctr,kappa(wfn_history),psi_tmp(1,1),1,psi(1,1),1)
   call yaml_map('Reformat Previous SCF wfn',.true.)
   !then the reformatting step based on history
   do jstep=0,wfn_history
      istep=modulo(modulo(istep_history,wfn_history+1)-jstep,wfn_history+1)
+     call old_wavefunction_get_psi(oldpsis(istep),psi_old)
      call reformatmywaves(iproc,orbs,atoms,&
           oldpsis(istep)%Lzd%hgrids(1),oldpsis(istep)%Lzd%hgrids(2),oldpsis(istep)%Lzd%hgrids(3),&
           oldpsis(istep)%Lzd%Glr%d%n1,oldpsis(istep)%Lzd%Glr%d%n2,oldpsis(istep)%Lzd%Glr%d%n3,&
           oldpsis(istep)%rxyz,oldpsis(istep)%Lzd%Glr%wfd,&
-          oldpsis(istep)%psi,Lzd%hgrids(1),Lzd%hgrids(2),Lzd%hgrids(3),&
+          psi_old,Lzd%hgrids(1),Lzd%hgrids(2),Lzd%hgrids(3),&
           Lzd%Glr%d%n1,Lzd%Glr%d%n2,Lzd%Glr%d%n3,rxyz,Lzd%Glr%wfd,psi_tmp)
+     call old_wavefunction_release_psi(oldpsis(istep),psi_old)
      if (nvctr>0) call axpy(nvctr,c(jstep,wfn_history),psi_tmp(1,1),1,psi(1,1),1)
      if (iproc==0)call yaml_map('Reformat Input wfn of Iter.',jstep,advance='no')
      if (iproc==0)call yaml_comment('Position:'//trim(yaml_toa(istep))//', Step'//trim(yaml_toa(istep_history)))
@@ -2698,6 +2729,8 @@ subroutine input_wf(iproc,nproc,in,GPU,atoms,rxyz,&
   KSwfn%SIC=in%SIC
   !exact exchange parallelization parameter
   KSwfn%exctxpar=in%exctxpar
+  KSwfn%exctx_screening=in%exctx_screening
+  KSwfn%exctx_persistent=in%exctx_persistent
 
   !avoid allocation of the eigenvalues array in case of restart
 !!$  if ( inputpsi /= INPUT_PSI_MEMORY_WVL .and. &
@@ -475,6 +475,8 @@ subroutine density_descriptors(iproc,nproc,xc,nspin,crmult,frmult,atoms,dpbox,&
      rhodsc%icomm=1
   else if (rho_commun=='MIX' .and. (domain_geocode(atoms%astruct%dom).eq.'F') .and. (nproc > 1)) then
      rhodsc%icomm=2
+  else if (rho_commun=='OWN') then
+     rhodsc%icomm=3
   end if
 
 !!$  !recent way
@@ -488,6 +490,17 @@ subroutine density_descriptors(iproc,nproc,xc,nspin,crmult,frmult,atoms,dpbox,&
 !!$     rhodsc%icomm=1
 !!$  end if
 
+  !the planes of the other processes are needed for the symmetrisation of the density
+  !and the orbitals are not distributed on the processes of the slabs with taskgroups
+  if (rhodsc%icomm==3 .and. (atoms%astruct%sym%symObj >= 0 .or. &
+       size(dpbox%nscatterarr,1) < nproc .or. dpbox%mpi_env%ngroup > 1)) then
+     if (.not.xc_isgga(xc)) then
+        rhodsc%icomm=1
+     else
+        rhodsc%icomm=0
+     endif
+  end if
+
   !in the case of taskgroups the RSC scheme should be overridden
   if (rhodsc%icomm==1 .and. size(dpbox%nscatterarr,1) < nproc) then
      if (domain_geocode(atoms%astruct%dom).eq.'F') then
@@ -515,6 +528,8 @@ subroutine density_descriptors(iproc,nproc,xc,nspin,crmult,frmult,atoms,dpbox,&
   !calculate dimensions of the complete array to be allocated before the reduction procedure
   if (rhodsc%icomm==1) then
      rhodsc%nrhotot=sum(dpbox%nscatterarr(:,1))
+  else if (rhodsc%icomm==3) then
+     rhodsc%nrhotot=max(dpbox%n3d,1)
   else
      rhodsc%nrhotot=dpbox%mesh%ndims(3)
   end if
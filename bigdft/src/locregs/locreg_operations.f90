@@ -358,15 +358,15 @@ module locreg_operations
 
          !allocation of work arrays
          if (allocate_arrays) then
-            w%y_c = f_malloc_ptr((/ w%nyc, nspinor /),id='w%y_c',info='{alignment: 32}')
-            w%y_f = f_malloc_ptr((/ w%nyf, nspinor /),id='w%y_f')
-            w%x_c = f_malloc_ptr((/ w%nxc, nspinor /),id='w%x_c')
-            w%x_f = f_malloc_ptr((/ w%nxf, nspinor /),id='w%x_f')
-            w%w1 = f_malloc_ptr(w%nw1,id='w%w1')
-            w%w2 = f_malloc_ptr(w%nw2,id='w%w2')
-            w%x_f1 = f_malloc_ptr((/ w%nxf1, nspinor /),id='w%x_f1')
-            w%x_f2 = f_malloc_ptr((/ w%nxf2, nspinor /),id='w%x_f2')
-            w%x_f3 = f_malloc_ptr((/ w%nxf3, nspinor /),id='w%x_f3')
+            w%y_c = f_malloc_ptr((/ w%nyc, nspinor /),id='w%y_c',info='{alignment: 32}',pool=.true.)
+            w%y_f = f_malloc_ptr((/ w%nyf, nspinor /),id='w%y_f',pool=.true.)
+            w%x_c = f_malloc_ptr((/ w%nxc, nspinor /),id='w%x_c',pool=.true.)
+            w%x_f = f_malloc_ptr((/ w%nxf, nspinor /),id='w%x_f',pool=.true.)
+            w%w1 = f_malloc_ptr(w%nw1,id='w%w1',pool=.true.)
+            w%w2 = f_malloc_ptr(w%nw2,id='w%w2',pool=.true.)
+            w%x_f1 = f_malloc_ptr((/ w%nxf1, nspinor /),id='w%x_f1',pool=.true.)
+            w%x_f2 = f_malloc_ptr((/ w%nxf2, nspinor /),id='w%x_f2',pool=.true.)
+            w%x_f3 = f_malloc_ptr((/ w%nxf3, nspinor /),id='w%x_f3',pool=.true.)
          end if
 
          !initialisation of the work arrays
@@ -391,8 +391,8 @@ module locreg_operations
 
          !allocation of work arrays
          if (allocate_arrays) then
-            w%x_c = f_malloc_ptr((/ w%nxc, nspinor /),id='w%x_c')
-            w%y_c = f_malloc_ptr((/ w%nyc, nspinor /),id='w%y_c',info='{alignment: 32}')
+            w%x_c = f_malloc_ptr((/ w%nxc, nspinor /),id='w%x_c',pool=.true.)
+            w%y_c = f_malloc_ptr((/ w%nyc, nspinor /),id='w%y_c',info='{alignment: 32}',pool=.true.)
          end if
 
       case('P')
@@ -418,15 +418,15 @@ module locreg_operations
             w%nxf2=nf
             w%nxf3=nf
 
-            w%y_c = f_malloc_ptr((/ w%nyc, nspinor /),id='w%y_c',info='{alignment: 32}')
-            w%y_f = f_malloc_ptr((/ w%nyf, nspinor /),id='w%y_f')
-            w%x_c = f_malloc_ptr((/ w%nxc, nspinor /),id='w%x_c')
-            w%x_f = f_malloc_ptr((/ w%nxf, nspinor /),id='w%x_f')
-            w%w1 = f_malloc_ptr(w%nw1,id='w%w1')
-            w%w2 = f_malloc_ptr(w%nw2,id='w%w2')
-            w%x_f1 = f_malloc_ptr((/ w%nxf1, nspinor /),id='w%x_f1')
-            w%x_f2 = f_malloc_ptr((/ w%nxf2, nspinor /),id='w%x_f2')
-            w%x_f3 = f_malloc_ptr((/ w%nxf3, nspinor /),id='w%x_f3')
+            w%y_c = f_malloc_ptr((/ w%nyc, nspinor /),id='w%y_c',info='{alignment: 32}',pool=.true.)
+            w%y_f = f_malloc_ptr((/ w%nyf, nspinor /),id='w%y_f',pool=.true.)
+            w%x_c = f_malloc_ptr((/ w%nxc, nspinor /),id='w%x_c',pool=.true.)
+            w%x_f = f_malloc_ptr((/ w%nxf, nspinor /),id='w%x_f',pool=.true.)
+            w%w1 = f_malloc_ptr(w%nw1,id='w%w1',pool=.true.)
+            w%w2 = f_malloc_ptr(w%nw2,id='w%w2',pool=.true.)
+            w%x_f1 = f_malloc_ptr((/ w%nxf1, nspinor /),id='w%x_f1',pool=.true.)
+            w%x_f2 = f_malloc_ptr((/ w%nxf2, nspinor /),id='w%x_f2',pool=.true.)
+            w%x_f3 = f_malloc_ptr((/ w%nxf3, nspinor /),id='w%x_f3',pool=.true.)
 
          else
 
@@ -441,8 +441,8 @@ module locreg_operations
             w%nxf3=0
 
             if (allocate_arrays) then
-               w%x_c = f_malloc_ptr((/ w%nxc, nspinor /),id='w%x_c')
-               w%y_c = f_malloc_ptr((/ w%nyc, nspinor /),id='w%y_c',info='{alignment: 32}')
+               w%x_c = f_malloc_ptr((/ w%nxc, nspinor /),id='w%x_c',pool=.true.)
+               w%y_c = f_malloc_ptr((/ w%nyc, nspinor /),id='w%y_c',info='{alignment: 32}',pool=.true.)
             end if
          endif
       case('W')
@@ -459,8 +459,8 @@ module locreg_operations
 
          !allocation of work arrays
          if (allocate_arrays) then
-            w%x_c = f_malloc_ptr((/ w%nxc, nspinor /),id='w%x_c')
-            w%y_c = f_malloc_ptr((/ w%nyc, nspinor /),id='w%y_c')
+            w%x_c = f_malloc_ptr((/ w%nxc, nspinor /),id='w%x_c',pool=.true.)
+            w%y_c = f_malloc_ptr((/ w%nyc, nspinor /),id='w%y_c',pool=.true.)
          end if
 
       end select
@@ -537,16 +537,16 @@ module locreg_operations
 
          !allocation of work arrays
          if (allocate_arrays) then
-            w%y_c = f_malloc_ptr((/ w%nyc, nspinor /),id='w%y_c',info='{alignment: 32}')
+            w%y_c = f_malloc_ptr((/ w%nyc, nspinor /),id='w%y_c',info='{alignment: 32}',pool=.true.)
             !w%y_c = f_malloc_ptr((/ w%nyc, nspinor /),id='w%y_c')!info='{alignment: 32}')
-            w%y_f = f_malloc_ptr((/ w%nyf, nspinor /),id='w%y_f')
-            w%x_c = f_malloc_ptr((/ w%nxc, nspinor /),id='w%x_c')
-            w%x_f = f_malloc_ptr((/ w%nxf, nspinor /),id='w%x_f')
-            w%w1 = f_malloc_ptr(w%nw1,id='w%w1')
-            w%w2 = f_malloc_ptr(w%nw2,id='w%w2')
-            w%x_f1 = f_malloc_ptr((/ w%nxf1, nspinor /),id='w%x_f1')
-            w%x_f2 = f_malloc_ptr((/ w%nxf2, nspinor /),id='w%x_f2')
-            w%x_f3 = f_malloc_ptr((/ w%nxf3, nspinor /),id='w%x_f3')
+            w%y_f = f_malloc_ptr((/ w%nyf, nspinor /),id='w%y_f',pool=.true.)
+            w%x_c = f_malloc_ptr((/ w%nxc, nspinor /),id='w%x_c',pool=.true.)
+            w%x_f = f_malloc_ptr((/ w%nxf, nspinor /),id='w%x_f',pool=.true.)
+            w%w1 = f_malloc_ptr(w%nw1,id='w%w1',pool=.true.)
+            w%w2 = f_malloc_ptr(w%nw2,id='w%w2',pool=.true.)
+            w%x_f1 = f_malloc_ptr((/ w%nxf1, nspinor /),id='w%x_f1',pool=.true.)
+            w%x_f2 = f_malloc_ptr((/ w%nxf2, nspinor /),id='w%x_f2',pool=.true.)
+            w%x_f3 = f_malloc_ptr((/ w%nxf3, nspinor /),id='w%x_f3',pool=.true.)
          end if
 
          !initialisation of the work arrays
@@ -571,8 +571,8 @@ module locreg_operations
 
          !allocation of work arrays
          if (allocate_arrays) then
-            w%x_c = f_malloc_ptr((/ w%nxc, nspinor /),id='w%x_c')
-            w%y_c = f_malloc_ptr((/ w%nyc, nspinor /),id='w%y_c',info='{alignment: 32}')
+            w%x_c = f_malloc_ptr((/ w%nxc, nspinor /),id='w%x_c',pool=.true.)
+            w%y_c = f_malloc_ptr((/ w%nyc, nspinor /),id='w%y_c',info='{alignment: 32}',pool=.true.)
          end if
 
       case('P')
@@ -598,15 +598,15 @@ module locreg_operations
             w%nxf2=nf
             w%nxf3=nf
 
-            w%y_c = f_malloc_ptr((/ w%nyc, nspinor /),id='w%y_c',info='{alignment: 32}')
-            w%y_f = f_malloc_ptr((/ w%nyf, nspinor /),id='w%y_f')
-            w%x_c = f_malloc_ptr((/ w%nxc, nspinor /),id='w%x_c')
-            w%x_f = f_malloc_ptr((/ w%nxf, nspinor /),id='w%x_f')
-            w%w1 = f_malloc_ptr(w%nw1,id='w%w1')
-            w%w2 = f_malloc_ptr(w%nw2,id='w%w2')
-            w%x_f1 = f_malloc_ptr((/ w%nxf1, nspinor /),id='w%x_f1')
-            w%x_f2 = f_malloc_ptr((/ w%nxf2, nspinor /),id='w%x_f2')
-            w%x_f3 = f_malloc_ptr((/ w%nxf3, nspinor /),id='w%x_f3')
+            w%y_c = f_malloc_ptr((/ w%nyc, nspinor /),id='w%y_c',info='{alignment: 32}',pool=.true.)
+            w%y_f = f_malloc_ptr((/ w%nyf, nspinor /),id='w%y_f',pool=.true.)
+            w%x_c = f_malloc_ptr((/ w%nxc, nspinor /),id='w%x_c',pool=.true.)
+            w%x_f = f_malloc_ptr((/ w%nxf, nspinor /),id='w%x_f',pool=.true.)
+            w%w1 = f_malloc_ptr(w%nw1,id='w%w1',pool=.true.)
+            w%w2 = f_malloc_ptr(w%nw2,id='w%w2',pool=.true.)
+            w%x_f1 = f_malloc_ptr((/ w%nxf1, nspinor /),id='w%x_f1',pool=.true.)
+            w%x_f2 = f_malloc_ptr((/ w%nxf2, nspinor /),id='w%x_f2',pool=.true.)
+            w%x_f3 = f_malloc_ptr((/ w%nxf3, nspinor /),id='w%x_f3',pool=.true.)
 
          else
 
@@ -621,8 +621,8 @@ module locreg_operations
             w%nxf3=0
 
             if (allocate_arrays) then
-               w%x_c = f_malloc_ptr((/ w%nxc, nspinor /),id='w%x_c')
-               w%y_c = f_malloc_ptr((/ w%nyc, nspinor /),id='w%y_c',info='{alignment: 32}')
+               w%x_c = f_malloc_ptr((/ w%nxc, nspinor /),id='w%x_c',pool=.true.)
+               w%y_c = f_malloc_ptr((/ w%nyc, nspinor /),id='w%y_c',info='{alignment: 32}',pool=.true.)
             end if
          endif
       case('W')
@@ -638,8 +638,8 @@ module locreg_operations
 
          !allocation of work arrays
          if (allocate_arrays) then
-            w%x_c = f_malloc_ptr((/ w%nxc, nspinor /),id='w%x_c')
-            w%y_c = f_malloc_ptr((/ w%nyc, nspinor /),id='w%y_c')
+            w%x_c = f_malloc_ptr((/ w%nxc, nspinor /),id='w%x_c',pool=.true.)
+            w%y_c = f_malloc_ptr((/ w%nyc, nspinor /),id='w%y_c',pool=.true.)
          end if
 
       end select
@@ -936,10 +936,10 @@ module locreg_operations
       end select
       !work arrays
       if (allocate_arrays) then
-         w%x_c = f_malloc_ptr(w%nxc,id='w%x_c')
-         w%x_f = f_malloc_ptr(w%nxf,id='w%x_f')
-         w%w1 = f_malloc_ptr(w%nw1,id='w%w1')
-         w%w2 = f_malloc_ptr(w%nw2,id='w%w2')
+         w%x_c = f_malloc_ptr(w%nxc,id='w%x_c',pool=.true.)
+         w%x_f = f_malloc_ptr(w%nxf,id='w%x_f',pool=.true.)
+         w%w1 = f_malloc_ptr(w%nw1,id='w%w1',pool=.true.)
+         w%w2 = f_malloc_ptr(w%nw2,id='w%w2',pool=.true.)
       end if
 
 
@@ -1037,10 +1037,10 @@ module locreg_operations
       end select
       !work arrays
       if (allocate_arrays) then
-         w%x_c = f_malloc_ptr(w%nxc,id='w%x_c')
-         w%x_f = f_malloc_ptr(w%nxf,id='w%x_f')
-         w%w1 = f_malloc_ptr(w%nw1,id='w%w1')
-         w%w2 = f_malloc_ptr(w%nw2,id='w%w2')
+         w%x_c = f_malloc_ptr(w%nxc,id='w%x_c',pool=.true.)
+         w%x_f = f_malloc_ptr(w%nxf,id='w%x_f',pool=.true.)
+         w%w1 = f_malloc_ptr(w%nw1,id='w%w1',pool=.true.)
+         w%w2 = f_malloc_ptr(w%nw2,id='w%w2',pool=.true.)
       end if
 
 
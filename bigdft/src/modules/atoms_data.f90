@@ -2648,49 +2648,74 @@ END SUBROUTINE astruct_distance
 
 
 !> Compute a list of neighbours for the given structure.
+!! The pairs are found with the linked cells of module_verlet, except for
+!! non-orthorhombic cells where all pairs are tested.
 subroutine astruct_neighbours(astruct, rxyz, neighb)
   use module_defs, only: gp
   use module_atoms, only: atomic_structure, atomic_neighbours, nullify_atomic_neighbours
+  use module_verlet
   use dynamic_memory
   use ao_inguess, only: atomic_info,atomic_z
-  use at_domain, only: domain_geocode
+  use at_domain, only: domain_periodic_dims
   implicit none
   type(atomic_structure), intent(in) :: astruct
   real(gp), dimension(3, astruct%nat), intent(in) :: rxyz
   type(atomic_neighbours), intent(out) :: neighb
 
-  integer :: maxnei, i, j, nnei
+  integer :: maxnei, i, j, k, nnei
   integer, dimension(:,:), allocatable :: tmp_nei
   logical, dimension(3) :: per
   real(gp), dimension(3) :: dxyz
   real(gp), dimension(:), allocatable :: rcuts
+  type(verlet_list) :: vl
 
   call nullify_atomic_neighbours(neighb)
 
   neighb%nat = astruct%nat
   neighb%keynei = f_malloc0_ptr((/ 2, neighb%nat /), id = "neighb%keynei")
 
-  maxnei = min(astruct%nat, 50)
-  tmp_nei = f_malloc((/ maxnei, astruct%nat /), id = "tmp_nei")
-
-  !select case(astruct%geocode)
-  select case(domain_geocode(astruct%dom))
-  case ("P")
-     per = (/ .true., .true., .true. /)
-  case ("S")
-     per = (/ .true., .false., .true. /)
-  case ("W")
-     per = (/ .false., .false., .true. /)
-  case default
-     per = (/ .false., .false., .false. /)
-  end select
-
   rcuts = f_malloc(astruct%ntypes, id = "rcuts")
   do i = 1, astruct%ntypes, 1
      call atomic_info(atomic_z(trim(astruct%atomnames(i))), rcov = rcuts(i))
      rcuts(i) = rcuts(i) * 1.2_gp ! add 20% in case.
   end do
 
+  if (astruct%dom%orthorhombic) then
+     vl = verlet_list_null()
+     call verlet_list_set(vl, 2.0_gp * maxval(rcuts), 0.0_gp)
+     call verlet_list_update(vl, astruct%dom, astruct%nat, rxyz)
+
+     ! Keep one image of each neighbour, the list being sorted by atom index.
+     neighb%nei = f_malloc_ptr(size(vl%nei), id = "neighb%nei")
+     nnei = 0
+     do i = 1, astruct%nat
+        neighb%keynei(2, i) = nnei + 1
+        do k = vl%keynei(2, i), vl%keynei(2, i) + vl%keynei(1, i) - 1
+           j = vl%nei(k)
+           if (j == i) cycle
+           if (nnei >= neighb%keynei(2, i)) then
+              if (neighb%nei(nnei) == j) cycle
+           end if
+           dxyz = verlet_pair(vl, astruct%nat, rxyz, i, k)
+           if (dxyz(1) * dxyz(1) + dxyz(2) * dxyz(2) + dxyz(3) * dxyz(3) < &
+                & (rcuts(astruct%iatype(i)) + rcuts(astruct%iatype(j)))**2) then
+              nnei = nnei + 1
+              neighb%nei(nnei) = j
+           end if
+        end do
+        neighb%keynei(1, i) = nnei - neighb%keynei(2, i) + 1
+     end do
+
+     call deallocate_verlet_list(vl)
+     call f_free(rcuts)
+     return
+  end if
+
+  maxnei = min(astruct%nat, 50)
+  tmp_nei = f_malloc((/ maxnei, astruct%nat /), id = "tmp_nei")
+
+  per = domain_periodic_dims(astruct%dom)
+
   nnei = 0
   do i = 1, astruct%nat
      do j = i + 1, astruct%nat
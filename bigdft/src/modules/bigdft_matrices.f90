@@ -632,7 +632,7 @@ module bigdft_matrices
       call init_sparse_matrix_wrapper(iproc, nproc, &
            in%nspin, orbs, lzd_s, atoms%astruct, &
            in%store_index, init_matmul=.true., matmul_optimize_load_balancing=in%cp%foe%matmul_optimize_load_balancing, &
-           imode=2, smat=linmat%smat(3), smat_ref=linmat%smat(2))
+           imode=2, smat=linmat%smat(3), smat_ref=linmat%smat(2), matmul_bsr=in%cp%foe%matmul_bsr)
       !write(1000+iproc,*) 'calling init_matrixindex_in_compressed_fortransposed'
       call init_matrixindex_in_compressed_fortransposed(iproc, nproc, &
            collcom_s, collcom_m, collcom_s_sr, linmat%smat(3), &
@@ -320,6 +320,9 @@ contains
     use module_cp2k
     use module_alborz
     use module_BornMayerHugginsTosiFumi
+    use module_lj, only: finalize_lj
+    use module_morse_bulk, only: finalize_morse_bulk
+    use module_tersoff, only: finalize_tersoff
     use f_enums, enum_int => toi
     use yaml_strings
     use SWpotential
@@ -330,6 +333,12 @@ contains
     call f_free_ptr(mm_rst%rf_extra)
     !free the extra variables
     select case(trim(f_str(mm_rst%run_mode)))
+    case('LENNARD_JONES_RUN_MODE')
+       call finalize_lj()
+    case('MORSE_SLAB_RUN_MODE','MORSE_BULK_RUN_MODE')
+       call finalize_morse_bulk()
+    case('TERSOFF_RUN_MODE')
+       call finalize_tersoff()
     case('BMHTF_RUN_MODE')
        call finalize_bmhtf()
     case('CP2K_RUN_MODE') ! CP2K run mode
@@ -418,6 +427,7 @@ contains
     use locregs
     use gaussians, only: deallocate_gwf
     use module_types
+    use vdwcorrection, only: vdwcorrection_finalize
     implicit none
     type(QM_restart_objects) :: rst
     !local variables
@@ -452,6 +462,9 @@ contains
     end if
     call f_free_ptr(rst%KSwfn%gaucoeffs)
 
+    !tables of the dispersion correction kept along the geometry steps
+    call vdwcorrection_finalize()
+
     !finalise the material accelearion usage
     call release_material_acceleration(rst%GPU)
 
@@ -2136,6 +2149,10 @@ contains
           do istep=0,runObj%inputs%wfn_history+1
              runObj%rst%KSwfn%oldpsis(istep)=old_wavefunction_null()
           end do
+          !the history may be compressed, the last SCF wavefunction is always kept in full
+          do istep=0,runObj%inputs%wfn_history
+             runObj%rst%KSwfn%oldpsis(istep)%precision=runObj%inputs%wfn_history_precision
+          end do
        end if
 
        if ((runObj%inputs%inputPsiId == 'INPUT_PSI_LCAO' .or. runObj%inputs%inputPsiId == 'INPUT_PSI_DISK_WVL') .and. &
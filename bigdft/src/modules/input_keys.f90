@@ -298,6 +298,7 @@ module module_input_keys
      character(len=10) :: geopt_approach !<id of geopt driver
      integer :: ncount_cluster_x         !< Maximum number of geopt steps
      integer :: wfn_history              !< Number of previous steps saved for wfn reformatting
+     integer :: wfn_history_precision    !< Storage of the saved steps (WFN_HISTORY_*)
      integer :: history                  !< History of DIIS method
      real(gp) :: betax,forcemax,randdis
      integer :: optcell, ionmov, nnos
@@ -373,6 +374,10 @@ module module_input_keys
      !!   BC (Blocking Collective)
      !!   OP2P (Overlap Point-to-Point)
      character(len=4) :: exctxpar
+     !> Fraction of the orbital norms neglected to screen the exact exchange couples (0 for no screening)
+     real(gp) :: exctx_screening
+     !> Persistent requests for the OP2P ring of the exact exchange
+     logical :: exctx_persistent
      !> Paradigm for unblocking global communications via OMP_NESTING
      character(len=3) :: unblock_comms
      !> Communication scheme for the density
@@ -1547,6 +1552,8 @@ contains
        output_wf=ENUM_BINARY
     case(WF_FORMAT_ETSF)
        output_wf=ENUM_ETSF
+    case(WF_FORMAT_MPI_NATIVE)
+       output_wf=ENUM_MPI_NATIVE
     end select
 
   end subroutine set_output_wf
@@ -1564,6 +1571,8 @@ contains
        output_wf=ENUM_TEXT
     case('binary')
        output_wf=ENUM_BINARY
+    case('mpi_binary')
+       output_wf=ENUM_MPI_NATIVE
     case('text_with_densities')
        output_wf=ENUM_TEXT
        call f_enum_attr(output_wf,ENUM_DENSITY)
@@ -1840,6 +1849,10 @@ contains
           in%projrad = val
        case (EXCTXPAR)
           in%exctxpar = val
+       case (EXCTX_SCREENING)
+          in%exctx_screening = val
+       case (EXCTX_PERSISTENT)
+          in%exctx_persistent = val
        case (INGUESS_GEOPT)
           in%inguess_geopt = val
        case (ACCEL)
@@ -2117,6 +2130,16 @@ contains
          in%nosefrq = val
        case (WAVEFUNCTION_EXTRAPOLATION)
           in%wfn_history = val
+       case (WAVEFUNCTION_HISTORY_PRECISION) !string
+          str = dict_value(val)
+          select case(trim(str))
+          case('single')
+             in%wfn_history_precision = WFN_HISTORY_SINGLE
+          case('quantized')
+             in%wfn_history_precision = WFN_HISTORY_QUANTIZED
+          case default
+             in%wfn_history_precision = WFN_HISTORY_DOUBLE
+          end select
        case (RESTART_NOSE)
           in%restart_nose = val
        case (RESTART_VEL)
@@ -2654,6 +2677,7 @@ contains
     in%history = 1
 !    in%wfn_history = 1
     in%wfn_history = 0
+    in%wfn_history_precision = WFN_HISTORY_DOUBLE
     in%ionmov = -1
     in%dtion = 0.0_gp
     in%strtarget(:)=0.0_gp
@@ -3234,6 +3258,9 @@ contains
        wave_format_from_filename = WF_FORMAT_ETSF
        if (iproc ==0) call yaml_comment('Reading wavefunctions in ETSF file format.')
        !if (iproc ==0) write(*,*) "Reading wavefunctions in ETSF file format."
+    else if (index(filename, ".mpibin", back = .true.) > 0) then
+       wave_format_from_filename = WF_FORMAT_MPI_NATIVE
+       if (iproc ==0) call yaml_comment('Reading wavefunctions in MPI-IO container format.')
     else
        isuffix = index(filename, ".bin", back = .true.)
        if (isuffix > 0) then
@@ -183,7 +183,8 @@ module module_interfaces
        interface
          subroutine LocalHamiltonianApplication(iproc,nproc,at,npsidim_orbs,orbs,&
           Lzd,confdatarr,ngatherarr,pot,psi,hpsi,&
-          energs,SIC,GPU,PotOrKin,xc,pkernel,orbsocc,psirocc,dpbox,potential,comgp,hpsi_noconf,econf)
+          energs,SIC,GPU,PotOrKin,xc,pkernel,orbsocc,psirocc,dpbox,potential,comgp,hpsi_noconf,econf,&
+          exctx_screening,exctx_persistent)
          use module_defs, only: gp,dp,wp
        use module_dpbox
        use module_types
@@ -213,6 +214,8 @@ module module_interfaces
        type(p2pComms),intent(inout), optional:: comgp
        real(wp), target, dimension(max(1,orbs%npsidim_orbs)), intent(inout),optional :: hpsi_noconf
        real(gp),intent(out),optional :: econf
+       real(gp), intent(in), optional :: exctx_screening
+       logical, intent(in), optional :: exctx_persistent
          END SUBROUTINE LocalHamiltonianApplication
        end interface
 
@@ -1,5 +1,6 @@
 module io
   use public_enums
+  use f_precisions, only: f_long
   implicit none
 
   private
@@ -32,6 +33,38 @@ module io
 
   public :: writeonewave
   public :: writemywaves
+  public :: write_waves_mpi, read_waves_mpi
+  public :: write_waves_linear_mpi, open_waves_linear_mpi, io_read_descr_linear_mpi, read_psig_mpi
+  public :: WF_BIN_NHEADER
+
+  !> Layout of the wavefunction container written with MPI-IO (see write_waves_mpi)
+  character(len=8), parameter :: WF_BIN_TAG = 'BIGDFTWF' !< tag at the beginning of the file
+  integer, parameter :: WF_BIN_VERSION = 1 !< version of the container
+  integer, parameter :: WF_BIN_NHEADER = 18 !< number of long integers in the header
+  integer(f_long), parameter :: WF_BIN_ALIGNMENT = 4096 !< alignment of the coefficients (page size)
+  integer, parameter :: WF_BIN_H_VERSION = 1
+  integer, parameter :: WF_BIN_H_N1 = 2
+  integer, parameter :: WF_BIN_H_N2 = 3
+  integer, parameter :: WF_BIN_H_N3 = 4
+  integer, parameter :: WF_BIN_H_NAT = 5
+  integer, parameter :: WF_BIN_H_NORB = 6
+  integer, parameter :: WF_BIN_H_NSPINOR = 7
+  integer, parameter :: WF_BIN_H_NSEG_C = 8
+  integer, parameter :: WF_BIN_H_NSEG_F = 9
+  integer, parameter :: WF_BIN_H_NVCTR_C = 10
+  integer, parameter :: WF_BIN_H_NVCTR_F = 11
+  integer, parameter :: WF_BIN_H_OFF_HGRIDS = 12
+  integer, parameter :: WF_BIN_H_OFF_KEYS = 13
+  integer, parameter :: WF_BIN_H_OFF_RXYZ = 14
+  integer, parameter :: WF_BIN_H_OFF_EVAL = 15
+  integer, parameter :: WF_BIN_H_OFF_PSI = 16
+  integer, parameter :: WF_BIN_H_SIZE_INTEGER = 17
+  integer, parameter :: WF_BIN_H_SIZE_DOUBLE = 18
+  !> Container of the support functions (see write_waves_linear_mpi), with the same header
+  character(len=8), parameter :: WF_LIN_TAG = 'BIGDFTSF' !< tag at the beginning of the file
+  integer, parameter :: WF_BIN_H_OFF_RECORDS = WF_BIN_H_OFF_KEYS !< offsets of the records, instead of the keys
+  integer, parameter :: WF_LIN_NDBL = 6 !< doubles at the beginning of a record
+  integer, parameter :: WF_LIN_NINT = 13 !< integers following them
 
   contains
 
@@ -97,43 +130,48 @@ module io
          call cpu_time(tr0)
          call system_clock(ncount1,ncount_rate,ncount_max)
     
-         ! Write the TMBs in the Plain BigDFT files.
-         ! Use same ordering as posinp and llr generation
-         ii = 0
-         do iat = 1, at%astruct%nat
-            do iorb=1,orbs%norbp
-               if(iat == orbs%onwhichatom(iorb+orbs%isorb)) then
-                  shift = 1
-                  do jorb = 1, iorb-1 
-                     jlr = orbs%inwhichlocreg(jorb+orbs%isorb)
-                     shift = shift + Lzd%Llr(jlr)%wfd%nvctr_c+7*Lzd%Llr(jlr)%wfd%nvctr_f
-                  end do
-                  ii = ii + 1
-                  ilr = orbs%inwhichlocreg(iorb+orbs%isorb)
-                  do ispinor=1,orbs%nspinor
-                     call open_filename_of_iorb(unitwf,binary,filename, &
-                        & orbs,iorb,ispinor,iorb_out)
-                     call writeonewave_linear(unitwf,.not. binary,iorb_out,&
-                        & Lzd%Llr(ilr)%d%n1,Lzd%Llr(ilr)%d%n2,Lzd%Llr(ilr)%d%n3,&
-                        & Lzd%Llr(ilr)%ns1,Lzd%Llr(ilr)%ns2,Lzd%Llr(ilr)%ns3,& 
-                        & Lzd%hgrids(1),Lzd%hgrids(2),Lzd%hgrids(3), &
-                        & Lzd%Llr(ilr)%locregCenter,Lzd%Llr(ilr)%locrad, 4, 0.0d0, &  !put here the real potentialPrefac and Order
-                        & at%astruct%nat,rxyz,&
-                        & Lzd%Llr(ilr)%wfd%nseg_c,Lzd%Llr(ilr)%wfd%nvctr_c,&
-                        & Lzd%Llr(ilr)%wfd%keygloc,Lzd%Llr(ilr)%wfd%keyglob,&
-                        & Lzd%Llr(ilr)%wfd%keyvloc,Lzd%Llr(ilr)%wfd%keyvglob,&
-                        & Lzd%Llr(ilr)%wfd%nseg_f,Lzd%Llr(ilr)%wfd%nvctr_f,&
-                        & Lzd%Llr(ilr)%wfd%keygloc(1:,Lzd%Llr(ilr)%wfd%nseg_c+1:), &
-                        & Lzd%Llr(ilr)%wfd%keyglob(1:,Lzd%Llr(ilr)%wfd%nseg_c+1:), &
-                        & Lzd%Llr(ilr)%wfd%keyvloc(Lzd%Llr(ilr)%wfd%nseg_c+1:), &
-                        & Lzd%Llr(ilr)%wfd%keyvglob(Lzd%Llr(ilr)%wfd%nseg_c+1:), &
-                        & psi(shift),psi(Lzd%Llr(ilr)%wfd%nvctr_c+shift),orbs%eval(iorb+orbs%isorb),&
-                        & orbs%onwhichatom(iorb+orbs%isorb))
-                     call f_close(unitwf)
-                  end do
-               end if
-            enddo
-         end do
+         if (iformat == WF_FORMAT_MPI_NATIVE) then
+            ! All the TMBs in a single file
+            call write_waves_linear_mpi(iproc,filename//'.mpibin',npsidim,Lzd,orbs,at,rxyz,psi)
+         else
+            ! Write the TMBs in the Plain BigDFT files.
+            ! Use same ordering as posinp and llr generation
+            ii = 0
+            do iat = 1, at%astruct%nat
+               do iorb=1,orbs%norbp
+                  if(iat == orbs%onwhichatom(iorb+orbs%isorb)) then
+                     shift = 1
+                     do jorb = 1, iorb-1 
+                        jlr = orbs%inwhichlocreg(jorb+orbs%isorb)
+                        shift = shift + Lzd%Llr(jlr)%wfd%nvctr_c+7*Lzd%Llr(jlr)%wfd%nvctr_f
+                     end do
+                     ii = ii + 1
+                     ilr = orbs%inwhichlocreg(iorb+orbs%isorb)
+                     do ispinor=1,orbs%nspinor
+                        call open_filename_of_iorb(unitwf,binary,filename, &
+                           & orbs,iorb,ispinor,iorb_out)
+                        call writeonewave_linear(unitwf,.not. binary,iorb_out,&
+                           & Lzd%Llr(ilr)%d%n1,Lzd%Llr(ilr)%d%n2,Lzd%Llr(ilr)%d%n3,&
+                           & Lzd%Llr(ilr)%ns1,Lzd%Llr(ilr)%ns2,Lzd%Llr(ilr)%ns3,& 
+                           & Lzd%hgrids(1),Lzd%hgrids(2),Lzd%hgrids(3), &
+                           & Lzd%Llr(ilr)%locregCenter,Lzd%Llr(ilr)%locrad, 4, 0.0d0, &  !put here the real potentialPrefac and Order
+                           & at%astruct%nat,rxyz,&
+                           & Lzd%Llr(ilr)%wfd%nseg_c,Lzd%Llr(ilr)%wfd%nvctr_c,&
+                           & Lzd%Llr(ilr)%wfd%keygloc,Lzd%Llr(ilr)%wfd%keyglob,&
+                           & Lzd%Llr(ilr)%wfd%keyvloc,Lzd%Llr(ilr)%wfd%keyvglob,&
+                           & Lzd%Llr(ilr)%wfd%nseg_f,Lzd%Llr(ilr)%wfd%nvctr_f,&
+                           & Lzd%Llr(ilr)%wfd%keygloc(1:,Lzd%Llr(ilr)%wfd%nseg_c+1:), &
+                           & Lzd%Llr(ilr)%wfd%keyglob(1:,Lzd%Llr(ilr)%wfd%nseg_c+1:), &
+                           & Lzd%Llr(ilr)%wfd%keyvloc(Lzd%Llr(ilr)%wfd%nseg_c+1:), &
+                           & Lzd%Llr(ilr)%wfd%keyvglob(Lzd%Llr(ilr)%wfd%nseg_c+1:), &
+                           & psi(shift),psi(Lzd%Llr(ilr)%wfd%nvctr_c+shift),orbs%eval(iorb+orbs%isorb),&
+                           & orbs%onwhichatom(iorb+orbs%isorb))
+                        call f_close(unitwf)
+                     end do
+                  end if
+               enddo
+            end do
+         end if
     
         ! Now write the coefficients to file
         ! Must be careful, the orbs%norb is the number of basis functions
@@ -228,6 +266,8 @@ module io
       if (iformat == WF_FORMAT_ETSF) then
           stop 'Linear scaling with ETSF writing not implemented yet'
       !    call write_waves_etsf(iproc,filename,orbs,n1,n2,n3,hx,hy,hz,at,rxyz,wfd,psi)
+      else if (iformat == WF_FORMAT_MPI_NATIVE) then
+          call f_err_throw('Fragment output in a single MPI-IO file not implemented yet')
       else
          call cpu_time(tr0)
          call system_clock(ncount1,ncount_rate,ncount_max)
@@ -2020,9 +2060,8 @@ module io
       unitm=99
       binary=(mod(iformat,10) /= WF_FORMAT_PLAIN)
 
-      call get_sparse_matrix_format(iformat, sparse_format)
-
       if (write_sparse) then
+          call get_sparse_matrix_format(iformat, sparse_format)
           call write_sparse_matrix_metadata(iproc, tmb%linmat%smat(2)%nfvctr, at%astruct%nat, at%astruct%ntypes, &
                at%astruct%units, domain_geocode(at%astruct%dom), at%astruct%cell_dim, at%astruct%shift, at%astruct%iatype, &
                at%astruct%rxyz, at%nzatom, at%nelpsp, at%astruct%atomnames, &
@@ -2037,7 +2076,8 @@ module io
 
       if (write_sparse) then
           call write_sparse_matrix(sparse_format, iproc, nproc, bigdft_mpi%mpi_comm, &
-               tmb%linmat%smat(2), tmb%linmat%ham_, trim(filename//'hamiltonian_sparse'))
+               tmb%linmat%smat(2), tmb%linmat%ham_, trim(filename//'hamiltonian_sparse'), &
+               smmd=tmb%linmat%smmd)
       end if
     
     
@@ -2048,7 +2088,8 @@ module io
 
       if (write_sparse) then
           call write_sparse_matrix(sparse_format, iproc, nproc, bigdft_mpi%mpi_comm, &
-               tmb%linmat%smat(1), tmb%linmat%ovrlp_, filename//'overlap_sparse')
+               tmb%linmat%smat(1), tmb%linmat%ovrlp_, filename//'overlap_sparse', &
+               smmd=tmb%linmat%smmd)
       end if
     
     
@@ -2059,7 +2100,8 @@ module io
 
       if (write_sparse) then
           call write_sparse_matrix(sparse_format, iproc, nproc, bigdft_mpi%mpi_comm, &
-               tmb%linmat%smat(3), tmb%linmat%kernel_, filename//'density_kernel_sparse')
+               tmb%linmat%smat(3), tmb%linmat%kernel_, filename//'density_kernel_sparse', &
+               smmd=tmb%linmat%smmd)
       end if
     
     
@@ -2630,6 +2672,11 @@ module io
          sparse_format = 'serial_text'
      else if (mod(iformat,10) == MATRIX_FORMAT_MPI_NATIVE) then
          sparse_format = 'parallel_mpi-native'
+     else if (mod(iformat,10) == MATRIX_FORMAT_MPI_BINARY) then
+         sparse_format = 'parallel_mpi-binary'
+     else if (mod(iformat,10) == MATRIX_FORMAT_BINARY) then
+         call f_err_throw("the Fortran binary sparse format is not available, "//&
+              "use the binary container ('iformat'=5) instead")
      else
          call f_err_throw("unsupported value for 'iformat'")
      end if
@@ -2788,6 +2835,15 @@ module io
      !if (iproc == 0) write(*,"(1x,A,A,a)") "Write wavefunctions to file: ", trim(filename),'.*'
      if (iformat == WF_FORMAT_ETSF) then
         call write_waves_etsf(iproc,filename,orbs,n1,n2,n3,hx,hy,hz,at,rxyz,wfd,psi)
+     else if (iformat == WF_FORMAT_MPI_NATIVE) then
+        call write_waves_mpi(iproc,filename//'.mpibin',orbs,n1,n2,n3,hx,hy,hz,at,rxyz,wfd,psi)
+        ! Additional PAW data, always in text
+        if (iproc == 0 .and. present(paw)) then
+           call f_open_file(unitwf, file = filename // "-rhoij", binary = .false.)
+           if (associated(paw%pawrhoij)) &
+                call writerhoij(unitwf, .false., at%astruct%nat, paw%pawrhoij)
+           call f_close(unitwf)
+        end if
      else
         call cpu_time(tr0)
         call system_clock(ncount1,ncount_rate,ncount_max)
@@ -2839,4 +2895,661 @@ module io
    END SUBROUTINE writemywaves
 
 
+   !> Write all the wavefunctions in a single file with collective MPI-IO.
+   !! The file starts with the tag WF_BIN_TAG, followed by WF_BIN_NHEADER long integers (see the WF_BIN_H_*
+   !! entries) giving the dimensions and the byte offsets of the sections:
+   !!  - the grid spacings (3 doubles)
+   !!  - the compression keys, keyg (2*(nseg_c+nseg_f) integers) followed by keyv (nseg_c+nseg_f integers)
+   !!  - the atomic positions (3*nat doubles)
+   !!  - the eigenvalues of all the orbitals (norb*nkpts doubles)
+   !!  - the coefficients, aligned to WF_BIN_ALIGNMENT: orbital iorb and spinor ispinor occupy the
+   !!    nvctr_c+7*nvctr_f doubles starting at element ((iorb-1)*nspinor+ispinor-1)*(nvctr_c+7*nvctr_f)
+   !! Task 0 writes the descriptors and each task writes its own orbitals, so that the file can be
+   !! read back with any number of tasks.
+   subroutine write_waves_mpi(iproc,filename,orbs,n1,n2,n3,hx,hy,hz,at,rxyz,wfd,psi)
+     use module_types
+     use module_base
+     use yaml_output
+     implicit none
+     integer, intent(in) :: iproc,n1,n2,n3
+     real(gp), intent(in) :: hx,hy,hz
+     type(atoms_data), intent(in) :: at
+     type(orbitals_data), intent(in) :: orbs
+     type(wavefunctions_descriptors), intent(in) :: wfd
+     real(gp), dimension(3,at%astruct%nat), intent(in) :: rxyz
+     real(wp), dimension(wfd%nvctr_c+7*wfd%nvctr_f,orbs%nspinor,orbs%norbp), intent(in) :: psi
+     character(len=*), intent(in) :: filename
+     !Local variables
+     integer :: ierr,thefile,iorb,ncomp,norbp_max,nseg
+     integer(f_long) :: size_of_integer,size_of_double
+     integer(kind=mpi_offset_kind) :: disp
+     integer(f_long), dimension(WF_BIN_NHEADER) :: header
+     real(gp), dimension(3) :: hgrids
+     real(kind=8) :: t0,t1
+
+     call f_routine(id='write_waves_mpi')
+     t0=mpi_wtime()
+
+     ncomp=wfd%nvctr_c+7*wfd%nvctr_f
+     nseg=wfd%nseg_c+wfd%nseg_f
+     size_of_integer=int(mpitypesize(1),f_long)
+     size_of_double=int(mpitypesize(1.0_wp),f_long)
+     header=0_f_long
+     header(WF_BIN_H_VERSION)=int(WF_BIN_VERSION,f_long)
+     header(WF_BIN_H_N1)=int(n1,f_long)
+     header(WF_BIN_H_N2)=int(n2,f_long)
+     header(WF_BIN_H_N3)=int(n3,f_long)
+     header(WF_BIN_H_NAT)=int(at%astruct%nat,f_long)
+     header(WF_BIN_H_NORB)=int(orbs%norb,f_long)*orbs%nkpts
+     header(WF_BIN_H_NSPINOR)=int(orbs%nspinor,f_long)
+     header(WF_BIN_H_NSEG_C)=int(wfd%nseg_c,f_long)
+     header(WF_BIN_H_NSEG_F)=int(wfd%nseg_f,f_long)
+     header(WF_BIN_H_NVCTR_C)=int(wfd%nvctr_c,f_long)
+     header(WF_BIN_H_NVCTR_F)=int(wfd%nvctr_f,f_long)
+     header(WF_BIN_H_SIZE_INTEGER)=size_of_integer
+     header(WF_BIN_H_SIZE_DOUBLE)=size_of_double
+     header(WF_BIN_H_OFF_HGRIDS)=len(WF_BIN_TAG)+WF_BIN_NHEADER*8_f_long
+     header(WF_BIN_H_OFF_KEYS)=header(WF_BIN_H_OFF_HGRIDS)+3*size_of_double
+     header(WF_BIN_H_OFF_RXYZ)=wf_bin_aligned(header(WF_BIN_H_OFF_KEYS)+3*int(nseg,f_long)*size_of_integer,8_f_long)
+     header(WF_BIN_H_OFF_EVAL)=header(WF_BIN_H_OFF_RXYZ)+3*header(WF_BIN_H_NAT)*size_of_double
+     header(WF_BIN_H_OFF_PSI)=wf_bin_aligned(header(WF_BIN_H_OFF_EVAL)+header(WF_BIN_H_NORB)*size_of_double,&
+          WF_BIN_ALIGNMENT)
+
+     call mpi_file_open(bigdft_mpi%mpi_comm,trim(filename),mpi_mode_wronly+mpi_mode_create,&
+          mpi_info_null,thefile,ierr)
+     if (ierr /= 0) then
+        call f_err_throw("Could not open the file '"//trim(filename)//"'",err_name='BIGDFT_RUNTIME_ERROR')
+        call f_release_routine()
+        return
+     end if
+     !discard the content of a previous (possibly larger) file
+     disp=int(0,kind=mpi_offset_kind)
+     call mpi_file_set_size(thefile,disp,ierr)
+
+     if (iproc == 0) then
+        disp=int(0,kind=mpi_offset_kind)
+        call mpi_file_write_at(thefile,disp,WF_BIN_TAG,len(WF_BIN_TAG),mpi_character,mpi_status_ignore,ierr)
+        disp=int(len(WF_BIN_TAG),kind=mpi_offset_kind)
+        call mpi_file_write_at(thefile,disp,header,WF_BIN_NHEADER,mpi_integer8,mpi_status_ignore,ierr)
+        hgrids=(/ hx,hy,hz /)
+        disp=int(header(WF_BIN_H_OFF_HGRIDS),kind=mpi_offset_kind)
+        call mpi_file_write_at(thefile,disp,hgrids,3,mpi_double_precision,mpi_status_ignore,ierr)
+        disp=int(header(WF_BIN_H_OFF_KEYS),kind=mpi_offset_kind)
+        call mpi_file_write_at(thefile,disp,wfd%keygloc,2*nseg,mpi_integer,mpi_status_ignore,ierr)
+        disp=disp+int(2*int(nseg,f_long)*size_of_integer,kind=mpi_offset_kind)
+        call mpi_file_write_at(thefile,disp,wfd%keyvloc,nseg,mpi_integer,mpi_status_ignore,ierr)
+        disp=int(header(WF_BIN_H_OFF_RXYZ),kind=mpi_offset_kind)
+        call mpi_file_write_at(thefile,disp,rxyz,3*at%astruct%nat,mpi_double_precision,mpi_status_ignore,ierr)
+        disp=int(header(WF_BIN_H_OFF_EVAL),kind=mpi_offset_kind)
+        call mpi_file_write_at(thefile,disp,orbs%eval,orbs%norb*orbs%nkpts,mpi_double_precision,&
+             mpi_status_ignore,ierr)
+     end if
+
+     !one collective write per orbital, the tasks with less orbitals write nothing
+     norbp_max=orbs%norbp
+     if (bigdft_mpi%nproc > 1) call fmpi_allreduce(norbp_max,1,FMPI_MAX,comm=bigdft_mpi%mpi_comm)
+     do iorb=1,norbp_max
+        if (iorb <= orbs%norbp) then
+           disp=int(header(WF_BIN_H_OFF_PSI)+int(orbs%isorb+iorb-1,f_long)*orbs%nspinor*ncomp*size_of_double,&
+                kind=mpi_offset_kind)
+           call mpi_file_write_at_all(thefile,disp,psi(1,1,iorb),ncomp*orbs%nspinor,mpi_double_precision,&
+                mpi_status_ignore,ierr)
+        else
+           disp=int(header(WF_BIN_H_OFF_PSI),kind=mpi_offset_kind)
+           call mpi_file_write_at_all(thefile,disp,hgrids,0,mpi_double_precision,mpi_status_ignore,ierr)
+        end if
+     end do
+
+     call mpi_file_close(thefile,ierr)
+
+     t1=mpi_wtime()
+     if (iproc == 0) then
+        call yaml_mapping_open('Write Waves Time',flow=.true.)
+        call yaml_map('Format','MPI-IO')
+        call yaml_map('Timing',t1-t0,fmt='(1pe10.3)')
+        call yaml_mapping_close()
+     end if
+
+     call f_release_routine()
+
+   END SUBROUTINE write_waves_mpi
+
+
+   !> Read the wavefunctions of the local orbitals from a file written by write_waves_mpi.
+   !! The number of tasks may differ from the one which wrote the file.
+   !! If the grid or the atomic positions have changed, the wavefunctions are reformatted.
+   subroutine read_waves_mpi(iproc,filename,orbs,n1,n2,n3,hx,hy,hz,at,rxyz_old,rxyz,wfd,psi,orblist)
+     use module_types
+     use module_base
+     use yaml_output
+     use box
+     use at_domain, only: domain_periodic_dims
+     use bounds, only: ext_buffers_coarse
+     implicit none
+     integer, intent(in) :: iproc,n1,n2,n3
+     real(gp), intent(in) :: hx,hy,hz
+     type(wavefunctions_descriptors), intent(in) :: wfd
+     type(orbitals_data), intent(inout) :: orbs
+     type(atoms_data), intent(in) :: at
+     real(gp), dimension(3,at%astruct%nat), intent(in) :: rxyz
+     real(gp), dimension(3,at%astruct%nat), intent(out) :: rxyz_old
+     real(wp), dimension(wfd%nvctr_c+7*wfd%nvctr_f,orbs%nspinor,orbs%norbp), intent(out) :: psi
+     character(len=*), intent(in) :: filename
+     integer, dimension(orbs%norb), intent(in), optional :: orblist
+     !Local variables
+     logical :: reformat
+     integer :: ierr,thefile,iorb,jorb,ispinor,norbp_max,iat,nb1,nb2,nb3
+     integer :: n1_old,n2_old,n3_old,nseg_c_old,nseg_f_old,nvctr_c_old,nvctr_f_old,ncomp_old
+     integer :: iseg,jj,j0,j1,ii,i0,i1,i2,i3,i,jf
+     integer(kind=mpi_offset_kind) :: disp
+     integer(f_long), dimension(WF_BIN_NHEADER) :: header
+     character(len=len(WF_BIN_TAG)) :: tag
+     logical, dimension(3) :: peri
+     real(gp) :: displ
+     real(gp), dimension(3) :: hgrids_old
+     real(wp), dimension(1) :: eval
+     integer, dimension(:), allocatable :: keyv_old
+     integer, dimension(:,:), allocatable :: keyg_old
+     real(wp), dimension(:), allocatable :: psi_old
+     real(wp), dimension(:,:,:), allocatable :: psifscf
+     real(wp), dimension(:,:,:,:,:,:), allocatable :: psigold
+     type(cell) :: mesh
+
+     call f_routine(id='read_waves_mpi')
+
+     call mpi_file_open(bigdft_mpi%mpi_comm,trim(filename),mpi_mode_rdonly,mpi_info_null,thefile,ierr)
+     if (ierr /= 0) then
+        call f_err_throw("Could not open the file '"//trim(filename)//"'",err_name='BIGDFT_RUNTIME_ERROR')
+        call f_release_routine()
+        return
+     end if
+
+     disp=int(0,kind=mpi_offset_kind)
+     call mpi_file_read_at_all(thefile,disp,tag,len(tag),mpi_character,mpi_status_ignore,ierr)
+     if (tag /= WF_BIN_TAG) then
+        call f_err_throw("The file '"//trim(filename)//"' is not a BigDFT wavefunction container",&
+             err_name='BIGDFT_RUNTIME_ERROR')
+     end if
+     disp=int(len(WF_BIN_TAG),kind=mpi_offset_kind)
+     call mpi_file_read_at_all(thefile,disp,header,WF_BIN_NHEADER,mpi_integer8,mpi_status_ignore,ierr)
+     if (header(WF_BIN_H_VERSION) /= WF_BIN_VERSION) then
+        call f_err_throw('Unsupported version of the wavefunction container: '//&
+             trim(yaml_toa(header(WF_BIN_H_VERSION))),err_name='BIGDFT_RUNTIME_ERROR')
+     end if
+     if (header(WF_BIN_H_SIZE_INTEGER) /= mpitypesize(1) .or. header(WF_BIN_H_SIZE_DOUBLE) /= mpitypesize(1.0_wp)) then
+        call f_err_throw("The file '"//trim(filename)//"' was written with different data sizes",&
+             err_name='BIGDFT_RUNTIME_ERROR')
+     end if
+     if (header(WF_BIN_H_NSPINOR) /= orbs%nspinor .or. header(WF_BIN_H_NAT) /= at%astruct%nat .or. &
+          header(WF_BIN_H_NORB) < int(orbs%norb,f_long)*orbs%nkpts) then
+        call f_err_throw("The orbitals or the atoms of the file '"//trim(filename)//&
+             "' do not correspond to the current system",err_name='BIGDFT_RUNTIME_ERROR')
+     end if
+     if (f_err_check()) then
+        call mpi_file_close(thefile,ierr)
+        call f_release_routine()
+        return
+     end if
+     n1_old=int(header(WF_BIN_H_N1))
+     n2_old=int(header(WF_BIN_H_N2))
+     n3_old=int(header(WF_BIN_H_N3))
+     nseg_c_old=int(header(WF_BIN_H_NSEG_C))
+     nseg_f_old=int(header(WF_BIN_H_NSEG_F))
+     nvctr_c_old=int(header(WF_BIN_H_NVCTR_C))
+     nvctr_f_old=int(header(WF_BIN_H_NVCTR_F))
+     ncomp_old=nvctr_c_old+7*nvctr_f_old
+
+     disp=int(header(WF_BIN_H_OFF_HGRIDS),kind=mpi_offset_kind)
+     call mpi_file_read_at_all(thefile,disp,hgrids_old,3,mpi_double_precision,mpi_status_ignore,ierr)
+     disp=int(header(WF_BIN_H_OFF_RXYZ),kind=mpi_offset_kind)
+     call mpi_file_read_at_all(thefile,disp,rxyz_old,3*at%astruct%nat,mpi_double_precision,mpi_status_ignore,ierr)
+
+     mesh=cell_new(at%astruct%dom,[n1,n2,n3],[hx,hy,hz])
+     displ=0.0_gp
+     do iat=1,at%astruct%nat
+        displ=displ+distance(mesh%dom,rxyz(:,iat),rxyz_old(:,iat))**2
+     enddo
+     displ=sqrt(displ)
+
+     reformat=hgrids_old(1) /= hx .or. hgrids_old(2) /= hy .or. hgrids_old(3) /= hz .or. &
+          nvctr_c_old /= wfd%nvctr_c .or. nvctr_f_old /= wfd%nvctr_f .or. &
+          n1_old /= n1 .or. n2_old /= n2 .or. n3_old /= n3 .or. displ > 1.d-3
+     if (iproc == 0) then
+        call yaml_map('Need to reformat wavefunctions',reformat)
+        if (reformat .and. displ > 1.d-3) call yaml_comment('large displacement of molecule' // trim(yaml_toa(displ)))
+     end if
+
+     if (reformat) then
+        keyg_old=f_malloc([2,nseg_c_old+nseg_f_old],id='keyg_old')
+        keyv_old=f_malloc(nseg_c_old+nseg_f_old,id='keyv_old')
+        disp=int(header(WF_BIN_H_OFF_KEYS),kind=mpi_offset_kind)
+        call mpi_file_read_at_all(thefile,disp,keyg_old,2*(nseg_c_old+nseg_f_old),mpi_integer,mpi_status_ignore,ierr)
+        disp=disp+int(2*int(nseg_c_old+nseg_f_old,f_long)*header(WF_BIN_H_SIZE_INTEGER),kind=mpi_offset_kind)
+        call mpi_file_read_at_all(thefile,disp,keyv_old,nseg_c_old+nseg_f_old,mpi_integer,mpi_status_ignore,ierr)
+        psi_old=f_malloc(ncomp_old,id='psi_old')
+        psigold=f_malloc([0.to.n1_old,1.to.2,0.to.n2_old,1.to.2,0.to.n3_old,1.to.2],id='psigold')
+        !WARNING: the boundary conditions are not assumed to change between new and old
+        peri=domain_periodic_dims(at%astruct%dom)
+        call ext_buffers_coarse(peri(1),nb1)
+        call ext_buffers_coarse(peri(2),nb2)
+        call ext_buffers_coarse(peri(3),nb3)
+        psifscf=f_malloc([-nb1.to.2*n1+1+nb1,-nb2.to.2*n2+1+nb2,-nb3.to.2*n3+1+nb3],id='psifscf')
+     end if
+
+     !one collective read per orbital, as in write_waves_mpi
+     norbp_max=orbs%norbp
+     if (bigdft_mpi%nproc > 1) call fmpi_allreduce(norbp_max,1,FMPI_MAX,comm=bigdft_mpi%mpi_comm)
+     do iorb=1,norbp_max
+        if (iorb > orbs%norbp) then
+           disp=int(header(WF_BIN_H_OFF_EVAL),kind=mpi_offset_kind)
+           call mpi_file_read_at_all(thefile,disp,eval,0,mpi_double_precision,mpi_status_ignore,ierr)
+           do ispinor=1,orbs%nspinor
+              disp=int(header(WF_BIN_H_OFF_PSI),kind=mpi_offset_kind)
+              call mpi_file_read_at_all(thefile,disp,eval,0,mpi_double_precision,mpi_status_ignore,ierr)
+           end do
+           cycle
+        end if
+        !orbital of the file to be read
+        jorb=orbs%isorb+iorb
+        if (present(orblist)) jorb=orblist(jorb)
+        disp=int(header(WF_BIN_H_OFF_EVAL)+int(jorb-1,f_long)*header(WF_BIN_H_SIZE_DOUBLE),kind=mpi_offset_kind)
+        call mpi_file_read_at_all(thefile,disp,orbs%eval(orbs%isorb+iorb),1,mpi_double_precision,&
+             mpi_status_ignore,ierr)
+        do ispinor=1,orbs%nspinor
+           disp=int(header(WF_BIN_H_OFF_PSI)+(int(jorb-1,f_long)*orbs%nspinor+ispinor-1)*ncomp_old*&
+                header(WF_BIN_H_SIZE_DOUBLE),kind=mpi_offset_kind)
+           if (.not. reformat) then
+              call mpi_file_read_at_all(thefile,disp,psi(1,ispinor,iorb),ncomp_old,mpi_double_precision,&
+                   mpi_status_ignore,ierr)
+              cycle
+           end if
+           call mpi_file_read_at_all(thefile,disp,psi_old,ncomp_old,mpi_double_precision,mpi_status_ignore,ierr)
+           !expand the old coefficients on the old grid, as in writeonewave and readonewave
+           call f_zero(psigold)
+           do iseg=1,nseg_c_old+nseg_f_old
+              jj=keyv_old(iseg)
+              j0=keyg_old(1,iseg)
+              j1=keyg_old(2,iseg)
+              ii=j0-1
+              i3=ii/((n1_old+1)*(n2_old+1))
+              ii=ii-i3*(n1_old+1)*(n2_old+1)
+              i2=ii/(n1_old+1)
+              i0=ii-i2*(n1_old+1)
+              i1=i0+j1-j0
+              if (iseg <= nseg_c_old) then
+                 do i=i0,i1
+                    psigold(i,1,i2,1,i3,1)=psi_old(i-i0+jj)
+                 end do
+              else
+                 do i=i0,i1
+                    jf=nvctr_c_old+7*(i-i0+jj-1)
+                    psigold(i,2,i2,1,i3,1)=psi_old(jf+1)
+                    psigold(i,1,i2,2,i3,1)=psi_old(jf+2)
+                    psigold(i,2,i2,2,i3,1)=psi_old(jf+3)
+                    psigold(i,1,i2,1,i3,2)=psi_old(jf+4)
+                    psigold(i,2,i2,1,i3,2)=psi_old(jf+5)
+                    psigold(i,1,i2,2,i3,2)=psi_old(jf+6)
+                    psigold(i,2,i2,2,i3,2)=psi_old(jf+7)
+                 end do
+              end if
+           end do
+           call reformatonewave(displ,wfd,at,hgrids_old(1),hgrids_old(2),hgrids_old(3),&
+                n1_old,n2_old,n3_old,rxyz_old,psigold,hx,hy,hz,n1,n2,n3,rxyz,psifscf,psi(1,ispinor,iorb))
+        end do
+     end do
+
+     call mpi_file_close(thefile,ierr)
+
+     if (reformat) then
+        call f_free(keyg_old)
+        call f_free(keyv_old)
+        call f_free(psi_old)
+        call f_free(psigold)
+        call f_free(psifscf)
+     end if
+
+     call f_release_routine()
+
+   END SUBROUTINE read_waves_mpi
+
+
+   !> Write all the support functions in a single file with collective MPI-IO.
+   !! The header is the one of write_waves_mpi, preceded by WF_LIN_TAG. The grid and key entries
+   !! are zero, since each support function has its own localisation region; the sections are:
+   !!  - the grid spacings (3 doubles)
+   !!  - the atomic positions (3*nat doubles)
+   !!  - the byte offsets of the norb records, followed by the end of the file (norb+1 long integers)
+   !!  - the records, starting at WF_BIN_H_OFF_PSI (aligned to WF_BIN_ALIGNMENT), in the global order of the orbitals.
+   !! A record holds the locreg center, the localisation radius, the prefactor of the confinement and
+   !! the eigenvalue (WF_LIN_NDBL doubles), the orbital index of the file, the dimensions and the
+   !! starting point of the box, the atom, the order of the confinement and the sizes of the keys
+   !! (WF_LIN_NINT integers), the keys keygloc, keyglob, keyvloc and keyvglob and, aligned to 8 bytes,
+   !! the nvctr_c+7*nvctr_f coefficients. The sizes of the records are reduced among the tasks, then
+   !! each task writes its own records at their offsets.
+   subroutine write_waves_linear_mpi(iproc,filename,npsidim,Lzd,orbs,at,rxyz,psi)
+     use module_types
+     use module_base
+     use module_interfaces, only: filename_of_iorb
+     implicit none
+     integer, intent(in) :: iproc,npsidim
+     type(atoms_data), intent(in) :: at
+     type(orbitals_data), intent(in) :: orbs
+     type(local_zone_descriptors), intent(in) :: Lzd
+     real(gp), dimension(3,at%astruct%nat), intent(in) :: rxyz
+     real(wp), dimension(npsidim), intent(in) :: psi
+     character(len=*), intent(in) :: filename
+     !Local variables
+     integer :: ierr,thefile,iorb,iiorb,ilr,shift,ncomp,nseg,norbp_max,iorb_out,ipiece
+     integer(f_long) :: size_of_integer,size_of_double
+     integer(kind=mpi_offset_kind) :: disp
+     integer(f_long), dimension(WF_BIN_NHEADER) :: header
+     integer, dimension(WF_LIN_NINT) :: idescr
+     real(gp), dimension(WF_LIN_NDBL) :: ddescr
+     real(gp), dimension(3) :: hgrids
+     integer(f_long), dimension(:), allocatable :: recoff
+     character(len=500) :: filename_out
+
+     call f_routine(id='write_waves_linear_mpi')
+
+     size_of_integer=int(mpitypesize(1),f_long)
+     size_of_double=int(mpitypesize(1.0_wp),f_long)
+     header=0_f_long
+     header(WF_BIN_H_VERSION)=int(WF_BIN_VERSION,f_long)
+     header(WF_BIN_H_NAT)=int(at%astruct%nat,f_long)
+     header(WF_BIN_H_NORB)=int(orbs%norb,f_long)
+     header(WF_BIN_H_NSPINOR)=int(orbs%nspinor,f_long)
+     header(WF_BIN_H_SIZE_INTEGER)=size_of_integer
+     header(WF_BIN_H_SIZE_DOUBLE)=size_of_double
+     header(WF_BIN_H_OFF_HGRIDS)=len(WF_LIN_TAG)+WF_BIN_NHEADER*8_f_long
+     header(WF_BIN_H_OFF_RXYZ)=header(WF_BIN_H_OFF_HGRIDS)+3*size_of_double
+     header(WF_BIN_H_OFF_RECORDS)=header(WF_BIN_H_OFF_RXYZ)+3*header(WF_BIN_H_NAT)*size_of_double
+     header(WF_BIN_H_OFF_PSI)=wf_bin_aligned(header(WF_BIN_H_OFF_RECORDS)+(header(WF_BIN_H_NORB)+1)*8_f_long,&
+          WF_BIN_ALIGNMENT)
+
+     !size of the local records, then offsets of all the records
+     recoff=f_malloc0(orbs%norb+1,id='recoff')
+     do iorb=1,orbs%norbp
+        iiorb=orbs%isorb+iorb
+        ilr=orbs%inwhichlocreg(iiorb)
+        recoff(iiorb+1)=wf_lin_record_size(Lzd%Llr(ilr)%wfd,size_of_integer,size_of_double)
+     end do
+     if (bigdft_mpi%nproc > 1) call fmpi_allreduce(recoff(1),orbs%norb+1,FMPI_SUM,comm=bigdft_mpi%mpi_comm)
+     recoff(1)=header(WF_BIN_H_OFF_PSI)
+     do iorb=1,orbs%norb
+        recoff(iorb+1)=recoff(iorb)+recoff(iorb+1)
+     end do
+
+     call mpi_file_open(bigdft_mpi%mpi_comm,trim(filename),mpi_mode_wronly+mpi_mode_create,&
+          mpi_info_null,thefile,ierr)
+     if (ierr /= 0) then
+        call f_err_throw("Could not open the file '"//trim(filename)//"'",err_name='BIGDFT_RUNTIME_ERROR')
+        call f_free(recoff)
+        call f_release_routine()
+        return
+     end if
+     disp=int(0,kind=mpi_offset_kind)
+     call mpi_file_set_size(thefile,disp,ierr)
+
+     if (iproc == 0) then
+        disp=int(0,kind=mpi_offset_kind)
+        call mpi_file_write_at(thefile,disp,WF_LIN_TAG,len(WF_LIN_TAG),mpi_character,mpi_status_ignore,ierr)
+        disp=int(len(WF_LIN_TAG),kind=mpi_offset_kind)
+        call mpi_file_write_at(thefile,disp,header,WF_BIN_NHEADER,mpi_integer8,mpi_status_ignore,ierr)
+        hgrids=Lzd%hgrids
+        disp=int(header(WF_BIN_H_OFF_HGRIDS),kind=mpi_offset_kind)
+        call mpi_file_write_at(thefile,disp,hgrids,3,mpi_double_precision,mpi_status_ignore,ierr)
+        disp=int(header(WF_BIN_H_OFF_RXYZ),kind=mpi_offset_kind)
+        call mpi_file_write_at(thefile,disp,rxyz,3*at%astruct%nat,mpi_double_precision,mpi_status_ignore,ierr)
+        disp=int(header(WF_BIN_H_OFF_RECORDS),kind=mpi_offset_kind)
+        call mpi_file_write_at(thefile,disp,recoff,orbs%norb+1,mpi_integer8,mpi_status_ignore,ierr)
+     end if
+
+     !seven collective writes per support function, the tasks with less orbitals write nothing
+     norbp_max=orbs%norbp
+     if (bigdft_mpi%nproc > 1) call fmpi_allreduce(norbp_max,1,FMPI_MAX,comm=bigdft_mpi%mpi_comm)
+     shift=1
+     do iorb=1,norbp_max
+        if (iorb > orbs%norbp) then
+           disp=int(header(WF_BIN_H_OFF_PSI),kind=mpi_offset_kind)
+           do ipiece=1,7
+              call mpi_file_write_at_all(thefile,disp,hgrids,0,mpi_double_precision,mpi_status_ignore,ierr)
+           end do
+           cycle
+        end if
+        iiorb=orbs%isorb+iorb
+        ilr=orbs%inwhichlocreg(iiorb)
+        nseg=Lzd%Llr(ilr)%wfd%nseg_c+Lzd%Llr(ilr)%wfd%nseg_f
+        ncomp=Lzd%Llr(ilr)%wfd%nvctr_c+7*Lzd%Llr(ilr)%wfd%nvctr_f
+        call filename_of_iorb(.true.,filename,orbs,iorb,1,filename_out,iorb_out)
+        ddescr(1:3)=Lzd%Llr(ilr)%locregCenter
+        !put here the real potentialPrefac and Order, as in writemywaves_linear
+        ddescr(4)=Lzd%Llr(ilr)%locrad
+        ddescr(5)=0.0_gp
+        ddescr(6)=orbs%eval(iiorb)
+        idescr=(/ iorb_out,Lzd%Llr(ilr)%d%n1,Lzd%Llr(ilr)%d%n2,Lzd%Llr(ilr)%d%n3,&
+             Lzd%Llr(ilr)%ns1,Lzd%Llr(ilr)%ns2,Lzd%Llr(ilr)%ns3,orbs%onwhichatom(iiorb),4,&
+             Lzd%Llr(ilr)%wfd%nseg_c,Lzd%Llr(ilr)%wfd%nseg_f,Lzd%Llr(ilr)%wfd%nvctr_c,Lzd%Llr(ilr)%wfd%nvctr_f /)
+        disp=int(recoff(iiorb),kind=mpi_offset_kind)
+        call mpi_file_write_at_all(thefile,disp,ddescr,WF_LIN_NDBL,mpi_double_precision,mpi_status_ignore,ierr)
+        disp=disp+int(WF_LIN_NDBL*size_of_double,kind=mpi_offset_kind)
+        call mpi_file_write_at_all(thefile,disp,idescr,WF_LIN_NINT,mpi_integer,mpi_status_ignore,ierr)
+        disp=disp+int(WF_LIN_NINT*size_of_integer,kind=mpi_offset_kind)
+        call mpi_file_write_at_all(thefile,disp,Lzd%Llr(ilr)%wfd%keygloc,2*nseg,mpi_integer,mpi_status_ignore,ierr)
+        disp=disp+int(2*nseg*size_of_integer,kind=mpi_offset_kind)
+        call mpi_file_write_at_all(thefile,disp,Lzd%Llr(ilr)%wfd%keyglob,2*nseg,mpi_integer,mpi_status_ignore,ierr)
+        disp=disp+int(2*nseg*size_of_integer,kind=mpi_offset_kind)
+        call mpi_file_write_at_all(thefile,disp,Lzd%Llr(ilr)%wfd%keyvloc,nseg,mpi_integer,mpi_status_ignore,ierr)
+        disp=disp+int(nseg*size_of_integer,kind=mpi_offset_kind)
+        call mpi_file_write_at_all(thefile,disp,Lzd%Llr(ilr)%wfd%keyvglob,nseg,mpi_integer,mpi_status_ignore,ierr)
+        disp=int(recoff(iiorb+1)-ncomp*size_of_double,kind=mpi_offset_kind)
+        call mpi_file_write_at_all(thefile,disp,psi(shift),ncomp,mpi_double_precision,mpi_status_ignore,ierr)
+        shift=shift+ncomp
+     end do
+
+     call mpi_file_close(thefile,ierr)
+     call f_free(recoff)
+
+     call f_release_routine()
+
+   END SUBROUTINE write_waves_linear_mpi
+
+
+   !> Open a file written by write_waves_linear_mpi and read the descriptors common to all the records.
+   !! The call is collective; the records are then read with io_read_descr_linear_mpi and read_psig_mpi,
+   !! by each task independently, and the file is closed with mpi_file_close.
+   subroutine open_waves_linear_mpi(filename,thefile,header,recoff,hgrids_old,nat,rxyz_old)
+     use module_base
+     use yaml_output
+     implicit none
+     character(len=*), intent(in) :: filename
+     integer, intent(in) :: nat
+     integer, intent(out) :: thefile
+     integer(f_long), dimension(WF_BIN_NHEADER), intent(out) :: header
+     integer(f_long), dimension(:), allocatable, intent(out) :: recoff
+     real(gp), dimension(3), intent(out) :: hgrids_old
+     real(gp), dimension(3,nat), intent(out) :: rxyz_old
+     !Local variables
+     integer :: ierr
+     integer(kind=mpi_offset_kind) :: disp
+     character(len=len(WF_LIN_TAG)) :: tag
+
+     call mpi_file_open(bigdft_mpi%mpi_comm,trim(filename),mpi_mode_rdonly,mpi_info_null,thefile,ierr)
+     if (ierr /= 0) then
+        call f_err_throw("Could not open the file '"//trim(filename)//"'",err_name='BIGDFT_RUNTIME_ERROR')
+        return
+     end if
+
+     disp=int(0,kind=mpi_offset_kind)
+     call mpi_file_read_at_all(thefile,disp,tag,len(tag),mpi_character,mpi_status_ignore,ierr)
+     disp=int(len(WF_LIN_TAG),kind=mpi_offset_kind)
+     call mpi_file_read_at_all(thefile,disp,header,WF_BIN_NHEADER,mpi_integer8,mpi_status_ignore,ierr)
+     if (tag /= WF_LIN_TAG) then
+        call f_err_throw("The file '"//trim(filename)//"' is not a BigDFT container of support functions",&
+             err_name='BIGDFT_RUNTIME_ERROR')
+     else if (header(WF_BIN_H_VERSION) /= WF_BIN_VERSION) then
+        call f_err_throw('Unsupported version of the wavefunction container: '//&
+             trim(yaml_toa(header(WF_BIN_H_VERSION))),err_name='BIGDFT_RUNTIME_ERROR')
+     else if (header(WF_BIN_H_SIZE_INTEGER) /= mpitypesize(1) .or. &
+          header(WF_BIN_H_SIZE_DOUBLE) /= mpitypesize(1.0_wp)) then
+        call f_err_throw("The file '"//trim(filename)//"' was written with different data sizes",&
+             err_name='BIGDFT_RUNTIME_ERROR')
+     else if (header(WF_BIN_H_NAT) /= nat) then
+        call f_err_throw("The atoms of the file '"//trim(filename)//&
+             "' do not correspond to the current system",err_name='BIGDFT_RUNTIME_ERROR')
+     end if
+     if (f_err_check()) then
+        call mpi_file_close(thefile,ierr)
+        return
+     end if
+
+     disp=int(header(WF_BIN_H_OFF_HGRIDS),kind=mpi_offset_kind)
+     call mpi_file_read_at_all(thefile,disp,hgrids_old,3,mpi_double_precision,mpi_status_ignore,ierr)
+     disp=int(header(WF_BIN_H_OFF_RXYZ),kind=mpi_offset_kind)
+     call mpi_file_read_at_all(thefile,disp,rxyz_old,3*nat,mpi_double_precision,mpi_status_ignore,ierr)
+     recoff=f_malloc(int(header(WF_BIN_H_NORB))+1,id='recoff')
+     disp=int(header(WF_BIN_H_OFF_RECORDS),kind=mpi_offset_kind)
+     call mpi_file_read_at_all(thefile,disp,recoff,size(recoff),mpi_integer8,mpi_status_ignore,ierr)
+
+   END SUBROUTINE open_waves_linear_mpi
+
+
+   !> Read the descriptors of the record irec of a file opened with open_waves_linear_mpi,
+   !! the container counterpart of io_read_descr_linear. The keys of wfd are allocated here.
+   subroutine io_read_descr_linear_mpi(thefile,header,recoff,irec,iorb_old,eval,n_old1,n_old2,n_old3,&
+        ns_old1,ns_old2,ns_old3,onwhichatom,locrad,locregCenter,confPotOrder,confPotprefac,wfd)
+     use module_base
+     use yaml_output
+     use compression
+     implicit none
+     integer, intent(in) :: thefile,irec
+     integer(f_long), dimension(WF_BIN_NHEADER), intent(in) :: header
+     integer(f_long), dimension(:), intent(in) :: recoff
+     integer, intent(out) :: iorb_old,n_old1,n_old2,n_old3,ns_old1,ns_old2,ns_old3,onwhichatom,confPotOrder
+     real(wp), intent(out) :: eval
+     real(gp), intent(out) :: locrad,confPotprefac
+     real(gp), dimension(3), intent(out) :: locregCenter
+     type(wavefunctions_descriptors), intent(out) :: wfd
+     !Local variables
+     integer :: ierr,nseg
+     integer(kind=mpi_offset_kind) :: disp
+     integer, dimension(WF_LIN_NINT) :: idescr
+     real(gp), dimension(WF_LIN_NDBL) :: ddescr
+
+     if (irec < 1 .or. irec >= size(recoff)) then
+        call f_err_throw('The support function '//trim(yaml_toa(irec))//&
+             ' is not in the container',err_name='BIGDFT_RUNTIME_ERROR')
+        return
+     end if
+     disp=int(recoff(irec),kind=mpi_offset_kind)
+     call mpi_file_read_at(thefile,disp,ddescr,WF_LIN_NDBL,mpi_double_precision,mpi_status_ignore,ierr)
+     disp=disp+int(WF_LIN_NDBL*header(WF_BIN_H_SIZE_DOUBLE),kind=mpi_offset_kind)
+     call mpi_file_read_at(thefile,disp,idescr,WF_LIN_NINT,mpi_integer,mpi_status_ignore,ierr)
+     locregCenter=ddescr(1:3)
+     locrad=ddescr(4)
+     confPotprefac=ddescr(5)
+     eval=ddescr(6)
+     iorb_old=idescr(1)
+     n_old1=idescr(2)
+     n_old2=idescr(3)
+     n_old3=idescr(4)
+     ns_old1=idescr(5)
+     ns_old2=idescr(6)
+     ns_old3=idescr(7)
+     onwhichatom=idescr(8)
+     confPotOrder=idescr(9)
+     wfd%nseg_c=idescr(10)
+     wfd%nseg_f=idescr(11)
+     wfd%nvctr_c=idescr(12)
+     wfd%nvctr_f=idescr(13)
+     call allocate_wfd(wfd)
+     nseg=wfd%nseg_c+wfd%nseg_f
+     disp=disp+int(WF_LIN_NINT*header(WF_BIN_H_SIZE_INTEGER),kind=mpi_offset_kind)
+     call mpi_file_read_at(thefile,disp,wfd%keygloc,2*nseg,mpi_integer,mpi_status_ignore,ierr)
+     disp=disp+int(2*nseg*header(WF_BIN_H_SIZE_INTEGER),kind=mpi_offset_kind)
+     call mpi_file_read_at(thefile,disp,wfd%keyglob,2*nseg,mpi_integer,mpi_status_ignore,ierr)
+     disp=disp+int(2*nseg*header(WF_BIN_H_SIZE_INTEGER),kind=mpi_offset_kind)
+     call mpi_file_read_at(thefile,disp,wfd%keyvloc,nseg,mpi_integer,mpi_status_ignore,ierr)
+     disp=disp+int(nseg*header(WF_BIN_H_SIZE_INTEGER),kind=mpi_offset_kind)
+     call mpi_file_read_at(thefile,disp,wfd%keyvglob,nseg,mpi_integer,mpi_status_ignore,ierr)
+
+   END SUBROUTINE io_read_descr_linear_mpi
+
+
+   !> Read the coefficients of the record irec and expand them in the box of the locreg,
+   !! the container counterpart of read_psig. wfd comes from io_read_descr_linear_mpi.
+   subroutine read_psig_mpi(thefile,header,recoff,irec,wfd,n1,n2,n3,psig)
+     use module_base
+     use compression
+     implicit none
+     integer, intent(in) :: thefile,irec,n1,n2,n3
+     integer(f_long), dimension(WF_BIN_NHEADER), intent(in) :: header
+     integer(f_long), dimension(:), intent(in) :: recoff
+     type(wavefunctions_descriptors), intent(in) :: wfd
+     real(wp), dimension(0:n1,2,0:n2,2,0:n3,2), intent(out) :: psig
+     !Local variables
+     integer :: ierr,ncomp,iseg,jj,j0,j1,ii,i0,i1,i2,i3,i,jf
+     integer(kind=mpi_offset_kind) :: disp
+     real(wp), dimension(:), allocatable :: psi
+
+     ncomp=wfd%nvctr_c+7*wfd%nvctr_f
+     psi=f_malloc(ncomp,id='psi')
+     disp=int(recoff(irec+1)-ncomp*header(WF_BIN_H_SIZE_DOUBLE),kind=mpi_offset_kind)
+     call mpi_file_read_at(thefile,disp,psi,ncomp,mpi_double_precision,mpi_status_ignore,ierr)
+
+     call f_zero(psig)
+     do iseg=1,wfd%nseg_c+wfd%nseg_f
+        jj=wfd%keyvloc(iseg)
+        j0=wfd%keygloc(1,iseg)
+        j1=wfd%keygloc(2,iseg)
+        ii=j0-1
+        i3=ii/((n1+1)*(n2+1))
+        ii=ii-i3*(n1+1)*(n2+1)
+        i2=ii/(n1+1)
+        i0=ii-i2*(n1+1)
+        i1=i0+j1-j0
+        if (iseg <= wfd%nseg_c) then
+           do i=i0,i1
+              psig(i,1,i2,1,i3,1)=psi(i-i0+jj)
+           end do
+        else
+           do i=i0,i1
+              jf=wfd%nvctr_c+7*(i-i0+jj-1)
+              psig(i,2,i2,1,i3,1)=psi(jf+1)
+              psig(i,1,i2,2,i3,1)=psi(jf+2)
+              psig(i,2,i2,2,i3,1)=psi(jf+3)
+              psig(i,1,i2,1,i3,2)=psi(jf+4)
+              psig(i,2,i2,1,i3,2)=psi(jf+5)
+              psig(i,1,i2,2,i3,2)=psi(jf+6)
+              psig(i,2,i2,2,i3,2)=psi(jf+7)
+           end do
+        end if
+     end do
+
+     call f_free(psi)
+
+   END SUBROUTINE read_psig_mpi
+
+
+   !> Size in bytes of a record of write_waves_linear_mpi
+   pure function wf_lin_record_size(wfd,size_of_integer,size_of_double) result(rsize)
+     use compression, only: wavefunctions_descriptors
+     implicit none
+     type(wavefunctions_descriptors), intent(in) :: wfd
+     integer(f_long), intent(in) :: size_of_integer,size_of_double
+     integer(f_long) :: rsize
+     rsize=wf_bin_aligned(WF_LIN_NDBL*size_of_double+&
+          (WF_LIN_NINT+6*int(wfd%nseg_c+wfd%nseg_f,f_long))*size_of_integer,8_f_long)+&
+          int(wfd%nvctr_c+7*wfd%nvctr_f,f_long)*size_of_double
+   end function wf_lin_record_size
+
+
+   !> Round an offset in the wavefunction container up to a multiple of align
+   pure function wf_bin_aligned(offset,align) result(aligned)
+     implicit none
+     integer(f_long), intent(in) :: offset,align
+     integer(f_long) :: aligned
+     aligned=((offset+align-1)/align)*align
+   end function wf_bin_aligned
+
+
 end module io
@@ -357,6 +357,8 @@ subroutine energyandforces_bmhtf(nat,rat,fat,epot)
     hspinv=1.0_gp/hsp
     !write(*,*) 'inside shortenergy  hsp=',hsp
     epot=0.0_gp;fat=0.0_gp
+    !all the pairs are needed: the spline includes the Coulomb terms up to
+    !the largest distance of the cell (see preparespline), so no Verlet list
     do iat=1,nat
         xiat=rat(1,iat);yiat=rat(2,iat);ziat=rat(3,iat)
         do jat=iat+1,nat
@@ -7,11 +7,20 @@
 
 
 module module_lj
+    use module_defs, only: gp
+    use module_verlet
     implicit none
     private
 
+    !> cutoff of the truncated potential, 0 for the full one
+    real(gp), save :: rcut=0.0_gp
+    real(gp), save :: eshift=0.0_gp
+    !> pairs within the cutoff, kept from one call to the other
+    type(verlet_list), save :: pairs
+
     public lenjon
     public init_lj
+    public finalize_lj
 
 contains
 !=====================================================================
@@ -39,6 +48,14 @@ subroutine init_lj(paramset,paramfile,units)
         select case(trim(paramset))
         case('default')
            if (bigdft_mpi%iproc ==0) call yaml_comment('Using normalized Units for LJ (sigma=1, epsilon=1)')
+           rcut=0.0_gp
+           eshift=0.0_gp
+        case('truncated')
+           if (bigdft_mpi%iproc ==0) call yaml_comment('Using normalized Units for LJ (sigma=1, epsilon=1),'//&
+                ' truncated and shifted at 2.5 sigma')
+           rcut=2.5_gp
+           eshift=4.0_gp*(rcut**(-12)-rcut**(-6))
+           call verlet_list_set(pairs,rcut,0.3_gp,half=.true.)
         case default
             call f_err_throw('Following parameter set for LJ force field '//&
                 'is unknown: '//trim(paramset))
@@ -46,8 +63,14 @@ subroutine init_lj(paramset,paramfile,units)
     endif
 end subroutine
 !=====================================================================
+subroutine finalize_lj()
+    implicit none
+    call deallocate_verlet_list(pairs)
+end subroutine finalize_lj
+!=====================================================================
 subroutine lenjon(nat,rxyz,fxyz,epot)
     use module_defs, only: gp
+    use at_domain, only: domain,domain_new,ATOMIC_UNITS,geocode_to_bc_enum
     !energy and forces for Lennard Jones potential
     !input: nat: number of atoms
     !       rxyz: positions of atoms
@@ -61,15 +84,48 @@ subroutine lenjon(nat,rxyz,fxyz,epot)
     real(gp), intent(out) :: fxyz(3,nat)
     real(gp), intent(out) :: epot
     !internal
-    integer :: iat, jat
+    integer :: iat, jat, k
     real(gp) :: dx,dy,dz,dd,dd2,dd6,dd12,tt,t1,t2,t3
     real(gp) :: xiat, yiat, ziat
+    type(domain) :: dom
 
     epot=0.d0
     do iat=1,nat
         fxyz(1,iat)=0.d0 ; fxyz(2,iat)=0.d0 ; fxyz(3,iat)=0.d0
     enddo
 
+    if (rcut > 0.0_gp) then
+        dom=domain_new(units=ATOMIC_UNITS,bc=geocode_to_bc_enum('F'))
+        call verlet_list_update(pairs,dom,nat,rxyz)
+        !$omp parallel default(private) shared(nat, rxyz, fxyz, epot, pairs, rcut, eshift)
+        !$omp do schedule(dynamic) reduction(+:fxyz,epot)
+        do iat=1,nat
+            xiat=rxyz(1,iat);yiat=rxyz(2,iat) ;ziat=rxyz(3,iat)
+            do k=pairs%keynei(2,iat),pairs%keynei(2,iat)+pairs%keynei(1,iat)-1
+                jat=pairs%nei(k)
+                dx=xiat-rxyz(1,jat)
+                dy=yiat-rxyz(2,jat)
+                dz=ziat-rxyz(3,jat)
+                dd=dx**2+dy**2+dz**2
+                if (dd >= rcut**2) cycle
+                dd2=1.d0/dd
+                dd6=dd2*dd2*dd2
+                dd12=dd6*dd6
+                epot=epot+4.d0*(dd12-dd6)-eshift
+                tt=24.d0*dd2*(2.d0*dd12-dd6)
+                t1=dx*tt ; t2=dy*tt ; t3=dz*tt
+                fxyz(1,iat)=fxyz(1,iat)+t1 ; fxyz(1,jat)=fxyz(1,jat)-t1
+                fxyz(2,iat)=fxyz(2,iat)+t2 ; fxyz(2,jat)=fxyz(2,jat)-t2
+                fxyz(3,iat)=fxyz(3,iat)+t3 ; fxyz(3,jat)=fxyz(3,jat)-t3
+            enddo
+        enddo
+        !$omp end do
+        !$omp end parallel
+        return
+    end if
+
+    !the default set is the untruncated potential: every pair interacts,
+    !there is no cutoff to build a Verlet list on
     !$omp parallel default(private) shared(nat, rxyz, fxyz, epot)
     !$omp do schedule(dynamic) reduction(+:fxyz,epot)
     do iat=1,nat
@@ -34,10 +34,15 @@
 !  
 !  rho is the inverse width of the well. rcut is the cutoff.
 !
+!  The pairs are taken from a Verlet list and every periodic image within
+!  the cutoff is counted. For cells shorter than twice the cutoff this
+!  differs from the former closest image sum, and a warning is emitted.
+!
 !*************************************************************************
 !
 module module_morse_bulk
     use module_base
+    use module_verlet
     implicit none
 
     !default private
@@ -54,11 +59,18 @@ module module_morse_bulk
     logical,save :: initialized_slab=.false.
 
     real(gp), save :: alat_int(3)
+    !> last cell checked against the cutoff
+    real(gp), save :: alat_checked(3)=0.0_gp
+
+    !> pairs within the cutoff, kept from one call to the other
+    type(verlet_list), save :: pairs
+    real(gp), parameter :: skin=1.0_gp
 
     public morse_bulk_wrapper
     public init_morse_bulk
     public morse_slab_wrapper
     public init_morse_slab
+    public finalize_morse_bulk
     contains 
 subroutine init_morse_slab(paramset,paramfile,geocode,units)
     use module_base
@@ -147,6 +159,7 @@ subroutine init_morse_slab(paramset,paramfile,geocode,units)
     if (rcut / R0 < 1.e-1_gp .and. bigdft_mpi%iproc==0) then
        call yaml_warning('morse_bulk: warning the cutoff is very small')
     endif
+    call verlet_list_set(pairs,rcut,skin,half=.true.)
 end subroutine init_morse_slab
 subroutine init_morse_bulk(paramset,paramfile,geocode)
     use module_base
@@ -201,7 +214,12 @@ subroutine init_morse_bulk(paramset,paramfile,geocode)
     if (rcut / R0 < 1.e-1_gp .and. bigdft_mpi%iproc==0) then
        call yaml_warning('morse_bulk: warning the cutoff is very small')
     endif
+    call verlet_list_set(pairs,rcut,skin,half=.true.)
 end subroutine init_morse_bulk
+subroutine finalize_morse_bulk()
+    implicit none
+    call deallocate_verlet_list(pairs)
+end subroutine finalize_morse_bulk
 subroutine morse_slab_wrapper(nat,alat,rxyz, fxyz, epot)
     use module_base
     implicit none 
@@ -245,33 +263,74 @@ SUBROUTINE MORSE_BULK(X,V,EMORSE, natoms, rho, R0, A, periodic, &
       ! R0 is the position of the bottom of the well
       ! rho is the width of the well and has units of inverse length
       ! A is the energy scale
+      ! With the cutoff, the pairs (and all their periodic images) are taken
+      ! from the Verlet list, otherwise from the closest images.
+      use at_domain, only: domain,domain_new,ATOMIC_UNITS,geocode_to_bc_enum
+      use yaml_output, only: yaml_warning
       implicit none 
       logical, intent(in) :: periodic, use_cutoff
       integer, intent(in) :: NATOMS
       real(gp), intent(in) :: X(3*NATOMS), rho, R0, A, boxvec(3), rcut
       real(gp), intent(out) :: V(3*NATOMS), EMORSE
-      integer ::  J1, J2, J3, J4
+      integer ::  J1, J2, J3, J4, K
       real(gp) :: DIST, R, DUMMY, &
-                       RR(NATOMS,NATOMS), &
                        XMUL2, iboxvec(3), dx(3), eshift
+      type(domain) :: dom
       if (periodic) iboxvec(:) = 1.0_gp / boxvec(:)
 
       if (use_cutoff) then
          Eshift = (1.0_gp - exp(rho * (r0 - rcut)))**2 - 1.0_gp
          !write(*,*) "Eshift", eshift, rcut
+         if (periodic) then
+            dom=domain_new(units=ATOMIC_UNITS,bc=geocode_to_bc_enum('P'),acell=boxvec)
+         else
+            dom=domain_new(units=ATOMIC_UNITS,bc=geocode_to_bc_enum('F'),acell=boxvec)
+         end if
+         call verlet_list_update(pairs,dom,natoms,X)
+         if (periodic .and. any(boxvec /= alat_checked)) then
+            alat_checked=boxvec
+            if (any(boxvec < 2.0_gp*rcut) .and. bigdft_mpi%iproc==0) &
+                 call yaml_warning('morse_bulk: cell shorter than twice the cutoff, '//&
+                 'all the periodic images within the cutoff are counted')
+         end if
       else
         Eshift=0.0_gp
       endif
 
       V(:) = 0.0_gp
       EMORSE=0.0_gp
+      if (use_cutoff) then
+         !$omp parallel do default(private) shared(natoms, x, pairs, &
+         !$omp RHO, R0, rcut, Eshift, A) &
+         !$omp schedule(dynamic) reduction(+:V,emorse)
+         DO J1=1,NATOMS
+            J3=3*J1
+            DO K=pairs%keynei(2,J1),pairs%keynei(2,J1)+pairs%keynei(1,J1)-1
+               J2=pairs%nei(K)
+               J4=3*J2
+               dx(:) = -verlet_pair(pairs,natoms,X,J1,K)
+               dist = max(sqrt(sum(dx**2)), 1.0e-5_gp)
+
+               if (dist.ge.rcut) cycle
+
+               R=exp(RHO*R0-RHO*DIST)
+               DUMMY=R*(R-2.0_gp)
+               EMORSE=EMORSE+DUMMY - Eshift
+               xmul2 = 2.0_gp*R*(R-1.0_gp)/DIST * A
+               V(J3-2:j3) = V(j3-2:j3) + xmul2 * dx
+               V(J4-2:j4) = V(j4-2:j4) - xmul2 * dx
+            ENDDO
+         ENDDO
+         !$omp end parallel do
+         EMORSE = EMORSE * A
+         RETURN
+      end if
+
       !$omp parallel default(private) shared(natoms, x, V, emorse, &
-      !$omp boxvec, iboxvec, RHO, R0, periodic, use_cutoff, rcut, &
-      !$omp Eshift, A)
+      !$omp boxvec, iboxvec, RHO, R0, periodic, Eshift, A)
       !$omp do schedule(dynamic) reduction(+:V,emorse)
       DO J1=1,NATOMS
          J3=3*J1
-         RR(J1,J1)=0.0_gp
          DO J2=J1+1,NATOMS
             J4=3*J2
             dx(:) = X(J3-2:j3)-X(J4-2:j4)
@@ -280,8 +339,6 @@ SUBROUTINE MORSE_BULK(X,V,EMORSE, natoms, rho, R0, A, periodic, &
             endif
             dist = max(sqrt(sum(dx**2)), 1.0e-5_gp)
 
-            if (use_cutoff .and. dist.ge.rcut) cycle
-
             R=exp(RHO*R0-RHO*DIST)
             DUMMY=R*(R-2.0_gp)
             EMORSE=EMORSE+DUMMY - Eshift
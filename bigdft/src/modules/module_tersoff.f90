@@ -8,11 +8,13 @@
 !!    For the list of contributors, see ~/AUTHORS
 module module_tersoff
   use module_base
+  use module_verlet
   implicit none
 
   private
   public :: tersoff
   public :: init_tersoff
+  public :: finalize_tersoff
 
      integer, parameter :: natmax=5000
      real(gp), save :: rcut1(2,2)         !cutoff
@@ -20,6 +22,9 @@ module module_tersoff
      integer, save :: Kinds_tersoff(natmax)   !Kinds, 1 for carbon and 2 for silicon
      logical, save :: only_c
      logical, save :: initialized_tersoff=.false.
+     !> pairs within the cutoff, kept from one call to the other
+     type(verlet_list), save :: pairs
+     real(gp), parameter :: skin=0.5_gp
 
 
 
@@ -61,12 +66,20 @@ do iat=1,nat
      stop "Tersoff only allowed for Silicon and/or Carbon atoms"
    endif
 enddo
+!the cutoff of the Verlet list is set at the first call
+call verlet_list_set(pairs,0.0_gp,skin)
 end subroutine
 
+subroutine finalize_tersoff()
+implicit none
+call deallocate_verlet_list(pairs)
+end subroutine finalize_tersoff
+
 !        subroutine energyandforces_per(nat,latvec,rxyz,fxyz,stress,pressure,etot,count)
 !subroutine tersoff(nat,latvec_bohr,rxyz,fxyz,strten,etot)
 subroutine tersoff(nat,cell,rxyzIN,fxyz,strten,etot)
 use module_base
+use at_domain, only: domain,domain_new,ATOMIC_UNITS,geocode_to_bc_enum
         implicit none
         integer, intent(in) :: nat
 !        integer   :: iat
@@ -121,6 +134,7 @@ use module_base
       real(gp):: tmplat(3,3)
       real(gp), ALLOCATABLE, DIMENSION(:,:) :: rel
       integer:: alpha, beta, a
+      type(domain) :: dom
 !        if(.not.allocated(Kinds_tersoff)) stop "Allocate Kinds before calling energyandforces"
 !        pi=dacos(-1.0_gp)
 
@@ -141,22 +155,24 @@ use module_base
 !        call rxyz_int2cart(latvec,xred,rxyz,nat)
 
 
-        nnbrx=64
-        nnbrxt=3*nnbrx/2
-        nnmax=nnbrxt*nat
-        npmax=nnbrxt*nat
-        allocate(XYZRrefdf(1:6*Npmax), UadUrdf(1:3*Npmax), dkEij(1:3*NNmax))
-        allocate(lsta(2,nat),lstb(nnbrx*nat),rel(5,nnbrx*nat))
-!        do i=1,nat
-!          kinds(i)=2
-!        enddo
         fxyz=0.0_gp
         call Parameters_per(R1,R2,Cr,Ca,alr,ala,X,Pn,Co_bcd,bcsq,dsq,h,Pmass)
         cut=R2(2,2)-1.e-3_gp
         if(only_c) cut=R2(1,1)-1.e-3_gp
         trans=latvec
         call invertmat(trans,transinv,3)
-        call makepairlist(lsta,lstb,rel,nat,rxyz,latvec,cut,nnbrx)
+        !the Verlet list is in Bohr
+        if (pairs%rcut /= cut/Bohr_Ang) call verlet_list_set(pairs,cut/Bohr_Ang,skin)
+        dom=domain_new(units=ATOMIC_UNITS,bc=geocode_to_bc_enum('P'),acell=cell)
+        call verlet_list_update(pairs,dom,nat,rxyzIN)
+
+        nnbrx=max(64,maxval(pairs%keynei(1,:)))
+        nnbrxt=3*nnbrx/2
+        nnmax=nnbrxt*nat
+        npmax=nnbrxt*nat
+        allocate(XYZRrefdf(1:6*Npmax), UadUrdf(1:3*Npmax), dkEij(1:3*NNmax))
+        allocate(lsta(2,nat),lstb(nnbrx*nat),rel(5,nnbrx*nat))
+        call verletpairlist(lsta,lstb,rel,nat,rxyzIN)
 !end of creating pairlist part---------------------------------------------------------
 
 !start calculating forces and energy
@@ -314,9 +330,10 @@ subroutine subeniat_t(i,Nmol,Npmax,NNmax,X,R,R1,R2,Cr,Ca,alr,ala,XYZRrefdf,UadUr
       real(gp), intent(in),     dimension(1:2,1:2)  :: Cr, Ca, alr, ala
       real(gp), intent(in),     dimension(1:2,1:2)  :: X
 
-      real(gp)   , intent(out), dimension(1:6*Npmax):: XYZRrefdf
-      real(gp)   , intent(out), dimension(1:3*Npmax):: UadUrdf
-      real(gp)   , intent(out):: Urtot
+      !accumulated over the calls for each atom i
+      real(gp)   , intent(inout), dimension(1:6*Npmax):: XYZRrefdf
+      real(gp)   , intent(inout), dimension(1:3*Npmax):: UadUrdf
+      real(gp)   , intent(inout):: Urtot
 
       real(gp) Ur, Ua
 
@@ -427,8 +444,9 @@ subroutine subfiat_t(i,Nmol,Npmax,NNmax,Pn,Co_bcd,bcsq,dsq,h,XYZRrefdf,UadUrdf,F
       real(gp),   intent(in),dimension(1:6*Npmax)::XYZRrefdf
       real(gp),   intent(in),dimension(1:3*Npmax)::UadUrdf
 
-      real(gp), intent(out),   dimension(1:3*Nmol)::F
-      real(gp), intent(out) :: Uatot
+      !accumulated over the calls for each atom i
+      real(gp), intent(inout), dimension(1:3*Nmol)::F
+      real(gp), intent(inout) :: Uatot
       real(gp), dimension(1:3*NNmax)::dkEij
       integer i
       integer Ki
@@ -682,572 +700,39 @@ integer:: nat
 Fout=Fin
 end subroutine
 
- subroutine reliatp(cut,relinteriat,lstbiat,rxyz,rxyzp,nat,iat,ninter,nmax)
- !This subroutine will calculate neighbors of atom iat within the given periodic image cell and the relative coordinates
- !The relative informations are stored in relinteriat
- !The atomic index jat is stored in lstbiat
- !rxyz holds the positions of iat, rxyzp is one of the periodic images to check
- !d2plane,d2corner,d2egde hold the distance of atom iat to the walls of the cell
- real*8, intent(inout)  :: relinteriat(5,nmax)
- real*8, intent(in)     :: rxyz(3,nat),rxyzp(3,nat),cut
- integer, intent(in)    :: nat,iat,nmax
- integer, intent(inout) :: ninter,lstbiat(nmax)
- real*8                 :: cut2,xrel,yrel,zrel,rr2,tt,tti
- integer                :: jat,Ki,Kj
- Ki=Kinds_tersoff(iat)
-! cut2=cut*cut
- do jat=1,nat
- Kj=Kinds_tersoff(jat)
- cut2=(rcut2(Ki,Kj)-1.d-8)*(rcut2(Ki,Kj)-1.d-8)
- xrel= rxyz(1,iat)-rxyzp(1,jat)
- yrel= rxyz(2,iat)-rxyzp(2,jat)
- zrel= rxyz(3,iat)-rxyzp(3,jat)
- rr2=xrel**2 + yrel**2 + zrel**2
-! if (rr2.le.cut2 .AND. iat.ne.jat) then
- if (rr2.lt.cut2 .AND. rr2.ne.0.0_gp) then
-! write(*,*) xrel,yrel,zrel
-  ninter=ninter+1
-  if (ninter.gt.nmax) stop 'nmax exceeded'
-  lstbiat(ninter)=jat
-  tt=dsqrt(rr2)
-  tti=1.0_gp/tt
-  relinteriat(1,ninter)=xrel*tti
-  relinteriat(2,ninter)=yrel*tti
-  relinteriat(3,ninter)=zrel*tti
-  relinteriat(4,ninter)=tt
-  relinteriat(5,ninter)=tti
-
-!  write(*,*) 'Inside reliatp,jat found',jat,tt
- endif
- enddo
-
-
- return
- end subroutine
-
-
-
-!********************************************************
-
- subroutine makepairlist(lsta,lstb,rel,nat,rxyz,latvec,cut,nmax)
- !This subroutine will construct the pairlist lsta and lstb of the atomic positions rxyz in the cell latvec
- !The cutoff is given with cut, all relative coordinates are stored in rel
- implicit none
- integer, intent(in) :: nat
- integer, intent(inout) :: lsta(2,nat),lstb(nat*nmax),nmax
- real*8, intent(inout)  :: rel(5,nat*nmax)
- real*8, intent(in)     :: cut, rxyz(3,nat), latvec(3,3)
- real*8                 :: rxyzexp(3,nat,3,3,3),relinteriat(5,nmax),transvecall(3,3,3,3)
- integer                :: iat,lstbiat(nmax),infocode,ninter,k,l,m
-
- call expand(rxyz,rxyzexp,transvecall,latvec,nat)
- do iat=1,nat
- ninter=0
-    lstbiat=0
-    relinteriat=0.0_gp
-    call findinter(iat,nat,lstbiat,cut,rxyz,rxyzexp,transvecall,latvec,ninter,nmax,relinteriat,infocode)
-    lsta(1,iat)=(iat-1)*nmax+1
-    lsta(2,iat)=(iat-1)*nmax+ninter
-    lstb(lsta(1,iat):lsta(1,iat)+nmax-1)=lstbiat(:)
-    rel(:,lsta(1,iat):lsta(1,iat)+nmax-1)=relinteriat(:,:)
- enddo
-
-! do iat=1,nat
-!    k=lsta(1,iat)
-!    l=lsta(2,iat)
-!    do m=k,l
-!    write(*,*) iat,lstb(m),m
-!    enddo
-! enddo
-end subroutine
-
-
-!**************************************************************************************
- subroutine findinter(iat,nat,lstbiat,cut,rxyz,rxyzexp,transvecall,latvec,ninter,nmax,relinteriat,infocode)
- !This subroutine will find all neighboring atoms of atom iat including those in periodic
- !images within the range of cut. The cell is described by latvec[v1,v2,v3]. rxyz holds the
- !coordinates of all atoms, nat is the number of atoms. The output ist ninter=the number of
- !atoms in the list of neighbors. Relative coordinates are stored in relinter,
- !the index of the interactiong atoms in lstbiat. rxyz holds the pos of all periodic images
- !infocode vill return 1 if an error occured and the number of neighbors exceeds nmax, else 0
- real*8,  intent(in)  :: rxyz(3,nat), latvec(3,3), cut, rxyzexp(3,nat,3,3,3),transvecall(3,3,3,3)
- real*8, intent(inout):: relinteriat(5,nmax)
- integer, intent(in)  :: iat,nat,nmax
- integer,intent(inout):: ninter,infocode,lstbiat(nmax)
- real(gp)              :: a(3),b(3),crossp(3),d2plane(6),d2corner(gp),d2edge(12),d2all(3,3,3),ppoint0(3),tempvec(3)
- real(gp)              :: nvectmp(3),pointtmp(3),ppointtmp(3),latvectmp(3),dist,nvec(3,3),cutplus
- real(gp)              :: tempvece(3,3,3,3,2),tempvecp(3,3,3,3,2)
- integer              :: k,l,m,summe,kt,lt,mt
- real(gp)              :: rxyzp(3,nat)
- !For second nearest images
- real(gp),allocatable  :: d2all_2(:,:,:),rxyzexp_2(:,:,:,:,:),transvecall_2(:,:,:,:)
- !For third nearest images
- real(gp),allocatable  :: d2all_3(:,:,:),rxyzexp_3(:,:,:,:,:),transvecall_3(:,:,:,:)
- !For the fourth nearest images
- real(gp),allocatable  :: d2all_4(:,:,:),rxyzexp_4(:,:,:,:,:),transvecall_4(:,:,:,:)
- real(gp)              :: dx2,dy2,dz2,dd2,cut2,aa,bb,thrd
- integer              :: k1,l1,m1
- real(gp)              :: dproj(6),rotmat(3,3)
- logical              :: nec
-
-
- ninter=0
- ppoint0=(/0.0_gp,0.0_gp,0.0_gp/)
- cutplus=cut+cut*0.01_gp
- d2all=cutplus
- tempvece=0.0_gp
-
- call nveclatvec(latvec,nvec)
-    !Bottom
-    call dist2plane(rxyz(:,iat),nvec(:,1),transvecall(:,1,1,2),dist)
-    d2all(:,:,1)=dist
-    !Top
-    call dist2plane(rxyz(:,iat),nvec(:,1),transvecall(:,1,1,3),dist)
-    d2all(:,:,3)=dist
-
-    !Back
-    call dist2plane(rxyz(:,iat),nvec(:,2),transvecall(:,2,1,1),dist)
-    d2all(1,:,:)=dist
-    !Front
-    call dist2plane(rxyz(:,iat),nvec(:,2),transvecall(:,3,1,1),dist)
-    d2all(3,:,:)=dist
-
-    !Left
-    call dist2plane(rxyz(:,iat),nvec(:,3),transvecall(:,1,2,1),dist)
-    d2all(:,1,:)=dist
-    !Right
-    call dist2plane(rxyz(:,iat),nvec(:,3),transvecall(:,1,3,1),dist)
-    d2all(:,3,:)=dist
-
-
- d2all(2,2,2)=0.0_gp !Always calculate in original cell
- !Calculate all information of relinter for atoms within the cell
- ninter=0
- do k=1,3
-  do l=1,3
-   do m=1,3
-      if (d2all(k,l,m).lt.cut) then
-
-      rxyzp(:,:)=rxyzexp(:,:,k,l,m)
-!      write(*,*) 'calling reliatp' ,iat,k,l,m
-!      write(*,*) "ninter1",ninter
-      call reliatp(cut,relinteriat,lstbiat,rxyz,rxyzp,nat,iat,ninter,nmax)
-!      write(*,*) "ninter2",ninter
-      endif
-   enddo
-  enddo
- enddo
- infocode=0
-! write(*,*) 'all well'
-
-! return
-
- !If second layer necessary
- !Call subroutine to check here...
- call check_rep(latvec,cut,nec)
- if(nec) then
-    return
- else
-!    write(*,*) "entering layer 2"
-    allocate(d2all_2(5,5,5),rxyzexp_2(3,nat,5,5,5),transvecall_2(3,5,5,5))
-    call expand_2(rxyz,rxyzexp_2,transvecall_2,latvec,nat)
-! call latvec2dproj(dproj,latvec,rotmat,rxyz,nat)
-! open(unit=12,file="secondexp.ascii")
-! write(12,*) nat
-! write(12,*) dproj(1),dproj(2),dproj(3)
-! write(12,*) dproj(4),dproj(5),dproj(6)
-! do k=1,5
-! do l=1,5
-! do m=1,5
-! do jat=1,nat
-! write(12,*) rxyzexp_2(:,jat,k,l,m),"au"
-! enddo
-! enddo
-! enddo
-! enddo
-! close(12)
-!!! stop
-
-    d2all_2=cutplus
-    !Calculate interaction with second nearest cells.
-    !Check planes
-    !Bottom
-    call dist2plane(rxyz(:,iat),nvec(:,1),transvecall_2(:,1,1,2),dist)
-    d2all_2(:,:,1)=dist
-    !Top
-    call dist2plane(rxyz(:,iat),nvec(:,1),transvecall_2(:,1,1,5),dist)
-    d2all_2(:,:,5)=dist
-
-    !Back
-    call dist2plane(rxyz(:,iat),nvec(:,2),transvecall_2(:,2,1,1),dist)
-    d2all_2(1,:,:)=dist
-    !Front
-    call dist2plane(rxyz(:,iat),nvec(:,2),transvecall_2(:,5,1,1),dist)
-    d2all_2(5,:,:)=dist
-
-    !Left
-    call dist2plane(rxyz(:,iat),nvec(:,3),transvecall_2(:,1,2,1),dist)
-    d2all_2(:,1,:)=dist
-    !Right
-    call dist2plane(rxyz(:,iat),nvec(:,3),transvecall_2(:,1,5,1),dist)
-    d2all_2(:,5,:)=dist
-
-
-!    !Substract corners
-!    bb=5.0_gp*(1.0_gp-4.0_gp/3.0_gp)
-!    aa=4.0_gp/3.0_gp
-!    cut2=cut*cut
-!    do k=2,5,3
-!       do l=2,5,3
-!          do m=2,5,3
-!          dx2=rxyz(1,iat)-transvecall_2(1,k,l,m)
-!          dx2=dx2*dx2
-!          dy2=rxyz(2,iat)-transvecall_2(2,k,l,m)
-!          dy2=dy2*dy2
-!          dz2=rxyz(3,iat)-transvecall_2(3,k,l,m)
-!          dz2=dz2*dz2
-!          dd2=dx2+dy2+dz2
-!             if(dd2.gt.cut2) then
-!              k1=int(bb+aa*real(k,8))
-!              l1=int(bb+aa*real(l,8))
-!              m1=int(bb+aa*real(m,8))
-!              d2all_2(k1,l1,m1)=cutplus
-!             endif
-!          enddo
-!       enddo
-!    enddo
-
-    do k=1,5
-     do l=1,5
-      do m=1,5
-         if (d2all_2(k,l,m).ge.cut) then
-         goto 1010
-         else
-         rxyzp(:,:)=rxyzexp_2(:,:,k,l,m)
-   !      write(*,*) 'calling reliatp' ,iat,k,l,m
-         call reliatp(cut,relinteriat,lstbiat,rxyz,rxyzp,nat,iat,ninter,nmax)
-         endif
-         1010 continue
-      enddo
-     enddo
-    enddo
-    infocode=0
-    deallocate(d2all_2,rxyzexp_2,transvecall_2)
-    nec=.false.
-    call check_rep(latvec,1.0_gp/2.0_gp*cut,nec)
-
-    if(nec) then
-       return
-    else
-
-!    write(*,*) "entering layer 3"
-       !Calculate third layer of periodic images if necessary
-       allocate(d2all_3(7,7,7),rxyzexp_3(3,nat,7,7,7),transvecall_3(3,7,7,7))
-       call expand_3(rxyz,rxyzexp_3,transvecall_3,latvec,nat)
-! call latvec2dproj(dproj,latvec,rotmat,rxyz,nat)
-! open(unit=12,file="secondexp3.ascii")
-! write(12,*) nat
-! write(12,*) dproj(1),dproj(2),dproj(3)
-! write(12,*) dproj(4),dproj(5),dproj(6)
-! do k=1,7
-! do l=1,7
-! do m=1,7
-! do jat=1,nat
-! write(12,*) rxyzexp_3(:,jat,k,l,m),"au"
-! enddo
-! enddo
-! enddo
-! enddo
-! close(12)
-! stop
-
-
-!       write(*,*) "after expand 3"
-       d2all_3=cutplus
-       !Calculate interaction with third nearest cells.
-       !Check planes
-       !Bottom
-       call dist2plane(rxyz(:,iat),nvec(:,1),transvecall_3(:,1,1,2),dist)
-       d2all_3(:,:,1)=dist
-       !Top
-       call dist2plane(rxyz(:,iat),nvec(:,1),transvecall_3(:,1,1,7),dist)
-       d2all_3(:,:,7)=dist
-
-       !Back
-       call dist2plane(rxyz(:,iat),nvec(:,2),transvecall_3(:,2,1,1),dist)
-       d2all_3(1,:,:)=dist
-       !Front
-       call dist2plane(rxyz(:,iat),nvec(:,2),transvecall_3(:,7,1,1),dist)
-       d2all_3(7,:,:)=dist
-
-       !Left
-       call dist2plane(rxyz(:,iat),nvec(:,3),transvecall_3(:,1,2,1),dist)
-       d2all_3(:,1,:)=dist
-       !Right
-       call dist2plane(rxyz(:,iat),nvec(:,3),transvecall_3(:,1,7,1),dist)
-       d2all_3(:,7,:)=dist
-
-
-!       !Substract corners
-!       bb=7.0_gp*(1.0_gp-6.0_gp/5.0_gp)
-!       aa=6.0_gp/5.0_gp
-!       cut2=cut*cut
-!       do k=2,7,5
-!          do l=2,7,5
-!             do m=2,7,5
-!             dx2=rxyz(1,iat)-transvecall_3(1,k,l,m)
-!             dx2=dx2*dx2
-!             dy2=rxyz(2,iat)-transvecall_3(2,k,l,m)
-!             dy2=dy2*dy2
-!             dz2=rxyz(3,iat)-transvecall_3(3,k,l,m)
-!             dz2=dz2*dz2
-!             dd2=dx2+dy2+dz2
-!                if(dd2.gt.cut2) then
-!                 k1=int(bb+aa*real(k,8))
-!                 l1=int(bb+aa*real(l,8))
-!                 m1=int(bb+aa*real(m,8))
-!                 d2all_3(k1,l1,m1)=cutplus
-!                endif
-!             enddo
-!          enddo
-!       enddo
-
-       do k=1,7
-        do l=1,7
-         do m=1,7
-            if (d2all_3(k,l,m).ge.cut) then
-            goto 1011
-            else
-            rxyzp(:,:)=rxyzexp_3(:,:,k,l,m)
-      !      write(*,*) 'calling reliatp' ,iat,k,l,m
-            call reliatp(cut,relinteriat,lstbiat,rxyz,rxyzp,nat,iat,ninter,nmax)
-            endif
-            1011 continue
-         enddo
-        enddo
-       enddo
-       infocode=0
-       deallocate(d2all_3,rxyzexp_3,transvecall_3)
-       nec=.false.
-       call check_rep(latvec,1.0_gp/3.0_gp*cut,nec)
-       if(nec) then
-       return
-       else
-          !Calculate fourth layer of periodic images if necessary
-          allocate(d2all_4(9,9,9),rxyzexp_4(3,nat,9,9,9),transvecall_4(3,9,9,9))
-          call expand_4(rxyz,rxyzexp_4,transvecall_4,latvec,nat)
-          d2all_4=cutplus
-          !Calculate interaction with fourth nearest cells.
-          !Check planes
-          !Bottom
-          call dist2plane(rxyz(:,iat),nvec(:,1),transvecall_4(:,1,1,2),dist)
-          d2all_4(:,:,1)=dist
-          !Top
-          call dist2plane(rxyz(:,iat),nvec(:,1),transvecall_4(:,1,1,9),dist)
-          d2all_4(:,:,9)=dist
-
-          !Back
-          call dist2plane(rxyz(:,iat),nvec(:,2),transvecall_4(:,2,1,1),dist)
-          d2all_4(1,:,:)=dist
-          !Front
-          call dist2plane(rxyz(:,iat),nvec(:,2),transvecall_4(:,9,1,1),dist)
-          d2all_4(9,:,:)=dist
-
-          !Left
-          call dist2plane(rxyz(:,iat),nvec(:,3),transvecall_4(:,1,2,1),dist)
-          d2all_4(:,1,:)=dist
-          !Right
-          call dist2plane(rxyz(:,iat),nvec(:,3),transvecall_4(:,1,9,1),dist)
-          d2all_4(:,9,:)=dist
-
-
-          do k=1,9
-           do l=1,9
-            do m=1,9
-               if (d2all_4(k,l,m).ge.cut) then
-               goto 1012
-               else
-               rxyzp(:,:)=rxyzexp_4(:,:,k,l,m)
-         !      write(*,*) 'calling reliatp' ,iat,k,l,m
-               call reliatp(cut,relinteriat,lstbiat,rxyz,rxyzp,nat,iat,ninter,nmax)
-               endif
-               1012 continue
-            enddo
-           enddo
-          enddo
-          infocode=0
-          deallocate(d2all_4,rxyzexp_4,transvecall_4)
-          nec=.false.
-          call check_rep(latvec,1.0_gp/4.0_gp*cut,nec)
-          if (nec) then
-          return
-          else
-          write(*,*)  "Cell periodicit exceeded the fourth order"
-          stop
-          endif
-      endif
-
-    endif
-
-
- endif
-
- end subroutine
-
- subroutine expand(rxyz,rxyzout,transvecall,latvec,nat)
- !This subroutine will expand the unit cell into 26 periodic cells and store them in rxyzout
- implicit none
- real*8, intent(in)  :: rxyz(3,nat),latvec(3,3)
- integer, intent(in) :: nat
- real*8, intent(out) :: rxyzout(3,nat,3,3,3) !26 periodic images plus the main cell
- integer             :: iat,iplane,icorner,iedge,m,k,l
- real*8,intent(inout):: transvecall(3,3,3,3)!,(transvecp(3,6),transvecc(3,8),transvece(3,12)
-
- do m=-1,1
-    do k=-1,1
-       do l=-1,1
-       transvecall(:,l+2,k+2,m+2)=real(l,8)*latvec(:,1)+real(k,8)*latvec(:,2)+real(m,8)*latvec(:,3)
-       enddo
-    enddo
- enddo
-
- do m=1,3
-    do k=1,3
-       do l=1,3
-       do iat=1,nat
-       rxyzout(:,iat,m,k,l)=rxyz(:,iat)+transvecall(:,m,k,l)
-       enddo
-       enddo
-    enddo
- enddo
- end subroutine
-
-
-
- subroutine expand_2(rxyz,rxyzout_2,transvecall_2,latvec,nat)
- !This subroutine will expand the periodic images to the second order, thus creating the periodic cells of 5*5*5 images
- !The 3*3*3 centered cells are nulled bc thay are present in the expansion of the first order (first neighboring cells)
- implicit none
- real(gp), intent(in)   :: latvec(3,3),rxyz(3,nat)
- real(gp), intent(inout):: rxyzout_2(3,nat,5,5,5)
- integer, intent(in)   :: nat
- integer               :: iat,iplane,icorner,iedge,m,k,l
- real(gp),intent(inout) :: transvecall_2(3,5,5,5)
-
- do m=-2,2
-    do k=-2,2
-       do l=-2,2
-       transvecall_2(:,l+3,k+3,m+3)=real(l,8)*latvec(:,1)+real(k,8)*latvec(:,2)+real(m,8)*latvec(:,3)
-       enddo
-    enddo
- enddo
-
- rxyzout_2=0.0_gp
- do m=1,5
-    do k=1,5
-       do l=1,5
-       do iat=1,nat
-!       if(m==5 .or. k==5 .or. l==5 .or. m==1 .or. k==1 .or. l==1) then
-       rxyzout_2(:,iat,m,k,l)=rxyz(:,iat)+transvecall_2(:,m,k,l)
-!       endif
-       enddo
-       enddo
-    enddo
- enddo
-
- end subroutine
-
- subroutine expand_3(rxyz,rxyzout_3,transvecall_3,latvec,nat)
- !This subroutine will expand the periodic images to the second order, thus creating the periodic cells of 5*5*5 images
- !The 3*3*3 centered cells are nulled bc thay are present in the expansion of the first order (first neighboring cells)
- implicit none
- real(gp), intent(in)   :: latvec(3,3),rxyz(3,nat)
- real(gp), intent(inout):: rxyzout_3(3,nat,7,7,7)
- integer, intent(in)   :: nat
- integer               :: iat,iplane,icorner,iedge,m,k,l
- real(gp),intent(inout) :: transvecall_3(3,7,7,7)
-
- do m=-3,3
-    do k=-3,3
-       do l=-3,3
-       transvecall_3(:,l+4,k+4,m+4)=real(l,8)*latvec(:,1)+real(k,8)*latvec(:,2)+real(m,8)*latvec(:,3)
-       enddo
-    enddo
- enddo
-
- rxyzout_3=0.0_gp
- do m=1,7
-    do k=1,7
-       do l=1,7
-       do iat=1,nat
-!       if(m==7 .or. k==7 .or. l==7 .or. m==1 .or. k==1 .or. l==1) then
-       rxyzout_3(:,iat,m,k,l)=rxyz(:,iat)+transvecall_3(:,m,k,l)
-!       endif
-       enddo
-       enddo
-    enddo
- enddo
-
- end subroutine
-
-
- subroutine expand_4(rxyz,rxyzout_4,transvecall_4,latvec,nat)
- !This subroutine will expand the periodic images to the second order, thus creating the periodic cells of 5*5*5 images
- !The 3*3*3 centered cells are nulled bc thay are present in the expansion of the first order (first neighboring cells)
- implicit none
- real(gp), intent(in)   :: latvec(3,3),rxyz(3,nat)
- real(gp), intent(inout):: rxyzout_4(3,nat,9,9,9)
- integer, intent(in)   :: nat
- integer               :: iat,iplane,icorner,iedge,m,k,l
- real(gp),intent(inout) :: transvecall_4(3,9,9,9)
-
- do m=-4,4
-    do k=-4,4
-       do l=-4,4
-       transvecall_4(:,l+5,k+5,m+5)=real(l,8)*latvec(:,1)+real(k,8)*latvec(:,2)+real(m,8)*latvec(:,3)
-       enddo
-    enddo
- enddo
-
- rxyzout_4=0.0_gp
- do m=1,9
-    do k=1,9
-       do l=1,9
-       do iat=1,nat
-!       if(m==7 .or. k==7 .or. l==7 .or. m==1 .or. k==1 .or. l==1) then
-       rxyzout_4(:,iat,m,k,l)=rxyz(:,iat)+transvecall_4(:,m,k,l)
-!       endif
-       enddo
-       enddo
-    enddo
- enddo
-
- end subroutine
-
-
-!> This subroutine will check if the cell size is sufficentli large to have periodic boundary conditions
-!! with for the given cut. If true, it fits. If false, it does not fit--> new layer necessary
-subroutine check_rep(latvec,cut,nec)
- implicit none
- !Arguments
- real*8, dimension(3,3), intent(in) :: latvec
- real*8, intent(in) :: cut
- logical, intent(out) :: nec
- !Local variables
- real*8, dimension(3,3) :: nvec
- real*8 :: point(3),point0(3),dist,eps
- integer:: i
-! eps=1.d-6
- nec=.true.
- call nveclatvec(latvec,nvec)
- point0=(/0.0_gp,0.0_gp,0.0_gp/)
- do i=1,3
-   call dist2plane(latvec(:,mod(i+1,3)+1),nvec(:,i),point0,dist)
-   ! write(*,*) "cut",i,cut, dist
-   if (dist.le.cut) nec=.false.
- end do
-end subroutine check_rep
-
+!> Construct the pairlist lsta and lstb from the Verlet list of the module,
+!! keeping the pairs within the cutoffs rcut2 of the kinds. The relative
+!! coordinates (unit vector, distance and its inverse, in Angstroem) are stored in rel.
+!! rxyz are the positions in Bohr used to update the Verlet list.
+subroutine verletpairlist(lsta,lstb,rel,nat,rxyz)
+implicit none
+integer, intent(in) :: nat
+integer, intent(out) :: lsta(2,nat),lstb(*)
+real(gp), intent(out) :: rel(5,*)
+real(gp), intent(in) :: rxyz(3,nat)
+integer :: iat,jat,k,l
+real(gp) :: dxyz(3),rr2,cut2,tt,tti
+l=0
+do iat=1,nat
+   lsta(1,iat)=l+1
+   do k=pairs%keynei(2,iat),pairs%keynei(2,iat)+pairs%keynei(1,iat)-1
+      jat=pairs%nei(k)
+      dxyz=verlet_pair(pairs,nat,rxyz,iat,k)*Bohr_Ang
+      rr2=dxyz(1)**2+dxyz(2)**2+dxyz(3)**2
+      cut2=(rcut2(Kinds_tersoff(iat),Kinds_tersoff(jat))-1.e-8_gp)**2
+      if (rr2 < cut2 .and. rr2 /= 0.0_gp) then
+         l=l+1
+         lstb(l)=jat
+         tt=sqrt(rr2)
+         tti=1.0_gp/tt
+         rel(1:3,l)=-dxyz*tti
+         rel(4,l)=tt
+         rel(5,l)=tti
+      end if
+   end do
+   lsta(2,iat)=l
+end do
+end subroutine verletpairlist
 
  !> This subroutine will transform back all atoms into the periodic cell
  !! defined by the 3 lattice vectors in latvec=[v1.v2.v3]
@@ -1366,42 +851,6 @@ subroutine rxyz_cart2int(latvec,rxyzint,rxyzcart,nat)
  end subroutine rxyz_int2cart
 
 
- !> Will calculate the normalized normal vector to the 3 planes of the cell
- subroutine nveclatvec(latvec,nvec)
- use module_base
- implicit none
- real(gp), intent(in) :: latvec(3,3)
- real(gp), intent(out):: nvec(3,3)
- real(gp)             :: a(3),b(3),crossp(3),norm
- integer:: i
- do i=1,3
- a=latvec(:,i)
- b=latvec(:,mod(i,3)+1)
- call cross_product(a,b,crossp)
- norm=dsqrt(crossp(1)*crossp(1)+crossp(2)*crossp(2)+crossp(3)*crossp(3))
- nvec(:,i)=crossp(:)/norm
- enddo
- end subroutine
-
-
-!> This subroutine will calculate  the distance between a plane and a point in space
-!! The point is 'point', the normalized normal vector of the plane is 'nvec', 'ppoint' is an arbitrary point on the plane
-!! and the output is the distance 'dist'
-subroutine dist2plane(point,nvec,ppoint,dist)
-  implicit none
-  !Arguments
-  real(gp), intent(in) :: point(3),nvec(3),ppoint(3)
-  real(gp), intent(out):: dist
-  !Local variables
-  integer             :: i
-  real(gp)             :: p,nvectmp(3)
-  nvectmp(:)=nvec(:)!/sqrt(nvec(1)*nvec(1)+nvec(2)*nvec(2)+nvec(3)*nvec(3))
-  p=DOT_PRODUCT(nvectmp,ppoint)
-  p=-p
-  dist=DOT_PRODUCT(nvectmp,point)+p
-end subroutine dist2plane
-
-
  subroutine cross_product(a,b,crossp)
  !a very simple implementation of the cross product
  implicit none
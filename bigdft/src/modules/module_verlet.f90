@@ -0,0 +1,333 @@
+!> @file
+!!  Linked-cell construction of Verlet neighbour lists
+!! @author
+!!    Copyright (C) 2016 BigDFT group
+!!    This file is distributed under the terms of the
+!!    GNU General Public License, see ~/COPYING file
+!!    or http://www.gnu.org/copyleft/gpl.txt .
+!!    For the list of contributors, see ~/AUTHORS
+
+
+!> Neighbour lists shared by the classical force fields.
+!! The pairs closer than rcut+skin are found in linear time by binning the
+!! atoms in cells of the (orthorhombic) domain. A list is then reused as long as
+!! no atom moved by more than skin/2 since it was built, so that it still
+!! contains all the pairs closer than rcut.
+module module_verlet
+  use module_base
+  implicit none
+
+  private
+
+  !> Verlet list, in compressed row storage. The neighbours of iat are
+  !! nei(k) for k=keynei(2,iat),keynei(2,iat)+keynei(1,iat)-1, and the
+  !! periodic image of nei(k) seen by iat is translated by shift(:,k)*acell
+  !! from the positions given at the build.
+  type, public :: verlet_list
+     logical :: half=.false. !< each pair is stored once, on the atom of lowest index
+     integer :: nat=0
+     integer :: nbuild=0 !< number of builds since the list was set
+     real(gp) :: rcut=0.0_gp !< interaction cutoff
+     real(gp) :: skin=0.0_gp !< margin on the cutoff saving the rebuilds
+     logical, dimension(3) :: peri=.false.
+     real(gp), dimension(3) :: acell=0.0_gp
+     integer, dimension(:,:), pointer :: keynei => null()
+     integer, dimension(:), pointer :: nei => null()
+     integer, dimension(:,:), pointer :: shift => null()
+     real(gp), dimension(:,:), pointer :: rxyz0 => null() !< positions at the last build
+  end type verlet_list
+
+  public :: verlet_list_null,verlet_list_set,deallocate_verlet_list
+  public :: verlet_list_update,verlet_pair
+
+contains
+
+  pure function verlet_list_null() result(vl)
+    implicit none
+    type(verlet_list) :: vl
+    vl%half=.false.
+    vl%nat=0
+    vl%nbuild=0
+    vl%rcut=0.0_gp
+    vl%skin=0.0_gp
+    vl%peri=.false.
+    vl%acell=0.0_gp
+    nullify(vl%keynei)
+    nullify(vl%nei)
+    nullify(vl%shift)
+    nullify(vl%rxyz0)
+  end function verlet_list_null
+
+  !> Set the cutoff and the skin of the list, dropping any previous build.
+  !! With half=.true. each pair appears only once, otherwise j is a neighbour
+  !! of i and i a neighbour of j, as needed by the many-body potentials.
+  subroutine verlet_list_set(vl,rcut,skin,half)
+    implicit none
+    type(verlet_list), intent(inout) :: vl
+    real(gp), intent(in) :: rcut,skin
+    logical, intent(in), optional :: half
+
+    call deallocate_verlet_list(vl)
+    vl%rcut=rcut
+    vl%skin=skin
+    vl%half=.false.
+    if (present(half)) vl%half=half
+    vl%nbuild=0
+  end subroutine verlet_list_set
+
+  subroutine deallocate_verlet_list(vl)
+    implicit none
+    type(verlet_list), intent(inout) :: vl
+    call f_free_ptr(vl%keynei)
+    call f_free_ptr(vl%nei)
+    call f_free_ptr(vl%shift)
+    call f_free_ptr(vl%rxyz0)
+    vl%nat=0
+  end subroutine deallocate_verlet_list
+
+  !> Distance vector from iat to the k-th entry of its neighbours.
+  pure function verlet_pair(vl,nat,rxyz,iat,k) result(dxyz)
+    implicit none
+    type(verlet_list), intent(in) :: vl
+    integer, intent(in) :: nat,iat,k
+    real(gp), dimension(3,nat), intent(in) :: rxyz
+    real(gp), dimension(3) :: dxyz
+    dxyz=rxyz(:,vl%nei(k))-rxyz(:,iat)+vl%shift(:,k)*vl%acell
+  end function verlet_pair
+
+  !> Make the list valid for the positions rxyz in the domain dom.
+  !! The list is only rebuilt when the number of atoms or the cell changed, or
+  !! when an atom moved by more than half of the skin since the last build.
+  subroutine verlet_list_update(vl,dom,nat,rxyz,rebuilt)
+    use at_domain, only: domain,domain_periodic_dims
+    implicit none
+    type(verlet_list), intent(inout) :: vl
+    type(domain), intent(in) :: dom
+    integer, intent(in) :: nat
+    real(gp), dimension(3,nat), intent(in) :: rxyz
+    logical, intent(out), optional :: rebuilt
+    !local variables
+    logical :: build
+    integer :: iat
+    real(gp) :: dmax2
+    logical, dimension(3) :: peri
+
+    if (.not. dom%orthorhombic) call f_err_throw(&
+         'The Verlet lists are only implemented for orthorhombic cells',&
+         err_name='BIGDFT_RUNTIME_ERROR')
+    peri=domain_periodic_dims(dom)
+
+    build=.not. associated(vl%rxyz0) .or. nat /= vl%nat
+    if (.not. build) build=any(peri .neqv. vl%peri) .or. &
+         any(peri .and. dom%acell /= vl%acell)
+    if (.not. build) then
+       dmax2=0.0_gp
+       do iat=1,nat
+          dmax2=max(dmax2,sum((rxyz(:,iat)-vl%rxyz0(:,iat))**2))
+       end do
+       build=4.0_gp*dmax2 > vl%skin**2
+    end if
+
+    if (build) then
+       vl%peri=peri
+       vl%acell=0.0_gp
+       where (peri) vl%acell=dom%acell
+       call verlet_list_build(vl,nat,rxyz)
+    end if
+    if (present(rebuilt)) rebuilt=build
+  end subroutine verlet_list_update
+
+  !> Linked-cell search of all the pairs (and periodic images) closer than
+  !! rcut+skin. Cells are at least rcut+skin wide, periodic directions shorter
+  !! than that are covered by looping on as many images as necessary.
+  subroutine verlet_list_build(vl,nat,rxyz)
+    implicit none
+    type(verlet_list), intent(inout) :: vl
+    integer, intent(in) :: nat
+    real(gp), dimension(3,nat), intent(in) :: rxyz
+    !local variables
+    integer :: iat,jat,i,k,nnei,ncells,ic,inei,n
+    real(gp) :: rc,rc2,fac
+    integer, dimension(3) :: ncell,mcell,c,cc,t,sh
+    real(gp), dimension(3) :: lo,width,dxyz
+    integer, dimension(:), allocatable :: head,next
+    integer, dimension(:,:), allocatable :: icell,img
+
+    call deallocate_verlet_list(vl)
+    vl%nat=nat
+    vl%nbuild=vl%nbuild+1
+    vl%rxyz0=f_malloc_ptr([3,nat],id='vl%rxyz0')
+    vl%keynei=f_malloc0_ptr([2,nat],id='vl%keynei')
+    if (nat > 0) call f_memcpy(src=rxyz,dest=vl%rxyz0)
+
+    rc=vl%rcut+vl%skin
+    rc2=rc**2
+
+    !cells of the free directions span the atoms
+    lo=0.0_gp
+    do i=1,3
+       if (vl%peri(i) .or. nat == 0) cycle
+       lo(i)=minval(rxyz(i,:))
+    end do
+    !limit the number of cells for sparse systems
+    fac=1.0_gp
+    do
+       do i=1,3
+          if (vl%peri(i)) then
+             ncell(i)=max(1,int(vl%acell(i)/(rc*fac)))
+             width(i)=vl%acell(i)/real(ncell(i),gp)
+             mcell(i)=ceiling(rc/width(i))
+          else
+             width(i)=rc*fac
+             ncell(i)=1
+             if (nat > 0) ncell(i)=int((maxval(rxyz(i,:))-lo(i))/width(i))+1
+             mcell(i)=1
+          end if
+       end do
+       if (real(ncell(1),gp)*real(ncell(2),gp)*real(ncell(3),gp) <= &
+            8.0_gp*real(nat,gp)+27.0_gp) exit
+       fac=1.25_gp*fac
+    end do
+    ncells=ncell(1)*ncell(2)*ncell(3)
+
+    !bin the atoms, img being the translation bringing them in the cell
+    head=f_malloc(ncells,id='head')
+    next=f_malloc(nat,id='next')
+    icell=f_malloc([3,nat],id='icell')
+    img=f_malloc([3,nat],id='img')
+    head=0
+    do iat=nat,1,-1
+       do i=1,3
+          if (vl%peri(i)) then
+             img(i,iat)=floor(rxyz(i,iat)/vl%acell(i))
+             dxyz(i)=rxyz(i,iat)-img(i,iat)*vl%acell(i)
+          else
+             img(i,iat)=0
+             dxyz(i)=rxyz(i,iat)-lo(i)
+          end if
+          icell(i,iat)=min(max(int(dxyz(i)/width(i)),0),ncell(i)-1)
+       end do
+       ic=1+icell(1,iat)+ncell(1)*(icell(2,iat)+ncell(2)*icell(3,iat))
+       next(iat)=head(ic)
+       head(ic)=iat
+    end do
+
+    !first pass counts the neighbours, second one stores them
+    do n=1,2
+       if (n == 2) then
+          nnei=0
+          do iat=1,nat
+             vl%keynei(2,iat)=nnei+1
+             nnei=nnei+vl%keynei(1,iat)
+          end do
+          vl%nei=f_malloc_ptr(nnei,id='vl%nei')
+          vl%shift=f_malloc_ptr([3,nnei],id='vl%shift')
+       end if
+       !$omp parallel do default(shared) schedule(dynamic) &
+       !$omp private(iat,jat,i,k,ic,inei,c,cc,t,sh,dxyz)
+       do iat=1,nat
+          inei=0
+          do k=-mcell(3),mcell(3)
+             do i=-mcell(2),mcell(2)
+                do ic=-mcell(1),mcell(1)
+                   c=icell(:,iat)+[ic,i,k]
+                   if (any(.not. vl%peri .and. (c < 0 .or. c >= ncell))) cycle
+                   cc=c
+                   where (vl%peri) cc=modulo(c,ncell)
+                   t=(c-cc)/ncell
+                   jat=head(1+cc(1)+ncell(1)*(cc(2)+ncell(2)*cc(3)))
+                   do while(jat /= 0)
+                      sh=t+img(:,iat)-img(:,jat)
+                      if (vl%half) then
+                         if (jat < iat .or. (jat == iat .and. .not. positive(t))) then
+                            jat=next(jat)
+                            cycle
+                         end if
+                      else if (jat == iat .and. all(t == 0)) then
+                         jat=next(jat)
+                         cycle
+                      end if
+                      dxyz=rxyz(:,jat)-rxyz(:,iat)+sh*vl%acell
+                      if (sum(dxyz**2) < rc2) then
+                         inei=inei+1
+                         if (n == 2) then
+                            vl%nei(vl%keynei(2,iat)+inei-1)=jat
+                            vl%shift(:,vl%keynei(2,iat)+inei-1)=sh
+                         end if
+                      end if
+                      jat=next(jat)
+                   end do
+                end do
+             end do
+          end do
+          if (n == 1) then
+             vl%keynei(1,iat)=inei
+          else
+             !the order of the neighbours should not depend on the binning
+             k=vl%keynei(2,iat)
+             call sort_neighbours(inei,vl%nei(k:k+inei-1),vl%shift(:,k:k+inei-1))
+          end if
+       end do
+       !$omp end parallel do
+    end do
+
+    call f_free(head)
+    call f_free(next)
+    call f_free(icell)
+    call f_free(img)
+
+  contains
+
+    !> Lexicographic sign of a translation, to keep one of the self-images
+    pure function positive(t)
+      implicit none
+      integer, dimension(3), intent(in) :: t
+      logical :: positive
+      positive=t(1) > 0 .or. (t(1) == 0 .and. (t(2) > 0 .or. (t(2) == 0 .and. t(3) > 0)))
+    end function positive
+
+  end subroutine verlet_list_build
+
+  !> Insertion sort of the neighbours of one atom by index, then translation.
+  pure subroutine sort_neighbours(n,nei,shift)
+    implicit none
+    integer, intent(in) :: n
+    integer, dimension(n), intent(inout) :: nei
+    integer, dimension(3,n), intent(inout) :: shift
+    !local variables
+    integer :: i,j,jat
+    integer, dimension(3) :: sh
+
+    do i=2,n
+       jat=nei(i)
+       sh=shift(:,i)
+       j=i-1
+       do while(j >= 1)
+          if (.not. greater(nei(j),shift(:,j),jat,sh)) exit
+          nei(j+1)=nei(j)
+          shift(:,j+1)=shift(:,j)
+          j=j-1
+       end do
+       nei(j+1)=jat
+       shift(:,j+1)=sh
+    end do
+
+  contains
+
+    pure function greater(i1,s1,i2,s2)
+      implicit none
+      integer, intent(in) :: i1,i2
+      integer, dimension(3), intent(in) :: s1,s2
+      logical :: greater
+      integer :: k
+      greater=i1 > i2
+      if (i1 /= i2) return
+      do k=1,3
+         greater=s1(k) > s2(k)
+         if (s1(k) /= s2(k)) return
+      end do
+    end function greater
+
+  end subroutine sort_neighbours
+
+end module module_verlet
@@ -415,6 +415,8 @@ module rhopotential
       use wrapper_linalg
       use module_defs
       use module_base, only: bigdft_mpi
+      use f_precisions, only: f_long
+      use f_utils, only: f_time
       use yaml_output
       use sparsematrix_base, only: sparse_matrix, matrices
       use module_types, only: linmat_auxiliary, comms_linear
@@ -440,9 +442,12 @@ module rhopotential
       character(len=*),parameter :: subname='sumrho_for_TMBs'
       logical :: print_local
       integer :: size_of_double, mpisource, istsource, istdest, nsize, jproc, ishift_dest, ishift_source
+      integer(f_long) :: t0,mem_mark,mem_peak
       !integer :: info
 
       call f_routine('sumrho_for_TMBs')
+      t0=f_time()
+      call f_malloc_mark()
 
       !!call get_modulo_array(denskern%nfvctr, aux%mat_ind_compr, moduloarray)
 
@@ -649,9 +654,23 @@ module rhopotential
              !call fmpi_allreduce(total_charge, 1, FMPI_SUM, bigdft_mpi%mpi_comm)
           end if
 
+          !highest memory reached during the construction of the density, on all the processes
+          if (print_local .and. get_verbose_level() > 2) then
+              call f_malloc_memory(mark=mem_mark,peak=mem_peak)
+              mem_peak=mem_peak-mem_mark
+              if (nproc > 1) call fmpi_allreduce(mem_peak,1,FMPI_MAX,comm=bigdft_mpi%mpi_comm)
+          end if
+
           !!if(print_local .and. iproc==0) write(*,'(3x,a,es20.12)') 'Calculation finished. TOTAL CHARGE = ', total_charge*hxh*hyh*hzh
           if (iproc==0 .and. print_local) then
               call yaml_map('Total charge',total_charge*hxh*hyh*hzh,fmt='(es20.12)')
+              if (get_verbose_level() > 2) then
+                 call yaml_mapping_open('Density construction',flow=.true.)
+                 call yaml_map('Memory peak (MB)',real(mem_peak,kind=8)/1048576.d0,fmt='(f10.2)')
+                 call yaml_map('Slab (MB)',real(ndimrho,kind=8)*8.d0/1048576.d0,fmt='(f10.2)')
+                 call yaml_map('Time (s)',real(f_time()-t0,kind=8)*1.d-9,fmt='(f10.4)')
+                 call yaml_mapping_close()
+              end if
           end if
 
           call timing(iproc,'sumrho_allred','OF')
@@ -13,7 +13,7 @@ module sparsematrix_wrappers
   contains
 
     subroutine init_sparse_matrix_wrapper(iproc, nproc, nspin, orbs, lzd, astruct, &
-               store_index, init_matmul, matmul_optimize_load_balancing, imode, smat, smat_ref)
+               store_index, init_matmul, matmul_optimize_load_balancing, imode, smat, smat_ref, matmul_bsr)
       use module_types, only: orbitals_data, local_zone_descriptors, atomic_structure
       use sparsematrix_init, only: init_sparse_matrix
       use at_domain, only: domain_geocode
@@ -27,6 +27,7 @@ module sparsematrix_wrappers
       logical,intent(in) :: store_index, init_matmul, matmul_optimize_load_balancing
       type(sparse_matrix),intent(out) :: smat
       type(sparse_matrix),intent(in),optional :: smat_ref !< reference sparsity pattern, in case smat must be at least as large as smat_ref
+      logical,intent(in),optional :: matmul_bsr !< allow the atom-block sparse matmul (default yes)
 
       ! Local variables
       integer :: nnonzero, nnonzero_mult, ilr
@@ -82,7 +83,7 @@ module sparsematrix_wrappers
            init_matmul=init_matmul, matmul_optimize_load_balancing=matmul_optimize_load_balancing, &
            nspin=nspin, geocode=domain_geocode(astruct%dom), &
            cell_dim=astruct%cell_dim, norbup=orbs%norbup, &
-           isorbu=orbs%isorbu, store_index=store_index, on_which_atom=orbs%onwhichatom)
+           isorbu=orbs%isorbu, store_index=store_index, on_which_atom=orbs%onwhichatom, matmul_bsr=matmul_bsr)
       call f_free_ptr(nonzero)
       call f_free_ptr(nonzero_mult)
       call f_free(locrad)
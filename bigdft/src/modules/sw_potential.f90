@@ -1,6 +1,7 @@
 !> Module defining the parameters for the Stillinger-Weber potential.
 module SWpotential
   use module_defs, only: gp
+  use module_verlet
   implicit none
 
   private
@@ -30,6 +31,10 @@ module SWpotential
   real(gp), allocatable,dimension(:,:) ::force_work_fit  !!working forces for fit
   real(gp), allocatable,dimension(:,:) :: pos_ref_fit  !!reference position for fit
 
+  !> pairs within the cutoff, kept from one call to the other
+  type(verlet_list), save :: pairs
+  real(gp), parameter :: skin=0.5_gp
+
   public :: SWcalcforce, init_potential_SW, free_potential_SW
   
 contains
@@ -99,6 +104,8 @@ contains
     else
        stop
     endif
+    !the cutoff of the Verlet list is set at the first call
+    call verlet_list_set(pairs,0.0_gp,skin)
   END SUBROUTINE init_potential_SW
 
 
@@ -132,19 +139,15 @@ contains
     if (allocated(force_ref_fit)) deallocate(force_ref_fit)
     if (allocated(pos_ref_fit)) deallocate(pos_ref_fit)
     if (allocated(force_work_fit)) deallocate(force_work_fit)
+    call deallocate_verlet_list(pairs)
   end subroutine free_potential_SW
 
   !> subroutine to compute forces and energies using Stillinger-Weber potential
   subroutine SWcalcforce(astruct, rxyz, fxyz, pot_energy, infocode)
     use numerics, only: Bohr_Ang, pi, eV_Ha
     use module_defs, only: gp
-    use module_atoms, only: atomic_structure, atomic_neighbours, &
-         & astruct_neighbours_next, astruct_neighbours_iter, &
-         & deallocate_atomic_neighbours
-    use dynamic_memory
+    use module_atoms, only: atomic_structure
     use f_utils
-    use module_base, only: f_err_throw
-    use at_domain, only: domain_periodic_dims,domain_geocode
 
     implicit none
 
@@ -154,12 +157,6 @@ contains
     real(gp), intent(out), dimension(3, astruct%nat), target:: fxyz
     integer, intent(out) :: infocode
 
-    type(atomic_neighbours) :: nei, nei2
-
-    real(gp), dimension(3*astruct%nat), target :: pos_normalised
-    real(gp), dimension(3*astruct%nat) :: box_vec
-    real(gp), dimension(:), pointer :: pos
-    real(gp), dimension(3) :: lbox
     integer :: NATOMS
     real(gp)  :: SIGMA 
     real(gp)  :: A 
@@ -173,12 +170,11 @@ contains
     real(gp) :: ONE_THIRD = 1.0_gp/3.0_gp
     real(gp) :: A_EPS
 
-    real(gp), dimension(:), pointer :: xa, ya, za
-    logical, dimension(3) :: peri
-    integer :: i, j, i_id, j_id, k, k_id
+    integer :: i, j, i_id, j_id, k, k_id, jnei, knei
     integer :: my_counter_i
-    real(gp) :: invsig
-    real(gp) :: xi, yi, zi, xij, yij, zij, rij, rij2
+    real(gp) :: invsig, rcut
+    real(gp) :: xij, yij, zij, rij, rij2
+    real(gp), dimension(3) :: dxyz
     real(gp) :: twobodyenergy, threebodyenergy
     real(gp) :: cos_x_ij, cos_y_ij, cos_z_ij, invrij, rhoij
     real(gp) :: one_o_a_ij, expo, gam_o_a_ij, exp_gam_ij, r_to_minusp
@@ -192,40 +188,11 @@ contains
     infocode = 0
 
     NATOMS = astruct%nat
-    pos = f_malloc_ptr(NATOMS * 3, id = "pos")
-    pos(1:NATOMS) = rxyz(1, :) * Bohr_Ang
-    pos(1 + NATOMS:2 * NATOMS) = rxyz(2, :) * Bohr_Ang
-    pos(1 + 2 * NATOMS:3 * NATOMS) = rxyz(3, :) * Bohr_Ang
-    lbox = astruct%cell_dim * Bohr_Ang
-
-    !peri=bc_periodic_dims(geocode_to_bc(astruct%geocode))
-    peri=domain_periodic_dims(astruct%dom)
-
-    where(.not. peri) lbox = 1._gp
-
-    box_vec(1:natoms) = lbox(1)
-    box_vec(1+natoms:2*natoms) = lbox(2)
-    box_vec(1+natoms+natoms:3*natoms) = lbox(3)
-
-    if (peri(1)) pos(1:natoms) = modulo(pos(1:natoms), box_vec(1:natoms))
-    if (peri(2)) pos(natoms+1:2*natoms) = modulo(pos(natoms+1:2*natoms), box_vec(natoms+1:2*natoms))
-    if (peri(3)) pos(2*natoms+1:3*natoms) = modulo(pos(2*natoms+1:3*natoms), box_vec(2*natoms+1:3*natoms))
-       
-!!$    if ( astruct%geocode .eq. 'P') pos = modulo(pos, box_vec) !apply PBC implement surface later on
-!!$    if ( astruct%geocode .eq. 'S') pos(1:natoms) = modulo(pos(1:natoms), box_vec(1:natoms))
-!!$    if ( astruct%geocode .eq. 'W') pos(natoms+1:2*natoms) = modulo(pos(natoms+1:2*natoms), box_vec(natoms+1:2*natoms))
-!!$    if ( astruct%geocode .eq. 'S') pos(2*natoms+1:3*natoms) = modulo(pos(2*natoms+1:3*natoms), box_vec(2*natoms+1:3*natoms))
-
 
-    ! Generate a neighbour list
-    call astruct_neighbours(astruct, rxyz, nei)
-
-    ! We first set-up pointers for the x, y, z components in the position and forces
-    pos_normalised = pos / box_vec
-
-    xa => pos_normalised(1:NATOMS)
-    ya => pos_normalised(NATOMS+1:2*NATOMS)
-    za => pos_normalised(2*NATOMS+1:3*NATOMS)
+    ! Pairs within the largest cutoff, in Bohr; all the periodic images are kept
+    rcut = maxval(SW_parameters(:,1)*SW_parameters(:,3)) / Bohr_Ang
+    if (pairs%rcut /= rcut) call verlet_list_set(pairs, rcut, skin)
+    call verlet_list_update(pairs, astruct%dom, NATOMS, rxyz)
 
     call f_zero(fxyz)
 
@@ -236,31 +203,17 @@ contains
     do i=1, NATOMS
        !     i_id = types(i)
        i_id = 1
-       xi = xa(i)
-       yi = ya(i)
-       zi = za(i)
 
-       call astruct_neighbours_iter(nei, i)
-       do while(astruct_neighbours_next(nei, j))
+       do jnei = pairs%keynei(2,i), pairs%keynei(2,i) + pairs%keynei(1,i) - 1
+          j = pairs%nei(jnei)
           j_id = 1
           !j_id = types(j)
 
-          ! Pair interactions of i and j
-          ! Distance, with periodic boundary conditions
-          if (domain_geocode(astruct%dom) == "P") then
-             xij = xa(j) - xi - 1.0_gp * nint( xa(j)-xi )
-             yij = ya(j) - yi - 1.0_gp * nint( ya(j)-yi )
-             zij = za(j) - zi - 1.0_gp * nint( za(j)-zi )
-          elseif (domain_geocode(astruct%dom) == "S") then
-             xij = xa(j) - xi - 1.0_gp * nint( xa(j)-xi )
-             yij = ya(j) - yi
-             zij = za(j) - zi - 1.0_gp * nint( za(j)-zi )
-          endif
-
-          ! Rescale the lengths into Angstroems
-          xij = xij * lbox(1)
-          yij = yij * lbox(2)
-          zij = zij * lbox(3)
+          ! Pair interactions of i and j, in Angstroems
+          dxyz = verlet_pair(pairs, NATOMS, rxyz, i, jnei) * Bohr_Ang
+          xij = dxyz(1)
+          yij = dxyz(2)
+          zij = dxyz(3)
 
           rij2 = xij*xij + yij*yij + zij*zij
 
@@ -316,26 +269,16 @@ contains
              ! Prepare for the three body term 
              fact3_ij=gam_o_a_ij*one_o_a_ij*invsig
 
-             nei2 = nei
-             do while (astruct_neighbours_next(nei2, k))
+             ! The neighbours after j, each triplet being counted once
+             do knei = jnei + 1, pairs%keynei(2,i) + pairs%keynei(1,i) - 1
+                k = pairs%nei(knei)
                 ! Triplet interaction with i in the middle; all interactions
                 !k_id = types(k)
                 k_id = 1
-                ! Distance, with periodic boundary conditions
-                if (domain_geocode(astruct%dom) == "P") then
-                   xik = xa(k) - xi - 1.0_gp * nint( xa(k)-xi )
-                   yik = ya(k) - yi - 1.0_gp * nint( ya(k)-yi )
-                   zik = za(k) - zi - 1.0_gp * nint( za(k)-zi )
-                elseif (domain_geocode(astruct%dom) == "S") then
-                   xik = xa(k) - xi - 1.0_gp * nint( xa(k)-xi )
-                   yik = ya(k) - yi
-                   zik = za(k) - zi - 1.0_gp * nint( za(k)-zi )
-                endif
-
-                ! Rescale the lengths into Angstroems
-                xik = xik * lbox(1)
-                yik = yik * lbox(2)
-                zik = zik * lbox(3)
+                dxyz = verlet_pair(pairs, NATOMS, rxyz, i, knei) * Bohr_Ang
+                xik = dxyz(1)
+                yik = dxyz(2)
+                zik = dxyz(3)
 
                 rik2 = xik*xik + yik*yik + zik*zik
 
@@ -423,9 +366,6 @@ contains
     end do
     pot_energy = (twobodyenergy+threebodyenergy) * eV_Ha
     fxyz = fxyz / Bohr_Ang * eV_Ha
-
-    call f_free_ptr(pos)
-    call deallocate_atomic_neighbours(nei)
   END SUBROUTINE SWcalcforce
 
 END MODULE  SWpotential
@@ -284,6 +284,13 @@ module module_types
      type(local_zone_descriptors) :: Lzd       !< Local zone descriptors of the corresponding run
      real(wp), dimension(:), pointer :: psi    !< Wavelets coefficients in compressed form
      real(gp), dimension(:,:), pointer :: rxyz !< Atomic positions of the step
+     !> Storage of the coefficients (WFN_HISTORY_*); if not double, psi is not allocated
+     !! and the coefficients are kept in psi_sp (and psi_q)
+     integer :: precision
+     integer :: norbp                                 !< Number of stored orbitals (times nspinor)
+     real(kind=4), dimension(:), allocatable :: psi_sp    !< Single precision coefficients (only the coarse ones if quantized)
+     integer(kind=2), dimension(:), allocatable :: psi_q  !< Quantized fine coefficients
+     real(wp), dimension(:), allocatable :: scale_q       !< Quantization step of the fine coefficients, per orbital
   end type old_wavefunction
 
 
@@ -369,6 +376,8 @@ module module_types
      type(paw_objects) :: paw                                !< PAW objects
      type(orthon_data) :: orthpar                            !< control the application of the orthogonality scheme for cubic DFT wavefunction
      character(len=4) :: exctxpar                            !< Method for exact exchange parallelisation for the wavefunctions, in case
+     real(gp) :: exctx_screening                             !< Norm fraction neglected to screen the exact exchange couples
+     logical :: exctx_persistent                             !< Persistent requests for the OP2P ring of the exact exchange
      type(p2pComms) :: comgp                                 !< describing p2p communications for distributing the potential
      type(comms_linear) :: collcom                           !< describes collective communication
      type(comms_linear) :: collcom_sr                        !< describes collective communication for the calculation of the charge density
@@ -617,6 +626,7 @@ module module_types
  public :: deallocate_orbs,deallocate_locreg_descriptors
  public :: deallocate_paw_objects!,deallocate_wfd,
  public :: old_wavefunction_set
+ public :: old_wavefunction_get_psi,old_wavefunction_release_psi,old_wavefunction_memory
  public :: nullify_locreg_descriptors
  public :: deallocate_rho_descriptors
  public :: nullify_paw_objects
@@ -673,6 +683,8 @@ contains
     wfn%Lzd=default_lzd()
     nullify(wfn%psi)
     nullify(wfn%rxyz)
+    wfn%precision=0
+    wfn%norbp=0
   end function old_wavefunction_null
 
 
@@ -690,8 +702,11 @@ contains
 
   !> Fills the old_wavefunction structure with corresponding data
   !! Deallocate previous workspaces if already existing
+  !! The coefficients are stored with the precision of wfn (see WFN_HISTORY_*):
+  !! in the quantized case the fine coefficients of each orbital are rounded to 16-bit integers
+  !! on a uniform grid of step scale_q, so that the error is bounded by scale_q/2
   subroutine old_wavefunction_set(wfn,nat,norbp,Lzd,rxyz,psi)
-
+    use public_enums, only: WFN_HISTORY_DOUBLE,WFN_HISTORY_SINGLE,WFN_HISTORY_QUANTIZED
     implicit none
     integer, intent(in) :: nat,norbp
     type(local_zone_descriptors), intent(in) :: Lzd
@@ -700,14 +715,45 @@ contains
     type(old_wavefunction), intent(inout) :: wfn
     !local variables
     character(len=*), parameter :: subname='old_wavefunction_set'
+    integer :: nvctr_c,nvctr_f,ncomp,iorb,ist,i
 
     !first, free the workspace if not already done
     call old_wavefunction_free(wfn)
     !then allocate the workspaces and fill them
-    wfn%psi = f_malloc_ptr((Lzd%Glr%wfd%nvctr_c+7*Lzd%Glr%wfd%nvctr_f)*norbp,id='wfn%psi')
-
-    if (norbp>0) call vcopy((Lzd%Glr%wfd%nvctr_c+7*Lzd%Glr%wfd%nvctr_f)*norbp,&
-         psi(1),1,wfn%psi(1),1)
+    nvctr_c=Lzd%Glr%wfd%nvctr_c
+    nvctr_f=Lzd%Glr%wfd%nvctr_f
+    ncomp=nvctr_c+7*nvctr_f
+    wfn%norbp=norbp
+    select case(wfn%precision)
+    case(WFN_HISTORY_SINGLE)
+       wfn%psi_sp = f_malloc(ncomp*norbp,id='wfn%psi_sp')
+       do i=1,ncomp*norbp
+          wfn%psi_sp(i)=real(psi(i),kind=4)
+       end do
+    case(WFN_HISTORY_QUANTIZED)
+       wfn%psi_sp = f_malloc(nvctr_c*norbp,id='wfn%psi_sp')
+       !no 16-bit integers in f_malloc
+       allocate(wfn%psi_q(7*nvctr_f*norbp))
+       wfn%scale_q = f_malloc(norbp,id='wfn%scale_q')
+       do iorb=1,norbp
+          ist=(iorb-1)*ncomp
+          do i=1,nvctr_c
+             wfn%psi_sp(i+(iorb-1)*nvctr_c)=real(psi(ist+i),kind=4)
+          end do
+          wfn%scale_q(iorb)=0.0_wp
+          do i=nvctr_c+1,ncomp
+             wfn%scale_q(iorb)=max(wfn%scale_q(iorb),abs(psi(ist+i)))
+          end do
+          wfn%scale_q(iorb)=wfn%scale_q(iorb)/real(huge(1_2),wp)
+          if (wfn%scale_q(iorb) == 0.0_wp) wfn%scale_q(iorb)=1.0_wp
+          do i=1,7*nvctr_f
+             wfn%psi_q(i+(iorb-1)*7*nvctr_f)=int(nint(psi(ist+nvctr_c+i)/wfn%scale_q(iorb)),kind=2)
+          end do
+       end do
+    case default
+       wfn%psi = f_malloc_ptr(ncomp*norbp,id='wfn%psi')
+       if (norbp>0) call vcopy(ncomp*norbp,psi(1),1,wfn%psi(1),1)
+    end select
 
     wfn%rxyz = f_malloc_ptr((/ 3, nat /),id='wfn%rxyz')
     if (nat>0) call vcopy(3*nat,rxyz(1,1),1,wfn%rxyz(1,1),1)
@@ -716,6 +762,74 @@ contains
   end subroutine old_wavefunction_set
 
 
+  !> Give access to the coefficients of an old wavefunction in double precision.
+  !! Points to wfn%psi if they are stored in full, otherwise psi is allocated and filled;
+  !! it has to be given back with old_wavefunction_release_psi
+  subroutine old_wavefunction_get_psi(wfn,psi)
+    use public_enums, only: WFN_HISTORY_SINGLE
+    implicit none
+    type(old_wavefunction), intent(in) :: wfn
+    real(wp), dimension(:), pointer :: psi
+    !local variables
+    integer :: nvctr_c,nvctr_f,ncomp,iorb,ist,i
+
+    if (associated(wfn%psi)) then
+       psi => wfn%psi
+       return
+    end if
+    nvctr_c=wfn%Lzd%Glr%wfd%nvctr_c
+    nvctr_f=wfn%Lzd%Glr%wfd%nvctr_f
+    ncomp=nvctr_c+7*nvctr_f
+    psi = f_malloc_ptr(ncomp*wfn%norbp,id='psi')
+    if (wfn%precision == WFN_HISTORY_SINGLE) then
+       do i=1,ncomp*wfn%norbp
+          psi(i)=real(wfn%psi_sp(i),wp)
+       end do
+    else
+       do iorb=1,wfn%norbp
+          ist=(iorb-1)*ncomp
+          do i=1,nvctr_c
+             psi(ist+i)=real(wfn%psi_sp(i+(iorb-1)*nvctr_c),wp)
+          end do
+          do i=1,7*nvctr_f
+             psi(ist+nvctr_c+i)=wfn%scale_q(iorb)*real(wfn%psi_q(i+(iorb-1)*7*nvctr_f),wp)
+          end do
+       end do
+    end if
+
+  end subroutine old_wavefunction_get_psi
+
+
+  !> Release the coefficients obtained with old_wavefunction_get_psi
+  subroutine old_wavefunction_release_psi(wfn,psi)
+    implicit none
+    type(old_wavefunction), intent(in) :: wfn
+    real(wp), dimension(:), pointer :: psi
+
+    if (associated(psi,target=wfn%psi)) then
+       nullify(psi)
+    else
+       call f_free_ptr(psi)
+    end if
+
+  end subroutine old_wavefunction_release_psi
+
+
+  !> Memory used by the coefficients of an old wavefunction, in bytes
+  function old_wavefunction_memory(wfn) result(nbytes)
+    implicit none
+    type(old_wavefunction), intent(in) :: wfn
+    integer(f_long) :: nbytes
+
+    nbytes=0
+    if (associated(wfn%psi)) nbytes=nbytes+8_f_long*size(wfn%psi)
+    if (allocated(wfn%psi_sp)) nbytes=nbytes+4_f_long*size(wfn%psi_sp)
+    if (allocated(wfn%psi_q)) nbytes=nbytes+2_f_long*size(wfn%psi_q)
+    if (allocated(wfn%scale_q)) nbytes=nbytes+8_f_long*size(wfn%scale_q)
+
+  end function old_wavefunction_memory
+
+
   subroutine old_wavefunction_free(wfn)
     implicit none
     type(old_wavefunction), intent(inout) :: wfn
@@ -724,6 +838,15 @@ contains
     if (associated(wfn%psi)) then
        call f_free_ptr(wfn%psi)
     end if
+    if (allocated(wfn%psi_sp)) then
+       call f_free(wfn%psi_sp)
+    end if
+    if (allocated(wfn%psi_q)) then
+       deallocate(wfn%psi_q)
+    end if
+    if (allocated(wfn%scale_q)) then
+       call f_free(wfn%scale_q)
+    end if
     if (associated(wfn%rxyz)) then
        call f_free_ptr(wfn%rxyz)
     end if
@@ -1264,6 +1387,8 @@ contains
     type(DFT_wavefunction), intent(out) :: wfn
 
     wfn%c_obj = 0
+    wfn%exctx_screening = 0.0_gp
+    wfn%exctx_persistent = .false.
 
     nullify(wfn%psi)
     nullify(wfn%hpsi)
@@ -93,6 +93,7 @@ module vdwcorrection
 
   public :: vdwcorrection_initializeparams
   public :: vdwcorrection_freeparams
+  public :: vdwcorrection_finalize
   public :: vdwcorrection_calculate_energy
   public :: vdwcorrection_calculate_forces
   public :: vdwcorrection_warnings
@@ -100,6 +101,31 @@ module vdwcorrection
   ! qoh: Share array of Van der Waals parameters accross module
 
   type(VDWPARAMETERS) :: vdwparams ! Array of parameters
+
+  !> Number of incremental updates of the D3 coordination numbers
+  !! before they are recomputed from scratch (bounds the round-off drift).
+  integer, parameter :: D3_CN_REFRESH = 64
+
+  !> Tables of the DFT-D3 correction restricted to the species of the system.
+  !! They are built once per run, and the coordination numbers of the last
+  !! geometry are kept to be reused or updated for the atoms which moved only.
+  TYPE D3TABLES
+     integer :: ntypes = 0
+     integer :: mxcn = 0
+     integer, dimension(:), pointer :: nzatom => null()  !< atomic number of each type
+     integer, dimension(:), pointer :: maxcn => null()   !< number of references of each type
+     real(gp), dimension(:), pointer :: rcov => null()   !< covalent radius of each type
+     real(gp), dimension(:,:), pointer :: cnref => null()       !< cnref(mxcn,ntypes)
+     real(gp), dimension(:,:,:,:), pointer :: c6ref => null()   !< c6ref(mxcn,mxcn,ntypes,ntypes)
+     !coordination numbers of the last geometry
+     integer :: nat = 0
+     integer :: nupdate = 0
+     integer, dimension(:), pointer :: iatype => null()
+     real(gp), dimension(:,:), pointer :: rxyz => null()
+     real(gp), dimension(:), pointer :: cn => null()
+  END TYPE D3TABLES
+
+  type(D3TABLES), save :: d3tab
  
 
 contains
@@ -957,6 +983,21 @@ contains
 
   end subroutine vdwcorrection_freeparams
 
+  !> Free the DFT-D3 tables kept along the run, to be called at its end
+  subroutine vdwcorrection_finalize()
+    implicit none
+
+    call d3tables_free_geometry()
+    call f_free_ptr(d3tab%nzatom)
+    call f_free_ptr(d3tab%maxcn)
+    call f_free_ptr(d3tab%rcov)
+    call f_free_ptr(d3tab%cnref)
+    call f_free_ptr(d3tab%c6ref)
+    d3tab%ntypes=0
+    d3tab%mxcn=0
+
+  end subroutine vdwcorrection_finalize
+
 
   !< This subroutine calculates the dispersion correction to the total energy.                                                    !
   !! @author
@@ -1000,8 +1041,18 @@ contains
 !!vama!!
     if (dispersion /= VDW_NONE) then 
 
-       ! qoh: Loop over all distinct pairs of atoms
+       if (dispersion == 5) call d3tables_update(atoms,rxyz)
 
+       ! qoh: Loop over all distinct pairs of atoms
+       ! The closest image of each pair is used, for any lattice, within
+       ! sqrt(20000) bohr: the linked cells of module_verlet (orthorhombic
+       ! cells, all images within the cutoff) would change the periodic
+       ! results, so this loop and the gradient ones are kept all-pairs.
+
+       !$omp parallel do default(shared) schedule(dynamic) &
+       !$omp private(atom1,atom2,nzatom1,nzatom2,dxyz,sqdist,distance) &
+       !$omp private(damping,c6coeff,c6d3,cni,cnj,e8,e6,c8) &
+       !$omp reduction(+:dispersion_energy)
        do atom1=1,atoms%astruct%nat
           do atom2=1,atom1-1
 
@@ -1034,9 +1085,9 @@ contains
                   e8 = 0.0_GP
 !! DFT-D3
              
-                   cni  = crd_nr(atom1,atoms%astruct%nat,rxyz,atoms)
-                   cnj  = crd_nr(atom2,atoms%astruct%nat,rxyz,atoms)
-                   c6d3 = c6cn(nzatom1,nzatom2,cni,cnj)
+                   cni  = d3tab%cn(atom1)
+                   cnj  = d3tab%cn(atom2)
+                   c6d3 = c6cn(atoms%astruct%iatype(atom1),atoms%astruct%iatype(atom2),cni,cnj)
                    c8   = 3.0_GP*c6d3*vdwparams%Qatom(nzatom1)*vdwparams%Qatom(nzatom2)
     
                    damping  = 1.0_GP/(1.0_GP &
@@ -1065,6 +1116,7 @@ contains
 !!vama!!               'Dispersion Correction Energy: ', dispersion_energy, 'Hartree'
           enddo
        enddo
+       !$omp end parallel do
 
 !!$       if (iproc == 0) then
 !!$          write(*,'(1x,a, e12.5,1x,a)') &
@@ -1183,8 +1235,14 @@ contains
           enddo
        else if (dispersion == 5) then
 
+          call d3tables_update(atoms,rxyz)
           call crd_nr_der(atoms%astruct%nat,rxyz,cnij,cnijk,atoms)
 
+          !each thread accumulates the forces of its own atoms only
+          !$omp parallel do default(shared) schedule(dynamic) &
+          !$omp private(atom1,atom2,atom3,nzatom1,nzatom2,nzatom3,dxyz,distance) &
+          !$omp private(rAj,rAk,rjk,r0aj,r0ak,r0jk,Qfac,fac6,fac8,fdmp6,fdmp8) &
+          !$omp private(tmp6,tmp8,tmp6a,tmp8a,cnA,cnj,c6Aj,grad_c6)
           do atom1=1,atoms%astruct%nat
 
              do atom2=1,atoms%astruct%nat
@@ -1220,13 +1278,13 @@ contains
  
 !            Coordination dependent C6_AB value
  
-                cnA = crd_nr(atom1,atoms%astruct%nat,rxyz,atoms)
-                cnj = crd_nr(atom2,atoms%astruct%nat,rxyz,atoms)
-                c6Aj = c6cn(nzatom1,nzatom2,cnA,cnj)
+                cnA = d3tab%cn(atom1)
+                cnj = d3tab%cn(atom2)
+                c6Aj = c6cn(atoms%astruct%iatype(atom1),atoms%astruct%iatype(atom2),cnA,cnj)
 !
 !            Get gradient for coordination number dependent C6
 !
-                call c6_grad(grad_c6,atom1,atom2,atom1,rxyz,atoms%astruct%nat,cnij,cnijk,atoms)
+                call c6_grad(grad_c6,atom1,atom2,atom1,atoms%astruct%nat,cnij,cnijk,atoms)
    
                 tmp6 = 6.0_GP*fdmp6*vdwparams%s6*c6Aj/(rAj**4.0_GP)
                 tmp8 = 6.0_GP*fdmp8*vdwparams%s8*c6Aj*Qfac/(rAj**5.0_GP)
@@ -1311,7 +1369,7 @@ contains
 !
 !                   Get gradient for coordination number dependent C6 for three centers
 !
-                    call c6_grad(grad_c6,atom2,atom3,atom1,rxyz,atoms%astruct%nat,cnij,cnijk,atoms)
+                    call c6_grad(grad_c6,atom2,atom3,atom1,atoms%astruct%nat,cnij,cnijk,atoms)
 
                     fac6 = (vdwparams%sr6*r0jk/sqrt(rjk))**(vdwparams%alpha)
                     fac8 = (vdwparams%sr8*r0jk/sqrt(rjk))**(vdwparams%alpha+2.0_GP)
@@ -1336,6 +1394,7 @@ contains
                 enddo
              enddo
            enddo
+           !$omp end parallel do
        end if
     call f_free(cnij)
     call f_free(cnijk)
@@ -9391,9 +9450,10 @@ contains
       end do
   END SUBROUTINE init_qat
 
-  function c6cn(iat,jat,cni,cnj)
+  !> Coordination number dependent C6 of a pair of atoms of types ityp and jtyp
+  pure function c6cn(ityp,jtyp,cni,cnj)
       implicit none
-      integer, intent(in) ::iat,jat
+      integer, intent(in) ::ityp,jtyp
       real(kind=GP), intent(in) ::cni,cnj
       real(kind=GP) :: c6cn
       integer       :: i,j
@@ -9403,12 +9463,12 @@ contains
       c6cn=0.0_GP
       top=0.0_GP
       bottom=0.0_GP
-      do i=1,vdwparams%maxcn(iat)
-         do j=1,vdwparams%maxcn(jat)
-            c6_ref=vdwparams_c6ab(iat,jat,i,j,1)
+      do i=1,d3tab%maxcn(ityp)
+         do j=1,d3tab%maxcn(jtyp)
+            c6_ref=d3tab%c6ref(i,j,ityp,jtyp)
             if (c6_ref.gt.0.0_GP) then
-               cna=vdwparams_c6ab(iat,jat,i,j,2)
-               cnb=vdwparams_c6ab(iat,jat,i,j,3)
+               cna=d3tab%cnref(i,ityp)
+               cnb=d3tab%cnref(j,jtyp)
                dist=(cna-cni)**2+(cnb-cnj)**2
                top=top+exp(k3*dist)*c6_ref
                bottom=bottom+exp(k3*dist)
@@ -9422,20 +9482,24 @@ contains
          c6cn=0.0_GP
       endif
   end function c6cn
-  function crd_nr(iat,nat,xyz,atoms)
-    
-      use module_atoms
- 
+
+  !> Contribution to the coordination number of a neighbour at distance r
+  pure function crd_count(rcov,r)
       implicit none
- 
-      type(atoms_data),                 intent(in) :: atoms
- 
-      real(kind=GP)                               :: crd_nr
-      integer ,intent(in)                         :: iat,nat
-      !!integer ,DIMENSION(nat),intent(in)          :: iz
+      real(kind=GP), intent(in) :: rcov,r
+      real(kind=GP) :: crd_count
+
+      crd_count=1.0_GP/(1.0_GP+exp(-k1*(rcov/r-1.0_GP)))
+  end function crd_count
+
+  !> Coordination number of atom iat
+  pure function crd_nr(iat,nat,xyz,iatype)
+      implicit none
+      integer, intent(in)                         :: iat,nat
       real(kind=GP), DIMENSION(3,nat),intent(in)  :: xyz
+      integer, DIMENSION(nat), intent(in)         :: iatype
+      real(kind=GP)                               :: crd_nr
       real(kind=GP)                               :: dx,dy,dz,r,rcov
-
       integer                                     :: i
         
       crd_nr=0.0_GP
@@ -9445,14 +9509,144 @@ contains
             dy=xyz(2,iat)-xyz(2,i)
             dz=xyz(3,iat)-xyz(3,i)
             r=sqrt(dx*dx+dy*dy+dz*dz)
-            !!rcov=vdwparams%cov_table(iz(i))+vdwparams%cov_table(iz(iat))
-            rcov = vdwparams%cov_table(atoms%nzatom(atoms%astruct%iatype(i)))+&
-             vdwparams%cov_table(atoms%nzatom(atoms%astruct%iatype(iat)))
-            crd_nr=crd_nr+1.0_GP/(1.0_GP+exp(-k1*(rcov/r-1.0_GP)))
+            rcov=d3tab%rcov(iatype(i))+d3tab%rcov(iatype(iat))
+            crd_nr=crd_nr+crd_count(rcov,r)
          endif
       enddo
   end function crd_nr
 
+  !> Build the reference C6 tables of the D3 correction for the species of atoms,
+  !! if they changed, and bring the coordination numbers to the geometry rxyz.
+  !! When only a few atoms moved since the last call, the coordination numbers of
+  !! the others are corrected by the contributions of the moved atoms only.
+  subroutine d3tables_update(atoms,rxyz)
+      use module_atoms
+      implicit none
+      type(atoms_data), intent(in) :: atoms
+      real(kind=GP), DIMENSION(3,atoms%astruct%nat), intent(in) :: rxyz
+      !local variables
+      integer :: nat,ntypes,ityp,jtyp,i,j,iat,jat,im,nmoved
+      real(kind=GP) :: dx,dy,dz,r,rold,rcov
+      integer, DIMENSION(:), allocatable :: moved
+
+      nat=atoms%astruct%nat
+      ntypes=atoms%astruct%ntypes
+
+      !species tables
+      if (d3tab%ntypes /= ntypes) then
+         call vdwcorrection_finalize()
+      else if (any(d3tab%nzatom /= atoms%nzatom(1:ntypes))) then
+         call vdwcorrection_finalize()
+      end if
+      if (d3tab%ntypes == 0) then
+         d3tab%ntypes=ntypes
+         d3tab%nzatom=f_malloc_ptr(ntypes,id='d3tab%nzatom')
+         d3tab%maxcn=f_malloc_ptr(ntypes,id='d3tab%maxcn')
+         d3tab%rcov=f_malloc_ptr(ntypes,id='d3tab%rcov')
+         d3tab%nzatom=atoms%nzatom(1:ntypes)
+         do ityp=1,ntypes
+            d3tab%maxcn(ityp)=vdwparams%maxcn(d3tab%nzatom(ityp))
+            d3tab%rcov(ityp)=vdwparams%cov_table(d3tab%nzatom(ityp))
+         end do
+         d3tab%mxcn=maxval(d3tab%maxcn)
+         d3tab%cnref=f_malloc0_ptr((/d3tab%mxcn,ntypes/),id='d3tab%cnref')
+         d3tab%c6ref=f_malloc0_ptr((/d3tab%mxcn,d3tab%mxcn,ntypes,ntypes/),&
+              id='d3tab%c6ref')
+         do ityp=1,ntypes
+            do i=1,d3tab%maxcn(ityp)
+               d3tab%cnref(i,ityp)=vdwparams_c6ab(d3tab%nzatom(ityp),d3tab%nzatom(ityp),i,i,2)
+            end do
+         end do
+         do jtyp=1,ntypes
+            do ityp=1,ntypes
+               do j=1,d3tab%maxcn(jtyp)
+                  do i=1,d3tab%maxcn(ityp)
+                     d3tab%c6ref(i,j,ityp,jtyp)=&
+                          vdwparams_c6ab(d3tab%nzatom(ityp),d3tab%nzatom(jtyp),i,j,1)
+                  end do
+               end do
+            end do
+         end do
+      end if
+
+      !coordination numbers
+      if (d3tab%nat /= nat) then
+         call d3tables_free_geometry()
+      else if (any(d3tab%iatype /= atoms%astruct%iatype(1:nat))) then
+         call d3tables_free_geometry()
+      end if
+
+      if (d3tab%nat == 0) then
+         d3tab%nat=nat
+         d3tab%iatype=f_malloc_ptr(nat,id='d3tab%iatype')
+         d3tab%rxyz=f_malloc_ptr((/3,nat/),id='d3tab%rxyz')
+         d3tab%cn=f_malloc_ptr(nat,id='d3tab%cn')
+         d3tab%iatype=atoms%astruct%iatype(1:nat)
+         nmoved=nat
+      else
+         nmoved=0
+         do iat=1,nat
+            if (any(rxyz(:,iat) /= d3tab%rxyz(:,iat))) nmoved=nmoved+1
+         end do
+         if (nmoved == 0) return
+         if (d3tab%nupdate >= D3_CN_REFRESH) nmoved=nat
+      end if
+
+      if (4*nmoved > nat) then
+         !$omp parallel do default(shared) private(iat)
+         do iat=1,nat
+            d3tab%cn(iat)=crd_nr(iat,nat,rxyz,d3tab%iatype)
+         end do
+         !$omp end parallel do
+         d3tab%nupdate=0
+      else
+         moved=f_malloc(nmoved,id='moved')
+         im=0
+         do iat=1,nat
+            if (any(rxyz(:,iat) /= d3tab%rxyz(:,iat))) then
+               im=im+1
+               moved(im)=iat
+            end if
+         end do
+         !$omp parallel do default(shared) private(iat,jat,im,dx,dy,dz,r,rold,rcov)
+         do iat=1,nat
+            if (any(rxyz(:,iat) /= d3tab%rxyz(:,iat))) then
+               d3tab%cn(iat)=crd_nr(iat,nat,rxyz,d3tab%iatype)
+            else
+               do im=1,nmoved
+                  jat=moved(im)
+                  rcov=d3tab%rcov(d3tab%iatype(jat))+d3tab%rcov(d3tab%iatype(iat))
+                  dx=rxyz(1,iat)-rxyz(1,jat)
+                  dy=rxyz(2,iat)-rxyz(2,jat)
+                  dz=rxyz(3,iat)-rxyz(3,jat)
+                  r=sqrt(dx*dx+dy*dy+dz*dz)
+                  dx=d3tab%rxyz(1,iat)-d3tab%rxyz(1,jat)
+                  dy=d3tab%rxyz(2,iat)-d3tab%rxyz(2,jat)
+                  dz=d3tab%rxyz(3,iat)-d3tab%rxyz(3,jat)
+                  rold=sqrt(dx*dx+dy*dy+dz*dz)
+                  d3tab%cn(iat)=d3tab%cn(iat)+(crd_count(rcov,r)-crd_count(rcov,rold))
+               end do
+            end if
+         end do
+         !$omp end parallel do
+         call f_free(moved)
+         d3tab%nupdate=d3tab%nupdate+1
+      end if
+      d3tab%rxyz=rxyz
+
+  end subroutine d3tables_update
+
+  !> Forget the coordination numbers of the last geometry
+  subroutine d3tables_free_geometry()
+      implicit none
+
+      call f_free_ptr(d3tab%iatype)
+      call f_free_ptr(d3tab%rxyz)
+      call f_free_ptr(d3tab%cn)
+      d3tab%nat=0
+      d3tab%nupdate=0
+  end subroutine d3tables_free_geometry
+
   subroutine crd_nr_der(n,xyz,cnij,cnijk,atoms)
  
       use module_atoms
@@ -9494,13 +9688,12 @@ contains
       end do
   END SUBROUTINE crd_nr_der
   !!subroutine c6_grad(grad,iat,jat,kat,x,z,n,cnij,cnijk,atoms)
-  subroutine c6_grad(grad,iat,jat,kat,x,n,cnij,cnijk,atoms)
+  subroutine c6_grad(grad,iat,jat,kat,n,cnij,cnijk,atoms)
       use module_atoms
       implicit none
  
       type(atoms_data),                 intent(in) :: atoms
       integer, intent(in)                          :: n,iat,jat,kat
-      real(kind=GP), DIMENSION(3,n),intent(in)     :: x
 !!      integer, DIMENSION(n),intent(in)             :: z
       real(kind=GP), DIMENSION(3),intent(out)      :: grad
       real(kind=GP), DIMENSION(3,n),intent(in)    :: cnij
@@ -9508,15 +9701,15 @@ contains
 
       real(kind=GP), DIMENSION(3)                  :: cnik
       real(kind=GP), DIMENSION(3)                  :: cnjk
-      integer                                      :: i, j
+      integer                                      :: i, j, ityp, jtyp
       real(kind=GP)                                :: cni,cnj
       real(kind=GP)                                :: t1,t2,dt1x,dt1y,dt1z,dt2x,dt2y,dt2z
       real(kind=GP)                                :: tmp1,tmp2,tmp3,tmp4,fac1,fac2
  
-      !!   cni=crd_nr(iat,n,x,z)
-      cni  = crd_nr(iat,n,x,atoms)
-      !!    cnj=crd_nr(jat,n,x,z)
-      cnj  = crd_nr(jat,n,x,atoms)
+      ityp = atoms%astruct%iatype(iat)
+      jtyp = atoms%astruct%iatype(jat)
+      cni  = d3tab%cn(iat)
+      cnj  = d3tab%cn(jat)
       if (iat.eq.kat) then
          cnik(1)=cnij(1,iat)
          cnik(2)=cnij(2,iat)
@@ -9540,15 +9733,15 @@ contains
       dt2x=0.0_GP
       dt2y=0.0_GP
       dt2z=0.0_GP
-      do i=1,vdwparams%maxcn(atoms%nzatom(atoms%astruct%iatype(iat)))
-        do j=1,vdwparams%maxcn(atoms%nzatom(atoms%astruct%iatype(jat)))
-          tmp1=vdwparams_c6AB(atoms%nzatom(atoms%astruct%iatype(iat)),atoms%nzatom(atoms%astruct%iatype(jat)),i,j,3)-cnj
-          tmp2=vdwparams_c6AB(atoms%nzatom(atoms%astruct%iatype(iat)),atoms%nzatom(atoms%astruct%iatype(jat)),i,j,2)-cni
+      do i=1,d3tab%maxcn(ityp)
+        do j=1,d3tab%maxcn(jtyp)
+          tmp1=d3tab%cnref(j,jtyp)-cnj
+          tmp2=d3tab%cnref(i,ityp)-cni
           tmp3=exp(k3*(tmp1*tmp1+tmp2*tmp2))
-          t1=t1+vdwparams_c6AB(atoms%nzatom(atoms%astruct%iatype(iat)),atoms%nzatom(atoms%astruct%iatype(jat)),i,j,1)*tmp3
+          t1=t1+d3tab%c6ref(i,j,ityp,jtyp)*tmp3
           t2=t2+tmp3
           fac1=tmp3*k3*2.0_GP
-          fac2=fac1*vdwparams_c6AB(atoms%nzatom(atoms%astruct%iatype(iat)),atoms%nzatom(atoms%astruct%iatype(jat)),i,j,1)
+          fac2=fac1*d3tab%c6ref(i,j,ityp,jtyp)
           tmp4=(tmp2*cnik(1)+tmp1*cnjk(1))
           dt1x=dt1x+fac2*tmp4
           dt2x=dt2x+fac1*tmp4
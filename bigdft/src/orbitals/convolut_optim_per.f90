@@ -18,7 +18,7 @@ subroutine ana_rot_per(n,ndat,x,y)
   real(wp), dimension(0:2*n+1,ndat), intent(in) :: x
   real(wp), dimension(ndat,0:2*n+1), intent(out) :: y
   !local variables
-  integer :: i,j,k,l
+  integer :: i,j,k,l,idone
   real(wp) :: ci,di
   real(wp), dimension(-7:8) :: ch,cg
   !       Daubechy S16
@@ -47,6 +47,10 @@ subroutine ana_rot_per(n,ndat,x,y)
 
   !write(*,*) 'ana_rot_per executed'
 
+  !variant of the machine profile (AVX or conv1d kernels of convolutions-c)
+  call conv1d_ana_rot_per_dispatch(n,ndat,x,y,idone)
+  if (idone /= 0) return
+
   call fill_mod_arr(mod_arr,-7,2*n+8,2*n+2)
   
   !dee
@@ -155,7 +159,7 @@ subroutine syn_rot_per(n,ndat,x,y)
   real(wp), dimension(0:2*n+1,ndat), intent(in) :: x
   real(wp), dimension(ndat,0:2*n+1), intent(out) :: y
   !local variables
-  integer :: i,j,k,l
+  integer :: i,j,k,l,idone
   real(wp) :: so,se
   real(wp), dimension(-8:9) :: ch,cg
   !       Daubechy S16
@@ -196,6 +200,10 @@ subroutine syn_rot_per(n,ndat,x,y)
 
 
 
+  !variant of the machine profile (AVX or conv1d kernels of convolutions-c)
+  call conv1d_syn_rot_per_dispatch(n,ndat,x,y,idone)
+  if (idone /= 0) return
+
   call fill_mod_arr(mod_arr,-4,n+4,n+1)
 
 !dee
@@ -555,6 +563,11 @@ subroutine convrot_n_per(n1,ndat,x,y)
   integer :: mod_arr(lowfil:n1+lupfil)   
   integer :: i,j,l,k
   real(wp) :: fill,tt1,tt2,tt3,tt4,tt5,tt6,tt7,tt8
+  integer :: idone
+
+  !variant of the machine profile (AVX or conv1d kernels of convolutions-c)
+  call conv1d_convrot_n_per_dispatch(n1,ndat,x,y,idone)
+  if (idone /= 0) return
 
   call fill_mod_arr(mod_arr,lowfil,n1+lupfil,n1+1)
 
@@ -680,6 +693,11 @@ subroutine convrot_t_per(n1,ndat,x,y)
   integer :: i,j,l,k
   integer :: mod_arr(lowfil:n1+lupfil)   
   real(wp) :: fill,tt1,tt2,tt3,tt4,tt5,tt6,tt7,tt8,tt9,tt10,tt11,tt12,tt
+  integer :: idone
+
+  !variant of the machine profile (AVX or conv1d kernels of convolutions-c)
+  call conv1d_convrot_t_per_dispatch(n1,ndat,x,y,idone)
+  if (idone /= 0) return
 
   call fill_mod_arr(mod_arr,lowfil,n1+lupfil,n1+1)
 
@@ -890,6 +908,8 @@ END SUBROUTINE convrot_t_per_test
 
 
 !> Applies the kinetic energy operator onto x to get y. Works for periodic BC
+!! The operator of convolutions-c/conv1d.hpp is used unless the dispatch is
+!! off (BIGDFT_CONV_DISPATCH=no), in which case the loops below are run.
 !! This routines is used by OpenCL/conv_check.f90
 subroutine convolut_kinetic_per_c(n1,n2,n3,hgrid,x,y,c)
   use module_defs, only: wp,gp
@@ -910,7 +930,10 @@ subroutine convolut_kinetic_per_c(n1,n2,n3,hgrid,x,y,c)
   integer, dimension(lowfil:n3+lupfil) :: mod_arr3   
   real(wp), dimension(3) :: scale
   real(wp), dimension(lowfil:lupfil,3) :: fil
-  integer :: k
+  integer :: k,idone
+
+  call conv1d_kinetic_per_c_dispatch(n1,n2,n3,hgrid,x,y,c,idone)
+  if (idone /= 0) return
 
   !$omp parallel default(private) shared(x,y,n1,n2,n3,c,hgrid,fil,mod_arr1,mod_arr2,mod_arr3)
   call fill_mod_arr(mod_arr1,lowfil,n1+lupfil,n1+1)
@@ -357,6 +357,73 @@ subroutine apply_potential_lr_conf(n1i,n2i,n3i,n1ip,n2ip,n3ip,ishift,n2,n3,&
 END SUBROUTINE apply_potential_lr_conf
 
 
+!> Apply the local potential, plus the confining potential of each orbital, to a block
+!! of ndat orbitals of the same localisation region (free BC, potential box equal to the
+!! wavefunction box), so that the potential is read once for the whole block.
+!! The arithmetic is the one of apply_potential_lr_conf (or of apply_potential_lr_bounds
+!! for the orbitals without confinement), orbital by orbital.
+subroutine apply_potential_lr_conf_block(n1i,n2i,n3i,n2,n3,ndat,psir,pot,epot,confdata,ibyyzz_r)
+  use module_defs
+  use dynamic_memory
+  use locreg_operations, only: confpot_data
+  implicit none
+  integer, intent(in) :: n1i,n2i,n3i,n2,n3,ndat
+  real(wp), dimension(n1i,n2i,n3i,ndat), intent(inout) :: psir !< real-space wfns in lr
+  real(wp), dimension(n1i,n2i,n3i), intent(in) :: pot !< real-space pot in lr
+  real(gp), dimension(ndat), intent(out) :: epot
+  type(confpot_data), dimension(ndat), intent(in) :: confdata !< data for the confining potentials
+  integer, dimension(2,-14:2*n2+16,-14:2*n3+16), intent(in) :: ibyyzz_r !< bounds in lr
+  !local variables
+  integer :: i1,i2,i3,idat,i1st,i1et
+  real(wp) :: tt11,cp,r2,x,psir1,pot1
+  logical, dimension(ndat) :: confining
+  integer, dimension(ndat) :: potorder_half
+  real(wp), dimension(ndat) :: y2,z2
+
+  call f_routine(id='apply_potential_lr_conf_block')
+
+  do idat=1,ndat
+     epot(idat)=0.0_wp
+     confining(idat)= confdata(idat)%potorder /= 0
+     potorder_half(idat)=confdata(idat)%potorder/2
+  end do
+
+  !$omp parallel do default(shared) reduction(+:epot) &
+  !$omp private(i1,i2,i3,idat,i1st,i1et,tt11,cp,r2,x,psir1,pot1,y2,z2)
+  do i3=1,n3i
+     do i2=1,n2i
+        i1st=ibyyzz_r(1,i2-15,i3-15)+1
+        i1et=min(n1i,ibyyzz_r(2,i2-15,i3-15)+1)
+        if (i1st > i1et) cycle
+        do idat=1,ndat
+           y2(idat)=(confdata(idat)%hh(2)*real(i2+confdata(idat)%ioffset(2),wp)-confdata(idat)%rxyzConf(2))**2
+           z2(idat)=(confdata(idat)%hh(3)*real(i3+confdata(idat)%ioffset(3),wp)-confdata(idat)%rxyzConf(3))**2
+        end do
+        do i1=max(1,i1st),i1et
+           pot1=pot(i1,i2,i3)
+           do idat=1,ndat
+              psir1=psir(i1,i2,i3,idat)
+              if (confining(idat)) then
+                 x=confdata(idat)%hh(1)*real(i1+confdata(idat)%ioffset(1),wp)-confdata(idat)%rxyzConf(1)
+                 r2=x**2+y2(idat)+z2(idat)
+                 cp=confdata(idat)%prefac*r2**potorder_half(idat)
+                 tt11=(pot1+cp)*psir1
+              else
+                 tt11=pot1*psir1
+              end if
+              epot(idat)=epot(idat)+tt11*psir1
+              psir(i1,i2,i3,idat)=tt11
+           end do
+        end do
+     end do
+  end do
+  !$omp end parallel do
+
+  call f_release_routine()
+
+END SUBROUTINE apply_potential_lr_conf_block
+
+
 !> Routine for applying the local potential
 !! Support the adding of a confining potential and the localisation region of the potential
 subroutine apply_potential_lr_conf_nobounds(n1i,n2i,n3i,n1ip,n2ip,n3ip,ishift,n2,n3,nspinor,npot,psir,pot,epot,confdata)
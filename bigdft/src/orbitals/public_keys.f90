@@ -146,6 +146,7 @@ module public_keys
   character(len = *), parameter :: NOSE_FREQUENCY = "nose_frequency"
   character(len = *), parameter :: ALWAYS_FROM_SCRATCH = "always_from_scratch"
   character(len = *), parameter :: WAVEFUNCTION_EXTRAPOLATION="wavefunction_extrapolation"
+  character(len = *), parameter :: WAVEFUNCTION_HISTORY_PRECISION="wavefunction_history_precision"
   character(len = *), parameter :: RESTART_POS="restart_pos"
   character(len = *), parameter :: RESTART_VEL="restart_vel"
   character(len = *), parameter :: RESTART_NOSE="restart_nose"
@@ -190,6 +191,8 @@ module public_keys
   character(len = *), parameter :: BLAS = "blas"
   character(len = *), parameter :: PROJRAD = "projrad"
   character(len = *), parameter :: EXCTXPAR = "exctxpar"
+  character(len = *), parameter :: EXCTX_SCREENING = "exctx_screening"
+  character(len = *), parameter :: EXCTX_PERSISTENT = "exctx_persistent"
   character(len = *), parameter :: IG_DIAG = "ig_diag"
   character(len = *), parameter :: IG_NORBP = "ig_norbp"
   character(len = *), parameter :: IG_BLOCKS = "ig_blocks"
@@ -401,6 +404,7 @@ module public_enums
   integer, parameter :: ETSF=3
   integer, parameter :: CUBE=22
   integer, parameter :: MPI_NATIVE=4 !<native (i.e. non-portable) MPI format
+  integer, parameter :: MPI_BINARY=5 !<binary container written with MPI-IO
 
   integer, parameter :: RPA=-1
   integer, parameter :: FXC=-2
@@ -414,6 +418,12 @@ module public_enums
   integer, parameter, public :: WF_FORMAT_PLAIN      = TEXT
   integer, parameter, public :: WF_FORMAT_BINARY     = BINARY
   integer, parameter, public :: WF_FORMAT_ETSF       = ETSF
+  integer, parameter, public :: WF_FORMAT_MPI_NATIVE = MPI_NATIVE
+
+  !> Storage of the wavefunction history for the extrapolation
+  integer, parameter, public :: WFN_HISTORY_DOUBLE    = 0 !< full copy
+  integer, parameter, public :: WFN_HISTORY_SINGLE    = 1 !< single precision coefficients
+  integer, parameter, public :: WFN_HISTORY_QUANTIZED = 2 !< single precision coarse, 16-bit fine coefficients
 
   !> Output matrix parameters.
   integer, parameter, public :: MATRIX_FORMAT_NONE       = NONE
@@ -421,6 +431,7 @@ module public_enums
   integer, parameter, public :: MATRIX_FORMAT_BINARY     = BINARY
   integer, parameter, public :: MATRIX_FORMAT_ETSF       = ETSF
   integer, parameter, public :: MATRIX_FORMAT_MPI_NATIVE = MPI_NATIVE
+  integer, parameter, public :: MATRIX_FORMAT_MPI_BINARY = MPI_BINARY
 
   !> Output grid parameters.
   ! with these options we would have
@@ -458,6 +469,7 @@ module public_enums
   type(f_enumerator), public :: ENUM_ETSF =f_enumerator('ETSF',ETSF,null())
   type(f_enumerator), public :: ENUM_CUBE =f_enumerator('CUBE',CUBE,null())
   type(f_enumerator), public :: ENUM_BINARY =f_enumerator('BINARY',BINARY,null())
+  type(f_enumerator), public :: ENUM_MPI_NATIVE =f_enumerator('MPI_NATIVE',MPI_NATIVE,null())
 
   !> enumerator for the dumping of the coupling matrix
   type(f_enumerator), public :: DUMP_COUPLING_MATRIX_RPA_ENUM =f_enumerator('rpa',RPA,null())
@@ -17,8 +17,9 @@ subroutine print_logo()
   implicit none
   integer :: namelen,ierr
   character(len=MPI_MAX_PROCESSOR_NAME) :: nodename_local
-  integer :: nthreads
-  !integer, parameter :: ln = 1024
+  integer :: nthreads,iprof
+  integer, parameter :: ln = 1024
+  character(len=ln) :: profile_path
 !$ integer :: omp_get_max_threads
 
 !  call yaml_comment('Daubechies Wavelets for DFT Pseudopotential Calculations',hfill='=')
@@ -69,6 +70,15 @@ subroutine print_logo()
      call yaml_map('Maximal OpenMP threads per MPI task',nthreads)
   endif
 
+  !tuned profile of the periodic convolutions, given by BIGDFT_CONV_PROFILE
+  call conv1d_profile_get(profile_path,ln,iprof)
+  if (iprof == 1) then
+     call yaml_map('Convolution profile',trim(profile_path))
+  else if (iprof == -1) then
+     call yaml_warning('Convolution profile "'//trim(profile_path)//&
+          '" not read, default convolution kernels')
+  end if
+
 END SUBROUTINE print_logo
 
 
@@ -333,6 +333,7 @@ subroutine readmywaves(iproc,filename,iformat,orbs,n1,n2,n3,hx,hy,hz,at,rxyz_old
   use compression
   use m_pawrhoij
   use at_domain, only: domain_periodic_dims
+  use io, only: read_waves_mpi
   implicit none
   integer, intent(in) :: iproc,n1,n2,n3, iformat
   real(gp), intent(in) :: hx,hy,hz
@@ -369,6 +370,20 @@ subroutine readmywaves(iproc,filename,iformat,orbs,n1,n2,n3,hx,hy,hz,at,rxyz_old
 
      call read_waves_etsf(iproc,filename // ".etsf",orbs,n1,n2,n3,hx,hy,hz,at,rxyz_old,rxyz,  &
           wfd,psi)
+  else if (iformat == WF_FORMAT_MPI_NATIVE) then
+     if (present(orblist)) then
+        call read_waves_mpi(iproc,filename // ".mpibin",orbs,n1,n2,n3,hx,hy,hz,at,rxyz_old,rxyz,  &
+             wfd,psi,orblist)
+     else
+        call read_waves_mpi(iproc,filename // ".mpibin",orbs,n1,n2,n3,hx,hy,hz,at,rxyz_old,rxyz,  &
+             wfd,psi)
+     end if
+
+     if (present(pawrhoij)) then
+        call f_open_file(unitwf, file = filename // "-rhoij", binary = .false.)
+        call readrhoij(unitwf, .false., at%astruct%nat, pawrhoij)
+        call f_close(unitwf)
+     end if
   else if (iformat == WF_FORMAT_BINARY .or. iformat == WF_FORMAT_PLAIN) then
      !conditions for periodicity in the three directions
 !!$     perx=(at%astruct%geocode /= 'F')
@@ -501,6 +516,13 @@ subroutine verify_file_presence(filerad,orbs,iformat,nproc)
      return
   end if
 
+  !Then the single file written with MPI-IO, readable with any number of processors
+  inquire(file=trim(filerad)//'.mpibin',exist=onefile)
+  if (onefile) then
+     iformat=WF_FORMAT_MPI_NATIVE
+     return
+  end if
+
   !otherwise, switch to normal input guess
   iformat=WF_FORMAT_NONE
 
@@ -2308,8 +2330,9 @@ subroutine readmywaves_linear_new(iproc,nproc,dir_output,filename,iformat,at,tmb
   use yaml_output
   use module_fragments
   !use internal_io
-  use module_interfaces, only: open_filename_of_iorb, reformat_supportfunctions, plot_wf
-  use io, only: read_coeff_minbasis, io_read_descr_linear, read_psig, io_error, read_dense_matrix_local
+  use module_interfaces, only: open_filename_of_iorb, filename_of_iorb, reformat_supportfunctions, plot_wf
+  use io, only: read_coeff_minbasis, io_read_descr_linear, read_psig, io_error, read_dense_matrix_local, &
+       open_waves_linear_mpi, io_read_descr_linear_mpi, read_psig_mpi, WF_BIN_NHEADER
   use locreg_operations, only: lpsi_to_global2
   use public_enums
   use rototranslations
@@ -2340,6 +2363,7 @@ subroutine readmywaves_linear_new(iproc,nproc,dir_output,filename,iformat,at,tmb
   real(kind=4) :: tr0,tr1
   real(kind=8) :: tel,eval
   character(len=256) :: error, full_filename
+  character(len=500) :: filename_out
   logical :: lstat
   character(len=*), parameter :: subname='readmywaves_linear_new'
   ! to eventually be part of the fragment structure?
@@ -2363,6 +2387,9 @@ subroutine readmywaves_linear_new(iproc,nproc,dir_output,filename,iformat,at,tmb
   type(domain) :: dom
   !!$ integer :: ierr
   type(orbitals_data) :: fake_orbs
+  integer :: thefile
+  integer(f_long), dimension(WF_BIN_NHEADER) :: header
+  integer(f_long), dimension(:), allocatable :: recoff
 
   ! DEBUG
   ! character(len=12) :: orbname
@@ -2377,7 +2404,7 @@ subroutine readmywaves_linear_new(iproc,nproc,dir_output,filename,iformat,at,tmb
   ! check file format
   if (iformat == WF_FORMAT_ETSF) then
      call f_err_throw('Linear scaling with ETSF writing not implemented yet')
-  else if (iformat /= WF_FORMAT_BINARY .and. iformat /= WF_FORMAT_PLAIN) then
+  else if (iformat /= WF_FORMAT_BINARY .and. iformat /= WF_FORMAT_PLAIN .and. iformat /= WF_FORMAT_MPI_NATIVE) then
      call f_err_throw('Unknown wavefunction file format from filename.')
   end if
 
@@ -2430,6 +2457,14 @@ subroutine readmywaves_linear_new(iproc,nproc,dir_output,filename,iformat,at,tmb
                fake_orbs%norbp = fake_orbs%norb
         end if
 
+     ! single file per fragment, opened by all the tasks
+     if (iformat == WF_FORMAT_MPI_NATIVE) then
+        full_filename=trim(dir_output)//trim(input_frag%dirname(ifrag_ref))//trim(filename)//'.mpibin'
+        call open_waves_linear_mpi(trim(full_filename),thefile,header,recoff,lzd_old%hgrids,&
+             ref_frags(ifrag_ref)%astruct_frg%nat,rxyz_old(:,isfat+1:isfat+ref_frags(ifrag_ref)%astruct_frg%nat))
+        if (f_err_check()) call io_error('Cannot read the support functions from '//trim(full_filename))
+     end if
+
      ! loop over orbitals of this fragment
      loop_iforb: do iforb=1,ref_frags(ifrag_ref)%fbasis%forbs%norb
         loop_iorb: do iorbp=1,tmb%orbs%norbp
@@ -2450,7 +2485,21 @@ subroutine readmywaves_linear_new(iproc,nproc,dir_output,filename,iformat,at,tmb
               ! bit of a hack to use orbs here not forbs, but different structures so this is necessary - to clean somehow
               full_filename=trim(dir_output)//trim(input_frag%dirname(ifrag_ref))//trim(filename)
 
-              if (input_frag%nfrag == 1) then
+              if (iformat == WF_FORMAT_MPI_NATIVE) then
+                 ! the record of the support function in the file is its index in the fragment
+                 if (input_frag%nfrag == 1) then
+                    call filename_of_iorb(.true.,full_filename,tmb%orbs,iorbp,ispinor,filename_out,iorb_out,iiorb=iforb)
+                 else
+                    call filename_of_iorb(.true.,full_filename,fake_orbs,iforb,ispinor,filename_out,iorb_out,iiorb=iforb)
+                 end if
+                 call io_read_descr_linear_mpi(thefile,header,recoff,iforb,iorb_old,eval,&
+                      Lzd_old%Llr(ilr)%d%n1,Lzd_old%Llr(ilr)%d%n2,Lzd_old%Llr(ilr)%d%n3, &
+                      Lzd_old%Llr(ilr)%ns1,Lzd_old%Llr(ilr)%ns2,Lzd_old%Llr(ilr)%ns3, &
+                      onwhichatom_tmp,Lzd_old%Llr(ilr)%locrad,Lzd_old%Llr(ilr)%locregCenter, &
+                      confPotOrder,confPotprefac,Lzd_old%Llr(ilr)%wfd)
+                 lstat=.not. f_err_check()
+                 write(error,'(a)') 'cannot read psi description.'
+              else if (input_frag%nfrag == 1) then
                   call open_filename_of_iorb(unitwf,(iformat == WF_FORMAT_BINARY),full_filename, &
                        & tmb%orbs,iorbp,ispinor,iorb_out,iiorb=iforb)
               else
@@ -2458,6 +2507,7 @@ subroutine readmywaves_linear_new(iproc,nproc,dir_output,filename,iformat,at,tmb
                        & fake_orbs,iforb,ispinor,iorb_out,iiorb=iforb)
               end if
 
+              if (iformat /= WF_FORMAT_MPI_NATIVE) then
               ! read headers, reading lzd info directly into lzd_old, which is otherwise nullified
               call io_read_descr_linear(unitwf, (iformat == WF_FORMAT_PLAIN), iorb_old, eval, &
                    Lzd_old%Llr(ilr)%d%n1,Lzd_old%Llr(ilr)%d%n2,Lzd_old%Llr(ilr)%d%n3, &
@@ -2468,6 +2518,7 @@ subroutine readmywaves_linear_new(iproc,nproc,dir_output,filename,iformat,at,tmb
                    nat=ref_frags(ifrag_ref)%astruct_frg%nat, &
                    rxyz_old=rxyz_old(:,isfat+1:isfat+ref_frags(ifrag_ref)%astruct_frg%nat))
                    !ref_frags(ifrag_ref)%astruct_frg%nat, rxyz_old(1,isfat+1))
+              end if
 
               ! in general this might point to a different tmb
               phi_array_old(iorbp)%psig = f_malloc_ptr((/ 0.to.Lzd_old%Llr(ilr)%d%n1 , 1.to.2 , &
@@ -2477,8 +2528,13 @@ subroutine readmywaves_linear_new(iproc,nproc,dir_output,filename,iformat,at,tmb
 
               !read phig directly
               call timing(iproc,'readtmbfiles','ON')
-              call read_psig(unitwf, (iformat == WF_FORMAT_PLAIN), Lzd_old%Llr(ilr)%wfd%nvctr_c, Lzd_old%Llr(ilr)%wfd%nvctr_f, &
-                   Lzd_old%Llr(ilr)%d%n1, Lzd_old%Llr(ilr)%d%n2, Lzd_old%Llr(ilr)%d%n3, phi_array_old(iorbp)%psig, lstat, error)
+              if (iformat == WF_FORMAT_MPI_NATIVE) then
+                 call read_psig_mpi(thefile,header,recoff,iforb,Lzd_old%Llr(ilr)%wfd, &
+                      Lzd_old%Llr(ilr)%d%n1,Lzd_old%Llr(ilr)%d%n2,Lzd_old%Llr(ilr)%d%n3,phi_array_old(iorbp)%psig)
+              else
+                 call read_psig(unitwf, (iformat == WF_FORMAT_PLAIN), Lzd_old%Llr(ilr)%wfd%nvctr_c, Lzd_old%Llr(ilr)%wfd%nvctr_f, &
+                      Lzd_old%Llr(ilr)%d%n1, Lzd_old%Llr(ilr)%d%n2, Lzd_old%Llr(ilr)%d%n3, phi_array_old(iorbp)%psig, lstat, error)
+              end if
               if (.not. lstat) call io_error(trim(error))
               call timing(iproc,'readtmbfiles','OF')
 
@@ -2542,7 +2598,7 @@ subroutine readmywaves_linear_new(iproc,nproc,dir_output,filename,iformat,at,tmb
                  call yaml_warning('Initialize_linear_from_file')
                  stop
               end if
-              close(unitwf)
+              if (iformat /= WF_FORMAT_MPI_NATIVE) close(unitwf)
 
            end do
 
@@ -2551,6 +2607,10 @@ subroutine readmywaves_linear_new(iproc,nproc,dir_output,filename,iformat,at,tmb
 
         end do loop_iorb
      end do loop_iforb
+     if (iformat == WF_FORMAT_MPI_NATIVE) then
+        call mpi_file_close(thefile,ierr)
+        call f_free(recoff)
+     end if
      isforb=isforb+ref_frags(ifrag_ref)%fbasis%forbs%norbu
      isfat=isfat+ref_frags(ifrag_ref)%astruct_frg%nat
 
@@ -2941,7 +3001,7 @@ subroutine readmywaves_linear_new(iproc,nproc,dir_output,filename,iformat,at,tmb
         full_filename=trim(dir_output)//trim(input_frag%dirname(ifrag_ref))//'density_kernel.bin'
         !should fragments have some knowledge of spin?
         !assume kernel is in binary if tmbs are...
-        binary=(iformat == WF_FORMAT_BINARY)
+        binary=(iformat /= WF_FORMAT_PLAIN)
         !!call read_dense_matrix_local(full_filename, binary, tmb%orbs%nspinor, ref_frags(ifrag_ref)%fbasis%forbs%norb, &
         !!     ref_frags(ifrag_ref)%kernel, ref_frags(ifrag_ref)%astruct_frg%nat)
         call read_dense_matrix_local(full_filename, binary, ref_frags(ifrag_ref)%fbasis%forbs%nspin, &
@@ -2953,7 +3013,7 @@ subroutine readmywaves_linear_new(iproc,nproc,dir_output,filename,iformat,at,tmb
            full_filename=trim(dir_output)//trim(input_frag%dirname(ifrag_ref))//'density_kernel_env.bin'
            !should fragments have some knowledge of spin?
            !assume kernel is in binary if tmbs are...
-           binary=(iformat == WF_FORMAT_BINARY)
+           binary=(iformat /= WF_FORMAT_PLAIN)
            !!call read_dense_matrix_local(full_filename, binary, tmb%orbs%nspinor, ref_frags(ifrag_ref)%nbasis_env, &
            !!     ref_frags(ifrag_ref)%kernel_env, ref_frags(ifrag_ref)%astruct_env%nat)
            call read_dense_matrix_local(full_filename, binary, tmb%orbs%nspinor, ref_frags(ifrag_ref)%nbasis_env, &
@@ -2976,7 +3036,7 @@ subroutine readmywaves_linear_new(iproc,nproc,dir_output,filename,iformat,at,tmb
         ! but need the number of electrons of the fragment which isn't stored in that case
         full_filename=trim(dir_output)//trim(input_frag%dirname(ifrag_ref))//trim(filename)//'_coeff.bin'
         !full_filename=trim(dir_output)//trim(input_frag%dirname(ifrag_ref))//'KS_coeffs.bin'
-        call f_open_file(unitwf,file=trim(full_filename),binary=iformat == WF_FORMAT_BINARY)
+        call f_open_file(unitwf,file=trim(full_filename),binary=iformat /= WF_FORMAT_PLAIN)
         call read_coeff_minbasis(unitwf,(iformat == WF_FORMAT_PLAIN),iproc,ref_frags(ifrag_ref)%fbasis%forbs%norb,&
              ref_frags(ifrag_ref)%nelec,ref_frags(ifrag_ref)%fbasis%forbs%norb,ref_frags(ifrag_ref)%coeff,ref_frags(ifrag_ref)%eval)
         !call read_linear_coefficients(mode, bigdft_mpi%iproc, bigdft_mpi%nproc, bigdft_mpi%mpi_comm,&
@@ -106,9 +106,13 @@ subroutine sumrho(dpbox,orbs,Lzd,GPU,symObj,rhodsc,xc,psi,rho_p,mapping)
    logical :: writeout
    integer :: nspinn
    integer :: iorb
+   integer(f_long) :: t0
    integer,dimension(:),allocatable:: localmapping
 
    writeout=dpbox%mpi_env%iproc + dpbox%mpi_env%igroup==0 .and. get_verbose_level() >= 1
+   t0=f_time()
+   !the memory peak of the density construction is reported by communicate_density
+   call f_malloc_mark()
 
    call timing(dpbox%mpi_env%iproc,'Rho_comput    ','ON')
 
@@ -129,11 +133,29 @@ subroutine sumrho(dpbox,orbs,Lzd,GPU,symObj,rhodsc,xc,psi,rho_p,mapping)
    end if
    !print *,'here',Lzd%linear,present(mapping),dpbox%iproc_world
    !write(*,*) 'iproc,rhoarray dim', iproc, Lzd%Glr%d%n1i*Lzd%Glr%d%n2i*nrhotot,nspinn
-   rho_p = f_malloc_ptr((/ Lzd%Glr%d%n1i*Lzd%Glr%d%n2i*rhodsc%nrhotot , nspinn /),id='rho_p')
+   if (rhodsc%icomm==3) then
+      !the density is built directly in the planes of the process
+      rho_p = f_malloc_ptr((/ Lzd%Glr%d%n1i*Lzd%Glr%d%n2i*max(dpbox%n3d,1) , nspinn /),id='rho_p')
+   else
+      rho_p = f_malloc_ptr((/ Lzd%Glr%d%n1i*Lzd%Glr%d%n2i*rhodsc%nrhotot , nspinn /),id='rho_p')
+   end if
 
    !switch between GPU/CPU treatment of the density
    !here also one might decide to save the value of psir and of its laplacian 
-   if (GPU%OCLconv) then
+   if (rhodsc%icomm==3) then
+      if (GPU%OCLconv) call f_err_throw('The density communication OWN is not implemented with OpenCL',&
+           err_name='BIGDFT_RUNTIME_ERROR')
+      if (present(mapping)) then
+         call density_to_plane_owners(dpbox,orbs,Lzd,xc,mapping,psi,nspinn,rho_p)
+      else
+         localmapping = f_malloc(orbs%norb,id='localmapping')
+         do iorb=1,orbs%norb
+            localmapping(iorb)=iorb
+         end do
+         call density_to_plane_owners(dpbox,orbs,Lzd,xc,localmapping,psi,nspinn,rho_p)
+         call f_free(localmapping)
+      end if
+   else if (GPU%OCLconv) then
       call local_partial_density_OCL(orbs,rhodsc%nrhotot,Lzd%Glr,&
            dpbox%mesh%hgrids(1),dpbox%mesh%hgrids(2),dpbox%mesh%hgrids(3),orbs%nspin,psi,rho_p,GPU)
    else if(Lzd%linear) then
@@ -173,6 +195,9 @@ subroutine sumrho(dpbox,orbs,Lzd,GPU,symObj,rhodsc,xc,psi,rho_p,mapping)
       call symmetrise_density(0,1,Lzd%Glr%mesh,&
            dpbox%mesh%ndims(1),dpbox%mesh%ndims(2),dpbox%mesh%ndims(3),orbs%nspin,rho_p,symObj)
    end if
+   if (writeout .and. get_verbose_level() > 2) then
+      call yaml_map('Density accumulation (s)',real(f_time()-t0,dp)*1.e-9_dp,fmt='(f10.4)')
+   end if
    call timing(dpbox%mpi_env%iproc,'Rho_comput    ','OF')
 
  END SUBROUTINE sumrho
@@ -195,6 +220,7 @@ subroutine communicate_density(dpbox,nspin,rhodsc,rho_p,rho,keep_rhop)
   character(len=*), parameter :: subname='communicate_density'
   logical :: dump
   integer :: i1,i2,i3,i3off,i3s,i,ispin,ierr,j3,j3p,j,itmred,n3d,irho
+  integer(f_long) :: t0,mem_mark,mem_peak
   real(dp) :: charge,tt,rhotot_dbl
   real(dp), dimension(:,:), allocatable :: tmred
   !!  real(dp), dimension(:,:), allocatable :: rho_p_OCL
@@ -204,10 +230,17 @@ subroutine communicate_density(dpbox,nspin,rhodsc,rho_p,rho,keep_rhop)
   real(4) ,dimension(:,:),allocatable :: sprho_comp
   
   dump=dpbox%mpi_env%iproc + dpbox%mpi_env%igroup == 0 .and. get_verbose_level() >= 1
+  t0=f_time()
 
   !write(*,*) 'iproc,TIMING:SR1'!,dpbox%iproc_world,real(ncount1-ncount0)/real(ncount_rate)
   !the density must be communicated to meet the shape of the poisson solver
-  if (dpbox%mpi_env%ngroup*dpbox%mpi_env%nproc> 1) then
+  if (rhodsc%icomm==3) then
+     !the density has already been accumulated in the planes of the process
+     if (dump) call yaml_map('Rho Commun','OWN')
+     call timing(dpbox%mpi_env%iproc,'Rho_comput    ','ON')
+     call vcopy(dpbox%mesh%ndims(1)*dpbox%mesh%ndims(2)*dpbox%n3d*nspin,rho_p(1,1),1,&
+          rho(1,1),1)
+  else if (dpbox%mpi_env%ngroup*dpbox%mpi_env%nproc> 1) then
      call timing(dpbox%mpi_env%iproc,'Rho_commun    ','ON')
      !write(*,*) 'rsflag',rsflag
      !communication strategy for the density
@@ -326,6 +359,13 @@ subroutine communicate_density(dpbox,nspin,rhodsc,rho_p,rho,keep_rhop)
   if (.not. keep_rhop) then
      call f_free_ptr(rho_p)
   end if
+
+  !highest memory reached since the beginning of sumrho, on all the processes
+  if (get_verbose_level() > 2) then
+     call f_malloc_memory(mark=mem_mark,peak=mem_peak)
+     mem_peak=mem_peak-mem_mark
+     if (dpbox%mpi_env%nproc > 1) call fmpi_allreduce(mem_peak,1,FMPI_MAX,comm=dpbox%mpi_env%mpi_comm)
+  end if
   
   !print *,'okhere1',dpbox%iproc_world
   !call mpi_barrier(bigdft_mpi%mpi_comm,ierr)
@@ -362,6 +402,13 @@ subroutine communicate_density(dpbox,nspin,rhodsc,rho_p,rho,keep_rhop)
         call yaml_map('Magnetic density orientation',&
              (/(tmred(ispin,1)/tmred(1,1),ispin=2,nspin)/),fmt='(f10.4)')
      end if
+     if (get_verbose_level() > 2) then
+        call yaml_mapping_open('Density construction',flow=.true.)
+        call yaml_map('Memory peak (MB)',real(mem_peak,dp)/1048576.0_dp,fmt='(f10.2)')
+        call yaml_map('Slab (MB)',real(size(rho,kind=f_long)*kind(1.0_dp),dp)/1048576.0_dp,fmt='(f10.2)')
+        call yaml_map('Communication (s)',real(f_time()-t0,dp)*1.e-9_dp,fmt='(f10.4)')
+        call yaml_mapping_close()
+     end if
      call yaml_newline()
   end if
 !call yaml_mapping_close()
@@ -372,6 +419,360 @@ subroutine communicate_density(dpbox,nspin,rhodsc,rho_p,rho,keep_rhop)
 
 end subroutine communicate_density
 
+!> Build the density of the orbitals of the process and accumulate it directly
+!! in the planes of the processes which own them (OWN communication, rhodsc%icomm==3).
+!! In the linear code the orbitals are treated by batches of one orbital per thread,
+!! in boxes of the size of the largest localisation region. The boxes of the same
+!! region are summed among the threads, then each plane of the remaining boxes is
+!! accumulated in the slab of its owners with one-sided communications.
+!! In the cubic code all the orbitals live in the simulation domain: a single box is
+!! filled orbital after orbital (daub_to_isf is threaded) and sent once per spin, it
+!! replaces the partial density of the reduce-scatter scheme.
+subroutine density_to_plane_owners(dpbox,orbs,Lzd,xc,mapping,psi,nspinn,rho_p)
+  use module_base
+  use module_dpbox, only: denspot_distribution
+  use module_types
+  use module_xc
+  use locregs
+  use locreg_operations
+  implicit none
+  integer, intent(in) :: nspinn
+  type(denspot_distribution), intent(in) :: dpbox
+  type(orbitals_data), intent(in) :: orbs
+  type(local_zone_descriptors), intent(in), target :: Lzd
+  type(xc_info), intent(in) :: xc
+  integer, dimension(orbs%norb), intent(in) :: mapping
+  real(wp), dimension(orbs%npsidim_orbs), intent(in) :: psi
+  real(dp), dimension(dpbox%mesh%ndims(1)*dpbox%mesh%ndims(2)*max(dpbox%n3d,1),nspinn), intent(inout) :: rho_p
+  !local variables
+  integer :: nslot,islot,istride,nbatch,ibatch,iorb,ilr,npsir,ncomplex,ncomp
+  integer :: oidx,sidx,ndimpsir,npts,icomp,ispin
+  real(gp) :: hfac
+  type(fmpi_win) :: win
+  type(locreg_descriptors), pointer :: lr
+  type(workarr_sumrho), dimension(:), allocatable :: w
+  integer, dimension(:), allocatable :: ispsi,slot_ilr,slot_spin
+  logical, dimension(:), allocatable :: slot_send
+  real(wp), dimension(:,:,:), allocatable :: psir
+  real(dp), dimension(:,:), allocatable :: boxes
+  !$ integer :: omp_get_max_threads
+
+  call f_routine(id='density_to_plane_owners')
+
+  !components of wavefunction in real space which must be considered simultaneously
+  if (orbs%nspinor ==4) then
+     npsir=4
+     ncomplex=0
+  else
+     npsir=1
+     ncomplex=orbs%nspinor-1
+  end if
+  !components of the density stored in each box
+  ncomp=1
+  if (npsir == 4) ncomp=nspinn
+
+  !each process is only owner of its planes, no need to divide the initial value
+  call xc_init_rho(xc,size(rho_p),rho_p,1)
+
+  !one box per thread in the linear code, a single one of the size of the domain
+  !in the cubic code
+  nslot=1
+  !$ if (Lzd%linear) nslot=omp_get_max_threads()
+
+  !starting point of each orbital in psi and size of the boxes
+  ispsi=f_malloc(orbs%norbp+1,id='ispsi')
+  ispsi(1)=1
+  ndimpsir=1
+  do iorb=1,orbs%norbp
+     call orbital_locreg(iorb,ilr,lr)
+     ispsi(iorb+1)=ispsi(iorb)+(lr%wfd%nvctr_c+7*lr%wfd%nvctr_f)*orbs%nspinor
+     ndimpsir=max(ndimpsir,lr%d%n1i*lr%d%n2i*lr%d%n3i)
+  end do
+
+  !all the processes should open the same number of epochs
+  nbatch=(orbs%norbp+nslot-1)/nslot
+  if (dpbox%mpi_env%nproc > 1) call fmpi_allreduce(nbatch,1,FMPI_MAX,comm=dpbox%mpi_env%mpi_comm)
+
+  allocate(w(0:nslot-1))
+  do islot=0,nslot-1
+     if (Lzd%linear) then
+        call initialize_work_arrays_sumrho(Lzd%nlr,Lzd%Llr,.true.,w(islot))
+     else
+        call initialize_work_arrays_sumrho(Lzd%Glr,.true.,w(islot))
+     end if
+  end do
+  psir=f_malloc((/ ndimpsir,npsir,nslot /),id='psir')
+  boxes=f_malloc((/ ndimpsir*ncomp,nslot /),id='boxes')
+  !a negative region marks an empty box
+  slot_ilr=f_malloc(0.to.nslot-1,id='slot_ilr')
+  slot_spin=f_malloc(0.to.nslot-1,id='slot_spin')
+  slot_send=f_malloc(0.to.nslot-1,id='slot_send')
+  slot_ilr=-1
+
+  if (dpbox%mpi_env%nproc > 1) then
+     call fmpi_win_create(win,rho_p(1,1),size(rho_p),dpbox%mpi_env%mpi_comm)
+     call fmpi_win_fence(win,FMPI_WIN_OPEN)
+  end if
+
+  do ibatch=1,nbatch
+     !the boxes sent in the previous batch are origin buffers of the accumulations,
+     !the epoch is closed before they are filled again
+     if (ibatch > 1 .and. dpbox%mpi_env%nproc > 1) then
+        call timing(dpbox%mpi_env%iproc,'Rho_comput    ','OF')
+        call timing(dpbox%mpi_env%iproc,'Rho_commun    ','ON')
+        call fmpi_win_fence(win,FMPI_WIN_CLOSE)
+        call fmpi_win_fence(win,FMPI_WIN_OPEN)
+        call timing(dpbox%mpi_env%iproc,'Rho_commun    ','OF')
+        call timing(dpbox%mpi_env%iproc,'Rho_comput    ','ON')
+     end if
+
+     !with a single box the threads are left to the convolutions of daub_to_isf
+     !$omp parallel if (nslot > 1) default(shared) &
+     !$omp private(islot,iorb,ilr,lr,hfac,oidx,sidx,npts,istride,ispin)
+     !$omp do schedule(static,1)
+     do islot=0,nslot-1
+        iorb=(ibatch-1)*nslot+islot+1
+        slot_send(islot)=slot_ilr(islot) >= 0 .and. .not. keep_box(iorb,islot)
+        if (iorb > orbs%norbp) cycle
+        call orbital_locreg(iorb,ilr,lr)
+        hfac=orbs%kwgts(orbs%iokpt(iorb))*(orbs%occup(mapping(orbs%isorb+iorb))/lr%mesh%volume_element)
+        if (hfac == 0.0_gp) cycle
+        if (Lzd%linear .and. lr%hybrid_on) stop 'ERROR, ilr not initialized'
+        npts=lr%d%n1i*lr%d%n2i*lr%d%n3i
+        ispin=orbital_spin(iorb)
+        !a box kept from the previous batch has the same region and spin
+        if (slot_ilr(islot) < 0) boxes(1:npts*ncomp,islot+1)=0.0_dp
+        slot_ilr(islot)=ilr
+        slot_spin(islot)=ispin
+        do oidx=0,ncomplex
+           do sidx=1,npsir
+              call daub_to_isf(lr,w(islot),&
+                   psi(ispsi(iorb)+(oidx+sidx-1)*(lr%wfd%nvctr_c+7*lr%wfd%nvctr_f)),&
+                   psir(1,sidx,islot+1))
+           end do
+           call box_density(npts,npsir,real(hfac,dp),psir(1,1,islot+1),boxes(1,islot+1))
+        end do
+        slot_send(islot)=.not. keep_box(iorb,islot)
+     end do
+     !$omp end do
+
+     !sum the boxes of the same region among the threads
+     istride=1
+     do while(istride < nslot)
+        !$omp do schedule(static,1)
+        do islot=0,nslot-1-istride,2*istride
+           if (slot_ilr(islot) < 0 .or. slot_ilr(islot+istride) < 0) cycle
+           if (slot_ilr(islot) /= slot_ilr(islot+istride) .or. &
+                slot_spin(islot) /= slot_spin(islot+istride)) cycle
+           ilr=slot_ilr(islot)
+           call orbital_locreg(0,ilr,lr)
+           npts=lr%d%n1i*lr%d%n2i*lr%d%n3i
+           call axpy(npts*ncomp,1.0_dp,boxes(1,islot+istride+1),1,boxes(1,islot+1),1)
+           slot_ilr(islot+istride)=-1
+        end do
+        !$omp end do
+        istride=2*istride
+     end do
+     !$omp end parallel
+
+     call timing(dpbox%mpi_env%iproc,'Rho_comput    ','OF')
+     call timing(dpbox%mpi_env%iproc,'Rho_commun    ','ON')
+     do islot=0,nslot-1
+        if (slot_ilr(islot) < 0 .or. .not. slot_send(islot)) cycle
+        ilr=slot_ilr(islot)
+        call orbital_locreg(0,ilr,lr)
+        npts=lr%d%n1i*lr%d%n2i*lr%d%n3i
+        do icomp=1,ncomp
+           ispin=slot_spin(islot)
+           if (ispin == 0) ispin=icomp
+           call box_to_plane_owners(dpbox,Lzd%Glr,lr,ispin,nspinn,&
+                boxes(1+(icomp-1)*npts,islot+1),win,rho_p)
+        end do
+        !free again once the epoch is closed
+        slot_ilr(islot)=-1
+     end do
+     call timing(dpbox%mpi_env%iproc,'Rho_commun    ','OF')
+     call timing(dpbox%mpi_env%iproc,'Rho_comput    ','ON')
+  end do
+
+  if (dpbox%mpi_env%nproc > 1) then
+     call timing(dpbox%mpi_env%iproc,'Rho_comput    ','OF')
+     call timing(dpbox%mpi_env%iproc,'Rho_commun    ','ON')
+     call fmpi_win_shut(win)
+     call timing(dpbox%mpi_env%iproc,'Rho_commun    ','OF')
+     call timing(dpbox%mpi_env%iproc,'Rho_comput    ','ON')
+  end if
+
+  do islot=0,nslot-1
+     call deallocate_work_arrays_sumrho(w(islot))
+  end do
+  deallocate(w)
+  call f_free(psir)
+  call f_free(boxes)
+  call f_free(slot_ilr)
+  call f_free(slot_spin)
+  call f_free(slot_send)
+  call f_free(ispsi)
+
+  call f_release_routine()
+
+contains
+
+  !> Localisation region of the orbital iorb of the process, or of the region ilr if iorb==0
+  subroutine orbital_locreg(iorb,ilr,lr)
+    implicit none
+    integer, intent(in) :: iorb
+    integer, intent(inout) :: ilr
+    type(locreg_descriptors), pointer :: lr
+    if (Lzd%linear) then
+       if (iorb > 0) ilr=orbs%inwhichlocreg(orbs%isorb+iorb)
+       lr => Lzd%Llr(ilr)
+    else
+       if (iorb > 0) ilr=0
+       lr => Lzd%Glr
+    end if
+  end subroutine orbital_locreg
+
+  !> Spin of the box of the orbital iorb, 0 for spinors (all the components)
+  pure function orbital_spin(iorb) result(ispin)
+    implicit none
+    integer, intent(in) :: iorb
+    integer :: ispin
+    if (npsir == 4) then
+       ispin=0
+    else if (orbs%spinsgn(orbs%isorb+iorb) > 0.0_gp) then
+       ispin=1
+    else
+       ispin=2
+    end if
+  end function orbital_spin
+
+  !> True if the box of the slot can wait for the next orbital of the process:
+  !! only with a single slot, when the next orbital has the same region and spin
+  function keep_box(iorb,islot) result(keep)
+    implicit none
+    integer, intent(in) :: iorb,islot
+    logical :: keep
+    integer :: jlr
+    type(locreg_descriptors), pointer :: jlrd
+    keep=nslot == 1 .and. iorb < orbs%norbp .and. slot_ilr(islot) >= 0
+    if (.not. keep) return
+    call orbital_locreg(iorb+1,jlr,jlrd)
+    keep=jlr == slot_ilr(islot) .and. orbital_spin(iorb+1) == slot_spin(islot)
+  end function keep_box
+
+end subroutine density_to_plane_owners
+
+
+!> Add the density of one orbital, given in real space, to a box of the same shape
+subroutine box_density(npts,npsir,hfac,psir,box)
+  use module_base
+  implicit none
+  integer, intent(in) :: npts,npsir
+  real(dp), intent(in) :: hfac
+  real(wp), dimension(npts,npsir), intent(in) :: psir
+  real(dp), dimension(npts,npsir), intent(inout) :: box
+  !local variables
+  integer :: i
+  real(dp) :: p1,p2,p3,p4
+
+  if (npsir == 1) then
+     do i=1,npts
+        p1=real(psir(i,1),dp)
+        box(i,1)=box(i,1)+hfac*p1*p1
+     end do
+  else
+     do i=1,npts
+        p1=real(psir(i,1),dp)
+        p2=real(psir(i,2),dp)
+        p3=real(psir(i,3),dp)
+        p4=real(psir(i,4),dp)
+        box(i,1)=box(i,1)+hfac*(p1*p1+p2*p2+p3*p3+p4*p4)
+        box(i,2)=box(i,2)+2.0_dp*hfac*(p1*p3+p2*p4)
+        box(i,3)=box(i,3)+2.0_dp*hfac*(p1*p4-p2*p3)
+        box(i,4)=box(i,4)+hfac*(p1*p1+p2*p2-p3*p3-p4*p4)
+     end do
+  end if
+
+END SUBROUTINE box_density
+
+
+!> Accumulate one component of a localisation region box in the slabs of the processes
+!! which own its planes. The planes in the overlap needed by the GGA are sent to all
+!! the processes which hold them. Whole planes are sent when the region covers the
+!! xy extension of the simulation domain, otherwise its lines are sent, split where
+!! they cross the periodic boundary
+subroutine box_to_plane_owners(dpbox,Glr,lr,ispin,nspinn,box,win,rho_p)
+  use module_base
+  use module_dpbox, only: denspot_distribution
+  use locregs
+  implicit none
+  integer, intent(in) :: ispin,nspinn
+  type(denspot_distribution), intent(in) :: dpbox
+  type(locreg_descriptors), intent(in) :: Glr,lr
+  real(dp), dimension(lr%d%n1i,lr%d%n2i,lr%d%n3i), intent(in) :: box
+  type(fmpi_win), intent(in) :: win
+  real(dp), dimension(dpbox%mesh%ndims(1)*dpbox%mesh%ndims(2)*max(dpbox%n3d,1),nspinn), intent(inout) :: rho_p
+  !local variables
+  logical :: whole
+  integer :: jproc,k,n3d,i3s,j2,j3,n1,n2,n3,i1s,n1s
+  integer(f_address) :: idisp,iplane
+
+  n1=Glr%d%n1i
+  n2=Glr%d%n2i
+  n3=Glr%d%n3i
+  whole=lr%d%n1i == n1 .and. lr%d%n2i == n2 .and. lr%nsi1 == 0 .and. lr%nsi2 == 0
+  !first point of the lines and length until the periodic boundary
+  i1s=modulo(lr%nsi1,n1)+1
+  n1s=min(lr%d%n1i,n1-i1s+1)
+
+  do jproc=0,dpbox%mpi_env%nproc-1
+     n3d=dpbox%nscatterarr(jproc,1)
+     i3s=dpbox%nscatterarr(jproc,3)-dpbox%nscatterarr(jproc,4)
+     do k=1,n3d
+        !plane of the box which corresponds to the plane k of the slab
+        j3=modulo(modulo(i3s+k-1,n3)-lr%nsi3,n3)+1
+        if (j3 > lr%d%n3i) cycle
+        iplane=int(n1,f_address)*n2*(int(max(n3d,1),f_address)*(ispin-1)+k-1)
+        if (whole) then
+           call accumulate_to_owner(dpbox%mpi_env%nproc,n1*n2,box(1,1,j3),jproc,iplane,win,rho_p)
+        else
+           do j2=1,lr%d%n2i
+              idisp=iplane+int(n1,f_address)*modulo(lr%nsi2+j2-1,n2)+i1s-1
+              call accumulate_to_owner(dpbox%mpi_env%nproc,n1s,box(1,j2,j3),jproc,idisp,win,rho_p)
+              if (n1s < lr%d%n1i) then
+                 idisp=iplane+int(n1,f_address)*modulo(lr%nsi2+j2-1,n2)
+                 call accumulate_to_owner(dpbox%mpi_env%nproc,lr%d%n1i-n1s,box(n1s+1,j2,j3),&
+                      jproc,idisp,win,rho_p)
+              end if
+           end do
+        end if
+     end do
+  end do
+
+END SUBROUTINE box_to_plane_owners
+
+
+!> Sum count values at the position idisp of the slab of jproc
+subroutine accumulate_to_owner(nproc,count,origin,jproc,idisp,win,rho_p)
+  use module_base
+  implicit none
+  integer, intent(in) :: nproc,count,jproc
+  integer(f_address), intent(in) :: idisp
+  real(dp), dimension(count), intent(in) :: origin
+  type(fmpi_win), intent(in) :: win
+  real(dp), dimension(*), intent(inout) :: rho_p
+
+  if (nproc > 1) then
+     call fmpi_accumulate(origin=origin(1),count=count,target_rank=jproc,&
+          target_disp=idisp,op=FMPI_SUM,win=win)
+  else
+     call axpy(count,1.0_dp,origin(1),1,rho_p(idisp+1),1)
+  end if
+
+END SUBROUTINE accumulate_to_owner
+
+
 !> Here starts the routine for building partial density inside the localisation region
 !! This routine should be treated as a building-block for the linear scaling code
 subroutine local_partial_density(nproc,rsflag,nscatterarr,&
@@ -469,11 +870,13 @@ subroutine local_partial_density(nproc,rsflag,nscatterarr,&
 END SUBROUTINE local_partial_density
 
 
+!> Accumulate the density of one orbital in the planes of rho_p.
+!! Each thread owns whole (i2,i3) lines of the output, such that
+!! no synchronisation is needed between the threads
 subroutine partial_density(rsflag,nproc,n1i,n2i,n3i,npsir,nspinn,nrhotot,&
       &   hfac,nscatterarr,spinsgn,psir,rho_p)
    use module_base
    use module_types
-   use yaml_output
    implicit none
    logical, intent(in) :: rsflag
    integer, intent(in) :: nproc,n1i,n2i,n3i,nrhotot,nspinn,npsir
@@ -482,106 +885,72 @@ subroutine partial_density(rsflag,nproc,n1i,n2i,n3i,npsir,nspinn,nrhotot,&
    real(wp), dimension(n1i,n2i,n3i,npsir), intent(in) :: psir
    real(dp), dimension(n1i,n2i,nrhotot,nspinn), intent(inout) :: rho_p
    !local variables
-   integer :: i3s,jproc,i3off,n3d,isjmp,i1,i2,i3,i1s,i1e,j3,i3sg
-   real(gp) :: hfac2
+   integer :: isjmp,i1,i2,i3s,j3
+   real(dp) :: hfac1,hfac2
    real(dp) :: psisq,p1,p2,p3,p4,r1,r2,r3,r4
-   !!!  integer :: ithread,nthread,omp_get_thread_num,omp_get_num_threads
-   !sum different slices by taking into account the overlap
-   i3sg=0
-   !$omp parallel default(none) &
-   !$omp private(jproc,i1,i3s,i1s,i1e,i3off,n3d,i3,j3,isjmp,psisq,p1,p2,p3,p4,r1,r2,r3,r4,i2) &
-   !$omp shared(n1i,nproc,rsflag,nspinn,nscatterarr,spinsgn) &
-   !$omp shared(n2i,npsir,hfac,hfac2,psir,rho_p,n3i,i3sg)
-   i3s=0
-   hfac2=2.0_gp*hfac
-   !!!  ithread=omp_get_thread_num()
-   !!!  nthread=omp_get_num_threads()
+   integer, dimension(:), allocatable :: j3map
 
-   !case without bounds
-   i1s=1
-   i1e=n1i
-
-   loop_xc_overlap: do jproc=0,nproc-1
-      !case for REDUCE_SCATTER approach, not used for GGA since it enlarges the 
-      !communication buffer
-      if (rsflag) then
-         i3off=nscatterarr(jproc,3)-nscatterarr(jproc,4)
-         n3d=nscatterarr(jproc,1)
-         if (n3d==0) exit loop_xc_overlap
-      else
-         i3off=0
-         n3d=n3i
-      end if
-      !here the condition for the MPI_ALLREDUCE should be entered
-      if(spinsgn > 0.0_gp) then
-         isjmp=1
-      else
-         isjmp=2
-      end if
-      do i3=i3off+1,i3off+n3d
-         !this allows the presence of GGA with non-isolated BC. If i3 is between 1 and n3i
-         !j3=i3. This is useful only when dealing with rsflags and GGA, so we can comment it out
-         !j3=modulo(i3-1,n3i)+1 
-         j3=i3
-         i3s=i3s+1
-         !!  if(mod(i3s,nthread) .eq. ithread) then
-         !$omp do
-         do i2=1,n2i
-            if (npsir == 1) then
-               do i1=i1s,i1e
-                  !conversion between the different types
-                  psisq=real(psir(i1,i2,j3,1),dp)
-                  psisq=psisq*psisq
-                  rho_p(i1,i2,i3s,isjmp)=rho_p(i1,i2,i3s,isjmp)+real(hfac,dp)*psisq
-               end do
-            else !similar loop for npsir=4
-               do i1=i1s,i1e
-                  !conversion between the different types
-                  p1=real(psir(i1,i2,j3,1),dp)
-                  p2=real(psir(i1,i2,j3,2),dp)
-                  p3=real(psir(i1,i2,j3,3),dp)
-                  p4=real(psir(i1,i2,j3,4),dp)
-
-                  !density values
-                  r1=p1*p1+p2*p2+p3*p3+p4*p4
-                  r2=p1*p3+p2*p4
-                  r3=p1*p4-p2*p3 !this seems with the opposite sign
-                  r4=p1*p1+p2*p2-p3*p3-p4*p4
-
-                  rho_p(i1,i2,i3s,1)=rho_p(i1,i2,i3s,1)+real(hfac,dp)*r1
-                  rho_p(i1,i2,i3s,2)=rho_p(i1,i2,i3s,2)+real(hfac2,dp)*r2
-                  rho_p(i1,i2,i3s,3)=rho_p(i1,i2,i3s,3)+real(hfac2,dp)*r3
-                  rho_p(i1,i2,i3s,4)=rho_p(i1,i2,i3s,4)+real(hfac,dp)*r4
-               end do
-            end if
-         end do
-         !$omp enddo
-         !!  end if
-         !$omp critical
-         i3sg=max(i3sg,i3s)
-         !$omp end critical
+   !sum different slices by taking into account the overlap
+   j3map = f_malloc(nrhotot,id='j3map')
+   call density_planes_map(rsflag,nproc,n3i,nrhotot,nscatterarr,j3map)
 
+   !here the condition for the MPI_ALLREDUCE should be entered
+   if(spinsgn > 0.0_gp) then
+      isjmp=1
+   else
+      isjmp=2
+   end if
+   hfac1=real(hfac,dp)
+   hfac2=2.0_dp*hfac1
+
+   !$omp parallel do default(none) schedule(static) collapse(2) &
+   !$omp private(i1,i2,i3s,j3,psisq,p1,p2,p3,p4,r1,r2,r3,r4) &
+   !$omp shared(n1i,n2i,nrhotot,npsir,isjmp,hfac1,hfac2,psir,rho_p,j3map)
+   do i3s=1,nrhotot
+      do i2=1,n2i
+         j3=j3map(i3s)
+         if (npsir == 1) then
+            do i1=1,n1i
+               !conversion between the different types
+               psisq=real(psir(i1,i2,j3,1),dp)
+               psisq=psisq*psisq
+               rho_p(i1,i2,i3s,isjmp)=rho_p(i1,i2,i3s,isjmp)+hfac1*psisq
+            end do
+         else !similar loop for npsir=4
+            do i1=1,n1i
+               !conversion between the different types
+               p1=real(psir(i1,i2,j3,1),dp)
+               p2=real(psir(i1,i2,j3,2),dp)
+               p3=real(psir(i1,i2,j3,3),dp)
+               p4=real(psir(i1,i2,j3,4),dp)
+
+               !density values
+               r1=p1*p1+p2*p2+p3*p3+p4*p4
+               r2=p1*p3+p2*p4
+               r3=p1*p4-p2*p3 !this seems with the opposite sign
+               r4=p1*p1+p2*p2-p3*p3-p4*p4
+
+               rho_p(i1,i2,i3s,1)=rho_p(i1,i2,i3s,1)+hfac1*r1
+               rho_p(i1,i2,i3s,2)=rho_p(i1,i2,i3s,2)+hfac2*r2
+               rho_p(i1,i2,i3s,3)=rho_p(i1,i2,i3s,3)+hfac2*r3
+               rho_p(i1,i2,i3s,4)=rho_p(i1,i2,i3s,4)+hfac1*r4
+            end do
+         end if
       end do
-      if (.not. rsflag) exit loop_xc_overlap !the whole range is already done
-   end do loop_xc_overlap
-   !$omp end parallel
+   end do
+   !$omp end parallel do
 
-   if (i3sg /= nrhotot) then
-      call yaml_warning('Problem with rho_p, i3s=' // trim(yaml_toa(i3sg)) // &
-           & 'nrhotot=' // trim(yaml_toa(nrhotot)))
-      !write(*,'(1x,a,i0,1x,i0)')'ERROR: problem with rho_p: i3s,nrhotot,',i3sg,nrhotot
-      stop
-   end if
+   call f_free(j3map)
 
 END SUBROUTINE partial_density
 
 
+!> Same as partial_density, restricted to the bounds of the isolated case
 subroutine partial_density_free(rsflag,nproc,n1i,n2i,n3i,npsir,nspinn,nrhotot,&
       &   hfac,nscatterarr,spinsgn,psir,rho_p,&
       &   ibyyzz_r) 
    use module_base
    use module_types
-   use yaml_output
    implicit none
    logical, intent(in) :: rsflag
    integer, intent(in) :: nproc,n1i,n2i,n3i,nrhotot,nspinn,npsir
@@ -591,27 +960,83 @@ subroutine partial_density_free(rsflag,nproc,n1i,n2i,n3i,npsir,nspinn,nrhotot,&
    real(dp), dimension(n1i,n2i,nrhotot,nspinn), intent(inout) :: rho_p
    integer, dimension(:,:,:),pointer :: ibyyzz_r 
    !local variables
-   integer :: i3s,jproc,i3off,n3d,isjmp,i1,i2,i3,i1s,i1e,j3,i3sg
-   real(gp) :: hfac2
+   integer :: isjmp,i1,i2,i3s,i1s,i1e,j3
+   real(dp) :: hfac1,hfac2
    real(dp) :: psisq,p1,p2,p3,p4,r1,r2,r3,r4
-   !  integer :: ncount0,ncount1,ncount_rate,ncount_max
-   !!!  integer :: ithread,nthread,omp_get_thread_num,omp_get_num_threads
+   integer, dimension(:), allocatable :: j3map
+
    !sum different slices by taking into account the overlap
-   i3sg=0
+   j3map = f_malloc(nrhotot,id='j3map')
+   call density_planes_map(rsflag,nproc,n3i,nrhotot,nscatterarr,j3map)
 
-   !$omp parallel default(private) shared(n1i,nproc,rsflag,nspinn,nscatterarr,spinsgn) &
-   !$omp shared(n2i,npsir,hfac,psir,rho_p,n3i,i3sg,ibyyzz_r)
-   i3s=0
+   !here the condition for the MPI_ALLREDUCE should be entered
+   if(spinsgn > 0.0_gp) then
+      isjmp=1
+   else
+      isjmp=2
+   end if
+   hfac1=real(hfac,dp)
+   hfac2=2.0_dp*hfac1
+
+   !$omp parallel do default(none) schedule(static) collapse(2) &
+   !$omp private(i1,i2,i3s,i1s,i1e,j3,psisq,p1,p2,p3,p4,r1,r2,r3,r4) &
+   !$omp shared(n2i,nrhotot,npsir,isjmp,hfac1,hfac2,psir,rho_p,j3map,ibyyzz_r)
+   do i3s=1,nrhotot
+      do i2=1,n2i
+         j3=j3map(i3s)
+         i1s=ibyyzz_r(1,i2-15,j3-15)+1
+         i1e=ibyyzz_r(2,i2-15,j3-15)+1
+         if (npsir == 1) then
+            do i1=i1s,i1e
+               !conversion between the different types
+               psisq=real(psir(i1,i2,j3,1),dp)
+               psisq=psisq*psisq
+               rho_p(i1,i2,i3s,isjmp)=rho_p(i1,i2,i3s,isjmp)+hfac1*psisq
+            end do
+         else !similar loop for npsir=4
+            do i1=i1s,i1e
+               !conversion between the different types
+               p1=real(psir(i1,i2,j3,1),dp)
+               p2=real(psir(i1,i2,j3,2),dp)
+               p3=real(psir(i1,i2,j3,3),dp)
+               p4=real(psir(i1,i2,j3,4),dp)
+
+               !density values
+               r1=p1*p1+p2*p2+p3*p3+p4*p4
+               r2=p1*p3+p2*p4
+               r3=p1*p4-p2*p3
+               r4=p1*p1+p2*p2-p3*p3-p4*p4
+
+               rho_p(i1,i2,i3s,1)=rho_p(i1,i2,i3s,1)+hfac1*r1
+               rho_p(i1,i2,i3s,2)=rho_p(i1,i2,i3s,2)+hfac2*r2
+               rho_p(i1,i2,i3s,3)=rho_p(i1,i2,i3s,3)+hfac2*r3
+               rho_p(i1,i2,i3s,4)=rho_p(i1,i2,i3s,4)+hfac1*r4
+            end do
+         end if
+      end do
+   end do
+   !$omp end parallel do
 
-   !!!   ithread=omp_get_thread_num()
-   !!!   nthread=omp_get_num_threads()
-   hfac2=2.0_gp*hfac
+   call f_free(j3map)
 
-   !  call system_clock(ncount0,ncount_rate,ncount_max)
+END SUBROUTINE partial_density_free
 
-   !case without bounds
-   i1s=1
-   i1e=n1i
+
+!> Plane of psir which has to be accumulated in each plane of rho_p.
+!! In the REDUCE_SCATTER approach the planes of all the processes are
+!! stored one after another, including the overlap needed by the GGA
+subroutine density_planes_map(rsflag,nproc,n3i,nrhotot,nscatterarr,j3map)
+   use module_base
+   use yaml_output
+   implicit none
+   logical, intent(in) :: rsflag
+   integer, intent(in) :: nproc,n3i,nrhotot
+   integer, dimension(0:nproc-1,4), intent(in) :: nscatterarr
+   integer, dimension(nrhotot), intent(out) :: j3map
+   !local variables
+   integer :: jproc,i3off,n3d,i3,i3s
+
+   i3s=0
    loop_xc_overlap: do jproc=0,nproc-1
       !case for REDUCE_SCATTER approach, not used for GGA since it enlarges the 
       !communication buffer
@@ -623,75 +1048,23 @@ subroutine partial_density_free(rsflag,nproc,n1i,n2i,n3i,npsir,nspinn,nrhotot,&
          i3off=0
          n3d=n3i
       end if
-
-      !here the condition for the MPI_ALLREDUCE should be entered
-      if(spinsgn > 0.0_gp) then
-         isjmp=1
-      else
-         isjmp=2
-      end if
       do i3=i3off+1,i3off+n3d
          !this allows the presence of GGA with non-isolated BC. If i3 is between 1 and n3i
          !j3=i3. This is useful only when dealing with rsflags and GGA, so we can comment it out
          !j3=modulo(i3-1,n3i)+1 
-         j3=i3
          i3s=i3s+1
-         !!!    if(mod(i3s,nthread) .eq. ithread) then
-         !$omp do
-         do i2=1,n2i
-            i1s=ibyyzz_r(1,i2-15,j3-15)+1
-            i1e=ibyyzz_r(2,i2-15,j3-15)+1
-            if (npsir == 1) then
-               do i1=i1s,i1e
-                  !conversion between the different types
-                  psisq=real(psir(i1,i2,j3,1),dp)
-                  psisq=psisq*psisq
-                  rho_p(i1,i2,i3s,isjmp)=rho_p(i1,i2,i3s,isjmp)+real(hfac,dp)*psisq
-                  !write(93000+iorb,'(4i8,es20.10)') i1,i2,i3,isjmp,rho_p(i1,i2,i3s,isjmp)
-               end do
-            else !similar loop for npsir=4
-               do i1=i1s,i1e
-                  !conversion between the different types
-                  p1=real(psir(i1,i2,j3,1),dp)
-                  p2=real(psir(i1,i2,j3,2),dp)
-                  p3=real(psir(i1,i2,j3,3),dp)
-                  p4=real(psir(i1,i2,j3,4),dp)
-
-                  !density values
-                  r1=p1*p1+p2*p2+p3*p3+p4*p4
-                  r2=p1*p3+p2*p4
-                  r3=p1*p4-p2*p3
-                  r4=p1*p1+p2*p2-p3*p3-p4*p4
-
-                  rho_p(i1,i2,i3s,1)=rho_p(i1,i2,i3s,1)+real(hfac,dp)*r1
-                  rho_p(i1,i2,i3s,2)=rho_p(i1,i2,i3s,2)+real(hfac2,dp)*r2
-                  rho_p(i1,i2,i3s,3)=rho_p(i1,i2,i3s,3)+real(hfac2,dp)*r3
-                  rho_p(i1,i2,i3s,4)=rho_p(i1,i2,i3s,4)+real(hfac,dp)*r4
-               end do
-            end if
-         end do
-         !$omp enddo
-         !!!    end if
-
-         !$omp critical
-         i3sg=max(i3sg,i3s)
-         !$omp end critical
-
+         if (i3s <= nrhotot) j3map(i3s)=i3
       end do
       if (.not. rsflag) exit loop_xc_overlap !the whole range is already done
    end do loop_xc_overlap
-   !$omp end parallel
 
-   if (i3sg /= nrhotot) then
-      call yaml_warning('Problem with rho_p, i3s=' // trim(yaml_toa(i3sg)) // &
+   if (i3s /= nrhotot) then
+      call yaml_warning('Problem with rho_p, i3s=' // trim(yaml_toa(i3s)) // &
            & 'nrhotot=' // trim(yaml_toa(nrhotot)))
-      !write(*,'(1x,a,i0,1x,i0)')'ERROR: problem with rho_p: i3s,nrhotot,',i3sg,nrhotot
       stop
    end if
 
-   !  call system_clock(ncount1,ncount_rate,ncount_max)
-   !  write(*,*) 'TIMING:PDF',real(ncount1-ncount0)/real(ncount_rate)
-END SUBROUTINE partial_density_free
+END SUBROUTINE density_planes_map
 
 
 !> Symmetrise the density using the symmetry operation
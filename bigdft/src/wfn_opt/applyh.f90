@@ -217,6 +217,7 @@ subroutine psi_to_vlocpsi(iproc,npsidim_orbs,orbs,Lzd,&
   use module_xc
   use locreg_operations
   use rhopotential, only: extract_potential
+  use at_domain, only: domain_geocode
   implicit none
   integer, intent(in) :: iproc,ipotmethod,npsidim_orbs
   real(gp), intent(in) :: alphaSIC
@@ -234,12 +235,18 @@ subroutine psi_to_vlocpsi(iproc,npsidim_orbs,orbs,Lzd,&
   real(gp),intent(out),optional :: econf_sum
   !local variables
   character(len=*), parameter :: subname='psi_to_vlocpsi'
-  logical :: dosome
-  integer :: iorb,npot,ispot,ispsi,ilr,ilr_orb,nbox,nvctr,ispinor,ispin,size_lpot
+  !> Maximal number of orbitals of a localisation region treated together
+  integer, parameter :: NORB_BLOCK=4
+  logical :: blocked
+  integer :: iorb,npot,ispot,ispsi,ilr,nbox,nvctr,ispinor,ispin,nbox_max,nblock,jorb,nb,ib,ips
   real(wp) :: exctXcoeff
   real(gp) :: epot,eSICi,eSIC_DCi,econf !n(c) etest
   type(workarr_sumrho) :: w
-  real(wp), dimension(:,:), allocatable :: psir,vsicpsir,psir_noconf
+  real(gp), dimension(NORB_BLOCK) :: epotblock,econfblock
+  type(confpot_data), dimension(NORB_BLOCK) :: confblock
+  integer, dimension(:), allocatable :: norb_lr,isorb_lr,iorb_lr,ispsi_orb,ispin_orb
+  real(wp), dimension(:), pointer :: psir
+  real(wp), dimension(:,:), pointer :: vsicpsir,psir_noconf
 
   call f_routine(id='psi_to_vlocpsi')
 
@@ -265,155 +272,203 @@ subroutine psi_to_vlocpsi(iproc,npsidim_orbs,orbs,Lzd,&
       econf_sum=0.0_gp
   end if
 
+  !index of the orbitals of each localisation region, with their position in psi
+  norb_lr=f_malloc0(Lzd%nlr,id='norb_lr')
+  isorb_lr=f_malloc(Lzd%nlr+1,id='isorb_lr')
+  iorb_lr=f_malloc(orbs%norbp,id='iorb_lr')
+  ispsi_orb=f_malloc(orbs%norbp,id='ispsi_orb')
+  ispin_orb=f_malloc(orbs%norbp,id='ispin_orb')
+  ispsi=1
+  nbox_max=0
+  do iorb=1,orbs%norbp
+     ilr=orbs%inwhichlocreg(iorb+orbs%isorb)
+     norb_lr(ilr)=norb_lr(ilr)+1
+     ispsi_orb(iorb)=ispsi
+     if (orbs%spinsgn(iorb+orbs%isorb)>0.d0) then
+        ispin_orb(iorb)=1
+     else
+        ispin_orb(iorb)=2
+     end if
+     ispsi=ispsi+(Lzd%Llr(ilr)%wfd%nvctr_c+7*Lzd%Llr(ilr)%wfd%nvctr_f)*orbs%nspinor
+     nbox_max=max(nbox_max,Lzd%Llr(ilr)%d%n1i*Lzd%Llr(ilr)%d%n2i*Lzd%Llr(ilr)%d%n3i)
+  end do
+  isorb_lr(1)=0
+  do ilr=1,Lzd%nlr
+     isorb_lr(ilr+1)=isorb_lr(ilr)+norb_lr(ilr)
+     norb_lr(ilr)=0
+  end do
+  do iorb=1,orbs%norbp
+     ilr=orbs%inwhichlocreg(iorb+orbs%isorb)
+     norb_lr(ilr)=norb_lr(ilr)+1
+     iorb_lr(isorb_lr(ilr)+norb_lr(ilr))=iorb
+  end do
+
+  !components of the potential (four or one, depending on the spin)
+  npot=orbs%nspinor
+  if (orbs%nspinor == 2) npot=1
+
+  !the blocked application of the potential is done for the plain local potential only
+  blocked = ipotmethod == 0 .and. orbs%nspinor == 1 .and. .not. present(vpsi_noconf)
+  nblock=1
+  if (blocked) nblock=NORB_BLOCK
+
+  !scratch arrays, sized once for the largest localisation region
+  !and recycled from the pool across the calls of the SCF loop
+  ! Wavefunctions in real space
+  psir = f_malloc_ptr(nbox_max*orbs%nspinor*nblock,id='psir',pool=.true.)
+  if (present(vpsi_noconf)) then
+     psir_noconf = f_malloc_ptr((/ nbox_max, orbs%nspinor /),id='psir_noconf',pool=.true.)
+  end if
+  ! wavefunction after application of the self-interaction potential
+  if (ipotmethod == 2 .or. ipotmethod == 3) then
+     vsicpsir = f_malloc_ptr((/ nbox_max, orbs%nspinor /),id='vsicpsir',pool=.true.)
+  end if
+
   call initialize_work_arrays_sumrho(lzd%nlr,lzd%llr,.true.,w)
 
   !loop on the localisation regions (so to create one work array set per lr)
   loop_lr: do ilr=1,Lzd%nlr
-     !check if this localisation region is used by one of the orbitals
-     dosome=.false.
-     do iorb=1,orbs%norbp
-        dosome = (orbs%inwhichlocreg(iorb+orbs%isorb) == ilr)
-        if (dosome) then
-            exit
-        end if
-     end do
-     if (.not. dosome) cycle loop_lr
+     if (norb_lr(ilr) == 0) cycle loop_lr
 
      !initialise the work arrays
      call initialize_work_arrays_sumrho(lzd%llr(ilr),.false.,w)
 
      !box elements size
      nbox=Lzd%Llr(ilr)%d%n1i*Lzd%Llr(ilr)%d%n2i*Lzd%Llr(ilr)%d%n3i
+     nvctr=Lzd%Llr(ilr)%wfd%nvctr_c+7*Lzd%Llr(ilr)%wfd%nvctr_f
+
+     !blocks of at most nblock orbitals of this region with the same spin,
+     !which share the extraction and the application of the potential
+     jorb=isorb_lr(ilr)
+     loop_blocks: do while(jorb < isorb_lr(ilr+1))
+        ispin=ispin_orb(iorb_lr(jorb+1))
+        nb=1
+        do while(nb < nblock .and. jorb+nb < isorb_lr(ilr+1))
+           if (ispin_orb(iorb_lr(jorb+nb+1)) /= ispin) exit
+           nb=nb+1
+        end do
 
-     !components of the potential (four or one, depending on the spin)
-     npot=orbs%nspinor
-     if (orbs%nspinor == 2) npot=1
-
-     ! Wavefunction in real space
-     psir = f_malloc0((/ nbox, orbs%nspinor /),id='psir')
-
-     if (present(vpsi_noconf)) then
-         psir_noconf = f_malloc((/ nbox, orbs%nspinor /),id='psir_noconf')
-     end if
-
-     !call to_zero(nbox*orbs%nspinor,psir(1,1))
-
-     ! wavefunction after application of the self-interaction potential
-     if (ipotmethod == 2 .or. ipotmethod == 3) then
-        vsicpsir = f_malloc((/ nbox, orbs%nspinor /),id='vsicpsir')
-     end if
+        !transform the wavefunctions in Daubechies basis to the wavefunctions in ISF basis
+        !the psir wavefunctions are given in the spinorial form
+        do ib=1,nb
+           iorb=iorb_lr(jorb+ib)
+           do ispinor=1,orbs%nspinor
+              call daub_to_isf(Lzd%Llr(ilr),w,psi(ispsi_orb(iorb)+nvctr*(ispinor-1)),&
+                   psir(1+nbox*(ispinor-1+orbs%nspinor*(ib-1))))
+           end do
+        end do
 
-  !n(c) etest=0.0_gp
+        ! For the linear scaling case
+        call extract_potential(ispin, ilr, nbox, lzd, pot, comgp)
+        econfblock=0.0_gp
 
-  ispsi=1
-  loop_orbs: do iorb=1,orbs%norbp
-     ilr_orb=orbs%inwhichlocreg(iorb+orbs%isorb)
-     nvctr=Lzd%Llr(ilr_orb)%wfd%nvctr_c+7*Lzd%Llr(ilr_orb)%wfd%nvctr_f
-     if (ilr_orb /= ilr) then
-        ispsi=ispsi+nvctr*orbs%nspinor
-        cycle loop_orbs
-     end if
-     
-     !transform the wavefunction in Daubechies basis to the wavefunction in ISF basis
-     !the psir wavefunction is given in the spinorial form
-     do ispinor=1,orbs%nspinor
-        call daub_to_isf(Lzd%Llr(ilr),w,psi(ispsi+nvctr*(ispinor-1)),psir(1,ispinor))
-     end do
-
-     !ispot=1+lr%d%n1i*lr%d%n2i*lr%d%n3i*(nspin+iorb-1)
-     !etest=etest+dot(lr%d%n1i*lr%d%n2i*lr%d%n3i,pot(ispot),1,psir(1,1),1)
-     !print *,'epot, iorb,iproc,norbp',iproc,orbs%norbp,iorb
-
-     !calculate the ODP, to be added to VPsi array
-
-     !Perdew-Zunger SIC scheme
-     eSIC_DCi=0.0_gp
-     if (ipotmethod == 2) then
-        !in this scheme the application of the potential is already done
-        call PZ_SIC_potential(iorb,Lzd%Llr(ilr),orbs,xc,&
-             0.5_gp*Lzd%hgrids(1),0.5_gp*Lzd%hgrids(2),0.5_gp*Lzd%hgrids(3),&
-             pkernel,psir,vsicpsir,eSICi,eSIC_DCi)
-     !NonKoopmans' correction scheme
-     else if (ipotmethod == 3) then 
-        !in this scheme first we have calculated the potential then we apply it
-        call vcopy(nbox*orbs%nspinor,psir(1,1),1,vsicpsir(1,1),1)
-        !for the moment the ODP is supposed to be valid only with one lr
-        call psir_to_vpsi(npot,orbs%nspinor,Lzd%Llr(ilr),&
-             pot(nbox*(orbs%nspin+(iorb-1)*orbs%nspinor)+1),&
-             vsicpsir,eSICi)
-     end if
+        if (blocked .and. domain_geocode(Lzd%Llr(ilr)%mesh%dom) == 'F') then
+           do ib=1,nb
+              confblock(ib)=confdatarr(iorb_lr(jorb+ib))
+           end do
+           !apply the potential to the block of psir wavefunctions and calculate potential energies
+           call apply_potential_lr_conf_block(Lzd%Llr(ilr)%d%n1i,Lzd%Llr(ilr)%d%n2i,Lzd%Llr(ilr)%d%n3i,&
+                Lzd%Llr(ilr)%d%n2,Lzd%Llr(ilr)%d%n3,nb,psir,pot,epotblock,confblock,&
+                Lzd%Llr(ilr)%bounds%ibyyzz_r)
+        else
+           do ib=1,nb
+              iorb=iorb_lr(jorb+ib)
+              ips=1+nbox*orbs%nspinor*(ib-1)
+              !calculate the ODP, to be added to VPsi array
+
+              !Perdew-Zunger SIC scheme
+              eSIC_DCi=0.0_gp
+              if (ipotmethod == 2) then
+                 !in this scheme the application of the potential is already done
+                 call PZ_SIC_potential(iorb,Lzd%Llr(ilr),orbs,xc,&
+                      0.5_gp*Lzd%hgrids(1),0.5_gp*Lzd%hgrids(2),0.5_gp*Lzd%hgrids(3),&
+                      pkernel,psir(ips),vsicpsir,eSICi,eSIC_DCi)
+              !NonKoopmans' correction scheme
+              else if (ipotmethod == 3) then 
+                 !in this scheme first we have calculated the potential then we apply it
+                 call vcopy(nbox*orbs%nspinor,psir(ips),1,vsicpsir(1,1),1)
+                 !for the moment the ODP is supposed to be valid only with one lr
+                 call psir_to_vpsi(npot,orbs%nspinor,Lzd%Llr(ilr),&
+                      pot(nbox*(orbs%nspin+(iorb-1)*orbs%nspinor)+1),&
+                      vsicpsir,eSICi)
+              end if
 
-     ! For the linear scaling case
-     if (orbs%spinsgn(iorb+orbs%isorb)>0.d0) then
-         ispin=1
-     else
-         ispin=2
-     end if
-     size_Lpot = Lzd%Llr(ilr_orb)%d%n1i*Lzd%Llr(ilr_orb)%d%n2i*Lzd%Llr(ilr_orb)%d%n3i
+              !apply the potential to the psir wavefunction and calculate potential energy
+              if (present(vpsi_noconf)) then
+                 if (.not.present(econf_sum)) then
+                    call f_err_throw('econf must be present when psir_noconf is present')
+                 end if
+                 call vcopy(nbox*orbs%nspinor, psir(ips), 1, psir_noconf(1,1), 1)
+                 call psir_to_vpsi(npot,orbs%nspinor,Lzd%Llr(ilr),&
+                      pot,psir(ips),epot,confdata=confdatarr(iorb),vpsir_noconf=psir_noconf,econf=econf)
+                 econfblock(ib)=econf
+              else
+                 call psir_to_vpsi(npot,orbs%nspinor,Lzd%Llr(ilr),&
+                      pot,psir(ips),epot,confdata=confdatarr(iorb))
+              end if
+              !this ispot has to be better defined inside denspot structure
+
+              !ODP treatment (valid only for the nlr=1 case)
+              if (ipotmethod==1) then !Exact Exchange
+                 ispot=1+nbox*(orbs%nspin+iorb-1)
+                 !add to the psir function the part of the potential coming from the exact exchange
+                 call axpy(nbox,exctXcoeff,pot(ispot),1,psir(ips),1)
+              else if (ipotmethod == 2) then !PZ scheme
+                 !subtract the sic potential from the vpsi function
+                 call axpy(nbox*orbs%nspinor,-alphaSIC,vsicpsir(1,1),1,psir(ips),1)
+                 !add the SIC correction to the potential energy
+                 epot=epot-alphaSIC*eSICi
+                 !accumulate the Double-Counted SIC energy
+                 evSIC=evSIC+alphaSIC*eSIC_DCi
+              else if (ipotmethod == 3) then !NK scheme
+                 !add the sic potential from the vpsi function
+                 call axpy(nbox*orbs%nspinor,alphaSIC,vsicpsir(1,1),1,psir(ips),1)
+                 epot=epot+alphaSIC*eSICi
+                 !accumulate the Double-Counted SIC energy
+                 evSIC=evSIC+alphaSIC*orbs%kwgts(orbs%iokpt(iorb))*orbs%occup(iorb+orbs%isorb)*eSICi
+              end if
+              epotblock(ib)=epot
 
-     call extract_potential(ispin, ilr_orb, size_lpot, lzd, pot, comgp)
+              !the unconfined wavefunction is transformed back here, as its buffer is not blocked
+              if (present(vpsi_noconf)) then
+                 do ispinor=1,orbs%nspinor
+                    call isf_to_daub(Lzd%Llr(ilr),w,psir_noconf(1,ispinor),&
+                         vpsi_noconf(ispsi_orb(iorb)+nvctr*(ispinor-1)))
+                 end do
+              end if
+           end do
+        end if
 
-     !apply the potential to the psir wavefunction and calculate potential energy
-     if (present(vpsi_noconf)) then
-         if (.not.present(econf_sum)) then
-             call f_err_throw('econf must be present when psir_noconf is present')
-         end if
-         call vcopy(nbox*orbs%nspinor, psir(1,1), 1, psir_noconf(1,1), 1)
-         call psir_to_vpsi(npot,orbs%nspinor,Lzd%Llr(ilr),&
-              pot,psir,epot,confdata=confdatarr(iorb),vpsir_noconf=psir_noconf,econf=econf)
-     else
-         call psir_to_vpsi(npot,orbs%nspinor,Lzd%Llr(ilr),&
-              pot,psir,epot,confdata=confdatarr(iorb))
-     end if
-     !!do i_stat=1,lzd%llr(ilr)%d%n1i*lzd%llr(ilr)%d%n2i*lzd%llr(ilr)%d%n3i
-     !!    write(1000+ilr_orb,*) orbs%ispot(iorb)+i_stat-1, pot(orbs%ispot(iorb)+i_stat-1)
-     !!end do
-     !this ispot has to be better defined inside denspot structure
-
-     !ODP treatment (valid only for the nlr=1 case)
-     if (ipotmethod==1) then !Exact Exchange
-        ispot=1+nbox*(orbs%nspin+iorb-1)
-        !add to the psir function the part of the potential coming from the exact exchange
-        call axpy(nbox,exctXcoeff,pot(ispot),1,psir(1,1),1)
-     else if (ipotmethod == 2) then !PZ scheme
-        !subtract the sic potential from the vpsi function
-        call axpy(nbox*orbs%nspinor,-alphaSIC,vsicpsir(1,1),1,psir(1,1),1)
-        !add the SIC correction to the potential energy
-        epot=epot-alphaSIC*eSICi
-        !accumulate the Double-Counted SIC energy
-        evSIC=evSIC+alphaSIC*eSIC_DCi
-     else if (ipotmethod == 3) then !NK scheme
-        !add the sic potential from the vpsi function
-        call axpy(nbox*orbs%nspinor,alphaSIC,vsicpsir(1,1),1,psir(1,1),1)
-        epot=epot+alphaSIC*eSICi
-        !accumulate the Double-Counted SIC energy
-        evSIC=evSIC+alphaSIC*orbs%kwgts(orbs%iokpt(iorb))*orbs%occup(iorb+orbs%isorb)*eSICi
-     end if
+        do ib=1,nb
+           iorb=iorb_lr(jorb+ib)
+           do ispinor=1,orbs%nspinor
+              call isf_to_daub(Lzd%Llr(ilr),w,psir(1+nbox*(ispinor-1+orbs%nspinor*(ib-1))),&
+                   vpsi(ispsi_orb(iorb)+nvctr*(ispinor-1)))
+           end do
 
-     do ispinor=1,orbs%nspinor
-         call isf_to_daub(Lzd%Llr(ilr),w,psir(1,ispinor),vpsi(ispsi+nvctr*(ispinor-1)))
-         if (present(vpsi_noconf)) then
-             call isf_to_daub(Lzd%Llr(ilr),w,psir_noconf(1,ispinor),vpsi_noconf(ispsi+nvctr*(ispinor-1)))
-         end if
-     end do
+           epot_sum=epot_sum+orbs%kwgts(orbs%iokpt(iorb))*orbs%occup(iorb+orbs%isorb)*epotblock(ib)
+           if (present(econf_sum)) then
+              econf_sum=econf_sum+orbs%kwgts(orbs%iokpt(iorb))*orbs%occup(iorb+orbs%isorb)*econfblock(ib)
+           end if
+        end do
+        jorb=jorb+nb
+     end do loop_blocks
 
-     epot_sum=epot_sum+orbs%kwgts(orbs%iokpt(iorb))*orbs%occup(iorb+orbs%isorb)*epot
-     if (present(econf_sum)) then
-         econf_sum=econf_sum+orbs%kwgts(orbs%iokpt(iorb))*orbs%occup(iorb+orbs%isorb)*econf
-     end if
-     ispsi=ispsi+nvctr*orbs%nspinor
-  enddo loop_orbs
+  end do loop_lr
 
   !deallocations of work arrays
-  call f_free(psir)
+  call f_free_ptr(psir)
   if (present(vpsi_noconf)) then
-      call f_free(psir_noconf)
+     call f_free_ptr(psir_noconf)
   end if
   if (ipotmethod == 2 .or. ipotmethod ==3) then
-     call f_free(vsicpsir)
+     call f_free_ptr(vsicpsir)
   end if
-
-end do loop_lr
+  call f_free(norb_lr)
+  call f_free(isorb_lr)
+  call f_free(iorb_lr)
+  call f_free(ispsi_orb)
+  call f_free(ispin_orb)
 
 call deallocate_work_arrays_sumrho(w)
 
@@ -297,7 +297,7 @@ subroutine PSolver(dom,datacode,iproc,nproc,n01,n02,n03,xc,hgrids,&
   end if
   !here the case ncplx/= 1 should be added
   call G_PoissonSolver(iproc,nproc,bigdft_mpi%mpi_comm,0,MPI_COMM_NULL,1,n1,n2,n3,nd1,nd2,nd3,md1,md2,md3,karray,zf(1,1,1),&
-       scal,0.0_dp,mesh,offset,strten)
+       scal,0.0_dp,mesh,offset,strten,0,.false.)
     
   !the value of the shift depends on the distributed i/o or not
   if (datacode=='G') then
@@ -0,0 +1,108 @@
+!> @file
+!! Test of the Grimme D3 dispersion correction
+!! @author
+!!    Copyright (C) 2017 BigDFT group
+!!    This file is distributed under the terms of the
+!!    GNU General Public License, see ~/COPYING file
+!!    or http://www.gnu.org/copyleft/gpl.txt .
+!!    For the list of contributors, see ~/AUTHORS
+
+
+!> Program to test the D3 energy and forces of a small C/H/O cluster.
+!! The values are compared to the reference file, the forces to the finite
+!! differences of the energy, and the coordination numbers updated from the
+!! few moved atoms to a computation from scratch.
+program test_dispersion
+  use module_base
+  use yaml_output
+  use module_atoms, only: atoms_data,atoms_data_null,allocate_atoms_data,&
+       deallocate_atoms_data
+  use at_domain, only: domain_new,ATOMIC_UNITS,geocode_to_bc_enum
+  use vdwcorrection
+  implicit none
+  !> PBE with the D3 damping
+  integer, parameter :: ixc=11,nat=36
+  !> Step of the finite differences (bohr)
+  real(gp), parameter :: h=1.e-4_gp
+  integer :: iat,i1,i2,i3
+  real(gp) :: eref,ep,em
+  real(gp), dimension(3,nat) :: rxyz,fxyz,fref
+  type(atoms_data) :: atoms
+  external :: astruct_set_n_atoms,astruct_set_n_types
+
+  call f_lib_initialize()
+
+  !C, H and O atoms on a distorted grid
+  atoms=atoms_data_null()
+  call astruct_set_n_types(atoms%astruct,3)
+  call astruct_set_n_atoms(atoms%astruct,nat)
+  call allocate_atoms_data(atoms)
+  atoms%astruct%atomnames(1:3)=['C','H','O']
+  atoms%nzatom=[6,1,8]
+  atoms%astruct%dom=domain_new(units=ATOMIC_UNITS,bc=geocode_to_bc_enum('F'))
+  iat=0
+  do i3=1,3
+     do i2=1,3
+        do i1=1,4
+           iat=iat+1
+           atoms%astruct%iatype(iat)=mod(iat,3)+1
+           rxyz(:,iat)=2.6_gp*real([i1,i2,i3],gp)+&
+                0.3_gp*sin(real([3*iat,5*iat,7*iat],gp))
+        end do
+     end do
+  end do
+
+  call vdwcorrection_initializeparams(ixc,VDW_DAMP_GRIMME_D3)
+
+  call yaml_mapping_open('Initial geometry')
+  call dispersion_report(rxyz)
+  !forces against the centered finite differences of the energy
+  fref=fxyz
+  do iat=1,nat,7
+     rxyz(1,iat)=rxyz(1,iat)+h
+     call vdwcorrection_calculate_energy(ep,rxyz,atoms,VDW_DAMP_GRIMME_D3)
+     rxyz(1,iat)=rxyz(1,iat)-2.0_gp*h
+     call vdwcorrection_calculate_energy(em,rxyz,atoms,VDW_DAMP_GRIMME_D3)
+     rxyz(1,iat)=rxyz(1,iat)+h
+     fxyz(1,iat)=fxyz(1,iat)+(ep-em)/(2.0_gp*h)
+  end do
+  call yaml_map('Force difference with finite differences',&
+       maxval(abs(fxyz(1,1:nat:7))),fmt='(1pe22.14)')
+  call yaml_mapping_close()
+
+  !less than a quarter of the atoms move: the coordination numbers are updated
+  do iat=1,nat,5
+     rxyz(:,iat)=rxyz(:,iat)+0.2_gp*cos(real([iat,2*iat,3*iat],gp))
+  end do
+  call yaml_mapping_open('Few atoms moved')
+  call dispersion_report(rxyz)
+  eref=ep
+  fref=fxyz
+  !same geometry from scratch
+  call vdwcorrection_finalize()
+  call vdwcorrection_calculate_energy(ep,rxyz,atoms,VDW_DAMP_GRIMME_D3)
+  call vdwcorrection_calculate_forces(fxyz,rxyz,atoms,VDW_DAMP_GRIMME_D3)
+  call yaml_map('Energy difference from scratch',abs(ep-eref),fmt='(1pe9.2)')
+  call yaml_map('Force difference from scratch',maxval(abs(fxyz-fref)),fmt='(1pe9.2)')
+  call yaml_mapping_close()
+
+  call vdwcorrection_freeparams()
+  call vdwcorrection_finalize()
+  call deallocate_atoms_data(atoms)
+  call f_lib_finalize()
+
+contains
+
+  subroutine dispersion_report(rxyz)
+    implicit none
+    real(gp), dimension(3,nat), intent(in) :: rxyz
+
+    call vdwcorrection_calculate_energy(ep,rxyz,atoms,VDW_DAMP_GRIMME_D3)
+    call vdwcorrection_calculate_forces(fxyz,rxyz,atoms,VDW_DAMP_GRIMME_D3)
+    call yaml_map('Energy',ep,fmt='(1pe22.14)')
+    call yaml_map('Force norm',sqrt(sum(fxyz**2)),fmt='(1pe22.14)')
+    call yaml_map('Max force',maxval(abs(fxyz)),fmt='(1pe22.14)')
+    call yaml_map('Max force sum',maxval(abs(sum(fxyz,dim=2))),fmt='(1pe22.14)')
+  end subroutine dispersion_report
+
+end program test_dispersion
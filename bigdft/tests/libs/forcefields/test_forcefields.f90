@@ -0,0 +1,346 @@
+!> @file
+!! Test of the neighbour lists of the classical force fields
+!! @author
+!!    Copyright (C) 2017 BigDFT group
+!!    This file is distributed under the terms of the
+!!    GNU General Public License, see ~/COPYING file
+!!    or http://www.gnu.org/copyleft/gpl.txt .
+!!    For the list of contributors, see ~/AUTHORS
+
+
+!> Program to test the Verlet lists and the force fields using them.
+!! The lists are compared to a brute force search of the periodic images,
+!! the Tersoff, Stillinger-Weber and Morse energies, forces and stress to the
+!! values of the former pair searches (the reference file).
+program test_forcefields
+  use module_base
+  use yaml_output
+  use module_atoms, only: atomic_structure,nullify_atomic_structure,&
+       deallocate_atomic_structure
+  use module_verlet
+  use module_tersoff, only: tersoff,init_tersoff,finalize_tersoff
+  use module_morse_bulk, only: morse_bulk_wrapper,init_morse_bulk,finalize_morse_bulk
+  use SWpotential, only: SWcalcforce,init_potential_SW,free_potential_SW
+  use at_domain, only: domain,domain_new,ATOMIC_UNITS,geocode_to_bc_enum
+  implicit none
+  !> Lattice constants of diamond Si and fcc Pt (bohr)
+  real(gp), parameter :: a_si=10.26_gp,a_pt=7.41_gp
+  integer :: nat
+  logical :: rebuilt
+  real(gp) :: epot
+  real(gp), dimension(3) :: cell
+  real(gp), dimension(6) :: strten
+  real(gp), dimension(:,:), allocatable :: rxyz,fxyz
+  type(atomic_structure) :: astruct
+  type(verlet_list) :: vl
+  type(domain) :: dom
+
+  call f_lib_initialize()
+
+  !the 8 atom cell is shorter than the cutoff: several images of each atom
+  call yaml_sequence_open('Verlet lists')
+  call diamond(1,a_si,.false.)
+  call check_verlet('Si8 periodic','P',12.0_gp,0.5_gp,.false.)
+  call check_verlet('Si8 periodic, half','P',12.0_gp,0.5_gp,.true.)
+  call free_structure()
+  call diamond(3,a_si,.false.)
+  call check_verlet('Si216 periodic','P',6.0_gp,0.5_gp,.false.)
+  call check_verlet('Si216 free, half','F',6.0_gp,0.5_gp,.true.)
+  call yaml_sequence_close()
+
+  !the list is only rebuilt once an atom moved by more than half of the skin
+  vl=verlet_list_null()
+  call verlet_list_set(vl,6.0_gp,0.5_gp)
+  dom=domain_new(units=ATOMIC_UNITS,bc=geocode_to_bc_enum('P'),acell=cell)
+  call verlet_list_update(vl,dom,nat,rxyz)
+  rxyz(1,1)=rxyz(1,1)+0.2_gp
+  call verlet_list_update(vl,dom,nat,rxyz,rebuilt)
+  call yaml_mapping_open('Verlet list updates')
+  call yaml_map('Rebuilt after 0.2 bohr',rebuilt)
+  rxyz(1,1)=rxyz(1,1)+0.1_gp
+  call verlet_list_update(vl,dom,nat,rxyz,rebuilt)
+  call yaml_map('Rebuilt after 0.3 bohr',rebuilt)
+  call yaml_map('Number of builds',vl%nbuild)
+  call yaml_mapping_close()
+  call deallocate_verlet_list(vl)
+  call free_structure()
+
+  call yaml_sequence_open('Tersoff')
+  call diamond(1,a_si,.false.)
+  call check_tersoff('Si8')
+  call diamond(2,a_si,.false.)
+  call check_tersoff('Si64')
+  call diamond(3,a_si,.true.)
+  call check_tersoff('SiC216')
+  call yaml_sequence_close()
+
+  !the references count the pairs within the cutoff of the potential, the
+  !cells being longer than twice the cutoff
+  call yaml_sequence_open('Stillinger-Weber')
+  call diamond(2,a_si,.false.)
+  call check_sw('Si64')
+  call diamond(3,a_si,.false.)
+  call check_sw('Si216')
+  call yaml_sequence_close()
+
+  !the first cell is longer than twice the cutoff, the second is not: all
+  !the periodic images within the cutoff are then counted
+  call yaml_sequence_open('Morse bulk')
+  call init_morse_bulk('Pt','none','P')
+  call fcc(5,a_pt)
+  call check_morse('Pt500')
+  call fcc(2,a_pt)
+  call check_morse('Pt32')
+  call finalize_morse_bulk()
+  call yaml_sequence_close()
+
+  call f_free(rxyz)
+  call f_free(fxyz)
+  call f_lib_finalize()
+
+contains
+
+  !> Diamond supercell of n**3 cubic cells of side a, with displaced atoms.
+  !! The atoms of the second fcc lattice are carbons if mixed.
+  subroutine diamond(n,a,mixed)
+    implicit none
+    integer, intent(in) :: n
+    real(gp), intent(in) :: a
+    logical, intent(in) :: mixed
+    !local variables
+    real(gp), dimension(3,8), parameter :: basis=reshape([&
+         0.0_gp,0.0_gp,0.0_gp, 0.0_gp,0.5_gp,0.5_gp, &
+         0.5_gp,0.0_gp,0.5_gp, 0.5_gp,0.5_gp,0.0_gp, &
+         0.25_gp,0.25_gp,0.25_gp, 0.25_gp,0.75_gp,0.75_gp, &
+         0.75_gp,0.25_gp,0.75_gp, 0.75_gp,0.75_gp,0.25_gp],[3,8])
+    integer :: i,j,k,l,iat
+
+    nat=8*n**3
+    call nullify_atomic_structure(astruct)
+    call astruct_set_n_types(astruct,2)
+    call astruct_set_n_atoms(astruct,nat)
+    astruct%atomnames(1)='Si'
+    astruct%atomnames(2)='C'
+    astruct%geocode='P'
+    cell=n*a
+    astruct%cell_dim=cell
+    call allocate_positions()
+    iat=0
+    do k=0,n-1
+       do j=0,n-1
+          do i=0,n-1
+             do l=1,8
+                iat=iat+1
+                rxyz(:,iat)=a*(basis(:,l)+[i,j,k])+displacement(iat,0.15_gp)
+                astruct%iatype(iat)=1
+                if (mixed .and. l > 4) astruct%iatype(iat)=2
+             end do
+          end do
+       end do
+    end do
+  end subroutine diamond
+
+  !> Fcc supercell of n**3 cubic cells of side a, with displaced atoms.
+  subroutine fcc(n,a)
+    implicit none
+    integer, intent(in) :: n
+    real(gp), intent(in) :: a
+    !local variables
+    real(gp), dimension(3,4), parameter :: basis=reshape([&
+         0.0_gp,0.0_gp,0.0_gp, 0.0_gp,0.5_gp,0.5_gp, &
+         0.5_gp,0.0_gp,0.5_gp, 0.5_gp,0.5_gp,0.0_gp],[3,4])
+    integer :: i,j,k,l,iat
+
+    nat=4*n**3
+    cell=n*a
+    call allocate_positions()
+    iat=0
+    do k=0,n-1
+       do j=0,n-1
+          do i=0,n-1
+             do l=1,4
+                iat=iat+1
+                rxyz(:,iat)=a*(basis(:,l)+[i,j,k])+displacement(iat,0.1_gp)
+             end do
+          end do
+       end do
+    end do
+  end subroutine fcc
+
+  !> Deterministic displacement of amplitude at most amp.
+  pure function displacement(iat,amp) result(d)
+    implicit none
+    integer, intent(in) :: iat
+    real(gp), intent(in) :: amp
+    real(gp), dimension(3) :: d
+    d=amp*sin([1.3_gp,2.1_gp,0.7_gp]*real(iat,gp))
+  end function displacement
+
+  subroutine allocate_positions()
+    implicit none
+    if (allocated(rxyz)) call f_free(rxyz)
+    if (allocated(fxyz)) call f_free(fxyz)
+    rxyz=f_malloc([3,nat],id='rxyz')
+    fxyz=f_malloc([3,nat],id='fxyz')
+  end subroutine allocate_positions
+
+  subroutine free_structure()
+    implicit none
+    call deallocate_atomic_structure(astruct)
+  end subroutine free_structure
+
+  !> Compare the list to all the pairs (and images) closer than rcut+skin.
+  subroutine check_verlet(label,geocode,rcut,skin,half)
+    implicit none
+    character(len=*), intent(in) :: label
+    character(len=1), intent(in) :: geocode
+    real(gp), intent(in) :: rcut,skin
+    logical, intent(in) :: half
+    !local variables
+    integer :: iat,jat,k,i1,i2,i3,npairs,nbrute,nmiss
+    integer, dimension(3) :: m
+    real(gp) :: rc2,d2,dsum,dbrute,ddiff
+    real(gp), dimension(3) :: dxyz,acell
+
+    vl=verlet_list_null()
+    call verlet_list_set(vl,rcut,skin,half=half)
+    if (geocode == 'P') then
+       dom=domain_new(units=ATOMIC_UNITS,bc=geocode_to_bc_enum('P'),acell=cell)
+       acell=cell
+       m=ceiling((rcut+skin)/cell)+1
+    else
+       dom=domain_new(units=ATOMIC_UNITS,bc=geocode_to_bc_enum('F'))
+       acell=0.0_gp
+       m=0
+    end if
+    call verlet_list_update(vl,dom,nat,rxyz)
+
+    rc2=(rcut+skin)**2
+    npairs=0
+    nbrute=0
+    nmiss=0
+    ddiff=0.0_gp
+    do iat=1,nat
+       dsum=0.0_gp
+       do k=vl%keynei(2,iat),vl%keynei(2,iat)+vl%keynei(1,iat)-1
+          dxyz=verlet_pair(vl,nat,rxyz,iat,k)
+          d2=sum(dxyz**2)
+          if (d2 >= rc2) nmiss=nmiss+1
+          dsum=dsum+sqrt(d2)
+       end do
+       npairs=npairs+vl%keynei(1,iat)
+       dbrute=0.0_gp
+       do jat=1,nat
+          if (half .and. jat < iat) cycle
+          do i3=-m(3),m(3)
+             do i2=-m(2),m(2)
+                do i1=-m(1),m(1)
+                   if (jat == iat .and. all([i1,i2,i3] == 0)) cycle
+                   !each image of iat itself is seen once in a half list
+                   if (half .and. jat == iat .and. .not. &
+                        (i3 > 0 .or. (i3 == 0 .and. (i2 > 0 .or. (i2 == 0 .and. i1 > 0))))) cycle
+                   dxyz=rxyz(:,jat)-rxyz(:,iat)+[i1,i2,i3]*acell
+                   d2=sum(dxyz**2)
+                   if (d2 < rc2) then
+                      nbrute=nbrute+1
+                      dbrute=dbrute+sqrt(d2)
+                   end if
+                end do
+             end do
+          end do
+       end do
+       ddiff=max(ddiff,abs(dsum-dbrute))
+    end do
+
+    call yaml_sequence(advance='no')
+    call yaml_mapping_open(label,flow=.true.)
+    call yaml_map('Pairs',npairs)
+    call yaml_map('Brute force pairs',nbrute)
+    call yaml_map('Pairs beyond the cutoff',nmiss)
+    call yaml_map('Max difference of distance sums',ddiff,fmt='(1pe9.2)')
+    call yaml_mapping_close()
+    if (npairs /= nbrute .or. nmiss /= 0 .or. ddiff > 1.e-10_gp) &
+         call yaml_warning('The Verlet list of '//trim(label)//' differs from the brute force search')
+    call deallocate_verlet_list(vl)
+  end subroutine check_verlet
+
+  subroutine check_tersoff(label)
+    implicit none
+    character(len=*), intent(in) :: label
+
+    call init_tersoff(nat,astruct,'default','none','P')
+    call tersoff(nat,cell,rxyz,fxyz,strten,epot)
+    call finalize_tersoff()
+    call report(label,strten=strten)
+    call free_structure()
+  end subroutine check_tersoff
+
+  subroutine check_sw(label)
+    implicit none
+    character(len=*), intent(in) :: label
+    !local variables
+    integer :: infocode
+
+    astruct%dom=domain_new(units=ATOMIC_UNITS,bc=geocode_to_bc_enum('P'),acell=cell)
+    call init_potential_SW(nat,1,1.0_gp)
+    call SWcalcforce(astruct,rxyz,fxyz,epot,infocode)
+    call free_potential_SW()
+    call report(label)
+    call free_structure()
+  end subroutine check_sw
+
+  !> Compare with the sum on all the images within the cutoff.
+  subroutine check_morse(label)
+    implicit none
+    character(len=*), intent(in) :: label
+    !local variables
+    !Pt parameters of init_morse_bulk
+    real(gp), parameter :: rho=1.6047_gp*Bohr_Ang,rcut=9.5_gp/Bohr_Ang
+    real(gp), parameter :: r0=2.8970_gp/Bohr_Ang,a=0.7102_gp*eV_Ha
+    integer :: iat,jat,i1,i2,i3
+    integer, dimension(3) :: m
+    real(gp) :: d,r,eshift,ebrute
+    real(gp), dimension(3) :: dxyz
+
+    call morse_bulk_wrapper(nat,cell,rxyz,fxyz,epot)
+    eshift=(1.0_gp-exp(rho*(r0-rcut)))**2-1.0_gp
+    m=ceiling(rcut/cell)+1
+    ebrute=0.0_gp
+    do iat=1,nat
+       do jat=1,nat
+          do i3=-m(3),m(3)
+             do i2=-m(2),m(2)
+                do i1=-m(1),m(1)
+                   if (jat == iat .and. all([i1,i2,i3] == 0)) cycle
+                   dxyz=rxyz(:,jat)-rxyz(:,iat)+[i1,i2,i3]*cell
+                   d=sqrt(sum(dxyz**2))
+                   if (d >= rcut) cycle
+                   r=exp(rho*(r0-d))
+                   ebrute=ebrute+0.5_gp*a*(r*(r-2.0_gp)-eshift)
+                end do
+             end do
+          end do
+       end do
+    end do
+    call report(label,ebrute=ebrute)
+  end subroutine check_morse
+
+  subroutine report(label,strten,ebrute)
+    implicit none
+    character(len=*), intent(in) :: label
+    real(gp), dimension(6), intent(in), optional :: strten
+    real(gp), intent(in), optional :: ebrute
+
+    call yaml_sequence(advance='no')
+    call yaml_mapping_open(label)
+    call yaml_map('Atoms',nat)
+    call yaml_map('Energy',epot,fmt='(1pe22.14)')
+    call yaml_map('Force norm',sqrt(sum(fxyz**2)),fmt='(1pe22.14)')
+    call yaml_map('Max force',maxval(abs(fxyz)),fmt='(1pe22.14)')
+    if (present(strten)) call yaml_map('Stress',strten,fmt='(1pe22.14)')
+    if (present(ebrute)) &
+         call yaml_map('Energy difference with all images',epot-ebrute,fmt='(1pe9.2)')
+    call yaml_mapping_close()
+  end subroutine report
+
+end program test_forcefields
@@ -0,0 +1,31 @@
+#!/bin/sh
+# check_history.sh REF LOG
+# The compressed wavefunction history of LOG must save memory at each MD
+# step, and the drift of the total energy (Ete) along the MD must stay
+# within tol of the drift of REF, the run keeping full copies.
+
+ref=$1
+log=$2
+tol=1.e-5
+
+saved=`grep "Wavefunction history" $log | sed 's/.*Saved (MB): *\([-0-9.]*\).*/\1/'`
+if test -z "$saved" ; then
+	echo "No wavefunction history in $log"
+	exit 1
+fi
+for s in $saved ; do
+	if ! awk -v s=$s 'BEGIN{exit !(s > 0)}' ; then
+		echo "No memory saved by the history of $log: $s MB"
+		exit 1
+	fi
+done
+
+drift() {
+	grep "(MD):" $1 | sed 's/.*Ete: *\([-0-9.eE+]*\)}.*/\1/' | \
+		awk 'NR==1{e0=$1} {e=$1} END{printf "%.6f\n", e-e0}'
+}
+dref=`drift $ref`
+dlog=`drift $log`
+echo "Energy drift (Ha): $dlog, with full copies: $dref"
+awk -v a=$dlog -v b=$dref -v t=$tol 'BEGIN{d=a-b; if (d < 0) d=-d; exit !(d <= t)}' || \
+	{ echo "Energy drift of $log differs by more than $tol" ; exit 1 ; }
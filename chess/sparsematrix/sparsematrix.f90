@@ -24,6 +24,7 @@ module sparsematrix
   use dictionaries, only: f_err_throw
   use yaml_strings
   use sparsematrix_base
+  use sparsematrix_bsr, only: compressed_to_bsr, sparsemm_bsr
   use time_profiling
   use wrapper_mpi
   use wrapper_linalg
@@ -964,7 +965,7 @@ module sparsematrix
      ! Local variables
      integer :: ii, nvctrp
      integer :: ncount, itg, iitg, ist_send, ist_recv
-     integer :: jproc_send, jproc, nccomm
+     integer :: jproc_send, jproc, nccomm, nscomm
      real(kind=mp) :: window_fake
      !integer,dimension(:),pointer :: nvctr_par
      type(fmpi_win),dimension(:),pointer :: windows
@@ -973,7 +974,8 @@ module sparsematrix
      integer,parameter :: ALLGATHERV=51, GET=52, GLOBAL_MATRIX=101, SUBMATRIX=102
      integer,parameter :: comm_strategy=GET
      integer,parameter :: data_strategy=SUBMATRIX!GLOBAL_MATRIX
-     integer,dimension(:,:),pointer :: luccomm
+     integer,dimension(:,:),pointer :: luccomm, luscomm
+     integer,dimension(:),allocatable :: requests
 
      call f_routine(id='compress_matrix_distributed_core')
 
@@ -993,10 +995,7 @@ module sparsematrix
              windows => windowsx
          end if
      case (ONESIDED_FULL)
-         if (nproc>1) then
-             ! Create a window for all taskgroups to which iproc belongs (max 2)
-             windows = f_malloc_ptr(smat%ntaskgroup,id='windows')
-         end if
+         ! Nothing to do, the communication is done with non-blocking point to point messages
      case default
          call f_err_throw('wrong value for onesided_action')
      end select
@@ -1009,8 +1008,10 @@ module sparsematrix
          if (layout==SPARSE_PARALLEL) then
              !stop 'layout==DENSE_PARALLEL not yet implemented'
              luccomm => smat%luccomm
+             luscomm => smat%luscomm
              nvctrp = smat%nvctrp
              nccomm = smat%nccomm
+             nscomm = smat%nscomm
          !else if (layout==DENSE_MATMUL) then
          else if (layout==SPARSE_MATMUL_SMALL) then
              if (.not.smat%smatmul_initialized) then
@@ -1018,8 +1019,10 @@ module sparsematrix
                       err_name='SPARSEMATRIX_RUNTIME_ERROR')
              end if
              luccomm => smat%smmm%luccomm_smmm
+             luscomm => smat%smmm%luscomm_smmm
              nvctrp = smat%smmm%nvctrp_mm
              nccomm = smat%smmm%nccomm_smmm
+             nscomm = smat%smmm%nscomm_smmm
          end if
          if (size(matrixp)/=nvctrp) then
              call f_err_throw('Array matrixp has size '//trim(yaml_toa(size(matrixp),fmt='(i0)'))//&
@@ -1032,7 +1035,29 @@ module sparsematrix
              !call timing(iproc,'compressd_comm','ON')
              call f_timing(TCAT_SMAT_COMPRESSION_COMMUNICATION,'ON')
 
-             if (onesided_action==ONESIDED_POST .or. onesided_action==ONESIDED_FULL) then
+             if (onesided_action==ONESIDED_FULL .and. nproc>1) then
+                 ! Each task posts the receives of the parts it needs and the sends of the parts
+                 ! the others need from it, using the lookup arrays built in init_matrix_taskgroups.
+                 ! In contrast to the one-sided version, this requires neither the creation of
+                 ! windows nor any synchronization within the taskgroups.
+                 call f_zero(matrix_compr)
+                 requests = f_malloc(nccomm+nscomm,id='requests')
+                 do jproc=1,nccomm
+                     jproc_send = luccomm(1,jproc)
+                     iitg = get_common_taskgroup(iproc,jproc_send)
+                     call fmpi_recv(matrix_compr(luccomm(3,jproc)), luccomm(4,jproc), &
+                          source=get_rank_on_taskgroup(jproc_send,iitg), tag=iitg, &
+                          comm=smat%mpi_groups(iitg)%mpi_comm, request=requests(jproc))
+                 end do
+                 do jproc=1,nscomm
+                     iitg = get_common_taskgroup(iproc,luscomm(1,jproc))
+                     call fmpi_send(matrixp(luscomm(2,jproc)), luscomm(3,jproc), &
+                          dest=get_rank_on_taskgroup(luscomm(1,jproc),iitg), tag=iitg, &
+                          comm=smat%mpi_groups(iitg)%mpi_comm, request=requests(nccomm+jproc))
+                 end do
+                 call fmpi_waitall(nccomm+nscomm, requests)
+                 call f_free(requests)
+             else if (onesided_action==ONESIDED_POST .or. onesided_action==ONESIDED_FULL) then
                  if (nproc>1) then
                     call f_zero(matrix_compr)
 
@@ -1082,7 +1107,7 @@ module sparsematrix
                  end if
              end if
 
-             if (onesided_action==ONESIDED_GATHER .or. onesided_action==ONESIDED_FULL) then
+             if (onesided_action==ONESIDED_GATHER) then
                  if (nproc>1) then
                      ! Synchronize the communication
                      do itg=1,smat%ntaskgroupp
@@ -1093,9 +1118,6 @@ module sparsematrix
                          call fmpi_win_free(windows(iitg))
                          !LG: why closing the windows (that is what fenceanfree does) if we have windowsx?
                      end do
-                     if (onesided_action==ONESIDED_FULL) then
-                         call free_fmpi_win_ptr(windows)
-                     end if
                      !call mpi_fenceandfree(window)
                  end if
              end if
@@ -1150,6 +1172,32 @@ module sparsematrix
        end function get_taskgroup_id
 
 
+       !> Get a taskgroup to which both iproc and jproc belong; in contrast to get_taskgroup_id
+       !! the result does not depend on the order of the arguments (the smallest common ID is taken),
+       !! such that the sending and the receiving task use the same communicator.
+       integer function get_common_taskgroup(iproc,jproc)
+         implicit none
+         integer,intent(in) :: iproc, jproc
+
+         ! Local variables
+         integer :: itg, iitg, jtg
+
+         get_common_taskgroup = huge(1)
+         do itg=1,2
+             iitg = smat%inwhichtaskgroup(itg,iproc)
+             if (iitg==0) cycle
+             do jtg=1,2
+                 if (smat%inwhichtaskgroup(jtg,jproc)==iitg) then
+                     get_common_taskgroup = min(get_common_taskgroup,iitg)
+                 end if
+             end do
+         end do
+         if (get_common_taskgroup==huge(1)) then
+             call f_err_throw('get_common_taskgroup did not suceed')
+         end if
+       end function get_common_taskgroup
+
+
        ! Get the ID of task iiproc on taskgroup iitg
        integer function get_rank_on_taskgroup(iiproc,iitg)
          implicit none
@@ -1261,6 +1309,14 @@ module sparsematrix
               err_name='SPARSEMATRIX_RUNTIME_ERROR')
      end if
    
+     if (smat%smmm%bsr%active) then
+         ! The block sparse matmul uses the blocks of a instead of the sequential entries
+         call compressed_to_bsr(smat%smmm%bsr%nablock, smat%smmm%bsr%ablock, 0, &
+              smat%nvctr, a, smat%smmm%bsr%nabsr, a_seq)
+         call f_release_routine()
+         return
+     end if
+
      !$omp parallel do default(none) private(iseq, ii) &
      !$omp shared(smat, a_seq, a)
      do iseq=1,smat%smmm%nseq
@@ -1293,6 +1349,14 @@ module sparsematrix
               err_name='SPARSEMATRIX_RUNTIME_ERROR')
      end if
    
+     if (smat%smmm%bsr%active) then
+         ! The block sparse matmul uses the blocks of a instead of the sequential entries
+         call compressed_to_bsr(smat%smmm%bsr%nablock, smat%smmm%bsr%ablock, smat%isvctrp_tg, &
+              smat%nvctrp_tg, a, smat%smmm%bsr%nabsr, a_seq)
+         call f_release_routine()
+         return
+     end if
+
      !$omp parallel do schedule(guided) &
      !$omp default(none) private(iseq, ii) &
      !$omp shared(smat, a_seq, a)
@@ -1343,6 +1407,13 @@ module sparsematrix
               err_name='SPARSEMATRIX_RUNTIME_ERROR')
      end if
 
+     if (smat%smmm%bsr%active) then
+         ! Atom-block version, a_seq contains the blocks of a (see sequential_acces_matrix_fast2)
+         call sparsemm_bsr(smat, a_seq, b, c)
+         call f_release_routine()
+         return
+     end if
+
      if (count_flops) then
          n_dense = nint(sqrt(real(smat%smmm%nseq,kind=mp)))
          !n_dense = smat%nfvctr
@@ -2320,11 +2391,11 @@ module sparsematrix
                            comm=smat%mpi_groups(iitg)%mpi_comm,request=request(itg))
                   else
                       call vcopy(ncount, mat%matrix_compr(ishift+ist_send), 1, recvbuf(ist_recv), 1)
+                      request(itg) = FMPI_REQUEST_NULL
                   end if
               end do
-              if (smat%mpi_groups(iitg)%nproc > 1) then
-                  call fmpi_waitall(smat%ntaskgroupp, request)
-              end if
+              ! Wait for the reductions of all taskgroups (and not only if the last one has more than one task)
+              call fmpi_waitall(smat%ntaskgroupp, request)
               ncount = 0
               do itg=1,smat%ntaskgroupp
                   iitg = smat%taskgroupid(itg)
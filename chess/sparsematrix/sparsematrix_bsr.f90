@@ -0,0 +1,471 @@
+!> @file
+!!   Atom-block (block sparse row) layout of the sparse matrix matrix multiplication
+!! @author
+!!   Copyright (C) 2016 CheSS developers
+!!
+!!   This file is part of CheSS.
+!!
+!!   CheSS is free software: you can redistribute it and/or modify
+!!   it under the terms of the GNU Lesser General Public License as published by
+!!   the Free Software Foundation, either version 3 of the License, or
+!!   (at your option) any later version.
+!!
+!!   CheSS is distributed in the hope that it will be useful,
+!!   but WITHOUT ANY WARRANTY; without even the implied warranty of
+!!   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+!!   GNU Lesser General Public License for more details.
+!!
+!!   You should have received a copy of the GNU Lesser General Public License
+!!   along with CheSS.  If not, see <http://www.gnu.org/licenses/>.
+
+
+!> Module to perform the sparse matrix matrix multiplication on dense atom blocks.
+!! In the compressed format, the lines of a block are consecutive and have all the same length,
+!! so that each block is a dense submatrix with a fixed leading dimension. The second factor and
+!! the result are therefore used in place, whereas the block rows of the first factor which are needed
+!! are gathered into a contiguous block storage (replacing the array of the sequential entries).
+module sparsematrix_bsr
+  use dynamic_memory
+  use sparsematrix_base
+  use time_profiling
+  implicit none
+
+  private
+
+  !> Public routines
+  public :: init_matmul_bsr
+  public :: compressed_to_bsr
+  public :: sparsemm_bsr
+
+  !> Minimal average length of the runs of consecutive products for which the block sparse
+  !! matmul is used; below this value the blocks are too small and the scalar version is faster
+  real(kind=mp),parameter :: MATMUL_BSR_MIN_RUN = 4.0_mp
+
+  contains
+
+    !> Determines the atom-block layout of the sparse matmul. The blocks are the runs of consecutive
+    !! basis functions having the same sparsity pattern both in smat and in the matmul pattern.
+    !! If one of the two patterns is not made of full blocks, or if the blocks are too small,
+    !! the block sparse matmul is not activated and the scalar version is used.
+    subroutine init_matmul_bsr(smat)
+      implicit none
+
+      ! Calling arguments
+      type(sparse_matrix),intent(inout) :: smat
+
+      ! Local variables
+      integer :: i, ib, kb, ip, nl, nb, nbs, ia, im, jm, ka, nj, nrun, nabsr, iseg, ioffa, ioffb, ilen, lenb
+      integer,dimension(2) :: inext
+      integer(kind=8) :: nprod
+      logical :: full
+      integer,dimension(:),allocatable :: blockof, jbl, jind, ista, sjb, sjind, sld, aoff, umin, umax
+      real(kind=mp) :: rrun
+
+      call f_routine(id='init_matmul_bsr')
+
+      call deallocate_sparse_matrix_bsr(smat%smmm%bsr)
+
+      if (matmul_version/=MATMUL_NEW .or. smat%nfvctr==0) then
+          call f_release_routine()
+          return
+      end if
+
+      ! Partition of the basis functions into blocks
+      blockof = f_malloc(smat%nfvctr,id='blockof')
+      nb = 1
+      blockof(1) = 1
+      do i=2,smat%nfvctr
+          if (.not.same_line(smat%nseg, smat%nsegline, smat%istsegline, smat%keyg, i-1, i) .or. &
+              .not.same_line(smat%smmm%nseg, smat%smmm%nsegline, smat%smmm%istsegline, smat%smmm%keyg, i-1, i)) then
+              nb = nb + 1
+          end if
+          blockof(i) = nb
+      end do
+      smat%smmm%bsr%nblock = nb
+      smat%smmm%bsr%isblock = f_malloc_ptr(nb+1,id='smat%smmm%bsr%isblock')
+      do i=smat%nfvctr,1,-1
+          smat%smmm%bsr%isblock(blockof(i)) = i
+      end do
+      smat%smmm%bsr%isblock(nb+1) = smat%nfvctr + 1
+
+      jbl = f_malloc(nb,id='jbl')
+      jind = f_malloc(nb,id='jind')
+      ista = f_malloc(nb+1,id='ista')
+      sld = f_malloc0(nb,id='sld')
+      aoff = f_malloc(nb,id='aoff')
+      umin = f_malloc(nb,id='umin')
+      umax = f_malloc(nb,id='umax')
+
+      ! Check that both patterns are made of full blocks, and count the blocks of smat
+      full = .true.
+      ista(1) = 0
+      do kb=1,nb
+          i = smat%smmm%bsr%isblock(kb)
+          call line_blocks(smat%nseg, smat%keyv, smat%keyg, smat%nsegline, smat%istsegline, &
+               nb, smat%smmm%bsr%isblock, blockof, i, nbs, jbl, jind, full)
+          if (.not.full) exit
+          ista(kb+1) = ista(kb) + nbs
+          call line_blocks(smat%smmm%nseg, smat%smmm%keyv, smat%smmm%keyg, smat%smmm%nsegline, smat%smmm%istsegline, &
+               nb, smat%smmm%bsr%isblock, blockof, i, nbs, jbl, jind, full)
+          if (.not.full) exit
+      end do
+
+      if (full) then
+          ! Blocks of each block row of smat, with their position within the line
+          sjb = f_malloc(ista(nb+1),id='sjb')
+          sjind = f_malloc(ista(nb+1),id='sjind')
+          do kb=1,nb
+              i = smat%smmm%bsr%isblock(kb)
+              call line_blocks(smat%nseg, smat%keyv, smat%keyg, smat%nsegline, smat%istsegline, &
+                   nb, smat%smmm%bsr%isblock, blockof, i, nbs, jbl, jind, full)
+              if (nbs==0) cycle
+              iseg = smat%istsegline(i)
+              do ib=1,nbs
+                  sjb(ista(kb)+ib) = jbl(ib)
+                  sjind(ista(kb)+ib) = jind(ib) - smat%keyv(iseg)
+              end do
+              iseg = smat%istsegline(i) + smat%nsegline(i) - 1
+              sld(kb) = smat%keyv(iseg) + smat%keyg(2,1,iseg) - smat%keyg(1,1,iseg) + 1 - smat%keyv(smat%istsegline(i))
+          end do
+
+          ! Blocks of the result: the local lines of the matmul pattern, cut into pieces at the
+          ! block boundaries. The result block (kb,piece) is the sum of the products of the blocks
+          ! (jb,kb) of the first factor with the blocks (jb,piece) of the second factor, for all common jb;
+          ! these products are merged into runs if they are consecutive in both factors.
+          ! The first pass counts the blocks and determines which part of the block rows of the first
+          ! factor is needed (only this part is guaranteed to be available in the taskgroup), the second
+          ! one fills the arrays.
+          aoff(:) = -1
+          umin(:) = huge(1)
+          umax(:) = -1
+          do ip=1,2
+              im = 0
+              nrun = 0
+              nprod = 0
+              i = smat%smmm%isfvctr + 1
+              do while (i<=smat%smmm%isfvctr+smat%smmm%nfvctrp)
+                  nl = min(smat%smmm%bsr%isblock(blockof(i)+1),smat%smmm%isfvctr+smat%smmm%nfvctrp+1) - i
+                  call line_blocks(smat%smmm%nseg, smat%smmm%keyv, smat%smmm%keyg, smat%smmm%nsegline, &
+                       smat%smmm%istsegline, nb, smat%smmm%bsr%isblock, blockof, i, nbs, jbl, jind, full)
+                  if (nbs>0) then
+                      iseg = smat%smmm%istsegline(i) + smat%smmm%nsegline(i) - 1
+                      lenb = smat%smmm%keyv(iseg) + smat%smmm%keyg(2,1,iseg) - smat%smmm%keyg(1,1,iseg) + 1 - &
+                             smat%smmm%keyv(smat%smmm%istsegline(i))
+                  end if
+                  do jm=1,nbs
+                      kb = jbl(jm)
+                      im = im + 1
+                      if (ip==1) then
+                          aoff(kb) = 0
+                      else
+                          smat%smmm%bsr%mblock(1,im) = smat%smmm%bsr%isblock(kb+1) - smat%smmm%bsr%isblock(kb)
+                          smat%smmm%bsr%mblock(2,im) = nl
+                          smat%smmm%bsr%mblock(3,im) = umax(kb) - umin(kb) + 1
+                          smat%smmm%bsr%mblock(4,im) = jind(jm) - smat%smmm%isvctr
+                          smat%smmm%bsr%mblock(5,im) = lenb
+                          smat%smmm%bsr%istlookup(im) = nrun + 1
+                      end if
+                      ilen = 0
+                      inext(1:2) = 0
+                      ia = ista(kb) + 1
+                      ka = 1
+                      do while (ia<=ista(kb+1) .and. ka<=nbs)
+                          if (sjb(ia)<jbl(ka)) then
+                              ia = ia + 1
+                          else if (sjb(ia)>jbl(ka)) then
+                              ka = ka + 1
+                          else
+                              nj = smat%smmm%bsr%isblock(sjb(ia)+1) - smat%smmm%bsr%isblock(sjb(ia))
+                              if (ip==1) then
+                                  umin(kb) = min(umin(kb),sjind(ia))
+                                  umax(kb) = max(umax(kb),sjind(ia)+nj-1)
+                                  ioffa = sjind(ia) + 1
+                              else
+                                  ioffa = aoff(kb) + sjind(ia) - umin(kb) + 1
+                              end if
+                              ioffb = jind(ka) - smat%smmm%isvctr
+                              nprod = nprod + int(nj,kind=8)
+                              if (ilen>0 .and. ioffa==inext(1) .and. ioffb==inext(2)) then
+                                  ! Consecutive in both factors: extend the current run
+                                  if (ip==2) smat%smmm%bsr%lookup(3,nrun) = smat%smmm%bsr%lookup(3,nrun) + nj
+                              else
+                                  nrun = nrun + 1
+                                  if (ip==2) then
+                                      smat%smmm%bsr%lookup(1,nrun) = ioffa
+                                      smat%smmm%bsr%lookup(2,nrun) = ioffb
+                                      smat%smmm%bsr%lookup(3,nrun) = nj
+                                  end if
+                              end if
+                              ilen = ilen + nj
+                              inext(1) = ioffa + nj
+                              inext(2) = ioffb + nj
+                              ia = ia + 1
+                              ka = ka + 1
+                          end if
+                      end do
+                  end do
+                  i = i + nl
+              end do
+              if (ip==1) then
+                  ! Offsets of the block rows of the first factor within the block storage
+                  nabsr = 0
+                  smat%smmm%bsr%nablock = 0
+                  do kb=1,nb
+                      if (aoff(kb)<0) cycle
+                      if (umax(kb)<0) then
+                          ! Block row which does not contribute
+                          umin(kb) = 0
+                          umax(kb) = -1
+                      end if
+                      aoff(kb) = nabsr
+                      nabsr = nabsr + (smat%smmm%bsr%isblock(kb+1)-smat%smmm%bsr%isblock(kb))*(umax(kb)-umin(kb)+1)
+                      smat%smmm%bsr%nablock = smat%smmm%bsr%nablock + 1
+                  end do
+                  smat%smmm%bsr%nabsr = nabsr
+                  smat%smmm%bsr%nmblock = im
+                  smat%smmm%bsr%ablock = f_malloc_ptr((/5,smat%smmm%bsr%nablock/),id='smat%smmm%bsr%ablock')
+                  smat%smmm%bsr%mblock = f_malloc_ptr((/5,im/),id='smat%smmm%bsr%mblock')
+                  smat%smmm%bsr%istlookup = f_malloc_ptr(im+1,id='smat%smmm%bsr%istlookup')
+                  smat%smmm%bsr%lookup = f_malloc_ptr((/3,nrun/),id='smat%smmm%bsr%lookup')
+                  ib = 0
+                  do kb=1,nb
+                      if (aoff(kb)<0) cycle
+                      ib = ib + 1
+                      i = smat%smmm%bsr%isblock(kb)
+                      smat%smmm%bsr%ablock(1,ib) = umax(kb) - umin(kb) + 1
+                      smat%smmm%bsr%ablock(2,ib) = smat%smmm%bsr%isblock(kb+1) - i
+                      smat%smmm%bsr%ablock(3,ib) = aoff(kb)
+                      smat%smmm%bsr%ablock(4,ib) = smat%keyv(smat%istsegline(i)) + umin(kb)
+                      smat%smmm%bsr%ablock(5,ib) = sld(kb)
+                  end do
+              end if
+          end do
+          smat%smmm%bsr%istlookup(im+1) = nrun + 1
+
+          call f_free(sjb)
+          call f_free(sjind)
+
+          ! Use the block version only if the runs are long enough; the block storage of the
+          ! first factor replaces the array of the sequential entries, so it must fit into it.
+          if (nrun>0) then
+              rrun = real(nprod,kind=mp)/real(nrun,kind=mp)
+          else
+              rrun = 0.0_mp
+          end if
+          smat%smmm%bsr%active = (rrun>=MATMUL_BSR_MIN_RUN .and. int(nabsr,kind=8)<=smat%smmm%nseq)
+      end if
+
+      if (.not.smat%smmm%bsr%active) then
+          call deallocate_sparse_matrix_bsr(smat%smmm%bsr)
+      end if
+
+      call f_free(blockof)
+      call f_free(jbl)
+      call f_free(jind)
+      call f_free(ista)
+      call f_free(sld)
+      call f_free(aoff)
+      call f_free(umin)
+      call f_free(umax)
+
+      call f_release_routine()
+
+    end subroutine init_matmul_bsr
+
+
+    !> Checks whether the lines iline and jline have the same sparsity pattern
+    pure function same_line(nseg, nsegline, istsegline, keyg, iline, jline)
+      implicit none
+      integer,intent(in) :: nseg, iline, jline
+      integer,dimension(:),intent(in) :: nsegline, istsegline
+      integer,dimension(2,2,nseg),intent(in) :: keyg
+      logical :: same_line
+      integer :: iseg, iiseg, jjseg
+
+      same_line = (nsegline(iline)==nsegline(jline))
+      if (.not.same_line) return
+      do iseg=0,nsegline(iline)-1
+          iiseg = istsegline(iline) + iseg
+          jjseg = istsegline(jline) + iseg
+          if (keyg(1,1,iiseg)/=keyg(1,1,jjseg) .or. keyg(2,1,iiseg)/=keyg(2,1,jjseg)) then
+              same_line = .false.
+              return
+          end if
+      end do
+    end function same_line
+
+
+    !> Gives the blocks (and the compressed index of their first element) which make up
+    !! the line iline; full is set to false if the line contains a block only partially
+    subroutine line_blocks(nseg, keyv, keyg, nsegline, istsegline, nblock, isblock, blockof, iline, nb, jblock, jindex, full)
+      implicit none
+      integer,intent(in) :: nseg, nblock, iline
+      integer,dimension(nseg),intent(in) :: keyv
+      integer,dimension(2,2,nseg),intent(in) :: keyg
+      integer,dimension(:),intent(in) :: nsegline, istsegline, blockof
+      integer,dimension(nblock+1),intent(in) :: isblock
+      integer,intent(out) :: nb
+      integer,dimension(nblock),intent(out) :: jblock, jindex
+      logical,intent(inout) :: full
+      integer :: iseg, j, jb
+
+      nb = 0
+      do iseg=istsegline(iline),istsegline(iline)+nsegline(iline)-1
+          j = keyg(1,1,iseg)
+          do while (j<=keyg(2,1,iseg))
+              jb = blockof(j)
+              if (j/=isblock(jb) .or. isblock(jb+1)-1>keyg(2,1,iseg)) then
+                  full = .false.
+                  return
+              end if
+              nb = nb + 1
+              jblock(nb) = jb
+              jindex(nb) = keyv(iseg) + j - keyg(1,1,iseg)
+              j = isblock(jb+1)
+          end do
+      end do
+    end subroutine line_blocks
+
+
+    !> Copies blocks of a matrix from the compressed storage (whose first element is the entry
+    !! ishift+1 of the full compressed matrix) to the block storage. Each block is described by
+    !! (1) its number of rows, (2) its number of columns, (3) its offset in the block storage,
+    !! (4) the index of its first element and (5) its leading dimension in the compressed storage.
+    subroutine compressed_to_bsr(nblock, blocks, ishift, ncompr, compr, nbsr, bsr)
+      implicit none
+      integer,intent(in) :: nblock, ishift, ncompr, nbsr
+      integer,dimension(5,nblock),intent(in) :: blocks
+      real(kind=mp),dimension(ncompr),intent(in) :: compr
+      real(kind=mp),dimension(nbsr),intent(out) :: bsr
+      integer :: iblock, icol, irow, ioff, ii
+
+      !$omp parallel do schedule(static) default(none) &
+      !$omp shared(nblock, blocks, ishift, compr, bsr) private(iblock, icol, irow, ioff, ii)
+      do iblock=1,nblock
+          ioff = blocks(3,iblock)
+          do icol=0,blocks(2,iblock)-1
+              ii = blocks(4,iblock) - ishift + icol*blocks(5,iblock) - 1
+              do irow=1,blocks(1,iblock)
+                  bsr(ioff+irow) = compr(ii+irow)
+              end do
+              ioff = ioff + blocks(1,iblock)
+          end do
+      end do
+      !$omp end parallel do
+    end subroutine compressed_to_bsr
+
+
+    !> Block version of the sparse matmul: c = a*b, where a is given in the block storage (as
+    !! returned by sequential_acces_matrix_fast2) and b and c in the local compressed matmul layout.
+    !! Each block of c is calculated at once from the runs of products of the blocks of a and b.
+    subroutine sparsemm_bsr(smat, a_bsr, b, c)
+      implicit none
+
+      ! Calling arguments
+      type(sparse_matrix),intent(in) :: smat
+      real(kind=mp),dimension(smat%smmm%bsr%nabsr),intent(in) :: a_bsr
+      real(kind=mp),dimension(smat%smmm%nvctrp),intent(in) :: b
+      real(kind=mp),dimension(smat%smmm%nvctrp),intent(out) :: c
+
+      ! Local variables
+      integer :: im
+
+      call f_routine(id='sparsemm_bsr')
+      call f_timing(TCAT_SMAT_MULTIPLICATION,'IR')
+
+      !$omp parallel do schedule(guided) default(none) &
+      !$omp shared(smat, a_bsr, b, c) private(im)
+      do im=1,smat%smmm%bsr%nmblock
+          call block_product(smat%smmm%bsr%mblock(1,im), smat%smmm%bsr%mblock(2,im), &
+               smat%smmm%bsr%mblock(3,im), smat%smmm%bsr%mblock(5,im), &
+               smat%smmm%bsr%istlookup(im), smat%smmm%bsr%istlookup(im+1)-1, smat%smmm%bsr%lookup, &
+               smat%smmm%bsr%nabsr, a_bsr, smat%smmm%nvctrp, b, c(smat%smmm%bsr%mblock(4,im)))
+      end do
+      !$omp end parallel do
+
+      call f_timing(TCAT_SMAT_MULTIPLICATION,'RS')
+      call f_release_routine()
+
+    end subroutine sparsemm_bsr
+
+
+    !> Dense micro-kernel for one block of the result, c(i,j) = sum_l a(l,i)*b(l,j), where l runs
+    !! over the runs ist to iend of consecutive products. The block is done by tiles of 2x2, such that each
+    !! element of a and b which is loaded is used twice; the inner loop is on contiguous memory.
+    !! It is written explicitly to avoid calling BLAS from within the OpenMP region.
+    subroutine block_product(m, n, lda, ldb, ist, iend, runs, na, a, nb, b, c)
+      implicit none
+      integer,intent(in) :: m, n, lda, ldb, ist, iend, na, nb
+      integer,dimension(:,:),intent(in) :: runs
+      real(kind=mp),dimension(na),intent(in) :: a
+      real(kind=mp),dimension(nb),intent(in) :: b
+      real(kind=mp),dimension(ldb,*),intent(out) :: c
+      integer :: i, j, ni, nj, irun, l, ia, ib
+      real(kind=mp) :: t11, t21, t12, t22, a1, a2, b1, b2
+
+      do j=1,n,2
+          nj = min(2,n-j+1)
+          do i=1,m,2
+              ni = min(2,m-i+1)
+              t11 = 0.0_mp
+              t21 = 0.0_mp
+              t12 = 0.0_mp
+              t22 = 0.0_mp
+              if (ni==2 .and. nj==2) then
+                  do irun=ist,iend
+                      ia = runs(1,irun) + (i-1)*lda - 1
+                      ib = runs(2,irun) + (j-1)*ldb - 1
+                      do l=1,runs(3,irun)
+                          a1 = a(ia+l)
+                          a2 = a(ia+lda+l)
+                          b1 = b(ib+l)
+                          b2 = b(ib+ldb+l)
+                          t11 = t11 + a1*b1
+                          t21 = t21 + a2*b1
+                          t12 = t12 + a1*b2
+                          t22 = t22 + a2*b2
+                      end do
+                  end do
+                  c(i,j) = t11
+                  c(i+1,j) = t21
+                  c(i,j+1) = t12
+                  c(i+1,j+1) = t22
+              else if (ni==2) then
+                  do irun=ist,iend
+                      ia = runs(1,irun) + (i-1)*lda - 1
+                      ib = runs(2,irun) + (j-1)*ldb - 1
+                      do l=1,runs(3,irun)
+                          b1 = b(ib+l)
+                          t11 = t11 + a(ia+l)*b1
+                          t21 = t21 + a(ia+lda+l)*b1
+                      end do
+                  end do
+                  c(i,j) = t11
+                  c(i+1,j) = t21
+              else if (nj==2) then
+                  do irun=ist,iend
+                      ia = runs(1,irun) + (i-1)*lda - 1
+                      ib = runs(2,irun) + (j-1)*ldb - 1
+                      do l=1,runs(3,irun)
+                          a1 = a(ia+l)
+                          t11 = t11 + a1*b(ib+l)
+                          t12 = t12 + a1*b(ib+ldb+l)
+                      end do
+                  end do
+                  c(i,j) = t11
+                  c(i,j+1) = t12
+              else
+                  do irun=ist,iend
+                      ia = runs(1,irun) + (i-1)*lda - 1
+                      ib = runs(2,irun) + (j-1)*ldb - 1
+                      do l=1,runs(3,irun)
+                          t11 = t11 + a(ia+l)*b(ib+l)
+                      end do
+                  end do
+                  c(i,j) = t11
+              end if
+          end do
+      end do
+    end subroutine block_product
+
+end module sparsematrix_bsr
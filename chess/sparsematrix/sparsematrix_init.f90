@@ -27,6 +27,7 @@ module sparsematrix_init
   use yaml_output
   use dynamic_memory, only: f_routine,f_release_routine
   use sparsematrix_base
+  use sparsematrix_bsr, only: init_matmul_bsr
   use wrapper_linalg
   use time_profiling
   implicit none
@@ -265,7 +266,7 @@ contains
     end function matrixindex_in_compressed_lowlevel
 
     subroutine init_sparse_matrix_matrix_multiplication_new(iproc, nproc, comm, norb, norbp, isorb, nseg, &
-         nsegline, istsegline, keyv, keyg, optimize_load_balancing, sparsemat)
+         nsegline, istsegline, keyv, keyg, optimize_load_balancing, matmul_bsr, sparsemat)
       use dynamic_memory
       implicit none
 
@@ -275,6 +276,7 @@ contains
       integer,dimension(nseg),intent(in) :: keyv
       integer,dimension(2,2,nseg),intent(in) :: keyg
       logical,intent(in) :: optimize_load_balancing
+      logical,intent(in) :: matmul_bsr !< allow the atom-block sparse matmul
       type(sparse_matrix),intent(inout) :: sparsemat
 
       integer :: jproc, iorb, iseq, ind, ii, iseg, ncount
@@ -546,6 +548,9 @@ contains
       !t2 = mpi_wtime()
       !write(*,*) 'iproc, time init_sequential_acces_matrix_new', iproc, t2-t1
 
+      ! Atom-block layout, used by the sparse matmul if allowed and if the sparsity patterns are made of dense blocks
+      if (matmul_bsr) call init_matmul_bsr(sparsemat)
+
       ! This array gives the starting and ending indices of the submatrix which
       ! is used by a given MPI task
       if (sparsemat%smmm%nseq>0) then
@@ -890,7 +895,7 @@ contains
     !> Currently assuming square matrices
     subroutine init_sparse_matrix(iproc, nproc, comm, norbu, nnonzero, nonzero, nnonzero_mult, &
                nonzero_mult, sparsemat, init_matmul, matmul_optimize_load_balancing, nspin, geocode, &
-               cell_dim, norbup, isorbu, store_index, on_which_atom, allocate_full, print_info)
+               cell_dim, norbup, isorbu, store_index, on_which_atom, allocate_full, print_info, matmul_bsr)
       use dynamic_memory
       use sparsematrix_memory, only: deallocate_sparse_matrix_matrix_multiplication
       implicit none
@@ -901,6 +906,7 @@ contains
       integer,dimension(2,nnonzero_mult),intent(inout) :: nonzero_mult
       type(sparse_matrix), intent(out) :: sparsemat
       logical,intent(in),optional :: init_matmul, matmul_optimize_load_balancing
+      logical,intent(in),optional :: matmul_bsr !< allow the atom-block sparse matmul (default yes)
       character(len=1),intent(in),optional :: geocode
       real(kind=mp),dimension(3),intent(in),optional :: cell_dim
       logical,intent(in),optional :: allocate_full, print_info, store_index
@@ -919,6 +925,7 @@ contains
       integer,dimension(:,:,:),allocatable :: keyg_mult
       integer,dimension(:),allocatable :: keyv_mult
       logical :: allocate_full_, print_info_, store_index_, matmul_optimize_load_balancing_ !LG: internal variables have the underscore, not the opposite
+      logical :: matmul_bsr_
       !integer(kind=mp) :: ntot
 
       real(kind=4) :: tr0, tr1, trt0, trt1
@@ -941,11 +948,13 @@ contains
       store_index_=.false.
       init_matmul_ = .true.
       matmul_optimize_load_balancing_ = .false.
+      matmul_bsr_ = .true.
       if (present(allocate_full)) allocate_full_=allocate_full
       if (present(print_info)) print_info_=print_info
       if (present(store_index)) store_index_=store_index
       if (present(init_matmul)) init_matmul_ = init_matmul
       if (present(matmul_optimize_load_balancing)) matmul_optimize_load_balancing_ = matmul_optimize_load_balancing
+      if (present(matmul_bsr)) matmul_bsr_ = matmul_bsr
 
       ! Sort the nonzero entries
       call sort_nonzero_entries(nnonzero, nonzero)
@@ -1250,7 +1259,7 @@ contains
           call init_sparse_matrix_matrix_multiplication_new(iproc, nproc, comm, &
                norbu, sparsemat%nfvctrp, sparsemat%isfvctr, nseg_mult, &
                nsegline_mult, istsegline_mult, keyv_mult, keyg_mult, &
-               .true., sparsemat)
+               .true., matmul_bsr_, sparsemat)
           if (matmul_optimize_load_balancing_) then
     
               ! Perform a sparse multiplication and get the timings
@@ -1376,7 +1385,7 @@ contains
               call deallocate_sparse_matrix_matrix_multiplication(sparsemat%smmm)
               call init_sparse_matrix_matrix_multiplication_new(iproc, nproc, comm, &
                    norbu, norb_par_ideal(iproc), isorb_par_ideal(iproc), nseg_mult, &
-                   nsegline_mult, istsegline_mult, keyv_mult, keyg_mult, .false., sparsemat)
+                   nsegline_mult, istsegline_mult, keyv_mult, keyg_mult, .false., matmul_bsr_, sparsemat)
 
               call write_matmul_memory(iproc, nproc, comm, sparsemat%smmm)
 
@@ -2839,7 +2848,7 @@ contains
 
     !> Uses the BigDFT sparsity pattern to create a BigDFT sparse_matrix type
     subroutine bigdft_to_sparsebigdft(iproc, nproc, comm, ncol, nvctr, nseg, keyg, smat, &
-         init_matmul, nspin, geocode, cell_dim, on_which_atom, nseg_mult, nvctr_mult, keyg_mult)
+         init_matmul, nspin, geocode, cell_dim, on_which_atom, nseg_mult, nvctr_mult, keyg_mult, matmul_bsr)
       use f_utils
       use dynamic_memory
       implicit none
@@ -2854,6 +2863,7 @@ contains
       integer,dimension(ncol),target,intent(in),optional :: on_which_atom
       integer,intent(in),optional :: nseg_mult, nvctr_mult
       integer,dimension(:,:,:),intent(in),optional :: keyg_mult
+      logical,intent(in),optional :: matmul_bsr
 
       ! Local variables
       integer :: nspin_,i_none
@@ -2963,7 +2973,7 @@ contains
       if (init_matmul_) then
           call init_sparse_matrix(iproc, nproc, comm, ncol, nvctr, nonzero, nvctr_mult, nonzero_mult, smat, &
                init_matmul=init_matmul_, matmul_optimize_load_balancing=.true., nspin=nspin_, geocode=geocode_, &
-               cell_dim=cell_dim_, on_which_atom=on_which_atom_)
+               cell_dim=cell_dim_, on_which_atom=on_which_atom_, matmul_bsr=matmul_bsr)
       else
           call init_sparse_matrix(iproc, nproc, comm, ncol, nvctr, nonzero, nvctr, nonzero, smat, &
                init_matmul=init_matmul_, matmul_optimize_load_balancing=.true., nspin=nspin_, geocode=geocode_, &
@@ -3658,7 +3668,7 @@ contains
       integer :: ntaskgrp_calc, ntaskgrp_use, i, ncount, iitaskgroup, group, ierr, iitaskgroups, iseg
       !logical :: go_on
       integer,dimension(:,:),allocatable :: in_taskgroup
-      integer :: iproc_start, iproc_end, imin, imax, niter
+      integer :: iproc_start, iproc_end, imin, imax, niter, jj
       logical :: found, found_start, found_end
       !integer :: jstart, kkproc, kproc, jend, lproc, llproc
       !integer :: iprocstart_current, iprocend_current, iprocend_prev, iprocstart_next
@@ -4475,6 +4485,16 @@ contains
               ii = ii + 1
           end do
 
+          ! The reverse information, i.e. which parts of its own data a task has to send to the others.
+          ! The used parts of all tasks are known, so this needs no communication.
+          jj = 0
+          do jproc=0,nproc-1
+              istart = max(iuse_startend(1,jproc),isvctr_par(iproc)+1)
+              iend = min(iuse_startend(2,jproc),isvctr_par(iproc)+nvctr_par(iproc))
+              if (istart>iend) cycle
+              jj = jj + 1
+          end do
+
           if (i==2) then
               if (.not.smat%smatmul_initialized) then
                   call f_err_throw('sparse matrix multiplication not initialized', &
@@ -4482,9 +4502,13 @@ contains
               end if
               smat%smmm%nccomm_smmm = ii
               smat%smmm%luccomm_smmm = f_malloc_ptr((/4,smat%smmm%nccomm_smmm/),id='smat%smmm%luccomm_smmm')
+              smat%smmm%nscomm_smmm = jj
+              smat%smmm%luscomm_smmm = f_malloc_ptr((/3,smat%smmm%nscomm_smmm/),id='smat%smmm%luscomm_smmm')
           else if (i==1) then
               smat%nccomm = ii
               smat%luccomm = f_malloc_ptr((/4,smat%nccomm/),id='smatluccomm')
+              smat%nscomm = jj
+              smat%luscomm = f_malloc_ptr((/3,smat%nscomm/),id='smat%luscomm')
           end if
 
           !!smat%smmm%luccomm_smmm = f_malloc_ptr((/4,smat%smmm%nccomm_smmm/),id='smat%smmm%luccomm_smmm')
@@ -4518,6 +4542,22 @@ contains
                   smat%luccomm(4,ii) = iend-istart+1 !number of elements
               end if
           end do
+          jj = 0
+          do jproc=0,nproc-1
+              istart = max(iuse_startend(1,jproc),isvctr_par(iproc)+1)
+              iend = min(iuse_startend(2,jproc),isvctr_par(iproc)+nvctr_par(iproc))
+              if (istart>iend) cycle
+              jj = jj + 1
+              if (i==2) then
+                  smat%smmm%luscomm_smmm(1,jj) = jproc !send data to this process
+                  smat%smmm%luscomm_smmm(2,jj) = istart-isvctr_par(iproc) !starting address on sending process
+                  smat%smmm%luscomm_smmm(3,jj) = iend-istart+1 !number of elements
+              else if (i==1) then
+                  smat%luscomm(1,jj) = jproc !send data to this process
+                  smat%luscomm(2,jj) = istart-isvctr_par(iproc) !starting address on sending process
+                  smat%luscomm(3,jj) = iend-istart+1 !number of elements
+              end if
+          end do
       end do
 
       call f_free(in_taskgroup)
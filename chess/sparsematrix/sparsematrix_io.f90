@@ -41,6 +41,30 @@ module sparsematrix_io
   public :: write_dense_matrix
   public :: read_dense_matrix
   public :: write_linear_eigenvalues
+  public :: read_sparse_matrix_lines
+
+  !> Layout of the binary container ('parallel_mpi-binary', extension .bin)
+  character(len=8),parameter :: BIN_TAG = 'CHESSBIN' !< tag at the beginning of the file
+  integer,parameter :: BIN_VERSION = 1 !< version of the container
+  integer,parameter :: BIN_NHEADER = 16 !< number of long integers in the header (following the tag)
+  integer(kind=f_long),parameter :: BIN_OFFSET_KEYS = 256 !< byte offset of the keys
+  integer(kind=f_long),parameter :: BIN_ALIGNMENT = 4096 !< alignment of the values (page size), allows to map them
+  ! Entries of the header
+  integer,parameter :: BIN_H_VERSION = 1
+  integer,parameter :: BIN_H_NSPIN = 2
+  integer,parameter :: BIN_H_NFVCTR = 3
+  integer,parameter :: BIN_H_NSEG = 4
+  integer,parameter :: BIN_H_NVCTR = 5
+  integer,parameter :: BIN_H_HAS_VALUES = 6
+  integer,parameter :: BIN_H_HAS_METADATA = 7
+  integer,parameter :: BIN_H_NAT = 8
+  integer,parameter :: BIN_H_NTYPES = 9
+  integer,parameter :: BIN_H_OFF_KEYS = 10
+  integer,parameter :: BIN_H_OFF_LINES = 11
+  integer,parameter :: BIN_H_OFF_METADATA = 12
+  integer,parameter :: BIN_H_OFF_VALUES = 13
+  integer,parameter :: BIN_H_SIZE_INTEGER = 14
+  integer,parameter :: BIN_H_SIZE_DOUBLE = 15
 
   contains
 
@@ -119,6 +143,13 @@ module sparsematrix_io
                    err_name='SPARSEMATRIX_IO_ERROR')
           end if
           call read_sparse_matrix_parallel(filename, iproc, nproc, comm, nspin, nfvctr, nseg, nvctr, keyv, keyg, mat_compr)
+      else if (trim(mode)=='parallel_mpi-binary') then
+          if (trim(filename_extension)/='.bin') then
+              call f_err_throw("Wrong file extension; '.bin' is required, but found "//trim(filename_extension)&
+                   &//" ("//trim(filename)//")", &
+                   err_name='SPARSEMATRIX_IO_ERROR')
+          end if
+          call read_sparse_matrix_binary(filename, iproc, nproc, comm, nspin, nfvctr, nseg, nvctr, keyv, keyg, mat_compr)
       else if (trim(mode)=='serial_text') then
           if (trim(filename_extension)/='.txt') then
               call f_err_throw("Wrong file extension; '.txt' is required, but found "//trim(filename_extension)&
@@ -255,7 +286,7 @@ module sparsematrix_io
           nseg_long = int(nseg,kind=f_long)
           disp = int((four_long+five_long*nseg_long)*size_of_integer_long+is_long*size_of_double_long,kind=mpi_offset_kind)
           call mpi_file_set_view(thefile, disp, mpi_double_precision, mpi_double_precision, 'native', mpi_info_null, ierr) 
-          if (np>1) then
+          if (np>0) then
               call mpi_file_read(thefile, mat_compr(is+1), np, mpi_double_precision, mpi_status_ignore, ierr)
           end if
       end do
@@ -268,6 +299,189 @@ module sparsematrix_io
     end subroutine read_sparse_matrix_parallel
 
 
+    !> Read a sparse matrix from the binary container (see write_sparse_matrix_binary).
+    !! Each task reads a part of the values with collective MPI-IO, and the full matrix is
+    !! then made available on all tasks.
+    subroutine read_sparse_matrix_binary(filename, iproc, nproc, comm, nspin, nfvctr, nseg, nvctr, keyv, keyg, mat_compr)
+      use sparsematrix_init, only: distribute_on_tasks
+      implicit none
+      
+      ! Calling arguments
+      character(len=*),intent(in) :: filename
+      integer,intent(in) :: iproc, nproc, comm
+      integer,intent(out) :: nspin, nfvctr, nseg, nvctr
+      integer,dimension(:),pointer,intent(out) :: keyv
+      integer,dimension(:,:,:),pointer,intent(out) :: keyg
+      real(kind=mp),dimension(:),pointer,intent(out) :: mat_compr
+
+      ! Local variables
+      integer :: iseg, np, is, ierr, thefile, ispin, ioffset
+      integer(kind=f_long),dimension(BIN_NHEADER) :: header
+      integer(kind=mpi_offset_kind) :: disp
+      integer,dimension(:,:),allocatable :: workarr_keys
+
+      call f_routine(id='read_sparse_matrix_binary')
+
+      call mpi_file_open(comm, trim(filename), & 
+           mpi_mode_rdonly, & 
+           mpi_info_null, thefile, ierr) 
+      if (ierr/=0) then
+          call f_err_throw("Could not open the file '"//trim(filename)//"'", &
+               err_name='SPARSEMATRIX_IO_ERROR')
+      end if
+
+      call read_binary_header(thefile, .true., filename, header)
+      nspin = int(header(BIN_H_NSPIN))
+      nfvctr = int(header(BIN_H_NFVCTR))
+      nseg = int(header(BIN_H_NSEG))
+      nvctr = int(header(BIN_H_NVCTR))
+
+      ! Read the matrix keys; they are needed by all tasks and are small compared to the values
+      keyv = f_malloc_ptr(nseg,id='keyv')
+      keyg = f_malloc_ptr((/2,2,nseg/),id='keyg')
+      workarr_keys = f_malloc((/5,nseg/),id='workarr_keys')
+      disp = int(header(BIN_H_OFF_KEYS),kind=mpi_offset_kind)
+      call mpi_file_read_at_all(thefile, disp, workarr_keys, 5*nseg, mpi_integer, mpi_status_ignore, ierr)
+      do iseg=1,nseg
+          keyv(iseg) = workarr_keys(1,iseg)
+          keyg(1,1,iseg) = workarr_keys(2,iseg)
+          keyg(2,1,iseg) = workarr_keys(3,iseg)
+          keyg(1,2,iseg) = workarr_keys(4,iseg)
+          keyg(2,2,iseg) = workarr_keys(5,iseg)
+      end do
+      call f_free(workarr_keys)
+
+      ! Read the matrices
+      mat_compr = f_malloc0_ptr(nvctr*nspin,id='mat_compr')
+      if (header(BIN_H_HAS_VALUES)/=0) then
+          call distribute_on_tasks(nvctr, iproc, nproc, np, is)
+          do ispin=1,nspin
+              ioffset = (ispin-1)*nvctr
+              disp = int(header(BIN_H_OFF_VALUES) + &
+                     int(ioffset+is,kind=f_long)*header(BIN_H_SIZE_DOUBLE),kind=mpi_offset_kind)
+              call mpi_file_read_at_all(thefile, disp, mat_compr(min(ioffset+is+1,nvctr*nspin)), np, &
+                   mpi_double_precision, mpi_status_ignore, ierr)
+          end do
+          call fmpi_allreduce(mat_compr, FMPI_SUM, comm=comm)
+      end if
+
+      call mpi_file_close(thefile, ierr)      
+
+      call f_release_routine()
+
+    end subroutine read_sparse_matrix_binary
+
+
+    !> Read only the lines iline_start to iline_end (for the spin component ispin) of a matrix
+    !! stored in the binary container, without loading the remaining values.
+    !! On exit, mat_lines contains the elements ist_compr+1 to ist_compr+size(mat_lines) of the
+    !! compressed matrix (with respect to the beginning of the spin component).
+    !! This routine is not collective and can be called by each task independently.
+    subroutine read_sparse_matrix_lines(filename, ispin, iline_start, iline_end, ist_compr, mat_lines)
+      implicit none
+      
+      ! Calling arguments
+      character(len=*),intent(in) :: filename
+      integer,intent(in) :: ispin, iline_start, iline_end
+      integer,intent(out) :: ist_compr
+      real(kind=mp),dimension(:),pointer,intent(out) :: mat_lines
+
+      ! Local variables
+      integer :: ierr, thefile, ncount
+      integer(kind=f_long),dimension(BIN_NHEADER) :: header
+      integer(kind=f_long),dimension(1) :: iline_ptr
+      integer(kind=mpi_offset_kind) :: disp
+
+      call f_routine(id='read_sparse_matrix_lines')
+
+      call mpi_file_open(mpi_comm_self, trim(filename), & 
+           mpi_mode_rdonly, & 
+           mpi_info_null, thefile, ierr) 
+      if (ierr/=0) then
+          call f_err_throw("Could not open the file '"//trim(filename)//"'", &
+               err_name='SPARSEMATRIX_IO_ERROR')
+      end if
+
+      call read_binary_header(thefile, .false., filename, header)
+      if (ispin<1 .or. ispin>header(BIN_H_NSPIN)) then
+          call f_err_throw('Wrong spin component: '//trim(yaml_toa(ispin)), &
+               err_name='SPARSEMATRIX_IO_ERROR')
+      end if
+      if (iline_start<1 .or. iline_end>header(BIN_H_NFVCTR) .or. iline_start>iline_end+1) then
+          call f_err_throw('Wrong line range: '//trim(yaml_toa((/iline_start,iline_end/))), &
+               err_name='SPARSEMATRIX_IO_ERROR')
+      end if
+      if (header(BIN_H_HAS_VALUES)==0) then
+          call f_err_throw("The file '"//trim(filename)//"' contains only the sparsity pattern", &
+               err_name='SPARSEMATRIX_IO_ERROR')
+      end if
+
+      ! Get the range of the compressed matrix from the line pointers
+      disp = int(header(BIN_H_OFF_LINES)+int(iline_start-1,kind=f_long)*8_f_long,kind=mpi_offset_kind)
+      call mpi_file_read_at(thefile, disp, iline_ptr, 1, mpi_integer8, mpi_status_ignore, ierr)
+      ist_compr = int(iline_ptr(1))
+      disp = int(header(BIN_H_OFF_LINES)+int(iline_end,kind=f_long)*8_f_long,kind=mpi_offset_kind)
+      call mpi_file_read_at(thefile, disp, iline_ptr, 1, mpi_integer8, mpi_status_ignore, ierr)
+      ncount = int(iline_ptr(1)) - ist_compr
+
+      mat_lines = f_malloc_ptr(ncount,id='mat_lines')
+      if (ncount>0) then
+          disp = int(header(BIN_H_OFF_VALUES) + &
+                 (int(ispin-1,kind=f_long)*header(BIN_H_NVCTR)+int(ist_compr,kind=f_long))*header(BIN_H_SIZE_DOUBLE), &
+                 kind=mpi_offset_kind)
+          call mpi_file_read_at(thefile, disp, mat_lines, ncount, mpi_double_precision, mpi_status_ignore, ierr)
+      end if
+
+      call mpi_file_close(thefile, ierr)      
+
+      call f_release_routine()
+
+    end subroutine read_sparse_matrix_lines
+
+
+    !> Read and check the header of the binary container
+    subroutine read_binary_header(thefile, collective, filename, header)
+      implicit none
+      
+      ! Calling arguments
+      integer,intent(in) :: thefile
+      logical,intent(in) :: collective
+      character(len=*),intent(in) :: filename
+      integer(kind=f_long),dimension(BIN_NHEADER),intent(out) :: header
+
+      ! Local variables
+      integer :: ierr
+      character(len=len(BIN_TAG)) :: tag
+      integer(kind=mpi_offset_kind) :: disp
+
+      disp = int(0,kind=mpi_offset_kind)
+      if (collective) then
+          call mpi_file_read_at_all(thefile, disp, tag, len(tag), mpi_character, mpi_status_ignore, ierr)
+      else
+          call mpi_file_read_at(thefile, disp, tag, len(tag), mpi_character, mpi_status_ignore, ierr)
+      end if
+      if (tag/=BIN_TAG) then
+          call f_err_throw("The file '"//trim(filename)//"' is not a CheSS binary matrix", &
+               err_name='SPARSEMATRIX_IO_ERROR')
+      end if
+      disp = int(len(BIN_TAG),kind=mpi_offset_kind)
+      if (collective) then
+          call mpi_file_read_at_all(thefile, disp, header, BIN_NHEADER, mpi_integer8, mpi_status_ignore, ierr)
+      else
+          call mpi_file_read_at(thefile, disp, header, BIN_NHEADER, mpi_integer8, mpi_status_ignore, ierr)
+      end if
+      if (header(BIN_H_VERSION)/=BIN_VERSION) then
+          call f_err_throw('Unsupported version of the binary matrix format: '//trim(yaml_toa(header(BIN_H_VERSION))), &
+               err_name='SPARSEMATRIX_IO_ERROR')
+      end if
+      if (header(BIN_H_SIZE_INTEGER)/=mpitypesize(1) .or. header(BIN_H_SIZE_DOUBLE)/=mpitypesize(1.0_mp)) then
+          call f_err_throw("The file '"//trim(filename)//"' was written with different data sizes", &
+               err_name='SPARSEMATRIX_IO_ERROR')
+      end if
+
+    end subroutine read_binary_header
+
+
     subroutine read_sparse_matrix_metadata(filename, nfvctr, nat, ntypes, units, geocode, cell_dim, shift, &
                nzatom, nelpsp, atomnames, iatype, rxyz, on_which_atom)
       use dynamic_memory
@@ -287,13 +501,24 @@ module sparsematrix_io
       integer,dimension(:),pointer,intent(inout) :: on_which_atom
 
       ! Local variables
-      integer :: iunit, iat, itype, i
+      integer :: iunit, iat, itype, i, index_dot
       !real(kind=mp) :: dummy_double
       !character(len=20) :: dummy_char
       !logical :: read_rxyz, read_on_which_atom
 
       call f_routine(id='read_sparse_matrix_metadata')
 
+      ! The binary container may carry the metadata together with a matrix
+      index_dot = index(filename,'.',back=.true.)
+      if (index_dot>0) then
+          if (filename(index_dot:)=='.bin') then
+              call read_sparse_matrix_metadata_binary(filename, nfvctr, nat, ntypes, units, geocode, cell_dim, shift, &
+                   nzatom, nelpsp, atomnames, iatype, rxyz, on_which_atom)
+              call f_release_routine()
+              return
+          end if
+      end if
+
       iunit = 99
       call f_open_file(iunit, file=trim(filename), binary=.false.)
 
@@ -325,10 +550,94 @@ module sparsematrix_io
     end subroutine read_sparse_matrix_metadata
 
 
+    !> Read the metadata embedded in a binary container (see write_sparse_matrix_binary)
+    subroutine read_sparse_matrix_metadata_binary(filename, nfvctr, nat, ntypes, units, geocode, cell_dim, shift, &
+               nzatom, nelpsp, atomnames, iatype, rxyz, on_which_atom)
+      implicit none
+      
+      ! Calling arguments
+      character(len=*),intent(in) :: filename
+      integer,intent(out) :: nfvctr
+      character(len=20),intent(out) :: units
+      character(len=1),intent(out) :: geocode
+      real(kind=mp),dimension(3),intent(out) :: cell_dim, shift
+      integer,intent(out) :: nat, ntypes
+      integer,dimension(:),pointer,intent(inout) :: nzatom, nelpsp, iatype
+      character(len=20),dimension(:),pointer,intent(inout) :: atomnames
+      real(kind=mp),dimension(:,:),pointer,intent(inout) :: rxyz
+      integer,dimension(:),pointer,intent(inout) :: on_which_atom
+
+      ! Local variables
+      integer :: ierr, thefile, itype
+      integer(kind=f_long),dimension(BIN_NHEADER) :: header
+      integer(kind=mpi_offset_kind) :: disp
+      real(kind=mp),dimension(6) :: cell
+      character(len=20) :: name
+
+      call f_routine(id='read_sparse_matrix_metadata_binary')
+
+      call mpi_file_open(mpi_comm_self, trim(filename), & 
+           mpi_mode_rdonly, & 
+           mpi_info_null, thefile, ierr) 
+      if (ierr/=0) then
+          call f_err_throw("Could not open the file '"//trim(filename)//"'", &
+               err_name='SPARSEMATRIX_IO_ERROR')
+      end if
+
+      call read_binary_header(thefile, .false., filename, header)
+      if (header(BIN_H_HAS_METADATA)==0) then
+          call f_err_throw("The file '"//trim(filename)//"' does not contain the matrix metadata", &
+               err_name='SPARSEMATRIX_IO_ERROR')
+      end if
+      nfvctr = int(header(BIN_H_NFVCTR))
+      nat = int(header(BIN_H_NAT))
+      ntypes = int(header(BIN_H_NTYPES))
+
+      nzatom = f_malloc_ptr(ntypes,id='nzatom')
+      nelpsp = f_malloc_ptr(ntypes,id='nelpsp')
+      atomnames = f_malloc0_str_ptr(len(atomnames),ntypes,id='atomnames')
+      rxyz = f_malloc_ptr((/3,nat/),id='rxyz')
+      iatype = f_malloc_ptr(nat,id='iatype')
+      on_which_atom = f_malloc_ptr(nfvctr,id='on_which_atom')
+
+      ! Same order as in write_sparse_matrix_binary
+      disp = int(header(BIN_H_OFF_METADATA),kind=mpi_offset_kind)
+      call mpi_file_read_at(thefile, disp, cell, 6, mpi_double_precision, mpi_status_ignore, ierr)
+      cell_dim(1:3) = cell(1:3)
+      shift(1:3) = cell(4:6)
+      disp = disp + 6*header(BIN_H_SIZE_DOUBLE)
+      call mpi_file_read_at(thefile, disp, rxyz, 3*nat, mpi_double_precision, mpi_status_ignore, ierr)
+      disp = disp + 3*nat*header(BIN_H_SIZE_DOUBLE)
+      call mpi_file_read_at(thefile, disp, nzatom, ntypes, mpi_integer, mpi_status_ignore, ierr)
+      disp = disp + ntypes*header(BIN_H_SIZE_INTEGER)
+      call mpi_file_read_at(thefile, disp, nelpsp, ntypes, mpi_integer, mpi_status_ignore, ierr)
+      disp = disp + ntypes*header(BIN_H_SIZE_INTEGER)
+      call mpi_file_read_at(thefile, disp, iatype, nat, mpi_integer, mpi_status_ignore, ierr)
+      disp = disp + nat*header(BIN_H_SIZE_INTEGER)
+      call mpi_file_read_at(thefile, disp, on_which_atom, nfvctr, mpi_integer, mpi_status_ignore, ierr)
+      disp = disp + nfvctr*header(BIN_H_SIZE_INTEGER)
+      call mpi_file_read_at(thefile, disp, geocode, 1, mpi_character, mpi_status_ignore, ierr)
+      disp = disp + 1
+      call mpi_file_read_at(thefile, disp, units, 20, mpi_character, mpi_status_ignore, ierr)
+      disp = disp + 20
+      do itype=1,ntypes
+          call mpi_file_read_at(thefile, disp, name, 20, mpi_character, mpi_status_ignore, ierr)
+          atomnames(itype) = name
+          disp = disp + 20
+      end do
+
+      call mpi_file_close(thefile, ierr)      
+
+      call f_release_routine()
+
+    end subroutine read_sparse_matrix_metadata_binary
+
+
     !> Write a sparse matrix to disk.
     !! ATTENTION: This routine must be called by all MPI tasks due to the fact that the matrix 
     !! is distributed among the matrix taksgroups
-    subroutine write_sparse_matrix(mode, iproc, nproc, comm, smat, mat, filename)
+    !! With the mode 'parallel_mpi-binary', the metadata smmd (if present) is stored in the same file.
+    subroutine write_sparse_matrix(mode, iproc, nproc, comm, smat, mat, filename, smmd)
       use dynamic_memory
       use f_utils
       use sparsematrix, only: gather_matrix_from_taskgroups
@@ -340,6 +649,7 @@ module sparsematrix_io
       type(sparse_matrix),intent(in) :: smat
       type(matrices),intent(in) :: mat
       character(len=*),intent(in) :: filename
+      type(sparse_matrix_metadata),intent(in),optional :: smmd
 
       ! Local variables
       integer :: iunit, iseg, icol, irow, jorb, ind, ispin
@@ -353,6 +663,23 @@ module sparsematrix_io
           call f_err_throw('filename is too long')
       end if
 
+      if (trim(mode)=='parallel_mpi-binary') then
+          ! Each task writes directly its part of the matrix, no need to gather it
+          call write_sparse_matrix_binary(iproc, comm, &
+               smat%nspin, smat%nfvctr, smat%nseg, smat%nvctr, smat%keyv, smat%keyg, &
+               trim(filename)//'.bin', smat%nvctrp_tg, smat%isvctrp_tg, smat%nvctrp, smat%isvctr, &
+               mat%matrix_compr, smmd)
+          if (smat%smatmul_initialized) then
+              filename_matmul = trim(filename)//'_matmul'
+              ! Only the sparsity pattern is stored, as the entries have no meaning
+              call write_sparse_matrix_binary(iproc, comm, &
+                   smat%nspin, smat%nfvctr, smat%smmm%nseg, sum(smat%smmm%nvctr_par), &
+                   smat%smmm%keyv, smat%smmm%keyg, trim(filename_matmul)//'.bin', 0, 0, 0, 0)
+          end if
+          call f_release_routine()
+          return
+      end if
+
       matrix_compr = sparsematrix_malloc(smat,iaction=SPARSE_FULL,id='matrix_compr')
       call gather_matrix_from_taskgroups(iproc, nproc, comm, &
            smat, mat%matrix_compr, matrix_compr)
@@ -536,7 +863,7 @@ module sparsematrix_io
           nseg_long = int(nseg,kind=f_long)
           disp = int((four_long+five_long*nseg_long)*size_of_integer_long+is_long*size_of_double_long,kind=mpi_offset_kind)
           call mpi_file_set_view(thefile, disp, mpi_double_precision, mpi_double_precision, 'native', mpi_info_null, ierr)
-          if (np>1) then
+          if (np>0) then
               call mpi_file_write(thefile, matrix_compr(is+1), np, mpi_double_precision, mpi_status_ignore, ierr)
           end if
       end do
@@ -548,6 +875,180 @@ module sparsematrix_io
     end subroutine write_sparse_matrix_parallel
 
 
+    !> Write a sparse matrix to the binary container (extension .bin).
+    !! The file starts with the tag BIN_TAG, followed by BIN_NHEADER long integers (see the BIN_H_*
+    !! entries) giving the dimensions and the byte offsets of the sections:
+    !!  - the keys (5*nseg integers, as in the MPI native format)
+    !!  - the line pointers (nfvctr+1 long integers, i.e. the position in the compressed matrix
+    !!    where each line starts, counting from 0), allowing to read only some lines
+    !!  - the metadata of the matrix (optional)
+    !!  - the values (optional); they are aligned to BIN_ALIGNMENT, so that they can be mapped into memory
+    !! Task 0 writes the header and the sparsity pattern, and each task writes its own part
+    !! (isvctr+1:isvctr+nvctrp) of the values with collective MPI-IO.
+    subroutine write_sparse_matrix_binary(iproc, comm, nspin, nfvctr, nseg, nvctr, &
+               keyv, keyg, filename, nvctrp_tg, isvctrp_tg, nvctrp, isvctr, mat_tg, smmd)
+      implicit none
+      
+      ! Calling arguments
+      integer,intent(in) :: iproc, comm
+      integer,intent(in) :: nspin, nfvctr, nseg, nvctr
+      integer,dimension(nseg),intent(in) :: keyv
+      integer,dimension(2,2,nseg),intent(in) :: keyg
+      character(len=*),intent(in) :: filename
+      integer,intent(in) :: nvctrp_tg, isvctrp_tg, nvctrp, isvctr
+      real(kind=mp),dimension(nvctrp_tg,nspin),intent(in),optional :: mat_tg
+      type(sparse_matrix_metadata),intent(in),optional :: smmd
+
+      ! Local variables
+      integer :: iseg, iline, ierr, thefile, ispin, ist, itype
+      integer(kind=f_long) :: size_of_integer, size_of_double, nat, ntypes
+      integer(kind=mpi_offset_kind) :: disp
+      integer(kind=f_long),dimension(BIN_NHEADER) :: header
+      integer,dimension(:,:),allocatable :: workarr_keys
+      integer(kind=f_long),dimension(:),allocatable :: line_ptr
+
+      call f_routine(id='write_sparse_matrix_binary')
+
+      if (present(smmd)) then
+          if (smmd%nfvctr/=nfvctr) then
+              call f_err_throw('The metadata do not correspond to the matrix', &
+                   err_name='SPARSEMATRIX_IO_ERROR')
+          end if
+          nat = int(smmd%nat,kind=f_long)
+          ntypes = int(smmd%ntypes,kind=f_long)
+      else
+          nat = 0_f_long
+          ntypes = 0_f_long
+      end if
+
+      ! Determine the layout of the file
+      size_of_integer = int(mpitypesize(1),kind=f_long)
+      size_of_double = int(mpitypesize(1.0_mp),kind=f_long)
+      header = 0_f_long
+      header(BIN_H_VERSION) = int(BIN_VERSION,kind=f_long)
+      header(BIN_H_NSPIN) = int(nspin,kind=f_long)
+      header(BIN_H_NFVCTR) = int(nfvctr,kind=f_long)
+      header(BIN_H_NSEG) = int(nseg,kind=f_long)
+      header(BIN_H_NVCTR) = int(nvctr,kind=f_long)
+      header(BIN_H_HAS_VALUES) = merge(1_f_long,0_f_long,present(mat_tg))
+      header(BIN_H_HAS_METADATA) = merge(1_f_long,0_f_long,present(smmd))
+      header(BIN_H_NAT) = nat
+      header(BIN_H_NTYPES) = ntypes
+      header(BIN_H_SIZE_INTEGER) = size_of_integer
+      header(BIN_H_SIZE_DOUBLE) = size_of_double
+      header(BIN_H_OFF_KEYS) = BIN_OFFSET_KEYS
+      header(BIN_H_OFF_LINES) = aligned_offset(header(BIN_H_OFF_KEYS) + 5*int(nseg,kind=f_long)*size_of_integer, 8_f_long)
+      header(BIN_H_OFF_METADATA) = header(BIN_H_OFF_LINES) + int(nfvctr+1,kind=f_long)*8_f_long
+      ! metadata: cell_dim, shift, rxyz, nzatom, nelpsp, iatype, on_which_atom, geocode, units, atomnames
+      header(BIN_H_OFF_VALUES) = header(BIN_H_OFF_METADATA)
+      if (present(smmd)) then
+          header(BIN_H_OFF_VALUES) = header(BIN_H_OFF_VALUES) + (6+3*nat)*size_of_double + &
+               (2*ntypes+nat+int(nfvctr,kind=f_long))*size_of_integer + 21 + 20*ntypes
+      end if
+      header(BIN_H_OFF_VALUES) = aligned_offset(header(BIN_H_OFF_VALUES), BIN_ALIGNMENT)
+
+      call mpi_file_open(comm, trim(filename), & 
+           mpi_mode_wronly + mpi_mode_create, & 
+           mpi_info_null, thefile, ierr) 
+      if (ierr/=0) then
+          call f_err_throw("Could not open the file '"//trim(filename)//"'", &
+               err_name='SPARSEMATRIX_IO_ERROR')
+      end if
+      ! Discard the content of a previous (possibly larger) file
+      disp = int(0,kind=mpi_offset_kind)
+      call mpi_file_set_size(thefile, disp, ierr)
+
+      if (iproc==0) then
+          ! Header
+          disp = int(0,kind=mpi_offset_kind)
+          call mpi_file_write_at(thefile, disp, BIN_TAG, len(BIN_TAG), mpi_character, mpi_status_ignore, ierr)
+          disp = int(len(BIN_TAG),kind=mpi_offset_kind)
+          call mpi_file_write_at(thefile, disp, header, BIN_NHEADER, mpi_integer8, mpi_status_ignore, ierr)
+
+          ! Keys
+          workarr_keys = f_malloc((/5,nseg/),id='workarr_keys')
+          do iseg=1,nseg
+              workarr_keys(1,iseg) = keyv(iseg)
+              workarr_keys(2,iseg) = keyg(1,1,iseg)
+              workarr_keys(3,iseg) = keyg(2,1,iseg)
+              workarr_keys(4,iseg) = keyg(1,2,iseg)
+              workarr_keys(5,iseg) = keyg(2,2,iseg)
+          end do
+          disp = int(header(BIN_H_OFF_KEYS),kind=mpi_offset_kind)
+          call mpi_file_write_at(thefile, disp, workarr_keys, 5*nseg, mpi_integer, mpi_status_ignore, ierr)
+          call f_free(workarr_keys)
+
+          ! Line pointers; the segments are ordered by lines
+          line_ptr = f_malloc0(nfvctr+1,id='line_ptr')
+          do iseg=1,nseg
+              iline = keyg(1,2,iseg)
+              line_ptr(iline+1) = line_ptr(iline+1) + int(keyg(2,1,iseg)-keyg(1,1,iseg)+1,kind=f_long)
+          end do
+          do iline=1,nfvctr
+              line_ptr(iline+1) = line_ptr(iline+1) + line_ptr(iline)
+          end do
+          disp = int(header(BIN_H_OFF_LINES),kind=mpi_offset_kind)
+          call mpi_file_write_at(thefile, disp, line_ptr, nfvctr+1, mpi_integer8, mpi_status_ignore, ierr)
+          call f_free(line_ptr)
+
+          ! Metadata, in the order given above
+          if (present(smmd)) then
+              disp = int(header(BIN_H_OFF_METADATA),kind=mpi_offset_kind)
+              call mpi_file_write_at(thefile, disp, smmd%cell_dim, 3, mpi_double_precision, mpi_status_ignore, ierr)
+              disp = disp + 3*size_of_double
+              call mpi_file_write_at(thefile, disp, smmd%shift, 3, mpi_double_precision, mpi_status_ignore, ierr)
+              disp = disp + 3*size_of_double
+              call mpi_file_write_at(thefile, disp, smmd%rxyz, 3*smmd%nat, mpi_double_precision, mpi_status_ignore, ierr)
+              disp = disp + 3*nat*size_of_double
+              call mpi_file_write_at(thefile, disp, smmd%nzatom, smmd%ntypes, mpi_integer, mpi_status_ignore, ierr)
+              disp = disp + ntypes*size_of_integer
+              call mpi_file_write_at(thefile, disp, smmd%nelpsp, smmd%ntypes, mpi_integer, mpi_status_ignore, ierr)
+              disp = disp + ntypes*size_of_integer
+              call mpi_file_write_at(thefile, disp, smmd%iatype, smmd%nat, mpi_integer, mpi_status_ignore, ierr)
+              disp = disp + nat*size_of_integer
+              call mpi_file_write_at(thefile, disp, smmd%on_which_atom, nfvctr, mpi_integer, mpi_status_ignore, ierr)
+              disp = disp + int(nfvctr,kind=f_long)*size_of_integer
+              call mpi_file_write_at(thefile, disp, smmd%geocode, 1, mpi_character, mpi_status_ignore, ierr)
+              disp = disp + 1
+              call mpi_file_write_at(thefile, disp, smmd%units, 20, mpi_character, mpi_status_ignore, ierr)
+              disp = disp + 20
+              do itype=1,smmd%ntypes
+                  call mpi_file_write_at(thefile, disp, smmd%atomnames(itype), 20, &
+                       mpi_character, mpi_status_ignore, ierr)
+                  disp = disp + 20
+              end do
+          end if
+      end if
+
+      ! Values: each task writes the part it is responsible for, taken from its taskgroup
+      if (present(mat_tg)) then
+          ist = min(isvctr-isvctrp_tg+1,nvctrp_tg)
+          do ispin=1,nspin
+              disp = int(header(BIN_H_OFF_VALUES) + &
+                     (int(ispin-1,kind=f_long)*int(nvctr,kind=f_long)+int(isvctr,kind=f_long))*size_of_double, &
+                     kind=mpi_offset_kind)
+              call mpi_file_write_at_all(thefile, disp, mat_tg(ist,ispin), nvctrp, &
+                   mpi_double_precision, mpi_status_ignore, ierr)
+          end do
+      end if
+
+      call mpi_file_close(thefile, ierr)      
+
+      call f_release_routine()
+
+      contains
+
+        !> Round the byte offset up to the next multiple of align
+        pure function aligned_offset(offset, align) result(aligned)
+          implicit none
+          integer(kind=f_long),intent(in) :: offset, align
+          integer(kind=f_long) :: aligned
+          aligned = ((offset+align-1)/align)*align
+        end function aligned_offset
+
+    end subroutine write_sparse_matrix_binary
+
+
 
 
     subroutine write_sparse_matrix_metadata(iproc, nfvctr, nat, ntypes, units, geocode, cell_dim, shift, iatype, &
@@ -46,6 +46,7 @@ module sparsematrix_memory
   public :: allocate_sparse_matrix_keys
   public :: allocate_sparse_matrix_basic
   public :: allocate_sparse_matrix_matrix_multiplication
+  public :: deallocate_sparse_matrix_bsr
   public :: sparsematrix_malloc_ptr
   public :: sparsematrix_malloc
   public :: sparsematrix_malloc0_ptr
@@ -125,6 +126,7 @@ module sparsematrix_memory
       nullify(sparsemat%tgranks)
       nullify(sparsemat%nranks)
       nullify(sparsemat%luccomm)
+      nullify(sparsemat%luscomm)
       nullify(sparsemat%transposed_lookup_local)
       !nullify(sparsemat%on_which_atom)
       call nullify_sparse_matrix_matrix_multiplication(sparsemat%smmm) 
@@ -148,11 +150,28 @@ module sparsematrix_memory
       nullify(smmm%nvctr_mm_par)
       nullify(smmm%isvctr_mm_par)
       nullify(smmm%luccomm_smmm)
+      nullify(smmm%luscomm_smmm)
       nullify(smmm%keyv)
       nullify(smmm%keyg)
       nullify(smmm%consecutive_lookup)
+      call nullify_sparse_matrix_bsr(smmm%bsr)
     end subroutine nullify_sparse_matrix_matrix_multiplication
 
+    pure subroutine nullify_sparse_matrix_bsr(bsr)
+      implicit none
+      type(sparse_matrix_bsr),intent(out):: bsr
+      bsr%active = .false.
+      bsr%nblock = 0
+      bsr%nablock = 0
+      bsr%nmblock = 0
+      bsr%nabsr = 0
+      nullify(bsr%isblock)
+      nullify(bsr%ablock)
+      nullify(bsr%mblock)
+      nullify(bsr%istlookup)
+      nullify(bsr%lookup)
+    end subroutine nullify_sparse_matrix_bsr
+
 !!$
     subroutine allocate_sparse_matrix_basic(store_index, norb, nproc, sparsemat)
       use dynamic_memory
@@ -295,6 +314,7 @@ module sparsematrix_memory
       call f_free_ptr(sparseMat%tgranks)
       call f_free_ptr(sparseMat%nranks)
       call f_free_ptr(sparseMat%luccomm)
+      call f_free_ptr(sparseMat%luscomm)
       call f_free_ptr(sparseMat%transposed_lookup_local)
       !call f_free_ptr(sparseMat%on_which_atom)
     end subroutine deallocate_sparse_matrix
@@ -385,6 +405,8 @@ module sparsematrix_memory
       smat_out%iseseg_tg(1:2) = smat_in%iseseg_tg(1:2)
       smat_out%istartend_local(1:2) = smat_in%istartend_local(1:2)
       smat_out%istartendseg_local(1:2) = smat_in%istartendseg_local(1:2)
+      smat_out%nccomm = smat_in%nccomm
+      smat_out%nscomm = smat_in%nscomm
 
       smat_out%keyv=f_malloc_ptr(src_ptr=smat_in%keyv, id='smat_out%')
       smat_out%nsegline=f_malloc_ptr(src_ptr=smat_in%nsegline, id='smat_out%nsegline')
@@ -404,6 +426,7 @@ module sparsematrix_memory
       smat_out%tgranks=f_malloc_ptr(src_ptr=smat_in%tgranks, id='smat_out%tgranks')
       smat_out%nranks=f_malloc_ptr(src_ptr=smat_in%nranks, id='smat_out%nranks')
       smat_out%luccomm=f_malloc_ptr(src_ptr=smat_in%luccomm, id='smat_out%luccomm')
+      smat_out%luscomm=f_malloc_ptr(src_ptr=smat_in%luscomm, id='smat_out%luscomm')
       smat_out%transposed_lookup_local=f_malloc_ptr(src_ptr=smat_in%transposed_lookup_local, &
            id='smat_out%transposed_lookup_local')
       !smat_out%on_which_atom=f_malloc_ptr(src_ptr=smat_in%on_which_atom, id='smat_out%on_which_atom')
@@ -445,6 +468,7 @@ module sparsematrix_memory
       smmm_out%isseg = smmm_in%isseg
       smmm_out%ieseg = smmm_in%ieseg
       smmm_out%nccomm_smmm = smmm_in%nccomm_smmm
+      smmm_out%nscomm_smmm = smmm_in%nscomm_smmm
       smmm_out%nvctrp = smmm_in%nvctrp
       smmm_out%isvctr = smmm_in%isvctr
       smmm_out%nconsecutive_max = smmm_in%nconsecutive_max
@@ -481,6 +505,7 @@ module sparsematrix_memory
       smmm_out%line_and_column=f_malloc_ptr(src_ptr=smmm_in%line_and_column, id='smmm_out%line_and_column')
       !!converted  call allocate_and_copy(smmm_in%luccomm_smmm, smmm_out%luccomm_smmm, id='smmm_out%luccomm_smmm')
       smmm_out%luccomm_smmm=f_malloc_ptr(src_ptr=smmm_in%luccomm_smmm, id='smmm_out%luccomm_smmm')
+      smmm_out%luscomm_smmm=f_malloc_ptr(src_ptr=smmm_in%luscomm_smmm, id='smmm_out%luscomm_smmm')
       !!converted  call allocate_and_copy(smmm_in%isvctr_par, smmm_out%isvctr_par, id='smmm_out%isvctr_par')
       smmm_out%isvctr_par=f_malloc_ptr(src_ptr=smmm_in%isvctr_par, id='smmm_out%isvctr_par')
       !!converted  call allocate_and_copy(smmm_in%nvctr_par, smmm_out%nvctr_par, id='smmm_out%nvctr_par')
@@ -488,6 +513,16 @@ module sparsematrix_memory
       !!converted  call allocate_and_copy(smmm_in%consecutive_lookup, smmm_out%consecutive_lookup, id='smmm_out%consecutive_lookup')
       smmm_out%consecutive_lookup=f_malloc_ptr(src_ptr=smmm_in%consecutive_lookup, id='smmm_out%consecutive_lookup')
       !!call allocate_and_copy(smmm_in%keyg, smmm_out%keyg, id='smmm_out%keyg')
+      smmm_out%bsr%active = smmm_in%bsr%active
+      smmm_out%bsr%nblock = smmm_in%bsr%nblock
+      smmm_out%bsr%nablock = smmm_in%bsr%nablock
+      smmm_out%bsr%nmblock = smmm_in%bsr%nmblock
+      smmm_out%bsr%nabsr = smmm_in%bsr%nabsr
+      smmm_out%bsr%isblock=f_malloc_ptr(src_ptr=smmm_in%bsr%isblock, id='smmm_out%bsr%isblock')
+      smmm_out%bsr%ablock=f_malloc_ptr(src_ptr=smmm_in%bsr%ablock, id='smmm_out%bsr%ablock')
+      smmm_out%bsr%mblock=f_malloc_ptr(src_ptr=smmm_in%bsr%mblock, id='smmm_out%bsr%mblock')
+      smmm_out%bsr%istlookup=f_malloc_ptr(src_ptr=smmm_in%bsr%istlookup, id='smmm_out%bsr%istlookup')
+      smmm_out%bsr%lookup=f_malloc_ptr(src_ptr=smmm_in%bsr%lookup, id='smmm_out%bsr%lookup')
     end subroutine copy_sparse_matrix_matrix_multiplication
 
     subroutine copy_matrices(mat_in, mat_out)
@@ -549,11 +584,25 @@ module sparsematrix_memory
       call f_free_ptr(smmm%nvctr_mm_par)
       call f_free_ptr(smmm%isvctr_mm_par)
       call f_free_ptr(smmm%luccomm_smmm)
+      call f_free_ptr(smmm%luscomm_smmm)
       call f_free_ptr(smmm%keyv)
       call f_free_ptr(smmm%keyg)
       call f_free_ptr(smmm%consecutive_lookup)
+      call deallocate_sparse_matrix_bsr(smmm%bsr)
     end subroutine deallocate_sparse_matrix_matrix_multiplication
 
+    subroutine deallocate_sparse_matrix_bsr(bsr)
+      use dynamic_memory
+      implicit none
+      type(sparse_matrix_bsr),intent(inout):: bsr
+      call f_free_ptr(bsr%isblock)
+      call f_free_ptr(bsr%ablock)
+      call f_free_ptr(bsr%mblock)
+      call f_free_ptr(bsr%istlookup)
+      call f_free_ptr(bsr%lookup)
+      call nullify_sparse_matrix_bsr(bsr)
+    end subroutine deallocate_sparse_matrix_bsr
+
     subroutine allocate_smat_d1_ptr(smat_ptr,smat_info_ptr)
       use dictionaries, only: f_err_throw
       use dynamic_memory
@@ -36,6 +36,29 @@ module sparsematrix_types
       real(kind=mp) :: power !< power of the matrix; eg.: 0 => original matrix, -1 => inverse, 0.5 => ^1/2, etc.
   end type matrices
 
+  !> Atom-block (block sparse row) layout of the sparse matrix matrix multiplication.
+  !! The basis functions are grouped into blocks of consecutive functions with identical sparsity
+  !! pattern (typically the support functions of one atom), such that all matrices are made of
+  !! dense blocks and the multiplication can be done with small dense products.
+  type,public :: sparse_matrix_bsr
+      logical :: active !< indicates whether the block sparse matmul is used
+      integer :: nblock !< number of blocks of basis functions
+      integer,dimension(:),pointer :: isblock !< first basis function of each block (dimension nblock+1)
+      integer :: nabsr !< size of the block storage of the first factor
+      integer :: nablock !< number of block rows of the first factor which are needed
+      !> needed parts of the block rows of the first factor: (1) number of rows, (2) number of lines, (3) offset in the block storage,
+      !! (4) index of the first element in the compressed storage, (5) size of a line in the compressed storage
+      integer,dimension(:,:),pointer :: ablock
+      integer :: nmblock !< number of blocks of the result
+      !> blocks of the result: (1) number of rows, (2) number of columns, (3) leading dimension of the first factor,
+      !! (4) index of the first element in the local compressed storage, (5) leading dimension of the second factor and of the result
+      integer,dimension(:,:),pointer :: mblock
+      integer,dimension(:),pointer :: istlookup !< first run of products contributing to each block of the result
+      !> runs of consecutive products: (1) first element of the first factor in the block storage,
+      !! (2) first element of the second factor in the local compressed storage, (3) length of the run
+      integer,dimension(:,:),pointer :: lookup
+  end type sparse_matrix_bsr
+
   !> Contains the parameters needed for the sparse matrix matrix multiplication
   type,public :: sparse_matrix_matrix_multiplication
       integer,dimension(:),pointer :: keyv
@@ -59,11 +82,14 @@ module sparsematrix_types
       !!integer :: ncl_smmm !< number of elements for the compress local after a sparse matrix matrix multiplication
       integer :: nccomm_smmm !<number of communications required for the compress distributed after a sparse matrix matrix multiplication
       integer,dimension(:,:),pointer :: luccomm_smmm !<lookup array for the communications required for the compress distributed after a sparse matrix matrix multiplication
+      integer :: nscomm_smmm !<number of sends required for the compress distributed after a sparse matrix matrix multiplication
+      integer,dimension(:,:),pointer :: luscomm_smmm !<lookup array for these sends: (1) receiving task, (2) starting address on the sending task, (3) number of elements
       integer :: nvctrp !< number of compressed matrix elements per MPI task
       integer :: isvctr !< starting entry of the compressed matrix elements
       integer,dimension(:),pointer :: isvctr_par, nvctr_par !<array that contains the values of nvctrp and isvctr of all MPI tasks
       integer :: nconsecutive_max !< max number of blocks (i.e. consecutive entries) for the sparse matmul
       integer,dimension(:,:),pointer :: consecutive_lookup !< lookup arrays for these blocks
+      type(sparse_matrix_bsr) :: bsr !< atom-block layout for the block sparse matmul
   end type sparse_matrix_matrix_multiplication
 
   type,public :: sparse_matrix
@@ -100,6 +126,8 @@ module sparsematrix_types
       integer,dimension(:),pointer :: nranks !< number of task on each taskgroup
       integer :: nccomm !<number of communications required for the compress distributed in the dense parallel format
       integer,dimension(:,:),pointer :: luccomm !<lookup array for the communications required for the compress distributed in the dense parallel format
+      integer :: nscomm !<number of sends required for the compress distributed in the dense parallel format
+      integer,dimension(:,:),pointer :: luscomm !<lookup array for these sends: (1) receiving task, (2) starting address on the sending task, (3) number of elements
       logical :: smatmul_initialized !< indicated whether the sparse matmul type has been initialized
       integer,dimension(:),pointer :: transposed_lookup_local !< lookup arrays for the transposed entries of the sparse matrix which is actually used by a given MPI task
   end type sparse_matrix
@@ -77,6 +77,7 @@ module chebyshev
       type(fmpi_win) :: window
       integer :: global_stop
       integer,dimension(:),allocatable :: global_stop_remote
+      logical :: stop_local
     
       !call timing(iproc, 'chebyshev_comp', 'ON')
       call f_timing(TCAT_CME_POLYNOMIALS,'ON')
@@ -92,26 +93,12 @@ module chebyshev
       if (resume) then
           if (kernel%smmm%nvctrp>0) then
               do ipl=npl_resume,npl
-                  !!write(*,*) 'ipl', ipl
                   call sparsemm_new(iproc, kernel, mat_seq, vectors_new(1,1), vectors_new(1,2))
-                  !!write(*,*) 'after sparsemm_new'
-                  call axbyz_kernel_vectors_new(kernel, 2.d0, vectors_new(1,2), -1.d0, vectors_new(1,4), vectors_new(1,3))
-                  !!write(*,*) 'after axbyz_kernel_vectors_new'
+                  call chebyshev_recursion_step(kernel%smmm%nvctrp, ncalc, cc(ipl,1,1:ncalc), cc(ipl,2,1), &
+                       vectors_new(1,1), vectors_new(1,2), vectors_new(1,4), fermi_new, penalty_ev_new, stop_local)
                   call compress_polynomial_vector_new(iproc, nproc, nsize_polynomial, &
                        kernel%nfvctr, kernel%smmm%nfvctrp, kernel, &
-                       vectors_new(1,3), chebyshev_polynomials(1,ipl))
-                  !!write(*,*) 'after compress_polynomial_vector_new'
-                  do icalc=1,ncalc
-                      !write(*,*) 'ipl, sum(vectors_new(:,3))', ipl, sum(vectors_new(:,3))
-                      call axpy(kernel%smmm%nvctrp, cc(ipl,1,icalc), vectors_new(1,3), 1, fermi_new(1,icalc), 1)
-                      !write(*,*) 'after axpy'
-                  end do
-                  call axpy(kernel%smmm%nvctrp, cc(ipl,2,1), vectors_new(1,3), 1, penalty_ev_new(1), 1)
-                  !!write(*,*) 'after axpy'
-                  call vcopy(kernel%smmm%nvctrp, vectors_new(1,1), 1, vectors_new(1,4), 1)
-                  !!write(*,*) 'after vcopy'
-                  call vcopy(kernel%smmm%nvctrp, vectors_new(1,3), 1, vectors_new(1,1), 1)
-                  !!write(*,*) 'after vcopy'
+                       vectors_new(1,1), chebyshev_polynomials(1,ipl))
               end do
           end if
           call f_release_routine()
@@ -221,79 +208,17 @@ module chebyshev
               !!write(*,*) 'AFTER TEST'
               main_loop: do ipl=3,npl
                   call sparsemm_new(iproc, kernel, mat_seq, vectors_new(1,1), vectors_new(1,2))
-                  call axbyz_kernel_vectors_new(kernel, 2.d0, vectors_new(1,2), -1.d0, vectors_new(1,4), vectors_new(1,3))
+                  ! Recursion and accumulation of all expansions in one sweep. Check the norm of the
+                  ! columns of the Chebyshev polynomials and set a flag if it explodes, which might
+                  ! be a consequence of the eigenvalue bounds being to small.
+                  call chebyshev_recursion_step(kernel%smmm%nvctrp, ncalc, cc(ipl,1,1:ncalc), cc(ipl,2,1), &
+                       vectors_new(1,1), vectors_new(1,2), vectors_new(1,4), fermi_new, penalty_ev_new, emergency_stop(1))
                   call compress_polynomial_vector_new(iproc, nproc, nsize_polynomial, &
                        kernel%nfvctr, kernel%smmm%nfvctrp, kernel, &
-                       vectors_new(1,3), chebyshev_polynomials(1,ipl))
-                  do icalc=1,ncalc
-                      !write(*,*) 'ipl, sum(vectors_new(:,3))', ipl, sum(vectors_new(:,3))
-                      call axpy(kernel%smmm%nvctrp, cc(ipl,1,icalc), vectors_new(1,3), 1, fermi_new(1,icalc), 1)
-                  end do
-                  call axpy(kernel%smmm%nvctrp, cc(ipl,2,1), vectors_new(1,3), 1, penalty_ev_new(1), 1)
-                  !write(*,*) 'ipl, cc(ipl,2,1), sum(penalty_ev_new)', ipl, cc(ipl,2,1), sum(penalty_ev_new)
-                  !call axpy(kernel%smmm%nvctrp, cc(ipl,3,1), vectors_new(1,3), 1, penalty_ev_new(1,2), 1)
-
-                  !write(*,*) 'in loop: sum(penalty_ev_new)', &
-                  !    ipl, sum(penalty_ev_new(:,1)), sum(penalty_ev_new(:,2)), &
-                  !    sum(vectors_new(:,3)), sum(fermi_new(:,1)), cc(ipl,2,1)
-             
-                  !if (mod(ipl,2)==1) then
-                  !    tt=cc(ipl,3,1)
-                  !else
-                  !    tt=-cc(ipl,3,1)
-                  !end if
-                  !call axpy(kernel%smmm%nvctrp, tt, vectors_new(1,3), 1, penalty_ev_new(1,2), 1)
-             
-                  call vcopy(kernel%smmm%nvctrp, vectors_new(1,1), 1, vectors_new(1,4), 1)
-                  call vcopy(kernel%smmm%nvctrp, vectors_new(1,3), 1, vectors_new(1,1), 1)
-    
-                  ! Check the norm of the columns of the kernel and set a flag if it explodes, which might
-                  ! be a consequence of the eigenvalue bounds being to small. Only
-                  ! check the first matrix to be calculated.
-                  !! New: Do this check on the penalty matrix
-                  !!emergency_stop(1) = check_emergency_stop(kernel%smmm%nvctrp, ncalc, penalty_ev_new(1,1))
-                  !!emergency_stop(2) = check_emergency_stop(kernel%smmm%nvctrp, ncalc, penalty_ev_new(1,2))
-                  ! New: Do this check on the Chebyshev polynomials
-                  emergency_stop(1) = check_emergency_stop(kernel%smmm%nvctrp, ncalc, vectors_new(1,3))
+                       vectors_new(1,1), chebyshev_polynomials(1,ipl))
                   if (any(emergency_stop)) then
-                      !!global_stop = 1 !.true.
-                      !!do jproc=0,nproc-1
-                      !!    !write(*,*)'BEFORE: iproc, jproc', iproc, jproc
-                      !!    !!call mpi_put(global_stop, int(1,fmpi_integer), mpi_logical, &
-                      !!    !!     int(jproc,fmpi_integer), int(jproc,fmpi_address), &
-                      !!    !!     int(1,fmpi_integer), mpi_logical, window, ierr)
-                      !!    call mpi_put(global_stop, 1, mpi_logical, &
-                      !!         jproc, int(jproc,fmpi_address), &
-                      !!         1, mpi_logical, window, ierr)
-                      !!    !call mpi_get(global_stop, 1, mpi_logical, &
-                      !!    !     jproc, int(jproc,fmpi_address), &
-                      !!    !     1, mpi_logical, window, ierr)
-                      !!    !call fmpi_get(global_stop, jproc, window, 1, int(jproc,fmpi_address))
-                      !!    !call fmpi_get(global_stop, 0, window, 1, int(0,fmpi_address))
-                      !!    !write(*,*)'AFTER: iproc, jproc', iproc, jproc
-                      !!end do
-                      !!!write(*,*) 'SEND STOP, iproc, ipl', iproc, ipl
-                      !!call mpi_win_fence(MPI_MODE_NOSTORE, window, ierr)
                       exit main_loop
                   end if
-                  !!do iorb=1,kernel%smmm%nfvctrp
-                  !!    !!tt=ddot(kernel%nfvctr, fermi(1,iorb,1), 1, fermi(1,iorb,1), 1)
-                  !!    tt=ddot(kernel%smmm%nvctrp, fermi_new(1,1), 1, fermi_new(1,1), 1)
-                  !!    if (abs(tt)>1000.d0*kernel%smmm%nvctrp) then
-                  !!        emergency_stop=.true.
-                  !!        exit main_loop
-                  !!    end if
-                  !!end do
-                  ! SM: To be checked
-                  !call fmpi_win_fence(window, FMPI_WIN_CLOSE)
-                  !write(*,*) 'CHECK BEFORE, iproc, ipl', iproc, ipl
-                  !!call mpi_win_fence(MPI_MODE_NOSTORE, window, ierr)
-                  !write(*,*) 'CHECK AFTER, iproc, ipl', iproc, ipl
-                  !if (any(global_stop_remote)) then
-                  !!if (sum(global_stop_remote)>0) then
-                  !!    !write(*,*) 'STOP REMOTE'
-                  !!    exit main_loop
-                  !!end if
               end do main_loop
               !write(*,*) 'emergency_stop',emergency_stop
               !write(*,*) 'sum(penalty_ev_new)', sum(penalty_ev_new(:,1)), sum(penalty_ev_new(:,2))
@@ -323,37 +248,49 @@ module chebyshev
 
     
 
-    ! Performs z = a*x + b*y
-    subroutine axbyz_kernel_vectors_new(smat, a, x_compr, b, y_compr, z_compr)
+    !> One step of the Chebyshev recursion, fused with the accumulation of the expansions:
+    !! t = 2*hx - xold, xold = x, x = t, fermi(:,icalc) += cf(icalc)*t, penalty += cp*t.
+    !! ces is set if an element of t exceeds the emergency threshold.
+    subroutine chebyshev_recursion_step(nvctrp, ncalc, cf, cp, x, hx, xold, fermi, penalty, ces)
       implicit none
     
       ! Calling arguments
-      type(sparse_matrix),intent(in) :: smat
-      real(8),intent(in) :: a, b
-      real(kind=mp),dimension(smat%smmm%nvctrp),intent(in) :: x_compr, y_compr
-      real(kind=mp),dimension(smat%smmm%nvctrp),intent(out) :: z_compr
+      integer,intent(in) :: nvctrp, ncalc
+      real(kind=mp),dimension(ncalc),intent(in) :: cf
+      real(kind=mp),intent(in) :: cp
+      real(kind=mp),dimension(nvctrp),intent(inout) :: x, xold
+      real(kind=mp),dimension(nvctrp),intent(in) :: hx
+      real(kind=mp),dimension(nvctrp,ncalc),intent(inout) :: fermi
+      real(kind=mp),dimension(nvctrp),intent(inout) :: penalty
+      logical,intent(out) :: ces
     
       ! Local variables
-      integer :: i
+      integer :: i, icalc
+      real(kind=mp) :: tt
 
-      call f_routine(id='axbyz_kernel_vectors_new')
+      call f_routine(id='chebyshev_recursion_step')
 
-      if (.not.smat%smatmul_initialized) then
-          call f_err_throw('sparse matrix multiplication not initialized', &
-               err_name='SPARSEMATRIX_RUNTIME_ERROR')
-      end if
-    
-      !$omp parallel default(shared) private(i)
-      !$omp do schedule(static)
-      do i=1,smat%smmm%nvctrp
-          z_compr(i) = a*x_compr(i)+b*y_compr(i)
+      ces = .false.
+      !$omp parallel default(none) &
+      !$omp shared(nvctrp, ncalc, cf, cp, x, hx, xold, fermi, penalty, ces) &
+      !$omp private(i, icalc, tt)
+      !$omp do schedule(static) reduction(.or.:ces)
+      do i=1,nvctrp
+          tt = 2.0_mp*hx(i) - xold(i)
+          xold(i) = x(i)
+          x(i) = tt
+          do icalc=1,ncalc
+              fermi(i,icalc) = fermi(i,icalc) + cf(icalc)*tt
+          end do
+          penalty(i) = penalty(i) + cp*tt
+          ces = ces .or. abs(tt)>1.e8_mp
       end do
       !$omp end do
       !$omp end parallel
 
       call f_release_routine()
     
-    end subroutine axbyz_kernel_vectors_new
+    end subroutine chebyshev_recursion_step
     
     
     
@@ -373,24 +310,25 @@ module chebyshev
     
       ! Local variables
       integer :: ipl, icalc
+      real(kind=mp),dimension(:,:),allocatable :: ccx
     
       call f_routine(id='chebyshev_fast')
       !call timing(iproc, 'chebyshev_comp', 'ON')    
       call f_timing(TCAT_CME_POLYNOMIALS,'ON')
     
       if (nsize_polynomial>0) then
-          call f_zero(kernel_compressed)
-   
+          ! All expansions at once: kernel_compressed = chebyshev_polynomials*cc, with the first
+          ! coefficient halved
+          ccx = f_malloc((/npl,ncalc/),id='ccx')
           do icalc=1,ncalc
-              !write(*,*) 'icalc, ipl, kernel_compressed(1,icalc)', icalc, 0, kernel_compressed(1,icalc)
-              call axpy(nsize_polynomial, 0.5d0*cc(1,icalc), chebyshev_polynomials(1,1), 1, kernel_compressed(1,icalc), 1)
-              !write(*,*) 'icalc, ipl, kernel_compressed(1,icalc)', icalc, 1, kernel_compressed(1,icalc), cc(1,icalc)
+              ccx(1,icalc) = 0.5d0*cc(1,icalc)
               do ipl=2,npl
-                  !write(*,*) 'icalc, ipl, kernel_compressed(1,icalc)', icalc, ipl, kernel_compressed(1,icalc), cc(ipl,icalc)
-                  call axpy(nsize_polynomial, cc(ipl,icalc), chebyshev_polynomials(1,ipl), 1, kernel_compressed(1,icalc), 1)
+                  ccx(ipl,icalc) = cc(ipl,icalc)
               end do
           end do
-    
+          call gemm('n', 'n', nsize_polynomial, ncalc, npl, 1.d0, chebyshev_polynomials(1,1), nsize_polynomial, &
+               ccx(1,1), npl, 0.d0, kernel_compressed(1,1), nsize_polynomial)
+          call f_free(ccx)
       end if
     
       !call timing(iproc, 'chebyshev_comp', 'OF')    
@@ -432,37 +370,4 @@ module chebyshev
     end subroutine compress_polynomial_vector_new
 
 
-    function check_emergency_stop(nvctrp, ncalc, column) result(ces)
-      implicit none
-
-      ! Calling arguments
-      integer,intent(in) :: nvctrp, ncalc
-      real(kind=mp),dimension(nvctrp),intent(in) :: column
-      logical :: ces
-
-      ! Local variables
-      integer :: i
-      !real(kind=mp) :: tt
-
-      call f_routine(id='check_emergency_stop')
-
-      ces = .false.
-      do i=1,nvctrp
-          !if (abs(column(i))>1.d4) then
-          if (abs(column(i))>1.d8) then
-              ces = .true.
-          end if
-          !!write(*,*) 'sum(column(:,icalc))',sum(column(:,icalc))
-          !!tt = dot(nvctrp, column(1,icalc), 1, column(1,icalc), 1)
-          !!write(*,*) 'tt',tt
-          !!if (abs(tt)>100000.d0*real(nvctrp,kind=mp)) then
-          !!    ces = .true.
-          !!end if
-      end do
-
-      call f_release_routine()
-
-    end function check_emergency_stop
-
-
 end module chebyshev
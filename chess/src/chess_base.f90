@@ -49,6 +49,7 @@ module chess_base
     real(mp) :: betax_foe, betax_ice
     logical :: adjust_fscale
     logical :: matmul_optimize_load_balancing
+    logical :: matmul_bsr
     real(mp) :: fscale_ediff_low
     real(mp) :: fscale_ediff_up
   end type foe_params
@@ -121,6 +122,7 @@ module chess_base
   character(len=*),parameter :: OCCUPATION_FUNCTION    = "occupation_function"
   character(len=*),parameter :: ADJUST_FSCALE          = "adjust_fscale"
   character(len=*),parameter :: MATMUL_OPTIMIZE_LOAD_BALANCING = "matmul_optimize_load_balancing"
+  character(len=*),parameter :: MATMUL_BSR             = "matmul_bsr"
   character(len=*),parameter :: FSCALE_EDIFF_LOW       = "fscale_ediff_low"
   character(len=*),parameter :: FSCALE_EDIFF_UP        = "fscale_ediff_up"
 
@@ -156,6 +158,7 @@ module chess_base
       fp%occupation_function = 0
       fp%adjust_fscale = .false.
       fp%matmul_optimize_load_balancing = .false.
+      fp%matmul_bsr = .true.
       fp%fscale_ediff_low = 0.0_mp
       fp%fscale_ediff_up = 0.0_mp
     end function foe_params_null
@@ -337,6 +340,8 @@ module chess_base
               cp%foe%adjust_fscale = val
           case(MATMUL_OPTIMIZE_LOAD_BALANCING)
               cp%foe%matmul_optimize_load_balancing = val
+          case(MATMUL_BSR)
+              cp%foe%matmul_bsr = val
           case(FSCALE_EDIFF_LOW)
               cp%foe%fscale_ediff_low = val
           case(FSCALE_EDIFF_UP)
@@ -50,7 +50,7 @@ module foe
                               trace_sparse_matrix_product, symmetrize_matrix, max_asymmetry_of_matrix, &
                               trace_sparse_matrix, transform_sparse_matrix
       use foe_base, only: foe_data, foe_data_set_int, foe_data_get_int, foe_data_set_real, foe_data_get_real, &
-                          foe_data_get_logical
+                          foe_data_get_logical, foe_data_set_logical
       use fermi_level, only: fermi_aux, init_fermi_level, determine_fermi_level, &
                              fermilevel_get_real, fermilevel_get_logical
       use chebyshev, only: chebyshev_clean, chebyshev_fast
@@ -103,7 +103,7 @@ module foe
       !logical,dimension(2) :: eval_bounds_ok
       real(kind=mp) :: temp_multiplicator, ebs_check, ebsp
       integer :: itemp, ispin, isshift, imshift, ilshift, ncount, istl
-      logical :: evbounds_shrinked, degree_sufficient, reached_limit
+      logical :: degree_sufficient, reached_limit
       real(kind=mp),parameter :: CHECK_RATIO=1.25d0
       real(kind=mp) :: ebsp_allspins, accuracy_function, accuracy_penalty
       real(kind=mp),dimension(1) :: max_error, x_max_error_check, max_error_check, mean_error_check
@@ -149,7 +149,12 @@ module foe
       npl_max = foe_data_get_int(foe_obj,"npl_max")
       npl_stride = foe_data_get_int(foe_obj,"npl_stride")
 
-      evbounds_shrinked=.false.
+      call foe_data_set_logical(foe_obj,"evbounds_shrinked",.false.)
+      call foe_data_set_int(foe_obj,"nsweeps",0)
+      call foe_data_set_int(foe_obj,"nspmm",0)
+      call foe_data_set_int(foe_obj,"ndegree_saved",0)
+      call foe_data_set_int(foe_obj,"nsweeps_saved",0)
+      call foe_data_set_int(foe_obj,"nspmm_saved",0)
 
 
       fermi_check_compr = sparsematrix_malloc(smatl, iaction=SPARSE_TASKGROUP, id='fermi_check_compr')
@@ -185,9 +190,13 @@ module foe
               call foe_data_set_real(foe_obj,"evlow",0.9d0*foe_data_get_real(foe_obj,"evlow",ispin),ispin)
               call foe_data_set_real(foe_obj,"evhigh",0.9d0*foe_data_get_real(foe_obj,"evhigh",ispin),ispin)
           end do
-          evbounds_shrinked=.true.
-      else
-          evbounds_shrinked=.false.
+          call foe_data_set_logical(foe_obj,"evbounds_shrinked",.true.)
+      else if (foe_data_get_int(foe_obj,"evbounds_isatur")>foe_data_get_int(foe_obj,"evbounds_nsatur")) then
+          ! The shrinking failed too often already; without the saturation this would cost
+          ! (at least) one additional sweep up to the penalty degree
+          call foe_data_set_int(foe_obj,"nsweeps_saved",foe_data_get_int(foe_obj,"nsweeps_saved")+1)
+          call foe_data_set_int(foe_obj,"nspmm_saved",foe_data_get_int(foe_obj,"nspmm_saved")+ &
+               smatl%nspin*foe_data_get_int(foe_obj,"npl_penalty_warmstart"))
       end if
 
       ntemp = foe_data_get_int(foe_obj,"ntemp")
@@ -279,7 +288,9 @@ module foe
                smatm, smatl, ham_, foe_obj, npl_min, ham_eff, & !kernel_%matrix_compr(ilshift+1:), &
                chebyshev_polynomials, npl, scale_factor, shift_value, hamscal_compr, &
                smats=smats, ovrlp_=ovrlp_, ovrlp_minus_one_half_=ovrlp_minus_one_half_(1), &
-               efarr=efarr, fscale_arr=fscale_arr, max_errorx=max_error)
+               efarr=efarr, fscale_arr=fscale_arr, max_errorx=max_error, warm_start=.true.)
+          ! Only the first sweep after a shrinking can reveal that it was too aggressive
+          call foe_data_set_logical(foe_obj,"evbounds_shrinked",.false.)
 
           !!if (iproc==0) then
           !!    call yaml_mapping_open('summary',flow=.true.)
@@ -628,6 +639,17 @@ module foe
           call yaml_sequence_close()
       end if
 
+      if (iproc==0 .and. foe_verbosity>=2) then
+          call yaml_mapping_open('FOE warm start',flow=.true.)
+          call yaml_map('npl guess',foe_data_get_int(foe_obj,"npl_warmstart"))
+          call yaml_map('sweeps',foe_data_get_int(foe_obj,"nsweeps"))
+          call yaml_map('SpMMs',foe_data_get_int(foe_obj,"nspmm"))
+          call yaml_map('degree tests saved',foe_data_get_int(foe_obj,"ndegree_saved"))
+          call yaml_map('sweeps saved',foe_data_get_int(foe_obj,"nsweeps_saved"))
+          call yaml_map('SpMMs saved',foe_data_get_int(foe_obj,"nspmm_saved"))
+          call yaml_mapping_close()
+      end if
+
       call foe_data_set_real(foe_obj,"fscale",fscale_new)
 
       degree_sufficient=.true.
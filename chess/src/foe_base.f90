@@ -51,6 +51,16 @@ module foe_base
     logical :: adjust_fscale !< dynamically adjust fscale or not
     real(kind=mp) :: fscale_ediff_low !< lower bound for the optimal relative energy difference between the kernel and the control kernel
     real(kind=mp) :: fscale_ediff_up  !< upper bound for the optimal relative energy difference between the kernel and the control kernel
+    ! Warm start, i.e. information kept from one call to the next one
+    integer :: npl_warmstart !< polynomial degree found in the previous call (0 if there is none)
+    integer :: npl_penalty_warmstart !< polynomial degree of the penalty function found in the previous call (0 if there is none)
+    logical :: evbounds_shrinked !< the eigenvalue bounds have been shrinked at the beginning of the current call
+    ! Statistics of the current call
+    integer :: nsweeps !< number of calculations of the Chebyshev polynomials
+    integer :: nspmm !< number of sparse matrix multiplications to calculate the Chebyshev polynomials
+    integer :: ndegree_saved !< number of polynomial degrees which did not have to be tested thanks to the warm start
+    integer :: nsweeps_saved !< number of restarts saved by not shrinking the eigenvalue bounds once more
+    integer :: nspmm_saved !< number of sparse matrix multiplications saved by not shrinking the eigenvalue bounds once more
   end type foe_data
 
 
@@ -100,6 +110,14 @@ module foe_base
       foe_obj%adjust_fscale          =f_none()
       foe_obj%fscale_ediff_low       =f_none()
       foe_obj%fscale_ediff_up        =f_none()
+      foe_obj%npl_warmstart          =f_none()
+      foe_obj%npl_penalty_warmstart  =f_none()
+      foe_obj%evbounds_shrinked      =f_none()
+      foe_obj%nsweeps                =f_none()
+      foe_obj%nspmm                  =f_none()
+      foe_obj%ndegree_saved          =f_none()
+      foe_obj%nsweeps_saved          =f_none()
+      foe_obj%nspmm_saved            =f_none()
     end subroutine nullify_foe_data
 
     pure function foe_data_null() result(foe_obj)
@@ -153,6 +171,14 @@ module foe_base
       foe_obj_out%adjust_fscale          = foe_obj_in%adjust_fscale
       foe_obj_out%fscale_ediff_low       = foe_obj_in%fscale_ediff_low
       foe_obj_out%fscale_ediff_up        = foe_obj_in%fscale_ediff_up
+      foe_obj_out%npl_warmstart          = foe_obj_in%npl_warmstart
+      foe_obj_out%npl_penalty_warmstart  = foe_obj_in%npl_penalty_warmstart
+      foe_obj_out%evbounds_shrinked      = foe_obj_in%evbounds_shrinked
+      foe_obj_out%nsweeps                = foe_obj_in%nsweeps
+      foe_obj_out%nspmm                  = foe_obj_in%nspmm
+      foe_obj_out%ndegree_saved          = foe_obj_in%ndegree_saved
+      foe_obj_out%nsweeps_saved          = foe_obj_in%nsweeps_saved
+      foe_obj_out%nspmm_saved            = foe_obj_in%nspmm_saved
     end subroutine copy_foe_data
 
 
@@ -194,6 +220,20 @@ module foe_base
           foe_obj%ntemp = val
       case ("occupation_function")
           foe_obj%occupation_function = val
+      case ("npl_warmstart")
+          foe_obj%npl_warmstart = val
+      case ("npl_penalty_warmstart")
+          foe_obj%npl_penalty_warmstart = val
+      case ("nsweeps")
+          foe_obj%nsweeps = val
+      case ("nspmm")
+          foe_obj%nspmm = val
+      case ("ndegree_saved")
+          foe_obj%ndegree_saved = val
+      case ("nsweeps_saved")
+          foe_obj%nsweeps_saved = val
+      case ("nspmm_saved")
+          foe_obj%nspmm_saved = val
       case default
           call f_err_throw("wrong argument for "//trim(fieldname))
       end select
@@ -227,6 +267,20 @@ module foe_base
           val = foe_obj%ntemp
       case ("occupation_function")
           val = foe_obj%occupation_function
+      case ("npl_warmstart")
+          val = foe_obj%npl_warmstart
+      case ("npl_penalty_warmstart")
+          val = foe_obj%npl_penalty_warmstart
+      case ("nsweeps")
+          val = foe_obj%nsweeps
+      case ("nspmm")
+          val = foe_obj%nspmm
+      case ("ndegree_saved")
+          val = foe_obj%ndegree_saved
+      case ("nsweeps_saved")
+          val = foe_obj%nsweeps_saved
+      case ("nspmm_saved")
+          val = foe_obj%nspmm_saved
       case default
           call f_err_throw("wrong argument for "//trim(fieldname))
       end select
@@ -405,6 +459,8 @@ module foe_base
       select case (fieldname)
       case ("adjust_fscale")
           foe_obj%adjust_fscale = val
+      case ("evbounds_shrinked")
+          foe_obj%evbounds_shrinked = val
       case default
           call f_err_throw("wrong argument for "//trim(fieldname))
       end select
@@ -419,6 +475,8 @@ module foe_base
       select case (fieldname)
       case ("adjust_fscale")
           val = foe_obj%adjust_fscale
+      case ("evbounds_shrinked")
+          val = foe_obj%evbounds_shrinked
       case default
           call f_err_throw("wrong argument for "//trim(fieldname))
       end select
@@ -1272,6 +1272,14 @@ module foe_common
       call foe_data_set_logical(foe_obj,"adjust_fscale",adjust_fscale_)
       call foe_data_set_real(foe_obj,"fscale_ediff_low",fscale_ediff_low_)
       call foe_data_set_real(foe_obj,"fscale_ediff_up",fscale_ediff_up_)
+      call foe_data_set_int(foe_obj,"npl_warmstart",0)
+      call foe_data_set_int(foe_obj,"npl_penalty_warmstart",0)
+      call foe_data_set_logical(foe_obj,"evbounds_shrinked",.false.)
+      call foe_data_set_int(foe_obj,"nsweeps",0)
+      call foe_data_set_int(foe_obj,"nspmm",0)
+      call foe_data_set_int(foe_obj,"ndegree_saved",0)
+      call foe_data_set_int(foe_obj,"nsweeps_saved",0)
+      call foe_data_set_int(foe_obj,"nspmm_saved",0)
 
       foe_obj%charge = f_malloc0_ptr(nspin,id='foe_obj%charge')
       foe_obj%evlow = f_malloc0_ptr(nspin,id='foe_obj%evlow')
@@ -1449,7 +1457,7 @@ module foe_common
                               transform_sparsity_pattern, sequential_acces_matrix_fast2, sparsemm_new, &
                               compress_matrix_distributed_wrapper
       use foe_base, only: foe_data, foe_data_set_int, foe_data_get_int, foe_data_set_real, foe_data_get_real, &
-                          foe_data_get_logical
+                          foe_data_get_logical, foe_data_set_logical
       use fermi_level, only: fermi_aux, init_fermi_level, determine_fermi_level, &
                              fermilevel_get_real, fermilevel_get_logical
       use chebyshev, only: chebyshev_clean, chebyshev_fast
@@ -1491,7 +1499,6 @@ module foe_common
       real(kind=mp),dimension(2) :: efarr
       !real(kind=mp) :: ebs_check, ef, ebsp
       integer :: isshift, imshift
-      logical :: evbounds_shrinked
       integer,parameter :: NTEMP_ACCURATE=4
       integer,parameter :: NTEMP_FAST=1
       !real(kind=mp) :: x_max_error, x_max_error_check
@@ -1543,8 +1550,6 @@ module foe_common
 
       imshift = (ispin-1)*smatm%nvctrp_tg
 
-      evbounds_shrinked=.false.
-
 
 
       penalty_ev_new = f_malloc((/smatl%smmm%nvctrp/),id='penalty_ev_new')
@@ -1712,10 +1717,11 @@ module foe_common
       !!write(*,*) 'restart',restart
 
       if (restart) then
-          if(evbounds_shrinked) then
+          if (foe_data_get_logical(foe_obj,"evbounds_shrinked")) then
               ! this shrink was not good, increase the saturation counter
               call foe_data_set_int(foe_obj,"evboundsshrink_isatur", &
                    foe_data_get_int(foe_obj,"evboundsshrink_isatur")+1)
+              call foe_data_set_logical(foe_obj,"evbounds_shrinked",.false.)
           end if
           call foe_data_set_int(foe_obj,"evbounds_isatur",0)
           if (iproc==0) then
@@ -1790,9 +1796,8 @@ module foe_common
       real(kind=mp),dimension(:,:,:),allocatable :: cc
       !real(kind=mp),dimension(:,:),allocatable :: fermip_check
       !real(kind=mp),dimension(:,:,:),allocatable :: penalty_ev
-      real(kind=mp) :: anoise, sumn, charge_diff
-      real(kind=mp) :: evlow_old, evhigh_old, sumn_old, ef_old, tt
-      real(kind=mp) :: x_max_error_fake, max_error_fake, mean_error_fake
+      real(kind=mp) :: sumn, charge_diff
+      real(kind=mp) :: evlow_old, evhigh_old, sumn_old, ef_old, tt, ef_start
       real(kind=mp) :: fscale, diff, fscale_new
       !logical :: calculate_SHS
       !logical,dimension(2) :: emergency_stop
@@ -1804,7 +1809,6 @@ module foe_common
       logical,dimension(2) :: eval_bounds_ok, bisection_bounds_ok
       real(kind=mp) :: temp_multiplicator, ef
       integer :: info
-      logical :: evbounds_shrinked
       !real(kind=mp),parameter :: FSCALE_LOWER_LIMIT=5.d-3
       !real(kind=mp),parameter :: FSCALE_UPPER_LIMIT=5.d-2
       real(kind=mp),parameter :: DEGREE_MULTIPLICATOR_ACCURATE=3.d0
@@ -1825,7 +1829,7 @@ module foe_common
       !real(kind=mp),dimension(2) :: temparr
       real(kind=mp),dimension(:),allocatable :: occupations
       !real(kind=mp),dimension(:,:),allocatable :: penalty_ev_new
-      real(kind=mp),dimension(:,:),allocatable :: fermi_small_new
+      real(kind=mp),dimension(:,:),allocatable :: fermi_small_new, traces
       integer :: jspin
       type(fmpi_win) ,dimension(:), allocatable :: windowsx
 
@@ -1845,8 +1849,6 @@ module foe_common
       call f_timing(TCAT_CME_AUXILIARY,'ON')
 
 
-      evbounds_shrinked=.false.
-
       windowsx = f_malloc(smatl%ntaskgroup,id='windowsx')
 
       fermi_small_new = f_malloc((/smatl%smmm%nvctrp_mm,smatl%nspin/),id='fermi_small_new')
@@ -1861,6 +1863,16 @@ module foe_common
       ! Size of one Chebyshev polynomial matrix in compressed form (distributed)
       nsize_polynomial = smatl%smmm%nvctrp_mm
 
+      ! The traces of the Chebyshev polynomials, such that the trace of the kernel for a given Fermi level
+      ! is simply a weighted sum of them and the kernel itself has only to be built once at the end
+      traces = f_malloc0((/npl,smatl%nspin/),id='traces')
+      do jspin=1,smatl%nspin
+          if (.not. calculate_spin_channels(jspin)) cycle
+          call calculate_polynomial_traces(iproc, nproc, comm, smatl, npl, &
+               chebyshev_polynomials(:,:,jspin), traces(:,jspin))
+      end do
+
+      cc = f_malloc((/npl,1,1/),id='cc')
 
 
       !ntemp = NTEMP_ACCURATE
@@ -1897,6 +1909,7 @@ module foe_common
                        "bisection_shift",max(foe_data_get_real(foe_obj,"bisection_shift",1),1.d-4), &
                        1)
 
+                  ef_start = foe_data_get_real(foe_obj,"ef")
                   efarr(1)=foe_data_get_real(foe_obj,"ef")-foe_data_get_real(foe_obj,"bisection_shift",1)
                   efarr(2)=foe_data_get_real(foe_obj,"ef")+foe_data_get_real(foe_obj,"bisection_shift",1)
                   !write(*,*) 'ef, efarr', foe_data_get_real(foe_obj,"ef",ispin), efarr
@@ -1954,8 +1967,6 @@ module foe_common
                       end if
 
 
-                      cc = f_malloc((/npl,1,3/),id='cc')
-
                       !call timing(iproc, 'FOE_auxiliary ', 'OF')
                       call f_timing(TCAT_CME_AUXILIARY,'OF')
                       !call timing(iproc, 'chebyshev_coef', 'ON')
@@ -1966,16 +1977,8 @@ module foe_common
                       call get_chebyshev_expansion_coefficients(iproc, nproc, comm, foe_data_get_real(foe_obj,"evlow",1), &
                            foe_data_get_real(foe_obj,"evhigh",1), npl, func, cc(1,1,1), &
                            x_max_error, max_error, mean_error)
-                      call func_set(FUNCTION_EXPONENTIAL, betax=foe_data_get_real(foe_obj,"betax"), &
-                           muax=foe_data_get_real(foe_obj,"evlow",1), mubx=foe_data_get_real(foe_obj,"evhigh",1))
-                      call get_chebyshev_expansion_coefficients(iproc, nproc, comm, foe_data_get_real(foe_obj,"evlow",1), &
-                           foe_data_get_real(foe_obj,"evhigh",1), npl, func, cc(1,1,2), &
-                           x_max_error_fake, max_error_fake, mean_error_fake)
-                      do ipl=1,npl
-                         cc(ipl,1,3) = -cc(ipl,1,2)
-                      end do
-                      call evnoise(npl, cc(1,1,2), foe_data_get_real(foe_obj,"evlow",1), &
-                           foe_data_get_real(foe_obj,"evhigh",1), anoise)
+                      ! The penalty function is not needed here, since the bounds have already
+                      ! been checked when the polynomials were calculated.
 
 
                       !if (iproc==0 .and. foe_verbosity>=1) then
@@ -1999,51 +2002,21 @@ module foe_common
                           do ipl=1,npl
                               !write(*,*) 'cc, ipl, cc(ipl,1,1)', ipl, cc(ipl,1,1)
                               cc(ipl,1,1)=2.d0*cc(ipl,1,1)
-                              cc(ipl,1,2)=2.d0*cc(ipl,1,2)
-                              cc(ipl,1,3)=2.d0*cc(ipl,1,3)
                           end do
                       end if
 
 
                       sumn = 0.0_mp
                       do jspin=1,smatl%nspin
-                      
                           if (.not. calculate_spin_channels(jspin)) cycle
-
-                          !call timing(iproc, 'FOE_auxiliary ', 'OF')
-                          call f_timing(TCAT_CME_AUXILIARY,'OF')
-
-                          !if (foe_verbosity>=1 .and. iproc==0) call yaml_map('polynomials','from memory')
-
-                          if (smatl%smmm%nvctrp_mm>0) then
-                              call chebyshev_fast(iproc, nproc, nsize_polynomial, npl, &
-                                   smatl%nfvctr, smatl%smmm%nfvctrp, &
-                                   smatl, chebyshev_polynomials(:,:,jspin), 1, cc, fermi_small_new(:,jspin))
-                          else
-                              call f_zero(fermi_small_new(:,jspin))
-                          end if
-
-                          ilshift=(jspin-1)*smatl%nvctrp_tg
-                          !!call compress_matrix_distributed_wrapper(iproc, nproc, smatl, SPARSE_MATMUL_SMALL, &
-                          !!     fermi_small_new(:,jspin), ONESIDED_POST, &
-                          !!     kernel_%matrix_compr(ilshift+1:), windowsx=windowsx)
-
-                          !call timing(iproc, 'FOE_auxiliary ', 'ON')
-                          call f_timing(TCAT_CME_AUXILIARY,'ON')
-
-
-
-
-                          call calculate_trace_distributed_new(iproc, nproc, comm, smatl, fermi_small_new(:,jspin), tt)
+                          tt = 0.5d0*cc(1,1,1)*traces(1,jspin)
+                          do ipl=2,npl
+                              tt = tt + cc(ipl,1,1)*traces(ipl,jspin)
+                          end do
                           occupations(jspin) = tt
-                          !write(*,*) 'jspin, trace', jspin, tt
                           sumn = sumn + tt
-                          !write(*,*) 'sumn',sumn
-
                       end do
 
-                      call f_free(cc)
-
 
                       if (all(eval_bounds_ok) .and. all(bisection_bounds_ok)) then
                           ! Print these informations already now if all entries are true.
@@ -2122,6 +2095,10 @@ module foe_common
 
                   end do main_loop
 
+                  ! Use the change of the Fermi level as bracket for the bisection in the next call
+                  call foe_data_set_real(foe_obj,"bisection_shift", &
+                       max(2.d0*abs(foe_data_get_real(foe_obj,"ef")-ef_start),1.d-4),1)
+
                   if (iproc==0) then
                       call yaml_newline()
                       call yaml_mapping_open('summary',flow=.true.)
@@ -2131,6 +2108,21 @@ module foe_common
                       call yaml_map('D Tr(K)',sumn-foe_data_get_real(foe_obj,"charge",ispin),fmt='(es9.2)')
                       call yaml_mapping_close()
                   end if
+
+         ! Build the kernel for the final Fermi level from the polynomials
+         call f_timing(TCAT_CME_AUXILIARY,'OF')
+         do jspin=1,smatl%nspin
+             if (.not. calculate_spin_channels(jspin)) cycle
+             if (smatl%smmm%nvctrp_mm>0) then
+                 call chebyshev_fast(iproc, nproc, nsize_polynomial, npl, &
+                      smatl%nfvctr, smatl%smmm%nfvctrp, &
+                      smatl, chebyshev_polynomials(:,:,jspin), 1, cc, fermi_small_new(:,jspin))
+             else
+                 call f_zero(fermi_small_new(:,jspin))
+             end if
+         end do
+         call f_timing(TCAT_CME_AUXILIARY,'ON')
+         call f_free(cc)
             
          do jspin=1,smatl%nspin
              ilshift=(jspin-1)*smatl%nvctrp_tg
@@ -2159,6 +2151,7 @@ module foe_common
 
       call f_free(occupations)
       call f_free(fermi_small_new)
+      call f_free(traces)
       call free_fmpi_win_arr(windowsx)
 
       !call timing(iproc, 'FOE_auxiliary ', 'OF')
@@ -2212,11 +2205,52 @@ module foe_common
     end subroutine calculate_trace_distributed_new
 
 
-    !> Determine the polynomial degree which yields the desired precision
+    !> Calculates the traces of the npl distributed Chebyshev polynomials, with a single reduction
+    subroutine calculate_polynomial_traces(iproc, nproc, comm, smatl, npl, polynomials, traces)
+      use dynamic_memory
+      implicit none
+      ! Calling arguments
+      integer,intent(in) :: iproc, nproc, comm, npl
+      type(sparse_matrix),intent(in) :: smatl
+      real(kind=mp),dimension(smatl%smmm%nvctrp_mm,npl),intent(in) :: polynomials
+      real(kind=mp),dimension(npl),intent(out) :: traces
+      integer :: i, ipl, iline, icolumn
+
+      call f_routine(id='calculate_polynomial_traces')
+
+      if (.not.smatl%smatmul_initialized) then
+          call f_err_throw('sparse matrix multiplication not initialized', &
+               err_name='SPARSEMATRIX_RUNTIME_ERROR')
+      end if
+
+      call f_zero(traces)
+      do i=1,smatl%smmm%nvctrp_mm
+          iline = smatl%smmm%line_and_column_mm(1,i)
+          icolumn = smatl%smmm%line_and_column_mm(2,i)
+          if (iline==icolumn) then
+              do ipl=1,npl
+                  traces(ipl) = traces(ipl) + polynomials(i,ipl)
+              end do
+          end if
+      end do
+
+      if (nproc > 1) then
+          call fmpi_allreduce(traces, FMPI_SUM, comm=comm)
+      end if
+
+      call f_release_routine()
+    end subroutine calculate_polynomial_traces
+
+
+    !> Determine the smallest polynomial degree (npl_min + k*npl_stride) for which both the function and the
+    !! penalty function are represented with the required accuracy.
+    !! If npl_guess and npl_penalty_guess are present (e.g. the degrees of a previous call), the search starts from
+    !! there and goes downwards or upwards, giving the same result as the search starting from npl_min.
+    !! ntested returns the number of sets of coefficients which have been calculated.
     subroutine get_polynomial_degree(iproc, nproc, comm, ispin, ncalc, fun, foe_obj, &
                npl_min, npl_max, npl_stride, accuracy_function, accuracy_penalty, verbosity, npl, npl_penalty, cc, &
                max_error, x_max_error, mean_error, anoise, increase_degree_for_penaltyfunction, &
-               ex, ef, fscale)
+               ex, ef, fscale, npl_guess, npl_penalty_guess, ntested)
       use foe_base, only: foe_data, foe_data_get_real
       use yaml_output
       use module_func
@@ -2234,12 +2268,15 @@ module foe_common
       real(kind=mp),intent(out) :: anoise
       logical,intent(out) :: increase_degree_for_penaltyfunction
       real(kind=mp),dimension(ncalc),intent(in),optional :: ex, ef, fscale
+      integer,intent(in),optional :: npl_guess, npl_penalty_guess
+      integer,intent(out),optional :: ntested
 
       ! Local variables
-      integer :: ipl, icalc, j, jpl
-      logical :: error_ok, found_degree, found_penalty_degree
+      integer :: ipl, icalc, j, jpl, npl_function, ntested_
+      logical :: error_ok, found_degree, found_penalty_degree, warm_start
       real(kind=mp),dimension(:,:,:),allocatable :: cc_trial
       real(kind=mp) :: x_max_error_penaltyfunction, max_error_penaltyfunction, mean_error_penaltyfunction
+      integer,parameter :: DEGREE_FUNCTION=1, DEGREE_PENALTY=2
 
       call f_routine(id='get_polynomial_degree')
 
@@ -2274,12 +2311,44 @@ module foe_common
 
       cc_trial = f_malloc0((/npl_max,ncalc,3/),id='cc_trial')
 
+      warm_start = .false.
+      if (present(npl_guess) .and. present(npl_penalty_guess)) then
+          warm_start = (npl_guess>0 .and. npl_penalty_guess>0)
+      end if
+      ntested_ = 0
+
       found_degree = .false.
       increase_degree_for_penaltyfunction = .false.
       found_penalty_degree = .false.
       npl_penalty = huge(1)
+      if (warm_start) then
+          if (foe_data_get_real(foe_obj,"evhigh",ispin)<=0.d0) then
+              stop 'ERROR: highest eigenvalue must be positive'
+          end if
+          npl_function = search_degree(DEGREE_FUNCTION, npl_guess)
+          npl_penalty = search_degree(DEGREE_PENALTY, npl_penalty_guess)
+          found_degree = (npl_function<=npl_max .and. npl_penalty<=npl_max)
+          if (found_degree) then
+              npl = max(npl_function,npl_penalty)
+              increase_degree_for_penaltyfunction = (npl_penalty>npl_function)
+          else
+              npl = npl_max
+          end if
+          ! Coefficients for the final degree
+          error_ok = degree_ok(DEGREE_FUNCTION, npl)
+          error_ok = degree_ok(DEGREE_PENALTY, npl)
+          do icalc=1,ncalc
+              do jpl=1,npl
+                  cc_trial(jpl,icalc,2) = cc_trial(jpl,1,2)
+                  cc_trial(jpl,icalc,3) = -cc_trial(jpl,1,2)
+              end do
+          end do
+      end if
       degree_loop: do ipl=npl_min,npl_max,npl_stride
 
+          if (warm_start) exit degree_loop
+          ntested_ = ntested_ + 2
+
           if (foe_data_get_real(foe_obj,"evhigh",ispin)<=0.d0) then
               stop 'ERROR: highest eigenvalue must be positive'
           end if
@@ -2376,6 +2445,7 @@ module foe_common
           end if
           npl = npl_max
       end if
+      if (present(ntested)) ntested = ntested_
 
       if (iproc==0 .and. verbosity>0) then
           call yaml_sequence_close()
@@ -2404,6 +2474,84 @@ module foe_common
 
       call f_release_routine
 
+      contains
+
+        !> Check whether the function (iwhat=DEGREE_FUNCTION) or the penalty function (iwhat=DEGREE_PENALTY)
+        !! is represented with the required accuracy by a polynomial of degree jpl_test;
+        !! the coefficients are stored in cc_trial(:,:,1) or cc_trial(:,1,2), respectively.
+        logical function degree_ok(iwhat, jpl_test)
+          implicit none
+          integer,intent(in) :: iwhat, jpl_test
+          integer :: jcalc
+
+          ntested_ = ntested_ + 1
+          call f_timing(TCAT_CME_AUXILIARY,'OF')
+          call f_timing(TCAT_CME_COEFFICIENTS,'ON')
+          if (iwhat==DEGREE_FUNCTION) then
+              do jcalc=1,ncalc
+                  select case (fun)
+                  case (FUNCTION_POLYNOMIAL)
+                      call func_set(FUNCTION_POLYNOMIAL, powerx=ex(jcalc))
+                  case (FUNCTION_ERRORFUNCTION)
+                      call func_set(FUNCTION_ERRORFUNCTION, efx=ef(jcalc), fscalex=fscale(jcalc))
+                  case (FUNCTION_FERMIFUNCTION)
+                      call func_set(FUNCTION_FERMIFUNCTION, efx=ef(jcalc), fscalex=fscale(jcalc))
+                  case (FUNCTION_FERMIFUNCTION_ENTROPY)
+                      call func_set(FUNCTION_FERMIFUNCTION_ENTROPY)
+                  case default
+                      call f_err_throw('wrong value for fun')
+                  end select
+                  call get_chebyshev_expansion_coefficients(iproc, nproc, comm, foe_data_get_real(foe_obj,"evlow",ispin), &
+                       foe_data_get_real(foe_obj,"evhigh",ispin), jpl_test, func, cc_trial(1:jpl_test,jcalc,1), &
+                       x_max_error(jcalc), max_error(jcalc), mean_error(jcalc))
+              end do
+              degree_ok = all(max_error(1:ncalc)<=accuracy_function)
+          else
+              call func_set(FUNCTION_EXPONENTIAL, betax=foe_data_get_real(foe_obj,"betax"), &
+                   muax=foe_data_get_real(foe_obj,"evlow",ispin), mubx=foe_data_get_real(foe_obj,"evhigh",ispin))
+              call get_chebyshev_expansion_coefficients(iproc, nproc, comm, foe_data_get_real(foe_obj,"evlow",ispin), &
+                   foe_data_get_real(foe_obj,"evhigh",ispin), jpl_test, func, cc_trial(1:jpl_test,1,2), &
+                   x_max_error_penaltyfunction, max_error_penaltyfunction, mean_error_penaltyfunction)
+              degree_ok = (max_error_penaltyfunction<=accuracy_penalty)
+          end if
+          call f_timing(TCAT_CME_COEFFICIENTS,'OF')
+          call f_timing(TCAT_CME_AUXILIARY,'ON')
+          if (iproc==0 .and. verbosity>0) then
+              call yaml_mapping_open(flow=.true.)
+              call yaml_map('ipl',jpl_test)
+              call yaml_map('penalty',iwhat==DEGREE_PENALTY)
+              call yaml_map('ok',degree_ok)
+              call yaml_mapping_close()
+          end if
+        end function degree_ok
+
+        !> Smallest degree npl_min+k*npl_stride for which degree_ok is true, searching from npl_start
+        !! downwards or upwards; huge(1) if it does not exist.
+        integer function search_degree(iwhat, npl_start) result(npl_found)
+          implicit none
+          integer,intent(in) :: iwhat, npl_start
+          integer :: jpl_test
+
+          jpl_test = npl_min + max(0,(npl_start-npl_min)/npl_stride)*npl_stride
+          jpl_test = min(jpl_test, npl_min+((npl_max-npl_min)/npl_stride)*npl_stride)
+          if (degree_ok(iwhat, jpl_test)) then
+              do
+                  if (jpl_test-npl_stride<npl_min) exit
+                  if (.not.degree_ok(iwhat, jpl_test-npl_stride)) exit
+                  jpl_test = jpl_test - npl_stride
+              end do
+              npl_found = jpl_test
+          else
+              npl_found = huge(1)
+              do jpl_test=jpl_test+npl_stride,npl_max,npl_stride
+                  if (degree_ok(iwhat, jpl_test)) then
+                      npl_found = jpl_test
+                      exit
+                  end if
+              end do
+          end if
+        end function search_degree
+
     end subroutine get_polynomial_degree
 
 
@@ -2538,7 +2686,8 @@ module foe_common
                smatm, smatl, ham_, foe_obj, npl_min, workarr_compr, chebyshev_polynomials, &
                npl, scale_factor, shift_value, hamscal_compr, &
                smats, ovrlp_, ovrlp_minus_one_half_, efarr, fscale_arr, ex, &
-               scaling_factor_low, scaling_factor_up, eval_multiplicator, eval_multiplicator_total, cc, max_errorx)
+               scaling_factor_low, scaling_factor_up, eval_multiplicator, eval_multiplicator_total, cc, max_errorx, &
+               warm_start)
       use module_func
       use dynamic_memory
       implicit none
@@ -2567,9 +2716,12 @@ module foe_common
       real(mp),intent(inout),optional :: eval_multiplicator, eval_multiplicator_total
       real(kind=mp),dimension(:,:,:),pointer,intent(out),optional :: cc
       real(mp),dimension(ncalc),intent(out),optional :: max_errorx
+      !> if true, start the search for the polynomial degree from the one of the previous call stored in foe_obj
+      logical,intent(in),optional :: warm_start
 
       ! Local variables
-      integer :: ilshift, i, jspin, imshift, npl_penalty
+      integer :: ilshift, i, jspin, imshift, npl_penalty, npl_guess, npl_penalty_guess, ntested, npl_min_start
+      logical :: warm_start_
       real(mp),dimension(:),allocatable :: max_error, x_max_error, mean_error
       real(mp) :: anoise, tt
       real(kind=mp),dimension(:,:,:),pointer :: cc_
@@ -2608,6 +2760,9 @@ module foe_common
       end if
 
 
+      warm_start_ = .false.
+      if (present(warm_start)) warm_start_ = warm_start
+
       max_error = f_malloc(ncalc,id='max_error')
       x_max_error = f_malloc(ncalc,id='x_max_error')
       mean_error = f_malloc(ncalc,id='mean_error')
@@ -2642,23 +2797,41 @@ module foe_common
               !fscale_arr(1) = foe_data_get_real(foe_obj,"fscale",ispin)
 
               if (jspin==1) then
+
+                  call foe_data_set_int(foe_obj,"nsweeps",foe_data_get_int(foe_obj,"nsweeps")+1)
+                  npl_guess = 0
+                  npl_penalty_guess = 0
+                  if (warm_start_) then
+                      npl_guess = foe_data_get_int(foe_obj,"npl_warmstart")
+                      npl_penalty_guess = foe_data_get_int(foe_obj,"npl_penalty_warmstart")
+                  end if
+                  npl_min_start = npl_min
     
                   if (func_name==FUNCTION_ERRORFUNCTION .or. func_name==FUNCTION_FERMIFUNCTION) then
                       call get_polynomial_degree(iproc, nproc, comm, 1, ncalc, &
                            foe_data_get_int(foe_obj,"occupation_function"), foe_obj, &
                            npl_min, npl_max, npl_stride, accuracy_function, accuracy_penalty, 0, npl, npl_penalty, cc_, &
                            max_error, x_max_error, mean_error, anoise, increase_degree_for_penaltyfunction, &
-                           ef=efarr, fscale=fscale_arr)
+                           ef=efarr, fscale=fscale_arr, &
+                           npl_guess=npl_guess, npl_penalty_guess=npl_penalty_guess, ntested=ntested)
                   else if (func_name==FUNCTION_POLYNOMIAL) then
                       call get_polynomial_degree(iproc, nproc, comm, 1, ncalc, FUNCTION_POLYNOMIAL, foe_obj, &
                            npl_min, npl_max, npl_stride, accuracy_function, accuracy_penalty, 0, npl, npl_penalty, cc_, &
                            max_error, x_max_error, mean_error, anoise, increase_degree_for_penaltyfunction, &
-                           ex=ex)
+                           ex=ex, npl_guess=npl_guess, npl_penalty_guess=npl_penalty_guess, ntested=ntested)
                   else if (func_name==FUNCTION_FERMIFUNCTION_ENTROPY) then
                       !!write(*,*) 'npl_min, npl_max, npl_stride', npl_min, npl_max, npl_stride
                       call get_polynomial_degree(iproc, nproc, comm, 1, ncalc, func_name, foe_obj, &
                            npl_min, npl_max, npl_stride, accuracy_function, accuracy_penalty, 0, npl, npl_penalty, cc_, &
-                           max_error, x_max_error, mean_error, anoise, increase_degree_for_penaltyfunction)
+                           max_error, x_max_error, mean_error, anoise, increase_degree_for_penaltyfunction, &
+                           npl_guess=npl_guess, npl_penalty_guess=npl_penalty_guess, ntested=ntested)
+                  end if
+                  if (warm_start_) then
+                      call foe_data_set_int(foe_obj,"npl_warmstart",npl)
+                      call foe_data_set_int(foe_obj,"npl_penalty_warmstart",npl_penalty)
+                      ! A search starting from npl_min would have tested both functions for each degree up to npl
+                      call foe_data_set_int(foe_obj,"ndegree_saved",foe_data_get_int(foe_obj,"ndegree_saved")+ &
+                           max(0,2*((npl-npl_min_start)/npl_stride+1)-ntested))
                   end if
                   !!npl_min = npl !to be used to speed up the search for npl in a following iteration
                   npl_min = min(npl_penalty,npl) !to be used to speed up the search for npl in a following iteration
@@ -2722,6 +2895,12 @@ module foe_common
                       eval_bounds_ok_allspins(i) = eval_bounds_ok(i)
                   end if 
               end do
+              ! If the bounds are not ok, the recursion stops after the penalty degree
+              if (all(eval_bounds_ok)) then
+                  call foe_data_set_int(foe_obj,"nspmm",foe_data_get_int(foe_obj,"nspmm")+npl)
+              else
+                  call foe_data_set_int(foe_obj,"nspmm",foe_data_get_int(foe_obj,"nspmm")+min(npl,npl_penalty))
+              end if
 
           end do spin_loop
 
@@ -256,7 +256,7 @@ module sparsematrix_highlevel
 
 
     subroutine sparse_matrix_and_matrices_init_from_file_bigdft(mode, filename, iproc, nproc, comm, smat, mat, &
-               init_matmul, filename_mult)
+               init_matmul, filename_mult, matmul_bsr)
       use sparsematrix_init, only: bigdft_to_sparsebigdft
       use sparsematrix_io, only: read_sparse_matrix
       use dynamic_memory
@@ -270,6 +270,7 @@ module sparsematrix_highlevel
       type(matrices),intent(out) :: mat
       logical,intent(in),optional :: init_matmul
       character(len=*),intent(in),optional :: filename_mult
+      logical,intent(in),optional :: matmul_bsr !< allow the atom-block sparse matmul (default yes)
       ! Optional variables that are contained within the sparse matrix format
       !!integer,intent(out),optional :: nat, ntypes
       !!integer,dimension(:),pointer,intent(inout),optional :: nzatom, nelpsp, iatype
@@ -292,7 +293,8 @@ module sparsematrix_highlevel
 
       call f_routine(id='sparse_matrix_and_matrices_init_from_file_bigdft')
 
-      if (trim(mode)/='serial_text' .and. trim(mode)/='parallel_mpi-native') then
+      if (trim(mode)/='serial_text' .and. trim(mode)/='parallel_mpi-native' .and. &
+          trim(mode)/='parallel_mpi-binary') then
           call f_err_throw("wrong value of 'mode'")
       end if
 
@@ -320,7 +322,8 @@ module sparsematrix_highlevel
       !!     init_matmul=init_matmul_)!, nspin=nspin, geocode=geocode, cell_dim=cell_dim, on_which_atom=on_which_atom_)
 
       if (init_matmul_) then
-          call sparse_matrix_init_from_file_bigdft(mode, filename, iproc, nproc, comm, smat, init_matmul_, filename_mult)
+          call sparse_matrix_init_from_file_bigdft(mode, filename, iproc, nproc, comm, smat, init_matmul_, filename_mult, &
+               matmul_bsr=matmul_bsr)
       else
           call sparse_matrix_init_from_file_bigdft(mode, filename, iproc, nproc, comm, smat, init_matmul_)
       end if
@@ -340,7 +343,7 @@ module sparsematrix_highlevel
 
 
     recursive subroutine sparse_matrix_init_from_file_bigdft(mode, filename, iproc, nproc, comm, &
-                         smat, init_matmul, filename_mult)
+                         smat, init_matmul, filename_mult, matmul_bsr)
       use sparsematrix_init, only: bigdft_to_sparsebigdft
       use sparsematrix_io, only: read_sparse_matrix
       use dynamic_memory
@@ -353,6 +356,7 @@ module sparsematrix_highlevel
       type(sparse_matrix),intent(out) :: smat
       logical,intent(in),optional :: init_matmul
       character(len=*),intent(in),optional :: filename_mult
+      logical,intent(in),optional :: matmul_bsr !< allow the atom-block sparse matmul (default yes)
 
       ! Local variables
       integer :: nspin, nfvctr, nseg, nvctr
@@ -373,7 +377,8 @@ module sparsematrix_highlevel
           init_matmul_ = .false.
       end if
 
-      if (trim(mode)/='serial_text' .and. trim(mode)/='parallel_mpi-native') then
+      if (trim(mode)/='serial_text' .and. trim(mode)/='parallel_mpi-native' .and. &
+          trim(mode)/='parallel_mpi-binary') then
           call f_err_throw("wrong value of 'mode'")
       end if
 
@@ -392,7 +397,7 @@ module sparsematrix_highlevel
       !!     nspin=nspin, geocode=geocode, cell_dim=cell_dim, on_which_atom=on_which_atom)
       if (init_matmul_) then
           call sparse_matrix_init_from_data_bigdft(iproc, nproc, comm, nspin, nfvctr, nvctr, nseg, keyg, smat, init_matmul_, &
-               nseg_mult=smat_mult%nseg, nvctr_mult=smat_mult%nvctr, keyg_mult=smat_mult%keyg)
+               nseg_mult=smat_mult%nseg, nvctr_mult=smat_mult%nvctr, keyg_mult=smat_mult%keyg, matmul_bsr=matmul_bsr)
           call deallocate_sparse_matrix(smat_mult)
       else
           call sparse_matrix_init_from_data_bigdft(iproc, nproc, comm, nspin, nfvctr, nvctr, nseg, keyg, smat, init_matmul_)
@@ -428,7 +433,8 @@ module sparsematrix_highlevel
     
       call f_routine(id='matrices_init_from_file_bigdft')
 
-      if (trim(mode)/='serial_text' .and. trim(mode)/='parallel_mpi-native') then
+      if (trim(mode)/='serial_text' .and. trim(mode)/='parallel_mpi-native' .and. &
+          trim(mode)/='parallel_mpi-binary') then
           call f_err_throw("wrong value of 'mode'")
       end if
     
@@ -498,7 +504,7 @@ module sparsematrix_highlevel
 
 
     subroutine sparse_matrix_init_from_data_bigdft(iproc, nproc, comm, nspin, nfvctr, nvctr, nseg, keyg, smat, &
-               init_matmul, nseg_mult, nvctr_mult, keyg_mult)
+               init_matmul, nseg_mult, nvctr_mult, keyg_mult, matmul_bsr)
       use sparsematrix_init, only: ccs_to_sparsebigdft_short, &
            bigdft_to_sparsebigdft, init_matrix_taskgroups
       use dynamic_memory
@@ -511,6 +517,7 @@ module sparsematrix_highlevel
       logical,intent(in) :: init_matmul
       integer,intent(in),optional :: nseg_mult, nvctr_mult
       integer,dimension(:,:,:),intent(in),optional :: keyg_mult
+      logical,intent(in),optional :: matmul_bsr !< allow the atom-block sparse matmul (default yes)
 
       call f_routine(id='sparse_matrix_init_from_data_bigdft')
 
@@ -529,7 +536,8 @@ module sparsematrix_highlevel
       ! Create the sparse_matrix structure
       if (init_matmul) then
           call bigdft_to_sparsebigdft(iproc, nproc, comm, nfvctr, nvctr, nseg, keyg, smat, nspin=nspin, &
-               init_matmul=init_matmul, nseg_mult=nseg_mult, nvctr_mult=nvctr_mult, keyg_mult=keyg_mult)
+               init_matmul=init_matmul, nseg_mult=nseg_mult, nvctr_mult=nvctr_mult, keyg_mult=keyg_mult, &
+               matmul_bsr=matmul_bsr)
       else
           call bigdft_to_sparsebigdft(iproc, nproc, comm, nfvctr, nvctr, nseg, keyg, smat, nspin=nspin)
       end if
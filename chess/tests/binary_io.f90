@@ -0,0 +1,178 @@
+!> @file
+!!   Test of the binary container of the sparse matrices
+!! @author
+!!   Copyright (C) 2017 CheSS developers
+!!
+!!   This file is part of CheSS.
+!!
+!!   CheSS is free software: you can redistribute it and/or modify
+!!   it under the terms of the GNU Lesser General Public License as published by
+!!   the Free Software Foundation, either version 3 of the License, or
+!!   (at your option) any later version.
+!!
+!!   CheSS is distributed in the hope that it will be useful,
+!!   but WITHOUT ANY WARRANTY; without even the implied warranty of
+!!   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+!!   GNU Lesser General Public License for more details.
+!!
+!!   You should have received a copy of the GNU Lesser General Public License
+!!   along with CheSS.  If not, see <http://www.gnu.org/licenses/>.
+
+
+!> Writes a matrix read from a text file, together with its metadata, to the binary
+!! container ('parallel_mpi-binary') and reads it back: the whole matrix with
+!! read_sparse_matrix, the metadata with read_sparse_matrix_metadata and a range of
+!! lines with read_sparse_matrix_lines. Everything must be identical to the input.
+program binary_io
+  use futile
+  use wrapper_MPI
+  use sparsematrix_base
+  use sparsematrix_init, only: init_matrix_taskgroups_wrapper
+  use sparsematrix, only: resize_matrix_to_taskgroup
+  use sparsematrix_io, only: read_sparse_matrix, write_sparse_matrix, read_sparse_matrix_lines
+  use sparsematrix_highlevel, only: sparse_matrix_and_matrices_init_from_file_bigdft, &
+                                    sparse_matrix_metadata_init_from_file
+  implicit none
+
+  ! Variables
+  integer :: iproc, nproc, comm, ist_compr, iline_start, iline_end, itype
+  integer :: nspin, nfvctr, nseg, nvctr, nspin_bin, nfvctr_bin, nseg_bin, nvctr_bin
+  character(len=1024) :: matrix_file, metadata_file
+  type(sparse_matrix),dimension(1) :: smat
+  type(matrices) :: mat
+  type(sparse_matrix_metadata) :: smmd, smmd_bin
+  integer,dimension(:),pointer :: keyv, keyv_bin
+  integer,dimension(:,:,:),pointer :: keyg, keyg_bin
+  real(kind=mp),dimension(:),pointer :: mat_compr, mat_compr_bin, mat_lines
+  logical :: keys_ok, metadata_ok
+  real(kind=mp) :: maxdiff, maxdiff_lines
+  type(dictionary), pointer :: options
+  type(yaml_cl_parse) :: parser !< command line parser
+  character(len=*),parameter :: filename_bin = 'binary_io_matrix'
+
+  call f_lib_initialize()
+
+  parser=yaml_cl_parse_null()
+  call commandline_options(parser)
+  call yaml_cl_parse_cmd_line(parser,args=options)
+  call yaml_cl_parse_free(parser)
+
+  matrix_file = options//'matrix_file'
+  metadata_file = options//'metadata_file'
+  call dict_free(options)
+
+  call mpiinit()
+  iproc=mpirank()
+  nproc=mpisize()
+  comm=mpiworld()
+
+  call f_malloc_set_status(iproc=iproc)
+
+  call sparsematrix_init_errors()
+  call sparsematrix_initialize_timing_categories()
+
+  if (iproc==0) then
+      call yaml_new_document()
+  end if
+
+  ! Matrix distributed over the taskgroups, and its metadata
+  call sparse_matrix_and_matrices_init_from_file_bigdft('serial_text', trim(matrix_file), &
+       iproc, nproc, comm, smat(1), mat, init_matmul=.false.)
+  call init_matrix_taskgroups_wrapper(iproc, nproc, comm, .true., 1, smat)
+  call resize_matrix_to_taskgroup(smat(1), mat)
+  call sparse_matrix_metadata_init_from_file(trim(metadata_file), smmd)
+
+  ! Each task writes its own part
+  call write_sparse_matrix('parallel_mpi-binary', iproc, nproc, comm, smat(1), mat, filename_bin, smmd=smmd)
+
+  ! Read back the whole matrix and compare with the text file
+  call read_sparse_matrix('serial_text', trim(matrix_file), iproc, nproc, comm, &
+       nspin, nfvctr, nseg, nvctr, keyv, keyg, mat_compr)
+  call read_sparse_matrix('parallel_mpi-binary', filename_bin//'.bin', iproc, nproc, comm, &
+       nspin_bin, nfvctr_bin, nseg_bin, nvctr_bin, keyv_bin, keyg_bin, mat_compr_bin)
+  keys_ok = nspin==nspin_bin .and. nfvctr==nfvctr_bin .and. nseg==nseg_bin .and. nvctr==nvctr_bin
+  if (keys_ok) then
+      keys_ok = all(keyv==keyv_bin) .and. all(keyg==keyg_bin)
+      maxdiff = maxval(abs(mat_compr-mat_compr_bin))
+  else
+      maxdiff = huge(maxdiff)
+  end if
+
+  ! Read back the metadata
+  call sparse_matrix_metadata_init_from_file(filename_bin//'.bin', smmd_bin)
+  metadata_ok = smmd%nfvctr==smmd_bin%nfvctr .and. smmd%nat==smmd_bin%nat .and. &
+                smmd%ntypes==smmd_bin%ntypes .and. smmd%geocode==smmd_bin%geocode .and. &
+                smmd%units==smmd_bin%units
+  if (metadata_ok) then
+      metadata_ok = all(smmd%cell_dim==smmd_bin%cell_dim) .and. all(smmd%shift==smmd_bin%shift) .and. &
+                    all(smmd%rxyz==smmd_bin%rxyz) .and. all(smmd%nzatom==smmd_bin%nzatom) .and. &
+                    all(smmd%nelpsp==smmd_bin%nelpsp) .and. all(smmd%iatype==smmd_bin%iatype) .and. &
+                    all(smmd%on_which_atom==smmd_bin%on_which_atom)
+      do itype=1,smmd%ntypes
+          metadata_ok = metadata_ok .and. smmd%atomnames(itype)==smmd_bin%atomnames(itype)
+      end do
+  end if
+
+  ! Read only some lines; not collective, each task takes a different range
+  iline_start = 1 + mod(iproc*(nfvctr/3),nfvctr)
+  iline_end = min(iline_start+nfvctr/4,nfvctr)
+  call read_sparse_matrix_lines(filename_bin//'.bin', 1, iline_start, iline_end, ist_compr, mat_lines)
+  maxdiff_lines = 0.0_mp
+  if (size(mat_lines)>0) then
+      maxdiff_lines = maxval(abs(mat_lines-mat_compr(ist_compr+1:ist_compr+size(mat_lines))))
+  end if
+  call fmpi_allreduce(maxdiff_lines, 1, FMPI_MAX, comm=comm)
+
+  if (iproc==0) then
+      call yaml_mapping_open('Binary container round trip')
+      call yaml_map('Keys identical',keys_ok)
+      call yaml_map('Max difference of the values',maxdiff)
+      call yaml_map('Metadata identical',metadata_ok)
+      call yaml_map('Max difference of the lines read separately',maxdiff_lines)
+      call yaml_mapping_close()
+  end if
+
+  call f_free_ptr(keyv)
+  call f_free_ptr(keyg)
+  call f_free_ptr(mat_compr)
+  call f_free_ptr(keyv_bin)
+  call f_free_ptr(keyg_bin)
+  call f_free_ptr(mat_compr_bin)
+  call f_free_ptr(mat_lines)
+  call deallocate_sparse_matrix_metadata(smmd)
+  call deallocate_sparse_matrix_metadata(smmd_bin)
+  call deallocate_sparse_matrix(smat(1))
+  call deallocate_matrices(mat)
+
+  if (iproc==0) then
+      call yaml_release_document()
+  end if
+
+  call mpifinalize()
+
+  call f_lib_finalize()
+
+end program binary_io
+
+
+subroutine commandline_options(parser)
+  use yaml_parse
+  use dictionaries, only: dict_new,operator(.is.)
+  implicit none
+  type(yaml_cl_parse),intent(inout) :: parser
+
+  call yaml_cl_parse_option(parser,'matrix_file','matrix.txt',&
+       'input file name','f',&
+       dict_new('Usage' .is. &
+       'File name from which the sparse matrix is read (text format)',&
+       'Allowed values' .is. &
+       'String'))
+
+  call yaml_cl_parse_option(parser,'metadata_file','sparsematrix_metadata.dat',&
+       'input file name of the metadata','m',&
+       dict_new('Usage' .is. &
+       'File name from which the metadata of the sparse matrix are read',&
+       'Allowed values' .is. &
+       'String'))
+
+end subroutine commandline_options
@@ -66,12 +66,14 @@ program driver_foe
   type(foe_data),dimension(:),allocatable :: foe_obj, ice_obj
   real(mp) :: tr, fscale, fscale_lowerbound, fscale_upperbound, accuracy_foe, accuracy_ice, accuracy_penalty
   real(mp) :: fscale_ediff_low, fscale_ediff_up
+  real(mp) :: ef_cold, energy_warm, ef_diff_warm, energy_diff_warm, kernel_diff_warm
+  type(matrices) :: mat_k_warm
   type(dictionary),pointer :: dict_timing_info, options
   type(yaml_cl_parse) :: parser !< command line parser
   character(len=1024) :: metadata_file, overlap_file, hamiltonian_file, kernel_file, kernel_matmul_file
   character(len=1024) :: sparsity_format, matrix_format, kernel_method, inversion_method
   logical :: check_spectrum, do_cubic_check, pexsi_do_inertia_count, init_matmul, keep_dense_kernel, write_kernel
-  logical :: write_symmetrized_kernel
+  logical :: write_symmetrized_kernel, check_warm_start
   integer,parameter :: nthreshold = 10 !< number of checks with threshold
   real(mp),dimension(nthreshold),parameter :: threshold = (/ 1.e-1_mp, &
                                                              1.e-2_mp, &
@@ -177,6 +179,7 @@ program driver_foe
       call yaml_map('Routine timing profiling depth',profiling_depth)
       call yaml_map('Keep the dense kernel',keep_dense_kernel)
       call yaml_map('Write the density kernel to disk',write_kernel)
+      call yaml_map('Check the warm start of FOE',check_warm_start)
       call yaml_mapping_close()
   end if
 
@@ -416,6 +419,30 @@ program driver_foe
       energies(it) = energy
   end do it_loop
 
+  ! Restart FOE from the objects of the last iteration, i.e. with the eigenvalue bounds,
+  ! polynomial degree and Fermi level found there, and compare with the cold start.
+  if (check_warm_start .and. trim(kernel_method)=='FOE') then
+      ef_cold = foe_data_get_real(foe_obj(nit),"ef",1)
+      call matrices_init(smat(3), mat_k_warm, matsize=SPARSE_TASKGROUP)
+      if (iproc==0) then
+          call yaml_comment('Warm start from the last iteration',hfill='=')
+          call yaml_sequence(advance='no')
+      end if
+      call matrix_fermi_operator_expansion(iproc, nproc, mpi_comm_world, &
+           foe_obj(nit), ice_obj(nit), smat(1), smat(2), smat(3), &
+           mat_s, mat_h, mat_ovrlpminusonehalf, mat_k_warm, energy_warm, &
+           calculate_minusonehalf=.false., foe_verbosity=1, symmetrize_kernel=.true., &
+           calculate_energy_density_kernel=.false., inversion_method=inversion_method)
+      ef_diff_warm = abs(foe_data_get_real(foe_obj(nit),"ef",1)-ef_cold)
+      energy_diff_warm = abs(energy_warm-energies(nit))
+      kernel_diff_warm = 0.0_mp
+      if (smat(3)%nvctrp_tg*smat(3)%nspin>0) then
+          kernel_diff_warm = maxval(abs(mat_k_warm%matrix_compr-mat_k%matrix_compr))
+      end if
+      call fmpi_allreduce(kernel_diff_warm, 1, FMPI_MAX, comm=mpi_comm_world)
+      call deallocate_matrices(mat_k_warm)
+  end if
+
   if (write_symmetrized_kernel) then
       if (.not.keep_dense_kernel) call yaml_warning("If 'keep_dense_kernel=no', 'keep_dense_kernel' will have no effect")
       if (.not.write_kernel) call yaml_warning("If 'write_kernel=no', 'keep_dense_kernel' will have no effect")
@@ -489,6 +516,14 @@ program driver_foe
       call yaml_scalar('',hfill='=')
   end if
 
+  if (check_warm_start .and. trim(kernel_method)=='FOE' .and. iproc==0) then
+      call yaml_mapping_open('Warm start versus cold start')
+      call yaml_map('Fermi level difference',ef_diff_warm,fmt='(es10.3)')
+      call yaml_map('energy difference',energy_diff_warm,fmt='(es10.3)')
+      call yaml_map('kernel max difference',kernel_diff_warm,fmt='(es10.3)')
+      call yaml_mapping_close()
+  end if
+
   call fmpi_barrier()
   call f_timing_checkpoint(ctr_name='CALC',mpi_comm=mpiworld(),nproc=mpisize(), &
        gather_routine=gather_timings)
@@ -674,6 +709,7 @@ program driver_foe
           write_symmetrized_kernel = options//'write_symmetrized_kernel'
           fscale_ediff_low = options//'fscale_ediff_low'
           fscale_ediff_up = options//'fscale_ediff_up'
+          check_warm_start = options//'check_warm_start'
          
           call dict_free(options)
       end if
@@ -795,6 +831,19 @@ program driver_foe
       else
           write_symmetrized_kernel = .false.
       end if
+      if (iproc==0) then
+          if (check_warm_start) then
+              icheck = 1
+          else
+              icheck = 0
+          end if
+      end if
+      call fmpi_bcast(icheck)
+      if (icheck==1) then
+          check_warm_start = .true.
+      else
+          check_warm_start = .false.
+      end if
 
     end subroutine read_and_communicate_input_variables
 
@@ -1119,5 +1168,13 @@ subroutine commandline_options(parser)
        'Allowed values' .is. &
        'Double'))
 
+  call yaml_cl_parse_option(parser,'check_warm_start','.false.',&
+       'Check that a warm start of FOE gives the same result as a cold start',&
+       help_dict=dict_new('Usage' .is. &
+       'Indicate whether FOE shall be run again starting from the parameters of the last iteration &
+       &and compared with the cold start',&
+       'Allowed values' .is. &
+       'Logical'))
+
 
 end subroutine commandline_options
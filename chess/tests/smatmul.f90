@@ -36,7 +36,7 @@ program smatmul
   use sparsematrix, only: write_matrix_compressed, &
                           sparsemm_new, sequential_acces_matrix_fast2, &
                           compress_matrix_distributed_wrapper, &
-                          resize_matrix_to_taskgroup
+                          resize_matrix_to_taskgroup, gather_matrix_from_taskgroups
   use sparsematrix_io, only: read_sparse_matrix, write_sparse_matrix
   use sparsematrix_highlevel, only: sparse_matrix_and_matrices_init_from_file_bigdft
   implicit none
@@ -53,13 +53,14 @@ program smatmul
   integer,dimension(:,:,:),pointer :: keyg
   character(len=20),dimension(:),pointer :: atomnames
   real(kind=8),dimension(:,:),pointer :: rxyz
-  type(sparse_matrix),dimension(1) :: smat
-  type(matrices) :: matA
+  type(sparse_matrix),dimension(1) :: smat, smat_csr
+  type(matrices) :: matA, matA_csr
   real(kind=8) :: max_error, mean_error
-  logical :: symmetric
+  logical :: symmetric, compare_bsr
   real(kind=8) :: time_start, time_end
   real(kind=8),dimension(:),pointer :: mat_compr
-  real(kind=8),dimension(:),allocatable :: mat_seq, vector_in, vector_out
+  real(kind=8),dimension(:),allocatable :: mat_seq, vector_in, vector_out, mat_global, mat_global_csr
+  real(kind=8) :: maxdiff
   type(dictionary), pointer :: dict_timing_info
   type(dictionary), pointer :: options
   type(yaml_cl_parse) :: parser !< command line parser
@@ -78,6 +79,7 @@ program smatmul
   filename = options//'filename'
   nit = options//'nit'
   verbosity = options//'verbosity'
+  compare_bsr = options//'compare_bsr'
   call dict_free(options)
 
   if (verbosity<1 .or. verbosity>2) then
@@ -182,6 +184,46 @@ program smatmul
   call f_timing_checkpoint(ctr_name='CALC',mpi_comm=comm,nproc=nproc,&
        gather_routine=gather_timings)
 
+  ! Repeat the multiplications with the scalar (CSR) version of the sparse matmul. The parallel
+  ! layout may differ from the one of the block version, so the results are compared globally.
+  if (compare_bsr) then
+      call sparse_matrix_and_matrices_init_from_file_bigdft('serial_text', filename, iproc, nproc,comm, &
+           smat_csr(1), matA_csr, init_matmul=.true., filename_mult=filename, matmul_bsr=.false.)
+      call init_matrix_taskgroups_wrapper(iproc, nproc, mpi_comm_world, .true., 1, smat_csr)
+      call resize_matrix_to_taskgroup(smat_csr(1), matA_csr)
+      call f_free(mat_seq)
+      call f_free(vector_in)
+      call f_free(vector_out)
+      mat_seq = sparsematrix_malloc(smat_csr(1), iaction=SPARSEMM_SEQ, id='mat_seq')
+      vector_in = f_malloc0(smat_csr(1)%smmm%nvctrp,id='vector_in')
+      vector_out = f_malloc0(smat_csr(1)%smmm%nvctrp,id='vector_out')
+      call sequential_acces_matrix_fast2(smat_csr(1), matA_csr%matrix_compr, mat_seq)
+      call vcopy(smat_csr(1)%smmm%nvctrp, &
+           matA_csr%matrix_compr(smat_csr(1)%smmm%isvctr_mm_par(iproc)+1-smat_csr(1)%isvctrp_tg), &
+           1, vector_in(1), 1)
+      do it=1,nit
+          call sparsemm_new(iproc, smat_csr(1), mat_seq, vector_in, vector_out)
+          call vcopy(smat_csr(1)%smmm%nvctrp, vector_out(1), 1, vector_in(1), 1)
+      end do
+      call compress_matrix_distributed_wrapper(iproc, nproc, smat_csr(1), SPARSE_MATMUL_SMALL, &
+           vector_out, ONESIDED_FULL, matA_csr%matrix_compr)
+      mat_global = sparsematrix_malloc(smat(1), iaction=SPARSE_FULL, id='mat_global')
+      mat_global_csr = sparsematrix_malloc(smat_csr(1), iaction=SPARSE_FULL, id='mat_global_csr')
+      call gather_matrix_from_taskgroups(iproc, nproc, comm, smat(1), matA%matrix_compr, mat_global)
+      call gather_matrix_from_taskgroups(iproc, nproc, comm, smat_csr(1), matA_csr%matrix_compr, mat_global_csr)
+      maxdiff = maxval(abs(mat_global-mat_global_csr))
+      if (iproc==0) then
+          call yaml_mapping_open('BSR versus CSR sparse matmul')
+          call yaml_map('BSR active',smat(1)%smmm%bsr%active)
+          call yaml_map('max difference',maxdiff,fmt='(es10.3)')
+          call yaml_mapping_close()
+      end if
+      call f_free(mat_global)
+      call f_free(mat_global_csr)
+      call deallocate_sparse_matrix(smat_csr(1))
+      call deallocate_matrices(matA_csr)
+  end if
+
   ! Deallocations
   call deallocate_sparse_matrix(smat(1))
   call deallocate_matrices(matA)
@@ -282,4 +324,11 @@ subroutine commandline_options(parser)
        'Allowed values' .is. &
        'Integer. Only 1 or 2 is possible'))
 
+  call yaml_cl_parse_option(parser,'compare_bsr','.false.',&
+       'compare the block and scalar sparse matmuls','b',&
+       dict_new('Usage' .is. &
+       'Repeat the multiplications with the scalar (CSR) sparse matmul and print the maximal difference with the block (BSR) one',&
+       'Allowed values' .is. &
+       'Logical'))
+
 end subroutine commandline_options
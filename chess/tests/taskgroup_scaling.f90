@@ -0,0 +1,226 @@
+!> @file
+!!   Weak scaling benchmark of the taskgroup communication of the sparse matrices
+!! @author
+!!   Copyright (C) 2017 CheSS developers
+!!
+!!   This file is part of CheSS.
+!!
+!!   CheSS is free software: you can redistribute it and/or modify
+!!   it under the terms of the GNU Lesser General Public License as published by
+!!   the Free Software Foundation, either version 3 of the License, or
+!!   (at your option) any later version.
+!!
+!!   CheSS is distributed in the hope that it will be useful,
+!!   but WITHOUT ANY WARRANTY; without even the implied warranty of
+!!   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+!!   GNU Lesser General Public License for more details.
+!!
+!!   You should have received a copy of the GNU Lesser General Public License
+!!   along with CheSS.  If not, see <http://www.gnu.org/licenses/>.
+
+
+!> Times the communication routines of sparsematrix.f90 on a random sparsity pattern
+!! (generate_random_symmetric_sparsity_pattern) whose size grows with the number of tasks,
+!! such that the work per task stays constant: the local sparse matmul, the distributed
+!! compress (ONESIDED_FULL, and ONESIDED_POST / ONESIDED_GATHER around a second matmul as
+!! done in the Chebyshev expansion), synchronize_matrix_taskgroups and
+!! gather_matrix_from_taskgroups. The timings are the maximum over the tasks of the
+!! average per iteration. Run it for several numbers of tasks, e.g. with "make weak-scaling".
+program taskgroup_scaling
+  use futile
+  use wrapper_MPI
+  use wrapper_linalg
+  use sparsematrix_base
+  use sparsematrix_init, only: generate_random_symmetric_sparsity_pattern, &
+                               init_matrix_taskgroups_wrapper, write_sparsematrix_info
+  use sparsematrix, only: sparsemm_new, sequential_acces_matrix_fast2, &
+                          compress_matrix_distributed_wrapper, synchronize_matrix_taskgroups, &
+                          gather_matrix_from_taskgroups
+  use sparsematrix_highlevel, only: matrices_init
+  use f_random, only: f_random_number
+  implicit none
+
+  ! Variables
+  integer :: iproc, nproc, comm, nfvctr_task, nvctr_task, nbuf_mult, nit, it, nthread
+  integer :: nfvctr, nvctr, istep
+  type(sparse_matrix),dimension(1) :: smat
+  type(matrices) :: mat
+  real(kind=mp),dimension(:),allocatable :: mat_seq, vector_in, vector_out, matrix_local, mat_global
+  type(fmpi_win),dimension(:),allocatable :: windows
+  real(kind=mp) :: t0
+  integer,parameter :: nstep = 5
+  real(kind=mp),dimension(nstep) :: times
+  character(len=*),dimension(nstep),parameter :: step_name = (/ &
+       'local matmul                        ', &
+       'compress, blocking                  ', &
+       'compress, overlapped with the matmul', &
+       'taskgroup synchronization           ', &
+       'gather from the taskgroups          ' /)
+  type(dictionary), pointer :: options
+  type(yaml_cl_parse) :: parser !< command line parser
+  !$ integer :: omp_get_max_threads
+
+  call f_lib_initialize()
+
+  parser=yaml_cl_parse_null()
+  call commandline_options(parser)
+  call yaml_cl_parse_cmd_line(parser,args=options)
+  call yaml_cl_parse_free(parser)
+
+  nfvctr_task = options//'nfvctr'
+  nvctr_task = options//'nvctr'
+  nbuf_mult = options//'nbuf_mult'
+  nit = options//'nit'
+  call dict_free(options)
+
+  call mpiinit()
+  iproc=mpirank()
+  nproc=mpisize()
+  comm=mpiworld()
+
+  call f_malloc_set_status(iproc=iproc)
+
+  call sparsematrix_init_errors()
+  call sparsematrix_initialize_timing_categories()
+
+  ! Weak scaling: the size of the matrix grows with the number of tasks
+  nfvctr = nproc*nfvctr_task
+  nvctr = nproc*nvctr_task
+
+  if (iproc==0) then
+      call yaml_new_document()
+      call yaml_mapping_open('Parallel environment')
+      call yaml_map('MPI tasks',nproc)
+      nthread = 1
+      !$ nthread = omp_get_max_threads()
+      call yaml_map('OpenMP threads',nthread)
+      call yaml_mapping_close()
+      call yaml_mapping_open('Parameters')
+      call yaml_map('Matrix dimension per task',nfvctr_task)
+      call yaml_map('Non-zero entries per task',nvctr_task)
+      call yaml_map('Buffer of the matmul pattern',nbuf_mult)
+      call yaml_map('Iterations',nit)
+      call yaml_mapping_close()
+  end if
+
+  call generate_random_symmetric_sparsity_pattern(iproc, nproc, comm, &
+       nfvctr, nvctr, nbuf_mult, .true., smat(1))
+  call init_matrix_taskgroups_wrapper(iproc, nproc, comm, .true., 1, smat)
+
+  if (iproc==0) then
+      call yaml_mapping_open('Matrix properties')
+      call write_sparsematrix_info(smat(1), 'Random matrix')
+      call yaml_mapping_close()
+  end if
+
+  ! Random entries, scaled such that the sum of each line is between 0 and 1
+  call matrices_init(smat(1), mat, matsize=SPARSE_TASKGROUP)
+  call f_random_number(mat%matrix_compr)
+  call vscal(smat(1)%nvctrp_tg, 1.0_mp/real(smat(1)%nfvctr,kind=mp), mat%matrix_compr(1), 1)
+
+  mat_seq = sparsematrix_malloc(smat(1), iaction=SPARSEMM_SEQ, id='mat_seq')
+  vector_in = f_malloc0(smat(1)%smmm%nvctrp,id='vector_in')
+  vector_out = f_malloc0(smat(1)%smmm%nvctrp,id='vector_out')
+  matrix_local = f_malloc(smat(1)%smmm%nvctrp_mm,id='matrix_local')
+  mat_global = sparsematrix_malloc(smat(1), iaction=SPARSE_FULL, id='mat_global')
+  windows = f_malloc(smat(1)%ntaskgroup,id='windows')
+
+  call sequential_acces_matrix_fast2(smat(1), mat%matrix_compr, mat_seq)
+  call f_random_number(vector_in)
+
+  times(:) = 0.0_mp
+  do it=1,nit
+      do istep=1,nstep
+          call fmpi_barrier(comm)
+          t0 = mpi_wtime()
+          select case (istep)
+          case (1)
+              call sparsemm_new(iproc, smat(1), mat_seq, vector_in, vector_out)
+          case (2)
+              call compress_matrix_distributed_wrapper(iproc, nproc, smat(1), SPARSE_MATMUL_LARGE, &
+                   vector_out, ONESIDED_FULL, mat%matrix_compr)
+          case (3)
+              call compress_matrix_distributed_wrapper(iproc, nproc, smat(1), SPARSE_MATMUL_LARGE, &
+                   vector_out, ONESIDED_POST, mat%matrix_compr, matrix_localx=matrix_local, windowsx=windows)
+              call sparsemm_new(iproc, smat(1), mat_seq, vector_in, vector_out)
+              call compress_matrix_distributed_wrapper(iproc, nproc, smat(1), SPARSE_MATMUL_LARGE, &
+                   vector_out, ONESIDED_GATHER, mat%matrix_compr, matrix_localx=matrix_local, windowsx=windows)
+          case (4)
+              call synchronize_matrix_taskgroups(iproc, nproc, smat(1), mat)
+          case (5)
+              call gather_matrix_from_taskgroups(iproc, nproc, comm, smat(1), mat%matrix_compr, mat_global)
+          end select
+          times(istep) = times(istep) + mpi_wtime() - t0
+      end do
+  end do
+  times(:) = times(:)/real(max(nit,1),kind=mp)
+  call fmpi_allreduce(times, FMPI_MAX, comm=comm)
+
+  if (iproc==0) then
+      call yaml_mapping_open('Time per iteration (s)')
+      do istep=1,nstep
+          call yaml_map(trim(step_name(istep)),times(istep),fmt='(es10.3)')
+      end do
+      call yaml_mapping_close()
+      ! Part of the blocking compress hidden behind the matmul in the overlapped version
+      if (times(2)>0.0_mp) then
+          call yaml_map('Hidden communication (%)', &
+               100.0_mp*max(0.0_mp,times(1)+times(2)-times(3))/times(2),fmt='(f6.1)')
+      end if
+  end if
+
+  call f_free(mat_seq)
+  call f_free(vector_in)
+  call f_free(vector_out)
+  call f_free(matrix_local)
+  call f_free(mat_global)
+  call free_fmpi_win_arr(windows)
+  call deallocate_matrices(mat)
+  call deallocate_sparse_matrix(smat(1))
+
+  if (iproc==0) then
+      call yaml_release_document()
+  end if
+
+  call mpifinalize()
+
+  call f_lib_finalize()
+
+end program taskgroup_scaling
+
+
+subroutine commandline_options(parser)
+  use yaml_parse
+  use dictionaries, only: dict_new,operator(.is.)
+  implicit none
+  type(yaml_cl_parse),intent(inout) :: parser
+
+  call yaml_cl_parse_option(parser,'nfvctr','200',&
+       'matrix dimension per task','n',&
+       dict_new('Usage' .is. &
+       'Dimension of the random matrix per MPI task, the total dimension is this value times the number of tasks',&
+       'Allowed values' .is. &
+       'Integer'))
+
+  call yaml_cl_parse_option(parser,'nvctr','2000',&
+       'non-zero entries per task','v',&
+       dict_new('Usage' .is. &
+       'Number of non-zero entries of the random matrix per MPI task',&
+       'Allowed values' .is. &
+       'Integer'))
+
+  call yaml_cl_parse_option(parser,'nbuf_mult','2',&
+       'buffer of the matmul pattern','b',&
+       dict_new('Usage' .is. &
+       'Extent of the buffer region used to build the sparsity pattern of the matrix multiplications',&
+       'Allowed values' .is. &
+       'Integer'))
+
+  call yaml_cl_parse_option(parser,'nit','10',&
+       'number of iterations','i',&
+       dict_new('Usage' .is. &
+       'Number of times each operation is timed',&
+       'Allowed values' .is. &
+       'Integer'))
+
+end subroutine commandline_options
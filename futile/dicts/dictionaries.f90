@@ -401,7 +401,8 @@ contains
        type(dictionary), pointer :: iter !to iterate over the dictionaries
        logical :: key_found
        type(dictionary), pointer :: dict_update      !< iterator for list renumbering
-       iter => dict
+       !go directly to the first occurrence
+       iter => get_dict_from_key(dict,key)
        key_found=.false.
        key_loop: do while(associated(iter))
           !follow the chain, stop at the first occurence
@@ -410,6 +411,7 @@ contains
           if (trim(iter%data%key) == trim(key)) then
              if (associated(iter%parent)) then
                 iter%parent%data%nelems=iter%parent%data%nelems-1
+                call dict_index_remove(iter%parent,iter)
              else
                 iter%data%nelems=iter%data%nelems-1
              end if
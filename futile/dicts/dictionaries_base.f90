@@ -26,6 +26,8 @@ module dictionaries_base
   integer, private :: nfolders_max=0   !< Maximum number of libraries allocated
   
   integer, parameter, private :: nfolder_size=10000 !< Size of the folder of pre-allocated dictionaries. Should be about 7 MB.
+  !> Number of keys above which the children of a mapping are searched through a hash index
+  integer, parameter, private :: nelems_indexed=32
   
   
   type, public :: storage
@@ -44,8 +46,25 @@ module dictionaries_base
      type(dictionary), pointer :: next => null()
      type(dictionary), pointer :: child => null()
      type(dictionary), pointer :: previous => null()
+     type(dictionary_index), pointer :: lookup => null() !< hash index of the children, for large mappings
   end type dictionary
 
+  type, public :: dictionary_slot
+     type(dictionary), pointer :: ptr => null()
+  end type dictionary_slot
+
+  !> Hash table (open addressing) of the keys of the children of a mapping.
+  !! It is built at the first search in a mapping of more than nelems_indexed keys
+  !! and kept up to date by set_elem and dict_index_remove.
+  !! It is considered as outdated (and rebuilt) whenever its number of keys or its first child
+  !! do not correspond to the ones of the mapping, or when keyed children are moved in
+  type, public :: dictionary_index
+     integer :: nkeys=0 !< number of indexed keys
+     type(dictionary), pointer :: first => null() !< first child when the index was updated
+     type(dictionary), pointer :: last => null()  !< last child, where the new keys are appended
+     type(dictionary_slot), dimension(:), pointer :: slots => null()
+  end type dictionary_index
+
 !!$  type :: values
 !!$     integer  :: inte 
 !!$     double precision :: rel
@@ -190,7 +209,7 @@ contains
     implicit none
     type(dictionary), intent(inout) :: dict
     dict%data=storage_null()
-    nullify(dict%child,dict%next,dict%parent,dict%previous)
+    nullify(dict%child,dict%next,dict%parent,dict%previous,dict%lookup)
   end subroutine dictionary_nullify
 
 
@@ -445,6 +464,7 @@ contains
          current=>dict_iter
          dict_iter=>dict_iter%next
          !destroy current
+         call dict_index_free(current)
          if (nfolder_size==0) then
             deallocate(current)
          else
@@ -682,6 +702,10 @@ contains
 !!$    end do
 
     child%parent=>dict
+    !keys which are moved in are not known by the index
+    if (associated(dict%lookup)) then
+       if (len_trim(child%data%key) > 0) call dict_index_free(dict)
+    end if
     if (associated(child%next)) call define_parent(dict,child%next)
   end subroutine define_parent
 
@@ -698,7 +722,7 @@ contains
 
   !> This routine creates a key for the dictionary in case it is absent
   !! the it adds one to the number of elements of the parent dictionary
-  pure subroutine set_elem(dict,key)
+  subroutine set_elem(dict,key)
     use yaml_strings, only: f_strcpy
     implicit none
     type(dictionary), pointer :: dict !!TO BE VERIFIED
@@ -708,6 +732,7 @@ contains
     call f_strcpy(src=trim(key),dest=dict%data%key)
     if (associated(dict%parent)) then
        dict%parent%data%nelems=dict%parent%data%nelems+1
+       if (associated(dict%parent%lookup)) call dict_index_add(dict%parent,dict)
     else
        dict%data%nelems=dict%data%nelems+1
     end if
@@ -771,28 +796,37 @@ contains
     logical, intent(in), optional :: create 
     type(dictionary), pointer :: dict_ptr
     !local variables
-    logical :: crt
+    logical :: crt,indexed
     type(dictionary), pointer :: iter
 
     crt=.false.
     if (present(create)) crt=create
-    !iterate until key found
     nullify(dict_ptr)
-    iter => dict
-    seek: do 
-       if (iter%data%key == trim(key)) then
-          dict_ptr=> iter
-          exit seek
-       else if (associated(iter%next)) then
-          iter => iter%next
-          cycle seek
-       else 
-          exit seek
-       end if
-    end do seek
+    !large mappings are searched through the index of the parent
+    indexed=.false.
+    if (associated(dict%parent)) then
+       if (dict%parent%data%nelems >= nelems_indexed .and. &
+            associated(dict%parent%child,target=dict)) &
+            indexed=dict_index_search(dict%parent,key,dict_ptr,iter)
+    end if
+    !otherwise iterate until key found
+    if (.not. indexed) then
+       iter => dict
+       seek: do 
+          if (iter%data%key == trim(key)) then
+             dict_ptr=> iter
+             exit seek
+          else if (associated(iter%next)) then
+             iter => iter%next
+             cycle seek
+          else 
+             exit seek
+          end if
+       end do seek
+    end if
 
     !this is useful for the first assignation, might be moved at the beginning
-    if (crt) then
+    if (crt .and. .not. associated(dict_ptr)) then
        if (no_key(iter)) then 
           call set_elem(iter,key)
           dict_ptr => iter
@@ -813,6 +847,194 @@ contains
 !!$       end if
     end if
   end function get_dict_from_key
+
+
+  !> Hash value of a key, as it is stored in the dictionary.
+  !! The final multiplication scatters the keys which only differ by their last characters
+  !! (like 'Atom1','Atom2',...) otherwise they would end up in contiguous slots
+  pure function dict_hash(key) result(h)
+    implicit none
+    character(len=*), intent(in) :: key
+    integer :: h
+    !local variables
+    integer, parameter :: prime=2147483647
+    integer :: i
+    integer(f_long) :: hl
+
+    hl=0
+    do i=1,min(len_trim(key),max_field_length)
+       hl=mod(31*hl+ichar(key(i:i)),int(prime,f_long))
+    end do
+    h=int(mod(hl*2654435761_f_long,int(prime,f_long)))
+  end function dict_hash
+
+
+  !> Free the hash index of the children of dict
+  subroutine dict_index_free(dict)
+    implicit none
+    type(dictionary) :: dict
+
+    if (.not. associated(dict%lookup)) return
+    if (associated(dict%lookup%slots)) deallocate(dict%lookup%slots)
+    deallocate(dict%lookup)
+    nullify(dict%lookup)
+  end subroutine dict_index_free
+
+
+  !> Put the child in the first free slot of the hash table
+  subroutine dict_index_insert(index,child)
+    implicit none
+    type(dictionary_index), intent(inout) :: index
+    type(dictionary), pointer :: child
+    !local variables
+    integer :: mask,islot
+
+    mask=size(index%slots)-1
+    islot=iand(dict_hash(child%data%key),mask)
+    do while(associated(index%slots(islot)%ptr))
+       islot=iand(islot+1,mask)
+    end do
+    index%slots(islot)%ptr => child
+    index%nkeys=index%nkeys+1
+  end subroutine dict_index_insert
+
+
+  !> (Re)build the hash index of the children of dict
+  subroutine dict_index_build(dict)
+    implicit none
+    type(dictionary), pointer :: dict
+    !local variables
+    integer :: nslots
+    type(dictionary), pointer :: iter
+
+    call dict_index_free(dict)
+    allocate(dict%lookup)
+    !keep the load factor below one half
+    nslots=2*nelems_indexed
+    do while(nslots < 2*dict%data%nelems+2)
+       nslots=2*nslots
+    end do
+    allocate(dict%lookup%slots(0:nslots-1))
+    dict%lookup%first => dict%child
+    iter => dict%child
+    do while(associated(iter))
+       if (len_trim(iter%data%key) > 0) call dict_index_insert(dict%lookup,iter)
+       dict%lookup%last => iter
+       iter => iter%next
+    end do
+  end subroutine dict_index_build
+
+
+  !> Register in the index of dict its new child, which has just been given a key
+  subroutine dict_index_add(dict,child)
+    implicit none
+    type(dictionary), pointer :: dict,child
+
+    !the index was outdated, it will be rebuilt at the next search
+    if (dict%lookup%nkeys+1 /= dict%data%nelems .or. &
+         .not. associated(dict%lookup%first,target=dict%child)) then
+       call dict_index_free(dict)
+       return
+    end if
+    if (2*(dict%lookup%nkeys+1) > size(dict%lookup%slots)) then
+       !the child is already in the chain
+       call dict_index_build(dict)
+    else
+       call dict_index_insert(dict%lookup,child)
+       if (.not. associated(child%next)) dict%lookup%last => child
+    end if
+  end subroutine dict_index_add
+
+
+  !> Remove from the index of dict the child which is going to be extracted from the chain.
+  !! To be called before the child is unlinked
+  subroutine dict_index_remove(dict,child)
+    implicit none
+    type(dictionary), pointer :: dict,child
+    !local variables
+    integer :: mask,islot,jslot
+    type(dictionary), pointer :: moved
+
+    if (.not. associated(dict%lookup)) return
+    if (dict%lookup%nkeys /= dict%data%nelems+1 .or. &
+         .not. associated(dict%lookup%first,target=dict%child)) then
+       call dict_index_free(dict)
+       return
+    end if
+    mask=size(dict%lookup%slots)-1
+    islot=iand(dict_hash(child%data%key),mask)
+    do while(associated(dict%lookup%slots(islot)%ptr))
+       if (associated(dict%lookup%slots(islot)%ptr,target=child)) exit
+       islot=iand(islot+1,mask)
+    end do
+    if (.not. associated(dict%lookup%slots(islot)%ptr)) then
+       !the child was not known
+       call dict_index_free(dict)
+       return
+    end if
+    nullify(dict%lookup%slots(islot)%ptr)
+    dict%lookup%nkeys=dict%lookup%nkeys-1
+    !reinsert the rest of the cluster, for the probing sequences to stay contiguous
+    jslot=iand(islot+1,mask)
+    do while(associated(dict%lookup%slots(jslot)%ptr))
+       moved => dict%lookup%slots(jslot)%ptr
+       nullify(dict%lookup%slots(jslot)%ptr)
+       dict%lookup%nkeys=dict%lookup%nkeys-1
+       call dict_index_insert(dict%lookup,moved)
+       jslot=iand(jslot+1,mask)
+    end do
+    if (associated(dict%lookup%first,target=child)) dict%lookup%first => child%next
+    if (associated(dict%lookup%last,target=child)) dict%lookup%last => child%previous
+  end subroutine dict_index_remove
+
+
+  !> Search the key among the children of dict through its hash index, which is built if needed.
+  !! On exit dict_ptr is the child with the key (nullified if absent) and last is the last child.
+  !! Returns .false. if the index cannot be used, in which case the chain has to be searched
+  function dict_index_search(dict,key,dict_ptr,last) result(ok)
+    implicit none
+    type(dictionary), pointer :: dict
+    character(len=*), intent(in) :: key
+    type(dictionary), pointer :: dict_ptr,last
+    logical :: ok
+    !local variables
+    integer :: mask,islot
+
+    nullify(dict_ptr,last)
+    ok=associated(dict%lookup)
+    if (ok) ok=dict%lookup%nkeys == dict%data%nelems .and. &
+         associated(dict%lookup%first,target=dict%child)
+    if (.not. ok) call dict_index_build(dict)
+    !inconsistent counting of the keys, do not use the index
+    ok=dict%lookup%nkeys == dict%data%nelems
+    if (.not. ok) then
+       call dict_index_free(dict)
+       return
+    end if
+
+    mask=size(dict%lookup%slots)-1
+    islot=iand(dict_hash(key),mask)
+    do while(associated(dict%lookup%slots(islot)%ptr))
+       if (dict%lookup%slots(islot)%ptr%data%key == trim(key)) then
+          dict_ptr => dict%lookup%slots(islot)%ptr
+          exit
+       end if
+       islot=iand(islot+1,mask)
+    end do
+
+    if (associated(dict_ptr)) then
+       ok=associated(dict_ptr%parent,target=dict)
+    else
+       last => dict%lookup%last
+       ok=associated(last)
+       if (ok) ok=associated(last%parent,target=dict) .and. .not. associated(last%next)
+    end if
+    if (.not. ok) then
+       nullify(dict_ptr,last)
+       call dict_index_free(dict)
+    end if
+  end function dict_index_search
+
 !!$
 !!$  !> Retrieve the pointer to the dictionary which has this key.
 !!$  !! If the key does not exists, create it in the next chain 
@@ -0,0 +1,21 @@
+!> @file
+!! Include fortran file for allocation template
+!! Map the work array on a buffer of the pool if requested
+!! @author
+!!    Copyright (C) 2012-2017 BigDFT group
+!!    This file is distributed under the terms of the
+!!    GNU General Public License, see ~/COPYING file
+!!    or http://www.gnu.org/copyleft/gpl.txt .
+!!    For the list of contributors, see ~/AUTHORS
+  !the pool is not used when the arrays are padded for debugging
+  if (m%pool .and. f_nan_pad_size == 0) then
+     ibuf=pool_get(product(m%shape(1:m%rank)),m%array_id,m%routine_id)
+     if (ibuf /= 0) then
+        call pool_map(m%lbounds(1:m%rank),m%ubounds(1:m%rank),ibuf,array)
+        if (m%put_to_zero) array=0.d0
+        if (m%srcdata_add > int(0,kind=8)) &
+             call c_memcopy(array,m%srcdata_add,f_sizeof(array))
+        call f_timer_resume()!TCAT_ARRAY_ALLOCATIONS
+        return
+     end if
+  end if
@@ -0,0 +1,15 @@
+!> @file
+!! Include fortran file for deallocation template
+!! Give the buffer back to the pool if the array has been mapped on it
+!! @author
+!!    Copyright (C) 2012-2017 BigDFT group
+!!    This file is distributed under the terms of the
+!!    GNU General Public License, see ~/COPYING file
+!!    or http://www.gnu.org/copyleft/gpl.txt .
+!!    For the list of contributors, see ~/AUTHORS
+  if (pool_nbuffers > 0) then
+     if (pool_release(loc_arr(array))) then
+        nullify(array)
+        return
+     end if
+  end if
@@ -91,6 +91,33 @@ module dynamic_memory_base
   !! number of active instances in mems
   type(memory_state), save :: memstate 
 
+  !> Buffer of the pool of work arrays.
+  !! The pointers allocated with f_malloc_ptr(...,pool=.true.) are mapped on these buffers, 
+  !! which are recycled at f_free_ptr instead of being deallocated, without accessing 
+  !! the system allocator or the database of the allocations
+  type :: pool_buffer
+     real(f_double), dimension(:), allocatable :: buf !< storage, of size pool_size_min*2**k+pool_pad
+     integer :: ioff             !< offset of the first element which is aligned on pool_alignment bytes
+     integer(f_address) :: iadd  !< address of the first element used by the work arrays
+     integer(kind=8) :: nbytes   !< size of the work array presently mapped on the buffer
+     logical :: in_use           !< true if a work array is presently mapped on the buffer
+     logical :: accounted        !< true if the buffer is accounted in the memory status
+     character(len=namelen) :: id      !< name of the work array presently mapped on the buffer
+     character(len=namelen) :: routine !< routine which has mapped it
+  end type pool_buffer
+  integer, parameter :: pool_nbuffers_max=128 !< Maximum number of buffers of the pool
+  integer(f_long), parameter :: pool_size_min=1024 !< Size of the smallest buffer (in elements)
+  !> The work arrays start on a multiple of pool_alignment bytes, which satisfies the
+  !! alignment requested in the info of f_malloc (e.g. for the AVX convolutions)
+  integer, parameter :: pool_alignment=64
+  integer(f_long), parameter :: pool_pad=pool_alignment/8 !< Elements added to each buffer for the alignment
+  type(pool_buffer), dimension(pool_nbuffers_max), target, save :: pool_buffers
+  integer, save :: pool_nbuffers=0 !< Number of buffers which have been allocated
+
+  interface pool_map
+     module procedure pool_map_d1,pool_map_d2,pool_map_d3
+  end interface pool_map
+
 
   interface assignment(=)
      module procedure i1_all,i2_all,i3_all,i4_all
@@ -193,6 +220,7 @@ module dynamic_memory_base
   end interface
 
   public :: f_free,f_free_ptr,f_free_str,f_free_str_ptr,f_malloc_dump_status
+  public :: f_malloc_mark,f_malloc_memory
   public :: f_routine,f_release_routine,f_malloc_set_status,f_malloc_initialize,f_malloc_finalize
   public :: f_memcpy,f_maxdiff,f_update_database,f_purge_database,f_subptr
   public :: assignment(=),operator(.to.),operator(.plus.)
@@ -317,6 +345,175 @@ contains
     include 'f_map-inc.f90'
   end subroutine map_workspace_l
 
+  !> Find a free buffer of the pool for a work array of n double precision elements.
+  !! A new buffer is allocated if none of the right size class is available.
+  !! Returns 0 if the request cannot be served by the pool, in which case the
+  !! work array has to be allocated in the usual way.
+  !! The pool is shared by the threads, its accesses are serialized
+  function pool_get(n,id,routine) result(ibuf)
+    use metadata_interfaces, only: loc_arr
+    implicit none
+    integer(f_long), intent(in) :: n
+    character(len=*), intent(in) :: id,routine
+    integer :: ibuf
+    !local variables
+    integer :: jbuf,ierr
+    integer(f_long) :: nbuf
+    integer(f_address) :: iadd
+    !$ logical, external :: omp_get_nested
+    !$ integer, external :: omp_get_thread_num
+
+    ibuf=0
+    if (n <= int(0,f_long)) return
+    nbuf=pool_size_min
+    do while (nbuf < n)
+       nbuf=2*nbuf
+    end do
+    !$omp critical (f_malloc_pool)
+    do jbuf=1,pool_nbuffers
+       if (pool_buffers(jbuf)%in_use) cycle
+       if (size(pool_buffers(jbuf)%buf,kind=f_long) /= nbuf+pool_pad) cycle
+       ibuf=jbuf
+       memstate%poolreuse=memstate%poolreuse+1
+       exit
+    end do
+    !no return in the critical section, ibuf stays 0 if the pool is full
+    ierr=0
+    if (ibuf == 0) then
+       ierr=1
+       if (pool_nbuffers < pool_nbuffers_max) &
+            allocate(pool_buffers(pool_nbuffers+1)%buf(nbuf+pool_pad),stat=ierr)
+    end if
+    if (ibuf == 0 .and. ierr == 0) then
+       pool_nbuffers=pool_nbuffers+1
+       ibuf=pool_nbuffers
+       iadd=loc_arr(pool_buffers(ibuf)%buf)
+       pool_buffers(ibuf)%ioff=int(modulo(-iadd,int(pool_alignment,f_address)))/kind(1.0_f_double)
+       pool_buffers(ibuf)%iadd=iadd+pool_buffers(ibuf)%ioff*kind(1.0_f_double)
+       !the buffers are accounted in the memory status, but not in the database,
+       !unless they are allocated in an OpenMP region, as the other arrays
+       pool_buffers(ibuf)%accounted=.true.
+       !$ pool_buffers(ibuf)%accounted=omp_get_thread_num() == 0 .and. .not. omp_get_nested()
+       call f_update_database(nbuf+pool_pad,kind(1.0_f_double),1,int(0,kind=8),'pool buffer',routine,' ')
+       memstate%poolsize=memstate%poolsize+(nbuf+pool_pad)*kind(1.0_f_double)
+    end if
+
+    if (ibuf /= 0) then
+       pool_buffers(ibuf)%in_use=.true.
+       pool_buffers(ibuf)%nbytes=n*kind(1.0_f_double)
+       pool_buffers(ibuf)%id=id
+       pool_buffers(ibuf)%routine=routine
+       memstate%poolalloc=memstate%poolalloc+1
+       memstate%mempool%memory=memstate%mempool%memory+pool_buffers(ibuf)%nbytes
+       if (memstate%mempool%memory > memstate%mempool%peak) then
+          memstate%mempool%peak=memstate%mempool%memory
+          memstate%mempool%array=id
+          memstate%mempool%routine=routine
+       end if
+    end if
+    !$omp end critical (f_malloc_pool)
+  end function pool_get
+
+  !> Give back to the pool the buffer of the work array starting at address iadd.
+  !! Returns false if the array does not come from the pool
+  function pool_release(iadd) result(released)
+    implicit none
+    integer(f_address), intent(in) :: iadd
+    logical :: released
+    !local variables
+    integer :: ibuf
+
+    released=.false.
+    !$omp critical (f_malloc_pool)
+    do ibuf=1,pool_nbuffers
+       if (.not. pool_buffers(ibuf)%in_use) cycle
+       if (pool_buffers(ibuf)%iadd /= iadd) cycle
+       pool_buffers(ibuf)%in_use=.false.
+       memstate%mempool%memory=memstate%mempool%memory-pool_buffers(ibuf)%nbytes
+       released=.true.
+       exit
+    end do
+    !$omp end critical (f_malloc_pool)
+  end function pool_release
+
+  !> Deallocate all the buffers of the pool.
+  !! The work arrays which are still mapped on them are reported if dump is true
+  subroutine pool_finalize(dump)
+    use yaml_output
+    implicit none
+    logical, intent(in) :: dump
+    !local variables
+    integer :: ibuf
+
+    if (dump .and. any(pool_buffers(1:pool_nbuffers)%in_use)) then
+       call yaml_warning('Work arrays of the pool have not been freed')
+       call yaml_sequence_open('Pool work arrays at finalization')
+       do ibuf=1,pool_nbuffers
+          if (.not. pool_buffers(ibuf)%in_use) cycle
+          call yaml_sequence(advance='no')
+          call yaml_mapping_open(flow=.true.)
+          call yaml_map(arrayid,trim(pool_buffers(ibuf)%id))
+          call yaml_map(routineid,trim(pool_buffers(ibuf)%routine))
+          call yaml_map(sizeid,pool_buffers(ibuf)%nbytes)
+          call yaml_mapping_close()
+       end do
+       call yaml_sequence_close()
+    end if
+    do ibuf=1,pool_nbuffers
+       if (pool_buffers(ibuf)%accounted) call f_purge_database(size(pool_buffers(ibuf)%buf,kind=8),&
+            kind(1.0_f_double),id='pool buffer',routine=main)
+       deallocate(pool_buffers(ibuf)%buf)
+       pool_buffers(ibuf)%in_use=.false.
+    end do
+    pool_nbuffers=0
+  end subroutine pool_finalize
+
+  !> Associate a work array to the buffer ibuf of the pool, starting at the aligned element
+  subroutine pool_map_d1(lb,ub,ibuf,ptr)
+    implicit none
+    integer(f_kind), dimension(1), intent(in) :: lb,ub
+    integer, intent(in) :: ibuf
+    real(f_double), dimension(:), pointer, intent(inout) :: ptr
+    call remap(lb,ub,pool_buffers(ibuf)%buf(1+pool_buffers(ibuf)%ioff:))
+  contains
+    subroutine remap(lb,ub,heap)
+      implicit none
+      integer(f_kind), dimension(1), intent(in) :: lb,ub
+      real(f_double), dimension(lb(1):ub(1)), intent(in), target :: heap
+      ptr => heap
+    end subroutine remap
+  end subroutine pool_map_d1
+
+  subroutine pool_map_d2(lb,ub,ibuf,ptr)
+    implicit none
+    integer(f_kind), dimension(2), intent(in) :: lb,ub
+    integer, intent(in) :: ibuf
+    real(f_double), dimension(:,:), pointer, intent(inout) :: ptr
+    call remap(lb,ub,pool_buffers(ibuf)%buf(1+pool_buffers(ibuf)%ioff:))
+  contains
+    subroutine remap(lb,ub,heap)
+      implicit none
+      integer(f_kind), dimension(2), intent(in) :: lb,ub
+      real(f_double), dimension(lb(1):ub(1),lb(2):ub(2)), intent(in), target :: heap
+      ptr => heap
+    end subroutine remap
+  end subroutine pool_map_d2
+
+  subroutine pool_map_d3(lb,ub,ibuf,ptr)
+    implicit none
+    integer(f_kind), dimension(3), intent(in) :: lb,ub
+    integer, intent(in) :: ibuf
+    real(f_double), dimension(:,:,:), pointer, intent(inout) :: ptr
+    call remap(lb,ub,pool_buffers(ibuf)%buf(1+pool_buffers(ibuf)%ioff:))
+  contains
+    subroutine remap(lb,ub,heap)
+      implicit none
+      integer(f_kind), dimension(3), intent(in) :: lb,ub
+      real(f_double), dimension(lb(1):ub(1),lb(2):ub(2),lb(3):ub(3)), intent(in), target :: heap
+      ptr => heap
+    end subroutine remap
+  end subroutine pool_map_d3
+
   !> Copy the contents of an array into another one
   include 'f_memcpy-inc.f90'
 
@@ -418,6 +615,7 @@ contains
   subroutine f_routine(id,profile)
     use yaml_output, only: yaml_map,yaml_flush_document,yaml_mapping_open
     use yaml_strings, only: yaml_time_toa
+    use f_trace, only: f_trace_active,f_trace_open,f_trace_id,TRACE_ROUTINE
     implicit none
     logical, intent(in), optional :: profile     !< ???
     character(len=*), intent(in), optional :: id !< name of the subprogram
@@ -425,7 +623,10 @@ contains
     !local variables
     integer :: lgt,ncalls,unit_dbg
     integer(kind=8) :: itime
+    !$ integer, external :: omp_get_thread_num
 
+    !the codepoints are only followed by the master thread
+    !$ if (omp_get_thread_num() /= 0) return
 
     if (ictrl == 0) then
        call f_err_throw(&
@@ -499,6 +700,7 @@ contains
        call yaml_map('Entering',yaml_time_toa(),unit=unit_dbg)
        call yaml_flush_document(unit=unit_dbg)
     end if
+    if (f_trace_active) call f_trace_open(f_trace_id(id,TRACE_ROUTINE))
     call f_timer_resume()
   end subroutine f_routine
 
@@ -530,11 +732,14 @@ contains
          yaml_comment
     use f_utils, only: f_rewind
     use yaml_strings, only: yaml_time_toa
+    use f_trace, only: f_trace_active,f_trace_close
     implicit none
     type(f_perf), intent(in), optional :: performance_info
     !local variables
     integer :: jproc,unit_dbg
+    !$ integer, external :: omp_get_thread_num
 
+    !$ if (omp_get_thread_num() /= 0) return
     if (ictrl == 0) then
        call f_err_throw(&
             '(f_release_routine): the routine f_malloc_initialize has not been called',&
@@ -542,6 +747,8 @@ contains
        return
     end if
 
+    if (f_trace_active) call f_trace_close()
+
     !profile the profiling
     call f_timer_interrupt(TCAT_ROUTINE_PROFILING)
 
@@ -1089,6 +1296,7 @@ contains
     use yaml_output!, only: yaml_date_and_time_toa
     use f_utils
     use yaml_strings
+    use f_trace, only: f_trace_set_pid
     implicit none
     !Arguments
     character(len=*), intent(in), optional :: logfile_name   !< Name of the logfile
@@ -1159,7 +1367,10 @@ contains
 
     !if (present(memory_limit)) call f_set_memory_limit(memory_limit)
        
-    if (present(iproc)) call set(mems(ictrl)%dict_global//processid,iproc)
+    if (present(iproc)) then
+       call set(mems(ictrl)%dict_global//processid,iproc)
+       call f_trace_set_pid(iproc)
+    end if
 
 !!$    if (present(profiling_depth)) then
 !!$    end if
@@ -1203,6 +1414,16 @@ contains
 
     if (present(process_id)) process_id=-1
     pid=0
+    if (associated(mems(ictrl)%dict_global)) pid = mems(ictrl)%dict_global//processid
+    !the pool of work arrays is shared by all the instances
+    if (ictrl == 1) then
+       if (present(dump)) then
+          call pool_finalize(dump)
+       else
+          call pool_finalize(pid == 0)
+       end if
+    end if
+
     !quick return if variables not associated
     if (associated(mems(ictrl)%dict_global)) then
        !put the last values in the dictionary if not freed
@@ -1381,6 +1602,26 @@ contains
 
   end subroutine f_malloc_dump_status
 
+
+  !> Start the measurement of the memory peak of a section of the code.
+  !! The highest memory reached after this call is given by f_malloc_memory
+  subroutine f_malloc_mark()
+    implicit none
+    memstate%memmark%memory=memstate%memtot%memory
+    memstate%memmark%peak=memstate%memtot%memory
+  end subroutine f_malloc_mark
+
+
+  !> Memory allocated with f_malloc, in bytes: present value, value at the last
+  !! call to f_malloc_mark and highest value reached since that call
+  subroutine f_malloc_memory(memory,mark,peak)
+    implicit none
+    integer(f_long), intent(out), optional :: memory,mark,peak
+    if (present(memory)) memory=memstate%memtot%memory
+    if (present(mark)) mark=memstate%memmark%memory
+    if (present(peak)) peak=memstate%memmark%peak
+  end subroutine f_malloc_memory
+
   subroutine subpointer_bounds(is,ie,lb,ub,region,from,size,lbound)
     implicit none
     integer(f_kind) :: lb,ub,is,ie
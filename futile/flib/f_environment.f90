@@ -28,6 +28,8 @@ module f_environment
   integer :: f_memorylimit=0
   !> maximum depth of the profiling routines (unlimited by default)
   integer :: f_maximum_profiling_depth=-1
+  !> number of events kept per thread in the trace of the routines and categories (no trace by default)
+  integer :: f_trace_events=0
 
   interface f_getenv
      module procedure getenv_i0,getenv_l0
@@ -51,6 +53,8 @@ module f_environment
 
       call f_getenv('FUTILE_PROFILING_DEPTH',f_maximum_profiling_depth)
 
+      call f_getenv('FUTILE_TRACE_EVENTS',f_trace_events)
+
     end subroutine f_environment_acquire
 
     subroutine getenv_i0(envvar,data)
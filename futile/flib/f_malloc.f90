@@ -92,6 +92,7 @@ module module_f_malloc
      character(len=f_malloc_namelen) :: array_id      !< label the array
      character(len=f_malloc_namelen) :: routine_id    !< label the routine
      type(f_workspace), pointer :: w !<workspace structure if the array is a work array
+     logical :: pool                         !< take the array from the pool of recycled work arrays
      character(len=f_malloc_info_maxlength) :: info !<information to the database for handling various approaches for allocation
   end type malloc_information_ptr
 
@@ -339,6 +340,7 @@ contains
     include 'f_malloc-null-inc.f90'
     m%ptr=.true.
     nullify(m%w)
+    m%pool=.false.
   end subroutine nullify_malloc_information_ptr
 
   pure subroutine nullify_malloc_information_buf(m)
@@ -469,27 +471,35 @@ contains
 
 
 
-  pure function f_malloci_ptr_simple(size,id,routine_id,profile,info) result(m)
+  pure function f_malloci_ptr_simple(size,id,routine_id,profile,info,pool) result(m)
     implicit none
     type(malloc_information_ptr) :: m
+    logical, intent(in), optional :: pool
     include 'f_malloci-simple-inc.f90'
+    if (present(pool)) m%pool=pool
   end function f_malloci_ptr_simple
-  pure function f_mallocli_ptr_simple(size,id,routine_id,profile,info) result(m)
+  pure function f_mallocli_ptr_simple(size,id,routine_id,profile,info,pool) result(m)
     implicit none
     type(malloc_information_ptr) :: m
+    logical, intent(in), optional :: pool
     include 'f_mallocli-simple-inc.f90'
+    if (present(pool)) m%pool=pool
   end function f_mallocli_ptr_simple
   !> For rank-1 arrays
-  pure function f_malloci0_ptr_simple(size,id,routine_id,profile,info) result(m)
+  pure function f_malloci0_ptr_simple(size,id,routine_id,profile,info,pool) result(m)
     implicit none
     type(malloc_information_ptr) :: m
+    logical, intent(in), optional :: pool
     include 'f_malloci-simple-inc.f90'
+    if (present(pool)) m%pool=pool
     m%put_to_zero=.true.
   end function f_malloci0_ptr_simple
-  pure function f_mallocli0_ptr_simple(size,id,routine_id,profile,info) result(m)
+  pure function f_mallocli0_ptr_simple(size,id,routine_id,profile,info,pool) result(m)
     implicit none
     type(malloc_information_ptr) :: m
+    logical, intent(in), optional :: pool
     include 'f_mallocli-simple-inc.f90'
+    if (present(pool)) m%pool=pool
     m%put_to_zero=.true.
   end function f_mallocli0_ptr_simple
   !> For rank-1 arrays
@@ -571,16 +581,20 @@ contains
     m%put_to_zero=.true.
   end function f_malloc0_bound
   !> For rank-1 arrays
-  pure function f_malloc_ptr_bound(bounds,id,routine_id,profile,info) result(m)
+  pure function f_malloc_ptr_bound(bounds,id,routine_id,profile,info,pool) result(m)
     implicit none
     type(malloc_information_ptr) :: m
+    logical, intent(in), optional :: pool
     include 'f_malloc-bound-inc.f90'
+    if (present(pool)) m%pool=pool
   end function f_malloc_ptr_bound
   !> For rank-1 arrays
-  pure function f_malloc0_ptr_bound(bounds,id,routine_id,profile,info) result(m)
+  pure function f_malloc0_ptr_bound(bounds,id,routine_id,profile,info,pool) result(m)
     implicit none
     type(malloc_information_ptr) :: m
+    logical, intent(in), optional :: pool
     include 'f_malloc-bound-inc.f90'
+    if (present(pool)) m%pool=pool
     m%put_to_zero=.true.
   end function f_malloc0_ptr_bound
   !> For rank-1 arrays, with bounds
@@ -655,16 +669,20 @@ contains
     m%put_to_zero=.true.
   end function f_malloc0_bounds
   !> Define the allocation information for  arrays of different rank
-  pure function f_malloc_ptr_bounds(bounds,id,routine_id,profile,info) result(m)
+  pure function f_malloc_ptr_bounds(bounds,id,routine_id,profile,info,pool) result(m)
     implicit none
     type(malloc_information_ptr) :: m
+    logical, intent(in), optional :: pool
     include 'f_malloc-bounds-inc.f90'
+    if (present(pool)) m%pool=pool
   end function f_malloc_ptr_bounds
   !> Define the allocation information for  arrays of different rank
-  pure function f_malloc0_ptr_bounds(bounds,id,routine_id,profile,info) result(m)
+  pure function f_malloc0_ptr_bounds(bounds,id,routine_id,profile,info,pool) result(m)
     implicit none
     type(malloc_information_ptr) :: m
+    logical, intent(in), optional :: pool
     include 'f_malloc-bounds-inc.f90'
+    if (present(pool)) m%pool=pool
     m%put_to_zero=.true.
   end function f_malloc0_ptr_bounds
   !> Define the allocation information for  arrays of different rank
@@ -744,25 +762,29 @@ contains
   !!  m%put_to_zero=.true.
   !!end function f_mallocli0
   !> Define the allocation information for  arrays of different rank
-  function f_malloc_ptr(sizes,id,routine_id,lbounds,ubounds,profile,info,src,src_ptr) result(m)
+  function f_malloc_ptr(sizes,id,routine_id,lbounds,ubounds,profile,info,src,src_ptr,pool) result(m)
     implicit none
     !the integer array src is here added to avoid problems in resolving the ambiguity
     integer, dimension(:), intent(in), optional :: src
     integer, dimension(:), pointer, intent(in), optional :: src_ptr
     type(malloc_information_ptr) :: m
     integer, dimension(:), intent(in), optional :: sizes,lbounds,ubounds
+    logical, intent(in), optional :: pool
     !local variables
     integer :: i
     include 'f_malloc-base-inc.f90'
+    if (present(pool)) m%pool=pool
     include 'f_malloc-check-inc.f90'
     include 'f_malloc-extra-inc.f90'
   end function f_malloc_ptr
   !> Define the allocation information for  arrays of different rank
-  function f_malloc0_ptr(sizes,id,routine_id,lbounds,ubounds,profile,info) result(m)
+  function f_malloc0_ptr(sizes,id,routine_id,lbounds,ubounds,profile,info,pool) result(m)
     implicit none
     type(malloc_information_ptr) :: m
+    logical, intent(in), optional :: pool
     include 'f_malloc-total-inc.f90'
     m%put_to_zero=.true.
+    if (present(pool)) m%pool=pool
   end function f_malloc0_ptr
   !!function f_mallocli0_ptr(sizes,id,routine_id,lbounds,ubounds,profile,info) result(m)
   !!  implicit none
@@ -0,0 +1,330 @@
+!> @file
+!! Lightweight tracing of routines and timing categories
+!! Events are stored in per-thread ring buffers and dumped
+!! in the Chrome trace-event format (readable by Perfetto)
+!! @author
+!!    Copyright (C) 2017-2017 BigDFT group
+!!    This file is distributed under the terms of the
+!!    GNU General Public License, see ~/COPYING file
+!!    or http://www.gnu.org/copyleft/gpl.txt .
+!!    For the list of contributors, see ~/AUTHORS
+
+
+!> Module recording the timeline of the routines and of the timing categories.
+!! Names are interned once into integer ids, such that recording an event
+!! only costs a clock read and a write into the ring buffer of the calling thread.
+!! Each thread writes in its own ring, no lock is therefore needed.
+!! When the ring is full the oldest events are overwritten.
+module f_trace
+  use f_precisions
+  implicit none
+
+  private
+
+  !> kinds of the traced objects
+  integer, parameter, public :: TRACE_ROUTINE=1
+  integer, parameter, public :: TRACE_CATEGORY=2
+
+  !> maximum length of the names of the traced objects
+  integer, parameter :: trace_namelen=64
+  !> size of the hash table of the names (power of two)
+  integer, parameter :: trace_nids_max=4096
+  !> maximum depth of the stack of opened routines (per thread)
+  integer, parameter :: trace_depth_max=128
+
+  !> ring buffer of the events of one thread
+  type :: trace_ring
+     integer(f_long) :: nrec=0 !< number of events recorded since initialization
+     integer :: depth=0 !< depth of the stack of opened routines
+     integer, dimension(trace_depth_max) :: stack_id !< ids of the opened routines
+     integer(f_long), dimension(trace_depth_max) :: stack_t0 !< their opening time
+     integer, dimension(:), allocatable :: id !< id of the traced object
+     integer(f_long), dimension(:), allocatable :: t0 !< starting time of the event (ns)
+     integer(f_long), dimension(:), allocatable :: dt !< duration of the event (ns)
+     integer(f_long), dimension(8) :: pad !< avoid false sharing of the counters
+  end type trace_ring
+
+  !> true if the events are recorded
+  logical, save, public :: f_trace_active=.false.
+  !> number of events in the ring of each thread
+  integer(f_long), save :: trace_nevents=0
+  !> reference time of the trace
+  integer(f_long), save :: trace_epoch=0
+  !> process id written in the trace
+  integer, save :: trace_pid=0
+  type(trace_ring), dimension(:), allocatable, save :: rings
+
+  !> table of the interned names, an id is the position of the name in the table
+  integer, save :: trace_nids=0
+  character(len=trace_namelen), dimension(trace_nids_max), save :: trace_names
+  integer, dimension(trace_nids_max), save :: trace_kinds
+  !> hash table giving the id of a name (0 if the slot is empty)
+  integer, dimension(0:trace_nids_max-1), save :: trace_slots=0
+
+  public :: f_trace_initialize,f_trace_finalize,f_trace_set_pid
+  public :: f_trace_id,f_trace_open,f_trace_close,f_trace_event
+  public :: f_trace_dump
+
+  contains
+
+    !> Allocate the rings of nevents events for each of the threads
+    subroutine f_trace_initialize(nevents)
+      use f_utils, only: f_time
+      implicit none
+      integer, intent(in) :: nevents
+      !local variables
+      integer :: nthreads,ithread
+      !$ integer, external :: omp_get_max_threads
+
+      if (f_trace_active .or. nevents <= 0) return
+      nthreads=1
+      !$ nthreads=omp_get_max_threads()
+      allocate(rings(0:nthreads-1))
+      do ithread=0,nthreads-1
+         allocate(rings(ithread)%id(nevents))
+         allocate(rings(ithread)%t0(nevents))
+         allocate(rings(ithread)%dt(nevents))
+         rings(ithread)%nrec=0
+         rings(ithread)%depth=0
+      end do
+      trace_nevents=nevents
+      trace_epoch=f_time()
+      f_trace_active=.true.
+    end subroutine f_trace_initialize
+
+    subroutine f_trace_finalize()
+      implicit none
+      if (.not. f_trace_active) return
+      f_trace_active=.false.
+      deallocate(rings)
+      trace_nevents=0
+    end subroutine f_trace_finalize
+
+    !> Set the process id (MPI rank) labelling the trace
+    subroutine f_trace_set_pid(pid)
+      implicit none
+      integer, intent(in) :: pid
+      trace_pid=pid
+    end subroutine f_trace_set_pid
+
+    !> Integer id of the name, which is added to the table if not yet present.
+    !! Returns 0 if the table is full
+    function f_trace_id(name,kind) result(id)
+      implicit none
+      character(len=*), intent(in) :: name
+      integer, intent(in) :: kind !< TRACE_ROUTINE or TRACE_CATEGORY
+      integer :: id
+      !local variables
+      integer :: islot
+
+      islot=trace_lookup(name,kind,id)
+      if (id /= 0) return
+      !$omp critical (f_trace_intern)
+      islot=trace_lookup(name,kind,id)
+      if (id == 0 .and. islot >= 0 .and. trace_nids < trace_nids_max/2) then
+         trace_nids=trace_nids+1
+         trace_names(trace_nids)=name
+         trace_kinds(trace_nids)=kind
+         trace_slots(islot)=trace_nids
+         id=trace_nids
+      end if
+      !$omp end critical (f_trace_intern)
+    end function f_trace_id
+
+    !> Search the name in the hash table (open addressing with linear probing).
+    !! On exit, id is the id of the name (0 if not found)
+    !! and the result is the slot where it is (or should be) stored
+    function trace_lookup(name,kind,id) result(islot)
+      implicit none
+      character(len=*), intent(in) :: name
+      integer, intent(in) :: kind
+      integer, intent(out) :: id
+      integer :: islot
+      !local variables
+      integer :: i,h,lgt,iprobe
+
+      lgt=min(len_trim(name),trace_namelen)
+      h=kind
+      do i=1,lgt
+         h=mod(31*h+ichar(name(i:i)),1048573)
+      end do
+      islot=iand(h,trace_nids_max-1)
+      do iprobe=1,trace_nids_max
+         id=trace_slots(islot)
+         if (id == 0) return
+         if (trace_kinds(id) == kind .and. trace_names(id) == name(1:lgt)) return
+         islot=iand(islot+1,trace_nids_max-1)
+      end do
+      id=0
+      islot=-1
+    end function trace_lookup
+
+    !> Open the routine id on the stack of the calling thread
+    subroutine f_trace_open(id)
+      use f_utils, only: f_time
+      implicit none
+      integer, intent(in) :: id
+      !local variables
+      integer :: ithread,depth
+      !$ integer, external :: omp_get_thread_num
+
+      ithread=0
+      !$ ithread=omp_get_thread_num()
+      if (ithread > ubound(rings,1)) return
+      depth=rings(ithread)%depth+1
+      rings(ithread)%depth=depth
+      if (depth > trace_depth_max) return
+      rings(ithread)%stack_id(depth)=id
+      rings(ithread)%stack_t0(depth)=f_time()
+    end subroutine f_trace_open
+
+    !> Close the last opened routine of the calling thread and record its event
+    subroutine f_trace_close()
+      use f_utils, only: f_time
+      implicit none
+      !local variables
+      integer :: ithread,depth
+      !$ integer, external :: omp_get_thread_num
+
+      ithread=0
+      !$ ithread=omp_get_thread_num()
+      if (ithread > ubound(rings,1)) return
+      depth=rings(ithread)%depth
+      if (depth <= 0) return
+      rings(ithread)%depth=depth-1
+      if (depth > trace_depth_max) return
+      call record(rings(ithread),rings(ithread)%stack_id(depth),&
+           rings(ithread)%stack_t0(depth),f_time())
+    end subroutine f_trace_close
+
+    !> Record the event of the object id, which lasted from t0 to t1 (in ns)
+    subroutine f_trace_event(id,t0,t1)
+      implicit none
+      integer, intent(in) :: id
+      integer(f_long), intent(in) :: t0,t1
+      !local variables
+      integer :: ithread
+      !$ integer, external :: omp_get_thread_num
+
+      ithread=0
+      !$ ithread=omp_get_thread_num()
+      if (ithread > ubound(rings,1)) return
+      call record(rings(ithread),id,t0,t1)
+    end subroutine f_trace_event
+
+    subroutine record(ring,id,t0,t1)
+      implicit none
+      type(trace_ring), intent(inout) :: ring
+      integer, intent(in) :: id
+      integer(f_long), intent(in) :: t0,t1
+      !local variables
+      integer(f_long) :: i
+
+      if (id == 0) return
+      i=mod(ring%nrec,trace_nevents)+1
+      ring%id(i)=id
+      ring%t0(i)=t0
+      ring%dt(i)=t1-t0
+      ring%nrec=ring%nrec+1
+    end subroutine record
+
+    !> Write the events of the rings in the Chrome trace-event (JSON) format,
+    !! in the file prefix-trace-<pid>.json (one file per process).
+    !! The routines of each thread and the timing categories are given on separate tracks
+    subroutine f_trace_dump(prefix)
+      use f_utils, only: f_open_file,f_close
+      use yaml_strings, only: yaml_toa
+      implicit none
+      character(len=*), intent(in) :: prefix
+      !local variables
+      integer :: unt,ithread,ncat_tid,id
+      integer(f_long) :: irec,i,nrec
+      character(len=512) :: line
+
+      if (.not. f_trace_active) return
+      !the categories are on the track following the threads
+      ncat_tid=ubound(rings,1)+1
+
+      unt=97
+      call f_open_file(unt,file=trim(prefix)//'-trace-'//trim(adjustl(yaml_toa(trace_pid)))//'.json',&
+           position='rewind')
+      write(unt,'(a)') '{"displayTimeUnit":"ms","traceEvents":['
+      write(line,'(a,i0,a,i0,a)') '{"name":"process_name","ph":"M","pid":',trace_pid,&
+           ',"tid":0,"args":{"name":"Process ',trace_pid,'"}}'
+      write(unt,'(a)') trim(line)
+      do ithread=0,ubound(rings,1)
+         write(line,'(a,i0,a,i0,a,i0,a)') ',{"name":"thread_name","ph":"M","pid":',trace_pid,&
+              ',"tid":',ithread,',"args":{"name":"Routines (thread ',ithread,')"}}'
+         write(unt,'(a)') trim(line)
+      end do
+      write(line,'(a,i0,a,i0,a)') ',{"name":"thread_name","ph":"M","pid":',trace_pid,&
+           ',"tid":',ncat_tid,',"args":{"name":"Categories"}}'
+      write(unt,'(a)') trim(line)
+
+      do ithread=0,ubound(rings,1)
+         nrec=min(rings(ithread)%nrec,trace_nevents)
+         do irec=rings(ithread)%nrec-nrec,rings(ithread)%nrec-1
+            i=mod(irec,trace_nevents)+1
+            id=rings(ithread)%id(i)
+            if (trace_kinds(id) == TRACE_CATEGORY) then
+               call event_line(line,trim(json_string(trace_names(id))),'category',&
+                    rings(ithread)%t0(i)-trace_epoch,rings(ithread)%dt(i),ncat_tid)
+            else
+               call event_line(line,trim(json_string(trace_names(id))),'routine',&
+                    rings(ithread)%t0(i)-trace_epoch,rings(ithread)%dt(i),ithread)
+            end if
+            write(unt,'(a)') trim(line)
+         end do
+      end do
+      write(unt,'(a)') ']}'
+      call f_close(unt)
+
+    contains
+
+      !> Complete event, the times are written in microseconds
+      subroutine event_line(line,name,cat,t0,dt,tid)
+        implicit none
+        character(len=*), intent(out) :: line
+        character(len=*), intent(in) :: name,cat
+        integer(f_long), intent(in) :: t0,dt
+        integer, intent(in) :: tid
+        !local variables
+        integer(f_long), parameter :: ns=1000
+
+        write(line,'(5a,i0,a,i3.3,a,i0,a,i3.3,a,i0,a,i0,a)') &
+             ',{"name":"',name,'","cat":"',cat,'","ph":"X","ts":',&
+             t0/ns,'.',mod(t0,ns),',"dur":',dt/ns,'.',mod(dt,ns),&
+             ',"pid":',trace_pid,',"tid":',tid,'}'
+      end subroutine event_line
+
+    end subroutine f_trace_dump
+
+    !> Content of the JSON string of the name: quotes, backslashes and
+    !! control characters are escaped
+    function json_string(name) result(str)
+      implicit none
+      character(len=*), intent(in) :: name
+      character(len=6*trace_namelen) :: str
+      !local variables
+      integer :: i,j,ic
+      character(len=1), parameter :: backslash=achar(92)
+
+      str=repeat(' ',len(str))
+      j=0
+      do i=1,len_trim(name)
+         ic=ichar(name(i:i))
+         select case(ic)
+         case(ichar('"'),ichar(backslash))
+            str(j+1:j+2)=backslash//name(i:i)
+            j=j+2
+         case(0:31,127)
+            write(str(j+1:j+6),'(2a,z4.4)') backslash,'u',ic
+            j=j+6
+         case default
+            str(j+1:j+1)=name(i:i)
+            j=j+1
+         end select
+      end do
+    end function json_string
+
+end module f_trace
@@ -795,8 +795,10 @@ subroutine d1_ptr(array,m)
   double precision :: d
   type(c_ptr) :: p
   !local variables
+  integer :: ibuf
   include 'allocate-profile-inc.f90' 
   include 'allocate-ptr-inc.f90'
+  include 'allocate-pool-inc.f90'
   include 'allocate-aligned-inc.f90'
   include 'allocate-simgrid-inc.f90' 
   !allocate the array
@@ -810,6 +812,7 @@ subroutine d1_ptr_free(array)
   double precision, dimension(:), pointer, intent(inout) :: array
   include 'deallocate-profile-inc.f90' 
   if (.not. associated(array)) return
+  include 'deallocate-pool-inc.f90'
   include 'deallocate-ptr-inc.f90'
   nullify(array)
 end subroutine d1_ptr_free
@@ -860,8 +863,10 @@ subroutine d2_ptr(array,m)
   double precision :: d
   type(c_ptr) :: p
   double precision, dimension(:,:), pointer, intent(inout) :: array
+  integer :: ibuf
   include 'allocate-profile-inc.f90'
   include 'allocate-ptr-inc.f90'
+  include 'allocate-pool-inc.f90'
   include 'allocate-aligned-inc.f90'
   include 'allocate-simgrid-inc.f90' 
   !allocate the array
@@ -875,6 +880,7 @@ subroutine d2_ptr_free(array)
   double precision, dimension(:,:), pointer, intent(inout) :: array
   include 'deallocate-profile-inc.f90' 
   if (.not. associated(array)) return
+  include 'deallocate-pool-inc.f90'
   include 'deallocate-ptr-inc.f90'
   nullify(array)
 end subroutine d2_ptr_free
@@ -909,8 +915,10 @@ subroutine d3_ptr(array,m)
   double precision, dimension(:,:,:), pointer, intent(inout) :: array
   double precision :: d
   type(c_ptr) :: p
+  integer :: ibuf
   include 'allocate-profile-inc.f90'
   include 'allocate-ptr-inc.f90' 
+  include 'allocate-pool-inc.f90'
   include 'allocate-aligned-inc.f90'
   include 'allocate-simgrid-inc.f90' 
   !allocate the array
@@ -925,6 +933,7 @@ subroutine d3_ptr_free(array)
   double precision, dimension(:,:,:), pointer, intent(inout) :: array
   include 'deallocate-profile-inc.f90' 
   if (.not. associated(array)) return
+  include 'deallocate-pool-inc.f90'
   include 'deallocate-ptr-inc.f90'
   nullify(array)
 end subroutine d3_ptr_free
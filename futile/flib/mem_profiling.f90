@@ -27,6 +27,11 @@ module memory_profiling
      integer :: memdealloc   !< Number of deallocations recorded
      type(memstat) :: memloc !< State of the memory in the local routine
      type(memstat) :: memtot !< Global state of the memory in profiler instance
+     integer :: poolalloc    !< Number of allocations served by the pool of work arrays
+     integer :: poolreuse    !< Number of them which recycled an existing buffer of the pool
+     integer(kind=8) :: poolsize !< Size of the buffers held by the pool (included in memtot)
+     type(memstat) :: mempool !< Memory of the pool which is in use by the work arrays
+     type(memstat) :: memmark !< Memory at the last mark and highest value reached since (see f_malloc_mark)
   end type memory_state
 
   real :: memorylimit = 0.e0 !< Limit of the memory allowed, in Gb
@@ -89,6 +94,16 @@ contains
           call yaml_map('in the routine',trim(memstate%memtot%routine))
           call yaml_map('Memory Peak of process',proc_peak)
          call yaml_mapping_close()
+         if (memstate%poolalloc > 0) then
+            call yaml_mapping_open('Pool of work arrays')
+             call yaml_map('No. of Allocations',memstate%poolalloc)
+             call yaml_map('Recycled buffers',memstate%poolreuse)
+             call yaml_map('Size of the buffers (MB)',real(memstate%poolsize,kind=8)/1048576d0,fmt="(f15.3)")
+             call yaml_map('Peak Value (MB)',real(memstate%mempool%peak,kind=8)/1048576d0,fmt="(f15.3)")
+             call yaml_map('for the array',trim(memstate%mempool%array))
+             call yaml_map('in the routine',trim(memstate%mempool%routine))
+            call yaml_mapping_close()
+         end if
        call yaml_mapping_close()
     end if
 
@@ -241,6 +256,18 @@ contains
     memstate%memloc%array='array'
     memstate%memloc%memory=f_0 !fake initialisation to print the first routine
     memstate%memloc%peak=f_0
+
+    memstate%poolalloc=f_0
+    memstate%poolreuse=f_0
+    memstate%poolsize=f_0
+    memstate%mempool%memory=f_0
+    memstate%mempool%peak=f_0
+    memstate%mempool%routine=f_0
+    memstate%mempool%array=f_0
+    memstate%memmark%memory=f_0
+    memstate%memmark%peak=f_0
+    memstate%memmark%routine=f_0
+    memstate%memmark%array=f_0
   end subroutine memstate_init
 
 
@@ -265,6 +292,11 @@ contains
        memstate%memtot%routine=routine
        memstate%memtot%array=array
     end if
+    if (memstate%memtot%memory > memstate%memmark%peak) then
+       memstate%memmark%peak=memstate%memtot%memory
+       memstate%memmark%routine=routine
+       memstate%memmark%array=array
+    end if
     if (isize > int(0,kind=8)) then
        memstate%memalloc=memstate%memalloc+1
     else if (isize < int(0,kind=8)) then
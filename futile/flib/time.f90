@@ -13,6 +13,7 @@ module time_profiling
   use f_precisions
   use dictionaries
   use f_utils, only: f_time
+  use f_trace
   implicit none
 
   private 
@@ -52,10 +53,12 @@ module time_profiling
      integer(f_long) :: epoch !<time of the creation of the routine
      double precision :: time0 !<reference time since last checkpoint
      double precision :: t0 !<reference time since last opening action
+     integer(f_long) :: itns0 !<reference time since last opening action, in ns (for the trace)
      double precision, dimension(ncat_max+1) :: clocks       !< timings of different categories
      double precision, dimension(nctr_max) :: counter_clocks !< times of the partial counters
      character(len=10), dimension(nctr_max) :: counter_names !< names of the partial counters, to be assigned
      character(len=128) :: report_file                    !< name of the file to write the report on
+     integer, dimension(0:ncat_max) :: trace_ids          !< ids of the categories in the trace
      type(dictionary), pointer :: dict_timing_categories  !< categories definitions
      type(dictionary), pointer :: dict_timing_groups      !< group definitions
   end type time_ctrl
@@ -87,10 +90,12 @@ module time_profiling
       time%epoch=f_time() !take the initial time
       time%time0=0.d0
       time%t0=0.d0
+      time%itns0=0
       time%clocks=0.d0
       time%counter_clocks=0.d0
       time%counter_names=repeat(' ',len(time%counter_names))
       time%report_file=repeat(' ',len(time%report_file))
+      time%trace_ids=0
       nullify(time%dict_timing_categories)
       nullify(time%dict_timing_groups)
     end subroutine nullify_time_ctrl
@@ -207,6 +212,9 @@ module time_profiling
          call f_err_throw('The number of initialized categories cannot exceed'//&
               trim(yaml_toa(ncat_max))//'. Change ncat_max in profile_time module',&
               err_id=TIMING_INVALID)
+      else
+         !intern the name once, such that the trace only records integers
+         times(ictrl)%trace_ids(cat_id)=f_trace_id(cat_name,TRACE_CATEGORY)
       end if
     end subroutine f_timing_category
 
@@ -546,8 +554,25 @@ module time_profiling
       !restore timing, categories can be manipulated now
       times(ictrl)%time0=0.d0
       times(ictrl)%timing_nctr=0 !no partial counters activated anymore
+
+      !each process writes the timeline of its events next to the report
+      if (f_trace_active) call f_trace_dump(trace_prefix(times(ictrl)%report_file))
     end subroutine f_timing_stop
 
+    !> Prefix of the trace file, obtained by removing the extension of the report file
+    function trace_prefix(report_file) result(prefix)
+      implicit none
+      character(len=*), intent(in) :: report_file
+      character(len=len(report_file)+4) :: prefix
+      !local variables
+      integer :: iext
+
+      prefix=report_file
+      iext=index(report_file,'.yaml',back=.true.)
+      if (iext > 0) prefix(iext:)=' '
+      if (len_trim(prefix) == 0) prefix='time'
+    end function trace_prefix
+
 
     !> The same timing routine but with system_clock (in case of a supported specs)
     subroutine f_timing(cat_id,action)
@@ -588,6 +613,7 @@ module time_profiling
          !if some other category was initalized before, return (no action)
          if (times(ictrl)%cat_on /= 0) return
          times(ictrl)%t0=real(itns,kind=8)*1.d-9
+         times(ictrl)%itns0=itns
          times(ictrl)%cat_on=cat_id !category which has been activated
         !catname=f_malloc((/1.to.128/), id="catname")
         call get_category_name(cat_id, catname)
@@ -606,6 +632,7 @@ module time_profiling
             t1=real(itns,kind=8)*1.d-9
             times(ictrl)%clocks(cat_id)=times(ictrl)%clocks(cat_id)+&
                  t1-times(ictrl)%t0
+            if (f_trace_active) call trace_category_event(cat_id,itns)
             times(ictrl)%cat_on=0
          call nvtxrangepop();
             !call Extrae_event(6000019,0)
@@ -627,12 +654,14 @@ module time_profiling
             !stop the active counter
             times(ictrl)%clocks(times(ictrl)%cat_on)=&
                  times(ictrl)%clocks(times(ictrl)%cat_on)+t1-times(ictrl)%t0
+            if (f_trace_active) call trace_category_event(times(ictrl)%cat_on,itns)
             times(ictrl)%cat_paused=times(ictrl)%cat_on
          else
             times(ictrl)%cat_paused=-1 !start by pausing
          end if
          times(ictrl)%cat_on=cat_id
          times(ictrl)%t0=t1
+         times(ictrl)%itns0=itns
          call get_category_name(cat_id, catname)
          call nvtxrangepusha(catname//CHAR(0));
 
@@ -650,10 +679,12 @@ module time_profiling
          t1=real(itns,kind=8)*1.d-9
          times(ictrl)%clocks(cat_id)=times(ictrl)%clocks(cat_id)+&
               t1-times(ictrl)%t0
+         if (f_trace_active) call trace_category_event(cat_id,itns)
          !restore normal counter
          if (times(ictrl)%cat_paused/=-1) then
             times(ictrl)%cat_on=times(ictrl)%cat_paused
             times(ictrl)%t0=t1
+            times(ictrl)%itns0=itns
          else
             times(ictrl)%cat_on=0
          end if
@@ -673,10 +704,12 @@ module time_profiling
          times(ictrl)%clocks(times(ictrl)%cat_on)=&
               times(ictrl)%clocks(times(ictrl)%cat_on)+&
               t1-times(ictrl)%t0
+         if (f_trace_active) call trace_category_event(times(ictrl)%cat_on,itns)
          !restore normal counter
          if (times(ictrl)%cat_paused/=-1) then
             times(ictrl)%cat_on=times(ictrl)%cat_paused
             times(ictrl)%t0=t1
+            times(ictrl)%itns0=itns
          else
             times(ictrl)%cat_on=0
          end if
@@ -689,6 +722,15 @@ module time_profiling
 
     END SUBROUTINE f_timing
 
+    !> Record in the trace the activity of the category since the last opening action
+    subroutine trace_category_event(cat_id,itns)
+      implicit none
+      integer, intent(in) :: cat_id
+      integer(f_long), intent(in) :: itns
+      if (cat_id < 0 .or. cat_id > ncat_max) return
+      call f_trace_event(times(ictrl)%trace_ids(cat_id),times(ictrl)%itns0,itns)
+    end subroutine trace_category_event
+
 
     !> Opens the file of the timing unit
     subroutine timing_open_stream(iunit_def)
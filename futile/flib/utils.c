@@ -103,6 +103,38 @@ void FC_FUNC(getaddress, GETADDRESS)(void *ptr,char *address, int *lgaddress,
   //return;
 }
 
+/* Representation of x in the %e format with the fewest significant digits, from ndig_min
+   to ndig_max, which is read back identically (as a float if single is not zero).
+   The representation with ndig_max digits is always read back identically.
+   Only the correctly rounded candidates are tried, so this is not a shortest-digits
+   algorithm (Ryu, Grisu) below ndig_max. */
+void FC_FUNC(roundtripetoa, ROUNDTRIPETOA)(const double *x, const int *single,
+                                           const int *ndig_min, const int *ndig_max,
+                                           char *str, int *lgstr)
+{
+  char buff[50];
+  int ndig, lgt;
+
+  memset(str, ' ', sizeof(char) * (*lgstr));
+
+  lgt = 0;
+  for (ndig = *ndig_min; ndig <= *ndig_max; ndig++)
+    {
+      lgt = snprintf(buff, sizeof(buff), "%.*e", ndig - 1, *x);
+      if (ndig == *ndig_max)
+        break;
+      if (*single)
+        {
+          if (strtof(buff, NULL) == (float)*x)
+            break;
+        }
+      else if (strtod(buff, NULL) == *x)
+        break;
+    }
+  if (lgt < *lgstr)
+    memcpy(str, buff, sizeof(char) * lgt);
+}
+
 void FC_FUNC(getdir, GETDIR)(const char *dir, int *lgDir,
                              char *out, int *lgOut,
                              int *status)
@@ -14,11 +14,29 @@
   character(len=*), optional, intent(in) :: label,advance,fmt
   integer, optional, intent(in) :: unit
   !local variables
-  integer :: msg_lgt,strm,nl,nu,tmp_lgt,i,il,icursor
+  integer :: msg_lgt,strm,nl,nu,tmp_lgt,i,il,buf_lgt
   character(len=tot_max_record_length) :: towrite
+  character(len=:), allocatable :: buf
 
   strm=stream_id(unit=unit)
 
+  !large numeric arrays might go in the binary side-car file of the stream
+  if (binary_sidecar(streams(strm),binary_type,size(mapvalue))) then
+     write(streams(strm)%binary_unit) mapvalue
+     call yaml_map_sidecar(mapname,binary_type,shape(mapvalue),label,advance,unit)
+     return
+  end if
+
+  !or be formatted by the streaming emitter
+  if (stream_array(streams(strm),binary_type)) then
+     buf_lgt=0
+     do i=lbound(mapvalue,1),ubound(mapvalue,1)
+        call buffer_element(buf,buf_lgt,trim(array_element_toa(mapvalue(i),fmt=fmt)))
+     end do
+     call yaml_map_array_buffer(mapname,buf,buf_lgt,label,advance,unit)
+     return
+  end if
+
   nl=lbound(mapvalue,1)
   nu=ubound(mapvalue,1)
 
@@ -41,6 +59,8 @@
         !template of an element
         tmp_lgt=tmp_lgt+len_trim(yaml_toa(mapvalue(il),fmt=fmt))
         tmp_lgt=tmp_lgt+3 !comma and spaces
+        !no need to format the other elements if the line is already too long
+        if (tmp_lgt > streams(strm)%max_record_length) exit
      end do
      !     tmp_lgt=tmp_lgt*(nu-nl)
      !print *,'debug',max(streams(strm)%icursor+msg_lgt+1,streams(strm)%tabref)+tmp_lgt,&
@@ -50,8 +70,6 @@
         !implement the writing explicitly per element
         call yaml_sequence_open(mapname,flow=.true.,unit=unit)
         do i=nl,nu
-         call yaml_stream_attributes(icursor=icursor)
-         !print *,'i,icursor',i,icursor
          call yaml_sequence(trim(yaml_toa(mapvalue(i),fmt=fmt)),unit=unit)
         end do
         call yaml_sequence_close(unit=unit)
@@ -13,7 +13,31 @@
   character(len=*), optional, intent(in) :: label,advance,fmt
   integer, optional, intent(in) :: unit
   !Local variables
-  integer :: irow,icol
+  integer :: irow,icol,strm,buf_lgt
+  character(len=:), allocatable :: buf
+
+  !large numeric matrices might go in the binary side-car file of the stream
+  strm=stream_id(unit=unit)
+  if (binary_sidecar(streams(strm),binary_type,size(mapvalue))) then
+     write(streams(strm)%binary_unit) mapvalue
+     call yaml_map_sidecar(mapname,binary_type,shape(mapvalue),label,advance,unit)
+     return
+  end if
+
+  !or be formatted by the streaming emitter, one flow sequence per row
+  if (stream_array(streams(strm),binary_type)) then
+     call yaml_sequence_open(mapname,label=label,unit=unit)
+     do irow=lbound(mapvalue,2),ubound(mapvalue,2)
+        buf_lgt=0
+        do icol=lbound(mapvalue,1),ubound(mapvalue,1)
+           call buffer_element(buf,buf_lgt,trim(array_element_toa(mapvalue(icol,irow),fmt=fmt)))
+        end do
+        call yaml_sequence(advance='no',unit=unit)
+        call dump_array_buffer(streams(strm),buf,buf_lgt,.false.,streams(strm)%icursor)
+     end do
+     call yaml_sequence_close(advance=advance,unit=unit)
+     return
+  end if
 
   !open the sequence associated to the matrix
   call yaml_sequence_open(mapname,label=label,advance=advance,unit=unit)
@@ -39,6 +39,10 @@ module yaml_output
   integer, parameter :: tot_streams=10             !< Max total number of streams
   integer, parameter :: tab=5                      !< Default number for tabbing
 
+  !> Styles of the streaming emitter of the numeric arrays (see yaml_set_stream)
+  integer, parameter :: ARRAY_STYLE_NONE=0,ARRAY_STYLE_FLOW=1,ARRAY_STYLE_BLOCK=2
+  integer, parameter :: max_element_length=95 !< Maximum length of an element formatted by the streaming emitter
+
   integer :: active_streams=0  !< Number of active streams (stdout always active after init)
   integer :: default_stream=1  !< Id of the default stream
 
@@ -68,6 +72,11 @@ module yaml_output
      !character(len=tot_max_record_length), dimension(:), pointer :: buffer !<
      !> papers which are cited in the stream
      type(dictionary), pointer :: dict_references=>null()
+     integer :: binary_threshold=0      !< Numeric arrays of more elements go to the binary side-car file (0: never)
+     integer :: binary_unit=0           !< Unit of the side-car file (0 if not yet opened)
+     integer :: binary_records=0        !< Number of arrays written in the side-car file
+     character(len=128) :: binary_file=' ' !< Name of the side-car file
+     integer :: array_style=ARRAY_STYLE_NONE !< Style of the streaming emitter of the numeric arrays (none: not used)
   end type yaml_stream
 
   type(yaml_stream), dimension(tot_streams), save :: streams    !< Private array containing the streams
@@ -107,6 +116,12 @@ module yaml_output
      module procedure yaml_warning_c,yaml_warning_str
   end interface
 
+  !> Formatting of an element of an array for the streaming emitter
+  interface array_element_toa
+     module procedure array_element_toa_d,array_element_toa_r,array_element_toa_i,array_element_toa_li
+     module procedure array_element_toa_c,array_element_toa_l
+  end interface
+
   interface yaml_comment
      module procedure yaml_comment_c,yaml_comment_str
   end interface
@@ -200,6 +215,11 @@ contains
     type(yaml_stream), intent(inout) :: strm
     call reset_document_in_stream(strm)
     nullify(strm%dict_references)
+    strm%binary_threshold=0
+    strm%binary_unit=0
+    strm%binary_records=0
+    strm%binary_file=' '
+    strm%array_style=ARRAY_STYLE_NONE
   end subroutine nullify_stream
   pure subroutine reset_document_in_stream(strm)
     implicit none
@@ -389,8 +409,9 @@ contains
 
   !> Set all the output from now on to the file indicated by stdout
   !! therefore the default stream is now the one indicated by unit
-  subroutine yaml_set_stream(unit,filename,istat,tabbing,record_length,position,setdefault)
-    use f_utils, only: f_utils_recl,f_get_free_unit,f_open_file
+  subroutine yaml_set_stream(unit,filename,istat,tabbing,record_length,position,setdefault,&
+       binary_threshold,array_style)
+    use f_utils, only: f_utils_recl,f_get_free_unit,f_open_file,f_close
     implicit none
     integer, optional, intent(in) :: unit  !< File unit specified by the user.(by default 6) Returns a error code if the unit
     !! is not 6 and it has already been opened by the processor
@@ -404,6 +425,14 @@ contains
     integer, optional, intent(out) :: istat
     logical, optional, intent(in) :: setdefault        !< decide if the new stream will be set as default stream. True if absent
     !! it is up the the user to deal with error signals sent by istat
+    !> Numeric arrays of more than binary_threshold elements are not written in the stream
+    !! but in a binary side-car file, which is referenced in the stream (0: never, default).
+    !! Setting it back to 0 closes the side-car file, the following arrays are appended to it
+    integer, optional, intent(in) :: binary_threshold
+    !> Numeric vectors and matrices are formatted by a streaming emitter, in 'flow' ([a, b]) or 'block'
+    !! (one "- a" per line) style, with a short representation of the floats which is read back
+    !! identically, unless a fmt is given to yaml_map ('none': usual yaml_toa formatting, default)
+    character(len=*), optional, intent(in) :: array_style
 
     !local variables
     integer, parameter :: NO_ERRORS = 0
@@ -547,6 +576,23 @@ contains
        if (recl_file<=0) recl_file=record_length!int(record_length,kind=8)
        streams(istream)%max_record_length=recl_file!int(min(int(record_length,kind=8),recl_file))
     end if
+    if (present(binary_threshold)) then
+       streams(istream)%binary_threshold=binary_threshold
+       if (binary_threshold <= 0 .and. streams(istream)%binary_unit /= 0) then
+          call f_close(streams(istream)%binary_unit)
+          streams(istream)%binary_unit=0
+       end if
+    end if
+    if (present(array_style)) then
+       select case(trim(array_style))
+       case('flow')
+          streams(istream)%array_style=ARRAY_STYLE_FLOW
+       case('block')
+          streams(istream)%array_style=ARRAY_STYLE_BLOCK
+       case default
+          streams(istream)%array_style=ARRAY_STYLE_NONE
+       end select
+    end if
   end subroutine yaml_set_stream
 
 
@@ -708,6 +754,7 @@ contains
   !> close one stream and free its place
   !! should this stream be the default stream, stdout becomes the default
   subroutine yaml_close_stream(unit,istat)
+    use f_utils, only: f_close
     implicit none
     integer, optional, intent(in) :: unit   !< @copydoc doc::unit
     integer, optional, intent(out) :: istat !<error code, zero if suceeded
@@ -745,6 +792,7 @@ contains
 
     !close files which are not stdout and remove them from stream_files
     if (unt /= 6) close(unt)
+    if (streams(strm)%binary_unit /= 0) call f_close(streams(strm)%binary_unit)
     iter => dict_iter(stream_files)
     do while (associated(iter))
        funt = iter
@@ -804,6 +852,7 @@ contains
   !> Close all the streams of all opened units
   !! The module will come back to its initial status
   subroutine yaml_close_all_streams()
+    use f_utils, only: f_close
     implicit none
 
     !local variables
@@ -818,6 +867,8 @@ contains
        else
           call yaml_purge_references(unit=unt)
           call yaml_release_document(unit=unt)
+          if (streams(istream)%binary_unit /= 0) call f_close(streams(istream)%binary_unit)
+          streams(istream)%binary_unit=0
        end if
     end do
     call dict_free(stream_files)
@@ -2433,6 +2484,353 @@ contains
     call yaml_mapping_close(unit=unit)
   end subroutine yaml_map_enum
 
+  !> Decide if the numeric array of n elements has to be written in the binary side-car file
+  !! of the stream, which is opened at the first usage.
+  !! Arrays of non-numeric types (empty binary_type) always go in the stream
+  function binary_sidecar(stream,binary_type,n) result(ok)
+    use f_utils, only: f_open_file
+    implicit none
+    type(yaml_stream), intent(inout) :: stream
+    character(len=*), intent(in) :: binary_type
+    integer, intent(in) :: n
+    logical :: ok
+    !local variables
+    integer :: unt
+    character(len=128) :: stream_out
+
+    ok=stream%binary_threshold > 0 .and. len(binary_type) > 0 .and. n > stream%binary_threshold
+    if (.not. ok .or. stream%binary_unit /= 0) return
+
+    call get_stream_filename(stream%unit,stream_out)
+    if (trim(stream_out) == 'stdout') then
+       stream%binary_file='arrays.bin'
+    else
+       stream%binary_file=stream_out
+       call rstrip(stream%binary_file,'.yaml')
+       stream%binary_file=trim(stream%binary_file)//'-arrays.bin'
+    end if
+    unt=98
+    if (stream%binary_records == 0) then
+       call f_open_file(unt,trim(stream%binary_file),status='replace',binary=.true.)
+    else
+       !the side-car has been closed by yaml_set_stream, keep the numbering of the records
+       call f_open_file(unt,trim(stream%binary_file),position='append',binary=.true.)
+    end if
+    stream%binary_unit=unt
+  end function binary_sidecar
+
+  !> Reference in the stream the array which has just been written in the binary side-car file.
+  !! Each array is a (Fortran unformatted) record of the file, in column-major order
+  subroutine yaml_map_sidecar(mapname,binary_type,shp,label,advance,unit)
+    implicit none
+    character(len=*), intent(in) :: mapname,binary_type
+    integer, dimension(:), intent(in) :: shp
+    character(len=*), optional, intent(in) :: label,advance
+    integer, optional, intent(in) :: unit
+    !local variables
+    integer :: strm
+
+    strm=stream_id(unit=unit)
+    streams(strm)%binary_records=streams(strm)%binary_records+1
+    call yaml_mapping_open(mapname,label=label,flow=.true.,unit=unit)
+    call yaml_map('Binary file',trim(streams(strm)%binary_file),unit=unit)
+    call yaml_map('Record',streams(strm)%binary_records,unit=unit)
+    call yaml_map('Type',binary_type,unit=unit)
+    call yaml_map('Shape',trim(yaml_toa(shp)),unit=unit)
+    call yaml_mapping_close(advance=advance,unit=unit)
+  end subroutine yaml_map_sidecar
+
+  !> Decide if the array has to be written by the streaming emitter of the stream.
+  !! This is only done for numeric arrays (non-empty binary_type) outside of a flow
+  function stream_array(stream,binary_type) result(ok)
+    implicit none
+    type(yaml_stream), intent(in) :: stream
+    character(len=*), intent(in) :: binary_type
+    logical :: ok
+
+    ok=stream%array_style /= ARRAY_STYLE_NONE .and. len(binary_type) > 0 .and. .not. stream%flowrite
+  end function stream_array
+
+  !> Append an element to the growable buffer buf(1:lgt) of the streaming emitter.
+  !! Each element is followed by a comma, the capacity of the buffer is doubled when needed
+  subroutine buffer_element(buf,lgt,element)
+    implicit none
+    character(len=:), allocatable, intent(inout) :: buf
+    integer, intent(inout) :: lgt
+    character(len=*), intent(in) :: element
+    !local variables
+    character(len=:), allocatable :: tmp
+
+    if (.not. allocated(buf)) allocate(character(len=max(1024,2*len(element)+2)) :: buf)
+    if (lgt+len(element)+1 > len(buf)) then
+       allocate(character(len=max(2*len(buf),lgt+len(element)+1)) :: tmp)
+       tmp(1:lgt)=buf(1:lgt)
+       call move_alloc(tmp,buf)
+    end if
+    buf(lgt+1:lgt+len(element))=element
+    lgt=lgt+len(element)+1
+    buf(lgt:lgt)=','
+  end subroutine buffer_element
+
+  !> Write the key of a numeric vector and its elements stored in the buffer of the streaming emitter
+  subroutine yaml_map_array_buffer(mapname,buf,lgt,label,advance,unit)
+    implicit none
+    character(len=*), intent(in) :: mapname
+    character(len=*), intent(in) :: buf
+    integer, intent(in) :: lgt
+    character(len=*), optional, intent(in) :: label,advance
+    integer, optional, intent(in) :: unit
+    !local variables
+    logical :: lblock
+    integer :: strm,msg_lgt,icol
+    character(len=tot_max_record_length) :: towrite
+
+    strm=stream_id(unit=unit)
+    !column of the continuation lines, inside the key
+    if (streams(strm)%icursor == 1) then
+       icol=streams(strm)%indent+2
+    else
+       icol=streams(strm)%icursor+1
+    end if
+
+    msg_lgt=0
+    call buffer_string(towrite,len(towrite),trim(mapname),msg_lgt)
+    call buffer_string(towrite,len(towrite),':',msg_lgt)
+    if (present(label)) then
+       call buffer_string(towrite,len(towrite),' &',msg_lgt)
+       call buffer_string(towrite,len(towrite),trim(label),msg_lgt)
+    end if
+    lblock=streams(strm)%array_style == ARRAY_STYLE_BLOCK .and. lgt > 0
+    if (.not. lblock) call buffer_string(towrite,len(towrite),' ',msg_lgt)
+    call dump(streams(strm),towrite(1:msg_lgt),advance='no',event=MAPPING)
+    call dump_array_buffer(streams(strm),buf,lgt,lblock,icol,advance)
+  end subroutine yaml_map_array_buffer
+
+  !> Write the elements of the buffer buf(1:lgt) of the streaming emitter after what has just been
+  !! dumped without advancing (the key or the dash of a sequence, with its trailing blank in flow style).
+  !! In flow style the lines are filled up to the record length of the stream,
+  !! in block style each element has its own line. The lines continue at the column icol.
+  !! Nothing is done per element apart from the copy of the buffer in the line
+  subroutine dump_array_buffer(stream,buf,lgt,lblock,icol,advance)
+    implicit none
+    type(yaml_stream), intent(inout) :: stream
+    character(len=*), intent(in) :: buf
+    integer, intent(in) :: lgt,icol
+    logical, intent(in) :: lblock
+    character(len=*), optional, intent(in) :: advance
+    !local variables
+    logical :: ladv
+    integer :: ist,iend,icursor
+
+    ladv=.true.
+    if (present(advance)) ladv=trim(advance) /= 'no'
+
+    icursor=stream%icursor
+    if (lgt == 0) then
+       write(stream%unit,'(a)',advance='no') '[]'
+       icursor=icursor+2
+    else if (lblock) then
+       ist=1
+       do while (ist < lgt)
+          iend=ist+index(buf(ist:lgt),',')-2
+          write(stream%unit,'(a)')
+          write(stream%unit,'(a)',advance='no') repeat(' ',icol)//'- '//buf(ist:iend)
+          icursor=icol+3+iend-ist+1
+          ist=iend+2
+       end do
+    else
+       write(stream%unit,'(a)',advance='no') '['
+       icursor=icursor+1
+       ist=1
+       do while (ist < lgt)
+          iend=ist+index(buf(ist:lgt),',')-2
+          !the element and its separator have to enter in the line
+          if (icursor > icol+2 .and. icursor+iend-ist+3 > stream%max_record_length) then
+             write(stream%unit,'(a)')
+             write(stream%unit,'(a)',advance='no') repeat(' ',icol)
+             icursor=icol+1
+          end if
+          if (iend+1 < lgt) then
+             write(stream%unit,'(a)',advance='no') buf(ist:iend+1)//' '
+             icursor=icursor+iend-ist+3
+          else
+             write(stream%unit,'(a)',advance='no') buf(ist:iend)//']'
+             icursor=icursor+iend-ist+2
+          end if
+          ist=iend+2
+       end do
+    end if
+
+    if (ladv) then
+       write(stream%unit,'(a)')
+       stream%icursor=1
+    else
+       stream%icursor=icursor
+    end if
+  end subroutine dump_array_buffer
+
+  !> Representation of x which is read back identically, with few digits.
+  !! The candidates of 15 (i.e. DBL_DIG), 16 and 17 digits are written and read back in C
+  !! (roundtripetoa in utils.c), which is much faster than the Fortran internal i/o.
+  !! This is not a shortest-digits algorithm like Ryu or Grisu: at 15 digits the result is
+  !! the shortest representation once the trailing zeros are removed, but in the 16 and 17 digits
+  !! cases it might be one digit longer than the shortest one, as well as for the subnormal numbers
+  function roundtrip_toa_d(x) result(str)
+    implicit none
+    real(f_double), intent(in) :: x
+    character(len=32) :: str
+    !local variables
+    character(len=32) :: tmp
+    external :: roundtripetoa
+
+    if (x /= x) then
+       str='.nan'
+    else if (abs(x) > huge(x)) then
+       str=merge('.inf ','-.inf',x > 0.0_f_double)
+    else if (x == 0.0_f_double) then
+       str=merge('-0.0','0.0 ',sign(1.0_f_double,x) < 0.0_f_double)
+    else
+       call roundtripetoa(x,0,15,17,tmp,len(tmp))
+       str=decimal_toa(tmp)
+    end if
+  end function roundtrip_toa_d
+
+  !> Representation of x which is read back identically as a single precision float,
+  !! with the 6 (i.e. FLT_DIG) to 9 digits candidates, as roundtrip_toa_d
+  !! with candidates of 6 (i.e. FLT_DIG) to 9 digits
+  function roundtrip_toa_r(x) result(str)
+    implicit none
+    real(f_simple), intent(in) :: x
+    character(len=32) :: str
+    !local variables
+    character(len=32) :: tmp
+    external :: roundtripetoa
+
+    if (x /= x) then
+       str='.nan'
+    else if (abs(x) > huge(x)) then
+       str=merge('.inf ','-.inf',x > 0.0_f_simple)
+    else if (x == 0.0_f_simple) then
+       str=merge('-0.0','0.0 ',sign(1.0_f_simple,x) < 0.0_f_simple)
+    else
+       call roundtripetoa(real(x,f_double),1,6,9,tmp,len(tmp))
+       str=decimal_toa(tmp)
+    end if
+  end function roundtrip_toa_r
+
+  !> YAML float of the %e representation es (d.dddde+ee), without trailing zeros
+  !! and in positional notation for exponents between -4 and 15
+  pure function decimal_toa(es) result(str)
+    implicit none
+    character(len=*), intent(in) :: es
+    character(len=32) :: str
+    !local variables
+    logical :: neg
+    integer :: i,ie,iexp,nd
+    character(len=32) :: digits,res
+    character(len=len(es)+1) :: expo
+
+    i=verify(es,' ')
+    neg= es(i:i) == '-'
+    if (neg) i=i+1
+    ie=index(es,'e')
+    digits=es(i:i)//es(i+2:ie-1)
+    iexp=0
+    do i=ie+2,len_trim(es)
+       iexp=10*iexp+ichar(es(i:i))-ichar('0')
+    end do
+    if (es(ie+1:ie+1) == '-') iexp=-iexp
+    nd=len_trim(digits)
+    do while (nd > 1 .and. digits(nd:nd) == '0')
+       nd=nd-1
+    end do
+
+    if (iexp >= 0 .and. iexp < 16) then
+       if (nd <= iexp+1) then
+          res=digits(1:nd)//repeat('0',iexp+1-nd)//'.0'
+       else
+          res=digits(1:iexp+1)//'.'//digits(iexp+2:nd)
+       end if
+    else if (iexp < 0 .and. iexp >= -4) then
+       res='0.'//repeat('0',-iexp-1)//digits(1:nd)
+    else
+       !exponent of es without the plus sign and the leading zeros
+       i=verify(es(ie+2:),'0')+ie+1
+       if (iexp < 0) then
+          expo='-'//es(i:len_trim(es))
+       else
+          expo=es(i:len_trim(es))
+       end if
+       if (nd == 1) then
+          res=digits(1:1)//'.0e'//trim(expo)
+       else
+          res=digits(1:1)//'.'//digits(2:nd)//'e'//trim(expo)
+       end if
+    end if
+    if (neg) then
+       str='-'//trim(res)
+    else
+       str=res
+    end if
+  end function decimal_toa
+
+  function array_element_toa_d(x,fmt) result(str)
+    implicit none
+    real(f_double), intent(in) :: x
+    character(len=*), optional, intent(in) :: fmt
+    character(len=max_element_length) :: str
+    if (present(fmt)) then
+       str=adjustl(yaml_toa(x,fmt=fmt))
+    else
+       str=roundtrip_toa_d(x)
+    end if
+  end function array_element_toa_d
+
+  function array_element_toa_r(x,fmt) result(str)
+    implicit none
+    real(f_simple), intent(in) :: x
+    character(len=*), optional, intent(in) :: fmt
+    character(len=max_element_length) :: str
+    if (present(fmt)) then
+       str=adjustl(yaml_toa(x,fmt=fmt))
+    else
+       str=roundtrip_toa_r(x)
+    end if
+  end function array_element_toa_r
+
+  function array_element_toa_i(x,fmt) result(str)
+    implicit none
+    integer(f_integer), intent(in) :: x
+    character(len=*), optional, intent(in) :: fmt
+    character(len=max_element_length) :: str
+    str=adjustl(yaml_toa(x,fmt=fmt))
+  end function array_element_toa_i
+
+  function array_element_toa_li(x,fmt) result(str)
+    implicit none
+    integer(f_long), intent(in) :: x
+    character(len=*), optional, intent(in) :: fmt
+    character(len=max_element_length) :: str
+    str=adjustl(yaml_toa(x,fmt=fmt))
+  end function array_element_toa_li
+
+  !> Non-numeric arrays are not written by the streaming emitter, only for the generic template
+  function array_element_toa_c(x,fmt) result(str)
+    implicit none
+    character(len=*), intent(in) :: x
+    character(len=*), optional, intent(in) :: fmt
+    character(len=max_element_length) :: str
+    str=adjustl(yaml_toa(x,fmt=fmt))
+  end function array_element_toa_c
+
+  function array_element_toa_l(x,fmt) result(str)
+    implicit none
+    logical, intent(in) :: x
+    character(len=*), optional, intent(in) :: fmt
+    character(len=max_element_length) :: str
+    str=adjustl(yaml_toa(x,fmt=fmt))
+  end function array_element_toa_l
+
   subroutine yaml_map_li(mapname,mapvalue,label,advance,unit,fmt)
     implicit none
     integer(f_long), intent(in) :: mapvalue
@@ -2466,12 +2864,14 @@ contains
   subroutine yaml_map_dv(mapname,mapvalue,label,advance,unit,fmt)
     implicit none
     real(f_double), dimension(:), intent(in) :: mapvalue
+    character(len=*), parameter :: binary_type='float64'
     include 'yaml_map-arr-inc.f90'
   end subroutine yaml_map_dv
 
   subroutine yaml_map_rv(mapname,mapvalue,label,advance,unit,fmt)
     implicit none
     real(f_simple), dimension(:), intent(in) :: mapvalue
+    character(len=*), parameter :: binary_type='float32'
     include 'yaml_map-arr-inc.f90'
   end subroutine yaml_map_rv
 
@@ -2480,24 +2880,28 @@ contains
   subroutine yaml_map_cv(mapname,mapvalue,label,advance,unit,fmt)
     implicit none
     character(len=*), dimension(:), intent(in) :: mapvalue
+    character(len=*), parameter :: binary_type=''
     include 'yaml_map-arr-inc.f90'
   end subroutine yaml_map_cv
 
   subroutine yaml_map_lv(mapname,mapvalue,label,advance,unit,fmt)
     implicit none
     logical, dimension(:), intent(in) :: mapvalue
+    character(len=*), parameter :: binary_type=''
     include 'yaml_map-arr-inc.f90'
   end subroutine yaml_map_lv
 
   subroutine yaml_map_liv(mapname,mapvalue,label,advance,unit,fmt)
     implicit none
     integer(f_long), dimension(:), intent(in) :: mapvalue
+    character(len=*), parameter :: binary_type='int64'
     include 'yaml_map-arr-inc.f90'
   end subroutine yaml_map_liv
 
   subroutine yaml_map_iv(mapname,mapvalue,label,advance,unit,fmt)
     implicit none
     integer(f_integer), dimension(:), intent(in) :: mapvalue
+    character(len=*), parameter :: binary_type='int32'
     include 'yaml_map-arr-inc.f90'
   end subroutine yaml_map_iv
 
@@ -2505,24 +2909,28 @@ contains
   subroutine yaml_map_dm(mapname,mapvalue,label,advance,unit,fmt)
     implicit none
     real(f_double), dimension(:,:), intent(in) :: mapvalue
+    character(len=*), parameter :: binary_type='float64'
     include 'yaml_map-mat-inc.f90'
   end subroutine yaml_map_dm
 
   subroutine yaml_map_rm(mapname,mapvalue,label,advance,unit,fmt)
     implicit none
     real(f_simple), dimension(:,:), intent(in) :: mapvalue
+    character(len=*), parameter :: binary_type='float32'
     include 'yaml_map-mat-inc.f90'
   end subroutine yaml_map_rm
 
   subroutine yaml_map_im(mapname,mapvalue,label,advance,unit,fmt)
     implicit none
     integer(f_integer), dimension(:,:), intent(in) :: mapvalue
+    character(len=*), parameter :: binary_type='int32'
     include 'yaml_map-mat-inc.f90'
   end subroutine yaml_map_im
 
   subroutine yaml_map_lm(mapname,mapvalue,label,advance,unit,fmt)
     implicit none
     logical, dimension(:,:), intent(in) :: mapvalue
+    character(len=*), parameter :: binary_type=''
     include 'yaml_map-mat-inc.f90'
   end subroutine yaml_map_lm
 
@@ -2534,7 +2942,14 @@ contains
     character(len=*), optional, intent(in) :: label,advance,fmt
     integer, optional, intent(in) :: unit
     !Local variables
-    integer :: irow,icol,ivec
+    integer :: irow,icol,ivec,strm
+
+    strm=stream_id(unit=unit)
+    if (binary_sidecar(streams(strm),'float64',size(mapvalue))) then
+       write(streams(strm)%binary_unit) mapvalue
+       call yaml_map_sidecar(mapname,'float64',shape(mapvalue),label,advance,unit)
+       return
+    end if
 
     !open the sequence associated to the matrix
     call yaml_sequence_open(mapname,label=label,unit=unit)
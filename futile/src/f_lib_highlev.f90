@@ -92,6 +92,7 @@ subroutine f_lib_initialize()
   use dynamic_memory, only: f_malloc_initialize
   use time_profiling, only: f_timing_initialize
   use f_bibliography, only: f_bib_initialize
+  use f_trace, only: f_trace_initialize
   implicit none
 
   call f_environment_acquire()
@@ -106,6 +107,8 @@ subroutine f_lib_initialize()
   call initialize_flib_timing_categories()
   !initialization of bibliography database
   call f_bib_initialize()
+  !timeline of the routines and categories, if required
+  call f_trace_initialize(f_trace_events)
 
 end subroutine f_lib_initialize
 
@@ -132,6 +135,7 @@ subroutine f_lib_finalize()
   use f_utils, only: f_humantime
   use module_f_objects, only: f_object_finalize
   use f_bibliography, only: f_bib_finalize
+  use f_trace, only: f_trace_finalize
   implicit none
   !local variables
   integer :: ndict,ndict_max,iproc,nlibs,nlibs_max
@@ -151,6 +155,7 @@ subroutine f_lib_finalize()
   call yaml_parse_errors_finalize()
   call f_err_finalize()
   call f_timing_finalize()
+  call f_trace_finalize()
   !debug, once again
   call dictionary_check_leak()
 
@@ -165,6 +170,7 @@ subroutine f_lib_finalize_noreport()
   use yaml_parse, only: yaml_parse_errors_finalize
   use time_profiling, only: f_timing_finalize
   use f_bibliography, only: f_bib_finalize
+  use f_trace, only: f_trace_finalize
   implicit none
   call f_malloc_finalize(dump=.false.)
   call yaml_close_all_streams()
@@ -172,6 +178,7 @@ subroutine f_lib_finalize_noreport()
   call yaml_parse_errors_finalize()
   call f_err_finalize()
   call f_timing_finalize()
+  call f_trace_finalize()
 end subroutine f_lib_finalize_noreport
 
 !> Some constants about Futile.
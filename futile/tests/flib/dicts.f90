@@ -1040,3 +1040,71 @@ subroutine profile_dictionary_usage()
 
 
 end subroutine profile_dictionary_usage
+
+
+!> Micro-benchmark of the basic operations (set, //, dict_iter and remove) on a mapping
+!! of increasing size, to verify that their cost per key does not grow with the size
+!! once the keys are searched through the hash index
+subroutine profile_dictionary_operations()
+  use dictionaries
+  use f_utils
+  use yaml_output
+  use yaml_strings
+  implicit none
+  !local variables
+  integer :: nkeys,ikey,ival,isum,nfound
+  integer(kind=8) :: t0,t1,t2,t3,t4
+  type(dictionary), pointer :: dict,iter
+  character(len=16), dimension(:), allocatable :: keys
+
+  nkeys=16
+  do while(nkeys <= 16384)
+     !the keys are prepared before, not to time their conversion
+     allocate(keys(nkeys))
+     do ikey=1,nkeys
+        keys(ikey)='Key'//trim(yaml_toa(ikey))
+     end do
+     call dict_init(dict)
+     t0=f_time()
+     do ikey=1,nkeys
+        call set(dict//trim(keys(ikey)),ikey)
+     end do
+     t1=f_time()
+     isum=0
+     do ikey=nkeys,1,-1
+        ival=dict//trim(keys(ikey))
+        isum=isum+ival
+     end do
+     t2=f_time()
+     nfound=0
+     iter => dict_iter(dict)
+     do while(associated(iter))
+        nfound=nfound+1
+        iter => dict_next(iter)
+     end do
+     t3=f_time()
+     !remove the odd keys, the remaining ones have to be found
+     do ikey=1,nkeys,2
+        call dict_remove(dict,trim(keys(ikey)))
+     end do
+     t4=f_time()
+     do ikey=2,nkeys,2
+        if (trim(keys(ikey)) .in. dict) isum=isum-ikey
+     end do
+     do ikey=1,nkeys,2
+        if (trim(keys(ikey)) .in. dict) isum=isum+ikey
+     end do
+     call yaml_mapping_open('Timings for dict operations',flow=.true.)
+     call yaml_map('No. of keys',nkeys)
+     call yaml_map('set (ns)',dble(t1-t0)/dble(nkeys),fmt='(f12.1)')
+     call yaml_map('get (ns)',dble(t2-t1)/dble(nkeys),fmt='(f12.1)')
+     call yaml_map('iter (ns)',dble(t3-t2)/dble(nkeys),fmt='(f12.1)')
+     call yaml_map('remove (ns)',dble(t4-t3)/dble(nkeys/2),fmt='(f12.1)')
+     call yaml_mapping_close()
+     call yaml_map('Dictionary operations check',[nfound,dict_size(dict),isum-(nkeys/2)**2])
+     call dict_free(dict)
+     deallocate(keys)
+     nkeys=4*nkeys
+  end do
+
+end subroutine profile_dictionary_operations
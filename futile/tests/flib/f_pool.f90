@@ -0,0 +1,127 @@
+!> @file
+!!  Test of the pool of work arrays of f_malloc_ptr
+!! @author
+!!    Copyright (C) 2017 BigDFT group
+!!    This file is distributed under the terms of the
+!!    GNU General Public License, see ~/COPYING file
+!!    or http://www.gnu.org/copyleft/gpl.txt .
+!!    For the list of contributors, see ~/AUTHORS
+program f_pool
+  use futile
+  implicit none
+  integer, parameter :: nit=100
+  integer :: it,ithread,nthread
+  logical :: recycled,zeroed,aligned,distinct,bounds_ok
+  integer(f_address) :: iadd1,iadd2
+  integer(f_long) :: mark,peak,memory
+  real(f_double), dimension(:), pointer :: d1,e1
+  real(f_double), dimension(:,:), pointer :: d2
+  real(f_double), dimension(:,:,:), pointer :: d3
+  integer(f_address), dimension(:), allocatable :: iadds
+  !$ integer, external :: omp_get_thread_num
+
+  call f_lib_initialize()
+
+  call f_routine(id='f_pool')
+
+  !a buffer is recycled by the next request of the same size class
+  d1=f_malloc_ptr(3000,id='d1',pool=.true.)
+  d1=1.0_f_double
+  iadd1=f_loc(d1(1))
+  call f_free_ptr(d1)
+  d2=f_malloc0_ptr([60,50],id='d2',pool=.true.)
+  recycled=f_loc(d2(1,1)) == iadd1
+  !and put to zero if requested
+  zeroed=all(d2 == 0.0_f_double)
+  call yaml_map('Recycled buffer of the same size class',recycled)
+  call yaml_map('Recycled buffer put to zero',zeroed)
+
+  !two arrays in use at the same time take different buffers
+  e1=f_malloc_ptr(4000,id='e1',pool=.true.)
+  iadd2=f_loc(e1(1))
+  distinct=iadd2 /= f_loc(d2(1,1))
+  call f_free_ptr(e1)
+  call f_free_ptr(d2)
+  call yaml_map('Distinct buffers for arrays in use',distinct)
+
+  !bounds of the mapped array, alignment requested in the info
+  d3=f_malloc_ptr([-1.to.2,0.to.3,1.to.5],id='d3',info='{alignment: 32}',pool=.true.)
+  bounds_ok=all(lbound(d3) == [-1,0,1]) .and. all(ubound(d3) == [2,3,5])
+  aligned=mod(f_loc(d3(-1,0,1)),int(32,f_address)) == 0
+  d3=2.0_f_double
+  call f_free_ptr(d3)
+  call yaml_map('Bounds of the pooled array',bounds_ok)
+  call yaml_map('Pooled array aligned',aligned)
+
+  !hot loop: only the first requests allocate a buffer
+  do it=1,nit
+     d1=f_malloc_ptr(it*100,id='d1',pool=.true.)
+     e1=f_malloc0_ptr(20000,id='e1',pool=.true.)
+     d1=e1(1:size(d1))
+     call f_free_ptr(d1)
+     call f_free_ptr(e1)
+  end do
+
+  !pooled and non-pooled arrays can be freed in any order
+  d1=f_malloc_ptr(500,id='d1',pool=.true.)
+  e1=f_malloc_ptr(500,id='e1')
+  call f_free_ptr(d1)
+  call f_free_ptr(e1)
+
+  !memory peak of a section of the code
+  call f_malloc_mark()
+  d1=f_malloc_ptr(1000,id='d1')
+  e1=f_malloc_ptr(500,id='e1')
+  call f_free_ptr(d1)
+  call f_free_ptr(e1)
+  call f_malloc_memory(memory=memory,mark=mark,peak=peak)
+  call yaml_map('Memory peak since the mark (B)',peak-mark)
+  call yaml_map('Memory given back',memory == mark)
+
+  !profiled routines called by all the threads of a parallel region
+  !$omp parallel do default(shared) private(it) schedule(static,1)
+  do it=1,16
+     call threaded_routine(it)
+  end do
+  !$omp end parallel do
+
+  !pooled arrays requested concurrently by the threads,
+  !a fixed number of them keeps the pool report reproducible
+  allocate(iadds(0:3))
+  iadds=0
+  !$omp parallel num_threads(4) default(shared) private(ithread,d1)
+  ithread=0
+  !$ ithread=omp_get_thread_num()
+  d1=f_malloc_ptr(40000,id='d1',pool=.true.)
+  d1=real(ithread,f_double)
+  iadds(ithread)=f_loc(d1(1))
+  !$omp barrier
+  call f_free_ptr(d1)
+  !$omp end parallel
+  nthread=count(iadds /= 0)
+  distinct=.true.
+  do it=1,nthread-1
+     distinct=distinct .and. all(iadds(0:it-1) /= iadds(it))
+  end do
+  deallocate(iadds)
+  call yaml_map('Distinct buffers for the threads',distinct)
+
+  call f_release_routine()
+
+  !the pool section of the memory report gives the number of requests and recycled buffers
+  call f_lib_finalize()
+
+contains
+
+  subroutine threaded_routine(n)
+    implicit none
+    integer, intent(in) :: n
+    real(f_double), dimension(:), allocatable :: a
+    call f_routine(id='threaded_routine')
+    allocate(a(n))
+    a=1.0_f_double
+    deallocate(a)
+    call f_release_routine()
+  end subroutine threaded_routine
+
+end program f_pool
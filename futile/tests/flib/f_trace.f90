@@ -0,0 +1,133 @@
+!> @file
+!!  Test of the timeline trace of the routines (Chrome trace-event format)
+!! @author
+!!    Copyright (C) 2017 BigDFT group
+!!    This file is distributed under the terms of the
+!!    GNU General Public License, see ~/COPYING file
+!!    or http://www.gnu.org/copyleft/gpl.txt .
+!!    For the list of contributors, see ~/AUTHORS
+program f_trace_test
+  use futile
+  use f_trace
+  use yaml_parse, only: yaml_parse_from_file
+  implicit none
+  integer, parameter :: nevents=64,nloop=100,nwork=20000,nbench=2000,nrep=5
+  character(len=*), parameter :: strange='a "quoted" '//achar(92)//'back'//achar(92)//'slash'//achar(9)//'tab'
+  integer :: i,nx,iev,irep
+  logical :: found,nested
+  integer(f_long) :: t_event,t_routine
+  real(f_double) :: work,ts_out,ts_in,dur_out,dur_in
+  character(len=64) :: ph,name
+  type(dictionary), pointer :: trace,events,ev
+
+  call f_lib_initialize()
+
+  !the rings can also be activated at f_lib_initialize with FUTILE_TRACE_EVENTS
+  call f_trace_finalize()
+  call f_trace_initialize(nevents)
+
+  !more events than the size of the ring: the oldest ones are overwritten
+  do i=1,nloop
+     call f_routine(id='loop')
+     call f_release_routine()
+  end do
+  call f_routine(id='outer')
+  call f_routine(id=strange)
+  call f_release_routine()
+  call f_release_routine()
+
+  call f_trace_dump('f_trace')
+
+  !the trace has to be read back by a (YAML 1.2 compatible) JSON parser
+  call yaml_parse_from_file(trace,'f_trace-trace-0.json')
+  events => trace//0//'traceEvents'
+  nx=0
+  found=.false.
+  ts_out=0.0_f_double
+  ts_in=0.0_f_double
+  dur_out=0.0_f_double
+  dur_in=0.0_f_double
+  do iev=0,dict_len(events)-1
+     ev => events//iev
+     ph=ev//'ph'
+     if (trim(ph) /= 'X') cycle
+     nx=nx+1
+     name=ev//'name'
+     if (trim(name) == 'outer') then
+        ts_out=ev//'ts'
+        dur_out=ev//'dur'
+     else if (trim(name) == strange) then
+        found=.true.
+        ts_in=ev//'ts'
+        dur_in=ev//'dur'
+     end if
+  end do
+  nested=ts_in >= ts_out .and. ts_in+dur_in <= ts_out+dur_out
+  call dict_free(trace)
+
+  call yaml_mapping_open('Trace read back')
+   call yaml_map('Events kept in the ring',nx)
+   call yaml_map('Escaped name found',found)
+   call yaml_map('Nested routines',nested)
+  call yaml_mapping_close()
+
+  !cost of recording a routine (as done in f_routine and f_release_routine),
+  !compared to a profiled routine doing a small amount of work.
+  !The minimum over several repetitions filters out the noise of the machine
+  t_event=huge(t_event)
+  t_routine=huge(t_routine)
+  do irep=1,nrep
+     t_event=min(t_event,bench_event())
+  end do
+  call f_trace_finalize()
+  do irep=1,nrep
+     t_routine=min(t_routine,bench_routine())
+  end do
+  call yaml_mapping_open('Trace overhead')
+   call yaml_map('Time per traced routine (ns)',t_event/nbench)
+   call yaml_map('Time per profiled routine (ns)',t_routine/nbench)
+   call yaml_map('Relative time overhead (%)',100.0_f_double*t_event/t_routine,fmt='(f8.3)')
+  call yaml_mapping_close()
+
+  call f_lib_finalize()
+
+contains
+
+  !> Time nbench traced events
+  function bench_event() result(t)
+    implicit none
+    integer(f_long) :: t
+    !local variables
+    integer :: it
+    integer(f_long) :: t0
+
+    t0=f_time()
+    do it=1,nbench
+       call f_trace_open(f_trace_id('bench',TRACE_ROUTINE))
+       call f_trace_close()
+    end do
+    t=f_time()-t0
+  end function bench_event
+
+  !> Time nbench calls of a routine doing a small amount of work
+  function bench_routine() result(t)
+    implicit none
+    integer(f_long) :: t
+    !local variables
+    integer :: it,j
+    integer(f_long) :: t0
+
+    t0=f_time()
+    do it=1,nbench
+       call f_routine(id='bench')
+       work=0.0_f_double
+       do j=1,nwork
+          work=work+sqrt(real(j+it,f_double))
+       end do
+       call f_release_routine()
+    end do
+    t=f_time()-t0
+    if (work < 0.0_f_double) call yaml_map('work',work)
+  end function bench_routine
+
+end program f_trace_test
@@ -209,6 +209,7 @@ program yaml_test
    end if
    if (TREES_EXTRAS .in. run) then
       call profile_dictionary_usage()
+      call profile_dictionary_operations()
    end if
 !!$   if (ALLOCATIONS .in. run) then
 !!$      call verify_heap_allocation_status()
@@ -232,9 +232,18 @@ end subroutine test_yaml_output_sequences1
 subroutine test_yaml_output_sequences2()
   use yaml_output
   use yaml_strings
+  use yaml_parse, only: yaml_parse_from_file
+  use dictionaries
+  use f_utils, only: f_open_file,f_close
   implicit none
   !local variables
+  integer :: unt,ierr,unb,i
   real(kind=8), dimension(:), allocatable :: dv
+  real(kind=8), dimension(5) :: dv_bin
+  real(kind=8), dimension(5,2) :: dm_bin
+  real(kind=8), dimension(12) :: dx,dx_read
+  real(kind=4), dimension(12) :: rx,rx_read
+  type(dictionary), pointer :: dict
 
   allocate(dv(5))
   dv=1.d0
@@ -277,5 +286,61 @@ subroutine test_yaml_output_sequences2()
   call yaml_sequence('a',label='l2',padding=10)
   call yaml_sequence_close()
 
+  !Check the binary side-car file for large arrays
+  call yaml_get_default_stream(unt)
+  call yaml_set_stream(unit=unt,binary_threshold=4,setdefault=.false.,istat=ierr)
+  call yaml_map('Short vector',dv(1:4))
+  call yaml_map('Long vector',dv)
+  call yaml_map('Long matrix',reshape([dv,dv],[5,2]))
+  call yaml_set_stream(unit=unt,binary_threshold=0,setdefault=.false.,istat=ierr)
+  call yaml_map('Long vector, no side-car',dv)
+
+  !the side-car has been closed, read it back
+  unb=98
+  call f_open_file(unb,'arrays.bin',status='old',binary=.true.)
+  read(unb)dv_bin
+  read(unb)dm_bin
+  call f_close(unb)
+  call yaml_map('Side-car read back',all(dv_bin == dv) .and. all(dm_bin == reshape([dv,dv],[5,2])))
+
+  !Check the streaming emitter of the numeric arrays, with the round-trip representation of the floats
+  do i=1,size(dx)
+     dx(i)=0.1d0*i
+  end do
+  dx(1)=1.d0/3.d0
+  dx(2)=-1.d-20
+  dx(3)=6.02214076d23
+  dx(4)=-0.0d0
+  dx(5)=123456789.d0
+  dx(6)=real(0.1,kind=8)
+  dx(7)=1.d-4
+  rx=real(dx)
+  call yaml_set_stream(unit=unt,array_style='flow',setdefault=.false.,istat=ierr)
+  call yaml_map('Round-trip floats',dx)
+  call yaml_map('Round-trip single precision floats',rx)
+  call yaml_map('Integers',[(i*i,i=1,40)])
+  call yaml_map('Given format',dx(1:3),fmt='(f6.3)')
+  call yaml_map('Empty vector',dx(1:0))
+  call yaml_map('Matrix',reshape(dx(1:6),[3,2]))
+  call yaml_sequence_open('Vectors in a sequence')
+    call yaml_sequence(advance='no')
+    call yaml_map('Vector',dx(1:3),label='vec')
+  call yaml_sequence_close()
+  call yaml_set_stream(unit=unt,array_style='block',setdefault=.false.,istat=ierr)
+  call yaml_map('Block style',dx(1:3))
+  call yaml_set_stream(unit=unt,array_style='none',setdefault=.false.,istat=ierr)
+
+  !the floats are read back identically
+  unb=97
+  call yaml_set_stream(unit=unb,filename='shortest.yaml',array_style='flow',setdefault=.false.,istat=ierr)
+  call yaml_map('dx',dx,unit=unb)
+  call yaml_map('rx',rx,unit=unb)
+  call yaml_close_stream(unit=unb)
+  call yaml_parse_from_file(dict,'shortest.yaml')
+  dx_read=dict//0//'dx'
+  rx_read=dict//0//'rx'
+  call dict_free(dict)
+  call yaml_map('Round-trip floats read back',all(dx_read == dx) .and. all(rx_read == rx))
+
   deallocate(dv)
 end subroutine test_yaml_output_sequences2
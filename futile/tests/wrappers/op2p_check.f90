@@ -11,9 +11,9 @@
     use overlap_point_to_point
     use wrapper_MPI
     implicit none
-    logical :: symmetric,nearest_neighbor,symfalse
+    logical :: symmetric,nearest_neighbor,symfalse,persistent
     integer :: iproc,jproc,nproc,norbp,ngroup,igroup,ndim,norb,iobj,jobj,kobj,nij_loc,nij_glob,i,j,ndimp,isdim
-    integer :: iorb_glb,jorb_glb,nsteps
+    integer :: iorb_glb,jorb_glb,nsteps,nrepeat
     integer, dimension(:), allocatable :: nobj,nobj_p
     integer, dimension(:,:), allocatable :: nobj_par
     type(dictionary), pointer :: options
@@ -50,6 +50,8 @@
     ndim=options//'ndim'
     symmetric=options//'symmetric'
     nearest_neighbor=options//'nn-pattern'
+    persistent=options//'persistent'
+    nrepeat=options//'benchmark'
     call dict_free(options)
 
     !construct the number of objects per processor
@@ -96,7 +98,8 @@
 
     call f_free(nobj)
 
-    call OP2P_unitary_test(mpiworld(),mpirank(),nproc,ngroup,ndim,nobj_par,symmetric,nearest_neighbor)
+    call OP2P_unitary_test(mpiworld(),mpirank(),nproc,ngroup,ndim,nobj_par,symmetric,nearest_neighbor,&
+         persistent=persistent,nrepeat=nrepeat)
 
     !starting the test for four point coupling matrix approach
 !!$
@@ -363,6 +366,16 @@
          dict_new('Usage' .is. &
          'Boolean, adjust the communication pattern of the operation.'))
 
+    call yaml_cl_parse_option(parser,'persistent','No',&
+         'Persistent requests','p',&
+         dict_new('Usage' .is. &
+         'Boolean, exchange the data with persistent requests. Implies the nearest-neighbor pattern.'))
+
+    call yaml_cl_parse_option(parser,'benchmark','0',&
+         'Loops of the throughput benchmark','b',&
+         dict_new('Usage' .is. &
+         'Number of OP2P loops timed after the test. No benchmark if zero.'))
+
   end subroutine OP2P_Check_options
 
 !!$  subroutine calculate_ndimp_and_isdim(ndim,nproc,iproc,ndimp,isdim,ndim_p)
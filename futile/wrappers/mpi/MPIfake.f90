@@ -114,6 +114,21 @@ end
 subroutine mpi_file_write()
 stop 'mpi_file_write'
 end
+subroutine mpi_file_read_at()
+stop 'mpi_file_read_at'
+end
+subroutine mpi_file_read_at_all()
+stop 'mpi_file_read_at_all'
+end
+subroutine mpi_file_write_at()
+stop 'mpi_file_write_at'
+end
+subroutine mpi_file_write_at_all()
+stop 'mpi_file_write_at_all'
+end
+subroutine mpi_file_set_size()
+stop 'mpi_file_set_size'
+end
 
 
 
@@ -373,6 +388,11 @@ subroutine mpi_type_create_hvector()
   stop 'MPIFAKE: mpi_type_create_hvector'
 END SUBROUTINE  MPI_TYPE_CREATE_HVECTOR
 
+subroutine mpi_type_create_resized()
+  implicit none
+  stop 'MPIFAKE: mpi_type_create_resized'
+END SUBROUTINE  MPI_TYPE_CREATE_RESIZED
+
 subroutine mpi_type_commit()
   implicit none
   stop 'MPIFAKE: mpi_type_commit'
@@ -393,6 +413,26 @@ subroutine mpi_testall()
   stop 'MPIFAKE: mpi_testall'
 END SUBROUTINE  MPI_TESTALL
 
+subroutine mpi_send_init()
+  implicit none
+  stop 'MPIFAKE: mpi_send_init'
+END SUBROUTINE  MPI_SEND_INIT
+
+subroutine mpi_recv_init()
+  implicit none
+  stop 'MPIFAKE: mpi_recv_init'
+END SUBROUTINE  MPI_RECV_INIT
+
+subroutine mpi_startall()
+  implicit none
+  stop 'MPIFAKE: mpi_startall'
+END SUBROUTINE  MPI_STARTALL
+
+subroutine mpi_request_free()
+  implicit none
+  stop 'MPIFAKE: mpi_request_free'
+END SUBROUTINE  MPI_REQUEST_FREE
+
 subroutine mpi_info_create()
   implicit none
   stop 'MPIFAKE: mpi_info_create'
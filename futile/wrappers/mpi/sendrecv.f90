@@ -29,6 +29,7 @@ module f_sendrecv
   end interface fmpi_recv
 
   public :: fmpi_send,fmpi_recv,fmpi_waitall,fmpi_wait
+  public :: fmpi_send_init,fmpi_recv_init,fmpi_startall,fmpi_testall,fmpi_request_free
 
   contains
 
@@ -87,6 +88,110 @@ module f_sendrecv
       end if
     end subroutine fmpi_wait
 
+    !> Create a persistent send request for a buffer which will be
+    !! sent several times to the same destination.
+    !! The request has to be started with fmpi_startall and released with fmpi_request_free
+    subroutine fmpi_send_init(buf,count,dest,tag,comm,request)
+      implicit none
+      real(f_double) :: buf !fake intent(in)
+      integer, intent(in) :: count
+      integer, intent(in) :: dest
+      integer, intent(in) :: tag
+      integer, intent(in), optional :: comm
+      integer, intent(out) :: request
+      !local variables
+      integer :: mpi_comm,ierr
+
+      mpi_comm=fmpi_comm(comm)
+      call MPI_SEND_INIT(buf,count,mpitype(buf),dest,tag,mpi_comm,request,ierr)
+      if (ierr/=0) call f_err_throw('An error in calling to MPI_SEND_INIT occured',&
+           err_id=ERR_MPI_WRAPPERS)
+    end subroutine fmpi_send_init
+
+    !> Create a persistent receive request, counterpart of fmpi_send_init
+    subroutine fmpi_recv_init(buf,count,source,tag,comm,request)
+      implicit none
+      real(f_double), intent(inout) :: buf !fake intent(out)
+      integer, intent(in) :: count
+      integer, intent(in) :: source
+      integer, intent(in) :: tag
+      integer, intent(in), optional :: comm
+      integer, intent(out) :: request
+      !local variables
+      integer :: mpi_comm,ierr
+
+      mpi_comm=fmpi_comm(comm)
+      call MPI_RECV_INIT(buf,count,mpitype(buf),source,tag,mpi_comm,request,ierr)
+      if (ierr/=0) call f_err_throw('An error in calling to MPI_RECV_INIT occured',&
+           err_id=ERR_MPI_WRAPPERS)
+    end subroutine fmpi_recv_init
+
+    !> Activate a set of persistent requests.
+    !! They complete as the others with fmpi_waitall or fmpi_testall
+    subroutine fmpi_startall(ncount,array_of_requests,simulate)
+      implicit none
+      integer, intent(in) :: ncount
+      integer, dimension(ncount), intent(inout) :: array_of_requests
+      logical, intent(in), optional :: simulate
+      !local variables
+      logical :: sim
+      integer :: ierr,tcat
+
+      if (ncount==0) return
+      sim=.false.
+      if (present(simulate)) sim=simulate
+      if (sim) return
+
+      tcat=TCAT_SEND
+      call f_timer_interrupt(tcat)
+      call MPI_STARTALL(ncount,array_of_requests,ierr)
+      call f_timer_resume()
+      if (ierr/=0) call f_err_throw('An error in calling to MPI_STARTALL occured',&
+           err_id=ERR_MPI_WRAPPERS)
+    end subroutine fmpi_startall
+
+    !> Test the completion of a set of requests without blocking.
+    !! Calling it during a calculation gives to the MPI library the occasion
+    !! to progress the pending messages
+    function fmpi_testall(ncount,array_of_requests,simulate) result(flag)
+      implicit none
+      integer, intent(in) :: ncount
+      integer, dimension(ncount), intent(inout) :: array_of_requests
+      logical, intent(in), optional :: simulate
+      logical :: flag
+      !local variables
+      integer :: ierr
+
+      flag=.true.
+      if (ncount==0) return
+      if (present(simulate)) then
+         if (simulate) return
+      end if
+
+      call MPI_TESTALL(ncount,array_of_requests,flag,FMPI_STATUSES_IGNORE,ierr)
+      if (ierr/=0) call f_err_throw('An error in calling to MPI_TESTALL occured',&
+           err_id=ERR_MPI_WRAPPERS)
+    end function fmpi_testall
+
+    !> Release a set of (persistent) requests, null requests are ignored
+    subroutine fmpi_request_free(ncount,array_of_requests)
+      implicit none
+      integer, intent(in) :: ncount
+      integer, dimension(ncount), intent(inout) :: array_of_requests
+      !local variables
+      integer :: i,ierr
+
+      do i=1,ncount
+         if (array_of_requests(i) == FMPI_REQUEST_NULL) cycle
+         call MPI_REQUEST_FREE(array_of_requests(i),ierr)
+         if (ierr/=0) then
+            call f_err_throw('An error in calling to MPI_REQUEST_FREE occured',&
+                 err_id=ERR_MPI_WRAPPERS)
+            return
+         end if
+      end do
+    end subroutine fmpi_request_free
+
     subroutine mpisend_i1(buf,dest,tag,comm,request,simulate,verbose)
       use yaml_output
       implicit none
@@ -36,6 +36,7 @@ module overlap_point_to_point
 !!$   public :: initialize_OP2P_descriptors,OP2P_communication,OP2P_descriptors,free_OP2P_descriptors
    public :: local_data_init,set_local_data,free_local_data,OP2P_unitary_test,initialize_OP2P_data
    public :: set_OP2P_iterator,OP2P_communication_step,OP2P_info,free_OP2P_data,OP2P_test
+   public :: OP2P_progress,nullify_OP2P_data
 
 !!$   type OP2P_descriptors
 !!$      logical :: forsymop !< descriptor for symmetric operation
@@ -88,6 +89,9 @@ module overlap_point_to_point
       logical :: simulate !<toggle the simulation of the communication
       logical :: verbose !<verbosity of the communication
       logical :: nearest_neighbor !< communication patterns only involves close processes
+      !> the ring of the data is performed with persistent requests, created once on the work arrays
+      !! (CPU only, implies nearest_neighbor as the partners do not change)
+      logical :: persistent
       logical :: do_calculation !<tell is the calculation has to be done
       integer :: iproc_dump !<rank which dumps the communication
       integer :: istep !<actual step of the communication
@@ -108,10 +112,13 @@ module overlap_point_to_point
       integer :: gpudirect !<are we in a GPUDirect scenario? (cuda psolver + cuda-aware MPI) (should be removed from here, rather go in f_buffers)\
       integer :: tag_offset !<offset for the tags in the communications
       integer :: ncouples !<total number of couples considered
+      integer(f_long) :: nsent !<number of elements sent by the present process, for the throughput
       !>stores the requests for the data
       integer, dimension(:), pointer :: requests_data
       !>stores the requests for the result
       integer, dimension(:), pointer :: requests_res
+      !>persistent requests (send/recv,group,work array) associated to dataw
+      integer, dimension(:,:,:), pointer :: requests_p
       !>data treated, to be used when simulating to
       !! see if the calculation is correct
       integer, dimension(:), pointer :: ndatac
@@ -181,6 +188,7 @@ module overlap_point_to_point
         OP2P%verbose=.false.
         OP2P%do_calculation=.false. !<tell is the calculation has to be done
         OP2P%nearest_neighbor=.false.
+        OP2P%persistent=.false.
         OP2P%iproc_dump=mpirank_null()-1
         OP2P%istep=0
         OP2P%nstep=-1
@@ -198,9 +206,11 @@ module overlap_point_to_point
         OP2P%gpudirect=0
         OP2P%tag_offset=0
         OP2P%ncouples=0
+        OP2P%nsent=int(0,f_long)
         !then nullifications
         nullify(OP2P%requests_data)
         nullify(OP2P%requests_res)
+        nullify(OP2P%requests_p)
         nullify(OP2P%ndatac)
         nullify(OP2P%ndatas)
         nullify(OP2P%group_id)
@@ -385,7 +395,7 @@ module overlap_point_to_point
      end subroutine cuda_estimate_memory_needs_gpudirect
 
      subroutine initialize_OP2P_data(OP2P,mpi_comm,iproc,nproc,ngroup,ndim,nobj_par,igpu,&
-          symmetric,nearest_neighbor,tag_offset)
+          symmetric,nearest_neighbor,tag_offset,persistent)
        use dynamic_memory
        use wrapper_MPI
        use yaml_strings
@@ -398,10 +408,12 @@ module overlap_point_to_point
        type(OP2P_data), intent(out) :: OP2P
        logical, intent(in), optional :: nearest_neighbor
        integer, intent(in), optional :: tag_offset
+       !> use persistent requests for the ring of the data (ignored with GPUDirect)
+       logical, intent(in), optional :: persistent
 
        !local variables
-       logical :: nn
-       integer :: igroup,icount,icountmax,iprocgrs,iprocgrr,jproc,igr,nobjp,nprocgr
+       logical :: nn,ps
+       integer :: igroup,icount,icountmax,iprocgrs,iprocgrr,jproc,igr,nobjp,nprocgr,ncount
        integer :: istep,nsteps,isobj,iobj_local,i,i_stat,maxtag
        integer, dimension(:,:,:), allocatable :: iprocpm1
 
@@ -409,6 +421,8 @@ module overlap_point_to_point
 
        nn=.false.
        if (present(nearest_neighbor)) nn=nearest_neighbor
+       ps=.false.
+       if (present(persistent)) ps=persistent
 
        if (present(tag_offset)) OP2P%tag_offset=tag_offset
 
@@ -476,6 +490,10 @@ module overlap_point_to_point
 
        if(igpu/=0) call cuda_estimate_memory_needs_gpudirect(iproc, nproc, OP2P, symmetric)
 
+       !persistent requests need the same partners at each step
+       OP2P%persistent=ps .and. OP2P%gpudirect/=1
+       if (OP2P%persistent) OP2P%nearest_neighbor=.true.
+
        !decide the strategy for the communication
        if (symmetric) then
           OP2P%nstep=(nproc-1)/2+1!nproc/2+1
@@ -609,6 +627,26 @@ module overlap_point_to_point
        !test array for data sending
        OP2P%ndatas = f_malloc0_ptr([1.to.2, 0.to.nproc-1, 1.to.OP2P%ngroup],id='ndatas')
 
+       if (OP2P%persistent) then
+          !each work array is always sent to and received from the same neighbours.
+          !the full array is sent, as its content changes provenance at each step
+          OP2P%requests_p=f_malloc_ptr([2,OP2P%ngroupp,2],id='requests_p')
+          OP2P%requests_p=FMPI_REQUEST_NULL
+          do i=1,2
+             do igroup=1,OP2P%ngroupp
+                ncount=size(OP2P%dataw(igroup,i)%ptr)
+                jproc=OP2P%ranks(SEND_DATA,igroup,0)
+                if (jproc /= mpirank_null()) call fmpi_send_init(OP2P%dataw(igroup,i)%ptr(1,1),&
+                     ncount,jproc,OP2P_tag(OP2P,iproc),comm=OP2P%mpi_comm,&
+                     request=OP2P%requests_p(SEND_DATA,igroup,i))
+                jproc=OP2P%ranks(RECV_DATA,igroup,0)
+                if (jproc /= mpirank_null()) call fmpi_recv_init(OP2P%dataw(igroup,i)%ptr(1,1),&
+                     ncount,jproc,OP2P_tag(OP2P,jproc),comm=OP2P%mpi_comm,&
+                     request=OP2P%requests_p(RECV_DATA,igroup,i))
+             end do
+          end do
+       end if
+
      end subroutine initialize_OP2P_data
 
      !> type to control the communication scheduling
@@ -643,6 +681,10 @@ module overlap_point_to_point
        end if
 
        !then nullifications
+       if (associated(OP2P%requests_p)) then
+          call fmpi_request_free(size(OP2P%requests_p),OP2P%requests_p)
+          call f_free_ptr(OP2P%requests_p)
+       end if
        call f_free_ptr(OP2P%requests_res)
        call f_free_ptr(OP2P%requests_data)
        call f_free_ptr(OP2P%ndatac)
@@ -848,11 +890,13 @@ module overlap_point_to_point
  !      real(wp), dimension(OP2P%ndim,norbp), intent(in) :: psir
        type(local_data), intent(inout) :: phi
        !local variables
-       integer :: igroup,dest,source,count,igr,jshift
+       integer :: igroup,dest,source,count,igr,jshift,nstart
        integer :: norbp!,original_source,norbp_max,iobj_local
+       integer, dimension(2*OP2P%ngroupp) :: requests_start
        real(f_double), dimension(:), pointer :: tmp
 
        norbp=phi%nobj
+       nstart=0
        !sending receiving data
        do igroup=1,OP2P%ngroupp
           igr=OP2P%group_id(igroup)
@@ -869,7 +913,15 @@ module overlap_point_to_point
              !send the fixed array to the processor which comes in the list
              OP2P%ndatas(DATA_,dest,igr)=&
                   OP2P%ndatas(DATA_,dest,igr)+count
-             if(OP2P%gpudirect/=1)then
+             if (OP2P%persistent .and. OP2P%istep > 0) then
+                !the data to be sent are in the work array, for which the request exists.
+                !the request sends the whole array, whatever the size of the present data
+                OP2P%nsent=OP2P%nsent+size(OP2P%dataw(igroup,OP2P%isend_data)%ptr)
+                nstart=nstart+1
+                requests_start(nstart)=OP2P%requests_p(SEND_DATA,igroup,OP2P%isend_data)
+                OP2P%requests_data(OP2P%ndata_comms)=requests_start(nstart)
+             else if(OP2P%gpudirect/=1)then
+                OP2P%nsent=OP2P%nsent+count
                 call fmpi_send(tmp(1),count,&
                      dest=dest,tag=OP2P_tag(OP2P,iproc),comm=OP2P%mpi_comm,&
                      request=OP2P%requests_data(OP2P%ndata_comms),&
@@ -879,6 +931,7 @@ module overlap_point_to_point
 !!$                  request=OP2P%requests_data(OP2P%ndata_comms),&
 !!$                  verbose=OP2P%verbose,simulate=OP2P%simulate) ! dest==OP2P%iproc_dump
              else
+               OP2P%nsent=OP2P%nsent+count
                call fmpi_send(phi%data_GPU,count,&
                   dest=dest,tag=OP2P_tag(OP2P,iproc),comm=OP2P%mpi_comm,&
                   request=OP2P%requests_data(OP2P%ndata_comms),&
@@ -894,7 +947,11 @@ module overlap_point_to_point
              OP2P%ndata_comms=OP2P%ndata_comms+1
              OP2P%ndatas(DATA_,iproc,igr)=&
                   OP2P%ndatas(DATA_,iproc,igr)-count
-             if(OP2P%gpudirect/=1)then
+             if (OP2P%persistent) then
+                nstart=nstart+1
+                requests_start(nstart)=OP2P%requests_p(RECV_DATA,igroup,OP2P%irecv_data)
+                OP2P%requests_data(OP2P%ndata_comms)=requests_start(nstart)
+             else if(OP2P%gpudirect/=1)then
                call fmpi_recv(OP2P%dataw(igroup,OP2P%irecv_data)%ptr(1,1),count,&!psiw(1,1,igroup,OP2P%irecv_data),count,&
                   source=source,tag=OP2P_tag(OP2P,source),comm=OP2P%mpi_comm,&
                   request=OP2P%requests_data(OP2P%ndata_comms),&
@@ -908,9 +965,24 @@ module overlap_point_to_point
             end if
           end if
        end do
+       call fmpi_startall(nstart,requests_start,simulate=OP2P%simulate)
 
      end subroutine P2P_data
 
+     !> Give to MPI the occasion of progressing the messages of the present step.
+     !! To be called from time to time within the calculation, when the library
+     !! does not have an asynchronous progress engine
+     subroutine OP2P_progress(OP2P)
+       use wrapper_MPI
+       implicit none
+       type(OP2P_data), intent(inout) :: OP2P
+       !local variables
+       logical :: done
+
+       if (OP2P%ndata_comms == 0) return
+       done=fmpi_testall(OP2P%ndata_comms,OP2P%requests_data,simulate=OP2P%simulate)
+     end subroutine OP2P_progress
+
      subroutine P2P_res(iproc,OP2P,phi)!,dpsiw)
        use wrapper_MPI
        use dynamic_memory
@@ -991,6 +1063,7 @@ module overlap_point_to_point
               end if
              OP2P%ndatas(RES_,dest,igr)=OP2P%ndatas(RES_,dest,igr)+&
                   OP2P%ndim*OP2P%nobj_par(dest,igr)
+             OP2P%nsent=OP2P%nsent+count
           end if
        end do
        do igroup=1,OP2P%ngroupp
@@ -1212,11 +1285,13 @@ module overlap_point_to_point
 
 
      !> Unitary test for the Overlap point-to-point.
-     subroutine OP2P_unitary_test(mpi_comm,iproc,nproc,ngroup,ndim,nobj_par,symmetric,nearest_neighbor,assert)
-       use yaml_output, only: yaml_map
+     subroutine OP2P_unitary_test(mpi_comm,iproc,nproc,ngroup,ndim,nobj_par,symmetric,nearest_neighbor,assert,&
+          persistent,nrepeat)
+       use yaml_output
        use yaml_strings
        use dictionaries, only: f_err_throw
        use f_utils
+       use wrapper_MPI
        implicit none
        !Arguments
        !>flag indicating the symmetricity of the operation. This reflects in the communication scheduling
@@ -1224,15 +1299,22 @@ module overlap_point_to_point
        integer, intent(in) :: mpi_comm,iproc,nproc,ngroup,ndim !< MPI data
        integer, dimension(0:nproc-1,ngroup), intent(in) :: nobj_par
        logical, intent(in), optional :: nearest_neighbor,assert
+       logical, intent(in), optional :: persistent !< use persistent requests for the data
+       !> number of loops of the throughput benchmark, performed after the test (default 0)
+       integer, intent(in), optional :: nrepeat
        !local variables
-       logical :: asst
-       real(wp) :: maxdiff
+       logical :: asst,ps
+       integer :: irep,nrep
+       real(wp) :: maxdiff,tloop,sent
        type(OP2P_data) :: OP2P
 
        asst=.false.
        if (present(assert)) asst=assert
+       nrep=0
+       if (present(nrepeat)) nrep=nrepeat
        !first initialize the OP2P data
-       call initialize_OP2P_data(OP2P,mpi_comm,iproc,nproc,ngroup,ndim,nobj_par,0,symmetric,nearest_neighbor)
+       call initialize_OP2P_data(OP2P,mpi_comm,iproc,nproc,ngroup,ndim,nobj_par,0,symmetric,nearest_neighbor,&
+            persistent=persistent)
 
        if (.not. OP2P_test(iproc,nproc,OP2P,maxdiff,asst)) then
           if (iproc==0) call f_err_throw('OP2P Unitary test not passed, maxdiff='+maxdiff**'(1pe12.5)')
@@ -1243,6 +1325,36 @@ module overlap_point_to_point
           call yaml_map('OP2P unitary test error',maxdiff)
        end if
        call free_OP2P_data(OP2P)
+
+       if (nrep <= 0) return
+       !throughput of the communication steps alone, without calculation
+       !nor initialization of the requests
+       sent=0.0_wp
+       tloop=0.0_wp
+       do irep=1,nrep
+          call initialize_OP2P_data(OP2P,mpi_comm,iproc,nproc,ngroup,ndim,nobj_par,0,symmetric,nearest_neighbor,&
+               persistent=persistent)
+          ps=OP2P%persistent
+          tloop=tloop+OP2P_communication_time(iproc,OP2P)
+          sent=sent+real(OP2P%nsent,wp)
+          call free_OP2P_data(OP2P)
+       end do
+       tloop=tloop/real(nrep,wp)
+       if (nproc > 1) then
+          call fmpi_allreduce(tloop,1,op=FMPI_MAX,comm=mpi_comm)
+          call fmpi_allreduce(sent,1,op=FMPI_SUM,comm=mpi_comm)
+       end if
+       !data exchanged per loop, in MB
+       sent=sent*real(c_sizeof(maxdiff),wp)/real(nrep,wp)/1024.0_wp**2
+       if (iproc==0) then
+          call yaml_mapping_open('OP2P throughput')
+          call yaml_map('Persistent requests',ps)
+          call yaml_map('Repetitions',nrep)
+          call yaml_map('Time per loop (s)',tloop,fmt='(1pe12.5)')
+          call yaml_map('Data exchanged per loop (MB)',sent,fmt='(1pe12.5)')
+          if (tloop > 0.0_wp) call yaml_map('Throughput (MB/s)',sent/tloop,fmt='(1pe12.5)')
+          call yaml_mapping_close()
+       end if
      end subroutine OP2P_unitary_test
 
      !> Test the coherence of the OP2P scheme within the chosen repartition.
@@ -1289,7 +1401,7 @@ module overlap_point_to_point
           !otherwise calculate
           call simulate_OP2P_calculation(iter%igroup,iter%istep,iter%remote_result,&
                iter%nloc_i,iter%nloc_j,iter%isloc_i,iter%isloc_j,&
-               OP2P%ndim,iter%phi_i,iter%phi_j,etot)
+               OP2P%ndim,iter%phi_i,iter%phi_j,etot,OP2P)
 
           if (iproc==0 .and. .not. quiet) then
              call OP2P_info(iter,OP2P,prc,tel,trm)
@@ -1314,6 +1426,39 @@ module overlap_point_to_point
 
      end function OP2P_test
 
+     !> Time (in seconds) spent by the communication steps of a loop with no calculation
+     function OP2P_communication_time(iproc,OP2P) result(time)
+       use wrapper_MPI
+       use dynamic_memory
+       use f_utils, only: f_time
+       implicit none
+       integer, intent(in) :: iproc
+       type(OP2P_data), intent(inout) :: OP2P
+       real(wp) :: time
+       !local variables
+       integer :: norbp
+       integer(f_long) :: t0
+       type(OP2P_iterator) :: iter
+       real(wp), dimension(:,:), pointer :: data,res
+
+       !the content of the data does not matter here
+       norbp=sum(OP2P%nobj_par(iproc,:))
+       data=f_malloc0_ptr([OP2P%ndim,norbp],id='data')
+       res=f_malloc0_ptr([OP2P%ndim,norbp],id='res')
+
+       call set_OP2P_iterator(iproc,OP2P,iter,norbp,data,res)
+       call fmpi_barrier(comm=OP2P%mpi_comm)
+       t0=f_time()
+       do
+          call OP2P_communication_step(iproc,OP2P,iter)
+          if (iter%event == OP2P_EXIT) exit
+       end do
+       time=real(f_time()-t0,wp)*1.e-9_wp
+
+       call f_free_ptr(data)
+       call f_free_ptr(res)
+     end function OP2P_communication_time
+
      subroutine test_data(iproc,OP2P,norbp,data)
        implicit none
        !Arguments
@@ -1423,7 +1568,7 @@ module overlap_point_to_point
 
    subroutine simulate_OP2P_calculation(igroup,istep,remote_result,&
         nloc_i,nloc_j,isloc_i,isloc_j,&
-        ndim,phi_i,phi_j,rtot)
+        ndim,phi_i,phi_j,rtot,OP2P)
      use yaml_output, only: yaml_map
      use yaml_strings
      implicit none
@@ -1436,6 +1581,8 @@ module overlap_point_to_point
      integer, intent(in) :: ndim
      type(local_data), intent(inout) :: phi_i,phi_j
      real(wp), intent(inout) :: rtot
+     !> if present, the messages of the ring are progressed during the calculation
+     type(OP2P_data), intent(inout), optional :: OP2P
      !local variables
      integer :: iorb,jorb,iorb_glb,jorb_glb,ishift,jshift,ishift_res,jshift_res,i
      real(wp) :: rint_ij
@@ -1486,6 +1633,7 @@ module overlap_point_to_point
               end if
            end if
         end do
+        if (present(OP2P)) call OP2P_progress(OP2P)
      end do
 
    end subroutine simulate_OP2P_calculation
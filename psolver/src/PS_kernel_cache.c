@@ -0,0 +1,148 @@
+#include <config.h>
+
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* On-disk cache of the Poisson kernel.
+
+   Each MPI task stores its slice of the kernel in its own file,
+     <dir>/pskernel-<hash of the key>-<iproc>.bin
+   made of a header, the key describing the kernel (compared on reuse, the
+   hash only selects the file) padded to 8 bytes, and the values.
+   Files are written under a temporary name and renamed, so that concurrent
+   jobs sharing the directory never read a partial file. */
+
+#define PS_CACHE_MAGIC "PSKCACHE"
+#define PS_CACHE_VERSION 1
+
+struct ps_cache_header {
+  char magic[8];
+  int version;
+  int keylen;
+  long long nelem;
+};
+
+static unsigned long long ps_cache_hash(const char *key, int keylen)
+{
+  /* FNV-1a */
+  unsigned long long h = 14695981039346656037ULL;
+  int i;
+  for (i = 0; i < keylen; i++) {
+    h ^= (unsigned char)key[i];
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+static char *ps_cache_path(const char *dir, int dirlen, const char *key, int keylen, int iproc)
+{
+  size_t len = dirlen + 64;
+  char *path = malloc(len);
+  if (!path) return NULL;
+  snprintf(path, len, "%.*s/pskernel-%016llx-%d.bin", dirlen, dir,
+           ps_cache_hash(key, keylen), iproc);
+  return path;
+}
+
+static size_t ps_cache_data_offset(int keylen)
+{
+  return sizeof(struct ps_cache_header) + ((keylen + 7) / 8) * 8;
+}
+
+/* found is 1 if the file exists and has been written for this very key. */
+void FC_FUNC_(ps_kernel_cache_load, PS_KERNEL_CACHE_LOAD)(const char *dir, int *dirlen,
+                                                          const char *key, int *keylen,
+                                                          int *iproc, double *data,
+                                                          long long *nelem, int *found)
+{
+  char *path;
+  int fd;
+  struct stat st;
+  void *map;
+  const struct ps_cache_header *h;
+  size_t offset = ps_cache_data_offset(*keylen);
+  size_t size = offset + sizeof(double) * (size_t)(*nelem);
+
+  *found = 0;
+  path = ps_cache_path(dir, *dirlen, key, *keylen, *iproc);
+  if (!path) return;
+  fd = open(path, O_RDONLY);
+  free(path);
+  if (fd < 0) return;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size != size) {
+    close(fd);
+    return;
+  }
+  map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) return;
+  h = (const struct ps_cache_header *)map;
+  if (memcmp(h->magic, PS_CACHE_MAGIC, 8) == 0 && h->version == PS_CACHE_VERSION &&
+      h->keylen == *keylen && h->nelem == *nelem &&
+      memcmp((const char *)map + sizeof(struct ps_cache_header), key, *keylen) == 0) {
+    memcpy(data, (const char *)map + offset, sizeof(double) * (size_t)(*nelem));
+    *found = 1;
+  }
+  munmap(map, size);
+}
+
+/* ierr is 0 on success; a failure leaves the cache unchanged. */
+void FC_FUNC_(ps_kernel_cache_store, PS_KERNEL_CACHE_STORE)(const char *dir, int *dirlen,
+                                                            const char *key, int *keylen,
+                                                            int *iproc, const double *data,
+                                                            long long *nelem, int *ierr)
+{
+  char *path, *tmp, *dirname;
+  FILE *f;
+  struct ps_cache_header h;
+  static const char pad[8] = {0};
+  size_t npad = ps_cache_data_offset(*keylen) - sizeof(struct ps_cache_header) - *keylen;
+  int ok;
+
+  *ierr = 1;
+  dirname = malloc(*dirlen + 1);
+  if (!dirname) return;
+  memcpy(dirname, dir, *dirlen);
+  dirname[*dirlen] = '\0';
+  ok = mkdir(dirname, 0755) == 0 || errno == EEXIST;
+  free(dirname);
+  if (!ok) return;
+
+  path = ps_cache_path(dir, *dirlen, key, *keylen, *iproc);
+  if (!path) return;
+  tmp = malloc(strlen(path) + 32);
+  if (!tmp) {
+    free(path);
+    return;
+  }
+  sprintf(tmp, "%s.%ld.tmp", path, (long)getpid());
+
+  memcpy(h.magic, PS_CACHE_MAGIC, 8);
+  h.version = PS_CACHE_VERSION;
+  h.keylen = *keylen;
+  h.nelem = *nelem;
+  f = fopen(tmp, "wb");
+  if (f) {
+    ok = fwrite(&h, sizeof(h), 1, f) == 1 &&
+      fwrite(key, 1, *keylen, f) == (size_t)(*keylen) &&
+      fwrite(pad, 1, npad, f) == npad &&
+      fwrite(data, sizeof(double), *nelem, f) == (size_t)(*nelem);
+    ok = (fclose(f) == 0) && ok;
+    if (ok && rename(tmp, path) == 0)
+      *ierr = 0;
+    else
+      unlink(tmp);
+  }
+  free(tmp);
+  free(path);
+}
@@ -8,7 +8,7 @@
 !! For the list of contributors, see ~/AUTHORS
 
 !regroup the psolver from here -------------
-subroutine apply_kernel(gpu,kernel,rho,offset,strten,zf,updaterho)
+subroutine apply_kernel(gpu,kernel,rho,offset,strten,zf,updaterho,single)
   use Poisson_Solver
   use wrapper_MPI
   use f_utils, only: f_zero
@@ -18,6 +18,8 @@ subroutine apply_kernel(gpu,kernel,rho,offset,strten,zf,updaterho)
   !>when true, the density is updated with the value of zf
   logical, intent(in) :: updaterho
   logical, intent(in) :: gpu !< logical variable controlling the gpu acceleration
+  !> when true, the MPI transpositions of the CPU solver are done in single precision
+  logical, intent(in) :: single
   type(coulomb_operator), intent(inout) :: kernel
   !> Total integral on the supercell of the final potential on output
   real(dp), intent(in) :: offset
@@ -52,6 +54,27 @@ subroutine apply_kernel(gpu,kernel,rho,offset,strten,zf,updaterho)
     end do
     !$omp end parallel do
 
+    if (kernel%igpu == 2 .and. .not. kernel%opt%calculate_strten) then
+       !FFTW solver, same data layout as the CUDA one (nproc is always 1)
+       n(1)=kernel%grid%n1
+       n(2)=kernel%grid%n3
+       n(3)=kernel%grid%n2
+       size1=kernel%grid%md1*kernel%grid%md2*kernel%grid%md3
+       call f_memcpy(n=size1,src=zf(1,1),dest=kernel%w%work1_fftw(1))
+       call fftw_3d_psolver_general(n,kernel%fftw_plan,kernel%geo,&
+            kernel%w%work1_fftw,kernel%w%work2_fftw,kernel%w%k_fftw,kernel%grid%scal)
+       call f_memcpy(n=size1,src=kernel%w%work1_fftw(1),dest=zf(1,1))
+       !the zero Fourier component is left to the offset in the periodic case
+       if (all(kernel%geo == 1)) then
+          !$omp parallel do default(shared) private(i1,i23)
+          do i23=1,kernel%grid%md2*kernel%grid%md3
+             do i1=1,kernel%grid%md1
+                zf(i1,i23)=zf(i1,i23)+offset*kernel%grid%scal/kernel%mesh%volume_element
+             end do
+          end do
+          !$omp end parallel do
+       end if
+    else
      call f_timing(TCAT_PSOLV_COMPUT,'OF')
      call G_PoissonSolver(kernel%mpi_env%iproc,kernel%mpi_env%nproc,&
           kernel%part_mpi%mpi_comm,kernel%inplane_mpi%iproc,&
@@ -60,8 +83,10 @@ subroutine apply_kernel(gpu,kernel,rho,offset,strten,zf,updaterho)
           kernel%grid%nd1,kernel%grid%nd2,kernel%grid%nd3,&
           kernel%grid%md1,kernel%grid%md2,kernel%grid%md3,&
           kernel%kernel,zf,&
-          kernel%grid%scal,kernel%mu**2,kernel%mesh,offset,strten)
+          kernel%grid%scal,kernel%mu**2,kernel%mesh,offset,strten,kernel%transpose_chunks,single,&
+          kernel%fftw_1d)
      call f_timing(TCAT_PSOLV_COMPUT,'ON')
+    end if
 
     if (updaterho) then
        !$omp parallel do default(shared) private(i1,i23,j23,j3)
@@ -335,9 +360,11 @@ end subroutine finalize_hartree_results
 !> Parallel version of Poisson Solver
 !! General version, for each boundary condition
 subroutine G_PoissonSolver(iproc,nproc,planes_comm,iproc_inplane,inplane_comm,ncplx,&
-     n1,n2,n3,nd1,nd2,nd3,md1,md2,md3,pot,zf,scal,mu0_square,mesh,offset,strten)
+     n1,n2,n3,nd1,nd2,nd3,md1,md2,md3,pot,zf,scal,mu0_square,mesh,offset,strten,nchunks,single,&
+     use_fftw)
   use Poisson_Solver, only: dp, gp, TCAT_PSOLV_COMMUN,TCAT_PSOLV_COMPUT
   use wrapper_mpi
+  use iso_c_binding, only: c_loc,c_f_pointer
   !use memory_profiling
   use time_profiling, only: f_timing
   use dynamic_memory
@@ -353,6 +380,12 @@ subroutine G_PoissonSolver(iproc,nproc,planes_comm,iproc_inplane,inplane_comm,nc
   integer, intent(inout) :: n1,n2,n3,nd1,nd2,nd3,md1,md2,md3,nproc,iproc
   integer, intent(in) :: ncplx
   integer, intent(in) :: planes_comm,inplane_comm,iproc_inplane
+  !> number of chunks of planes of the pipelined transpositions, blocking MPI_ALLTOALL if < 2
+  integer, intent(in) :: nchunks
+  !> transpositions in single precision, with the non-blocking all-to-all of the pipelined ones
+  logical, intent(in) :: single
+  !> batched FFTW transforms (fftw.cpp) in place of the fftstp_sg steps
+  logical, intent(in) :: use_fftw
   real(gp), intent(in) :: scal,offset,mu0_square
   type(cell), intent(in) :: mesh
   real(dp), dimension(nd1,nd2,nd3/nproc), intent(in) :: pot
@@ -387,6 +420,12 @@ subroutine G_PoissonSolver(iproc,nproc,planes_comm,iproc_inplane,inplane_comm,nc
   integer :: n3pr1,n3pr2,j1start,n1p,n2dimp
   integer :: ithread, nthread
   integer,parameter :: max_memory_zt = 500 !< maximal memory for zt array, in megabytes
+  logical :: pipelined,spcomm
+  integer :: nchunk2,nchunk3,ichunk,jstart,jend,nslice
+  integer, dimension(:), allocatable :: requests
+  !single precision buffers of the transpositions, allocated as double precision arrays
+  real(dp), dimension(:), allocatable, target :: zmpi1_sbuf,zmpi2_sbuf
+  real(kind=4), dimension(:), pointer :: zmpi1_s,zmpi2_s
   !integer(f_long) :: readb,writeb
   real(f_double) :: gflops_fft
   type(f_perf) :: performance_info
@@ -510,6 +549,21 @@ subroutine G_PoissonSolver(iproc,nproc,planes_comm,iproc_inplane,inplane_comm,nc
      zmpi1 = f_malloc((/ 2, n1, md2/nproc, nd3/nproc, n3pr2 /),id='zmpi1')
   end if
 
+  !pipelined transpositions: the FFTs of a chunk of planes overlap with the
+  !non-blocking all-to-all of the previous chunks
+  pipelined=(nchunks > 1 .or. single) .and. nproc > 1 .and. n3pr1 == 1
+  spcomm=pipelined .and. single
+  !size of the slice of zmpi1 and zmpi2 exchanged with each process
+  nslice=2*n1dim*(md2/nproc)*(nd3/nproc)
+  if (pipelined) requests = f_malloc(max(nchunks,1),id='requests')
+  if (spcomm) then
+     !the padding planes are never converted, hence the initialization
+     zmpi1_sbuf = f_malloc0((nslice*nproc+1)/2,id='zmpi1_sbuf')
+     zmpi2_sbuf = f_malloc0((nslice*nproc+1)/2,id='zmpi2_sbuf')
+     call c_f_pointer(c_loc(zmpi1_sbuf),zmpi1_s,[nslice*nproc])
+     call c_f_pointer(c_loc(zmpi2_sbuf),zmpi2_s,[nslice*nproc])
+  end if
+
   !calculating the FFT work arrays (beware on the HalFFT in n3 dimension)
 
   !$omp parallel sections default(shared)
@@ -573,11 +627,20 @@ subroutine G_PoissonSolver(iproc,nproc,planes_comm,iproc_inplane,inplane_comm,nc
   zw = f_malloc((/ 1.to.2,1.to.ncache/4,1.to.2,0.to.nthread-1 /),id='zw')
   zt = f_malloc((/ 1.to.2,1.to.lzt/n3pr1,1.to.n1p,0.to.nthread-1 /),id='zt')
     
+  !chunks of the two pipelined transpositions, over the J2 and the j3 planes,
+  !fixed before the parallel region as all the threads go through them
+  nchunk2=1
+  nchunk3=1
+  if (pipelined) then
+     nchunk2=max(min(nchunks,md2/nproc),1)
+     nchunk3=max(min(nchunks,nd3/nproc),1)
+  end if
+
   ithread = 0
   !$omp parallel num_threads(nthread) &
   !$omp default(shared)&
   !$omp private(nfft,inzee,Jp2stb,J2stb,Jp2stf,J2stf,i3,strten_omp)&
-  !$omp private(j2,i1,i,j3,j) &
+  !$omp private(j2,i1,i,j3,j,ichunk,jstart,jend) &
   !$omp firstprivate(lot, maxIter,ithread)
   !$ ithread = omp_get_thread_num()
 !  !$omp firstprivate(before3, now3, after3)
@@ -587,8 +650,16 @@ subroutine G_PoissonSolver(iproc,nproc,planes_comm,iproc_inplane,inplane_comm,nc
   if (ithread>nthread-1) then
       call f_err_throw('wrong thread ID')
   end if
+  do ichunk=1,nchunk2
+  if (pipelined) then
+     jstart=(ichunk-1)*(md2/nproc)/nchunk2+1
+     jend=ichunk*(md2/nproc)/nchunk2
+  else
+     jstart=1
+     jend=maxIter
+  end if
   !$omp do schedule(static)
-  do j2 = 1, maxIter
+  do j2 = jstart, min(jend,maxIter)
      !this condition ensures that we manage only the interesting part for the FFT
      !if (iproc*(md2/nproc)+j2 <= n2dim) then
 
@@ -608,11 +679,17 @@ subroutine G_PoissonSolver(iproc,nproc,planes_comm,iproc_inplane,inplane_comm,nc
 
            !input: I1,I3,J2,(Jp2)
            inzee=1
-           do i=1,ic3
-              call fftstp_sg(lot,nfft,n3dim,lot,n3dim,zw(1,1,inzee,ithread), &
-                zw(1,1,3-inzee,ithread),ntrig,btrig3,after3(i),now3(i),before3(i),1)
-              inzee=3-inzee
-           enddo
+           if (use_fftw) then
+              call fftw_1d_psolver_many(n3dim,nfft,zw(1,1,1,ithread),lot,&
+                   zw(1,1,2,ithread),lot,1)
+              inzee=2
+           else
+              do i=1,ic3
+                 call fftstp_sg(lot,nfft,n3dim,lot,n3dim,zw(1,1,inzee,ithread), &
+                   zw(1,1,3-inzee,ithread),ntrig,btrig3,after3(i),now3(i),before3(i),1)
+                 inzee=3-inzee
+              enddo
+           end if
 
            !output: I1,i3,J2,(Jp2)
            !exchanging components
@@ -625,18 +702,38 @@ subroutine G_PoissonSolver(iproc,nproc,planes_comm,iproc_inplane,inplane_comm,nc
            end if
            !output: I1,J2,i3,(Jp2)
         end do
+        if (spcomm) call PS_buffer_to_sp(nd3,2*n1dim,2*n1dim*(md2/nproc),2*n1dim*(j2-1),&
+             zmpi2,zmpi2_s)
      !end if
   end do
   !$omp end do
   ! DO NOT USE NOWAIT, removes the implicit barrier
 
+  if (pipelined) then
+     !$omp master
+     !input: I1,J2,j3,jp3,(Jp2), for the J2 of the chunk
+     if (spcomm) then
+        call PS_transpose_chunk(nproc,planes_comm,nd3/nproc,2*n1dim*(jend-jstart+1),&
+             2*n1dim*(md2/nproc),2*n1dim*(jstart-1),nslice,MPI_REAL,&
+             zmpi2_sbuf,zmpi1_sbuf,ichunk,requests)
+     else
+        call PS_transpose_chunk(nproc,planes_comm,nd3/nproc,2*n1dim*(jend-jstart+1),&
+             2*n1dim*(md2/nproc),2*n1dim*(jstart-1),nslice,MPI_DOUBLE_PRECISION,&
+             zmpi2,zmpi1,ichunk,requests)
+     end if
+     !$omp end master
+  end if
+  end do
+
   gflops_fft=5*2*real(n1dim*maxIter,f_double)*n3dim*log(real(n3dim,f_double))
 
   !$omp master
     nd3=nd3/n3pr1
     !Interprocessor data transposition
     !input: I1,J2,j3,jp3,(Jp2)
-    if (nproc > 1 .and. iproc < n3pr1*n3pr2) then
+    if (pipelined) then
+       call PS_transpose_wait(nchunk2,requests)
+    else if (nproc > 1 .and. iproc < n3pr1*n3pr2) then
        call f_timing(TCAT_PSOLV_COMPUT,'OF')
        call f_timing(TCAT_PSOLV_COMMUN,'ON')
        !communication scheduling
@@ -651,6 +748,7 @@ subroutine G_PoissonSolver(iproc,nproc,planes_comm,iproc_inplane,inplane_comm,nc
     !output: I1,J2,j3,Jp2,(jp3)
   !$omp end master
   !$omp barrier
+  if (spcomm) call PS_buffer_to_dp(nslice*nproc,zmpi1_s,zmpi1)
 
   !now each process perform complete convolution of its planes
 
@@ -670,8 +768,16 @@ subroutine G_PoissonSolver(iproc,nproc,planes_comm,iproc_inplane,inplane_comm,nc
   
   strten_omp=0
 
+  do ichunk=1,nchunk3
+  if (pipelined) then
+     jstart=(ichunk-1)*(nd3/nproc)/nchunk3+1
+     jend=ichunk*(nd3/nproc)/nchunk3
+  else
+     jstart=1
+     jend=maxIter
+  end if
   !$omp do schedule(static)
-  do j3 = 1, maxIter
+  do j3 = jstart, min(jend,maxIter)
        !this condition ensures that we manage only the interesting part for the FFT
      !if (iproc*(nd3/nproc)+j3 <= n3/2+1) then
           Jp2stb=1
@@ -704,6 +810,10 @@ subroutine G_PoissonSolver(iproc,nproc,planes_comm,iproc_inplane,inplane_comm,nc
              !output: J2,Jp2,I1,j3,(jp3)
              !performing FFT
              !input: I2,I1,j3,(jp3)
+             if (use_fftw) then
+                call fftw_1d_psolver_many(n1,nfft,zw(1,1,1,ithread),lot,&
+                     zt(1,j,1,ithread),lzt/n3pr1,1)
+             else
              inzee=1
              do i=1,ic1-1
                 call fftstp_sg(lot,nfft,n1,lot,n1,zw(1,1,inzee,ithread),zw(1,1,3-inzee,ithread),&
@@ -715,6 +825,7 @@ subroutine G_PoissonSolver(iproc,nproc,planes_comm,iproc_inplane,inplane_comm,nc
              i=ic1
              call fftstp_sg(lot,nfft,n1,lzt/n3pr1,n1,zw(1,1,inzee,ithread),zt(1,j,1,ithread),&
                   ntrig,btrig1,after1(i),now1(i),before1(i),1)
+             end if
              !output: I2,i1,j3,(jp3)
           end do
 
@@ -756,11 +867,17 @@ subroutine G_PoissonSolver(iproc,nproc,planes_comm,iproc_inplane,inplane_comm,nc
              !input: i1,I2,j3,(jp3)
              inzee=1
 
+             if (use_fftw) then
+                call fftw_1d_psolver_many(n2,nfft,zw(1,1,1,ithread),lot,&
+                     zw(1,1,2,ithread),lot,1)
+                inzee=2
+             else
              do i=1,ic2
                 call fftstp_sg(lot,nfft,n2,lot,n2,zw(1,1,inzee,ithread),zw(1,1,3-inzee,ithread),&
                      ntrig,btrig2,after2(i),now2(i),before2(i),1)
                 inzee=3-inzee
              enddo
+             end if
              !output: i1,i2,j3,(jp3)
              !Multiply with kernel in fourier space
              i3=mod(iproc,n3pr2)*(nd3/n3pr2)+j3
@@ -781,12 +898,18 @@ subroutine G_PoissonSolver(iproc,nproc,planes_comm,iproc_inplane,inplane_comm,nc
 !TRANSFORM BACK IN REAL SPACE
              !transform along y axis
              !input: i1,i2,j3,(jp3)
+             if (use_fftw) then
+                call fftw_1d_psolver_many(n2,nfft,zw(1,1,inzee,ithread),lot,&
+                     zw(1,1,3-inzee,ithread),lot,-1)
+                inzee=3-inzee
+             else
              do i=1,ic2
                 call fftstp_sg(lot,nfft,n2,lot,n2,zw(1,1,inzee,ithread),zw(1,1,3-inzee,ithread),&
                      ntrig,ftrig2,after2(i),now2(i),before2(i),-1)
                !zw(:,:,3-inzee)=zw(:,:,inzee)
                 inzee=3-inzee
              end do
+             end if
 
              !reverse ordering
              !input: i1,I2,j3,(jp3)
@@ -820,6 +943,11 @@ subroutine G_PoissonSolver(iproc,nproc,planes_comm,iproc_inplane,inplane_comm,nc
            nfft=min(j+(lot-1),n2dimp/n3pr1)-j+1
 
             !performing FFT
+             if (use_fftw) then
+                call fftw_1d_psolver_many(n1,nfft,zt(1,j,1,ithread),lzt/n3pr1,&
+                     zw(1,1,1,ithread),lot,-1)
+                inzee=1
+             else
              i=1
              if (n3pr1 > 1) then
                call fftstp_sg(lzt/n3pr1,nfft,n1,lot,n1,zt(1,j,1,ithread),zw(1,1,1,ithread),&
@@ -834,6 +962,7 @@ subroutine G_PoissonSolver(iproc,nproc,planes_comm,iproc_inplane,inplane_comm,nc
                      ntrig,ftrig1,after1(i),now1(i),before1(i),-1)
                 inzee=3-inzee
              enddo
+             end if
 
              !output: I2,I1,j3,(jp3)
              !reverse ordering
@@ -847,12 +976,30 @@ subroutine G_PoissonSolver(iproc,nproc,planes_comm,iproc_inplane,inplane_comm,nc
              endif
              ! output: I1,J2,j3,Jp2,(jp3)
           end do
+          if (spcomm) call PS_buffer_to_sp(nproc,2*n1dim*(md2/nproc),nslice,&
+               2*n1dim*(md2/nproc)*(j3-1),zmpi1,zmpi1_s)
      !endif
 
 !END OF TRANSFORM FOR X AND Z
 
        end do
   !$omp end do
+
+  if (pipelined) then
+     !$omp master
+     !input: I1,J2,j3,Jp2,(jp3), for the j3 of the chunk
+     if (spcomm) then
+        call PS_transpose_chunk(nproc,planes_comm,1,2*n1dim*(md2/nproc)*(jend-jstart+1),&
+             nslice,2*n1dim*(md2/nproc)*(jstart-1),nslice,MPI_REAL,&
+             zmpi1_sbuf,zmpi2_sbuf,ichunk,requests)
+     else
+        call PS_transpose_chunk(nproc,planes_comm,1,2*n1dim*(md2/nproc)*(jend-jstart+1),&
+             nslice,2*n1dim*(md2/nproc)*(jstart-1),nslice,MPI_DOUBLE_PRECISION,&
+             zmpi1,zmpi2,ichunk,requests)
+     end if
+     !$omp end master
+  end if
+  end do
     !$omp critical
     !do i = 1, 6
     !  strten(j) = strten(j) + strten_omp(j)
@@ -866,7 +1013,9 @@ subroutine G_PoissonSolver(iproc,nproc,planes_comm,iproc_inplane,inplane_comm,nc
 !TRANSFORM BACK IN Y
     !Interprocessor data transposition
     !input: I1,J2,j3,Jp2,(jp3)
-    if (nproc > 1 .and. iproc < n3pr1*n3pr2) then
+    if (pipelined) then
+       call PS_transpose_wait(nchunk3,requests)
+    else if (nproc > 1 .and. iproc < n3pr1*n3pr2) then
        call f_timing(TCAT_PSOLV_COMPUT,'OF')
        call f_timing(TCAT_PSOLV_COMMUN,'ON')
        !communication scheduling
@@ -881,6 +1030,7 @@ subroutine G_PoissonSolver(iproc,nproc,planes_comm,iproc_inplane,inplane_comm,nc
     nd3=nd3*n3pr1
   !$omp end master
   !$omp barrier
+  if (spcomm) call PS_buffer_to_dp(nslice*nproc,zmpi2_s,zmpi2)
 
   !transform along z axis
   !input: I1,J2,i3,(Jp2)
@@ -907,11 +1057,17 @@ subroutine G_PoissonSolver(iproc,nproc,planes_comm,iproc_inplane,inplane_comm,nc
            !performing FFT
            !input: I1,i3,J2,(Jp2)
            inzee=1
-           do i=1,ic3
-              call fftstp_sg(lot,nfft,n3dim,lot,n3dim,zw(1,1,inzee,ithread), &
-                zw(1,1,3-inzee,ithread),ntrig,ftrig3,after3(i),now3(i),before3(i),-1)
-              inzee=3-inzee
-           enddo
+           if (use_fftw) then
+              call fftw_1d_psolver_many(n3dim,nfft,zw(1,1,1,ithread),lot,&
+                   zw(1,1,2,ithread),lot,-1)
+              inzee=2
+           else
+              do i=1,ic3
+                 call fftstp_sg(lot,nfft,n3dim,lot,n3dim,zw(1,1,inzee,ithread), &
+                   zw(1,1,3-inzee,ithread),ntrig,ftrig3,after3(i),now3(i),before3(i),-1)
+                 inzee=3-inzee
+              enddo
+           end if
            !output: I1,I3,J2,(Jp2)
 
            !rebuild the output array
@@ -957,6 +1113,11 @@ subroutine G_PoissonSolver(iproc,nproc,planes_comm,iproc_inplane,inplane_comm,nc
   if (nproc > 1) then
      call f_free(zmpi1)
   end if
+  if (pipelined) call f_free(requests)
+  if (spcomm) then
+     call f_free(zmpi1_sbuf)
+     call f_free(zmpi2_sbuf)
+  end if
   call f_timing(TCAT_PSOLV_COMPUT,'OF')
 
   call f_perf_set_model(performance_info,F_PERF_GFLOPS,nint(gflops_fft,f_long))
@@ -969,6 +1130,123 @@ subroutine G_PoissonSolver(iproc,nproc,planes_comm,iproc_inplane,inplane_comm,nc
 END SUBROUTINE G_PoissonSolver
 
 
+!> Post the non-blocking transposition of a chunk of planes of G_PoissonSolver.
+!! The send and receive buffers are made of nproc slices of nslice elements of type
+!! mpitype, one for each process, and the chunk takes nblocks blocks of blocklen elements,
+!! separated by stride elements, starting at offset in each slice.
+!! The previous requests are tested to let the communications progress.
+subroutine PS_transpose_chunk(nproc,comm,nblocks,blocklen,stride,offset,nslice,mpitype,&
+     sendbuf,recvbuf,ichunk,requests)
+  use Poisson_Solver, only: dp, TCAT_PSOLV_COMPUT, TCAT_PSOLV_COMPOST
+  use wrapper_mpi
+  use time_profiling, only: f_timing
+  use dictionaries, only: f_err_throw
+  implicit none
+  integer, intent(in) :: nproc,comm,nblocks,blocklen,stride,offset,nslice,mpitype,ichunk
+  !> the buffers are declared in double precision also for single precision transpositions
+  real(dp), dimension(*), intent(in) :: sendbuf
+  real(dp), dimension(*), intent(inout) :: recvbuf
+  integer, dimension(ichunk), intent(inout) :: requests
+  !local variables
+  logical :: flag
+  integer :: ierr,jproc,vectype,chunktype
+  integer(fmpi_address) :: lb,extent
+  integer, dimension(0:nproc-1) :: counts,displs
+
+  call f_timing(TCAT_PSOLV_COMPUT,'OF')
+  call f_timing(TCAT_PSOLV_COMPOST,'ON')
+
+  !the extent is reduced to one element such that the displacements are counted in elements
+  call MPI_TYPE_VECTOR(nblocks,blocklen,stride,mpitype,vectype,ierr)
+  call MPI_TYPE_GET_EXTENT(mpitype,lb,extent,ierr)
+  call MPI_TYPE_CREATE_RESIZED(vectype,lb,extent,chunktype,ierr)
+  call MPI_TYPE_COMMIT(chunktype,ierr)
+  do jproc=0,nproc-1
+     counts(jproc)=1
+     displs(jproc)=jproc*nslice+offset
+  end do
+  requests(ichunk)=FMPI_REQUEST_NULL
+  call MPI_IALLTOALLV(sendbuf,counts,displs,chunktype,&
+       recvbuf,counts,displs,chunktype,comm,requests(ichunk),ierr)
+  if (ierr /= FMPI_SUCCESS) call f_err_throw('An error in calling to MPI_IALLTOALLV occured',&
+       err_id=ERR_MPI_WRAPPERS)
+  !pending communications keep their own reference to the datatypes
+  call MPI_TYPE_FREE(chunktype,ierr)
+  call MPI_TYPE_FREE(vectype,ierr)
+
+  call MPI_TESTALL(ichunk,requests,flag,FMPI_STATUSES_IGNORE,ierr)
+
+  call f_timing(TCAT_PSOLV_COMPOST,'OF')
+  call f_timing(TCAT_PSOLV_COMPUT,'ON')
+
+END SUBROUTINE PS_transpose_chunk
+
+
+!> Complete the pipelined transposition of G_PoissonSolver
+subroutine PS_transpose_wait(nchunk,requests)
+  use Poisson_Solver, only: TCAT_PSOLV_COMPUT, TCAT_PSOLV_COMWAIT
+  use wrapper_mpi
+  use time_profiling, only: f_timing
+  use dictionaries, only: f_err_throw
+  implicit none
+  integer, intent(in) :: nchunk
+  integer, dimension(nchunk), intent(inout) :: requests
+  !local variables
+  integer :: ierr
+
+  call f_timing(TCAT_PSOLV_COMPUT,'OF')
+  call f_timing(TCAT_PSOLV_COMWAIT,'ON')
+  call MPI_WAITALL(nchunk,requests,FMPI_STATUSES_IGNORE,ierr)
+  if (ierr /= FMPI_SUCCESS) call f_err_throw('An error in calling to MPI_WAITALL occured',&
+       err_id=ERR_MPI_WRAPPERS)
+  call f_timing(TCAT_PSOLV_COMWAIT,'OF')
+  call f_timing(TCAT_PSOLV_COMPUT,'ON')
+
+END SUBROUTINE PS_transpose_wait
+
+
+!> Copy to the single precision buffer of a transposition nblocks blocks of
+!! blocklen elements, separated by stride elements and starting at offset.
+!! Called by each thread for its own planes
+subroutine PS_buffer_to_sp(nblocks,blocklen,stride,offset,buf,buf_s)
+  use Poisson_Solver, only: dp
+  implicit none
+  integer, intent(in) :: nblocks,blocklen,stride,offset
+  real(dp), dimension(*), intent(in) :: buf
+  real(kind=4), dimension(*), intent(inout) :: buf_s
+  !local variables
+  integer :: iblock,i,istart
+
+  do iblock=0,nblocks-1
+     istart=offset+iblock*stride
+     do i=istart+1,istart+blocklen
+        buf_s(i)=real(buf(i),kind=4)
+     end do
+  end do
+
+END SUBROUTINE PS_buffer_to_sp
+
+
+!> Copy back the received single precision buffer of a transposition,
+!! to be called by all the threads of the parallel region
+subroutine PS_buffer_to_dp(n,buf_s,buf)
+  use Poisson_Solver, only: dp
+  implicit none
+  integer, intent(in) :: n
+  real(kind=4), dimension(n), intent(in) :: buf_s
+  real(dp), dimension(n), intent(inout) :: buf
+  !local variables
+  integer :: i
+
+  !$omp do schedule(static)
+  do i=1,n
+     buf(i)=real(buf_s(i),dp)
+  end do
+  !$omp end do
+
+END SUBROUTINE PS_buffer_to_dp
+
+
 !> General routine, takes into account the free boundary conditions
 subroutine G_mpiswitch_upcorn(j3,nfft,Jp2stb,J2stb,lot,&
      n1,n1dim,md2,nd3,nproc,zmpi1,zw)
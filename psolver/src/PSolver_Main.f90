@@ -163,6 +163,12 @@ subroutine Electrostatic_Solver(kernel,rhov,energies,pot_ion,rho_ion,ehartree)
      call yaml_map('Box',kernel%mesh%ndims,fmt='(i5)')
      call yaml_map('MPI tasks',kernel%mpi_env%nproc,fmt='(i5)')
      if (cudasolver) call yaml_map('GPU acceleration',.true.)
+     if (kernel%igpu==2 .and. .not. kernel%opt%calculate_strten) call yaml_map('FFTW solver',.true.)
+     if (kernel%fftw_1d) call yaml_map('FFTW solver','slab-decomposed')
+     if (kernel%transpose_chunks > 1 .and. kernel%mpi_env%nproc > 1 .and. .not. cudasolver) &
+          call yaml_map('Pipelined transpositions',kernel%transpose_chunks)
+     if (kernel%mixed_precision > 0.0_dp .and. kernel%mpi_env%nproc > 1 .and. .not. cudasolver) &
+          call yaml_map('Single precision MPI transpositions until residual',kernel%mixed_precision)
   end if
   
   !in the case of SC cavity, gather the full density and determine the depsdrho
@@ -469,6 +475,7 @@ subroutine Parallel_GPS(kernel,cudasolver,offset,strten,wrtmsg,rho_dist,use_inpu
   real(dp), parameter :: max_ratioex = 1.0e10_dp !< just to avoid crazy results
   real(dp), parameter :: no_ig_minres=1.0d-2 !< just to neglect wrong inputguess
   integer :: n1,n23,i1,i23,ip,i23s,iinit
+  logical :: single
   real(dp) :: rpoints,rhores2,beta,ratio,normr,normb,alpha,q
   !aliasings
   call f_timing(TCAT_PSOLV_COMPUT,'ON')
@@ -477,13 +484,21 @@ subroutine Parallel_GPS(kernel,cudasolver,offset,strten,wrtmsg,rho_dist,use_inpu
   n23=kernel%grid%m3*kernel%grid%n3p
   n1=kernel%grid%m1
 
+  !mixed precision: the data of the MPI transpositions of the FFT are sent in
+  !single precision until the residual of the loop gets below the threshold, the
+  !following iterations in double precision refine the solution. The FFTs, the
+  !kernel multiplication and the GPS loops are always in double precision.
+  !The residuals compared with the threshold are root mean squares, as for minres
+  single=kernel%mixed_precision > 0.0_dp
+
   !now switch the treatment according to the method used
   select case(trim(toa(kernel%method)))
   case('VAC')
      !initalise to zero the zf array 
      !call f_zero(kernel%w%zf)
-     !core psolver routine
-     call apply_kernel(cudasolver,kernel,rho_dist,offset,strten,kernel%w%zf,.false.)
+     !core psolver routine, the residual is the one of the calling loop
+     single=single .and. kernel%opt%scf_residual > kernel%mixed_precision
+     call apply_kernel(cudasolver,kernel,rho_dist,offset,strten,kernel%w%zf,.false.,single)
   case('PI')
 
      if (wrtmsg) &
@@ -519,7 +534,7 @@ subroutine Parallel_GPS(kernel,cudasolver,offset,strten,wrtmsg,rho_dist,use_inpu
         !initalise to zero the zf array 
         !call f_zero(kernel%w%zf)
         call apply_kernel(cudasolver,kernel,kernel%w%pot(1,i23s+1),&
-             offset,strten,kernel%w%zf,.true.)
+             offset,strten,kernel%w%zf,.true.,single)
         !gathering the data to obtain the distribution array
         call PS_gather(kernel%w%pot,kernel)
 
@@ -528,6 +543,7 @@ subroutine Parallel_GPS(kernel,cudasolver,offset,strten,wrtmsg,rho_dist,use_inpu
         call update_rhopol(kernel%mesh,kernel%w%pot,kernel%nord,kernel%PI_eta,kernel%w%eps,&
              kernel%w%dlogeps,kernel%w%rho,rhores2)
 
+        !from now on the root mean square of the residual
         rhores2=sqrt(rhores2/rpoints)
 
         if (wrtmsg) then 
@@ -537,6 +553,7 @@ subroutine Parallel_GPS(kernel,cudasolver,offset,strten,wrtmsg,rho_dist,use_inpu
         end if
 
         if (rhores2 < kernel%minres) exit pi_loop
+        single=single .and. rhores2 > kernel%mixed_precision
 
         if ((rhores2 > no_ig_minres).and.use_input_guess .and. iinit==NEVER_DONE) then
            call f_zero(kernel%w%rho)
@@ -578,7 +595,7 @@ subroutine Parallel_GPS(kernel,cudasolver,offset,strten,wrtmsg,rho_dist,use_inpu
       end do
       !$omp end parallel do
  
-      call apply_kernel(cudasolver,kernel,kernel%w%z,offset,strten,kernel%w%zf,.true.)
+      call apply_kernel(cudasolver,kernel,kernel%w%z,offset,strten,kernel%w%zf,.true.,single)
 
       normr=0.0_dp
       !$omp parallel do default(shared) private(i1,i23) &
@@ -612,6 +629,7 @@ subroutine Parallel_GPS(kernel,cudasolver,offset,strten,wrtmsg,rho_dist,use_inpu
        call EPS_iter_output(1,0.0_dp,normr,0.0_dp,0.0_dp,0.0_dp)
       end if
       if (normr < kernel%minres) iinit=kernel%max_iter+10
+      single=single .and. normr > kernel%mixed_precision
  
       if (normr > no_ig_minres ) then
  
@@ -649,7 +667,7 @@ subroutine Parallel_GPS(kernel,cudasolver,offset,strten,wrtmsg,rho_dist,use_inpu
         !initalise to zero the zf array 
         !call f_zero(kernel%w%zf)
         !  Apply the Preconditioner
-        call apply_kernel(cudasolver,kernel,kernel%w%z,offset,strten,kernel%w%zf,.true.)
+        call apply_kernel(cudasolver,kernel,kernel%w%z,offset,strten,kernel%w%zf,.true.,single)
 
         call apply_reductions(ip,cudasolver,kernel,&
              kernel%w%res,kernel%w%pot,kernel%w%p,kernel%w%q,kernel%w%z,&
@@ -665,6 +683,7 @@ subroutine Parallel_GPS(kernel,cudasolver,offset,strten,wrtmsg,rho_dist,use_inpu
            call EPS_iter_output(ip,0.0_dp,normr,0.0_dp,0.0_dp,0.0_dp)
         end if
         if (normr < kernel%minres .or. normr > max_ratioex) exit PCG_loop
+        single=single .and. normr > kernel%mixed_precision
      end do PCG_loop
      if (wrtmsg) call yaml_sequence_close()
   end select
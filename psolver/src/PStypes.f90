@@ -28,6 +28,7 @@ module PStypes
   character(len=*), parameter :: SCREENING               = 'screening'
   character(len=*), parameter :: ISF_ORDER               = 'isf_order'
   character(len=*), parameter :: STRESS_TENSOR           = 'stress_tensor'
+  character(len=*), parameter :: CACHE_DIR               = 'cache_dir'
   character(len=*), parameter :: ENVIRONMENT_VARIABLES   = 'environment'
   character(len=*), parameter :: CAVITY_KEY              = 'cavity'
   character(len=*), parameter :: EPSILON_KEY             = 'epsilon'
@@ -56,6 +57,8 @@ module PStypes
   character(len=*), parameter :: KEEP_GPU_MEMORY         = 'keep_gpu_memory'
   character(len=*), parameter :: USE_GPU_DIRECT          = 'use_gpu_direct'
   character(len=*), parameter :: TASKGROUP_SIZE_KEY      = 'taskgroup_size'
+  character(len=*), parameter :: TRANSPOSE_CHUNKS        = 'transpose_chunks'
+  character(len=*), parameter :: MIXED_PRECISION         = 'mixed_precision'
   character(len=*), parameter :: GLOBAL_DATA             = 'global_data'
   character(len=*), parameter, public :: VERBOSITY               = 'verbose'
   character(len=*), parameter :: OUTPUT                  = 'output'
@@ -65,6 +68,9 @@ module PStypes
   integer, parameter :: RADII_BONDI_ID = 2
   integer, parameter :: RADII_UFF_ID = 3
 
+  !> number of sizes of the reduced kernels in each isolated direction
+  integer, parameter :: REDUCED_KERNEL_LEVELS = 4
+
 
   !> Defines the internal information for application of the FFT between the kernel and the density
   type, public :: FFT_metadata
@@ -126,6 +132,10 @@ module PStypes
      integer(f_address) :: p_GPU,q_GPU,r_GPU,x_GPU,z_GPU,oneoeps_GPU,corr_GPU!<addresses for the GPU memory
      !> GPU scalars. Event if they are scalars of course their address is needed
      integer(f_address) :: alpha_GPU, beta_GPU, kappa_GPU, beta0_GPU, eexctX_GPU, reduc_GPU, ehart_GPU
+     !> work arrays of the FFTW solver (igpu=2), the plans are bound to them
+     real(dp), dimension(:), pointer :: work1_fftw,work2_fftw
+     !> kernel in the transposed layout of the FFTW solver
+     real(dp), dimension(:), pointer :: k_fftw
   end type PS_workarrays
 
 
@@ -158,6 +168,10 @@ module PStypes
      !! to calculate the forces (nabla2pot times epsilon minus one)
      logical :: final_call
      real(gp) :: potential_integral
+     !> Residual of the loop calling the solver (e.g. the SCF one), compared to the
+     !! mixed_precision threshold of the kernel for the vacuum solver. Zero when the
+     !! caller does not give it, hence vacuum solves are then in double precision
+     real(gp) :: scf_residual
   end type PSolver_options
 
 
@@ -199,7 +213,10 @@ module PStypes
      type(cavity_data) :: cavity !< description of the cavity for the dielectric medium
      type(PSolver_options) :: opt !<Datatype controlling the operations of the solver
      real(dp), dimension(:), pointer :: kernel !< kernel of the Poisson Solver
+     character(len=256) :: cache_dir !< directory of the on-disk kernel cache, empty if not used
+     logical :: kernel_from_cache !< kernel%kernel has been read from the cache instead of built
      integer, dimension(5) :: plan
+     integer(f_address), dimension(12) :: fftw_plan !< FFTW plans, kept for the lifetime of the kernel
      integer, dimension(3) :: geo
      !>workarrays for the application of the Solver. Might have different
      !!memory footprints dependently of the treatment.
@@ -210,10 +227,18 @@ module PStypes
      type(FFT_metadata) :: grid !<dimensions of the FFT grid associated to this kernel
      logical :: use_gpu_direct
      integer :: igpu !< control the usage of the GPU
+     !> FFTW transforms in the slab-decomposed solver, for accel: FFTW with more than one task
+     logical :: fftw_1d
      integer :: gpuPCGRed !< control if GPU can be used for PCG reductions
      integer :: initCufftPlan
      integer :: keepGPUmemory
      integer :: stay_on_gpu
+     !> number of chunks of the pipelined MPI transpositions of the FFT,
+     !! blocking MPI_ALLTOALL if lower than 2
+     integer :: transpose_chunks
+     !> residual below which the MPI transpositions of the FFT go back to double precision,
+     !! they are always in double precision if zero
+     real(dp) :: mixed_precision
      integer :: keepzf
      !parameters for the iterative methods
      !> Order of accuracy for the finite difference nabla, used for nonvacuum calculations (only in SC).
@@ -239,6 +264,20 @@ module PStypes
      integer, dimension(:), pointer :: rhodispls !< Array needed to gather the information of the Poisson solver on multiple gpus
   end type coulomb_operator
 
+  !> Sequential kernels of an operator on boxes reduced in its isolated directions.
+  !! The sizes of the boxes go by steps of a quarter of the mesh,
+  !! each kernel is built at the first density which needs it
+  type, public :: reduced_kernels
+     integer, dimension(3) :: nlev    !< number of box sizes in each direction
+     integer, dimension(3) :: quantum !< step of the box sizes, in grid points
+     !> description of a batch of densities: couple of objects, kernel,
+     !! starting point and sizes of the box, offsets of the density and of the zf array in work
+     !! and end of the zf array
+     integer, dimension(:,:), pointer :: batch
+     real(dp), dimension(:), pointer :: work !< densities and zf arrays of a batch, as big as for the whole mesh
+     type(coulomb_operator), dimension(:), pointer :: kernels !< kernels of each combination of sizes
+  end type reduced_kernels
+
 
   !> Define the energy terms for the Poisson and Generalized poisson operator applications
   type, public :: PSolver_energies
@@ -264,6 +303,7 @@ module PStypes
   public :: ps_allocate_lowlevel_workarrays,PSolver_options_null,PS_input_dict
   public :: release_PS_potential,PS_release_lowlevel_workarrays,PS_set_options,pkernel_init
   public :: ps_soft_PCM_forces,pkernel_get_radius,epsilon_inner_cavity
+  public :: reduced_kernels_null,reduced_kernels_new,reduced_kernels_free
 
   !To specify properly to doxygen (test)
   private :: free_PS_workarrays, PS_fill_variables, PS_input_fill
@@ -296,6 +336,7 @@ contains
     o%only_electrostatic =.true.
     o%final_call         =.false.
     o%potential_integral =0.0_gp
+    o%scf_residual       =0.0_gp
    end function PSolver_options_null
 
   pure function FFT_metadata_null() result(d)
@@ -342,6 +383,9 @@ contains
     nullify(w%q)
     nullify(w%eps)
     nullify(w%rho_ions)
+    nullify(w%work1_fftw)
+    nullify(w%work2_fftw)
+    nullify(w%k_fftw)
     call f_zero(w%work1_GPU)
     call f_zero(w%work2_GPU)
     call f_zero(w%rho_GPU)
@@ -377,7 +421,10 @@ contains
 !    k%ndims=(/0,0,0/)
 !    k%hgrids=(/0.0_gp,0.0_gp,0.0_gp/)
     nullify(k%kernel)
+    k%cache_dir=''
+    k%kernel_from_cache=.false.
     k%plan=(/0,0,0,0,0/)
+    k%fftw_plan=int(0,f_address)
     k%geo=(/0,0,0/)
     call nullify_work_arrays(k%w)
     call nullify_mpi_environment(k%mpi_env)
@@ -385,8 +432,11 @@ contains
     call nullify_mpi_environment(k%part_mpi)
     k%grid=FFT_metadata_null()
     k%igpu=0
+    k%fftw_1d=.false.
     k%initCufftPlan=0
     k%keepGPUmemory=1
+    k%transpose_chunks=0
+    k%mixed_precision=0.0_dp
     k%use_gpu_direct=.false.
     k%keepzf=1
     k%nord=0
@@ -426,6 +476,9 @@ contains
     call f_free_ptr(w%p)
     call f_free_ptr(w%q)
     if(keepzf == 1) call f_free_ptr(w%zf)
+    call f_free_ptr(w%work1_fftw)
+    call f_free_ptr(w%work2_fftw)
+    call f_free_ptr(w%k_fftw)
     if (gpuPCGRed == 1) then
        if (keepGPUmemory == 1) then
           call cudafree(w%z_GPU)
@@ -482,10 +535,14 @@ contains
     call free_PS_workarrays(kernel%mpi_env%iproc,kernel%igpu,&
          kernel%keepzf,kernel%gpuPCGred,kernel%keepGPUmemory,kernel%w)
     !free GPU data
+    if (kernel%igpu > 0 .and. kernel%mpi_env%iproc == 0) then
+       call f_free_ptr(kernel%rhocounts)
+       call f_free_ptr(kernel%rhodispls)
+    end if
+    if (kernel%igpu == 2 .and. kernel%mpi_env%iproc == 0) &
+         call fftw_3d_psolver_destroy_plan(kernel%fftw_plan)
     if (kernel%igpu == 1) then
        if (kernel%mpi_env%iproc == 0) then
-          call f_free_ptr(kernel%rhocounts)
-          call f_free_ptr(kernel%rhodispls)
           if (kernel%initCufftPlan == 1) then
              call cufftDestroy(kernel%plan(1))
              call cufftDestroy(kernel%plan(2))
@@ -499,6 +556,74 @@ contains
     call release_mpi_environment(kernel%mpi_env)
   end subroutine pkernel_free
 
+  pure function reduced_kernels_null() result(rk)
+    implicit none
+    type(reduced_kernels) :: rk
+    rk%nlev=0
+    rk%quantum=0
+    nullify(rk%batch)
+    nullify(rk%work)
+    nullify(rk%kernels)
+  end function reduced_kernels_null
+
+  !> Reduced kernels of the operator kernel, none of them is built yet.
+  !! They exist only for an operator applied on the CPU by a single process,
+  !! otherwise the result stays null
+  function reduced_kernels_new(kernel) result(rk)
+    use at_domain, only: domain_periodic_dims
+    use yaml_output, only: yaml_comment
+    implicit none
+    type(coulomb_operator), intent(in) :: kernel
+    type(reduced_kernels) :: rk
+    !local variables
+    integer :: ik,nbatch
+    logical, dimension(3) :: peri
+    !$ integer, external :: omp_get_max_threads
+
+    rk=reduced_kernels_null()
+    if (kernel%igpu /= 0 .or. kernel%mpi_env%nproc > 1) then
+       if (kernel%mpi_env%iproc == 0) call yaml_comment(&
+            'Exact exchange: no reduced boxes for a GPU or distributed kernel, the couples are solved in the full box')
+       return
+    end if
+
+    !a smaller box would change the period, the angles of the cell are not reduced either
+    peri=domain_periodic_dims(kernel%mesh%dom)
+    rk%nlev=1
+    if (kernel%mesh%dom%orthorhombic) then
+       where (.not. peri) rk%nlev=REDUCED_KERNEL_LEVELS
+    end if
+    rk%quantum=(kernel%mesh%ndims+rk%nlev-1)/rk%nlev
+    allocate(rk%kernels(product(rk%nlev)))
+    do ik=1,size(rk%kernels)
+       rk%kernels(ik)=pkernel_null()
+    end do
+
+    !at most one density per thread in a batch
+    nbatch=1
+    !$ nbatch=omp_get_max_threads()
+    rk%batch=f_malloc0_ptr([12,nbatch],id='rk%batch')
+    rk%work=f_malloc_ptr(kernel%grid%md1*kernel%grid%md3*2*(kernel%grid%md2/kernel%mpi_env%nproc)+&
+         int(kernel%mesh%ndim),id='rk%work')
+  end function reduced_kernels_new
+
+  subroutine reduced_kernels_free(rk)
+    implicit none
+    type(reduced_kernels), intent(inout) :: rk
+    !local variables
+    integer :: ik
+
+    if (associated(rk%kernels)) then
+       do ik=1,size(rk%kernels)
+          if (associated(rk%kernels(ik)%kernel)) call pkernel_free(rk%kernels(ik))
+       end do
+       deallocate(rk%kernels)
+    end if
+    call f_free_ptr(rk%batch)
+    call f_free_ptr(rk%work)
+    rk=reduced_kernels_null()
+  end subroutine reduced_kernels_free
+
   !> Initialization of the Poisson kernel starting from the box and boundary
   !! conditions data.
   !function pkernel_init(iproc,nproc,dict,geocode,ndims,hgrids,alpha_bc,beta_ac,gamma_ab,mpi_env) result(kernel)
@@ -556,15 +681,18 @@ contains
 
        group_size=nproc
        !if the taskgroup size is not a divisor of nproc do not create taskgroups
-       if (nproc >1 .and. taskgroup_size > 0 .and. taskgroup_size < nproc .and.&
-            mod(nproc,taskgroup_size)==0) then
-          group_size=taskgroup_size
+       if (nproc >1 .and. taskgroup_size > 0 .and. taskgroup_size < nproc) then
+          if (mod(nproc,taskgroup_size)==0) group_size=taskgroup_size
        end if
        call mpi_environment_set(kernel%mpi_env,iproc,nproc,mpiworld(),group_size)
     end if
 
-    !gpu can be used only for one nproc
-    if (nproc > 1) kernel%igpu=0
+    !gpu can be used only for one nproc, the FFTW solver goes to the
+    !FFTW transforms of the slab-decomposed solver
+    if (nproc > 1) then
+       kernel%fftw_1d = kernel%igpu == 2
+       kernel%igpu=0
+    end if
 
     !-------------------
     nthreads=0
@@ -582,6 +710,8 @@ contains
        call yaml_map('MPI tasks',kernel%mpi_env%nproc)
        if (nthreads /=0) call yaml_map('OpenMP threads per MPI task',nthreads)
        if (kernel%igpu==1) call yaml_map('Kernel copied on GPU',.true.)
+       if (kernel%igpu==2) call yaml_map('FFTW solver',.true.)
+       if (kernel%fftw_1d) call yaml_map('FFTW solver','slab-decomposed')
        if (kernel%method /= 'VAC') call yaml_map('Iterative method for Generalised Equation',toa(kernel%method))
        if (kernel%method .hasattr. PS_RIGID_ENUM) call yaml_map('Cavity determination','rigid')
        if (kernel%method .hasattr. PS_SCCS_ENUM) call yaml_map('Cavity determination','sccs')
@@ -593,7 +723,7 @@ contains
   !>modifies the options of the poisson solver to switch certain options
   subroutine PS_set_options(kernel,global_data,calculate_strten,verbose,&
        update_cavity,use_input_guess,cavity_info,cavitation_terms,&
-       potential_integral,final_call)
+       potential_integral,final_call,scf_residual)
     implicit none
     type(coulomb_operator), intent(inout) :: kernel
     logical, intent(in), optional :: global_data,calculate_strten,verbose
@@ -601,6 +731,8 @@ contains
     logical, intent(in), optional :: cavity_info,cavitation_terms
     logical, intent(in), optional :: final_call
     real(gp), intent(in), optional :: potential_integral
+    !> residual of the calling loop, to switch the transpositions back to double precision
+    real(gp), intent(in), optional :: scf_residual
 
     if (present(global_data)) then
        if (global_data) then
@@ -623,6 +755,7 @@ contains
     if (present(cavitation_terms)) kernel%opt%only_electrostatic=.not. cavitation_terms
     if (present(potential_integral)) kernel%opt%potential_integral =potential_integral
     if (present(final_call)) kernel%opt%final_call=final_call
+    if (present(scf_residual)) kernel%opt%scf_residual=scf_residual
 
   end subroutine PS_set_options
 
@@ -743,6 +876,9 @@ contains
           k%itype_scf=val
        case(STRESS_TENSOR)
           opt%calculate_strten=val
+       case(CACHE_DIR)
+          strn=val
+          if (trim(strn) /= 'none') k%cache_dir=strn
        case DEFAULT
           if (k%mpi_env%iproc==0) &
                call yaml_warning("unknown input key '" // trim(level) // "/" // trim(dict_key(val)) // "'")
@@ -845,6 +981,8 @@ contains
           select case(trim(strn))
           case('CUDA')
              k%igpu=1
+          case('FFTW')
+             k%igpu=2
           case('none')
              k%igpu=0
           end select
@@ -859,6 +997,10 @@ contains
           k%use_gpu_direct=val
        case (TASKGROUP_SIZE_KEY)
 
+       case (TRANSPOSE_CHUNKS)
+          k%transpose_chunks=val
+       case (MIXED_PRECISION)
+          k%mixed_precision=val
        case (GLOBAL_DATA)
           dummy_l=val
           if (dummy_l) then
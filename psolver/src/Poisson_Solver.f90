@@ -85,6 +85,8 @@ module Poisson_Solver
    integer, public, save :: TCAT_PSOLV_COMPUT=TIMING_UNINITIALIZED
    integer, public, save :: TCAT_PSOLV_COMMUN=TIMING_UNINITIALIZED
    integer, public, save :: TCAT_PSOLV_KERNEL=TIMING_UNINITIALIZED
+   integer, public, save :: TCAT_PSOLV_COMPOST=TIMING_UNINITIALIZED
+   integer, public, save :: TCAT_PSOLV_COMWAIT=TIMING_UNINITIALIZED
 
    include 'configure.inc'
 
@@ -95,6 +97,8 @@ module Poisson_Solver
    ! Routine that creates the kernel
    public :: pkernel_init, pkernel_set, pkernel_free, pkernel_set_epsilon, pkernel_allocate_cavity,pkernel_get_radius
    public :: rebuild_cavity_from_rho
+   ! Kernels of the reduced boxes
+   public :: reduced_kernels,reduced_kernels_null,reduced_kernels_new,reduced_kernels_free,reduced_kernel
    ! Calculate the poisson solver
    public :: H_potential,Electrostatic_Solver,PS_set_options
    ! Calculate the allocation dimensions
@@ -145,6 +149,12 @@ contains
   call f_timing_category('PSolver Communication',comm,&
        'MPI_ALLTOALL and MPI_ALLGATHERV',&
        TCAT_PSOLV_COMMUN)
+  call f_timing_category('PSolver Comm. Posting',comm,&
+       'MPI_IALLTOALLV of the pipelined transpositions',&
+       TCAT_PSOLV_COMPOST)
+  call f_timing_category('PSolver Comm. Wait',comm,&
+       'Part of the pipelined transpositions not overlapped with the FFTs',&
+       TCAT_PSOLV_COMWAIT)
 
   end subroutine PS_initialize_timing_categories
 
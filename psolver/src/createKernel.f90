@@ -146,8 +146,12 @@ function pkernel_init_old(verb,iproc,nproc,igpu,geocode,ndims,hgrids,itype_scf,&
      call mpi_environment_set(kernel%mpi_env,iproc,nproc,MPI_COMM_WORLD,group_size)
   end if
 
-  !gpu can be used only for one nproc
-  if (nproc > 1) kernel%igpu=0
+  !gpu can be used only for one nproc, the FFTW solver goes to the
+  !FFTW transforms of the slab-decomposed solver
+  if (nproc > 1) then
+     kernel%fftw_1d = kernel%igpu == 2
+     kernel%igpu=0
+  end if
 
   !-------------------
   nthreads=0
@@ -210,6 +214,7 @@ subroutine pkernel_set(kernel,eps,dlogeps,oneoeps,oneosqrteps,corr,verbose) !opt
   integer :: myiproc_node, mynproc_node
   integer,dimension(3) :: n
   real(dp) :: p1,p2,mu3,ker
+  character(len=512) :: cache_key
   !call timing(kernel%mpi_env%iproc+kernel%mpi_env%igroup*kernel%mpi_env%nproc,'PSolvKernel   ','ON')
   call f_timing(TCAT_PSOLV_KERNEL,'ON')
   call f_routine(id='pkernel_set')
@@ -359,11 +364,15 @@ subroutine pkernel_set(kernel,eps,dlogeps,oneoeps,oneosqrteps,corr,verbose) !opt
 
 
      !the kernel must be built and scattered to all the processes
-     call Surfaces_Kernel(kernel%mpi_env%iproc,kernelnproc,&
-          kernel%mpi_env%mpi_comm,kernel%inplane_mpi%mpi_comm,&
-          n1,n2,n3,m3,nd1,nd2,nd3,&
-          kernel%mesh,&
-          kernel%itype_scf,kernel%kernel,mu0t)!,alphat)!,betat,gammat)!,n3pr2,n3pr1)
+     cache_key=kernel_cache_key(kernel,geocode,[n1,n2,n3],[nd1,nd2,nd3],[n3pr1,n3pr2],kernelnproc)
+     if (.not. kernel_cache_load(kernel,cache_key,dump)) then
+        call Surfaces_Kernel(kernel%mpi_env%iproc,kernelnproc,&
+             kernel%mpi_env%mpi_comm,kernel%inplane_mpi%mpi_comm,&
+             n1,n2,n3,m3,nd1,nd2,nd3,&
+             kernel%mesh,&
+             kernel%itype_scf,kernel%kernel,mu0t)!,alphat)!,betat,gammat)!,n3pr2,n3pr1)
+        call kernel_cache_store(kernel,cache_key,dump)
+     end if
 
      !last plane calculated for the density and the kernel
      nlimd=n2
@@ -426,9 +435,13 @@ subroutine pkernel_set(kernel,eps,dlogeps,oneoeps,oneosqrteps,corr,verbose) !opt
      !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
 
      !the kernel must be built and scattered to all the processes
-     call Free_Kernel(kernel%mesh%ndims(1),kernel%mesh%ndims(2),kernel%mesh%ndims(3),&
-          n1,n2,n3,nd1,nd2,nd3,kernel%mesh%hgrids(1),kernel%mesh%hgrids(2),kernel%mesh%hgrids(3),&
-          kernel%itype_scf,kernel%mpi_env%iproc,kernelnproc,kernel%kernel,mu0t,n3pr2,n3pr1)
+     cache_key=kernel_cache_key(kernel,geocode,[n1,n2,n3],[nd1,nd2,nd3],[n3pr1,n3pr2],kernelnproc)
+     if (.not. kernel_cache_load(kernel,cache_key,dump)) then
+        call Free_Kernel(kernel%mesh%ndims(1),kernel%mesh%ndims(2),kernel%mesh%ndims(3),&
+             n1,n2,n3,nd1,nd2,nd3,kernel%mesh%hgrids(1),kernel%mesh%hgrids(2),kernel%mesh%hgrids(3),&
+             kernel%itype_scf,kernel%mpi_env%iproc,kernelnproc,kernel%kernel,mu0t,n3pr2,n3pr1)
+        call kernel_cache_store(kernel,cache_key,dump)
+     end if
 
      !last plane calculated for the density and the kernel
      nlimd=n2/2
@@ -489,10 +502,14 @@ subroutine pkernel_set(kernel,eps,dlogeps,oneoeps,oneosqrteps,corr,verbose) !opt
 !!$     !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
 
 
-     call Wires_Kernel(kernel%mpi_env%iproc,kernelnproc,&
-          kernel%mesh%ndims(1),kernel%mesh%ndims(2),kernel%mesh%ndims(3),&
-          n1,n2,n3,nd1,nd2,nd3,kernel%mesh%hgrids(1),kernel%mesh%hgrids(2),kernel%mesh%hgrids(3),&
-          kernel%itype_scf,kernel%kernel,mu0t)
+     cache_key=kernel_cache_key(kernel,geocode,[n1,n2,n3],[nd1,nd2,nd3],[n3pr1,n3pr2],kernelnproc)
+     if (.not. kernel_cache_load(kernel,cache_key,dump)) then
+        call Wires_Kernel(kernel%mpi_env%iproc,kernelnproc,&
+             kernel%mesh%ndims(1),kernel%mesh%ndims(2),kernel%mesh%ndims(3),&
+             n1,n2,n3,nd1,nd2,nd3,kernel%mesh%hgrids(1),kernel%mesh%hgrids(2),kernel%mesh%hgrids(3),&
+             kernel%itype_scf,kernel%kernel,mu0t)
+        call kernel_cache_store(kernel,cache_key,dump)
+     end if
 
      nlimd=n2
      nlimk=n3/2+1
@@ -584,19 +601,20 @@ subroutine pkernel_set(kernel,eps,dlogeps,oneoeps,oneosqrteps,corr,verbose) !opt
 
   kernel%gpuPCGRed=0
   if (kernel%igpu >0) then
-    if(trim(toa(kernel%method))=='PCG') kernel%gpuPCGRed=1
     n(1)=n1!kernel%mesh%ndims(1)*(2-kernel%geo(1))
     n(2)=n3!kernel%mesh%ndims(2)*(2-kernel%geo(2))
     n(3)=n2!kernel%mesh%ndims(3)*(2-kernel%geo(3))
 
-
-    !perform the estimation of the processors
-    call mpinoderanks(kernel%mpi_env%iproc,kernel%mpi_env%nproc,kernel%mpi_env%mpi_comm,&
-         myiproc_node,mynproc_node)
+    if (kernel%igpu == 1) then
+      if(trim(toa(kernel%method))=='PCG') kernel%gpuPCGRed=1
+      !perform the estimation of the processors
+      call mpinoderanks(kernel%mpi_env%iproc,kernel%mpi_env%nproc,kernel%mpi_env%mpi_comm,&
+           myiproc_node,mynproc_node)
 
 
-    call cuda_estimate_memory_needs(kernel, n, &
-         int(myiproc_node,kind=8), int(mynproc_node,kind=8)) !LG: why longs?
+      call cuda_estimate_memory_needs(kernel, n, &
+           int(myiproc_node,kind=8), int(mynproc_node,kind=8)) !LG: why longs?
+    end if
 
     size2=2*n1*n2*n3
     sizek=(n1/2+1)*n2*n3
@@ -681,7 +699,11 @@ subroutine pkernel_set(kernel,eps,dlogeps,oneoeps,oneosqrteps,corr,verbose) !opt
     !offset to zero
     if (geocode == 'P') pkernel2(1)=0.0_dp
 
-    if (kernel%igpu == 2) kernel%kernel=pkernel2
+    !the CPU kernel is kept for the stress tensor, computed by G_PoissonSolver
+    if (kernel%igpu == 2) then
+      kernel%w%k_fftw=f_malloc_ptr(sizek,id='k_fftw')
+      call f_memcpy(src=pkernel2,dest=kernel%w%k_fftw)
+    end if
    endif
 
    if (kernel%mpi_env%iproc == 0) then
@@ -693,6 +715,13 @@ subroutine pkernel_set(kernel,eps,dlogeps,oneoeps,oneosqrteps,corr,verbose) !opt
       if (kernel%initCufftPlan == 1) then
         call cuda_3d_psolver_general_plan(n,kernel%plan,switch_alg,kernel%geo)
       endif
+    else if (kernel%igpu == 2) then
+      !the plans are measured once and bound to the work arrays
+      kernel%w%work1_fftw=f_malloc_ptr(size2,id='work1_fftw')
+      kernel%w%work2_fftw=f_malloc_ptr(size2,id='work2_fftw')
+      call fftw_3d_psolver_general_plan(n,kernel%fftw_plan,kernel%geo,&
+           kernel%w%work1_fftw,kernel%w%work2_fftw)
+      if (dump) call yaml_map('FFTW plans',.true.)
     endif
 
     call f_free(pkernel2)
@@ -821,6 +850,106 @@ end if
 END SUBROUTINE pkernel_set
 
 
+!> Description of the kernel slice of this task, key of the on-disk kernel cache.
+!! All the quantities which change the values of kernel%kernel on this task enter the key.
+function kernel_cache_key(kernel,geocode,n,nd,n3pr,kernelnproc) result(key)
+  implicit none
+  type(coulomb_operator), intent(in) :: kernel
+  character(len=1), intent(in) :: geocode
+  integer, dimension(3), intent(in) :: n,nd
+  integer, dimension(2), intent(in) :: n3pr
+  integer, intent(in) :: kernelnproc
+  character(len=512) :: key
+
+  write(key,'(a,1x,a1,16(1x,i0),10(1x,es24.17))') 'PSKERNEL',geocode,&
+       kernel%mesh%ndims,n,nd,n3pr,kernel%itype_scf,kernelnproc,kernel%mpi_env%iproc,&
+       min(kernel%igpu,1),size(kernel%kernel),kernel%mesh%habc,kernel%mu
+end function kernel_cache_key
+
+
+!> Fill kernel%kernel from the cache directory, if any.
+!! The kernels are built with collective operations, hence either all the tasks
+!! read their slice or all of them build it.
+function kernel_cache_load(kernel,key,dump) result(found)
+  use f_precisions, only: f_long
+  implicit none
+  type(coulomb_operator), intent(inout) :: kernel
+  character(len=*), intent(in) :: key
+  logical, intent(in) :: dump
+  logical :: found
+  !local variables
+  integer :: ifound
+
+  found=.false.
+  if (len_trim(kernel%cache_dir) == 0) return
+
+  call ps_kernel_cache_load(kernel%cache_dir,len_trim(kernel%cache_dir),key,len_trim(key),&
+       kernel%mpi_env%iproc,kernel%kernel,int(size(kernel%kernel),f_long),ifound)
+  found= ifound == 1
+  if (kernel%mpi_env%nproc > 1) &
+       call fmpi_allreduce(found,1,op=FMPI_LAND,comm=kernel%mpi_env%mpi_comm)
+  kernel%kernel_from_cache=found
+  if (dump .and. found) call yaml_map('Kernel read from cache',trim(kernel%cache_dir))
+end function kernel_cache_load
+
+
+!> Write the kernel slice of this task in the cache directory, if any.
+!! A failure only disables the reuse of this kernel, it is reported once for all the tasks.
+subroutine kernel_cache_store(kernel,key,dump)
+  use f_precisions, only: f_long
+  implicit none
+  type(coulomb_operator), intent(in) :: kernel
+  character(len=*), intent(in) :: key
+  logical, intent(in) :: dump
+  !local variables
+  integer :: ierr
+
+  if (len_trim(kernel%cache_dir) == 0) return
+
+  call ps_kernel_cache_store(kernel%cache_dir,len_trim(kernel%cache_dir),key,len_trim(key),&
+       kernel%mpi_env%iproc,kernel%kernel,int(size(kernel%kernel),f_long),ierr)
+  if (kernel%mpi_env%nproc > 1) &
+       call fmpi_allreduce(ierr,1,op=FMPI_MAX,comm=kernel%mpi_env%mpi_comm)
+  if (ierr /= 0) then
+     if (kernel%mpi_env%iproc == 0) &
+          call yaml_warning('Kernel cache: cannot write in '//trim(kernel%cache_dir))
+  else if (dump) then
+     call yaml_map('Kernel written in cache',trim(kernel%cache_dir))
+  end if
+end subroutine kernel_cache_store
+
+
+!> Index in rk%kernels of the kernel for the boxes with the sizes of levels lev,
+!! which is built at the first request. The index is 0 for the whole mesh,
+!! whose kernel is the original one
+function reduced_kernel(rk,kernel,lev) result(ik)
+  use dictionaries
+  implicit none
+  type(reduced_kernels), intent(inout) :: rk
+  type(coulomb_operator), intent(in) :: kernel !< original kernel
+  integer, dimension(3), intent(in) :: lev !< size of the box, in steps of rk%quantum
+  integer :: ik
+  !local variables
+  type(dictionary), pointer :: dict
+
+  ik=0
+  if (all(lev == rk%nlev)) return
+  ik=lev(1)+rk%nlev(1)*(lev(2)-1+rk%nlev(2)*(lev(3)-1))
+  if (associated(rk%kernels(ik)%kernel)) return
+
+  call dict_init(dict)
+  call set(dict//SETUP_VARIABLES//VERBOSITY,.false.)
+  rk%kernels(ik)=pkernel_init(0,1,dict,kernel%mesh%dom,min(lev*rk%quantum,kernel%mesh%ndims),&
+       kernel%mesh%hgrids,mpi_env=kernel%mpi_env)
+  call dict_free(dict)
+  !same operator as the original kernel, read from its cache if any
+  rk%kernels(ik)%itype_scf=kernel%itype_scf
+  rk%kernels(ik)%mu=kernel%mu
+  rk%kernels(ik)%cache_dir=kernel%cache_dir
+  call pkernel_set(rk%kernels(ik),verbose=.false.)
+end function reduced_kernel
+
+
 subroutine cuda_estimate_memory_needs(kernel, n,iproc_node, nproc_node)
   use iso_c_binding
   implicit none
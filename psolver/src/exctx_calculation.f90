@@ -26,8 +26,62 @@ subroutine internal_calculation_exctx(istep,factor,pkernel,norb,occup,spinsgn,re
   real(gp), intent(inout) :: eexctX
   real(wp), dimension(pkernel%mesh%ndim), intent(out) :: rp_ij
   !local variables
+  integer, dimension(2) :: npairs
+  integer, dimension(2,3,1) :: supports
+  type(reduced_kernels) :: rk
+  type(OP2P_data) :: OP2P
+
+  !no couple is skipped, all the densities span the whole box,
+  !and the messages of the ring are not progressed
+  npairs=0
+  supports=0
+  rk=reduced_kernels_null()
+  call nullify_OP2P_data(OP2P)
+  call screened_calculation_exctx(istep,factor,pkernel,norb,occup,spinsgn,remote_result,&
+       nloc_i,nloc_j,isloc_i,isloc_j,&
+       phi_i,phi_j,eexctX,rp_ij,.false.,supports,npairs,rk,OP2P)
+
+end subroutine internal_calculation_exctx
+
+
+!> Same as internal_calculation_exctx, but when screening is true the couples of objects
+!! whose supports do not intersect are skipped.
+!! The supports are boxes of grid points given for each global object,
+!! npairs counts the couples which have been (1) calculated and (2) skipped.
+!! If the kernels of rk exist, the Poisson equation of each couple is solved in the smallest
+!! reduced box containing the two supports, and the densities are solved by batches
+!! of one per thread.
+!! The pending messages of the OP2P ring are progressed after each Poisson solve
+subroutine screened_calculation_exctx(istep,factor,pkernel,norb,occup,spinsgn,remote_result,&
+     nloc_i,nloc_j,isloc_i,isloc_j,&
+     phi_i,phi_j,eexctX,rp_ij,screening,supports,npairs,rk,OP2P)
+  use PSbase, wp=>dp
+  use overlap_point_to_point
+  use Poisson_Solver
+  implicit none
+  logical, intent(in) :: remote_result
+  logical, intent(in) :: screening !<skip the couples whose supports are disjoint
+  integer, intent(in) :: istep !<step of the calculation
+  integer, intent(in) :: norb
+  integer, intent(in) :: nloc_i,nloc_j !<number of local elements to  be treated
+  integer, intent(in) :: isloc_i !<starting point of the elements for phi_i
+  integer, intent(in) :: isloc_j !<starting point of the elements for phi_j
+  real(gp), intent(in) :: factor !<overall factor to treat the data
+  real(gp), dimension(norb), intent(in) :: occup,spinsgn !<to treat the data
+  type(coulomb_operator), intent(inout) :: pkernel
+  type(local_data), intent(inout) :: phi_i,phi_j
+  real(gp), intent(inout) :: eexctX
+  real(wp), dimension(pkernel%mesh%ndim), intent(out) :: rp_ij
+  integer, dimension(2,3,*), intent(in) :: supports !<lower and upper grid points of each object
+  integer, dimension(2), intent(inout) :: npairs !<couples calculated and skipped
+  type(reduced_kernels), intent(inout) :: rk !<kernels of the reduced boxes
+  type(OP2P_data), intent(inout) :: OP2P !<descriptor of the ring which provides phi_j
+  !local variables
+  logical :: reduced
   integer :: iorb,jorb,ndim,iorb_glb,jorb_glb,ishift,jshift,ishift_res,jshift_res
+  integer :: i,ik,nb,nbatch,iwork,nzf
   real(gp) :: hfaci,hfacj,ehart
+  integer, dimension(3) :: lev,nbox
 !loop over all the orbitals
 !for the first step do only the upper triangular part
   !do iorb=iorbs,iorbs+norbi-1
@@ -35,6 +89,10 @@ subroutine internal_calculation_exctx(istep,factor,pkernel,norb,occup,spinsgn,re
 !!$     iorb=
 
   ndim=product(pkernel%mesh%ndims)
+  reduced=screening .and. associated(rk%kernels)
+  nb=0
+  iwork=0
+  if (reduced) nbatch=size(rk%batch,2)
   if(pkernel%igpu==1 .and. pkernel%stay_on_gpu /= 1) then
     call synchronize()
  end if
@@ -56,6 +114,54 @@ subroutine internal_calculation_exctx(istep,factor,pkernel,norb,occup,spinsgn,re
      end if
      !do it only for upper triangular results 
      if (istep /= 0 .or. jorb_glb >= iorb_glb) then
+        !the pair density vanishes if the supports are disjoint
+        if (screening) then
+           if (any(supports(1,:,iorb_glb) > supports(2,:,jorb_glb)) .or. &
+                any(supports(1,:,jorb_glb) > supports(2,:,iorb_glb))) then
+              npairs(2)=npairs(2)+1
+              cycle
+           end if
+        end if
+        npairs(1)=npairs(1)+1
+
+        if (reduced) then
+           !smallest reduced box containing the two supports
+           do i=1,3
+              lev(i)=(max(supports(2,i,iorb_glb),supports(2,i,jorb_glb))-&
+                   min(supports(1,i,iorb_glb),supports(1,i,jorb_glb)))/rk%quantum(i)+1
+           end do
+           lev=min(lev,rk%nlev)
+           nbox=min(lev*rk%quantum,pkernel%mesh%ndims)
+           ik=reduced_kernel(rk,pkernel,lev)
+           if (ik == 0) then
+              nzf=pkernel%grid%md1*pkernel%grid%md3*2*pkernel%grid%md2
+           else
+              nzf=rk%kernels(ik)%grid%md1*rk%kernels(ik)%grid%md3*2*rk%kernels(ik)%grid%md2
+           end if
+           !the batch is full, or its work arrays cannot host this density
+           if (nb == nbatch .or. iwork+product(nbox)+nzf > size(rk%work)) then
+              call exctx_batch_computation(nb,rk,pkernel,phi_i,phi_j,norb,occup,factor,&
+                   remote_result,istep,eexctX)
+              call OP2P_progress(OP2P)
+              nb=0
+              iwork=0
+           end if
+           nb=nb+1
+           rk%batch(1,nb)=iorb
+           rk%batch(2,nb)=jorb
+           rk%batch(3,nb)=ik
+           do i=1,3
+              rk%batch(3+i,nb)=min(supports(1,i,iorb_glb),supports(1,i,jorb_glb),&
+                   pkernel%mesh%ndims(i)-nbox(i)+1)
+              rk%batch(6+i,nb)=nbox(i)
+           end do
+           rk%batch(10,nb)=iwork
+           rk%batch(11,nb)=iwork+product(nbox)
+           rk%batch(12,nb)=iwork+product(nbox)+nzf
+           iwork=rk%batch(12,nb)
+           cycle
+        end if
+
         if(pkernel%igpu==1 .and. pkernel%stay_on_gpu /= 1 .and. istep ==0) then
           call reset_gpu_data(ndim,rp_ij,pkernel%w%rho_GPU)
         end if 
@@ -80,16 +186,233 @@ subroutine internal_calculation_exctx(istep,factor,pkernel,norb,occup,spinsgn,re
         if ((iorb_glb /= jorb_glb .and. istep==0) .or. remote_result) then
           call exctx_post_computation(jorb, iorb, rp_ij, phi_j, phi_i, pkernel, norb, occup,factor)
         end if
+        call OP2P_progress(OP2P)
         !write(100+iproc,*)iorb+isorb,jorb+jsorb,igrpr(igroup)
      end if
   end do
   end do
+  if (nb > 0) call exctx_batch_computation(nb,rk,pkernel,phi_i,phi_j,norb,occup,factor,&
+       remote_result,istep,eexctX)
 
   if(pkernel%igpu==1 .and. pkernel%stay_on_gpu /= 1) then
     call get_gpu_data(ndim,rp_ij,pkernel%w%rho_GPU)
  end if
 
-end subroutine internal_calculation_exctx
+end subroutine screened_calculation_exctx
+
+
+!> Exact exchange of the nb couples described in rk%batch.
+!! Each density is solved in its reduced box by one thread,
+!! then the results are accumulated one couple after the other
+subroutine exctx_batch_computation(nb,rk,pkernel,phi_i,phi_j,norb,occup,factor,remote_result,istep,eexctX)
+  use PSbase, wp=>dp
+  use overlap_point_to_point
+  use Poisson_Solver
+  use time_profiling, only: f_timing
+  implicit none
+  integer, intent(in) :: nb,norb,istep
+  logical, intent(in) :: remote_result
+  real(gp), intent(in) :: factor
+  real(gp), dimension(norb), intent(in) :: occup
+  type(reduced_kernels), intent(inout) :: rk
+  type(coulomb_operator), intent(inout) :: pkernel
+  type(local_data), intent(inout) :: phi_i,phi_j
+  real(gp), intent(inout) :: eexctX
+  !local variables
+  integer :: ib,iorb,jorb,ik,irho,izf,iend
+  real(gp) :: ehart
+
+  call f_timing(TCAT_PSOLV_COMPUT,'ON')
+  !a single density uses the threads of the solver
+  !$omp parallel do if (nb > 1) default(shared) private(ib,iorb,jorb,ik,irho,izf,iend,ehart) &
+  !$omp schedule(static,1) reduction(+:eexctX)
+  do ib=1,nb
+     iorb=rk%batch(1,ib)
+     jorb=rk%batch(2,ib)
+     ik=rk%batch(3,ib)
+     irho=rk%batch(10,ib)
+     izf=rk%batch(11,ib)
+     iend=rk%batch(12,ib)
+     call exctx_box_pre_computation(iorb,jorb,rk%batch(4:6,ib),rk%batch(7:9,ib),&
+          rk%work(irho+1:izf),phi_i,phi_j,pkernel)
+     if (ik == 0) then
+        call exctx_box_potential(pkernel,rk%work(irho+1:izf),rk%work(izf+1:iend),ehart)
+     else
+        call exctx_box_potential(rk%kernels(ik),rk%work(irho+1:izf),rk%work(izf+1:iend),ehart)
+     end if
+     call exctx_accum_eexctX(iorb,jorb,phi_i,phi_j,pkernel,norb,occup,factor,remote_result,istep,ehart,eexctX)
+  end do
+  !$omp end parallel do
+  call f_timing(TCAT_PSOLV_COMPUT,'OF')
+
+  !two couples of a batch may share an object
+  do ib=1,nb
+     iorb=rk%batch(1,ib)
+     jorb=rk%batch(2,ib)
+     irho=rk%batch(10,ib)
+     izf=rk%batch(11,ib)
+     call exctx_box_post_computation(iorb,jorb,rk%batch(4:6,ib),rk%batch(7:9,ib),&
+          rk%work(irho+1:izf),phi_i,phi_j,pkernel,norb,occup,factor)
+     if ((phi_i%id_glb(iorb) /= phi_j%id_glb(jorb) .and. istep==0) .or. remote_result) then
+        call exctx_box_post_computation(jorb,iorb,rk%batch(4:6,ib),rk%batch(7:9,ib),&
+             rk%work(irho+1:izf),phi_j,phi_i,pkernel,norb,occup,factor)
+     end if
+  end do
+
+end subroutine exctx_batch_computation
+
+
+!> Potential of the density rho of a reduced box, written in rho,
+!! ehart is the Hartree energy of the density
+subroutine exctx_box_potential(kernel,rho,zf,ehart)
+  use PSbase, wp=>dp
+  use Poisson_Solver
+  implicit none
+  type(coulomb_operator), intent(inout) :: kernel
+  real(dp), dimension(kernel%grid%m1,kernel%grid%m3*kernel%grid%n3p), intent(inout) :: rho
+  real(dp), dimension(kernel%grid%md1,kernel%grid%md3*2*kernel%grid%md2), intent(inout) :: zf
+  real(gp), intent(out) :: ehart
+  !local variables
+  real(dp) :: eh
+  real(dp), dimension(6) :: strten
+
+  call apply_kernel(.false.,kernel,rho,0.0_dp,strten,zf,.false.,.false.)
+  call finalize_hartree_results(.false.,.false.,kernel,rho,&
+       kernel%grid%m1,kernel%grid%m3,kernel%grid%n3p,&
+       kernel%grid%md1,kernel%grid%md3,2*kernel%grid%md2,&
+       rho,zf,rho,eh)
+  ehart=0.5_gp*eh*kernel%mesh%volume_element
+
+end subroutine exctx_box_potential
+
+
+!> Pair density of the objects phi1(iorb) and phi2(jorb) in the box of nbox points from ns
+subroutine exctx_box_pre_computation(iorb,jorb,ns,nbox,rho,phi1,phi2,pkernel)
+  use PSbase, wp=>dp
+  use overlap_point_to_point
+  use Poisson_Solver
+  implicit none
+  integer, intent(in) :: iorb,jorb
+  integer, dimension(3), intent(in) :: ns,nbox
+  type(coulomb_operator), intent(in) :: pkernel
+  real(wp), dimension(nbox(1),nbox(2),nbox(3)), intent(out) :: rho
+  type(local_data), intent(inout) :: phi1,phi2
+  !local variables
+  integer :: i1,i2,i3,ind,shift1,shift2
+  real(gp) :: hfac
+
+  hfac=1.0_gp/product(pkernel%mesh%hgrids)
+  shift1=phi1%displ(iorb)
+  shift2=phi2%displ(jorb)
+  !$omp parallel do default(shared) private(i1,i2,i3,ind)
+  do i3=1,nbox(3)
+     do i2=1,nbox(2)
+        ind=ns(1)+pkernel%mesh%ndims(1)*(ns(2)+i2-2+pkernel%mesh%ndims(2)*(ns(3)+i3-2))
+        do i1=1,nbox(1)
+           rho(i1,i2,i3)=hfac*phi1%data(ind+i1-1+shift1)*phi2%data(ind+i1-1+shift2)
+        end do
+     end do
+  end do
+  !$omp end parallel do
+end subroutine exctx_box_pre_computation
+
+
+!> Same as exctx_post_computation, for a potential given in the box of nbox points from ns
+subroutine exctx_box_post_computation(orb1,orb2,ns,nbox,pot,phi1,phi2,pkernel,norb,occup,factor)
+  use PSbase, wp=>dp
+  use overlap_point_to_point
+  use Poisson_Solver
+  implicit none
+  integer, intent(in) :: orb1,orb2,norb
+  integer, dimension(3), intent(in) :: ns,nbox
+  type(coulomb_operator), intent(in) :: pkernel
+  real(wp), dimension(nbox(1),nbox(2),nbox(3)), intent(in) :: pot
+  type(local_data), intent(inout) :: phi1,phi2
+  real(gp), dimension(norb), intent(in) :: occup
+  real(gp), intent(in) :: factor !<overall factor to treat the data
+  !local variables
+  integer :: i1,i2,i3,ind,shift1_res,shift2
+  real(gp) :: hfac1
+
+  shift1_res=phi1%displ_res(orb1)
+  shift2=phi2%displ(orb2)
+  hfac1=-factor*occup(phi2%id_glb(orb2))
+  !$omp parallel do default(shared) private(i1,i2,i3,ind)
+  do i3=1,nbox(3)
+     do i2=1,nbox(2)
+        ind=ns(1)+pkernel%mesh%ndims(1)*(ns(2)+i2-2+pkernel%mesh%ndims(2)*(ns(3)+i3-2))
+        do i1=1,nbox(1)
+           phi1%res(ind+i1-1+shift1_res)=phi1%res(ind+i1-1+shift1_res)+&
+                hfac1*pot(i1,i2,i3)*phi2%data(ind+i1-1+shift2)
+        end do
+     end do
+  end do
+  !$omp end parallel do
+end subroutine exctx_box_post_computation
+
+
+!> Boxes of grid points containing each of the nobj objects of psir up to a fraction tol of its norm.
+!! The norm is measured on the marginal distributions of the objects, and tol is shared among the
+!! faces of the box in the isolated directions, so the norm outside of a box is at most tol.
+!! The periodic directions are never restricted.
+!! Only the supports of the objects isobj+1 to isobj+nobj are filled
+subroutine exctx_supports(mesh,tol,nobj,isobj,psir,supports)
+  use PSbase, wp=>dp
+  use box, only: cell
+  use at_domain, only: domain_periodic_dims
+  use dynamic_memory
+  use f_utils, only: f_zero
+  implicit none
+  type(cell), intent(in) :: mesh
+  real(gp), intent(in) :: tol !<fraction of the norm outside of the boxes
+  integer, intent(in) :: nobj,isobj
+  real(wp), dimension(mesh%ndims(1),mesh%ndims(2),mesh%ndims(3),nobj), intent(in) :: psir
+  integer, dimension(2,3,*), intent(inout) :: supports !<lower and upper grid points of each object
+  !local variables
+  integer :: iobj,i1,i2,i3,idir,lo,hi
+  real(gp) :: tt,thr,acc
+  logical, dimension(3) :: peri
+  real(gp), dimension(:,:), allocatable :: marg
+
+  peri=domain_periodic_dims(mesh%dom)
+  marg = f_malloc([maxval(mesh%ndims),3],id='marg')
+
+  do iobj=1,nobj
+     !marginal distributions of the density of the object along each direction
+     call f_zero(marg)
+     do i3=1,mesh%ndims(3)
+        do i2=1,mesh%ndims(2)
+           do i1=1,mesh%ndims(1)
+              tt=real(psir(i1,i2,i3,iobj),gp)**2
+              marg(i1,1)=marg(i1,1)+tt
+              marg(i2,2)=marg(i2,2)+tt
+              marg(i3,3)=marg(i3,3)+tt
+           end do
+        end do
+     end do
+     thr=tol*sum(marg(1:mesh%ndims(1),1))/real(max(2*count(.not. peri),1),gp)
+     do idir=1,3
+        lo=1
+        hi=mesh%ndims(idir)
+        if (.not. peri(idir)) then
+           acc=marg(lo,idir)
+           do while (acc <= thr .and. lo < hi)
+              lo=lo+1
+              acc=acc+marg(lo,idir)
+           end do
+           acc=marg(hi,idir)
+           do while (acc <= thr .and. hi > lo)
+              hi=hi-1
+              acc=acc+marg(hi,idir)
+           end do
+        end if
+        supports(1,idir,isobj+iobj)=lo
+        supports(2,idir,isobj+iobj)=hi
+     end do
+  end do
+  call f_free(marg)
+
+end subroutine exctx_supports
 
 subroutine exctx_pre_computation(iorb, jorb, rp_ij, phi1, phi2, pkernel)
   use PSbase, wp=>dp
@@ -1,10 +1,10 @@
-#include <iostream>
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/time.h>
 #include <fftw3.h>
+#ifdef _OPENMP
 #include <omp.h>
-#include <fstream>
+#endif
  
 #define DOUBLE
 
@@ -37,6 +37,15 @@ class dim3 {
  }
 };
 
+// the threading of FFTW is initialised once per process
+static void init_fftw_threads() {
+ static bool threads_initialised = false;
+ if (!threads_initialised) {
+   fftw_init_threads();
+   threads_initialised = true;
+ }
+}
+
 void transpose_c(fftw_complex *idata, fftw_complex *odata,
         int width, int height, int gridDimx,
         int gridDimy, int blockDimx, int blockDimy)
@@ -225,7 +234,10 @@ extern "C" void fftw_3d_psolver_general_plan_(int *N,
  int ysize = NY/2 + geo2 * NY/2;
  int zsize = NZ/2 + geo3 * NZ/2;
 
+ init_fftw_threads();
+#ifdef _OPENMP
  fftw_plan_with_nthreads(omp_get_max_threads());
+#endif
 
  n1d[0] = NX;
  plan[0] = fftw_plan_many_dft_r2c(1, n1d,ysize*zsize, (Real*)in,
@@ -277,9 +289,6 @@ extern "C" void fftw_3d_psolver_general_(int *N, fftw_plan *plan, int *geo,
           fftw_complex *d_data,  fftw_complex *d_data2, Real *d_kernel,
           Real *scal_p) {
 
- fftw_init_threads();
-
-
  int NX = N[0];
  int NY = N[1];
  int NZ = N[2];
@@ -402,3 +411,83 @@ extern "C" void fftw_3d_psolver_general_(int *N, fftw_plan *plan, int *geo,
         fftw_execute(plan[3]);
 
 }
+
+extern "C" void fftw_3d_psolver_destroy_plan_(fftw_plan *plan) {
+ for (int i = 0; i < 12; i++) {
+   if (plan[i]) fftw_destroy_plan(plan[i]);
+   plan[i] = NULL;
+ }
+}
+
+// Batched 1D transforms of the slab-decomposed solver (G_PoissonSolver),
+// in place of the fftstp_sg steps. The lines are interleaved: point k of
+// line j is at in[j+k*istride]. isign is the one of fftstp_sg, +1 for
+// exp(+i...) (FFTW_BACKWARD) and -1 for exp(-i...) (FFTW_FORWARD).
+// Each OpenMP thread of the solver transforms its own lines, so the plans
+// are single-threaded; they are cached by shape for the whole run and
+// applied to the arrays of the call.
+// A plan of a shape which does not fit in the cache is destroyed after use.
+#define NPLANS_1D 64
+
+struct plan_1d {
+ int n, howmany, istride, ostride, sign;
+ fftw_plan plan;
+};
+
+static plan_1d plans_1d[NPLANS_1D];
+static int nplans_1d = 0;
+
+#ifdef _OPENMP
+// the FFTW planner is not thread safe
+struct planner_lock {
+ omp_lock_t lock;
+ planner_lock() { omp_init_lock(&lock); }
+};
+static planner_lock planner;
+#endif
+
+extern "C" void fftw_1d_psolver_many_(int *n, int *howmany, fftw_complex *in, int *istride,
+          fftw_complex *out, int *ostride, int *isign) {
+
+ fftw_plan plan = NULL;
+ bool cached = false;
+
+#ifdef _OPENMP
+ omp_set_lock(&planner.lock);
+#endif
+ for (int i = 0; i < nplans_1d; i++) {
+   if (plans_1d[i].n == *n && plans_1d[i].howmany == *howmany &&
+       plans_1d[i].istride == *istride && plans_1d[i].ostride == *ostride &&
+       plans_1d[i].sign == *isign) {
+     plan = plans_1d[i].plan;
+     cached = true;
+     break;
+   }
+ }
+ if (!cached) {
+   init_fftw_threads();
+   fftw_plan_with_nthreads(1);
+   plan = fftw_plan_many_dft(1, n, *howmany, in, NULL, *istride, 1,
+            out, NULL, *ostride, 1, *isign > 0 ? FFTW_BACKWARD : FFTW_FORWARD,
+            FFTW_ESTIMATE | FFTW_UNALIGNED);
+   if (nplans_1d < NPLANS_1D) {
+     plan_1d entry = {*n, *howmany, *istride, *ostride, *isign, plan};
+     plans_1d[nplans_1d++] = entry;
+     cached = true;
+   }
+ }
+#ifdef _OPENMP
+ omp_unset_lock(&planner.lock);
+#endif
+
+ fftw_execute_dft(plan, in, out);
+ if (!cached) {
+#ifdef _OPENMP
+   omp_set_lock(&planner.lock);
+#endif
+   fftw_destroy_plan(plan);
+#ifdef _OPENMP
+   omp_unset_lock(&planner.lock);
+#endif
+ }
+}
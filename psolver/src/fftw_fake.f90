@@ -0,0 +1,26 @@
+!> @file
+!!    Routines to bind fake arguments for the FFTW solver
+!! @author
+!!    Copyright (C) 2017 BigDFT group
+!!    This file is distributed under the terms of the
+!!    GNU General Public License, see ~/COPYING file
+!!    or http://www.gnu.org/copyleft/gpl.txt .
+!!    For the list of contributors, see ~/AUTHORS
+subroutine fftw_3d_psolver_general_plan()
+   use dictionaries
+   call f_err_throw('The FFTW solver (accel: FFTW) is not available, reconfigure with --with-fftw')
+END SUBROUTINE fftw_3d_psolver_general_plan
+
+subroutine fftw_3d_psolver_general()
+   use dictionaries
+   call f_err_throw('We should not enter into the fftw_3d_psolver_general routine')
+END SUBROUTINE fftw_3d_psolver_general
+
+subroutine fftw_3d_psolver_destroy_plan()
+   implicit none
+END SUBROUTINE fftw_3d_psolver_destroy_plan
+
+subroutine fftw_1d_psolver_many()
+   use dictionaries
+   call f_err_throw('We should not enter into the fftw_1d_psolver_many routine')
+END SUBROUTINE fftw_1d_psolver_many
@@ -23,20 +23,19 @@ program Fock_Operator_Program
   !Order of interpolating scaling function
   real(kind=8), parameter :: a_gauss = 1.0, a2 = a_gauss**2
   real(kind=8), parameter :: acell = 10.d0
-  logical :: symmetric,usegpu
+  logical :: symmetric,usegpu,persistent
   character(len=1) :: geocode !< @copydoc poisson_solver::coulomb_operator::geocode
-  real(f_double) :: offset,eexctX,tel,sfac,trm,ehartree_exp
-  integer :: iproc,nproc,norb,norbu,norbd,norbpj,nspin,prc
-  integer :: i_stat,igpu,iorb,jproc,ndim,ngroup,isorb
+  real(f_double) :: offset,eexctX,sfac,ehartree_exp,tol,eexctX_screened
+  integer :: iproc,nproc,norb,norbu,norbd,norbpj,nspin,ndisjoint
+  integer :: igpu,iorb,jproc,ndim,ngroup,isorb,isorbp,i_stat
+  integer, dimension(2) :: npairs
   integer, dimension(3) :: nxyz
   real(f_double), dimension(3) :: hgrids
-  type(OP2P_data) :: OP2P
-  type(OP2P_iterator) :: iter
   type(cell) :: mesh
   type(coulomb_operator) :: pkernel
   type(dictionary), pointer :: dict_input,options,dict_timing_info
   integer, dimension(:,:), allocatable :: nobj_par
-  real(f_double), dimension(:), allocatable :: occup,spinsgn,rp_ij
+  real(f_double), dimension(:), allocatable :: occup,spinsgn
   real(f_double), dimension(:,:,:), allocatable :: density,rhopot
   real(f_double), dimension(:,:,:), allocatable :: potential,pot_ion
   real(f_double), dimension(:,:,:,:), allocatable :: psir,dpsir
@@ -68,6 +67,8 @@ program Fock_Operator_Program
   nxyz=options//'ndim'
   geocode=options//'geocode'
   usegpu = options // 'accel'
+  tol = options // 'screening'
+  persistent = options // 'persistent'
 
   call dict_init(dict_input)
   if (usegpu) then 
@@ -84,6 +85,7 @@ program Fock_Operator_Program
   if (nspin==0) then
      nspin=1
      norbu=options//'norb'
+     norbd=0
   else if (nspin==1) then
      norbu=options//'norb'//0
      norbd=0
@@ -126,9 +128,17 @@ program Fock_Operator_Program
   !then fill for all the functions the proposed density
   !the psi should be transformed in real space, do it within the orbital basis iterators
   psir = f_malloc0([nxyz(1),nxyz(2),nxyz(3),norbp(norb,nproc,iproc)],id='psir')
+  isorbp=0
+  do jproc=0,iproc-1
+     isorbp=isorbp+norbp(norb,nproc,jproc)
+  end do
   do iorb=1,norbp(norb,nproc,iproc)
-     call f_memcpy(n=product(nxyz),src=density(1,1,1),&
-          dest=psir(1,1,1,iorb))
+     if (tol > 0.0_f_double) then
+        call separated_gaussian(isorbp+iorb,psir(1,1,1,iorb))
+     else
+        call f_memcpy(n=product(nxyz),src=density(1,1,1),&
+             dest=psir(1,1,1,iorb))
+     end if
   end do
 
   call f_free(density)
@@ -182,51 +192,28 @@ program Fock_Operator_Program
      igpu=.if. pkernel%use_gpu_direct .then. pkernel%igpu .else. 0
   end if
   
-  call initialize_OP2P_data(OP2P,mpiworld(),iproc,nproc,ngroup,ndim,nobj_par,igpu,symmetric)
-
-  !this part is also inaesthetic
-  if(igpu==1 .and. OP2P%gpudirect==1) pkernel%stay_on_gpu=1
-  !allocate work array for the internal exctx calculation
-  rp_ij = f_malloc(ndim,id='rp_ij')
-  eexctX=0.0d0
-  !initialize the OP2P descriptor for the communication
-  call set_OP2P_iterator(iproc,OP2P,iter,norbp(norb,nproc,iproc),psir,dpsir)
-  !main loop
-  if (iproc == 0) call yaml_newline()
-  OP2P_exctx_loop: do
-     call OP2P_communication_step(iproc,OP2P,iter)
-     if(igpu==1) call synchronize() !this can be moved inside the communication step
-     if (iter%event == OP2P_EXIT) exit OP2P_exctx_loop
-     call internal_calculation_exctx(iter%istep,sfac,pkernel,norb,&
-          occup,spinsgn,&
-          iter%remote_result,iter%nloc_i,iter%nloc_j,iter%isloc_i,iter%isloc_j,&
-          iter%phi_i,iter%phi_j,eexctX,rp_ij)
-     if (iproc == 0) then
-        !this part can be replaced by a progress bar
-        call OP2P_info(iter,OP2P,prc,tel,trm)
-        call yaml_comment('Exact exchange calculation: '+prc**'(i3)'+&
-             '%; Time (s): Elapsed='+tel**'(1pg12.2)'&
-             +', Remaining='+trm**'(1pg12.2)')
-     end if
-  end do OP2P_exctx_loop
-
-  !we need to get the result back from the card (and synchronize with it, finally)
-  if(pkernel%igpu==1 .and. pkernel%stay_on_gpu==1) then
-     !here wrappers should be used
-     call get_gpu_data(1, eexctX, pkernel%w%eexctX_GPU )
-     !f_zero should go here
-     call cudamemset(pkernel%w%eexctX_GPU,0,1,i_stat)
-     if (i_stat /= 0) call f_err_throw('error cudamalloc eexctX_GPU (GPU out of memory ?) ')
-     pkernel%stay_on_gpu=0
-  end if
-  call free_OP2P_data(OP2P)
-  if (nproc > 1) call fmpi_allreduce(eexctX,1,op=FMPI_SUM)
+  call exact_exchange(0.0_f_double,eexctX,npairs)
   if (iproc == 0) then
      call yaml_map('Exact Exchange Energy',eexctX,fmt='(1pe18.11)')
-     call yaml_map('Expected Exchange Energy',ehartree_exp,fmt='(1pe18.11)')
+     if (tol == 0.0_f_double) call yaml_map('Expected Exchange Energy',ehartree_exp,fmt='(1pe18.11)')
+  end if
+  !the couples of distant objects are skipped, the others are solved in reduced boxes
+  if (tol > 0.0_f_double) then
+     call exact_exchange(tol,eexctX_screened,npairs)
+     if (iproc == 0) then
+        call yaml_mapping_open('Exact exchange screening')
+        call yaml_map('Tolerance',tol)
+        call yaml_map('Exact Exchange Energy',eexctX_screened,fmt='(1pe18.11)')
+        call yaml_map('Energy error',abs(eexctX_screened-eexctX),fmt='(1pe9.2)')
+        call yaml_map('Disjoint couples',ndisjoint)
+        call yaml_mapping_open('Exact Exchange pairs',flow=.true.)
+        call yaml_map('Calculated',npairs(1))
+        call yaml_map('Skipped',npairs(2))
+        call yaml_mapping_close()
+        call yaml_mapping_close()
+     end if
   end if
   call f_free(nobj_par)
-  call f_free(rp_ij)
   call f_free(dpsir)
   call f_free(psir)
   call f_free(occup,spinsgn)
@@ -250,6 +237,124 @@ program Fock_Operator_Program
 
 contains
 
+  !> Exact exchange energy of the orbitals of psir, with the OP2P scheme.
+  !! If tol is positive, the couples are screened with the supports of the orbitals
+  !! and npairs gives the couples calculated and skipped
+  subroutine exact_exchange(tol,eexctX,npairs)
+    implicit none
+    real(f_double), intent(in) :: tol
+    real(f_double), intent(out) :: eexctX
+    integer, dimension(2), intent(out) :: npairs
+    !local variables
+    integer :: prc,i_stat,jorb
+    real(f_double) :: tel,trm
+    type(OP2P_data) :: OP2P
+    type(OP2P_iterator) :: iter
+    type(reduced_kernels) :: rk
+    integer, dimension(:,:,:), allocatable :: supports
+    real(f_double), dimension(:), allocatable :: rp_ij
+
+    call initialize_OP2P_data(OP2P,mpiworld(),iproc,nproc,ngroup,ndim,nobj_par,igpu,symmetric,&
+         persistent=persistent)
+
+    !this part is also inaesthetic
+    if(igpu==1 .and. OP2P%gpudirect==1) pkernel%stay_on_gpu=1
+    !allocate work array for the internal exctx calculation
+    rp_ij = f_malloc(ndim,id='rp_ij')
+    eexctX=0.0d0
+    npairs=0
+    if (tol > 0.0_f_double) then
+       supports = f_malloc0([2,3,norb],id='supports')
+       call exctx_supports(pkernel%mesh,tol,norbp(norb,nproc,iproc),isorbp,psir,supports)
+       if (nproc > 1) call fmpi_allreduce(supports,FMPI_SUM)
+       !couples of the same spin with disjoint supports, independently of the orbital repartition
+       ndisjoint=0
+       do iorb=1,norb
+          do jorb=iorb+1,norb
+             if (spinsgn(iorb) /= spinsgn(jorb)) cycle
+             if (any(supports(1,:,iorb) > supports(2,:,jorb)) .or. &
+                  any(supports(1,:,jorb) > supports(2,:,iorb))) ndisjoint=ndisjoint+1
+          end do
+       end do
+       rk=reduced_kernels_new(pkernel)
+    else
+       supports = f_malloc0([2,3,1],id='supports')
+       rk=reduced_kernels_null()
+    end if
+    call f_zero(dpsir)
+    !initialize the OP2P descriptor for the communication
+    call set_OP2P_iterator(iproc,OP2P,iter,norbp(norb,nproc,iproc),psir,dpsir)
+    !main loop
+    if (iproc == 0) call yaml_newline()
+    OP2P_exctx_loop: do
+       call OP2P_communication_step(iproc,OP2P,iter)
+       if(igpu==1) call synchronize() !this can be moved inside the communication step
+       if (iter%event == OP2P_EXIT) exit OP2P_exctx_loop
+       call screened_calculation_exctx(iter%istep,sfac,pkernel,norb,&
+            occup,spinsgn,&
+            iter%remote_result,iter%nloc_i,iter%nloc_j,iter%isloc_i,iter%isloc_j,&
+            iter%phi_i,iter%phi_j,eexctX,rp_ij,tol > 0.0_f_double,supports,npairs,rk,OP2P)
+       if (iproc == 0) then
+          !this part can be replaced by a progress bar
+          call OP2P_info(iter,OP2P,prc,tel,trm)
+          call yaml_comment('Exact exchange calculation: '+prc**'(i3)'+&
+               '%; Time (s): Elapsed='+tel**'(1pg12.2)'&
+               +', Remaining='+trm**'(1pg12.2)')
+       end if
+    end do OP2P_exctx_loop
+
+    !we need to get the result back from the card (and synchronize with it, finally)
+    if(pkernel%igpu==1 .and. pkernel%stay_on_gpu==1) then
+       !here wrappers should be used
+       call get_gpu_data(1, eexctX, pkernel%w%eexctX_GPU )
+       !f_zero should go here
+       call cudamemset(pkernel%w%eexctX_GPU,0,1,i_stat)
+       if (i_stat /= 0) call f_err_throw('error cudamalloc eexctX_GPU (GPU out of memory ?) ')
+       pkernel%stay_on_gpu=0
+    end if
+    call free_OP2P_data(OP2P)
+    if (nproc > 1) call fmpi_allreduce(eexctX,1,op=FMPI_SUM)
+    if (tol > 0.0_f_double) then
+       if (nproc > 1) call fmpi_allreduce(npairs,FMPI_SUM)
+    end if
+    call reduced_kernels_free(rk)
+    call f_free(supports)
+    call f_free(rp_ij)
+
+  end subroutine exact_exchange
+
+  !> Normalized gaussian centred on the x axis of the box at a position given by iorb,
+  !! the orbitals of each spin are equally spaced along the axis
+  subroutine separated_gaussian(iorb,psi)
+    implicit none
+    integer, intent(in) :: iorb
+    real(f_double), dimension(nxyz(1),nxyz(2),nxyz(3)), intent(out) :: psi
+    !local variables
+    real(f_double), parameter :: sigma=0.4d0
+    integer :: i1,i2,i3,korb,nspinorb
+    real(f_double), dimension(3) :: rxyz
+
+    korb=iorb
+    nspinorb=norbu
+    if (iorb > norbu) then
+       korb=iorb-norbu
+       nspinorb=norbd
+    end if
+    rxyz(1)=acell*(real(korb,f_double)-0.5d0)/real(nspinorb,f_double)
+    rxyz(2:3)=0.5d0*acell
+    do i3=1,nxyz(3)
+       do i2=1,nxyz(2)
+          do i1=1,nxyz(1)
+             psi(i1,i2,i3)=exp(-((hgrids(1)*(i1-1)-rxyz(1))**2+&
+                  (hgrids(2)*(i2-1)-rxyz(2))**2+(hgrids(3)*(i3-1)-rxyz(3))**2)/(2.0d0*sigma**2))
+          end do
+       end do
+    end do
+    !same normalization as the orbitals in the wavelet code, the density is then rescaled by the volume element
+    psi=psi/sqrt(sum(psi**2))
+
+  end subroutine separated_gaussian
+
   pure function norbp(norb,nproc,jproc)
     implicit none
     integer, intent(in) :: jproc,norb,nproc
@@ -303,6 +408,21 @@ contains
        'help_string: Number of orbitals for each spin,'//&
        'help_dict: {Allowed values: list of integers}}')
 
+  call yaml_cl_parse_option(parser,&
+       '{name: screening,'//&
+       'shortname: s,'//&
+       'default: 0.0,'//&
+       'help_string: Screening of the exact exchange couples,'//&
+       'help_dict: {Allowed values: fraction of the norm of the orbitals outside of their supports.'//&
+       ' The separated orbitals are then compared with and without screening}}')
+
+  call yaml_cl_parse_option(parser,&
+       '{name: persistent,'//&
+       'shortname: p,'//&
+       'default: No,'//&
+       'help_string: Persistent requests for the OP2P ring of the orbitals,'//&
+       'help_dict: {Allowed values: Boolean}}')
+
 end subroutine Fock_test_options
 
 end program Fock_Operator_Program
@@ -25,7 +25,8 @@ program PS_Check
   implicit none
   !Length of the box
   character(len=*), parameter :: subname='PS_Check'
-  logical :: usegpu
+  logical :: usegpu,usefftw
+  character(len=256) :: cachedir
   real(kind=8), parameter :: a_gauss = 1.0d0,a2 = a_gauss**2
   real(kind=8), parameter :: acell = 10.d0
   character(len=1) :: geocode !< @copydoc poisson_solver::coulomb_operator::geocode
@@ -87,6 +88,9 @@ program PS_Check
   nxyz=options//'ndim'
   geocode=options//'geocode'
   usegpu = options//'accel'
+  usefftw = options//'fftw'
+  cachedir='None'
+  if ('cache' .in. options) cachedir = options//'cache'
 
   call dict_init(dict_input)
   if (usegpu) then 
@@ -277,6 +281,14 @@ program PS_Check
 
   call f_timing_checkpoint('Serial',mpi_comm=MPI_COMM_WORLD,&
        nproc=nproc,gather_routine=gather_timings)
+
+  if (usefftw) call compare_fftw(iproc,nproc,dom,ndims,hgrids,itype_scf,offset,&
+       density,extra_ref)
+
+  if (pkernel%mixed_precision > 0.0_dp) call compare_single(pkernel,offset,density)
+
+  if (trim(cachedir) /= 'None') &
+       call check_kernel_cache(iproc,nproc,dom,ndims,hgrids,itype_scf,cachedir)
   !call timing(MPI_COMM_WORLD,'Serial','PR')
 
   !call f_malloc_dump_status()
@@ -425,6 +437,227 @@ contains
   END SUBROUTINE compare_cplx_calculations
 
 
+  !> Time the FFTW solver against the CPU one on all the processes, for the
+  !! grid of this run and for grids of half and one and a half times as many
+  !! points per direction in the same box, one speedup per grid size.
+  !! The run grid is compared to the reference, the others to the CPU solver.
+  subroutine compare_fftw(iproc,nproc,dom,ndims,hgrids,itype_scf,offset,density,potential)
+    use Poisson_Solver
+    use dynamic_memory
+    use f_utils, only: f_time
+    use f_precisions, only: f_long
+    use wrapper_mpi
+    implicit none
+    integer, intent(in) :: iproc,nproc
+    type(domain), intent(in) :: dom
+    integer, dimension(3), intent(in) :: ndims
+    real(dp), dimension(3), intent(in) :: hgrids
+    integer, intent(in) :: itype_scf
+    real(kind=8), intent(in) :: offset
+    real(kind=8), dimension(product(ndims)), intent(in) :: density,potential
+    !local variables
+    integer, parameter :: nrep=5,ngrids=3
+    integer :: irep,isolver,igrid,i1,i2,i3,ind,ierr
+    integer(f_long) :: t0,t1
+    real(kind=8) :: ehartree,sigma,r2
+    integer, dimension(3) :: nd
+    real(dp), dimension(3) :: hd
+    real(kind=8), dimension(2) :: tsolver
+    real(kind=8), dimension(:), allocatable :: rho,rhopot,cpupot
+    type(coulomb_operator) :: kernel
+    type(dictionary), pointer :: dict_input
+
+    call f_routine(id='compare_fftw')
+
+    if (iproc == 0) call yaml_sequence_open('FFTW comparison')
+    do igrid=1,ngrids
+       if (igrid == 2) then
+          nd=ndims
+       else
+          nd=2*max((ndims*igrid)/4,8)
+       end if
+       hd=hgrids*real(ndims,dp)/real(nd,dp)
+       rho=f_malloc(product(nd),id='rho')
+       rhopot=f_malloc(product(nd),id='rhopot')
+       cpupot=f_malloc(product(nd),id='cpupot')
+       if (igrid == 2) then
+          call f_memcpy(src=density,dest=rho)
+       else
+          !gaussian in the middle of the box
+          sigma=0.1_dp*minval(real(nd,dp)*hd)
+          do i3=1,nd(3)
+             do i2=1,nd(2)
+                do i1=1,nd(1)
+                   ind=i1+nd(1)*(i2-1+nd(2)*(i3-1))
+                   r2=((i1-1-nd(1)/2)*hd(1))**2+((i2-1-nd(2)/2)*hd(2))**2+&
+                        ((i3-1-nd(3)/2)*hd(3))**2
+                   rho(ind)=exp(-0.5_dp*r2/sigma**2)
+                end do
+             end do
+          end do
+       end if
+       if (iproc == 0) then
+          call yaml_sequence(advance='no')
+          call yaml_map('Grid',nd)
+       end if
+       do isolver=1,2
+          dict_input=>dict_new('kernel' .is. dict_new('isf_order' .is. itype_scf),&
+               'setup' .is. dict_new('verbose' .is. 'No'))
+          if (isolver == 2) call dict_set(dict_input//'setup'//'accel','FFTW')
+          kernel=pkernel_init(iproc,nproc,dict_input,dom,nd,hd)
+          call dict_free(dict_input)
+          call pkernel_set(kernel,verbose=.false.)
+          !best of nrep runs, the first one also includes the warm-up
+          tsolver(isolver)=huge(1.0_dp)
+          do irep=1,nrep
+             call f_memcpy(src=rho,dest=rhopot)
+             call MPI_BARRIER(kernel%mpi_env%mpi_comm,ierr)
+             t0=f_time()
+             call H_potential('G',kernel,rhopot,rhopot,ehartree,offset,.false.,quiet='YES')
+             t1=f_time()
+             tsolver(isolver)=min(tsolver(isolver),real(t1-t0,kind=8)*1.e-9_dp)
+          end do
+          if (isolver == 1) then
+             call f_memcpy(src=rhopot,dest=cpupot)
+             if (igrid == 2) call compare(iproc,nproc,kernel%mpi_env%mpi_comm,&
+                  nd(1),nd(2),nd(3),1,potential,rhopot,'CPU')
+          else if (igrid == 2) then
+             call compare(iproc,nproc,kernel%mpi_env%mpi_comm,nd(1),nd(2),nd(3),1,&
+                  potential,rhopot,'FFTW')
+          else
+             call compare(iproc,nproc,kernel%mpi_env%mpi_comm,nd(1),nd(2),nd(3),1,&
+                  cpupot,rhopot,'FFTW vs CPU')
+          end if
+          call pkernel_free(kernel)
+       end do
+       if (iproc == 0) then
+          call yaml_map('CPU time (s)',tsolver(1),fmt='(1pe12.4)')
+          call yaml_map('FFTW time (s)',tsolver(2),fmt='(1pe12.4)')
+          call yaml_map('Speedup',tsolver(1)/tsolver(2),fmt='(f8.2)')
+       end if
+       call f_free(rho,rhopot,cpupot)
+    end do
+    if (iproc == 0) call yaml_sequence_close()
+
+    call f_release_routine()
+
+  end subroutine compare_fftw
+
+
+  !> Solve with the single precision MPI transpositions of the mixed precision
+  !! option, forced by a residual above the threshold, and compare with the
+  !! solution with double precision transpositions.
+  !! The relative difference should be of the order of the single precision epsilon.
+  subroutine compare_single(kernel,offset,density)
+    use Poisson_Solver
+    use wrapper_mpi
+    implicit none
+    type(coulomb_operator), intent(inout) :: kernel
+    real(kind=8), intent(in) :: offset
+    real(kind=8), dimension(kernel%mesh%ndims(1)*kernel%mesh%ndims(2)*kernel%mesh%ndims(3)), &
+         intent(in) :: density
+    !local variables
+    real(kind=8), parameter :: tol_single=1.e-5_dp
+    real(kind=8) :: ehartree,eref,maxdiff
+    real(kind=8), dimension(:), allocatable :: rhopot,potref
+
+    call f_routine(id='compare_single')
+
+    rhopot=f_malloc(size(density),id='rhopot')
+    potref=f_malloc(size(density),id='potref')
+
+    call f_memcpy(src=density,dest=potref)
+    call H_potential('G',kernel,potref,potref,eref,offset,.false.,quiet='YES')
+
+    call PS_set_options(kernel,scf_residual=10.0_gp*kernel%mixed_precision)
+    call f_memcpy(src=density,dest=rhopot)
+    call H_potential('G',kernel,rhopot,rhopot,ehartree,offset,.false.,quiet='YES')
+    call PS_set_options(kernel,scf_residual=0.0_gp)
+
+    !the potential is global, the reduction only guards against different roundings
+    maxdiff=maxval(abs(rhopot-potref))/maxval(abs(potref))
+    if (kernel%mpi_env%nproc > 1) &
+         call fmpi_allreduce(maxdiff,1,op=FMPI_MAX,comm=kernel%mpi_env%mpi_comm)
+
+    if (kernel%mpi_env%iproc+kernel%mpi_env%igroup == 0) then
+       call yaml_mapping_open('Single precision MPI transpositions')
+       call yaml_map('Relative difference in Inf. Norm',maxdiff,fmt='(1pe20.12)')
+       call yaml_map('Relative Hartree energy difference',(ehartree-eref)/eref,fmt='(1pe20.12)')
+       if (maxdiff > tol_single .or. abs(ehartree-eref) > tol_single*abs(eref)) &
+            call yaml_warning('Single precision transpositions beyond tolerance')
+       call yaml_mapping_close()
+    end if
+
+    call f_free(rhopot,potref)
+
+    call f_release_routine()
+
+  end subroutine compare_single
+
+
+  !> Check the on-disk kernel cache: the kernel is built a first time with the
+  !! cache (which stores it, unless it is already there), then a second time,
+  !! which must read it back. The kernel read from the cache is compared with a
+  !! kernel recomputed without the cache on each process.
+  subroutine check_kernel_cache(iproc,nproc,dom,ndims,hgrids,itype_scf,cachedir)
+    use Poisson_Solver
+    use f_utils, only: f_time
+    use f_precisions, only: f_long
+    use wrapper_mpi
+    implicit none
+    integer, intent(in) :: iproc,nproc
+    type(domain), intent(in) :: dom
+    integer, dimension(3), intent(in) :: ndims
+    real(dp), dimension(3), intent(in) :: hgrids
+    integer, intent(in) :: itype_scf
+    character(len=*), intent(in) :: cachedir
+    !local variables
+    integer :: icache,ierr
+    integer(f_long) :: t0,t1
+    real(kind=8) :: maxdiff
+    real(kind=8), dimension(0:2) :: tkernel
+    type(coulomb_operator), dimension(0:2) :: kernel
+    type(dictionary), pointer :: dict_input
+
+    call f_routine(id='check_kernel_cache')
+
+    !0: recomputed, 1: stored in the cache, 2: read from the cache
+    do icache=0,2
+       dict_input=>dict_new('kernel' .is. dict_new('isf_order' .is. itype_scf),&
+            'setup' .is. dict_new('verbose' .is. 'No'))
+       if (icache > 0) call dict_set(dict_input//'kernel'//'cache_dir',trim(cachedir))
+       kernel(icache)=pkernel_init(iproc,nproc,dict_input,dom,ndims,hgrids)
+       call dict_free(dict_input)
+       call MPI_BARRIER(MPI_COMM_WORLD,ierr)
+       t0=f_time()
+       call pkernel_set(kernel(icache),verbose=.false.)
+       t1=f_time()
+       tkernel(icache)=real(t1-t0,kind=8)*1.e-9_dp
+    end do
+
+    maxdiff=maxval(abs(kernel(2)%kernel-kernel(0)%kernel))
+    if (nproc > 1) call fmpi_allreduce(maxdiff,1,op=FMPI_MAX,comm=MPI_COMM_WORLD)
+
+    if (iproc == 0) then
+       call yaml_mapping_open('Kernel cache')
+       call yaml_map('Cache hit',kernel(2)%kernel_from_cache)
+       call yaml_map('Difference in Inf. Norm',maxdiff,fmt='(1pe20.12)')
+       call yaml_map('Kernel build time (s)',tkernel(0),fmt='(1pe12.4)')
+       call yaml_map('Kernel read time (s)',tkernel(2),fmt='(1pe12.4)')
+       if (.not. kernel(2)%kernel_from_cache) &
+            call yaml_warning('The kernel has not been read from '//trim(cachedir))
+       call yaml_mapping_close()
+    end if
+
+    do icache=0,2
+       call pkernel_free(kernel(icache))
+    end do
+
+    call f_release_routine()
+
+  end subroutine check_kernel_cache
+
+
   !> Compare with the given reference
   subroutine compare_with_reference(nproc,geocode,distcode,n01,n02,n03,&
        nspden,offset,ehref,&
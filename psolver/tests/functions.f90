@@ -63,6 +63,16 @@ subroutine PS_Check_options(parser)
        dict_new('Usage' .is. &
        'Boolean, set the GPU acceleration'))
 
+  call yaml_cl_parse_option(parser,'fftw','No',&
+       'FFTW solver comparison','w',&
+       dict_new('Usage' .is. &
+       'Boolean, time the FFTW solver against the CPU one for several grid sizes'))
+
+  call yaml_cl_parse_option(parser,'cache','None',&
+       'Kernel cache check','k',&
+       dict_new('Usage' .is. &
+       'Directory of the on-disk kernel cache, to check a kernel read from it against a recomputed one'))
+
   call yaml_cl_parse_option(parser,'logfile','Yes',&
        'Write logfile','l',&
        dict_new('Usage' .is. &